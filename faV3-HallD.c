@@ -25,10 +25,10 @@
 #include "faV3Lib.h"
 #include "faV3-HallD.h"
 
-extern pthread_mutex_t faV3Mutex;
+extern pthread_mutex_t faV3SlotMutex[FAV3_MAX_BOARDS + 2];
 
-#define FAV3LOCK      if(pthread_mutex_lock(&faV3Mutex)<0) perror("pthread_mutex_lock");
-#define FAV3UNLOCK    if(pthread_mutex_unlock(&faV3Mutex)<0) perror("pthread_mutex_unlock");
+#define FAV3SLOTLOCK(_id)   if(pthread_mutex_lock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_lock");
+#define FAV3SLOTUNLOCK(_id) if(pthread_mutex_unlock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_unlock");
 
 extern int nfaV3;
 extern int faV3ID[FAV3_MAX_BOARDS];
@@ -65,7 +65,9 @@ faV3HallDInit(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
 {
   int32_t rval = OK;
 
-  rval = faV3Init(addr, addr_inc, nadc, iFlag);
+  /* The shadow registers follow the V3 map of the ADC registers.  Writes
+     through HallDp keep it current, but not faV3ShadowVerify's masks. */
+  rval = faV3Init(addr, addr_inc, nadc, iFlag & ~FAV3_INIT_USE_SHADOW);
 
   if(rval <= 0)
     return ERROR;
@@ -308,7 +310,7 @@ faV3HallDSetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
 
   rval = faV3SetupADC(id, 0);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Disable ADC processing while writing window info */
   if(pmode == FAV3_HALLD_PROC_MODE_PULSE_PARAM)
     mode_bit = 0;
@@ -325,35 +327,35 @@ faV3HallDSetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
 
   /* Configure the mode (mode_bit), # of pulses (NP), # samples above TET (NSAT)
      keep TNSAT, if it's already been configured */
-  vmeWrite32(&HallDp[id]->config1,
-	     (vmeRead32(&HallDp[id]->config1) & FAV3_ADC_CONFIG1_TNSAT_MASK) |
-	     (mode_bit << 8) | ((NP-1) << 4) | ((NSAT-1) << 10) );
+  faV3RegWrite32(id, &HallDp[id]->config1,
+		 (faV3RegRead32(id, &HallDp[id]->config1) & FAV3_ADC_CONFIG1_TNSAT_MASK) |
+		 (mode_bit << 8) | ((NP-1) << 4) | ((NSAT-1) << 10) );
   /* Disable user-requested channels */
-  vmeWrite32(&HallDp[id]->config2, faV3ChanDisableMask[id]);
+  faV3RegWrite32(id, &HallDp[id]->config2, faV3ChanDisableMask[id]);
 
   /* Set window parameters */
-  vmeWrite32(&HallDp[id]->pl, PL);
-  vmeWrite32(&HallDp[id]->ptw, PTW - 1);
+  faV3RegWrite32(id, &HallDp[id]->pl, PL);
+  faV3RegWrite32(id, &HallDp[id]->ptw, PTW - 1);
 
   /* Set Readback NSB, NSA */
   if(NSB < 0) /* Convert value if negative */
     NSB = ((-1) * NSB) | FAV3_ADC_NSB_NEGATIVE;
 
-  vmeWrite32(&HallDp[id]->nsb, NSB);
-  vmeWrite32(&HallDp[id]->nsa,
-	     (vmeRead32(&HallDp[id]->nsa) & FAV3_ADC_TNSA_MASK) |
-	     NSA );
+  faV3RegWrite32(id, &HallDp[id]->nsb, NSB);
+  faV3RegWrite32(id, &HallDp[id]->nsa,
+		 (faV3RegRead32(id, &HallDp[id]->nsa) & FAV3_ADC_TNSA_MASK) |
+		 NSA );
 
   /* Set Pedestal parameters */
-  vmeWrite32(&HallDp[id]->config7, (NPED-1)<<10 | (MAXPED));
+  faV3RegWrite32(id, &HallDp[id]->config7, (NPED-1)<<10 | (MAXPED));
 
   /* Enable ADC processing */
-  vmeWrite32(&HallDp[id]->config1,
-	     vmeRead32(&HallDp[id]->config1) | FAV3_ADC_PROC_ENABLE );
+  faV3RegWrite32(id, &HallDp[id]->config1,
+		 faV3RegRead32(id, &HallDp[id]->config1) | FAV3_ADC_PROC_ENABLE );
 
   /* Set default value of trigger path threshold (TPT) */
-  vmeWrite32(&HallDp[id]->config3, FAV3_ADC_DEFAULT_TPT);
-  FAV3UNLOCK;
+  faV3RegWrite32(id, &HallDp[id]->config3, FAV3_ADC_DEFAULT_TPT);
+  FAV3SLOTUNLOCK(id);
 
   faV3SetTriggerStopCondition(id, faV3HallDCalcMaxUnAckTriggers(pmode,PTW,NSA,NSB,NP));
   faV3SetTriggerBusyCondition(id, faV3HallDCalcMaxUnAckTriggers(pmode,PTW,NSA,NSB,NP));
@@ -412,7 +414,7 @@ faV3HallDGetProcMode(int id, int *pmode, uint32_t *PL, uint32_t *PTW,
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_HALLD_SUPPORTED_PROC_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
 
   config1 = vmeRead32(&HallDp[id]->config1);
@@ -436,7 +438,7 @@ faV3HallDGetProcMode(int id, int *pmode, uint32_t *PL, uint32_t *PTW,
   *NPED = (config7 & FAV3_ADC_CONFIG7_NPED_MASK) >> 10;
   *MAXPED = (config7 & FAV3_ADC_CONFIG7_MAXPED_MASK);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -469,10 +471,10 @@ faV3HallDProcPedConfig(int id, int nsamples, int maxvalue)
       return ERROR;
     }
 
-  FAV3LOCK;
-  vmeWrite32(&HallDp[id]->config7,
-	     (nsamples - 1)<<10 | maxvalue);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &HallDp[id]->config7,
+		 (nsamples - 1)<<10 | maxvalue);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -526,10 +528,10 @@ faV3HallDSampleConfig(int id, int nsamples, int maxvalue)
       return ERROR;
     }
 
-  FAV3LOCK;
-  vmeWrite32(&HallDp[id]->config6,
-	     (nsamples - 1)<<10 | maxvalue);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &HallDp[id]->config6,
+		 (nsamples - 1)<<10 | maxvalue);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -575,14 +577,14 @@ faV3HallDReadAllChannelSamples(int id, uint16_t data[16])
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  config1 = vmeRead32(&HallDp[id]->config1);
+  config1 = faV3RegRead32(id, &HallDp[id]->config1);
   // Set request bit
-  vmeWrite32(&HallDp[id]->config1, (config1 |  FAV3_ADC_CONFIG1_CHAN_READ_ENABLE) );
+  faV3RegWrite32(id, &HallDp[id]->config1, (config1 |  FAV3_ADC_CONFIG1_CHAN_READ_ENABLE) );
 
   // reset request bit
-  vmeWrite32(&HallDp[id]->config1, config1);
+  faV3RegWrite32(id, &HallDp[id]->config1, config1);
 
 
   status2 = vmeRead32(&HallDp[id]->status2);
@@ -593,7 +595,7 @@ faV3HallDReadAllChannelSamples(int id, uint16_t data[16])
     {
       printf("%s(id = %d): Timeout waiting for Channel Samples\n",
 	     __func__, id);
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       return ERROR;
     }
 
@@ -603,7 +605,7 @@ faV3HallDReadAllChannelSamples(int id, uint16_t data[16])
       status2 = vmeRead32(&HallDp[id]->status2);
       data[ichan] = status2 & 0x7FFF;
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (FAV3_MAX_ADC_CHANNELS);
 }
@@ -630,7 +632,7 @@ faV3SetMGTTestMode(int id, uint32_t mode)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_HALLD_SUPPORTED_PROC_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(mode)
     {				/* After Sync Reset (Normal mode) */
       vmeWrite32(&FAV3p[id]->ctrl_mgt, FAV3_MGT_RESET);
@@ -642,7 +644,7 @@ faV3SetMGTTestMode(int id, uint32_t mode)
       vmeWrite32(&FAV3p[id]->ctrl_mgt, FAV3_MGT_RESET);
       vmeWrite32(&FAV3p[id]->ctrl_mgt, FAV3_MGT_ENABLE_DATA_ALIGNMENT);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -684,7 +686,7 @@ faV3SetHitbitsMode(int id, int enable)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_HALLD_SUPPORTED_PROC_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(enable)
     {
       vmeWrite32(&FAV3p[id]->ctrl_mgt,
@@ -695,7 +697,7 @@ faV3SetHitbitsMode(int id, int enable)
       vmeWrite32(&FAV3p[id]->ctrl_mgt,
 		 vmeRead32(&FAV3p[id]->ctrl_mgt) & ~FAV3_MGT_HITBITS_TO_CTP);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -730,9 +732,9 @@ faV3GetHitbitsMode(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_HALLD_SUPPORTED_PROC_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->ctrl_mgt)&FAV3_MGT_HITBITS_TO_CTP)>>3;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -754,9 +756,9 @@ faV3HallDSetRoguePTWFallBack(int id, uint16_t enablemask)
 {
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&HallDp[id]->rogue_ptw_fall_back, enablemask);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &HallDp[id]->rogue_ptw_fall_back, enablemask);
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -778,9 +780,9 @@ faV3HallDGetRoguePTWFallBack(int id, uint16_t *enablemask)
   int rval = OK;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   *enablemask = vmeRead32(&HallDp[id]->rogue_ptw_fall_back) & FAV3_ROGUE_PTW_FALL_BACK_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -795,10 +797,10 @@ faV3HallDGStatus(int sflag)
   int nsb;
   extern u_long faV3A24Offset;
 
-  FAV3LOCK;
   for(ifa = 0; ifa < nfaV3; ifa++)
     {
       id = faV3Slot(ifa);
+      FAV3SLOTLOCK(id);
       a24addr[id] = (uint32_t) ((u_long) FAV3p[id] - faV3A24Offset);
       st[id].version = vmeRead32(&FAV3p[id]->version);
       st[id].adr32 = vmeRead32(&FAV3p[id]->adr32);
@@ -863,9 +865,8 @@ faV3HallDGStatus(int sflag)
 	{
 	  hd_st[id].thres[ii] = vmeRead32(&HallDp[id]->thres[ii]);
 	}
-
+      FAV3SLOTUNLOCK(id);
     }
-  FAV3UNLOCK;
 
   printf("\n");
 
@@ -7,9 +7,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "faV3Config.h"
 #include "jvme.h"
@@ -104,17 +111,237 @@ faV3InitGlobals()
     }
 }
 
-/* reading and parsing config file */
+/* Config file keywords, sorted for bsearch */
+enum faV3ConfKeyType
+  {
+    FAV3_KEY_SLOT,
+    FAV3_KEY_INT,		/* one value */
+    FAV3_KEY_MASK,		/* 16 bits, channel 0 first */
+    FAV3_KEY_MASK_INV,		/* same, stored inverted */
+    FAV3_KEY_INT_ALL,		/* one value for all channels */
+    FAV3_KEY_INT_CH,		/* channel, value */
+    FAV3_KEY_INT_ALLCH,		/* 16 values, channel 0 first */
+    FAV3_KEY_FLOAT_ALL,
+    FAV3_KEY_FLOAT_CH,
+    FAV3_KEY_FLOAT_ALLCH
+  };
+
+typedef struct
+{
+  const char *keyword;
+  int type;
+  size_t offset;		/* of the setting in FAV3_CONF */
+  size_t size;			/* of one value */
+} faV3ConfKey_t;
+
+#define CONFKEY(_keyword, _type, _field)				\
+  { _keyword, _type, offsetof(FAV3_CONF, _field), sizeof(((FAV3_CONF *) 0)->_field) }
+#define CONFKEY_CH(_keyword, _type, _field)				\
+  { _keyword, _type, offsetof(FAV3_CONF, _field), sizeof(((FAV3_CONF *) 0)->_field[0]) }
+
+static const faV3ConfKey_t faV3ConfKeys[] =
+  {
+    CONFKEY("FAV3_ACCUMULATOR_MASK", FAV3_KEY_MASK, accumulatorMask),
+    CONFKEY("FAV3_ADC_MASK", FAV3_KEY_MASK_INV, chDisMask),
+    CONFKEY_CH("FAV3_ALLCH_DAC", FAV3_KEY_INT_ALLCH, dac),
+    CONFKEY_CH("FAV3_ALLCH_DELAY", FAV3_KEY_INT_ALLCH, delay),
+    CONFKEY_CH("FAV3_ALLCH_GAIN", FAV3_KEY_FLOAT_ALLCH, gain),
+    CONFKEY_CH("FAV3_ALLCH_PED", FAV3_KEY_FLOAT_ALLCH, pedestal),
+    CONFKEY_CH("FAV3_ALLCH_TET", FAV3_KEY_INT_ALLCH, thr),
+    CONFKEY_CH("FAV3_CH_DAC", FAV3_KEY_INT_CH, dac),
+    CONFKEY_CH("FAV3_CH_DELAY", FAV3_KEY_INT_CH, delay),
+    CONFKEY_CH("FAV3_CH_GAIN", FAV3_KEY_FLOAT_CH, gain),
+    CONFKEY_CH("FAV3_CH_PED", FAV3_KEY_FLOAT_CH, pedestal),
+    CONFKEY_CH("FAV3_CH_TET", FAV3_KEY_INT_CH, thr),
+    CONFKEY("FAV3_COMPRESSION", FAV3_KEY_INT, compression),
+    CONFKEY_CH("FAV3_DAC", FAV3_KEY_INT_ALL, dac),
+    CONFKEY("FAV3_DATA_FORMAT", FAV3_KEY_INT, data_format),
+    CONFKEY_CH("FAV3_DELAY", FAV3_KEY_INT_ALL, delay),
+    CONFKEY_CH("FAV3_GAIN", FAV3_KEY_FLOAT_ALL, gain),
+    CONFKEY("FAV3_INSERT_ADC_PARAMS", FAV3_KEY_INT, insert_adc_params),
+    CONFKEY("FAV3_INVERT_MASK", FAV3_KEY_MASK, invertMask),
+    CONFKEY("FAV3_MAXPED", FAV3_KEY_INT, max_ped),
+    CONFKEY("FAV3_MODE", FAV3_KEY_INT, mode),
+    CONFKEY("FAV3_NPEAK", FAV3_KEY_INT, npeak),
+    CONFKEY("FAV3_NPED", FAV3_KEY_INT, nped),
+    CONFKEY("FAV3_NSA", FAV3_KEY_INT, nsa),
+    CONFKEY("FAV3_NSAT", FAV3_KEY_INT, nsat),
+    CONFKEY("FAV3_NSB", FAV3_KEY_INT, nsb),
+    CONFKEY_CH("FAV3_PED", FAV3_KEY_FLOAT_ALL, pedestal),
+    CONFKEY("FAV3_PLAYBACK_DISABLE_MASK", FAV3_KEY_MASK, playbackDisableMask),
+    CONFKEY("FAV3_PROC_VERSION", FAV3_KEY_INT, proc_version),
+    CONFKEY("FAV3_PTW_FALLBACK_MASK", FAV3_KEY_MASK, ptw_fallback_mask),
+    { "FAV3_SLOT", FAV3_KEY_SLOT, 0, 0 },
+    CONFKEY("FAV3_SPARSIFICATION", FAV3_KEY_INT, sparsification),
+    CONFKEY("FAV3_SUPPRESS_TRIG_TIME", FAV3_KEY_INT, suppress_trig_time),
+    CONFKEY_CH("FAV3_TET", FAV3_KEY_INT_ALL, thr),
+    CONFKEY("FAV3_TET_IGNORE_MASK", FAV3_KEY_MASK, thrIgnoreMask),
+    CONFKEY("FAV3_TRG_MASK", FAV3_KEY_MASK, trigMask),
+    CONFKEY("FAV3_TRG_MINMULT", FAV3_KEY_INT, trigMinMult),
+    CONFKEY("FAV3_TRG_MINTOT", FAV3_KEY_INT, trigMinTOT),
+    CONFKEY("FAV3_TRG_WIDTH", FAV3_KEY_INT, trigWidth),
+    CONFKEY("FAV3_TRIG_MODE_MASK", FAV3_KEY_MASK, trigModeMask),
+    CONFKEY("FAV3_TRIG_NSA", FAV3_KEY_INT, trig_nsa),
+    CONFKEY("FAV3_TRIG_NSAT", FAV3_KEY_INT, trig_nsat),
+    CONFKEY("FAV3_TRIG_THR", FAV3_KEY_INT, trig_thr),
+    CONFKEY("FAV3_VXSREADOUT", FAV3_KEY_INT, vxsReadout),
+    CONFKEY("FAV3_W_OFFSET", FAV3_KEY_INT, winOffset),
+    CONFKEY("FAV3_W_WIDTH", FAV3_KEY_INT, winWidth)
+  };
+
+#define NCONFKEYS (sizeof(faV3ConfKeys) / sizeof(faV3ConfKeys[0]))
+
+static int
+faV3ConfKeyCompare(const void *keyword, const void *key)
+{
+  return(strcmp((const char *) keyword, ((const faV3ConfKey_t *) key)->keyword));
+}
+
+/* Store an integer setting into slots [slot_min, slot_max) */
+static void
+faV3ConfStoreInt(const faV3ConfKey_t *key, int slot_min, int slot_max,
+		 int chan, uint32_t val)
+{
+  char *p;
+  int slot;
+
+  for(slot = slot_min; slot < slot_max; slot++)
+    {
+      p = (char *) &faV3[slot] + key->offset + chan * key->size;
+      if(key->size == sizeof(uint16_t))
+	*(uint16_t *) p = val;
+      else
+	*(uint32_t *) p = val;
+    }
+}
+
+static void
+faV3ConfStoreFloat(const faV3ConfKey_t *key, int slot_min, int slot_max,
+		   int chan, float val)
+{
+  int slot;
+
+  for(slot = slot_min; slot < slot_max; slot++)
+    *(float *) ((char *) &faV3[slot] + key->offset + chan * key->size) = val;
+}
+
+/* Could the line at p be a FAV3_CRATE, as parsed below */
+static int
+faV3ConfCrateLine(const char *p, const char *end)
+{
+  if((*p == '#') || (*p == ' ') || (*p == '\t') || (*p == '\n'))
+    return(0);
+
+  if(isspace((unsigned char) *p))
+    return(1);			/* the keyword comes after other white space */
+
+  return(((end - p) >= 10) && (strncmp(p, "FAV3_CRATE", 10) == 0) &&
+	 (((end - p) == 10) || isspace((unsigned char) p[10])));
+}
+
+/* FAV3_CRATE sections of the last file read, so that reading it again
+   goes straight to the sections of this host.  The file is known by its
+   inode, size and modification time.  An index is only kept if the file
+   was last changed more than a second before it was read: a change in
+   the same clock tick would leave the time as it was. */
+typedef struct
+{
+  char name[ROCLEN];
+  size_t offset;		/* of the FAV3_CRATE line */
+  int line;
+} faV3ConfCrate_t;
+
+static struct
+{
+  int valid;
+  char filename[FNLEN];
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+  int ncrate, maxcrate;
+  faV3ConfCrate_t *crate;
+} faV3ConfIndex;
+
+static int
+faV3ConfIndexMatch(const char *filename, const struct stat *st)
+{
+  return(faV3ConfIndex.valid &&
+	 (strcmp(faV3ConfIndex.filename, filename) == 0) &&
+	 (faV3ConfIndex.dev == st->st_dev) && (faV3ConfIndex.ino == st->st_ino) &&
+	 (faV3ConfIndex.size == st->st_size) &&
+	 (faV3ConfIndex.mtime.tv_sec == st->st_mtim.tv_sec) &&
+	 (faV3ConfIndex.mtime.tv_nsec == st->st_mtim.tv_nsec));
+}
+
+static void
+faV3ConfIndexAdd(const char *name, size_t offset, int line)
+{
+  faV3ConfCrate_t *crate;
+
+  if(faV3ConfIndex.ncrate == faV3ConfIndex.maxcrate)
+    {
+      crate = realloc(faV3ConfIndex.crate,
+		      (2 * faV3ConfIndex.maxcrate + 16) * sizeof(faV3ConfCrate_t));
+      if(crate == NULL)
+	{
+	  faV3ConfIndex.valid = -1;	/* not kept */
+	  return;
+	}
+      faV3ConfIndex.crate = crate;
+      faV3ConfIndex.maxcrate = 2 * faV3ConfIndex.maxcrate + 16;
+    }
+
+  crate = &faV3ConfIndex.crate[faV3ConfIndex.ncrate++];
+  strcpy(crate->name, name);
+  crate->offset = offset;
+  crate->line = line;
+}
+
+#define SCAN_16(_fmt, _v)						\
+  sscanf(str_tmp, "%*s " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt \
+	 " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt " " _fmt, \
+	 &_v[ 0], &_v[ 1], &_v[ 2], &_v[ 3], &_v[ 4], &_v[ 5], &_v[ 6], &_v[ 7], \
+	 &_v[ 8], &_v[ 9], &_v[10], &_v[11], &_v[12], &_v[13], &_v[14], &_v[15])
+
+/* Errors name the line of the config file */
+#define PARSE_ERR(_rval, format, ...) {					\
+    printf("%s: ERROR: %s line %d: %s: " format "\n",			\
+	   __func__, filename, line, keyword, ## __VA_ARGS__);		\
+    rval = (_rval);							\
+    goto done;								\
+  }
+
+/* reading and parsing config file
+
+   The file is mapped, and taken a line at a time as fgets() would, so a
+   line longer than STRLEN - 1 goes on as the next one.  Lines of crates
+   that are not ours are skipped without being parsed, up to the next
+   FAV3_CRATE.  Keywords are looked up in faV3ConfKeys.
+   Reading the same file again, unchanged, uses faV3ConfIndex to go from
+   one section of this host (or "all") to the next, without looking at
+   the rest; the sections of other crates are then not listed.
+
+   Channel 16 in FAV3_CH_* is taken, as it always was, but now with a
+   warning and without storing the value: it used to be written past
+   the per channel array, into channel 0 of the next setting. */
 int
 faV3ReadConfigFile(char *filename_in)
 {
-  FILE   *fd;
-  char   filename[FNLEN];
-  char   fname[FNLEN] = { "" };  /* config file name */
-  char   host[ROCLEN], ROC_name[ROCLEN];
-  char *envDir = NULL;
-  int do_parsing;
-  SCAN_VARS;
+  int fd;
+  struct stat st;
+  char *map = NULL;
+  const char *p, *end, *eol, *lstart;
+  struct timespec now = {0, 0};
+  size_t len;
+  char filename[FNLEN];
+  char host[ROCLEN], ROC_name[ROCLEN] = "";
+  char str_tmp[STRLEN], str2[STRLEN] = "", keyword[ROCLEN] = "";
+  const faV3ConfKey_t *key;
+  int slot_min = 0, slot_max = 0, chan = 0, args, ichan, msk[16];
+  int val = 0, line = 1, rval = 0, indexed, icrate = 0;
+  uint32_t bits;
+  float f1 = 0., fmsk[16];
 
   gethostname(host, ROCLEN);	/* obtain our hostname - and drop any domain extension */
   for(int jj = 0; jj < strlen(host); jj++)
@@ -127,38 +354,106 @@ faV3ReadConfigFile(char *filename_in)
     }
 
   strcpy(filename,filename_in); /* copy filename from parameter list to local string */
-  do_parsing = 1;
 
-  if((fd=fopen(filename,"r")) == NULL)
+  if(((fd = open(filename, O_RDONLY)) < 0) || (fstat(fd, &st) < 0))
     {
       printf("%s: Can't open config file >%s<\n",
 	     __func__, filename);
+      if(fd >= 0)
+	close(fd);
       return(-1);
     }
 
+  if(st.st_size > 0)
+    {
+      map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(map == MAP_FAILED)
+	{
+	  perror("mmap");
+	  printf("%s: Can't map config file >%s<\n",
+		 __func__, filename);
+	  close(fd);
+	  return(-1);
+	}
+    }
+  close(fd);
+
   printf("%s: Using configuration file >%s<\n",
 	 __func__, filename);
 
+  indexed = faV3ConfIndexMatch(filename, &st);
+  if(!indexed)
+    {
+      clock_gettime(CLOCK_REALTIME, &now);
+      strcpy(faV3ConfIndex.filename, filename);
+      faV3ConfIndex.dev = st.st_dev;
+      faV3ConfIndex.ino = st.st_ino;
+      faV3ConfIndex.size = st.st_size;
+      faV3ConfIndex.mtime = st.st_mtim;
+      faV3ConfIndex.ncrate = 0;
+      faV3ConfIndex.valid = 0;
+    }
+
   /* Parsing of config file */
   active = 0; /* by default disable crate */
-  int ch = 0;
-  while ((ch = getc(fd)) != EOF)
+  p = map;
+  end = map + ((map != NULL) ? st.st_size : 0);
+  while(p < end)
     {
-      if ( ch == '#' || ch == ' ' || ch == '\t' )
+      if(indexed && !active)
+	{
+	  /* on to the next section of ours */
+	  while((icrate < faV3ConfIndex.ncrate) &&
+		((faV3ConfIndex.crate[icrate].offset < (size_t) (p - map)) ||
+		 (strcmp(faV3ConfIndex.crate[icrate].name, host) &&
+		  strcmp(faV3ConfIndex.crate[icrate].name, "all"))))
+	    icrate++;
+	  if(icrate == faV3ConfIndex.ncrate)
+	    break;
+	  p = map + faV3ConfIndex.crate[icrate].offset;
+	  line = faV3ConfIndex.crate[icrate].line;
+	}
+
+      eol = memchr(p, '\n', end - p);
+
+      if(!active && !faV3ConfCrateLine(p, end))
+	{
+	  /* not ours, and not the start of another crate */
+	  if(eol == NULL)
+	    break;
+	  p = eol + 1;
+	  line++;
+	  continue;
+	}
+
+
+      if((*p == '#') || (*p == ' ') || (*p == '\t') || (*p == '\n'))
 	{
-	  while ( getc(fd)!='\n' /*&& getc(fd)!=!= EOF*/ ) {} /*ERROR !!!*/
+	  /* comment or empty line */
+	  if(eol == NULL)
+	    break;
+	  p = eol + 1;
+	  line++;
 	  continue;
 	}
-      if( ch == '\n' )
-	continue;
 
-      ungetc(ch,fd);
-      fgets(str_tmp, STRLEN, fd);
-      sscanf (str_tmp, "%s %s", keyword, ROC_name);
+      len = (eol != NULL) ? (eol - p + 1) : (end - p);
+      if(len > STRLEN - 1)
+	len = STRLEN - 1;
+      memcpy(str_tmp, p, len);
+      str_tmp[len] = '\0';
+      lstart = p;
+      p += len;
+
+      /* keyword and crate name, as sscanf("%s %s") would */
+      sscanf(str_tmp, "%79s %79s", keyword, ROC_name);
 
       /* Start parsing real config inputs */
       if(strcmp(keyword,"FAV3_CRATE") == 0)
 	{
+	  if(!indexed)
+	    faV3ConfIndexAdd(ROC_name, lstart - map, line);
+
 	  if(strcmp(ROC_name,host) == 0)
 	    {
 	      printf("%s: FAV3_CRATE = %s  host = %s - active\n", __func__, ROC_name, host);
@@ -174,303 +469,846 @@ faV3ReadConfigFile(char *filename_in)
 	      printf("%s: FAV3_CRATE = %s  host = %s - not active\n", __func__, ROC_name,host);
 	      active = 0;
 	    }
-	  continue;
+	}
+      else if(active)
+	{
+	  key = bsearch(keyword, faV3ConfKeys, NCONFKEYS, sizeof(faV3ConfKey_t),
+			faV3ConfKeyCompare);
+	  if(key == NULL)
+	    {
+	      printf("%s: ERROR: %s line %d: Unknown keyword: %s\n",
+		     __func__, filename, line, keyword);
+	    }
+	  else
+	    {
+	      switch(key->type)
+		{
+		case FAV3_KEY_SLOT:
+		  sscanf(str_tmp, "%*s %s", str2);
+		  if(isdigit(str2[0]))
+		    {
+		      slot_min = atoi(str2);
+		      slot_max = slot_min + 1;
+		      if((slot_min < 2) || (slot_min > 21))
+			PARSE_ERR(-4, "Invalid slot number %d", slot_min);
+		    }
+		  else if(!strcmp(str2,"all"))
+		    {
+		      slot_min = 0;
+		      slot_max = NBOARD;
+		    }
+		  else
+		    PARSE_ERR(-4, "Invalid slot >%s<, must be 'all' or actual slot number",
+			      str2);
+		  break;
+
+		case FAV3_KEY_INT:
+		  sscanf(str_tmp, "%*s %d", &val);
+		  faV3ConfStoreInt(key, slot_min, slot_max, 0, val);
+		  break;
+
+		case FAV3_KEY_MASK:
+		case FAV3_KEY_MASK_INV:
+		  args = SCAN_16("%d", msk);
+		  if(args != 16)
+		    PARSE_ERR(-8, "Invalid number of arguments (%d), should be 16", args);
+		  bits = 0;
+		  for(ichan = 0; ichan < NCHAN; ichan++)
+		    {
+		      if((msk[ichan] < 0) || (msk[ichan] > 1))
+			PARSE_ERR(-6, "Invalid mask bit value, %d", msk[ichan]);
+		      bits |= msk[ichan] << ichan;
+		    }
+		  val = bits;
+		  if(key->type == FAV3_KEY_MASK_INV)
+		    bits = ~bits & 0xffff;
+		  faV3ConfStoreInt(key, slot_min, slot_max, 0, bits);
+		  break;
+
+		case FAV3_KEY_INT_ALL:
+		  sscanf(str_tmp, "%*s %d", &val);
+		  for(ichan = 0; ichan < NCHAN; ichan++)
+		    faV3ConfStoreInt(key, slot_min, slot_max, ichan, val);
+		  break;
+
+		case FAV3_KEY_INT_CH:
+		  sscanf(str_tmp, "%*s %d %d", &chan, &val);
+		  if(chan == NCHAN)
+		    {
+		      printf("%s: WARNING: %s line %d: %s: channel %d ignored\n",
+			     __func__, filename, line, keyword, chan);
+		      break;
+		    }
+		  if((chan < 0) || (chan > NCHAN))
+		    PARSE_ERR(-4, "Invalid channel number %d", chan);
+		  faV3ConfStoreInt(key, slot_min, slot_max, chan, val);
+		  break;
+
+		case FAV3_KEY_INT_ALLCH:
+		  args = SCAN_16("%d", msk);
+		  if(args != 16)
+		    PARSE_ERR(-8, "Wrong argument's number %d, should be 16", args);
+		  for(ichan = 0; ichan < NCHAN; ichan++)
+		    faV3ConfStoreInt(key, slot_min, slot_max, ichan, msk[ichan]);
+		  break;
+
+		case FAV3_KEY_FLOAT_ALL:
+		  sscanf(str_tmp, "%*s %f", &f1);
+		  for(ichan = 0; ichan < NCHAN; ichan++)
+		    faV3ConfStoreFloat(key, slot_min, slot_max, ichan, f1);
+		  break;
+
+		case FAV3_KEY_FLOAT_CH:
+		  sscanf(str_tmp, "%*s %d %f", &chan, &f1);
+		  if(chan == NCHAN)
+		    {
+		      printf("%s: WARNING: %s line %d: %s: channel %d ignored\n",
+			     __func__, filename, line, keyword, chan);
+		      break;
+		    }
+		  if((chan < 0) || (chan > NCHAN))
+		    PARSE_ERR(-4, "Invalid channel number %d", chan);
+		  faV3ConfStoreFloat(key, slot_min, slot_max, chan, f1);
+		  break;
+
+		case FAV3_KEY_FLOAT_ALLCH:
+		  args = SCAN_16("%f", fmsk);
+		  if(args != 16)
+		    PARSE_ERR(-8, "Wrong argument's number %d, should be 16", args);
+		  for(ichan = 0; ichan < NCHAN; ichan++)
+		    faV3ConfStoreFloat(key, slot_min, slot_max, ichan, fmsk[ichan]);
+		  break;
+		}
+	    }
 	}
 
-      SCAN_SLOT("FAV3_SLOT", slot_min, slot_max);
-      SCAN_INT("FAV3_PROC_VERSION", faV3[slot].proc_version, slot_min, slot_max);
-
-      SCAN_MASK_INV("FAV3_ADC_MASK", faV3[slot].chDisMask, slot_min, slot_max);
+      if((len > 0) && (str_tmp[len - 1] == '\n'))
+	line++;
+    }
 
-      SCAN_INT("FAV3_MODE", faV3[slot].mode, slot_min, slot_max);
+ done:
+  if(map != NULL)
+    munmap(map, st.st_size);
 
-      SCAN_INT("FAV3_W_OFFSET", faV3[slot].winOffset, slot_min, slot_max);
-      SCAN_INT("FAV3_W_WIDTH", faV3[slot].winWidth, slot_min, slot_max);
-      SCAN_INT("FAV3_NSA", faV3[slot].nsa, slot_min, slot_max);
-      SCAN_INT("FAV3_NSB", faV3[slot].nsb, slot_min, slot_max);
-      SCAN_INT("FAV3_NPEAK", faV3[slot].npeak, slot_min, slot_max);
+  /* Kept for the next read of the file, if it was read through and
+     was not changed just before */
+  if(!indexed && (faV3ConfIndex.valid == 0) && (rval == 0) &&
+     ((st.st_mtim.tv_sec + 1 < now.tv_sec) ||
+      ((st.st_mtim.tv_sec + 1 == now.tv_sec) &&
+       (st.st_mtim.tv_nsec < now.tv_nsec))))
+    faV3ConfIndex.valid = 1;
 
-      SCAN_INT("FAV3_NSAT", faV3[slot].nsat, slot_min, slot_max);
-      SCAN_INT("FAV3_NPED", faV3[slot].nped, slot_min, slot_max);
-      SCAN_INT("FAV3_MAXPED", faV3[slot].max_ped, slot_min, slot_max);
+  return(rval);
+}
 
-      SCAN_MASK("FAV3_PTW_FALLBACK_MASK", faV3[slot].ptw_fallback_mask, slot_min, slot_max);
 
-      SCAN_INT("FAV3_TRIG_THR", faV3[slot].trig_thr, slot_min, slot_max);
-      SCAN_INT("FAV3_TRIG_NSA", faV3[slot].trig_nsa, slot_min, slot_max);
-      SCAN_INT("FAV3_TRIG_NSAT", faV3[slot].trig_nsat, slot_min, slot_max);
+/* Download results, per slot */
+typedef struct
+{
+  int32_t done;			/* this download reached the slot */
+  int32_t nfail;		/* calls that returned ERROR */
+  const char *first_fail;	/* the first of them */
+  int32_t nchange;		/* settings that differed (faV3DownloadChanged) */
+  int32_t full;			/* all settings were written */
+  double ms;			/* time taken */
+} faV3DownloadResult_t;
+
+static faV3DownloadResult_t faV3DownloadResult[NBOARD+1];
+static int faV3DownloadThreads = FAV3_DOWNLOAD_THREADS;
+static int faV3DownloadNext;
+static int faV3DownloadFlags;
+static pthread_mutex_t faV3DownloadMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Settings of the last download of each slot that had no failed calls */
+static FAV3_CONF faV3Applied[NBOARD+1];
+static int faV3AppliedValid[NBOARD+1];
+
+#define FAV3_DOWNLOAD_CHANGED  (1 << 8)	/* faV3DownloadChanged, not faV3DownloadAll */
+
+extern int faV3FwRev[(FAV3_MAX_BOARDS + 1)][FAV3_FW_FUNCTION_MAX];
+
+/* Call a library routine, and keep a note if it fails */
+#define DLCALL(_call)							\
+  if((_call) == ERROR)							\
+    {									\
+      if(res->nfail++ == 0)						\
+	res->first_fail = #_call;					\
+    }
 
-      SCAN_MASK("FAV3_TRG_MASK", faV3[slot].trigMask, slot_min, slot_max);
-      SCAN_INT("FAV3_TRG_WIDTH", faV3[slot].trigWidth, slot_min, slot_max);
-      SCAN_INT("FAV3_TRG_MINTOT", faV3[slot].trigMinTOT, slot_min, slot_max);
-      SCAN_INT("FAV3_TRG_MINMULT", faV3[slot].trigMinMult, slot_min, slot_max);
+/* Call a library routine if any of the settings it writes changed */
+#define DLCHANGED(_ndiff, _call)					\
+  if((n = (_ndiff)) > 0)						\
+    {									\
+      res->nchange += n;						\
+      if(!dryrun)							\
+	DLCALL(_call);							\
+    }
 
-      SCAN_MASK("FAV3_TET_IGNORE_MASK", faV3[slot].thrIgnoreMask, slot_min, slot_max);
-      SCAN_MASK("FAV3_INVERT_MASK", faV3[slot].invertMask, slot_min, slot_max);
-      SCAN_MASK("FAV3_PLAYBACK_DISABLE_MASK", faV3[slot].playbackDisableMask, slot_min, slot_max);
-      SCAN_INT("FAV3_SPARSIFICATION", faV3[slot].sparsification, slot_min, slot_max);
-      SCAN_MASK("FAV3_ACCUMULATOR_MASK", faV3[slot].accumulatorMask, slot_min, slot_max);
-      SCAN_MASK("FAV3_TRIG_MODE_MASK", faV3[slot].trigModeMask, slot_min, slot_max);
+/* download setting into one FADC */
+static void
+faV3DownloadSlot(int slot)
+{
+  faV3DownloadResult_t *res = &faV3DownloadResult[slot];
+  struct timespec t0, t1;
+  int ichan;
 
-      SCAN_FLOAT_ALL("FAV3_PED", faV3[slot].pedestal, slot_min, slot_max);
-      SCAN_FLOAT_CH("FAV3_CH_PED", faV3[slot].pedestal, slot_min, slot_max);
-      SCAN_FLOAT_ALLCH("FAV3_ALLCH_PED", faV3[slot].pedestal, slot_min, slot_max);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  memset(res, 0, sizeof(faV3DownloadResult_t));
 
-      SCAN_INT_ALL("FAV3_TET", faV3[slot].thr, slot_min, slot_max);
-      SCAN_INT_CH("FAV3_CH_TET", faV3[slot].thr, slot_min, slot_max);
-      SCAN_INT_ALLCH("FAV3_ALLCH_TET", faV3[slot].thr, slot_min, slot_max);
+  DLCALL(faV3SetChanDisableMask(slot, faV3[slot].chDisMask));
 
-      SCAN_INT_ALL("FAV3_DAC", faV3[slot].dac, slot_min, slot_max);
-      SCAN_INT_CH("FAV3_CH_DAC", faV3[slot].dac, slot_min, slot_max);
-      SCAN_INT_ALLCH("FAV3_ALLCH_DAC", faV3[slot].dac, slot_min, slot_max);
+  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_HALLD_SUPPORTED_PROC_FIRMWARE)
+    {
+      DLCALL(faV3HallDSetProcMode(slot,
+				  faV3[slot].mode,
+				  faV3[slot].winOffset / FAV3_ADC_NS_PER_CLK,
+				  faV3[slot].winWidth / FAV3_ADC_NS_PER_CLK,
+				  faV3[slot].nsb / FAV3_ADC_NS_PER_CLK,
+				  faV3[slot].nsa / FAV3_ADC_NS_PER_CLK,
+				  faV3[slot].npeak,
+				  faV3[slot].nped,
+				  faV3[slot].max_ped,
+				  faV3[slot].nsat / FAV3_ADC_NS_PER_CLK));
+
+      DLCALL(faV3HallDSetRoguePTWFallBack(slot, faV3[slot].ptw_fallback_mask));
+    }
+  else
+    {
+      DLCALL(faV3SetProcMode(slot,
+			     faV3[slot].mode,
+			     faV3[slot].winOffset / FAV3_ADC_NS_PER_CLK,
+			     faV3[slot].winWidth / FAV3_ADC_NS_PER_CLK,
+			     faV3[slot].nsb / FAV3_ADC_NS_PER_CLK,
+			     faV3[slot].nsa / FAV3_ADC_NS_PER_CLK,
+			     faV3[slot].npeak));
+
+      DLCALL(faV3SetPulseParameterConfig(slot,
+					 faV3[slot].nped,
+					 faV3[slot].max_ped,
+					 faV3[slot].nsat / FAV3_ADC_NS_PER_CLK));
+
+      DLCALL(faV3SetRoguePTWFallBack(slot, faV3[slot].ptw_fallback_mask));
+    }
 
-      SCAN_FLOAT_ALL("FAV3_GAIN", faV3[slot].gain, slot_min, slot_max);
-      SCAN_FLOAT_CH("FAV3_CH_GAIN", faV3[slot].gain, slot_min, slot_max);
-      SCAN_FLOAT_ALLCH("FAV3_ALLCH_GAIN", faV3[slot].gain, slot_min, slot_max);
+  DLCALL(faV3SetTriggerPathSamples(slot, faV3[slot].trig_nsa / FAV3_ADC_NS_PER_CLK,
+				   faV3[slot].trig_nsat / FAV3_ADC_NS_PER_CLK));
+  DLCALL(faV3SetTriggerPathThreshold(slot, faV3[slot].trig_thr));
 
-      SCAN_INT_ALL("FAV3_DELAY", faV3[slot].delay, slot_min, slot_max);
-      SCAN_INT_CH("FAV3_CH_DELAY", faV3[slot].delay, slot_min, slot_max);
-      SCAN_INT_ALLCH("FAV3_ALLCH_DELAY", faV3[slot].delay, slot_min, slot_max);
+  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
+    {
+      DLCALL(faV3SetHitbitTrigMask(slot, faV3[slot].trigMask));
+      DLCALL(faV3SetHitbitTrigWidth(slot, faV3[slot].trigWidth / FAV3_ADC_NS_PER_CLK));
+      DLCALL(faV3SetHitbitMinTOT(slot, faV3[slot].trigMinTOT));
+      DLCALL(faV3SetHitbitMinMultiplicity(slot, faV3[slot].trigMinMult));
+
+      DLCALL(faV3ThresholdIgnore(slot, faV3[slot].thrIgnoreMask));
+      DLCALL(faV3SetInvertMask(slot, faV3[slot].invertMask));
+      DLCALL(faV3PlaybackDisable(slot, faV3[slot].playbackDisableMask));
+      DLCALL(faV3SetSparsificationMode(slot, faV3[slot].sparsification));
+      DLCALL(faV3SetAccumulatorScalerMode(slot, faV3[slot].accumulatorMask));
+    }
 
-      SCAN_INT("FAV3_DATA_FORMAT",  faV3[slot].data_format, slot_min, slot_max);
-      SCAN_INT("FAV3_SUPPRESS_TRIG_TIME",  faV3[slot].suppress_trig_time, slot_min, slot_max);
-      SCAN_INT("FAV3_INSERT_ADC_PARAMS",  faV3[slot].insert_adc_params, slot_min, slot_max);
-      SCAN_INT("FAV3_COMPRESSION", faV3[slot].compression, slot_min, slot_max);
-      SCAN_INT("FAV3_VXSREADOUT", faV3[slot].vxsReadout, slot_min, slot_max);
+  DLCALL(faV3SetDataFormat(slot, faV3[slot].data_format));
+  DLCALL(faV3DataSuppressTriggerTime(slot, faV3[slot].suppress_trig_time));
+  DLCALL(faV3DataInsertAdcParameters(slot, faV3[slot].insert_adc_params));
+  DLCALL(faV3SetCompression(slot,faV3[slot].compression));
+  DLCALL(faV3SetVXSReadout(slot,faV3[slot].vxsReadout));
 
 
-      if(active)
+  for(ichan=0; ichan<NCHAN; ichan++)
+    {
+      if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
 	{
-	  printf("%s: ERROR: Unknown keyword: %s\n", __func__, keyword);
+	  DLCALL(faV3SetTriggerProcessingMode(slot, ichan,
+					      (faV3[slot].trigModeMask & (1 << ichan)) ? 1 : 0));
+	  DLCALL(faV3SetChannelGain(slot, ichan, faV3[slot].gain[ichan]));
+	  DLCALL(faV3SetChannelDelay(slot, ichan, faV3[slot].delay[ichan] / FAV3_ADC_NS_PER_CLK));
 	}
 
+      float ped = faV3[slot].pedestal[ichan] * (float) (faV3[slot].nsa + faV3[slot].nsb) / FAV3_ADC_NS_PER_CLK;
+      DLCALL(faV3SetPedestal(slot, ichan, (int) ped));
+
+      int thr = (faV3[slot].thr[ichan] > 0) ?
+	faV3[slot].pedestal[ichan] + faV3[slot].thr[ichan] : 0;
+      DLCALL(faV3SetThreshold(slot, ichan, thr));
+
+      DLCALL(faV3DACSet(slot, ichan, faV3[slot].dac[ichan]));
+    }
+
+  if(res->nfail == 0)
+    {
+      faV3Applied[slot] = faV3[slot];
+      faV3AppliedValid[slot] = 1;
     }
 
-  fclose(fd);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  res->ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6;
+  res->done = 1;
+}
 
-  return(0);
+/* Compare a setting with the reference: 1 if it changed.  list prints it. */
+static int
+faV3DiffInt(int slot, int chan, const char *name, int32_t old, int32_t new,
+	    int hex, int list)
+{
+  if(old == new)
+    return(0);
+
+  if(list)
+    {
+      printf("  slot %2d: %-26s", slot, name);
+      if(chan >= 0)
+	printf(" ch %2d", chan);
+      if(hex)
+	printf("  0x%04x -> 0x%04x\n", old, new);
+      else
+	printf("  %d -> %d\n", old, new);
+    }
+
+  return(1);
 }
 
+static int
+faV3DiffFloat(int slot, int chan, const char *name, float old, float new,
+	      int list)
+{
+  if(old == new)
+    return(0);
 
-/* download setting into all found FADCs */
-int
-faV3DownloadAll()
+  if(list)
+    printf("  slot %2d: %-26s ch %2d  %f -> %f\n", slot, name, chan, old, new);
+
+  return(1);
+}
+
+/* Values written by the full download for pedestal and threshold */
+static int
+faV3PedestalValue(const FAV3_CONF *conf, int ichan)
 {
-  int slot, ichan, ifa, nfadc;
-  float ped;
-  extern int faV3FwRev[(FAV3_MAX_BOARDS + 1)][FAV3_FW_FUNCTION_MAX];
+  float ped = conf->pedestal[ichan] * (float) (conf->nsa + conf->nsb) / FAV3_ADC_NS_PER_CLK;
 
-    /* faInit() must be called by now; get the number of boards from there */
-  nfadc = faV3GetN();
-  printf("%s: nfadc=%d\n", __func__, nfadc);
-  for(ifa=0; ifa<nfadc; ifa++)
-    {
-      slot = faV3Slot(ifa);
+  return((int) ped);
+}
 
-      faV3SetChanDisableMask(slot, faV3[slot].chDisMask);
+static int
+faV3ThresholdValue(const FAV3_CONF *conf, int ichan)
+{
+  int thr = (conf->thr[ichan] > 0) ?
+    conf->pedestal[ichan] + conf->thr[ichan] : 0;
 
+  return(thr);
+}
 
-      if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_HALLD_SUPPORTED_PROC_FIRMWARE)
-	{
-	  faV3HallDSetProcMode(slot,
-			  faV3[slot].mode,
-			  faV3[slot].winOffset / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].winWidth / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].nsb / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].nsa / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].npeak,
-			  faV3[slot].nped,
-			  faV3[slot].max_ped,
-			  faV3[slot].nsat / FAV3_ADC_NS_PER_CLK);
-
-	  faV3HallDSetRoguePTWFallBack(slot, faV3[slot].ptw_fallback_mask);
-	}
+static void faV3ReadSlotConfig(int slot, FAV3_CONF *conf);
+
+#define DLDIFF(_name, _field, _hex)					\
+  faV3DiffInt(slot, -1, _name, ref->_field, conf->_field, _hex, dryrun)
+#define DLDIFFCH(_name, _old, _new)					\
+  faV3DiffInt(slot, ichan, _name, _old, _new, 0, dryrun)
+
+/* download the settings of one FADC that differ from the last download,
+   or from the board with FAV3_DOWNLOAD_READBACK */
+static void
+faV3DownloadSlotChanged(int slot)
+{
+  faV3DownloadResult_t *res = &faV3DownloadResult[slot];
+  const FAV3_CONF *conf = &faV3[slot], *ref = &faV3Applied[slot];
+  FAV3_CONF readback;
+  struct timespec t0, t1;
+  int dryrun = (faV3DownloadFlags & FAV3_DOWNLOAD_DRYRUN) ? 1 : 0;
+  int ichan, n, nproc, halld;
+  uint32_t bit;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  memset(res, 0, sizeof(faV3DownloadResult_t));
+
+  if(faV3DownloadFlags & FAV3_DOWNLOAD_READBACK)
+    {
+      memset(&readback, 0, sizeof(readback));
+      faV3ReadSlotConfig(slot, &readback);
+      ref = &readback;
+    }
+  else if(!faV3AppliedValid[slot])
+    {
+      if(dryrun)
+	printf("  slot %2d: no previous download, all settings\n", slot);
       else
-	{
-	  faV3SetProcMode(slot,
-			  faV3[slot].mode,
-			  faV3[slot].winOffset / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].winWidth / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].nsb / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].nsa / FAV3_ADC_NS_PER_CLK,
-			  faV3[slot].npeak);
+	faV3DownloadSlot(slot);
+      res->full = 1;
+      res->done = 1;
+      return;
+    }
 
-	  faV3SetPulseParameterConfig(slot,
-				      faV3[slot].nped,
-				      faV3[slot].max_ped,
-				      faV3[slot].nsat / FAV3_ADC_NS_PER_CLK);
+  halld = (faV3FwRev[slot][FAV3_FW_PROC] == FAV3_HALLD_SUPPORTED_PROC_FIRMWARE);
 
-	  faV3SetRoguePTWFallBack(slot, faV3[slot].ptw_fallback_mask);
+  /* The processing mode sets up the ADC, and resets the trigger path
+     threshold.  Pedestals depend on NSA + NSB.  Write everything. */
+  nproc = DLDIFF("FAV3_MODE", mode, 0) + DLDIFF("FAV3_W_OFFSET", winOffset, 0) +
+    DLDIFF("FAV3_W_WIDTH", winWidth, 0) + DLDIFF("FAV3_NSB", nsb, 0) +
+    DLDIFF("FAV3_NSA", nsa, 0) + DLDIFF("FAV3_NPEAK", npeak, 0);
+  if(halld)
+    nproc += DLDIFF("FAV3_NPED", nped, 0) + DLDIFF("FAV3_MAXPED", max_ped, 0) +
+      DLDIFF("FAV3_NSAT", nsat, 0);
 
+  if(nproc)
+    {
+      if(dryrun)
+	printf("  slot %2d: processing mode changed, all settings\n", slot);
+      else
+	faV3DownloadSlot(slot);
+      res->nchange = nproc;
+      res->full = 1;
+      res->done = 1;
+      return;
+    }
 
-	}
+  DLCHANGED(DLDIFF("FAV3_ADC_MASK (disabled)", chDisMask, 1),
+	    faV3SetChanDisableMask(slot, conf->chDisMask));
 
-      faV3SetTriggerPathSamples(slot, faV3[slot].trig_nsa / FAV3_ADC_NS_PER_CLK,
-				faV3[slot].trig_nsat / FAV3_ADC_NS_PER_CLK);
-      faV3SetTriggerPathThreshold(slot, faV3[slot].trig_thr);
+  if(halld)
+    {
+      DLCHANGED(DLDIFF("FAV3_PTW_FALLBACK_MASK", ptw_fallback_mask, 1),
+		faV3HallDSetRoguePTWFallBack(slot, conf->ptw_fallback_mask));
+    }
+  else
+    {
+      DLCHANGED(DLDIFF("FAV3_NPED", nped, 0) + DLDIFF("FAV3_MAXPED", max_ped, 0) +
+		DLDIFF("FAV3_NSAT", nsat, 0),
+		faV3SetPulseParameterConfig(slot, conf->nped, conf->max_ped,
+					    conf->nsat / FAV3_ADC_NS_PER_CLK));
+      DLCHANGED(DLDIFF("FAV3_PTW_FALLBACK_MASK", ptw_fallback_mask, 1),
+		faV3SetRoguePTWFallBack(slot, conf->ptw_fallback_mask));
+    }
+
+  DLCHANGED(DLDIFF("FAV3_TRIG_NSA", trig_nsa, 0) + DLDIFF("FAV3_TRIG_NSAT", trig_nsat, 0),
+	    faV3SetTriggerPathSamples(slot, conf->trig_nsa / FAV3_ADC_NS_PER_CLK,
+				      conf->trig_nsat / FAV3_ADC_NS_PER_CLK));
+  DLCHANGED(DLDIFF("FAV3_TRIG_THR", trig_thr, 0),
+	    faV3SetTriggerPathThreshold(slot, conf->trig_thr));
+
+  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
+    {
+      DLCHANGED(DLDIFF("FAV3_TRG_MASK", trigMask, 1),
+		faV3SetHitbitTrigMask(slot, conf->trigMask));
+      DLCHANGED(DLDIFF("FAV3_TRG_WIDTH", trigWidth, 0),
+		faV3SetHitbitTrigWidth(slot, conf->trigWidth / FAV3_ADC_NS_PER_CLK));
+      DLCHANGED(DLDIFF("FAV3_TRG_MINTOT", trigMinTOT, 0),
+		faV3SetHitbitMinTOT(slot, conf->trigMinTOT));
+      DLCHANGED(DLDIFF("FAV3_TRG_MINMULT", trigMinMult, 0),
+		faV3SetHitbitMinMultiplicity(slot, conf->trigMinMult));
+
+      DLCHANGED(DLDIFF("FAV3_TET_IGNORE_MASK", thrIgnoreMask, 1),
+		faV3ThresholdIgnore(slot, conf->thrIgnoreMask));
+      DLCHANGED(DLDIFF("FAV3_INVERT_MASK", invertMask, 1),
+		faV3SetInvertMask(slot, conf->invertMask));
+      DLCHANGED(DLDIFF("FAV3_PLAYBACK_DISABLE_MASK", playbackDisableMask, 1),
+		faV3PlaybackDisable(slot, conf->playbackDisableMask));
+      DLCHANGED(DLDIFF("FAV3_SPARSIFICATION", sparsification, 0),
+		faV3SetSparsificationMode(slot, conf->sparsification));
+      DLCHANGED(DLDIFF("FAV3_ACCUMULATOR_MASK", accumulatorMask, 1),
+		faV3SetAccumulatorScalerMode(slot, conf->accumulatorMask));
+    }
 
+  DLCHANGED(DLDIFF("FAV3_DATA_FORMAT", data_format, 0),
+	    faV3SetDataFormat(slot, conf->data_format));
+  DLCHANGED(DLDIFF("FAV3_SUPPRESS_TRIG_TIME", suppress_trig_time, 0),
+	    faV3DataSuppressTriggerTime(slot, conf->suppress_trig_time));
+  DLCHANGED(DLDIFF("FAV3_INSERT_ADC_PARAMS", insert_adc_params, 0),
+	    faV3DataInsertAdcParameters(slot, conf->insert_adc_params));
+  DLCHANGED(DLDIFF("FAV3_COMPRESSION", compression, 0),
+	    faV3SetCompression(slot, conf->compression));
+  DLCHANGED(DLDIFF("FAV3_VXSREADOUT", vxsReadout, 0),
+	    faV3SetVXSReadout(slot, conf->vxsReadout));
+
+  for(ichan=0; ichan<NCHAN; ichan++)
+    {
       if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
 	{
-	  faV3SetHitbitTrigMask(slot, faV3[slot].trigMask);
-	  faV3SetHitbitTrigWidth(slot, faV3[slot].trigWidth / FAV3_ADC_NS_PER_CLK);
-	  faV3SetHitbitMinTOT(slot, faV3[slot].trigMinTOT);
-	  faV3SetHitbitMinMultiplicity(slot, faV3[slot].trigMinMult);
-
-	  faV3ThresholdIgnore(slot, faV3[slot].thrIgnoreMask);
-	  faV3SetInvertMask(slot, faV3[slot].invertMask);
-	  faV3PlaybackDisable(slot, faV3[slot].playbackDisableMask);
-	  faV3SetSparsificationMode(slot, faV3[slot].sparsification);
-	  faV3SetAccumulatorScalerMode(slot, faV3[slot].accumulatorMask);
+	  bit = 1 << ichan;
+	  DLCHANGED(DLDIFFCH("FAV3_TRIG_MODE_MASK",
+			   (ref->trigModeMask & bit) ? 1 : 0,
+			   (conf->trigModeMask & bit) ? 1 : 0),
+		    faV3SetTriggerProcessingMode(slot, ichan,
+						 (conf->trigModeMask & bit) ? 1 : 0));
+	  DLCHANGED(faV3DiffFloat(slot, ichan, "FAV3_CH_GAIN",
+				  ref->gain[ichan], conf->gain[ichan], dryrun),
+		    faV3SetChannelGain(slot, ichan, conf->gain[ichan]));
+	  DLCHANGED(DLDIFFCH("FAV3_CH_DELAY", ref->delay[ichan], conf->delay[ichan]),
+		    faV3SetChannelDelay(slot, ichan, conf->delay[ichan] / FAV3_ADC_NS_PER_CLK));
 	}
 
-      faV3SetDataFormat(slot, faV3[slot].data_format);
-      faV3DataSuppressTriggerTime(slot, faV3[slot].suppress_trig_time);
-      faV3DataInsertAdcParameters(slot, faV3[slot].insert_adc_params);
-      faV3SetCompression(slot,faV3[slot].compression);
-      faV3SetVXSReadout(slot,faV3[slot].vxsReadout);
+      /* Compared as written, since the readback pedestal is rounded */
+      DLCHANGED(DLDIFFCH("FAV3_CH_PED (sum)", faV3PedestalValue(ref, ichan),
+		       faV3PedestalValue(conf, ichan)),
+		faV3SetPedestal(slot, ichan, faV3PedestalValue(conf, ichan)));
+      DLCHANGED(DLDIFFCH("FAV3_CH_TET (+ pedestal)", faV3ThresholdValue(ref, ichan),
+		       faV3ThresholdValue(conf, ichan)),
+		faV3SetThreshold(slot, ichan, faV3ThresholdValue(conf, ichan)));
+      DLCHANGED(DLDIFFCH("FAV3_CH_DAC", ref->dac[ichan], conf->dac[ichan]),
+		faV3DACSet(slot, ichan, conf->dac[ichan]));
+    }
 
+  if(!dryrun && (res->nfail == 0))
+    {
+      faV3Applied[slot] = faV3[slot];
+      faV3AppliedValid[slot] = 1;
+    }
 
-      for(ichan=0; ichan<NCHAN; ichan++)
-	{
-	  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
-	    {
-	      faV3SetTriggerProcessingMode(slot, ichan,
-					   (faV3[slot].trigModeMask & (1 << ichan)) ? 1 : 0);
-	      faV3SetChannelGain(slot, ichan, faV3[slot].gain[ichan]);
-	      faV3SetChannelDelay(slot, ichan, faV3[slot].delay[ichan] / FAV3_ADC_NS_PER_CLK);
-	    }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  res->ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6;
+  res->done = 1;
+}
+
+/* Each worker takes the next board until there are none left.  The
+   library routines only lock their own slot, so boards do not wait on
+   each other.  The thresholds and trigger gains of a board are written
+   once each, at the end of its download (faV3ShadowBatch). */
+static void *
+faV3DownloadWorker(void *arg)
+{
+  int nfadc = *(int *) arg;
+  int batch = !(faV3DownloadFlags & FAV3_DOWNLOAD_DRYRUN);
+  int ifa, slot;
 
-	  float ped = faV3[slot].pedestal[ichan] * (float) (faV3[slot].nsa + faV3[slot].nsb) / FAV3_ADC_NS_PER_CLK;
-	  faV3SetPedestal(slot, ichan, (int) ped);
+  while(1)
+    {
+      pthread_mutex_lock(&faV3DownloadMutex);
+      ifa = faV3DownloadNext++;
+      pthread_mutex_unlock(&faV3DownloadMutex);
 
-	  int thr = (faV3[slot].thr[ichan] > 0) ?
-	    faV3[slot].pedestal[ichan] + faV3[slot].thr[ichan] : 0;
-	  faV3SetThreshold(slot, ichan, thr);
+      if(ifa >= nfadc)
+	break;
 
-	  faV3DACSet(slot, ichan, faV3[slot].dac[ichan]);
-	}
+      slot = faV3Slot(ifa);
+      if(batch)
+	faV3ShadowBatch(slot, 1);
+
+      if(faV3DownloadFlags & FAV3_DOWNLOAD_CHANGED)
+	faV3DownloadSlotChanged(slot);
+      else
+	faV3DownloadSlot(slot);
+
+      if(batch)
+	faV3ShadowBatch(slot, 0);
+    }
+
+  return(NULL);
+}
+
+/* Number of threads used by faV3DownloadAll. 1 downloads in the calling thread. */
+int
+faV3SetDownloadThreads(int nthreads)
+{
+  if((nthreads < 1) || (nthreads > FAV3_MAX_BOARDS))
+    {
+      printf("%s: ERROR: Invalid number of threads (%d)\n",
+	     __func__, nthreads);
+      return(-1);
     }
 
+  faV3DownloadThreads = nthreads;
+
   return(0);
 }
 
-int32_t
-faV3GetModulesConfig()
+static int
+faV3DownloadRun(const char *caller, int flags)
 {
-  int slot, ichan, ifa, nfadc;
-  float ped = 0.;
-  int thres = 0;
-  uint32_t fw_vers = 0;
-  extern int faV3FwRev[(FAV3_MAX_BOARDS + 1)][FAV3_FW_FUNCTION_MAX];
+  pthread_t thread[FAV3_MAX_BOARDS];
+  int slot, ifa, nfadc, nthreads, nstarted, nbad = 0;
+  faV3DownloadResult_t *res;
 
+    /* faInit() must be called by now; get the number of boards from there */
   nfadc = faV3GetN();
+  printf("%s: nfadc=%d\n", caller, nfadc);
+
+  memset(faV3DownloadResult, 0, sizeof(faV3DownloadResult));
+  faV3DownloadNext = 0;
+  faV3DownloadFlags = flags;
+
+  nthreads = faV3DownloadThreads;
+  if(nthreads > nfadc)
+    nthreads = nfadc;
+  if(flags & FAV3_DOWNLOAD_DRYRUN)
+    nthreads = 1;		/* keep the listing in slot order */
 
+  /* This thread downloads too, so one fewer is started */
+  for(nstarted = 0; nstarted < nthreads - 1; nstarted++)
+    {
+      if(pthread_create(&thread[nstarted], NULL, faV3DownloadWorker, &nfadc) != 0)
+	{
+	  perror("pthread_create");
+	  break;
+	}
+    }
+
+  faV3DownloadWorker(&nfadc);
+
+  for(ifa = 0; ifa < nstarted; ifa++)
+    pthread_join(thread[ifa], NULL);
+
+  if(flags & FAV3_DOWNLOAD_DRYRUN)
+    return(0);
 
   for(ifa = 0; ifa < nfadc; ifa++)
     {
       slot = faV3Slot(ifa);
+      res = &faV3DownloadResult[slot];
 
-      faV3[slot].chDisMask = faV3GetChanDisableMask(slot);
-
-      if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_HALLD_SUPPORTED_PROC_FIRMWARE)
+      if(res->nfail)
 	{
-	  faV3HallDGetProcMode(slot,
-			       &faV3[slot].mode,
-			       &faV3[slot].winOffset,
-			       &faV3[slot].winWidth,
-			       &faV3[slot].nsb,
-			       &faV3[slot].nsa,
-			       &faV3[slot].npeak,
-			       &faV3[slot].nped,
-			       &faV3[slot].max_ped,
-			       &faV3[slot].nsat);
-	  faV3[slot].winOffset *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].winWidth *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].nsb *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].nsa *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].nsat *= FAV3_ADC_NS_PER_CLK;
-
-	  faV3HallDGetRoguePTWFallBack(slot, &faV3[slot].ptw_fallback_mask);
+	  nbad++;
+	  printf("%s: slot %2d: FAILED  %d call(s), first %.*s  (%.1f ms)\n",
+		 caller, slot, res->nfail,
+		 (int) strcspn(res->first_fail, "("), res->first_fail, res->ms);
 	}
+      else if((flags & FAV3_DOWNLOAD_CHANGED) && !res->full)
+	printf("%s: slot %2d: OK  %d change(s)  (%.1f ms)\n",
+	       caller, slot, res->nchange, res->ms);
       else
-	{
-	  faV3GetProcMode(slot,
-			  &faV3[slot].mode,
-			  &faV3[slot].winOffset,
-			  &faV3[slot].winWidth,
-			  &faV3[slot].nsb,
-			  &faV3[slot].nsa,
-			  &faV3[slot].npeak);
-	  faV3[slot].winOffset *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].winWidth *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].nsb *= FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].nsa *= FAV3_ADC_NS_PER_CLK;
-
-	  faV3GetPulseParameterConfig(slot,
-				      &faV3[slot].nped,
-				      &faV3[slot].max_ped,
-				      &faV3[slot].nsat);
-	  faV3[slot].nsat *= FAV3_ADC_NS_PER_CLK;
-
-	  faV3GetRoguePTWFallBack(slot, &faV3[slot].ptw_fallback_mask);
-	}
+	printf("%s: slot %2d: OK  (%.1f ms)\n", caller, slot, res->ms);
+    }
+
+  if(nbad)
+    {
+      printf("%s: ERROR: %d of %d board(s) not fully configured\n",
+	     caller, nbad, nfadc);
+      return(-1);
+    }
+
+  return(0);
+}
+
+/* download setting into all found FADCs */
+int
+faV3DownloadAll()
+{
+  return(faV3DownloadRun(__func__, 0));
+}
+
+/* download only the settings that changed since the last download, or
+   that differ from the boards with FAV3_DOWNLOAD_READBACK.
+   FAV3_DOWNLOAD_DRYRUN lists them without writing. */
+int
+faV3DownloadChanged(int flags)
+{
+  return(faV3DownloadRun(__func__,
+			 (flags & (FAV3_DOWNLOAD_DRYRUN | FAV3_DOWNLOAD_READBACK)) |
+			 FAV3_DOWNLOAD_CHANGED));
+}
+
+/* Result of the last faV3DownloadAll for a slot: number of calls that
+   failed, or -1 if the slot was not downloaded */
+int
+faV3DownloadStatus(int slot)
+{
+  if((slot < 0) || (slot > NBOARD) || !faV3DownloadResult[slot].done)
+    return(-1);
+
+  return(faV3DownloadResult[slot].nfail);
+}
+
+/* read the settings of one FADC */
+static void
+faV3ReadSlotConfig(int slot, FAV3_CONF *conf)
+{
+  int ichan;
+
+  conf->chDisMask = faV3GetChanDisableMask(slot);
+
+  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_HALLD_SUPPORTED_PROC_FIRMWARE)
+    {
+      faV3HallDGetProcMode(slot,
+			   &conf->mode,
+			   &conf->winOffset,
+			   &conf->winWidth,
+			   &conf->nsb,
+			   &conf->nsa,
+			   &conf->npeak,
+			   &conf->nped,
+			   &conf->max_ped,
+			   &conf->nsat);
+      conf->winOffset *= FAV3_ADC_NS_PER_CLK;
+      conf->winWidth *= FAV3_ADC_NS_PER_CLK;
+      conf->nsb *= FAV3_ADC_NS_PER_CLK;
+      conf->nsa *= FAV3_ADC_NS_PER_CLK;
+      conf->nsat *= FAV3_ADC_NS_PER_CLK;
+
+      faV3HallDGetRoguePTWFallBack(slot, &conf->ptw_fallback_mask);
+    }
+  else
+    {
+      faV3GetProcMode(slot,
+		      &conf->mode,
+		      &conf->winOffset,
+		      &conf->winWidth,
+		      &conf->nsb,
+		      &conf->nsa,
+		      &conf->npeak);
+      conf->winOffset *= FAV3_ADC_NS_PER_CLK;
+      conf->winWidth *= FAV3_ADC_NS_PER_CLK;
+      conf->nsb *= FAV3_ADC_NS_PER_CLK;
+      conf->nsa *= FAV3_ADC_NS_PER_CLK;
+
+      faV3GetPulseParameterConfig(slot,
+				  &conf->nped,
+				  &conf->max_ped,
+				  &conf->nsat);
+      conf->nsat *= FAV3_ADC_NS_PER_CLK;
+
+      faV3GetRoguePTWFallBack(slot, &conf->ptw_fallback_mask);
+    }
+
+  faV3GetTriggerPathSamples(slot, &conf->trig_nsa, &conf->trig_nsat);
+  conf->trig_nsa *= FAV3_ADC_NS_PER_CLK;
+  conf->trig_nsat *= FAV3_ADC_NS_PER_CLK;
+  faV3GetTriggerPathThreshold(slot, &conf->trig_thr);
+
+  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
+    {
+      conf->trigMask = faV3GetHitbitTrigMask(slot);
+      conf->trigWidth = faV3GetHitbitTrigWidth(slot) * FAV3_ADC_NS_PER_CLK;
+      conf->trigMinTOT = faV3GetHitbitMinTOT(slot);
+      conf->trigMinMult = faV3GetHitbitMinMultiplicity(slot);
+
+      conf->thrIgnoreMask = faV3GetThresholdIgnoreMask(slot);
+      conf->invertMask = faV3GetInvertMask(slot);
+      conf->playbackDisableMask = faV3GetPlaybackDisableMask(slot);
+      conf->sparsification = faV3GetSparsificationMode(slot);
+      conf->accumulatorMask = faV3GetAccumulatorScalerMode(slot);
+    }
 
-      faV3GetTriggerPathSamples(slot, &faV3[slot].trig_nsa, &faV3[slot].trig_nsat);
-      faV3[slot].trig_nsa *= FAV3_ADC_NS_PER_CLK;
-      faV3[slot].trig_nsat *= FAV3_ADC_NS_PER_CLK;
-      faV3GetTriggerPathThreshold(slot, &faV3[slot].trig_thr);
+  conf->data_format = faV3GetDataFormat(slot);
+  conf->suppress_trig_time = faV3DataGetSuppressTriggerTime(slot);
+  conf->insert_adc_params = faV3DataGetInsertAdcParameters(slot);
+  conf->compression = faV3GetCompression(slot);
+  conf->vxsReadout = faV3GetVXSReadout(slot);
 
+
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    {
       if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
 	{
-	  faV3[slot].trigMask = faV3GetHitbitTrigMask(slot);
-	  faV3[slot].trigWidth = faV3GetHitbitTrigWidth(slot) * FAV3_ADC_NS_PER_CLK;
-	  faV3[slot].trigMinTOT = faV3GetHitbitMinTOT(slot);
-	  faV3[slot].trigMinMult = faV3GetHitbitMinMultiplicity(slot);
-
-	  faV3[slot].thrIgnoreMask = faV3GetThresholdIgnoreMask(slot);
-	  faV3[slot].invertMask = faV3GetInvertMask(slot);
-	  faV3[slot].playbackDisableMask = faV3GetPlaybackDisableMask(slot);
-	  faV3[slot].sparsification = faV3GetSparsificationMode(slot);
-	  faV3[slot].accumulatorMask = faV3GetAccumulatorScalerMode(slot);
+	  conf->trigModeMask |= (faV3GetTriggerProcessingMode(slot, ichan) << ichan);
+	  conf->gain[ichan] = faV3GetChannelGain(slot, ichan);
+	  conf->delay[ichan] = faV3GetChannelDelay(slot, ichan) * FAV3_ADC_NS_PER_CLK;
 	}
 
-      faV3[slot].data_format = faV3GetDataFormat(slot);
-      faV3[slot].suppress_trig_time = faV3DataGetSuppressTriggerTime(slot);
-      faV3[slot].insert_adc_params = faV3DataGetInsertAdcParameters(slot);
-      faV3[slot].compression = faV3GetCompression(slot);
-      faV3[slot].vxsReadout = faV3GetVXSReadout(slot);
+      conf->pedestal[ichan] =  (float) faV3GetPedestal(slot, ichan) *
+	FAV3_ADC_NS_PER_CLK / (conf->nsa + conf->nsb);
 
+      int thr = faV3GetThreshold(slot, ichan) & FAV3_THR_VALUE_MASK;
+      if (thr > 0)
+	conf->thr[ichan] = thr - (int)conf->pedestal[ichan];
 
-      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
-	{
-	  if(faV3FwRev[slot][FAV3_FW_PROC] == FAV3_SUPPORTED_PROC_FIRMWARE)
-	    {
-	      faV3[slot].trigModeMask |= (faV3GetTriggerProcessingMode(slot, ichan) << ichan);
-	      faV3[slot].gain[ichan] = faV3GetChannelGain(slot, ichan);
-	      faV3[slot].delay[ichan] = faV3GetChannelDelay(slot, ichan) * FAV3_ADC_NS_PER_CLK;
-	    }
+      faV3DACGet(slot, ichan, &conf->dac[ichan]);
+    }
+}
+
+int32_t
+faV3GetModulesConfig()
+{
+  int slot, ifa, nfadc;
 
-	  faV3[slot].pedestal[ichan] =  (float) faV3GetPedestal(slot, ichan) *
-	    FAV3_ADC_NS_PER_CLK / (faV3[slot].nsa + faV3[slot].nsb);
+  nfadc = faV3GetN();
 
-	  int thr = faV3GetThreshold(slot, ichan);
-	  if (thr > 0)
-	    faV3[slot].thr[ichan] = thr - (int)faV3[slot].pedestal[ichan];
 
-	  faV3DACGet(slot, ichan, &faV3[slot].dac[ichan]);
-	}
+  for(ifa = 0; ifa < nfadc; ifa++)
+    {
+      slot = faV3Slot(ifa);
+
+      faV3ReadSlotConfig(slot, &faV3[slot]);
     }
   return 0;
 }
 
+/* Write cursor for faV3ConfigToString.  Lines that do not fit are
+   counted, not written, so len ends up as the length of the whole text. */
+typedef struct
+{
+  char *buf;
+  int32_t size;			/* of buf, 0 to only count */
+  int32_t len;			/* of the text so far */
+  int32_t full;			/* a line did not fit; no more are written */
+} faV3ConfCursor_t;
+
+static void
+faV3CursorPrintf(faV3ConfCursor_t *cur, const char *format, ...)
+{
+  va_list args;
+  int32_t room = 0, n;
+
+  if(!cur->full)
+    room = cur->size - cur->len;
+
+  va_start(args, format);
+  n = vsnprintf((room > 0) ? cur->buf + cur->len : NULL, (room > 0) ? room : 0,
+		format, args);
+  va_end(args);
+
+  if(n < 0)
+    return;
+
+  if(!cur->full && (n >= room))
+    {
+      /* keep whole lines only */
+      cur->full = 1;
+      if(cur->size > 0)
+	cur->buf[cur->len] = '\0';
+    }
+
+  cur->len += n;
+}
+
+/* keyword, then one value per channel */
+static void
+faV3CursorMask(faV3ConfCursor_t *cur, const char *keyword, uint32_t mask)
+{
+  faV3CursorPrintf(cur,
+		   "%s %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n",
+		   keyword,
+		   (mask >> 0) & 0x1, (mask >> 1) & 0x1, (mask >> 2) & 0x1,
+		   (mask >> 3) & 0x1, (mask >> 4) & 0x1, (mask >> 5) & 0x1,
+		   (mask >> 6) & 0x1, (mask >> 7) & 0x1, (mask >> 8) & 0x1,
+		   (mask >> 9) & 0x1, (mask >> 10) & 0x1, (mask >> 11) & 0x1,
+		   (mask >> 12) & 0x1, (mask >> 13) & 0x1, (mask >> 14) & 0x1,
+		   (mask >> 15) & 0x1);
+}
+
+static void
+faV3CursorInts(faV3ConfCursor_t *cur, const char *keyword, const uint32_t *v)
+{
+  faV3CursorPrintf(cur,
+		   "%s %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n",
+		   keyword,
+		   v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+		   v[8], v[9], v[10], v[11], v[12], v[13], v[14], v[15]);
+}
+
+static void
+faV3CursorFloats(faV3ConfCursor_t *cur, const char *keyword, const float *v)
+{
+  faV3CursorPrintf(cur,
+		   "%s %.1f %.1f %.1f %.1f %.1f %.1f %.1f %.1f"
+		   " %.1f %.1f %.1f %.1f %.1f %.1f %.1f %.1f\n",
+		   keyword,
+		   v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+		   v[8], v[9], v[10], v[11], v[12], v[13], v[14], v[15]);
+}
+
+/* Write the configuration of all found FADCs as config file text.
+
+   Returns the length of the whole text, as snprintf does.  If that is
+   length or more, only the lines that fit were written.  With string
+   NULL or length 0, nothing is written and the length is returned, so
+   the caller can size the buffer. */
 int32_t
 faV3ConfigToString(char *string, int32_t length)
 {
-  int slot, ichan, ifa, nfadc;
-  uint32_t adcChanEnabled = 0;
+  int slot, ifa, nfadc;
   char   host[ROCLEN];
-
-  CONFIG_STRING_VARS;
+  faV3ConfCursor_t cur;
+  const FAV3_CONF *conf;
 
   gethostname(host, ROCLEN);	/* obtain our hostname - and drop any domain extension */
   for(int jj = 0; jj < strlen(host); jj++)
@@ -484,232 +1322,247 @@ faV3ConfigToString(char *string, int32_t length)
 
   nfadc = faV3GetN();
 
-  str = string;
-  str[0] = '\0';
+  memset(&cur, 0, sizeof(cur));
+  if((string != NULL) && (length > 0))
+    {
+      cur.buf = string;
+      cur.size = length;
+      string[0] = '\0';
+    }
 
-  sprintf(sss,"FAV3_CRATE %s\n", host);
-  ADD_TO_STRING;
+  faV3CursorPrintf(&cur, "FAV3_CRATE %s\n", host);
 
   for(ifa=0; ifa<nfadc; ifa++)
     {
       slot = faV3Slot(ifa);
+      conf = &faV3[slot];
+
+      faV3CursorPrintf(&cur, "FAV3_SLOT %d\n", slot);
+
+      faV3CursorMask(&cur, "FAV3_ADC_MASK", ~conf->chDisMask & 0xFFFF);
+
+      faV3CursorPrintf(&cur, "FAV3_MODE %d\n", conf->mode);
+      faV3CursorPrintf(&cur, "FAV3_W_OFFSET %d\n", conf->winOffset);
+      faV3CursorPrintf(&cur, "FAV3_W_WIDTH  %d\n", conf->winWidth);
+      faV3CursorPrintf(&cur, "FAV3_NSA %d\n", conf->nsa);
+      faV3CursorPrintf(&cur, "FAV3_NSB %d\n", conf->nsb);
+      faV3CursorPrintf(&cur, "FAV3_NPEAK %d\n", conf->npeak);
+      faV3CursorPrintf(&cur, "FAV3_NSAT %d\n", conf->nsat);
+      faV3CursorPrintf(&cur, "FAV3_NPED %d\n", conf->nped);
+      faV3CursorPrintf(&cur, "FAV3_MAXPED %d\n", conf->max_ped);
+
+      faV3CursorMask(&cur, "FAV3_PTW_FALLBACK_MASK", conf->ptw_fallback_mask);
+
+      faV3CursorPrintf(&cur, "FAV3_TRIG_NSA %d\n", conf->trig_nsa);
+      faV3CursorPrintf(&cur, "FAV3_TRIG_NSAT %d\n", conf->trig_nsat);
+      faV3CursorPrintf(&cur, "FAV3_TRIG_THR %d\n", conf->trig_thr);
+
+      faV3CursorMask(&cur, "FAV3_TRG_MASK", conf->trigMask);
+      faV3CursorPrintf(&cur, "FAV3_TRG_WIDTH %d\n", conf->trigWidth);
+      faV3CursorPrintf(&cur, "FAV3_TRG_MINTOT %d\n", conf->trigMinTOT);
+      faV3CursorPrintf(&cur, "FAV3_TRG_MINMULT %d\n", conf->trigMinMult);
+
+      faV3CursorMask(&cur, "FAV3_TET_IGNORE_MASK", conf->thrIgnoreMask);
+      faV3CursorMask(&cur, "FAV3_INVERT_MASK", conf->invertMask);
+      faV3CursorMask(&cur, "FAV3_PLAYBACK_DISABLE_MASK", conf->playbackDisableMask);
+      faV3CursorPrintf(&cur, "FAV3_SPARSIFICATION %d\n", conf->sparsification);
+      faV3CursorMask(&cur, "FAV3_ACCUMULATOR_MASK", conf->accumulatorMask);
+      faV3CursorMask(&cur, "FAV3_TRIG_MODE_MASK", conf->trigModeMask);
+
+      faV3CursorFloats(&cur, "FAV3_ALLCH_PED", conf->pedestal);
+      faV3CursorInts(&cur, "FAV3_ALLCH_TET", conf->thr);
+      faV3CursorInts(&cur, "FAV3_ALLCH_DAC", conf->dac);
+      faV3CursorFloats(&cur, "FAV3_ALLCH_GAIN", conf->gain);
+      faV3CursorInts(&cur, "FAV3_ALLCH_DELAY", conf->delay);
+
+      faV3CursorPrintf(&cur, "FAV3_DATA_FORMAT %d\n", conf->data_format);
+      faV3CursorPrintf(&cur, "FAV3_SUPPRESS_TRIG_TIME %d\n", conf->suppress_trig_time);
+      faV3CursorPrintf(&cur, "FAV3_INSERT_ADC_PARAMS %d\n", conf->insert_adc_params);
+      faV3CursorPrintf(&cur, "FAV3_COMPRESSION %d\n", conf->compression);
+      faV3CursorPrintf(&cur, "FAV3_VXSREADOUT %d\n", conf->vxsReadout);
+    }
 
-      sprintf(sss,"FAV3_SLOT %d\n",slot);
-      ADD_TO_STRING;
-
-      adcChanEnabled = ~faV3[slot].chDisMask & 0xFFFF;
-      sprintf(sss,"FAV3_ADC_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(adcChanEnabled>>ichan)&0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_MODE %d\n",      faV3[slot].mode);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_W_OFFSET %d\n", faV3[slot].winOffset);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_W_WIDTH  %d\n", faV3[slot].winWidth);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_NSA %d\n", faV3[slot].nsa);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_NSB %d\n", faV3[slot].nsb);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_NPEAK %d\n", faV3[slot].npeak);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_NSAT %d\n", faV3[slot].nsat);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_NPED %d\n", faV3[slot].nped);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_MAXPED %d\n", faV3[slot].max_ped);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_PTW_FALLBACK_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].ptw_fallback_mask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_TRIG_NSA %d\n", faV3[slot].trig_nsa);
-      ADD_TO_STRING;
+  faV3CursorPrintf(&cur, "FAV3_CRATE end\n");
 
-      sprintf(sss,"FAV3_TRIG_NSAT %d\n", faV3[slot].trig_nsat);
-      ADD_TO_STRING;
+  if(cur.full && (cur.size > 0))
+    printf("%s: ERROR: %d bytes needed, only %d given.  Output truncated.\n",
+	   __func__, cur.len + 1, length);
 
-      sprintf(sss,"FAV3_TRIG_THR %d\n", faV3[slot].trig_thr);
-      ADD_TO_STRING;
+  return(cur.len);
+}
 
-      sprintf(sss,"FAV3_TRG_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].trigMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+/* Settings of FAV3_CONF in the binary encoding, in order */
+typedef struct
+{
+  size_t offset;		/* in FAV3_CONF */
+  int32_t count;		/* values */
+  size_t size;			/* of one value, 2 or 4 bytes */
+} faV3ConfWords_t;
+
+#define CONFWORD(_field)						\
+  { offsetof(FAV3_CONF, _field), 1, sizeof(((FAV3_CONF *) 0)->_field) }
+#define CONFWORDS(_field)						\
+  { offsetof(FAV3_CONF, _field), MAX_FAV3_CH, sizeof(((FAV3_CONF *) 0)->_field[0]) }
+
+static const faV3ConfWords_t faV3ConfWords[] =
+  {
+    CONFWORD(proc_version), CONFWORD(chDisMask), CONFWORD(mode),
+    CONFWORD(winOffset), CONFWORD(winWidth), CONFWORD(nsb), CONFWORD(nsa),
+    CONFWORD(npeak), CONFWORD(nsat), CONFWORD(nped), CONFWORD(max_ped),
+    CONFWORD(ptw_fallback_mask),
+    CONFWORD(trig_thr), CONFWORD(trig_nsa), CONFWORD(trig_nsat),
+    CONFWORD(trigMask), CONFWORD(trigWidth), CONFWORD(trigMinTOT),
+    CONFWORD(trigMinMult),
+    CONFWORD(thrIgnoreMask), CONFWORD(invertMask),
+    CONFWORD(playbackDisableMask), CONFWORD(sparsification),
+    CONFWORD(accumulatorMask), CONFWORD(trigModeMask),
+    CONFWORDS(pedestal), CONFWORDS(thr), CONFWORDS(dac), CONFWORDS(gain),
+    CONFWORDS(delay),
+    CONFWORD(data_format), CONFWORD(suppress_trig_time),
+    CONFWORD(insert_adc_params), CONFWORD(compression), CONFWORD(vxsReadout)
+  };
+
+#define NCONFWORDS (sizeof(faV3ConfWords) / sizeof(faV3ConfWords[0]))
+
+static uint32_t
+faV3ConfBoardWords()
+{
+  uint32_t i, n = 1;		/* slot */
 
-      sprintf(sss,"FAV3_TRG_WIDTH %d\n", faV3[slot].trigWidth);
-      ADD_TO_STRING;
+  for(i = 0; i < NCONFWORDS; i++)
+    n += faV3ConfWords[i].count;
 
-      sprintf(sss,"FAV3_TRG_MINTOT %d\n", faV3[slot].trigMinTOT);
-      ADD_TO_STRING;
+  return(n);
+}
 
-      sprintf(sss,"FAV3_TRG_MINMULT %d\n", faV3[slot].trigMinMult);
-      ADD_TO_STRING;
+/* Write the configuration of all found FADCs in the binary encoding
+   (FAV3_CONF_MAGIC in faV3Config.h).
 
-      sprintf(sss,"FAV3_TET_IGNORE_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].thrIgnoreMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+   Returns the number of bytes of the whole encoding.  Nothing is written
+   if that is more than length, or if buf is NULL. */
+int32_t
+faV3ConfigToBinary(void *buf, int32_t length)
+{
+  uint32_t *w = (uint32_t *) buf;
+  uint32_t nwords, i, j, u32;
+  uint16_t u16;
+  int slot, ifa, nfadc;
+  const char *p;
 
-      sprintf(sss,"FAV3_INVERT_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].invertMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+  nfadc = faV3GetN();
+  nwords = 4 + nfadc * faV3ConfBoardWords();
 
-      sprintf(sss,"FAV3_PLAYBACK_DISABLE_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].playbackDisableMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+  if((buf == NULL) || (length < (int32_t) (nwords * sizeof(uint32_t))))
+    {
+      if((buf != NULL) && (length > 0))
+	printf("%s: ERROR: %d bytes needed, only %d given\n",
+	       __func__, (int) (nwords * sizeof(uint32_t)), length);
+      return(nwords * sizeof(uint32_t));
+    }
 
-      sprintf(sss,"FAV3_SPARSIFICATION %d\n", faV3[slot].sparsification);
-      ADD_TO_STRING;
+  *w++ = FAV3_CONF_MAGIC;
+  *w++ = FAV3_CONF_VERSION;
+  *w++ = nfadc;
+  *w++ = faV3ConfBoardWords();
 
-      sprintf(sss,"FAV3_ACCUMULATOR_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",(faV3[slot].accumulatorMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+  for(ifa = 0; ifa < nfadc; ifa++)
+    {
+      slot = faV3Slot(ifa);
+      *w++ = slot;
 
-      sprintf(sss,"FAV3_TRIG_MODE_MASK");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
+      for(i = 0; i < NCONFWORDS; i++)
 	{
-	  sprintf(sss," %d",(faV3[slot].trigModeMask >> ichan) & 0x1);
-	  ADD_TO_STRING;
+	  p = (const char *) &faV3[slot] + faV3ConfWords[i].offset;
+	  for(j = 0; j < faV3ConfWords[i].count; j++, p += faV3ConfWords[i].size)
+	    {
+	      if(faV3ConfWords[i].size == sizeof(uint16_t))
+		{
+		  memcpy(&u16, p, sizeof(u16));
+		  u32 = u16;
+		}
+	      else
+		memcpy(&u32, p, sizeof(u32));
+	      *w++ = u32;
+	    }
 	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+    }
 
-      sprintf(sss,"FAV3_ALLCH_PED");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %.1f",faV3[slot].pedestal[ichan]);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+  return(nwords * sizeof(uint32_t));
+}
 
-      sprintf(sss,"FAV3_ALLCH_TET");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",faV3[slot].thr[ichan]);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+/* Read back the binary encoding of faV3ConfigToBinary into the
+   configuration.  Returns the number of boards, or -1 if it is not
+   valid. */
+int32_t
+faV3ConfigFromBinary(const void *buf, int32_t length)
+{
+  const uint32_t *w = (const uint32_t *) buf;
+  uint32_t nboards, iboard, i, j, slot;
+  uint16_t u16;
+  char *p;
+
+  if((buf == NULL) || (length < (int32_t) (4 * sizeof(uint32_t))) ||
+     (w[0] != FAV3_CONF_MAGIC) || (w[1] != FAV3_CONF_VERSION) ||
+     (w[3] != faV3ConfBoardWords()))
+    {
+      printf("%s: ERROR: Not a version %d configuration\n",
+	     __func__, FAV3_CONF_VERSION);
+      return(-1);
+    }
 
-      sprintf(sss,"FAV3_ALLCH_DAC");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
-	{
-	  sprintf(sss," %d",faV3[slot].dac[ichan]);
-	  ADD_TO_STRING;
-	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
+  nboards = w[2];
+  if(nboards > NBOARD)
+    {
+      printf("%s: ERROR: Invalid number of boards %d\n", __func__, nboards);
+      return(-1);
+    }
+  if(length < (int32_t) ((4 + nboards * w[3]) * sizeof(uint32_t)))
+    {
+      printf("%s: ERROR: %d boards need %d bytes, only %d given\n",
+	     __func__, nboards, (int) ((4 + nboards * w[3]) * sizeof(uint32_t)),
+	     length);
+      return(-1);
+    }
 
-      sprintf(sss,"FAV3_ALLCH_GAIN");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
+  w += 4;
+  for(iboard = 0; iboard < nboards; iboard++)
+    {
+      slot = *w++;
+      if(slot > NBOARD)
 	{
-	  sprintf(sss," %.1f",faV3[slot].gain[ichan]);
-	  ADD_TO_STRING;
+	  printf("%s: ERROR: Invalid slot %d\n", __func__, slot);
+	  return(-1);
 	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
 
-      sprintf(sss,"FAV3_ALLCH_DELAY");
-      ADD_TO_STRING;
-      for(ichan = 0; ichan < MAX_FAV3_CH; ichan++)
+      for(i = 0; i < NCONFWORDS; i++)
 	{
-	  sprintf(sss," %d",faV3[slot].delay[ichan]);
-	  ADD_TO_STRING;
+	  p = (char *) &faV3[slot] + faV3ConfWords[i].offset;
+	  for(j = 0; j < faV3ConfWords[i].count; j++, p += faV3ConfWords[i].size)
+	    {
+	      if(faV3ConfWords[i].size == sizeof(uint16_t))
+		{
+		  u16 = *w++;
+		  memcpy(p, &u16, sizeof(u16));
+		}
+	      else
+		memcpy(p, w++, sizeof(uint32_t));
+	    }
 	}
-      sprintf(sss,"\n");
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_DATA_FORMAT %d\n", faV3[slot].data_format);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_SUPPRESS_TRIG_TIME %d\n", faV3[slot].suppress_trig_time);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_INSERT_ADC_PARAMS %d\n", faV3[slot].insert_adc_params);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_COMPRESSION %d\n", faV3[slot].compression);
-      ADD_TO_STRING;
-
-      sprintf(sss,"FAV3_VXSREADOUT %d\n", faV3[slot].vxsReadout);
-      ADD_TO_STRING;
-
-
     }
 
-  sprintf(sss,"FAV3_CRATE end\n");
-  ADD_TO_STRING;
-
-  CLOSE_STRING;
-
-  return 0;
+  return(nboards);
 }
 
-/* upload setting from all found FADCs */
+/* upload setting from all found FADCs.  Returns -1 if string was too
+   short; faV3ConfigToString(NULL, 0) + 1 is the length needed. */
 int
 faV3UploadAll(char *string, int length)
 {
 
   faV3GetModulesConfig();
 
-  faV3ConfigToString(string,length);
+  if(faV3ConfigToString(string,length) >= length)
+    return -1;
 
   return 0;
 }
@@ -717,9 +1570,22 @@ faV3UploadAll(char *string, int length)
 int
 faV3UploadAllPrint()
 {
-  char str[16001];
-  faV3UploadAll(str, 16000);
+  char *str;
+  int length;
+
+  faV3GetModulesConfig();
+
+  length = faV3ConfigToString(NULL, 0) + 1;
+  str = (char *) malloc(length);
+  if(str == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate %d bytes\n", __func__, length);
+      return -1;
+    }
+
+  faV3ConfigToString(str, length);
   printf("%s",str);
+  free(str);
 
   return 0;
 }
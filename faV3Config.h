@@ -10,6 +10,29 @@
 
 #define MAX_FAV3_CH 16
 
+/* Threads used by faV3DownloadAll (faV3SetDownloadThreads).  The
+   download of a board is almost all single VME cycles, and the bus does
+   one at a time, so more threads do not make it faster on a crate
+   controller: the default is 1.  They help when a board's download waits
+   without using the bus (a slow bridge, or setters that sleep), since the
+   other boards go on meanwhile.
+   A download is not undone when a call fails: the DAC values cannot be
+   read back, and some registers start actions when written.  The
+   summary lists the boards that failed (faV3DownloadStatus), to be
+   downloaded again. */
+#define FAV3_DOWNLOAD_THREADS 1
+
+/* faV3DownloadChanged flags */
+#define FAV3_DOWNLOAD_DRYRUN   (1 << 0)	/* list the changes, do not write */
+#define FAV3_DOWNLOAD_READBACK (1 << 1)	/* compare with the boards, not the last download */
+
+/* Binary encoding of faV3ConfigToBinary.  All words are 32 bit, host order.
+     magic (FAV3_CONF_MAGIC), version, number of boards, words per board
+     for each board: slot, then the FAV3_CONF settings from proc_version
+       to vxsReadout in order, one word per value (floats as their bits) */
+#define FAV3_CONF_MAGIC   0x66614366	/* "faCf" */
+#define FAV3_CONF_VERSION 1
+
 /** FADC250 configuration parameters **/
 typedef struct {
   uint32_t proc_version;
@@ -71,8 +94,13 @@ int faV3Config(char *fname);
 void faV3InitGlobals();
 int faV3ReadConfigFile(char *filename);
 int faV3DownloadAll();
+int faV3DownloadChanged(int flags);
+int faV3SetDownloadThreads(int nthreads);
+int faV3DownloadStatus(int slot);
 int32_t faV3GetModulesConfig();
 int32_t faV3ConfigToString(char *string, int32_t length);
+int32_t faV3ConfigToBinary(void *buf, int32_t length);
+int32_t faV3ConfigFromBinary(const void *buf, int32_t length);
 int faV3UploadAll(char *string, int length);
 int faV3UploadAllPrint();
 
@@ -0,0 +1,504 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3DataGen.c
+ *
+ * @brief     Synthetic fADC250 V3 data stream generator.
+ *
+ *            Produces the blocks that a board would send for a given
+ *            configuration and a fixed signal on each channel: block
+ *            header (and ADC parameter word), event headers, trigger time,
+ *            raw windows and/or pulse parameters, scaler data, block
+ *            trailer and filler words.
+ *
+ *            The words of a whole block are built once into a template.
+ *            Generating a block copies the template and patches the few
+ *            words that change from block to block (block number, event
+ *            headers, trigger times, trailer), so the rate is close to
+ *            that of memcpy.
+ *
+ *            Pulse parameters come from a simple model of the synthesized
+ *            waveform (integral over NSB/NSA around the pulse start, peak,
+ *            half-height time), not from the firmware algorithm.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "faV3DataGen.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+#define GEN_DEF(_type)  (FAV3_DATA_TYPE_DEFINE | (_type))
+#define GEN_SLOT(_gen)  (((_gen)->cfg.slot << 22) & FAV3_DATA_SLOT_MASK)
+
+#define FAV3_GEN_MAX_ADC    0xFFF	/* 12 bit ADC */
+
+/* Data types without a FAV3_DATA_* define */
+#define FAV3_GEN_PULSE_PARAM  0x48000000	/* type 9 */
+#define FAV3_GEN_SCALER       0x60000000	/* type 12 */
+
+/**
+ * @brief Fill a configuration with the library defaults: mode 1,
+ *        FAV3_ADC_DEFAULT_* window settings, all channels, 1 event per
+ *        block, ADC parameter word on, fillers to a multiple of 2 words.
+ */
+void
+faV3GenDefaults(faV3GenConfig_t * cfg)
+{
+  memset(cfg, 0, sizeof(faV3GenConfig_t));
+
+  cfg->slot = 3;
+  cfg->modID = 1;
+  cfg->mode = 1;
+  cfg->PL = FAV3_ADC_DEFAULT_PL;
+  cfg->PTW = FAV3_ADC_DEFAULT_PTW;
+  cfg->NSB = FAV3_ADC_DEFAULT_NSB;
+  cfg->NSA = FAV3_ADC_DEFAULT_NSA;
+  cfg->NP = FAV3_ADC_DEFAULT_NP;
+  cfg->NPED = FAV3_ADC_DEFAULT_NPED;
+  cfg->insert_params = 1;
+  cfg->block_level = 1;
+  cfg->fill_words = 2;
+  cfg->chan_mask = 0xFFFF;
+  cfg->trig_period = 1000;
+}
+
+/**
+ * @brief Initialize a generator.  All channels start at pedestal 100 with
+ *        no pulses.
+ * @param gen Generator
+ * @param cfg Configuration (copied)
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3GenInit(faV3Gen_t * gen, const faV3GenConfig_t * cfg)
+{
+  int32_t ichan;
+
+  if((gen == NULL) || (cfg == NULL))
+    return ERROR;
+
+  if((cfg->mode != 1) && (cfg->mode != 9) && (cfg->mode != 10))
+    {
+      printf("%s: ERROR: Invalid mode (%d)\n", __func__, cfg->mode);
+      return ERROR;
+    }
+
+  if((cfg->slot > 31) || (cfg->PTW == 0) || (cfg->PTW > FAV3_ADC_MAX_PTW) ||
+     (cfg->NSB > FAV3_ADC_MAX_NSB) || (cfg->NSA > FAV3_ADC_MAX_NSA) ||
+     (cfg->NP == 0) || (cfg->NP > FAV3_ADC_MAX_NP) ||
+     (cfg->NPED > FAV3_ADC_MAX_NPED) || (cfg->format > 2) ||
+     (cfg->suppress_tt > 2) || (cfg->scaler_interval > FAV3_SCALER_INSERT_MASK)
+     || (cfg->block_level == 0) ||
+     (cfg->block_level > FAV3_GEN_MAX_BLOCKLEVEL))
+    {
+      printf("%s: ERROR: Invalid configuration\n", __func__);
+      return ERROR;
+    }
+
+  memset(gen, 0, sizeof(faV3Gen_t));
+  gen->cfg = *cfg;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    gen->chan[ichan].pedestal = 100;
+  gen->dirty = 1;
+
+  return OK;
+}
+
+/**
+ * @brief Free the block template of a generator
+ */
+void
+faV3GenFree(faV3Gen_t * gen)
+{
+  if(gen == NULL)
+    return;
+
+  free(gen->tmpl);
+  gen->tmpl = NULL;
+  gen->tmpl_max = 0;
+  gen->dirty = 1;
+}
+
+/**
+ * @brief Set the signal of a channel
+ * @param gen Generator
+ * @param chan Channel (0-15)
+ * @param ch Signal (copied; waveform is referenced, not copied)
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3GenSetChannel(faV3Gen_t * gen, int32_t chan, const faV3GenChannel_t * ch)
+{
+  if((gen == NULL) || (ch == NULL) || (chan < 0) ||
+     (chan >= FAV3_MAX_ADC_CHANNELS) || (ch->npulse < 0) ||
+     (ch->npulse > FAV3_ADC_MAX_NP))
+    return ERROR;
+
+  gen->chan[chan] = *ch;
+  gen->dirty = 1;
+
+  return OK;
+}
+
+/* Sample i of the window of a channel */
+static uint32_t
+faV3GenSample(const faV3GenChannel_t * ch, uint32_t i)
+{
+  const faV3GenPulse_t *p;
+  uint32_t v, ip;
+  int32_t dt;
+
+  if(ch->waveform && (i < (uint32_t) ch->nsamples))
+    v = ch->waveform[i];
+  else
+    v = ch->pedestal;
+
+  if(ch->waveform)
+    return (v > FAV3_GEN_MAX_ADC) ? FAV3_GEN_MAX_ADC : v;
+
+  for(ip = 0; ip < (uint32_t) ch->npulse; ip++)
+    {
+      p = &ch->pulse[ip];
+      dt = (int32_t) i - (int32_t) p->time;
+      if((dt < 0) || (dt >= (int32_t) (p->rise + p->fall)))
+	continue;
+
+      if(dt < (int32_t) p->rise)
+	v += (p->amplitude * dt) / p->rise;
+      else
+	v += (p->amplitude * (p->rise + p->fall - dt)) / (p->fall ? p->fall : 1);
+    }
+
+  return (v > FAV3_GEN_MAX_ADC) ? FAV3_GEN_MAX_ADC : v;
+}
+
+/* Raw window words of a channel.  Returns the number of words. */
+static int32_t
+faV3GenWindow(faV3Gen_t * gen, int32_t chan, uint32_t * out)
+{
+  const faV3GenChannel_t *ch = &gen->chan[chan];
+  uint32_t width = gen->cfg.PTW, i, s1, s2;
+  int32_t n = 0;
+
+  out[n++] = GEN_DEF(FAV3_DATA_WINDOW_RAW) | (chan << 23) | width;
+
+  for(i = 0; i < width; i += 2)
+    {
+      s1 = faV3GenSample(ch, i);
+      /* Padding sample of an odd width is flagged not valid */
+      s2 = (i + 1 < width) ? faV3GenSample(ch, i + 1) : 0x2000;
+      out[n++] = (s1 << 16) | s2;
+    }
+
+  return n;
+}
+
+/* Pulse parameter words of a channel, without the event number in the
+   block.  Returns the number of words (0 if no pulses). */
+static int32_t
+faV3GenPulseParam(faV3Gen_t * gen, int32_t chan, uint32_t * out)
+{
+  const faV3GenChannel_t *ch = &gen->chan[chan];
+  const faV3GenPulse_t *p;
+  uint32_t ip, i, v, sum, over, nover, peak, t64, ped;
+  int32_t first, last, n = 0;
+
+  if(ch->npulse == 0)
+    return 0;
+
+  ped = ch->pedestal * (gen->cfg.NPED ? gen->cfg.NPED : 1);
+  if(ped > 0x3FFF)
+    ped = 0x3FFF;
+
+  out[n++] = GEN_DEF(FAV3_GEN_PULSE_PARAM) | (chan << 15) | ped;
+
+  for(ip = 0; (ip < (uint32_t) ch->npulse) && (ip < gen->cfg.NP); ip++)
+    {
+      p = &ch->pulse[ip];
+
+      first = (int32_t) p->time - (int32_t) gen->cfg.NSB;
+      if(first < 0)
+	first = 0;
+      last = (int32_t) p->time + (int32_t) gen->cfg.NSA;
+      if(last > (int32_t) gen->cfg.PTW)
+	last = gen->cfg.PTW;
+
+      sum = over = nover = peak = 0;
+      for(i = first; (int32_t) i < last; i++)
+	{
+	  v = faV3GenSample(ch, i);
+	  sum += v;
+	  if(v >= FAV3_GEN_MAX_ADC)
+	    {
+	      over = 1;
+	      nover++;
+	    }
+	  if(v > peak)
+	    peak = v;
+	}
+      if(sum > 0x3FFFF)
+	sum = 0x3FFFF;
+      if(nover > 0x1FF)
+	nover = 0x1FF;
+
+      /* Half height on the rising edge, in 1/64 samples */
+      t64 = (p->time << 6) + (p->rise << 5);
+
+      out[n++] = (1 << 30) | (sum << 12) | (over << 10) | nover;
+      out[n++] = (((t64 >> 6) & 0x1FF) << 21) | ((t64 & 0x3F) << 15) |
+	((peak & 0xFFF) << 3);
+    }
+
+  return n;
+}
+
+/* Words of one event, after the event header and trigger time */
+static int32_t
+faV3GenPayload(faV3Gen_t * gen, uint32_t evt_of_blk, uint32_t * out)
+{
+  int32_t chan, n = 0, np;
+
+  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+    {
+      if(!(gen->cfg.chan_mask & (1 << chan)))
+	continue;
+
+      if((gen->cfg.mode == 1) || (gen->cfg.mode == 10))
+	n += faV3GenWindow(gen, chan, &out[n]);
+
+      if((gen->cfg.mode == 9) || (gen->cfg.mode == 10))
+	{
+	  np = faV3GenPulseParam(gen, chan, &out[n]);
+	  if(np)
+	    out[n] |= (evt_of_blk & 0xFF) << 19;
+	  n += np;
+	}
+    }
+
+  return n;
+}
+
+/* Words of one event payload, at most */
+static int32_t
+faV3GenPayloadMax(faV3Gen_t * gen)
+{
+  return FAV3_MAX_ADC_CHANNELS * (1 + ((gen->cfg.PTW + 1) >> 1) +
+				  1 + 2 * FAV3_ADC_MAX_NP);
+}
+
+/* Build the block template */
+static int32_t
+faV3GenPrepare(faV3Gen_t * gen)
+{
+  faV3GenConfig_t *cfg = &gen->cfg;
+  int32_t ievt, n = 0, np, max, chan, hdr, ntt;
+  uint32_t *t;
+
+  max = 2 + cfg->block_level * (3 + faV3GenPayloadMax(gen));
+  if(max > gen->tmpl_max)
+    {
+      t = (uint32_t *) realloc(gen->tmpl, max * sizeof(uint32_t));
+      if(t == NULL)
+	{
+	  printf("%s: ERROR: Unable to allocate %d words\n", __func__, max);
+	  return ERROR;
+	}
+      gen->tmpl = t;
+      gen->tmpl_max = max;
+    }
+  t = gen->tmpl;
+
+  /* Block number and event count are patched in faV3GenBlock */
+  t[n++] = GEN_DEF(FAV3_DATA_BLOCK_HEADER) | GEN_SLOT(gen) |
+    ((cfg->modID & 0xF) << 18) | cfg->block_level;
+  if(cfg->insert_params)
+    t[n++] = ((cfg->PL & 0x7FF) << 18) | ((cfg->NSB & 0x1FF) << 9) |
+      (cfg->NSA & 0x1FF);
+
+  for(ievt = 0; ievt < (int32_t) cfg->block_level; ievt++)
+    {
+      /* Payload first, 3 words ahead, to know if the event has data */
+      np = faV3GenPayload(gen, ievt + 1, &t[n + 3]);
+
+      /* Format 1: no event header for an event without data.
+         Format 2: event header for the first event of the block only. */
+      hdr = (cfg->format == 0) || ((cfg->format == 1) && np) ||
+	((cfg->format == 2) && (ievt == 0));
+      ntt = (cfg->suppress_tt == 0) ? 2 : ((cfg->suppress_tt == 2) ? 1 : 0);
+
+      gen->evt_hdr[ievt] = hdr ? n : -1;
+      gen->evt_tt[ievt] = ntt ? n + hdr : -1;
+      if(hdr + ntt != 3)
+	memmove(&t[n + hdr + ntt], &t[n + 3], np * sizeof(uint32_t));
+      n += hdr + ntt + np;
+    }
+
+  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+    gen->pulses_per_evt[chan] = (cfg->chan_mask & (1 << chan)) ?
+      gen->chan[chan].npulse : 0;
+
+  gen->tmpl_words = n;
+  gen->dirty = 0;
+
+  return OK;
+}
+
+/* Scaler data goes after the last event of every scaler_interval'th block */
+static int32_t
+faV3GenScalerDue(faV3Gen_t * gen)
+{
+  return gen->cfg.scaler_interval &&
+    (((gen->blk_num + 1) % gen->cfg.scaler_interval) == 0);
+}
+
+/**
+ * @brief Number of words in the next block of a generator
+ * @return Number of words, otherwise ERROR
+ */
+int32_t
+faV3GenBlockWords(faV3Gen_t * gen)
+{
+  int32_t n, fill;
+
+  if(gen == NULL)
+    return ERROR;
+
+  if(gen->dirty && (faV3GenPrepare(gen) != OK))
+    return ERROR;
+
+  n = gen->tmpl_words + 1;
+  if(faV3GenScalerDue(gen))
+    n += 1 + FAV3_GEN_NSCALERS;
+
+  fill = gen->cfg.fill_words;
+  if((fill > 1) && (n % fill))
+    n += fill - (n % fill);
+
+  return n;
+}
+
+/**
+ * @brief Generate the next block
+ * @param gen Generator
+ * @param buf Output
+ * @param maxwords Capacity of buf, in words
+ * @return Number of words written, otherwise ERROR (nothing is written if
+ *         the block does not fit)
+ */
+int32_t
+faV3GenBlock(faV3Gen_t * gen, uint32_t * buf, int32_t maxwords)
+{
+  faV3GenConfig_t *cfg;
+  int32_t nwords, n, ievt, chan, off;
+
+  nwords = faV3GenBlockWords(gen);
+  if(nwords < 0)
+    return ERROR;
+
+  if((buf == NULL) || (nwords > maxwords))
+    {
+      printf("%s: ERROR: Block (%d words) does not fit in buffer (%d words)\n",
+	     __func__, nwords, maxwords);
+      return ERROR;
+    }
+
+  cfg = &gen->cfg;
+  n = gen->tmpl_words;
+  memcpy(buf, gen->tmpl, n * sizeof(uint32_t));
+
+  gen->blk_num++;
+  buf[0] |= (gen->blk_num & 0x3FF) << 8;
+
+  for(ievt = 0; ievt < (int32_t) cfg->block_level; ievt++)
+    {
+      gen->evt_num++;
+      gen->time += cfg->trig_period;
+
+      off = gen->evt_hdr[ievt];
+      if(off >= 0)
+	buf[off] = GEN_DEF(FAV3_DATA_EVENT_HEADER) |
+	  ((uint32_t) (gen->time & 0x3FF) << 12) | (gen->evt_num & 0xFFF);
+
+      off = gen->evt_tt[ievt];
+      if(off >= 0)
+	{
+	  buf[off] = GEN_DEF(FAV3_DATA_TRIGGER_TIME) |
+	    (uint32_t) (gen->time & 0xFFFFFF);
+	  if(cfg->suppress_tt == 0)
+	    buf[off + 1] = (uint32_t) ((gen->time >> 24) & 0xFFFFFF);
+	}
+    }
+
+  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+    gen->scalers[chan] += gen->pulses_per_evt[chan] * cfg->block_level;
+  gen->scalers[FAV3_MAX_ADC_CHANNELS] = (uint32_t) gen->time;
+
+  if(cfg->scaler_interval && ((gen->blk_num % cfg->scaler_interval) == 0))
+    {
+      buf[n++] = GEN_DEF(FAV3_GEN_SCALER) | FAV3_GEN_NSCALERS;
+      memcpy(&buf[n], gen->scalers, sizeof(gen->scalers));
+      n += FAV3_GEN_NSCALERS;
+    }
+
+  /* Word count includes the block header and trailer */
+  buf[n] = GEN_DEF(FAV3_DATA_BLOCK_TRAILER) | GEN_SLOT(gen) | (n + 1);
+  n++;
+
+  while(n < nwords)
+    buf[n++] = GEN_DEF(FAV3_DATA_FILLER) | GEN_SLOT(gen);
+
+  if(cfg->flags & FAV3_GEN_FLAG_SWAP)
+    for(n = 0; n < nwords; n++)
+      buf[n] = __builtin_bswap32(buf[n]);
+
+  return nwords;
+}
+
+/**
+ * @brief Generate the next block of each of several generators, one after
+ *        the other, as in a multiblock (token passing) readout.
+ * @param gen Array of generators, in readout (slot) order
+ * @param ngen Number of generators
+ * @param buf Output
+ * @param maxwords Capacity of buf, in words
+ * @return Number of words written, otherwise ERROR (nothing is written if
+ *         the blocks do not fit)
+ */
+int32_t
+faV3GenCrate(faV3Gen_t * gen, int32_t ngen, uint32_t * buf, int32_t maxwords)
+{
+  int32_t igen, n, nwords = 0;
+
+  if((gen == NULL) || (ngen <= 0))
+    return ERROR;
+
+  for(igen = 0; igen < ngen; igen++)
+    {
+      n = faV3GenBlockWords(&gen[igen]);
+      if(n < 0)
+	return ERROR;
+      nwords += n;
+    }
+
+  if((buf == NULL) || (nwords > maxwords))
+    {
+      printf("%s: ERROR: Blocks (%d words) do not fit in buffer (%d words)\n",
+	     __func__, nwords, maxwords);
+      return ERROR;
+    }
+
+  for(igen = 0, n = 0; igen < ngen; igen++)
+    n += faV3GenBlock(&gen[igen], &buf[n], maxwords - n);
+
+  return n;
+}
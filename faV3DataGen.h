@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3DataGen.h
+ *
+ * @brief     Header for the synthetic fADC250 V3 data stream generator
+ *
+ *            The generator does no I/O and does not depend on jvme.
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Lib.h"
+
+/* Generator flags */
+#define FAV3_GEN_FLAG_SWAP        (1 << 0)	/* write big-endian words */
+
+#define FAV3_GEN_MAX_BLOCKLEVEL   255	/* block header event count is 8 bits */
+#define FAV3_GEN_NSCALERS         (FAV3_MAX_ADC_CHANNELS + 1)	/* + timer */
+
+/* Settings that change the data layout.  The comments name the library
+   routine that makes the same setting on a board. */
+typedef struct faV3GenConfig_struct
+{
+  uint32_t slot;		/* 0-31 */
+  uint32_t modID;		/* module ID in the block header */
+  uint32_t mode;		/* 1, 9 or 10 (faV3SetProcMode) */
+  uint32_t PL, PTW, NSB, NSA, NP, NPED;	/* faV3SetProcMode */
+  uint32_t format;		/* 0, 1 or 2 (faV3SetDataFormat) */
+  uint32_t suppress_tt;		/* 0, 1 or 2 (faV3DataSuppressTriggerTime) */
+  uint32_t insert_params;	/* faV3DataInsertAdcParameters */
+  uint32_t scaler_interval;	/* in blocks (faV3SetScalerBlockInterval) */
+  uint32_t block_level;		/* events per block (faV3SetBlockLevel) */
+  uint32_t fill_words;		/* pad blocks to a multiple of this many
+				   words with filler words (0 or 1 = none) */
+  uint16_t chan_mask;		/* enabled channels (faV3ChanDisable) */
+  uint32_t trig_period;		/* clock ticks between triggers */
+  uint32_t flags;		/* FAV3_GEN_FLAG_* */
+} faV3GenConfig_t;
+
+/* A triangular pulse on top of the pedestal */
+typedef struct faV3GenPulse_struct
+{
+  uint32_t time;		/* first sample of the rise, in the window */
+  uint32_t amplitude;		/* peak height above pedestal */
+  uint32_t rise, fall;		/* samples from start to peak, peak to end */
+} faV3GenPulse_t;
+
+/* Signal of one channel, the same in every event.  If waveform is set it
+   is used for the raw window (padded with the pedestal up to PTW), and
+   the pulses are only used for the pulse parameters. */
+typedef struct faV3GenChannel_struct
+{
+  uint16_t pedestal;
+  const uint16_t *waveform;
+  int32_t nsamples;
+  int32_t npulse;
+  faV3GenPulse_t pulse[FAV3_ADC_MAX_NP];
+} faV3GenChannel_t;
+
+typedef struct faV3Gen_struct
+{
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t chan[FAV3_MAX_ADC_CHANNELS];
+
+  /* Stream state */
+  uint32_t blk_num;		/* blocks generated */
+  uint32_t evt_num;		/* events generated */
+  uint64_t time;		/* trigger time of the last event */
+  uint32_t scalers[FAV3_GEN_NSCALERS];
+
+  /* Block template, rebuilt when the configuration changes */
+  int32_t dirty;
+  uint32_t *tmpl;
+  int32_t tmpl_words, tmpl_max;
+  int32_t pulses_per_evt[FAV3_MAX_ADC_CHANNELS];
+  int32_t evt_hdr[FAV3_GEN_MAX_BLOCKLEVEL];	/* template offsets, or -1 */
+  int32_t evt_tt[FAV3_GEN_MAX_BLOCKLEVEL];	/* template offsets, or -1 */
+} faV3Gen_t;
+
+void faV3GenDefaults(faV3GenConfig_t * cfg);
+int32_t faV3GenInit(faV3Gen_t * gen, const faV3GenConfig_t * cfg);
+void faV3GenFree(faV3Gen_t * gen);
+int32_t faV3GenSetChannel(faV3Gen_t * gen, int32_t chan,
+			  const faV3GenChannel_t * ch);
+int32_t faV3GenBlockWords(faV3Gen_t * gen);
+int32_t faV3GenBlock(faV3Gen_t * gen, uint32_t * buf, int32_t maxwords);
+int32_t faV3GenCrate(faV3Gen_t * gen, int32_t ngen, uint32_t * buf,
+		     int32_t maxwords);
@@ -0,0 +1,639 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3DecPool.c
+ *
+ * @brief     Multi-threaded decoder of multiblock buffers.
+ *
+ *            A buffer read from a crate with token passing holds one block
+ *            per slot (or several rounds of them).  It is indexed with
+ *            faV3IndexBuild, each block is decoded by a pool of threads,
+ *            and the events of all slots are merged in trigger number
+ *            order on the calling thread.
+ *
+ *            Blocks are handed out largest first from a shared counter, so
+ *            an idle thread always takes the next block and slots with long
+ *            raw windows do not hold up the rest.
+ *
+ *            Each block decodes into its own slice of a shared output
+ *            arena, sized from its word count, so threads never write to
+ *            the same memory and nothing is allocated per call once the
+ *            arena is large enough.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+#include "faV3DecPool.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+/* Extra output room per block, for windows whose width is larger than the
+   words that follow them */
+#define FAV3_DECPOOL_EXTRA_SAMPLES  FAV3_DEC_MAX_SAMPLES
+#define FAV3_DECPOOL_EXTRA_WORDS \
+  (FAV3_DEC_INVALID_WORDS(FAV3_DEC_MAX_SAMPLES) + FAV3_DEC_MAX_SCALERS)
+
+/* The event header trigger number is 12 bits */
+#define FAV3_DECPOOL_EVT_BITS       12
+
+typedef struct
+{
+  int32_t start, nwords;	/* words of the block in the buffer */
+  int32_t rec0, samp0, word0;	/* start of the block's arena slice */
+  int32_t nrec;			/* records decoded */
+  int32_t evt0, maxevt;		/* the block's events in evrec[] */
+  int32_t nevt;			/* events found in the records */
+  int32_t status;		/* ERROR if the slice was too small */
+} faV3DecTask_t;
+
+typedef struct
+{
+  int32_t created;
+  int32_t nthreads;
+  uint32_t flags;
+  pthread_t thread[FAV3_DECPOOL_MAX_THREADS];
+  faV3Decoder_t *dec;		/* one per thread */
+
+  /* Current buffer */
+  const uint32_t *buf;
+  uint32_t generation;
+  int32_t quit;
+  int32_t nbusy;		/* workers not done with this generation */
+  int32_t ntasks;
+  volatile int32_t next;	/* next entry of order[] to decode */
+  faV3DecTask_t *task;		/* one per indexed block */
+  faV3DecTask_t **order;	/* largest first */
+  int32_t maxtasks;
+
+  /* Index and output arena, grown as needed */
+  faV3Index_t idx;
+  faV3DecRecord_t *rec;
+  int32_t maxrec;
+  uint16_t *samples;
+  int32_t maxsamples;
+  uint32_t *words;
+  int32_t maxwords;
+  int32_t *evrec;		/* per event: first and end record */
+  int32_t maxevrec;
+
+  /* Statistics */
+  uint32_t ncall, nblocks, nevents, nindexerr, ndecodeerr, ntruncated;
+  uint32_t ntask[FAV3_DECPOOL_MAX_THREADS];
+} faV3DecPool_t;
+
+static faV3DecPool_t faV3DecPool;
+
+pthread_mutex_t faV3DecPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t faV3DecPoolCallMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t faV3DecPoolStartCond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t faV3DecPoolDoneCond = PTHREAD_COND_INITIALIZER;
+#define POOLLOCK      if(pthread_mutex_lock(&faV3DecPoolMutex)<0) perror("pthread_mutex_lock");
+#define POOLUNLOCK    if(pthread_mutex_unlock(&faV3DecPoolMutex)<0) perror("pthread_mutex_unlock");
+#define CALLLOCK      if(pthread_mutex_lock(&faV3DecPoolCallMutex)<0) perror("pthread_mutex_lock");
+#define CALLUNLOCK    if(pthread_mutex_unlock(&faV3DecPoolCallMutex)<0) perror("pthread_mutex_unlock");
+
+/* Find the records of each event of a block, while they are still in the
+   cache: from its event header up to the next event header or the block
+   trailer */
+static void
+faV3DecPoolEvents(faV3DecTask_t * t, const faV3DecRecord_t * rec)
+{
+  int32_t *evrec = &faV3DecPool.evrec[2 * t->evt0];
+  int32_t irec, nevt = 0, open = 0;
+
+  for(irec = 0; irec < t->nrec; irec++)
+    {
+      if(rec[irec].type == FAV3_DEC_EVENT_HEADER)
+	{
+	  if(open)
+	    evrec[2 * nevt++ + 1] = irec;
+	  open = (nevt < t->maxevt);
+	  if(open)
+	    evrec[2 * nevt] = irec;
+	}
+      else if(rec[irec].type == FAV3_DEC_BLOCK_TRAILER)
+	break;
+    }
+
+  if(open)
+    evrec[2 * nevt++ + 1] = irec;
+
+  t->nevt = nevt;
+}
+
+/* Decode one block into its arena slice */
+static void
+faV3DecPoolRun(faV3Decoder_t * dec, faV3DecTask_t * t)
+{
+  faV3DecOutput_t out;
+  int32_t n;
+
+  out.rec = &faV3DecPool.rec[t->rec0];
+  out.maxrec = t->nwords;
+  out.nrec = 0;
+  out.samples = &faV3DecPool.samples[t->samp0];
+  out.maxsamples = 2 * t->nwords + FAV3_DECPOOL_EXTRA_SAMPLES;
+  out.nsamples = 0;
+  out.words = &faV3DecPool.words[t->word0];
+  out.maxwords = t->nwords + FAV3_DECPOOL_EXTRA_WORDS;
+  out.nwords = 0;
+
+  faV3DecoderReset(dec);
+  faV3DecoderSetOutput(dec, &out);
+
+  n = faV3DecoderFeed(dec, &faV3DecPool.buf[t->start], t->nwords);
+  if(faV3DecoderFlush(dec) != OK)
+    n = ERROR;
+
+  t->nrec = out.nrec;
+  t->status = (n == t->nwords) ? OK : ERROR;
+
+  faV3DecPoolEvents(t, out.rec);
+}
+
+/* Decode blocks until there are none left */
+static void
+faV3DecPoolWork(int32_t ithr)
+{
+  int32_t itask;
+
+  while((itask = __sync_fetch_and_add(&faV3DecPool.next, 1))
+	< faV3DecPool.ntasks)
+    {
+      faV3DecPoolRun(&faV3DecPool.dec[ithr], faV3DecPool.order[itask]);
+      faV3DecPool.ntask[ithr]++;
+    }
+}
+
+static void *
+faV3DecPoolThread(void *arg)
+{
+  int32_t ithr = (int32_t) (long) arg;
+  uint32_t generation = 0;	/* faV3DecPoolCreate starts from 0 */
+
+  POOLLOCK;
+  while(1)
+    {
+      while(!faV3DecPool.quit && (faV3DecPool.generation == generation))
+	pthread_cond_wait(&faV3DecPoolStartCond, &faV3DecPoolMutex);
+
+      if(faV3DecPool.quit)
+	break;
+
+      generation = faV3DecPool.generation;
+      POOLUNLOCK;
+
+      faV3DecPoolWork(ithr);
+
+      POOLLOCK;
+      if(--faV3DecPool.nbusy == 0)
+	pthread_cond_signal(&faV3DecPoolDoneCond);
+    }
+  POOLUNLOCK;
+
+  return NULL;
+}
+
+static int
+faV3DecPoolCompare(const void *a, const void *b)
+{
+  const faV3DecTask_t *ta = *(faV3DecTask_t * const *) a;
+  const faV3DecTask_t *tb = *(faV3DecTask_t * const *) b;
+
+  if(ta->nwords != tb->nwords)
+    return (ta->nwords > tb->nwords) ? -1 : 1;
+
+  return (ta->start < tb->start) ? -1 : 1;
+}
+
+/* Grow *ptr to hold at least n items of size bytes */
+static int32_t
+faV3DecPoolGrow(void **ptr, int32_t * max, int32_t n, size_t size)
+{
+  void *p;
+
+  if(n <= *max)
+    return OK;
+
+  /* Leave some room, so slowly growing buffers don't realloc every call */
+  n += n >> 2;
+  p = realloc(*ptr, (size_t) n * size);
+  if(p == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate %d items of %d bytes\n",
+	     __func__, n, (int) size);
+      return ERROR;
+    }
+
+  *ptr = p;
+  *max = n;
+
+  return OK;
+}
+
+/* Make room for the index and output of a buffer of nwords words */
+static int32_t
+faV3DecPoolReserve(int32_t nwords)
+{
+  int32_t maxblocks = (nwords >> 1) + 1;
+  int32_t maxtasks = faV3DecPool.maxtasks;
+
+  if((faV3DecPoolGrow((void **) &faV3DecPool.idx.blocks,
+		      &faV3DecPool.idx.maxblocks, maxblocks,
+		      sizeof(faV3IndexBlock_t)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.idx.events,
+		      &faV3DecPool.idx.maxevents, nwords + 1,
+		      sizeof(uint32_t)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.task, &faV3DecPool.maxtasks,
+		      maxblocks, sizeof(faV3DecTask_t)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.order, &maxtasks,
+		      maxblocks, sizeof(faV3DecTask_t *)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.rec, &faV3DecPool.maxrec,
+		      nwords + 1, sizeof(faV3DecRecord_t)) != OK))
+    return ERROR;
+
+  return OK;
+}
+
+/* Lay out the blocks of the index as tasks, and size the arena slices */
+static int32_t
+faV3DecPoolPlan(int32_t nwords)
+{
+  faV3Index_t *idx = &faV3DecPool.idx;
+  faV3DecTask_t *t;
+  int32_t iblk, nrec = 0, nsamples = 0, nw = 0;
+
+  for(iblk = 0; iblk < idx->nblocks; iblk++)
+    {
+      t = &faV3DecPool.task[iblk];
+      t->start = idx->blocks[iblk].header;
+      t->nwords = ((iblk + 1 < idx->nblocks) ?
+		   (int32_t) idx->blocks[iblk + 1].header : nwords) - t->start;
+      t->rec0 = nrec;
+      t->samp0 = nsamples;
+      t->word0 = nw;
+      t->evt0 = idx->blocks[iblk].first_event;
+      t->maxevt = idx->blocks[iblk].nevents;
+      t->nrec = 0;
+      t->nevt = 0;
+      t->status = OK;
+      faV3DecPool.order[iblk] = t;
+
+      nrec += t->nwords;
+      nsamples += 2 * t->nwords + FAV3_DECPOOL_EXTRA_SAMPLES;
+      nw += t->nwords + FAV3_DECPOOL_EXTRA_WORDS;
+    }
+
+  if((faV3DecPoolGrow((void **) &faV3DecPool.samples,
+		      &faV3DecPool.maxsamples, nsamples,
+		      sizeof(uint16_t)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.evrec, &faV3DecPool.maxevrec,
+		      2 * idx->nevents, sizeof(int32_t)) != OK) ||
+     (faV3DecPoolGrow((void **) &faV3DecPool.words, &faV3DecPool.maxwords,
+		      nw, sizeof(uint32_t)) != OK))
+    return ERROR;
+
+  qsort(faV3DecPool.order, idx->nblocks, sizeof(faV3DecTask_t *),
+	faV3DecPoolCompare);
+  faV3DecPool.ntasks = idx->nblocks;
+
+  return OK;
+}
+
+/* Position of a slot in the merge: the next event of its block chain */
+typedef struct
+{
+  int32_t block;		/* -1 when the slot has no more events */
+  int32_t ievt;			/* event in the block */
+  uint32_t evt_num;
+} faV3DecCursor_t;
+
+/* Move the cursor to the next block with an event at or after its
+   position */
+static void
+faV3DecPoolSeek(faV3DecCursor_t * c)
+{
+  faV3DecTask_t *t;
+  int32_t irec;
+
+  while(c->block >= 0)
+    {
+      t = &faV3DecPool.task[c->block];
+      if(c->ievt < t->nevt)
+	{
+	  irec = faV3DecPool.evrec[2 * (t->evt0 + c->ievt)];
+	  c->evt_num = faV3DecPool.rec[t->rec0 + irec].u.eh.evt_num;
+	  return;
+	}
+
+      c->block = faV3DecPool.idx.blocks[c->block].next;
+      c->ievt = 0;
+    }
+}
+
+/* Signed distance from trigger number b to a, allowing for rollover */
+static inline int32_t
+faV3DecPoolEvtDiff(uint32_t a, uint32_t b)
+{
+  return ((int32_t) ((a - b) << (32 - FAV3_DECPOOL_EVT_BITS)))
+    >> (32 - FAV3_DECPOOL_EVT_BITS);
+}
+
+/* Merge the decoded blocks into events, in trigger number order */
+static int32_t
+faV3DecPoolMerge(faV3DecEventCallback_t cb, void *arg)
+{
+  faV3DecCursor_t cur[32];
+  faV3DecEvent_t evt;
+  faV3DecEventSlot_t *es;
+  faV3DecTask_t *t;
+  int32_t *evrec;
+  uint32_t active = 0, evt_num;
+  int32_t slot, nevents = 0;
+
+  for(slot = 0; slot < 32; slot++)
+    {
+      cur[slot].block = faV3DecPool.idx.slot_first[slot];
+      cur[slot].ievt = 0;
+      faV3DecPoolSeek(&cur[slot]);
+      if(cur[slot].block >= 0)
+	active |= (1u << slot);
+    }
+
+  while(active)
+    {
+      /* Earliest trigger number among the slots */
+      slot = __builtin_ctz(active);
+      evt_num = cur[slot].evt_num;
+      for(slot++; slot < 32; slot++)
+	if((active & (1u << slot)) &&
+	   (faV3DecPoolEvtDiff(cur[slot].evt_num, evt_num) < 0))
+	  evt_num = cur[slot].evt_num;
+
+      evt.evt_num = evt_num;
+      evt.slotmask = 0;
+      evt.nslots = 0;
+
+      for(slot = 0; slot < 32; slot++)
+	{
+	  if(!(active & (1u << slot)) || (cur[slot].evt_num != evt_num))
+	    continue;
+
+	  t = &faV3DecPool.task[cur[slot].block];
+	  evrec = &faV3DecPool.evrec[2 * (t->evt0 + cur[slot].ievt)];
+
+	  es = &evt.slot[evt.nslots++];
+	  es->slot = slot;
+	  es->rec = &faV3DecPool.rec[t->rec0 + evrec[0]];
+	  es->nrec = evrec[1] - evrec[0];
+	  evt.slotmask |= (1u << slot);
+
+	  cur[slot].ievt++;
+	  faV3DecPoolSeek(&cur[slot]);
+	  if(cur[slot].block < 0)
+	    active &= ~(1u << slot);
+	}
+
+      if(cb)
+	(*cb) (&evt, arg);
+      nevents++;
+    }
+
+  return nevents;
+}
+
+/**
+ * @brief Start the decoder threads
+ * @param nthreads Number of threads that decode, including the one that
+ *                 calls faV3DecPoolDecode (1 - FAV3_DECPOOL_MAX_THREADS)
+ * @param flags FAV3_DEC_FLAG_* for the decoders
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecPoolCreate(int32_t nthreads, uint32_t flags)
+{
+  int32_t ithr;
+
+  if((nthreads <= 0) || (nthreads > FAV3_DECPOOL_MAX_THREADS))
+    {
+      printf("%s: ERROR: Invalid number of threads (%d)\n", __func__,
+	     nthreads);
+      return ERROR;
+    }
+
+  CALLLOCK;
+  POOLLOCK;
+  if(faV3DecPool.created)
+    {
+      printf("%s: ERROR: Pool already created\n", __func__);
+      POOLUNLOCK;
+      CALLUNLOCK;
+      return ERROR;
+    }
+
+  memset(&faV3DecPool, 0, sizeof(faV3DecPool));
+
+  faV3DecPool.dec = (faV3Decoder_t *) malloc(nthreads * sizeof(faV3Decoder_t));
+  if(faV3DecPool.dec == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate %d decoders\n", __func__,
+	     nthreads);
+      POOLUNLOCK;
+      CALLUNLOCK;
+      return ERROR;
+    }
+
+  for(ithr = 0; ithr < nthreads; ithr++)
+    faV3DecoderInit(&faV3DecPool.dec[ithr], flags);
+
+  faV3DecPool.nthreads = nthreads;
+  faV3DecPool.flags = flags;
+  faV3DecPool.created = 1;
+  POOLUNLOCK;
+
+  /* The calling thread is decoder 0 */
+  for(ithr = 1; ithr < nthreads; ithr++)
+    {
+      if(pthread_create(&faV3DecPool.thread[ithr], NULL, faV3DecPoolThread,
+			(void *) (long) ithr) != 0)
+	{
+	  perror("pthread_create");
+	  printf("%s: ERROR: Unable to start thread %d.  Using %d thread(s)\n",
+		 __func__, ithr, ithr);
+	  faV3DecPool.nthreads = ithr;
+	  break;
+	}
+    }
+  CALLUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Stop the decoder threads and free the pool
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecPoolDestroy()
+{
+  int32_t ithr;
+
+  CALLLOCK;
+  POOLLOCK;
+  if(!faV3DecPool.created)
+    {
+      POOLUNLOCK;
+      CALLUNLOCK;
+      return OK;
+    }
+
+  faV3DecPool.quit = 1;
+  pthread_cond_broadcast(&faV3DecPoolStartCond);
+  POOLUNLOCK;
+
+  for(ithr = 1; ithr < faV3DecPool.nthreads; ithr++)
+    pthread_join(faV3DecPool.thread[ithr], NULL);
+
+  POOLLOCK;
+  free(faV3DecPool.dec);
+  free(faV3DecPool.idx.blocks);
+  free(faV3DecPool.idx.events);
+  free(faV3DecPool.task);
+  free(faV3DecPool.order);
+  free(faV3DecPool.rec);
+  free(faV3DecPool.samples);
+  free(faV3DecPool.words);
+  free(faV3DecPool.evrec);
+  memset(&faV3DecPool, 0, sizeof(faV3DecPool));
+  POOLUNLOCK;
+  CALLUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Decode a multiblock buffer with the thread pool
+ *
+ *   The buffer is split at block headers and the blocks are decoded in
+ *   parallel.  The events of all slots are then merged by trigger number
+ *   and passed to cb, in trigger number order, from the calling thread.
+ *   Records given to cb are valid only during the call.
+ *
+ *   Event headers are required: records of a block before its first event
+ *   header (the block header) or from its trailer on are not passed to cb.
+ *
+ * @param buf Data (e.g. from a multiblock faV3ReadBlock)
+ * @param nwords Number of words in buf
+ * @param cb Routine called for each event
+ * @param arg Argument passed to cb
+ * @return Number of events, otherwise ERROR
+ */
+int32_t
+faV3DecPoolDecode(const uint32_t * buf, int32_t nwords,
+		  faV3DecEventCallback_t cb, void *arg)
+{
+  faV3Index_t *idx = &faV3DecPool.idx;
+  int32_t itask, nevents;
+
+  if(((buf == NULL) && (nwords > 0)) || (nwords < 0))
+    return ERROR;
+
+  CALLLOCK;
+  if(!faV3DecPool.created)
+    {
+      printf("%s: ERROR: Pool not created\n", __func__);
+      CALLUNLOCK;
+      return ERROR;
+    }
+
+  if(faV3DecPoolReserve(nwords) != OK)
+    {
+      CALLUNLOCK;
+      return ERROR;
+    }
+
+  faV3IndexBuild(idx, buf, nwords, faV3DecPool.flags);
+  if(faV3DecPoolPlan(nwords) != OK)
+    {
+      CALLUNLOCK;
+      return ERROR;
+    }
+
+  /* Start the workers, and decode along with them */
+  POOLLOCK;
+  faV3DecPool.buf = buf;
+  faV3DecPool.next = 0;
+  faV3DecPool.nbusy = faV3DecPool.nthreads - 1;
+  faV3DecPool.generation++;
+  pthread_cond_broadcast(&faV3DecPoolStartCond);
+  POOLUNLOCK;
+
+  faV3DecPoolWork(0);
+
+  POOLLOCK;
+  while(faV3DecPool.nbusy > 0)
+    pthread_cond_wait(&faV3DecPoolDoneCond, &faV3DecPoolMutex);
+  POOLUNLOCK;
+
+  nevents = faV3DecPoolMerge(cb, arg);
+
+  faV3DecPool.ncall++;
+  faV3DecPool.nblocks += idx->nblocks;
+  faV3DecPool.nevents += nevents;
+  faV3DecPool.nindexerr += idx->nerrors;
+  faV3DecPool.ntruncated += idx->truncated;
+  for(itask = 0; itask < faV3DecPool.ntasks; itask++)
+    if(faV3DecPool.task[itask].status != OK)
+      faV3DecPool.ndecodeerr++;
+  CALLUNLOCK;
+
+  return nevents;
+}
+
+/**
+ * @brief Show the state of the decoder pool
+ * @param pflag Print to standard out if non-zero
+ * @return Number of decoder threads, or 0 if the pool is not created
+ */
+int32_t
+faV3DecPoolStatus(int32_t pflag)
+{
+  int32_t ithr, rval;
+
+  CALLLOCK;
+  rval = faV3DecPool.created ? faV3DecPool.nthreads : 0;
+
+  if(pflag)
+    {
+      printf("faV3DecPool: %s\n",
+	     faV3DecPool.created ? "created" : "not created");
+      if(faV3DecPool.created)
+	{
+	  printf("  Threads   %4d\n", faV3DecPool.nthreads);
+	  printf("  Buffers     %10u\n", faV3DecPool.ncall);
+	  printf("  Blocks      %10u  (index errors %u, decode errors %u)\n",
+		 faV3DecPool.nblocks, faV3DecPool.nindexerr,
+		 faV3DecPool.ndecodeerr);
+	  printf("  Events      %10u\n", faV3DecPool.nevents);
+	  printf("  Truncated   %10u\n", faV3DecPool.ntruncated);
+	  printf("  Blocks decoded per thread:\n");
+	  for(ithr = 0; ithr < faV3DecPool.nthreads; ithr++)
+	    printf("    %2d: %10u\n", ithr, faV3DecPool.ntask[ithr]);
+	}
+    }
+  CALLUNLOCK;
+
+  return rval;
+}
@@ -0,0 +1,43 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3DecPool.h
+ *
+ * @brief     Header for the multi-threaded decoder of multiblock buffers
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Decoder.h"
+
+#define FAV3_DECPOOL_MAX_THREADS  64
+
+/* Records of one slot in an event: from the event header up to the next
+   event header or block trailer */
+typedef struct faV3DecEventSlot_struct
+{
+  uint32_t slot;
+  const faV3DecRecord_t *rec;
+  int32_t nrec;
+} faV3DecEventSlot_t;
+
+/* One trigger, merged across slots */
+typedef struct faV3DecEvent_struct
+{
+  uint32_t evt_num;		/* trigger number from the event headers */
+  uint32_t slotmask;		/* slots with data for this trigger */
+  int32_t nslots;
+  faV3DecEventSlot_t slot[32];	/* in slot order */
+} faV3DecEvent_t;
+
+typedef void (*faV3DecEventCallback_t) (const faV3DecEvent_t * evt,
+					void *arg);
+
+int32_t faV3DecPoolCreate(int32_t nthreads, uint32_t flags);
+int32_t faV3DecPoolDestroy();
+int32_t faV3DecPoolDecode(const uint32_t * buf, int32_t nwords,
+			  faV3DecEventCallback_t cb, void *arg);
+int32_t faV3DecPoolStatus(int32_t pflag);
@@ -0,0 +1,1152 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Decoder.c
+ *
+ * @brief     Reentrant, streaming decoder for fADC250 V3 data.
+ *
+ *            Words are fed in buffers of any size (faV3DecoderFeed).
+ *            Records are emitted to a callback and/or stored in output
+ *            arrays.  A multi-word record is emitted when the next type
+ *            defining word arrives, or at faV3DecoderFlush.
+ *
+ *            No I/O is done here and there is no global state.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAV3_DEC_X86
+#endif
+#include "faV3Decoder.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+#define DEC_LOAD(_w, _swap) ((_swap) ? __builtin_bswap32(_w) : (_w))
+
+static const char *faV3DecTypeNames[FAV3_DEC_NTYPES] = {
+  "BLOCK HEADER",
+  "BLOCK TRAILER",
+  "EVENT HEADER",
+  "TRIGGER TIME",
+  "WINDOW RAW",
+  "PULSE PARAM",
+  "SCALER",
+  "FILLER",
+  "OTHER"
+};
+
+/**
+ * @brief Return the name of a decoder record type
+ */
+const char *
+faV3DecoderTypeName(int32_t type)
+{
+  if((type < 0) || (type >= FAV3_DEC_NTYPES))
+    return "UNKNOWN";
+
+  return faV3DecTypeNames[type];
+}
+
+/**
+ * @brief Initialize a decoder context
+ * @param dec Decoder context
+ * @param flags FAV3_DEC_FLAG_* (e.g. FAV3_DEC_FLAG_SWAP for big-endian input)
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecoderInit(faV3Decoder_t * dec, uint32_t flags)
+{
+  if(dec == NULL)
+    return ERROR;
+
+  memset(dec, 0, sizeof(faV3Decoder_t));
+  dec->flags = flags;
+  dec->rec = &dec->cur;
+  dec->evt_idx = (uint32_t) - 1;
+
+  return OK;
+}
+
+/**
+ * @brief Drop any unfinished record and clear the statistics.
+ *        Flags and record sinks are kept.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecoderReset(faV3Decoder_t * dec)
+{
+  if(dec == NULL)
+    return ERROR;
+
+  dec->slot = 0;
+  dec->evt_num = 0;
+  dec->evt_idx = (uint32_t) - 1;
+  dec->inblock = 0;
+  dec->blockstart = 0;
+  dec->pending = 0;
+  dec->remaining = 0;
+  memset(&dec->stats, 0, sizeof(dec->stats));
+
+  return OK;
+}
+
+/**
+ * @brief Set the routine called for each decoded record.
+ *        Window samples and scaler counts are valid only during the call.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecoderSetCallback(faV3Decoder_t * dec, faV3DecCallback_t cb, void *arg)
+{
+  if(dec == NULL)
+    return ERROR;
+
+  dec->callback = cb;
+  dec->arg = arg;
+
+  return OK;
+}
+
+/**
+ * @brief Set output arrays for decoded records.
+ *
+ *   Records are built in place at out->rec[out->nrec], and nrec counts
+ *   them once finished.  faV3DecoderFeed stops, without consuming the
+ *   word, when the next record would not fit.  The caller may then empty
+ *   the arrays (reset nrec, nsamples and nwords) and feed the rest of the
+ *   buffer.  A record left open by the arrays being emptied or changed at
+ *   other times is moved, with its samples, by the next faV3DecoderFeed.
+ *
+ * @param out Output arrays, or NULL to stop storing records
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecoderSetOutput(faV3Decoder_t * dec, faV3DecOutput_t * out)
+{
+  if(dec == NULL)
+    return ERROR;
+
+  dec->out = out;
+
+  return OK;
+}
+
+/* Count the invalid samples of a finished window, and drop the flag of the
+   padding sample of an odd width window */
+static void
+faV3DecWindowDone(faV3DecRecord_t * rec)
+{
+  uint32_t *invalid = rec->u.win.invalid;
+  uint32_t n = rec->u.win.nsamples, iw, ninvalid = 0;
+
+  if(n & 31)
+    invalid[n >> 5] &= (1u << (n & 31)) - 1;
+  for(iw = (n >> 5) + 1; iw < FAV3_DEC_INVALID_WORDS(rec->u.win.width); iw++)
+    invalid[iw] = 0;
+
+  for(iw = 0; iw < ((n + 31) >> 5); iw++)
+    ninvalid += __builtin_popcount(invalid[iw]);
+
+  rec->u.win.ninvalid = ninvalid;
+}
+
+/* Count the record, and hand it on.  In the output arrays it is already
+   in place at out->rec[out->nrec]. */
+static inline void
+faV3DecEmit(faV3Decoder_t * dec, const faV3DecRecord_t * rec)
+{
+  dec->stats.nrec[rec->type]++;
+
+  if(dec->callback)
+    (*dec->callback) (rec, dec->arg);
+
+  if(dec->out)
+    dec->out->nrec++;
+}
+
+/* Finish the open record at rec */
+static inline void
+faV3DecFinish(faV3Decoder_t * dec, faV3DecRecord_t * rec)
+{
+  if(rec->type == FAV3_DEC_WINDOW_RAW)
+    faV3DecWindowDone(rec);
+  faV3DecEmit(dec, rec);
+}
+
+/* Move an unfinished record, and its samples or counts, to where the next
+   record goes, if the output arrays were emptied or changed since it was
+   started */
+static int32_t
+faV3DecMove(faV3Decoder_t * dec)
+{
+  faV3DecOutput_t *out = dec->out;
+  faV3DecRecord_t *rec = dec->rec;
+  faV3DecRecord_t *to = out ? &out->rec[out->nrec] : &dec->cur;
+  int32_t nsamples = 0, nw = 0;
+  uint16_t *samples;
+  uint32_t *words;
+
+  if(!dec->pending || (rec == to))
+    return OK;
+
+  if(rec->type == FAV3_DEC_WINDOW_RAW)
+    {
+      nsamples = (rec->u.win.width + 1) & ~1;
+      nw = FAV3_DEC_INVALID_WORDS(rec->u.win.width);
+    }
+  else if(rec->type == FAV3_DEC_SCALER)
+    nw = rec->word & 0x3F;
+
+  if(out)
+    {
+      if((out->nrec >= out->maxrec) ||
+	 (out->nsamples + nsamples > out->maxsamples) ||
+	 (out->nwords + nw > out->maxwords))
+	return ERROR;
+      samples = &out->samples[out->nsamples];
+      words = &out->words[out->nwords];
+      out->nsamples += nsamples;
+      out->nwords += nw;
+    }
+  else
+    {
+      samples = dec->samples;
+      words = (rec->type == FAV3_DEC_SCALER) ? dec->counts : dec->invalid;
+    }
+
+  *to = *rec;
+  if(rec->type == FAV3_DEC_WINDOW_RAW)
+    {
+      memmove(samples, rec->u.win.samples, nsamples * sizeof(uint16_t));
+      memmove(words, rec->u.win.invalid, nw * sizeof(uint32_t));
+      to->u.win.samples = samples;
+      to->u.win.invalid = words;
+    }
+  else if(rec->type == FAV3_DEC_SCALER)
+    {
+      memmove(words, rec->u.sc.counts, nw * sizeof(uint32_t));
+      to->u.sc.counts = words;
+    }
+  dec->rec = to;
+
+  return OK;
+}
+
+/* Check that the output arrays can take the record started by word w */
+static inline int32_t
+faV3DecHasRoom(faV3Decoder_t * dec, uint32_t dtype, uint32_t w,
+	       int32_t pending)
+{
+  faV3DecOutput_t *out = dec->out;
+
+  if(out->nrec + pending + 1 > out->maxrec)
+    return 0;
+
+  if(dtype == 4)
+    return (((out->nsamples + (int32_t) (((w & 0xFFF) + 1) & ~1)) <= out->maxsamples)
+	    && ((out->nwords + FAV3_DEC_INVALID_WORDS(w & 0xFFF)) <= out->maxwords));
+
+  if(dtype == 12)
+    return ((out->nwords + (int32_t) (w & 0x3F)) <= out->maxwords);
+
+  return 1;
+}
+
+/* Start a pulse parameter record at rec.  Returns the pulse words it
+   may take. */
+__attribute__ ((always_inline))
+static inline int32_t
+faV3DecPulseStart(faV3Decoder_t * dec, faV3DecRecord_t * rec, uint32_t w)
+{
+  rec->word = w;
+  rec->type = FAV3_DEC_PULSE_PARAM;
+  rec->slot = dec->slot;
+  rec->evt_num = dec->evt_num;
+  rec->evt_idx = dec->evt_idx;
+  rec->u.pp.evt_of_blk = (w & 0x07f80000) >> 19;
+  rec->u.pp.chan = (w & 0x00078000) >> 15;
+  rec->u.pp.quality = (w & (1 << 14)) >> 14;
+  rec->u.pp.ped_sum = (w & 0x00003fff);
+  rec->u.pp.npulse = 0;
+
+  return 2 * FAV3_DEC_MAX_PULSES;
+}
+
+/* Start a record from a type defining word, at rec.  Returns the
+   continuation words expected, or -1 for a single word record (already
+   emitted).  Inlined into the feed loop, which keeps the record in
+   registers. */
+__attribute__ ((always_inline))
+static inline int32_t
+faV3DecStart(faV3Decoder_t * dec, faV3DecRecord_t * rec, uint32_t w,
+	     uint64_t pos)
+{
+  faV3DecOutput_t *out = dec->out;
+  uint32_t dtype = (w & FAV3_DATA_TYPE_MASK) >> 27;
+  int32_t remaining = -1;
+
+  rec->word = w;
+
+  switch (dtype)
+    {
+    case 0:			/* BLOCK HEADER */
+      dec->slot = (w & FAV3_DATA_SLOT_MASK) >> 22;
+      dec->evt_idx = (uint32_t) - 1;
+      dec->inblock = 1;
+      dec->blockstart = pos;
+      rec->type = FAV3_DEC_BLOCK_HEADER;
+      rec->u.bh.modID = (w & 0x3C0000) >> 18;
+      rec->u.bh.blk_num = (w & 0x3FF00) >> 8;
+      rec->u.bh.n_evts = (w & 0xFF);
+      rec->u.bh.has_param = 0;
+      rec->u.bh.PL = rec->u.bh.NSB = rec->u.bh.NSA = 0;
+      remaining = 1;
+      break;
+
+    case 1:			/* BLOCK TRAILER */
+      rec->type = FAV3_DEC_BLOCK_TRAILER;
+      rec->u.bt.n_words = w & FAV3_DATA_WRDCNT_MASK;
+      rec->u.bt.counted = dec->inblock ? (uint32_t) (pos - dec->blockstart + 1) : 0;
+      if(rec->u.bt.counted != rec->u.bt.n_words)
+	dec->stats.trailer_mismatch++;
+      if(((w & FAV3_DATA_SLOT_MASK) >> 22) != dec->slot)
+	dec->stats.trailer_slot++;
+      dec->inblock = 0;
+      break;
+
+    case 2:			/* EVENT HEADER */
+      rec->type = FAV3_DEC_EVENT_HEADER;
+      rec->u.eh.time_low_10 = (w & 0x003FF000) >> 12;
+      rec->u.eh.evt_num = (w & 0xFFF);
+      dec->evt_num = rec->u.eh.evt_num;
+      dec->evt_idx++;
+      break;
+
+    case 3:			/* TRIGGER TIME */
+      rec->type = FAV3_DEC_TRIGGER_TIME;
+      rec->u.tt.nwords = 1;
+      rec->u.tt.time_1 = (w & 0x07FFFFFF);
+      rec->u.tt.time_2 = 0;
+      rec->u.tt.time = (w & 0xFFFFFF);
+      remaining = 1;
+      break;
+
+    case 4:			/* WINDOW RAW DATA */
+      rec->type = FAV3_DEC_WINDOW_RAW;
+      rec->u.win.chan = (w & 0x7800000) >> 23;
+      rec->u.win.width = (w & 0xFFF);
+      rec->u.win.nsamples = 0;
+      rec->u.win.ninvalid = 0;
+      if(out)
+	{
+	  /* Room for the padding sample of an odd width */
+	  rec->u.win.samples = &out->samples[out->nsamples];
+	  out->nsamples += (rec->u.win.width + 1) & ~1;
+	  rec->u.win.invalid = &out->words[out->nwords];
+	  out->nwords += FAV3_DEC_INVALID_WORDS(rec->u.win.width);
+	}
+      else
+	{
+	  rec->u.win.samples = dec->samples;
+	  rec->u.win.invalid = dec->invalid;
+	}
+      memset(rec->u.win.invalid, 0,
+	     FAV3_DEC_INVALID_WORDS(rec->u.win.width) * sizeof(uint32_t));
+      remaining = (rec->u.win.width + 1) >> 1;
+      break;
+
+    case 9:			/* PULSE PARAMETERS */
+      return faV3DecPulseStart(dec, rec, w);
+
+    case 12:			/* SCALER HEADER */
+      rec->type = FAV3_DEC_SCALER;
+      rec->u.sc.nwords = 0;
+      if(out)
+	{
+	  rec->u.sc.counts = &out->words[out->nwords];
+	  out->nwords += (w & 0x3F);
+	}
+      else
+	rec->u.sc.counts = dec->counts;
+      remaining = (w & 0x3F);
+      break;
+
+    case 15:			/* FILLER WORD */
+      rec->type = FAV3_DEC_FILLER;
+      break;
+
+    default:
+      rec->type = FAV3_DEC_OTHER;
+      rec->u.other.dtype = dtype;
+      break;
+    }
+
+  rec->slot = dec->slot;
+  rec->evt_num = dec->evt_num;
+  rec->evt_idx = dec->evt_idx;
+
+  /* Single word records are emitted right away */
+  if(remaining < 0)
+    faV3DecEmit(dec, rec);
+
+  return remaining;
+}
+
+/* A pulse word of the pulse parameter record at rec */
+static inline void
+faV3DecPulseWord(faV3Decoder_t * dec, faV3DecRecord_t * rec, uint32_t w)
+{
+  faV3DecPulse_t *p;
+
+  if(w & (1 << 30))
+    {				/* Word 1: Integral of n-th pulse in window */
+      if(rec->u.pp.npulse < FAV3_DEC_MAX_PULSES)
+	{
+	  p = &rec->u.pp.pulse[rec->u.pp.npulse++];
+	  p->word[0] = w;
+	  p->word[1] = 0;
+	}
+      else
+	dec->stats.overflow++;
+    }
+  else
+    {				/* Word 2: Time of n-th pulse in window */
+      if(rec->u.pp.npulse > 0)
+	rec->u.pp.pulse[rec->u.pp.npulse - 1].word[1] = w;
+      else
+	dec->stats.orphan++;
+    }
+}
+
+/* Unpack the window raw sample words at buf[0..n-1], with remaining
+   words still expected.  Returns the words consumed. */
+static inline int32_t
+faV3DecSamples(faV3Decoder_t * dec, faV3DecRecord_t * rec,
+	       const uint32_t * buf, int32_t n, int32_t remaining,
+	       const int swap)
+{
+  uint32_t width = rec->u.win.width;
+  uint32_t first = 2 * (((width + 1) >> 1) - remaining);
+  int32_t done;
+
+  if(n > remaining)
+    n = remaining;
+
+  done = faV3DecodeSamples(buf, n,
+			   (swap ? FAV3_DEC_FLAG_SWAP : 0) |
+			   (dec->flags & FAV3_DEC_FLAG_SCALAR),
+			   &rec->u.win.samples[first], rec->u.win.invalid,
+			   first);
+
+  first += 2 * done;
+  rec->u.win.nsamples = (first > width) ? width : first;
+
+  return done;
+}
+
+/* The loop state is kept in locals, and written back to dec on return:
+   rec is the open record, and remaining is -1 when there is none.
+   Inlined once per byte order. */
+__attribute__ ((always_inline))
+static inline int32_t
+faV3DecoderFeedWords(faV3Decoder_t * dec, const uint32_t * buf,
+		     int32_t nwords, const int swap)
+{
+  faV3DecOutput_t *out = dec->out;
+  faV3DecRecord_t *rec = dec->rec;
+  uint32_t w, dtype;
+  int32_t i = 0, n, remaining = dec->pending ? dec->remaining : -1;
+
+  while(i < nwords)
+    {
+      w = DEC_LOAD(buf[i], swap);
+
+      if(w & FAV3_DATA_TYPE_DEFINE)
+	{
+	  dtype = (w & FAV3_DATA_TYPE_MASK) >> 27;
+
+	  if(out && !faV3DecHasRoom(dec, dtype, w, remaining >= 0))
+	    {
+	      /* Leave nothing open in the arrays the caller will empty */
+	      if(remaining >= 0)
+		{
+		  faV3DecFinish(dec, rec);
+		  remaining = -1;
+		}
+	      break;
+	    }
+
+	  if(remaining >= 0)
+	    faV3DecFinish(dec, rec);
+
+	  rec = out ? &out->rec[out->nrec] : &dec->cur;
+	  remaining = faV3DecStart(dec, rec, w, dec->stats.nwords + i);
+	  i++;
+
+	  /* Most of the data in the pulse modes: take the pulse words, and
+	     the pulse parameter records that follow, here.  A record is
+	     emitted as soon as the next type defining word shows.  The
+	     counts are kept in locals until the run ends. */
+	  if(dtype == 9)
+	    {
+	      faV3DecCallback_t callback = dec->callback;
+	      int32_t nrec = out ? out->nrec : 0, npp = 0, np;
+
+	      while(1)
+		{
+		  np = 0;
+		  /* The common case: one pulse, then the next record */
+		  if((i + 2 < nwords) && (remaining >= 2))
+		    {
+		      uint32_t w1 = DEC_LOAD(buf[i], swap);
+		      uint32_t w2 = DEC_LOAD(buf[i + 1], swap);
+
+		      w = DEC_LOAD(buf[i + 2], swap);
+		      if(((w1 & 0xC0000000) == 0x40000000) &&
+			 ((w2 & 0xC0000000) == 0) && (w & FAV3_DATA_TYPE_DEFINE))
+			{
+			  rec->u.pp.pulse[0].word[0] = w1;
+			  rec->u.pp.pulse[0].word[1] = w2;
+			  np = 1;
+			  remaining -= 2;
+			  i += 2;
+			}
+		    }
+		  while((i < nwords) && (remaining > 0))
+		    {
+		      w = DEC_LOAD(buf[i], swap);
+		      if(w & FAV3_DATA_TYPE_DEFINE)
+			break;
+		      if(w & (1 << 30))
+			{	/* Word 1: Integral of n-th pulse in window */
+			  if(np < FAV3_DEC_MAX_PULSES)
+			    {
+			      rec->u.pp.pulse[np].word[0] = w;
+			      rec->u.pp.pulse[np].word[1] = 0;
+			      np++;
+			    }
+			  else
+			    dec->stats.overflow++;
+			}
+		      else
+			{	/* Word 2: Time of n-th pulse in window */
+			  if(np > 0)
+			    rec->u.pp.pulse[np - 1].word[1] = w;
+			  else
+			    dec->stats.orphan++;
+			}
+		      remaining--;
+		      i++;
+		    }
+		  rec->u.pp.npulse = np;
+		  if((i == nwords) || (remaining == 0))
+		    break;
+
+		  npp++;
+		  if(callback)
+		    (*callback) (rec, dec->arg);
+		  remaining = -1;
+
+		  if(out)
+		    {
+		      nrec++;
+		      if(nrec + 1 > out->maxrec)
+			break;
+		    }
+		  if(((w & FAV3_DATA_TYPE_MASK) >> 27) != 9)
+		    break;
+		  rec = out ? &out->rec[nrec] : &dec->cur;
+		  remaining = faV3DecPulseStart(dec, rec, w);
+		  i++;
+		}
+
+	      dec->stats.nrec[FAV3_DEC_PULSE_PARAM] += npp;
+	      if(out)
+		out->nrec = nrec;
+	    }
+	  continue;
+	}
+
+      /* Continuation word */
+      if(remaining <= 0)
+	{
+	  if(remaining < 0)
+	    dec->stats.orphan++;
+	  else
+	    dec->stats.overflow++;
+	  i++;
+	  continue;
+	}
+
+      switch (rec->type)
+	{
+	case FAV3_DEC_PULSE_PARAM:
+	  faV3DecPulseWord(dec, rec, w);
+	  break;
+
+	case FAV3_DEC_WINDOW_RAW:
+	  n = faV3DecSamples(dec, rec, &buf[i], nwords - i, remaining, swap);
+	  remaining -= n;
+	  i += n;
+	  continue;
+
+	case FAV3_DEC_BLOCK_HEADER:
+	  rec->u.bh.has_param = 1;
+	  rec->u.bh.PL = (w & 0x1FFC0000) >> 18;
+	  rec->u.bh.NSB = (w & 0x0003FE00) >> 9;
+	  rec->u.bh.NSA = (w & 0x000001FF);
+	  break;
+
+	case FAV3_DEC_TRIGGER_TIME:
+	  rec->u.tt.nwords++;
+	  rec->u.tt.time_2 = (w & 0xFFFFFF);
+	  rec->u.tt.time |= ((uint64_t) rec->u.tt.time_2) << 24;
+	  break;
+
+	case FAV3_DEC_SCALER:
+	  rec->u.sc.counts[rec->u.sc.nwords++] = w;
+	  break;
+
+	default:
+	  dec->stats.orphan++;
+	  break;
+	}
+
+      remaining--;
+      i++;
+    }
+
+  dec->rec = rec;
+  dec->pending = (remaining >= 0);
+  dec->remaining = (remaining > 0) ? remaining : 0;
+  dec->stats.nwords += i;
+
+  return i;
+}
+
+/**
+ * @brief Decode a buffer of data words.
+ *
+ *   Records may span calls.  A record still open at the end of the buffer
+ *   is emitted by the next type defining word or by faV3DecoderFlush.
+ *
+ * @param dec Decoder context
+ * @param buf Data words
+ * @param nwords Number of words in buf
+ * @return Number of words consumed (less than nwords only if the output
+ *         arrays are full), otherwise ERROR
+ */
+int32_t
+faV3DecoderFeed(faV3Decoder_t * dec, const uint32_t * buf, int32_t nwords)
+{
+  if((dec == NULL) || ((buf == NULL) && (nwords > 0)) || (nwords < 0))
+    return ERROR;
+
+  if(faV3DecMove(dec) != OK)
+    return 0;
+
+  if(dec->flags & FAV3_DEC_FLAG_SWAP)
+    return faV3DecoderFeedWords(dec, buf, nwords, 1);
+
+  return faV3DecoderFeedWords(dec, buf, nwords, 0);
+}
+
+/**
+ * @brief Emit the record still open at the end of the data, if any.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3DecoderFlush(faV3Decoder_t * dec)
+{
+  if(dec == NULL)
+    return ERROR;
+
+  if(faV3DecMove(dec) != OK)
+    return ERROR;
+
+  if(dec->pending)
+    {
+      faV3DecFinish(dec, dec->rec);
+      dec->pending = 0;
+      dec->remaining = 0;
+    }
+
+  return OK;
+}
+
+/*
+ * Window raw sample unpacking.
+ *
+ * Each sample word holds two samples: bits 16-28 (first) with the invalid
+ * flag in bit 29, and bits 0-12 (second) with the invalid flag in bit 13.
+ * Viewed as 16 bit lanes, the first sample is in the upper lane, so the
+ * SIMD versions swap the lanes of each word (host order) or the bytes of
+ * each lane (big-endian input, where the word swap and lane swap cancel).
+ * After that, bit 15 of every even lane is the type defining bit and bit 13
+ * of every lane is the invalid flag.
+ */
+
+/* OR 16 invalid flags into the bitmask, starting at sample pos */
+static inline void
+faV3DecSetBits(uint32_t * invalid, uint32_t pos, uint32_t bits)
+{
+  uint64_t v = ((uint64_t) bits) << (pos & 31);
+
+  invalid[pos >> 5] |= (uint32_t) v;
+  if(v >> 32)
+    invalid[(pos >> 5) + 1] |= (uint32_t) (v >> 32);
+}
+
+static int32_t
+faV3DecSamplesScalar(const uint32_t * words, int32_t nwords, int swap,
+		     uint16_t * samples, uint32_t * invalid, uint32_t first)
+{
+  int32_t i;
+  uint32_t w, pos;
+
+  for(i = 0; i < nwords; i++)
+    {
+      w = DEC_LOAD(words[i], swap);
+      if(w & FAV3_DATA_TYPE_DEFINE)
+	break;
+
+      samples[2 * i] = (w >> 16) & FAV3_DEC_SAMPLE_MASK;
+      samples[2 * i + 1] = w & FAV3_DEC_SAMPLE_MASK;
+
+      if(w & 0x20002000)
+	{
+	  pos = first + 2 * i;
+	  if(w & 0x20000000)
+	    invalid[pos >> 5] |= 1u << (pos & 31);
+	  pos++;
+	  if(w & 0x2000)
+	    invalid[pos >> 5] |= 1u << (pos & 31);
+	}
+    }
+
+  return i;
+}
+
+#ifdef FAV3_DEC_X86
+__attribute__ ((target("sse2")))
+static inline __m128i
+faV3DecArrangeSSE2(__m128i x, int swap)
+{
+  if(swap)
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+}
+
+__attribute__ ((target("sse2")))
+static int32_t
+faV3DecSamplesSSE2(const uint32_t * words, int32_t nwords, int swap,
+		   uint16_t * samples, uint32_t * invalid, uint32_t first)
+{
+  const __m128i adc = _mm_set1_epi16(FAV3_DEC_SAMPLE_MASK);
+  __m128i a, b;
+  uint32_t bits;
+  int32_t i;
+
+  /* 8 words (16 samples) per pass */
+  for(i = 0; i + 8 <= nwords; i += 8)
+    {
+      a = faV3DecArrangeSSE2(_mm_loadu_si128((const __m128i *) &words[i]),
+			     swap);
+      b = faV3DecArrangeSSE2(_mm_loadu_si128((const __m128i *) &words[i + 4]),
+			     swap);
+
+      /* Stop at a type defining word */
+      if((_mm_movemask_epi8(a) | _mm_movemask_epi8(b)) & 0x2222)
+	break;
+
+      _mm_storeu_si128((__m128i *) & samples[2 * i], _mm_and_si128(a, adc));
+      _mm_storeu_si128((__m128i *) & samples[2 * i + 8],
+		       _mm_and_si128(b, adc));
+
+      /* Move the invalid flag to the lane sign bit, and narrow to bytes */
+      bits = _mm_movemask_epi8(_mm_packs_epi16(_mm_slli_epi16(a, 2),
+					       _mm_slli_epi16(b, 2)));
+      if(bits)
+	faV3DecSetBits(invalid, first + 2 * i, bits);
+    }
+
+  return i + faV3DecSamplesScalar(&words[i], nwords - i, swap,
+				  &samples[2 * i], invalid, first + 2 * i);
+}
+
+__attribute__ ((target("avx2")))
+static int32_t
+faV3DecSamplesAVX2(const uint32_t * words, int32_t nwords, int swap,
+		   uint16_t * samples, uint32_t * invalid, uint32_t first)
+{
+  const __m256i adc = _mm256_set1_epi16(FAV3_DEC_SAMPLE_MASK);
+  const __m256i lane_swap =
+    _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+		     2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m256i byte_swap =
+    _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+		     1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  const __m256i ctrl = swap ? byte_swap : lane_swap;
+  __m256i a, b;
+  uint32_t m, bits;
+  int32_t i;
+
+  /* 16 words (32 samples) per pass */
+  for(i = 0; i + 16 <= nwords; i += 16)
+    {
+      a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) &words[i]),
+			      ctrl);
+      b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+						 &words[i + 8]), ctrl);
+
+      /* Stop at a type defining word */
+      if((_mm256_movemask_epi8(a) | _mm256_movemask_epi8(b)) & 0x22222222)
+	break;
+
+      _mm256_storeu_si256((__m256i *) & samples[2 * i],
+			  _mm256_and_si256(a, adc));
+      _mm256_storeu_si256((__m256i *) & samples[2 * i + 16],
+			  _mm256_and_si256(b, adc));
+
+      /* packs works per 128 bit lane: bytes 0-7 are a[0-7], 8-15 b[0-7],
+         16-23 a[8-15], 24-31 b[8-15] */
+      m = _mm256_movemask_epi8(_mm256_packs_epi16(_mm256_slli_epi16(a, 2),
+						  _mm256_slli_epi16(b, 2)));
+      if(m)
+	{
+	  bits = (m & 0xFF) | ((m >> 8) & 0xFF00);
+	  if(bits)
+	    faV3DecSetBits(invalid, first + 2 * i, bits);
+	  bits = ((m >> 8) & 0xFF) | ((m >> 16) & 0xFF00);
+	  if(bits)
+	    faV3DecSetBits(invalid, first + 2 * i + 16, bits);
+	}
+    }
+
+  /* Avoid the AVX to SSE transition penalty in the code that follows */
+  _mm256_zeroupper();
+
+  return i + faV3DecSamplesSSE2(&words[i], nwords - i, swap,
+				&samples[2 * i], invalid, first + 2 * i);
+}
+#endif /* FAV3_DEC_X86 */
+
+typedef int32_t (*faV3DecSamplesFunc_t) (const uint32_t *, int32_t, int,
+					 uint16_t *, uint32_t *, uint32_t);
+
+/* Chosen on each call, with no state kept: __builtin_cpu_supports only
+   tests a word filled in by libgcc at startup */
+static inline faV3DecSamplesFunc_t
+faV3DecSamplesSelect()
+{
+#ifdef FAV3_DEC_X86
+  if(__builtin_cpu_supports("avx2"))
+    return faV3DecSamplesAVX2;
+  if(__builtin_cpu_supports("sse2"))
+    return faV3DecSamplesSSE2;
+#endif
+  return faV3DecSamplesScalar;
+}
+
+/**
+ * @brief Unpack a run of window raw sample words
+ *
+ *   Uses AVX2 or SSE2 when the CPU has them, unless FAV3_DEC_FLAG_SCALAR is
+ *   set.  Unpacking stops at the first type defining word.
+ *
+ * @param words Sample words (continuation words of a type 4 record)
+ * @param nwords Number of words
+ * @param flags FAV3_DEC_FLAG_SWAP for big-endian input, FAV3_DEC_FLAG_SCALAR
+ * @param samples Output, 2 samples per word (13 bit ADC values)
+ * @param invalid Invalid-sample bitmask of the window.  Bits are only set,
+ *                so it must be cleared before the first call for a window.
+ * @param first Index in the window of the first sample of words[0] (even)
+ * @return Number of words unpacked
+ */
+int32_t
+faV3DecodeSamples(const uint32_t * words, int32_t nwords, uint32_t flags,
+		  uint16_t * samples, uint32_t * invalid, uint32_t first)
+{
+  int swap = (flags & FAV3_DEC_FLAG_SWAP) ? 1 : 0;
+
+  if(nwords <= 0)
+    return 0;
+
+  if(flags & FAV3_DEC_FLAG_SCALAR)
+    return faV3DecSamplesScalar(words, nwords, swap, samples, invalid, first);
+
+  return (*faV3DecSamplesSelect()) (words, nwords, swap, samples, invalid,
+				    first);
+}
+
+/*
+ * Block / event index.
+ *
+ * The buffer is scanned for block headers, block trailers and event
+ * headers: type defining words whose bits 27-31 are 0x10, 0x11 or 0x12.
+ * With bit 31 flipped these are the values 0-2, so a single signed compare
+ * per word classifies them.
+ */
+
+#define FAV3_INDEX_CHUNK 1024
+
+static int32_t
+faV3IdxScanScalar(const uint32_t * words, int32_t nwords, int swap,
+		  uint32_t base, uint32_t * hits)
+{
+  int32_t i, nhits = 0;
+  uint32_t w;
+
+  for(i = 0; i < nwords; i++)
+    {
+      w = DEC_LOAD(words[i], swap);
+      if(((w >> 27) ^ 0x10) < 3)
+	hits[nhits++] = base + i;
+    }
+
+  return nhits;
+}
+
+#ifdef FAV3_DEC_X86
+__attribute__ ((target("sse2")))
+static int32_t
+faV3IdxScanSSE2(const uint32_t * words, int32_t nwords, int swap,
+		uint32_t base, uint32_t * hits)
+{
+  const __m128i flip = _mm_set1_epi32(0x10), three = _mm_set1_epi32(3);
+  __m128i x, t;
+  uint32_t bits;
+  int32_t i, nhits = 0;
+
+  for(i = 0; i + 4 <= nwords; i += 4)
+    {
+      x = _mm_loadu_si128((const __m128i *) &words[i]);
+      if(swap)
+	{
+	  x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+	  x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+	}
+      t = _mm_xor_si128(_mm_srli_epi32(x, 27), flip);
+      bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(t, three)));
+
+      while(bits)
+	{
+	  hits[nhits++] = base + i + __builtin_ctz(bits);
+	  bits &= bits - 1;
+	}
+    }
+
+  return nhits + faV3IdxScanScalar(&words[i], nwords - i, swap, base + i,
+				   &hits[nhits]);
+}
+
+__attribute__ ((target("avx2")))
+static int32_t
+faV3IdxScanAVX2(const uint32_t * words, int32_t nwords, int swap,
+		uint32_t base, uint32_t * hits)
+{
+  const __m256i flip = _mm256_set1_epi32(0x10), three = _mm256_set1_epi32(3);
+  const __m256i bswap =
+    _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		     3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  __m256i x, t;
+  uint32_t bits;
+  int32_t i, nhits = 0;
+
+  for(i = 0; i + 8 <= nwords; i += 8)
+    {
+      x = _mm256_loadu_si256((const __m256i *) &words[i]);
+      if(swap)
+	x = _mm256_shuffle_epi8(x, bswap);
+      t = _mm256_xor_si256(_mm256_srli_epi32(x, 27), flip);
+      bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(three, t)));
+
+      while(bits)
+	{
+	  hits[nhits++] = base + i + __builtin_ctz(bits);
+	  bits &= bits - 1;
+	}
+    }
+
+  _mm256_zeroupper();
+
+  return nhits + faV3IdxScanSSE2(&words[i], nwords - i, swap, base + i,
+				 &hits[nhits]);
+}
+#endif /* FAV3_DEC_X86 */
+
+typedef int32_t (*faV3IdxScanFunc_t) (const uint32_t *, int32_t, int,
+				      uint32_t, uint32_t *);
+
+static inline faV3IdxScanFunc_t
+faV3IdxScanSelect()
+{
+#ifdef FAV3_DEC_X86
+  if(__builtin_cpu_supports("avx2"))
+    return faV3IdxScanAVX2;
+  if(__builtin_cpu_supports("sse2"))
+    return faV3IdxScanSSE2;
+#endif
+  return faV3IdxScanScalar;
+}
+
+static void
+faV3IdxCloseBlock(faV3Index_t * idx, faV3IndexBlock_t * b)
+{
+  if(b->trailer == FAV3_INDEX_NONE)
+    b->status |= FAV3_INDEX_ERR_NO_TRAILER;
+
+  if(b->nevents != b->n_evts)
+    b->status |= FAV3_INDEX_WARN_NEVENTS;
+
+  if(b->status & FAV3_INDEX_ERR_MASK)
+    idx->nerrors++;
+}
+
+/**
+ * @brief Index the blocks and events of a buffer
+ *
+ *   Scans the buffer once and records the offsets of each block header,
+ *   block trailer and event header, with the blocks of each slot chained
+ *   from slot_first[slot].  The trailer word count and slot of each block
+ *   are checked against its header.
+ *
+ * @param idx Index, with blocks/maxblocks and events/maxevents set
+ * @param buf Data (e.g. from a multiblock faV3ReadBlock)
+ * @param nwords Number of words in buf
+ * @param flags FAV3_DEC_FLAG_SWAP for big-endian input, FAV3_DEC_FLAG_SCALAR
+ * @return Number of blocks found, otherwise ERROR
+ */
+int32_t
+faV3IndexBuild(faV3Index_t * idx, const uint32_t * buf, int32_t nwords,
+	       uint32_t flags)
+{
+  faV3IdxScanFunc_t scan = faV3IdxScanSelect();
+  uint32_t hits[FAV3_INDEX_CHUNK];
+  int32_t slot_last[32];
+  int32_t off, n, nhits, ihit, islot, cur = -1;
+  int swap = (flags & FAV3_DEC_FLAG_SWAP) ? 1 : 0;
+  faV3IndexBlock_t *b = NULL;
+  uint32_t w, h, slot;
+
+  if((idx == NULL) || ((buf == NULL) && (nwords > 0)) || (nwords < 0))
+    return ERROR;
+
+
+  idx->nblocks = 0;
+  idx->nevents = 0;
+  idx->slotmask = 0;
+  idx->nerrors = 0;
+  idx->orphan = 0;
+  idx->truncated = 0;
+  for(islot = 0; islot < 32; islot++)
+    {
+      idx->slot_first[islot] = -1;
+      slot_last[islot] = -1;
+    }
+
+  for(off = 0; off < nwords; off += FAV3_INDEX_CHUNK)
+    {
+      n = nwords - off;
+      if(n > FAV3_INDEX_CHUNK)
+	n = FAV3_INDEX_CHUNK;
+
+      if(flags & FAV3_DEC_FLAG_SCALAR)
+	nhits = faV3IdxScanScalar(&buf[off], n, swap, off, hits);
+      else
+	nhits = (*scan) (&buf[off], n, swap, off, hits);
+
+      for(ihit = 0; ihit < nhits; ihit++)
+	{
+	  h = hits[ihit];
+	  w = DEC_LOAD(buf[h], swap);
+
+	  switch ((w & FAV3_DATA_TYPE_MASK) >> 27)
+	    {
+	    case 0:		/* BLOCK HEADER */
+	      if(cur >= 0)
+		faV3IdxCloseBlock(idx, b);
+	      cur = -1;
+
+	      if(idx->nblocks >= idx->maxblocks)
+		{
+		  idx->truncated++;
+		  break;
+		}
+
+	      cur = idx->nblocks++;
+	      b = &idx->blocks[cur];
+	      slot = (w & FAV3_DATA_SLOT_MASK) >> 22;
+	      b->slot = slot;
+	      b->blk_num = (w & 0x3FF00) >> 8;
+	      b->n_evts = (w & 0xFF);
+	      b->header = h;
+	      b->trailer = FAV3_INDEX_NONE;
+	      b->n_words = 0;
+	      b->status = 0;
+	      b->first_event = idx->nevents;
+	      b->nevents = 0;
+	      b->next = -1;
+
+	      if(slot_last[slot] < 0)
+		idx->slot_first[slot] = cur;
+	      else
+		idx->blocks[slot_last[slot]].next = cur;
+	      slot_last[slot] = cur;
+	      idx->slotmask |= (1u << slot);
+	      break;
+
+	    case 1:		/* BLOCK TRAILER */
+	      if(cur < 0)
+		{
+		  idx->orphan++;
+		  break;
+		}
+
+	      b->trailer = h;
+	      b->n_words = w & FAV3_DATA_WRDCNT_MASK;
+	      if(b->n_words != (h - b->header + 1))
+		b->status |= FAV3_INDEX_ERR_WORDCOUNT;
+	      if(((w & FAV3_DATA_SLOT_MASK) >> 22) != b->slot)
+		b->status |= FAV3_INDEX_ERR_SLOT;
+
+	      faV3IdxCloseBlock(idx, b);
+	      cur = -1;
+	      break;
+
+	    case 2:		/* EVENT HEADER */
+	      if(cur < 0)
+		{
+		  idx->orphan++;
+		  break;
+		}
+
+	      if(idx->nevents >= idx->maxevents)
+		{
+		  idx->truncated++;
+		  break;
+		}
+
+	      idx->events[idx->nevents++] = h;
+	      b->nevents++;
+	      break;
+	    }
+	}
+    }
+
+  if(cur >= 0)
+    faV3IdxCloseBlock(idx, b);
+
+  return idx->nblocks;
+}
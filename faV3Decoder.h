@@ -0,0 +1,253 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Decoder.h
+ *
+ * @brief     Header for the reentrant fADC250 V3 data decoder
+ *
+ *            The decoder does no I/O and keeps all of its state in a
+ *            faV3Decoder_t, so one context may be used per thread.
+ *            It does not depend on jvme.
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Lib.h"
+
+/* Record types produced by the decoder */
+enum faV3DecType_enum
+  {
+    FAV3_DEC_BLOCK_HEADER,
+    FAV3_DEC_BLOCK_TRAILER,
+    FAV3_DEC_EVENT_HEADER,
+    FAV3_DEC_TRIGGER_TIME,
+    FAV3_DEC_WINDOW_RAW,
+    FAV3_DEC_PULSE_PARAM,
+    FAV3_DEC_SCALER,
+    FAV3_DEC_FILLER,
+    FAV3_DEC_OTHER,		/* any other type (including data not valid) */
+    FAV3_DEC_NTYPES
+  };
+
+/* Decoder flags */
+#define FAV3_DEC_FLAG_SWAP        (1 << 0)	/* input words are big-endian */
+#define FAV3_DEC_FLAG_SCALAR      (1 << 1)	/* don't use the SIMD sample unpacker */
+
+#define FAV3_DEC_MAX_SAMPLES      4096	/* window width is 12 bits */
+#define FAV3_DEC_MAX_SCALERS      64	/* scaler word count is 6 bits */
+#define FAV3_DEC_MAX_PULSES       4
+
+#define FAV3_DEC_SAMPLE_MASK      0x1FFF
+/* Words in a window invalid-sample bitmask (1 bit per sample, plus padding) */
+#define FAV3_DEC_INVALID_WORDS(_width)  (((_width) + 1 + 31) >> 5)
+
+/* The two words of a pulse, as they come from the board: the bit fields
+   follow the data format, so the decoder stores each word whole */
+typedef union faV3DecPulse_union
+{
+  uint32_t word[2];
+  struct
+  {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    /* Word 1 */
+    uint32_t word1_type:2;	/* 1 */
+    uint32_t adc_sum:18;
+    uint32_t nsa_ext:1;
+    uint32_t over:1;
+    uint32_t under:1;
+    uint32_t samp_ov_thres:9;
+    /* Word 2 (all 0 until it arrives) */
+    uint32_t word2_type:2;	/* 0 */
+    uint32_t time_coarse:9;
+    uint32_t time_fine:6;
+    uint32_t vpeak:12;
+    uint32_t:1;
+    uint32_t quality:1;
+    uint32_t quality2:1;
+#else
+    /* Word 1 */
+    uint32_t samp_ov_thres:9;
+    uint32_t under:1;
+    uint32_t over:1;
+    uint32_t nsa_ext:1;
+    uint32_t adc_sum:18;
+    uint32_t word1_type:2;	/* 1 */
+    /* Word 2 (all 0 until it arrives) */
+    uint32_t quality2:1;
+    uint32_t quality:1;
+    uint32_t:1;
+    uint32_t vpeak:12;
+    uint32_t time_fine:6;
+    uint32_t time_coarse:9;
+    uint32_t word2_type:2;	/* 0 */
+#endif
+  };
+} faV3DecPulse_t;
+
+/* 56 bytes: decoded pulses are kept as the two data words */
+typedef struct faV3DecRecord_struct
+{
+  uint16_t type;		/* FAV3_DEC_* */
+  uint16_t slot;		/* slot from the enclosing block header */
+  uint32_t evt_num;		/* trigger number from the last event header */
+  uint32_t evt_idx;		/* event headers seen in this block, minus 1 */
+  uint32_t word;		/* type defining word (host order) */
+  union
+  {
+    struct
+    {
+      uint32_t modID, blk_num, n_evts;
+      uint32_t has_param;	/* 1 if the ADC parameter word was present */
+      uint32_t PL, NSB, NSA;
+    } bh;
+    struct
+    {
+      uint32_t n_words;		/* word count in the trailer */
+      uint32_t counted;		/* words seen from block header to trailer */
+    } bt;
+    struct
+    {
+      uint32_t time_low_10, evt_num;
+    } eh;
+    struct
+    {
+      uint32_t nwords;
+      uint32_t time_1, time_2;
+      uint64_t time;		/* 48 bit trigger time */
+    } tt;
+    struct
+    {
+      uint32_t chan, width;
+      uint32_t nsamples;	/* samples decoded (== width if complete) */
+      uint32_t ninvalid;	/* samples flagged as not valid by the ADC */
+      uint16_t *samples;	/* 13 bit ADC values */
+      uint32_t *invalid;	/* bit i set if samples[i] is not valid */
+    } win;
+    struct
+    {
+      uint8_t evt_of_blk, chan, quality, npulse;
+      uint16_t ped_sum;
+      faV3DecPulse_t pulse[FAV3_DEC_MAX_PULSES];
+    } pp;
+    struct
+    {
+      uint32_t nwords;
+      uint32_t *counts;
+    } sc;
+    struct
+    {
+      uint32_t dtype;		/* data type (bits 27-30) */
+    } other;
+  } u;
+} faV3DecRecord_t;
+
+typedef void (*faV3DecCallback_t) (const faV3DecRecord_t * rec, void *arg);
+
+/* Output arrays.  Set with faV3DecoderSetOutput.  Window samples of records
+   stored in rec[] point into samples[].  Invalid-sample bitmasks and scaler
+   counts point into words[]. */
+typedef struct faV3DecOutput_struct
+{
+  faV3DecRecord_t *rec;
+  int32_t maxrec, nrec;
+  uint16_t *samples;
+  int32_t maxsamples, nsamples;
+  uint32_t *words;
+  int32_t maxwords, nwords;
+} faV3DecOutput_t;
+
+typedef struct faV3DecStats_struct
+{
+  uint64_t nwords;
+  uint64_t nrec[FAV3_DEC_NTYPES];
+  uint32_t orphan;		/* continuation words without a record */
+  uint32_t overflow;		/* extra samples, pulses or scaler words */
+  uint32_t trailer_mismatch;	/* trailer word count != words seen */
+  uint32_t trailer_slot;	/* trailer slot != block header slot */
+} faV3DecStats_t;
+
+typedef struct faV3Decoder_struct
+{
+  uint32_t flags;
+
+  /* Record sinks */
+  faV3DecCallback_t callback;
+  void *arg;
+  faV3DecOutput_t *out;
+
+  /* Stream state */
+  uint32_t slot;
+  uint32_t evt_num, evt_idx;
+  uint32_t inblock;
+  uint64_t blockstart;		/* stream position of the block header */
+  int32_t pending;		/* rec is an unfinished record */
+  int32_t remaining;		/* continuation words still expected */
+  faV3DecRecord_t *rec;		/* record being built: in place in
+				   out->rec[out->nrec], or cur */
+  faV3DecRecord_t cur;
+
+  /* Payload storage for callback mode */
+  uint16_t samples[FAV3_DEC_MAX_SAMPLES];
+  uint32_t invalid[FAV3_DEC_INVALID_WORDS(FAV3_DEC_MAX_SAMPLES)];
+  uint32_t counts[FAV3_DEC_MAX_SCALERS];
+
+  faV3DecStats_t stats;
+} faV3Decoder_t;
+
+/* Block status bits in the index */
+#define FAV3_INDEX_ERR_WORDCOUNT  (1 << 0)	/* trailer word count != words seen */
+#define FAV3_INDEX_ERR_SLOT       (1 << 1)	/* trailer slot != header slot */
+#define FAV3_INDEX_ERR_NO_TRAILER (1 << 2)	/* no trailer before next header or end */
+#define FAV3_INDEX_ERR_MASK       0x7
+#define FAV3_INDEX_NONE           0xFFFFFFFF
+#define FAV3_INDEX_WARN_NEVENTS   (1 << 8)	/* event headers != n_evts (normal if
+						   event headers are suppressed) */
+
+typedef struct faV3IndexBlock_struct
+{
+  uint32_t slot;
+  uint32_t blk_num;
+  uint32_t n_evts;
+  uint32_t header;		/* offset of the block header */
+  uint32_t trailer;		/* offset of the block trailer, or
+				   FAV3_INDEX_NONE if missing */
+  uint32_t n_words;		/* word count from the trailer */
+  uint32_t status;		/* FAV3_INDEX_ERR_* and FAV3_INDEX_WARN_* bits */
+  uint32_t first_event;		/* index of the first event in events[] */
+  uint32_t nevents;		/* event headers found in the block */
+  int32_t next;			/* next block from the same slot, or -1 */
+} faV3IndexBlock_t;
+
+/* Index of a (multiblock) buffer.  The caller provides blocks[] and
+   events[] and sets maxblocks and maxevents. */
+typedef struct faV3Index_struct
+{
+  faV3IndexBlock_t *blocks;
+  int32_t maxblocks, nblocks;
+  uint32_t *events;		/* offsets of event headers */
+  int32_t maxevents, nevents;
+  int32_t slot_first[32];	/* first block for each slot, or -1 */
+  uint32_t slotmask;		/* slots with at least one block */
+  uint32_t nerrors;		/* blocks with FAV3_INDEX_ERR_* set */
+  uint32_t orphan;		/* trailers and event headers outside a block */
+  uint32_t truncated;		/* blocks or events dropped, arrays full */
+} faV3Index_t;
+
+int32_t faV3DecoderInit(faV3Decoder_t * dec, uint32_t flags);
+int32_t faV3DecoderReset(faV3Decoder_t * dec);
+int32_t faV3DecoderSetCallback(faV3Decoder_t * dec, faV3DecCallback_t cb,
+			       void *arg);
+int32_t faV3DecoderSetOutput(faV3Decoder_t * dec, faV3DecOutput_t * out);
+int32_t faV3DecoderFeed(faV3Decoder_t * dec, const uint32_t * buf,
+			int32_t nwords);
+int32_t faV3DecoderFlush(faV3Decoder_t * dec);
+const char *faV3DecoderTypeName(int32_t type);
+
+int32_t faV3IndexBuild(faV3Index_t * idx, const uint32_t * buf,
+		       int32_t nwords, uint32_t flags);
+int32_t faV3DecodeSamples(const uint32_t * words, int32_t nwords,
+			  uint32_t flags, uint16_t * samples,
+			  uint32_t * invalid, uint32_t first);
@@ -0,0 +1,909 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3EvBuild.c
+ *
+ * @brief     Cross-slot event builder.
+ *
+ *            The readout thread hands each buffer (a single block, or a
+ *            multiblock buffer from token passing) to faV3EvBuildPush.
+ *            Buffers go through a single producer, single consumer ring of
+ *            pointers, with no lock.  The builder indexes each buffer with
+ *            faV3IndexBuild, queues the events of each slot, and sends out
+ *            an event once every expected slot has one queued.
+ *
+ *            The 12 bit trigger number of the event header is extended for
+ *            each slot, and the 48 bit trigger time is put together from
+ *            the two TRIGGER TIME words (from word 1 and the previous time of
+ *            the slot, if word 2 is not there).  Slots are lined up by
+ *            trigger number.  A slot that skipped a trigger, or has a
+ *            different trigger time than the lowest slot, is flagged in the
+ *            event.  As with the trigger mismatch registers of the board
+ *            (faV3GetFirstTriggerMismatch, faV3GetMismatchTriggerCount),
+ *            each slot keeps its first mismatched trigger and a count.
+ *
+ *            A slot queues at most twice the block level of events.  If a
+ *            slot stops sending data, the queue of another slot fills, and
+ *            the oldest events are sent out with the slot marked missing.
+ *            A pushed buffer is held until all of its events are sent out,
+ *            then given back with its done routine.
+ *
+ *            The builder counts without a lock.  At the end of each pass
+ *            over the pushed buffers, and of a flush, it copies its
+ *            statistics under the module lock, and the Get and Status
+ *            routines read that copy.  They may be behind the builder by
+ *            one pass.  The queue full count is kept by the pushing thread,
+ *            with atomic stores.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+#include "faV3EvBuild.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+/* The event header trigger number is 12 bits */
+#define FAV3_EVB_EVT_BITS     12
+#define FAV3_EVB_SPIN         64	/* empty polls before the thread sleeps */
+#define FAV3_EVB_SLEEP_US     1000	/* longest sleep, if a wakeup is missed */
+
+typedef struct
+{
+  const uint32_t *data;
+  int32_t nwords;
+  faV3EvBuildDone_t done;
+  void *arg;
+} faV3EvBuildEntry_t;
+
+/* Statistics of one slot */
+typedef struct
+{
+  uint32_t nevents, nmissing, nmismatch, nlate;
+  int32_t mismatched;
+  uint32_t first_mismatch;
+} faV3EvBuildSlotStats_t;
+
+/* Statistics of the builder, as of the last faV3EvBuildPublish */
+typedef struct
+{
+  uint32_t slotmask;
+  int32_t learn;
+  uint32_t nbuffers, nevents, nincomplete, nmismatch;
+  uint32_t nforced, ndropped, nindexerr;
+  faV3EvBuildSlotStats_t slot[32];
+} faV3EvBuildStats_t;
+
+/* Events of one slot, waiting for the other slots */
+typedef struct
+{
+  faV3EvBuildSlot_t *ev;
+  uint32_t *seq;		/* queue entry that holds each event */
+  uint32_t first, count;
+
+  int32_t started;
+  uint32_t evt_num;		/* last trigger number */
+  uint64_t time;		/* last trigger time */
+
+  faV3EvBuildSlotStats_t stats;
+} faV3EvBuildFifo_t;
+
+typedef struct
+{
+  int32_t created;
+  uint32_t flags;
+  uint32_t slotmask;		/* expected slots */
+  int32_t learn;		/* add slots to slotmask as they show up, until
+				   one is into its second block */
+  uint32_t block_level;
+  faV3EvBuildCallback_t cb;
+  void *arg;
+  pthread_t thread;
+  volatile int32_t quit;
+  volatile int32_t sleeping;
+  volatile int32_t flushreq;
+
+  /* Queue of pushed buffers */
+  faV3EvBuildEntry_t *entry;
+  uint32_t nbuf;
+  volatile uint32_t head;	/* next entry to push (producer) */
+  volatile uint32_t tail;	/* next entry to release (builder) */
+  uint32_t parse;		/* next entry to index (builder) */
+
+  /* Events waiting, per slot */
+  faV3EvBuildFifo_t fifo[32];
+  uint32_t fifo_size;
+  uint32_t have;		/* slots with events queued */
+  faV3EvBuildSlot_t *evmem;
+  uint32_t *seqmem;
+
+  faV3Index_t idx;
+  faV3EvBuildEvent_t evt;
+  uint32_t last_evt;		/* last trigger number sent out */
+  int32_t sent;
+
+  /* Statistics: nfull is the pushing thread's, the rest the builder's.
+     pub is read and written with EVBLOCK held. */
+  uint32_t nfull, nbuffers, nevents, nincomplete, nmismatch;
+  uint32_t nforced, ndropped, nindexerr;
+  faV3EvBuildStats_t pub;
+} faV3EvBuild_t;
+
+static faV3EvBuild_t faV3EvBuild;
+
+pthread_mutex_t faV3EvBuildMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t faV3EvBuildCond = PTHREAD_COND_INITIALIZER;
+#define EVBLOCK      if(pthread_mutex_lock(&faV3EvBuildMutex)<0) perror("pthread_mutex_lock");
+#define EVBUNLOCK    if(pthread_mutex_unlock(&faV3EvBuildMutex)<0) perror("pthread_mutex_unlock");
+
+/* Signed distance from trigger number b to a, allowing for rollover */
+static inline int32_t
+faV3EvBuildEvtDiff(uint32_t a, uint32_t b)
+{
+  return ((int32_t) ((a - b) << (32 - FAV3_EVB_EVT_BITS)))
+    >> (32 - FAV3_EVB_EVT_BITS);
+}
+
+static inline uint32_t
+faV3EvBuildWord(const uint32_t * p)
+{
+  return (faV3EvBuild.flags & FAV3_DEC_FLAG_SWAP) ? __builtin_bswap32(*p) : *p;
+}
+
+static inline void
+faV3EvBuildMismatch(faV3EvBuildFifo_t * f, uint32_t evt_num)
+{
+  if(!f->stats.mismatched)
+    {
+      f->stats.mismatched = 1;
+      f->stats.first_mismatch = evt_num;
+    }
+  f->stats.nmismatch++;
+}
+
+/* Send out the lowest trigger number queued.  forced is set if some
+   expected slots have nothing queued. */
+static void
+faV3EvBuildEmit(int32_t forced)
+{
+  faV3EvBuildEvent_t *evt = &faV3EvBuild.evt;
+  faV3EvBuildFifo_t *f;
+  faV3EvBuildSlot_t *s;
+  uint32_t have = faV3EvBuild.have, fmask = faV3EvBuild.fifo_size - 1;
+  uint32_t bit, evt_num = 0;
+  int32_t slot, found = 0;
+
+  for(slot = 0; slot < 32; slot++)
+    {
+      if(!(have & (1u << slot)))
+	continue;
+      f = &faV3EvBuild.fifo[slot];
+      s = &f->ev[f->first & fmask];
+      if(!found || ((int32_t) (s->evt_num - evt_num) < 0))
+	evt_num = s->evt_num;
+      found = 1;
+    }
+
+  evt->evt_num = evt_num;
+  evt->time = FAV3_EVB_NO_TIME;
+  evt->slotmask = 0;
+  evt->missing = faV3EvBuild.slotmask & ~have;
+  evt->mismatch = 0;
+
+  for(slot = 0; slot < 32; slot++)
+    {
+      bit = 1u << slot;
+      f = &faV3EvBuild.fifo[slot];
+      if(!(have & bit))
+	{
+	  if(evt->missing & bit)
+	    f->stats.nmissing++;
+	  continue;
+	}
+
+      s = &f->ev[f->first & fmask];
+      if(s->evt_num != evt_num)
+	{
+	  /* A later trigger is queued: this slot skipped evt_num */
+	  evt->missing |= bit;
+	  evt->mismatch |= bit;
+	  f->stats.nmissing++;
+	  faV3EvBuildMismatch(f, evt_num);
+	  continue;
+	}
+
+      evt->slot[slot] = *s;
+      if(evt->slotmask == 0)
+	evt->time = s->time;
+      else if(s->time != evt->time)
+	{
+	  evt->mismatch |= bit;
+	  faV3EvBuildMismatch(f, evt_num);
+	}
+      evt->slotmask |= bit;
+
+      f->first++;
+      f->stats.nevents++;
+      if(--f->count == 0)
+	faV3EvBuild.have &= ~bit;
+    }
+
+  faV3EvBuild.nevents++;
+  if(evt->missing)
+    faV3EvBuild.nincomplete++;
+  if(evt->mismatch)
+    faV3EvBuild.nmismatch++;
+  if(forced)
+    faV3EvBuild.nforced++;
+  faV3EvBuild.last_evt = evt_num;
+  faV3EvBuild.sent = 1;
+
+  (*faV3EvBuild.cb) (evt, faV3EvBuild.arg);
+}
+
+/* Send out events while every expected slot has one queued */
+static void
+faV3EvBuildReady()
+{
+  if(faV3EvBuild.learn)
+    return;
+
+  while(faV3EvBuild.have &&
+	((faV3EvBuild.have & faV3EvBuild.slotmask) == faV3EvBuild.slotmask))
+    faV3EvBuildEmit(0);
+}
+
+/* Queue the event at data for slot */
+static void
+faV3EvBuildQueue(uint32_t slot, const uint32_t * data, int32_t nwords,
+		 uint32_t seq)
+{
+  faV3EvBuildFifo_t *f = &faV3EvBuild.fifo[slot];
+  faV3EvBuildSlot_t *s;
+  uint32_t bit = 1u << slot, w, evt_num;
+  uint64_t time = FAV3_EVB_NO_TIME;
+
+  if(!(faV3EvBuild.slotmask & bit))
+    {
+      if(!faV3EvBuild.learn)
+	{
+	  faV3EvBuild.ndropped++;
+	  return;
+	}
+      faV3EvBuild.slotmask |= bit;
+    }
+
+  w = faV3EvBuildWord(&data[0]) & 0xFFF;
+  evt_num = f->started ? f->evt_num + faV3EvBuildEvtDiff(w, f->evt_num) : w;
+
+  if(nwords > 1)
+    {
+      w = faV3EvBuildWord(&data[1]);
+      if((w & 0xF8000000) ==
+	 (FAV3_DATA_TYPE_DEFINE | FAV3_DATA_TRIGGER_TIME))
+	{
+	  time = w & 0xFFFFFF;
+	  if((nwords > 2) &&
+	     !((w = faV3EvBuildWord(&data[2])) & FAV3_DATA_TYPE_DEFINE))
+	    time |= ((uint64_t) (w & 0xFFFFFF)) << 24;
+	  else if(f->time != FAV3_EVB_NO_TIME)
+	    {
+	      /* Word 2 suppressed: upper bits from the last time */
+	      time |= f->time & ~0xFFFFFFULL;
+	      if(time < f->time)
+		time += (1ULL << 24);
+	    }
+	}
+    }
+
+  if(faV3EvBuild.sent && ((int32_t) (evt_num - faV3EvBuild.last_evt) <= 0))
+    f->stats.nlate++;
+
+  f->started = 1;
+  f->evt_num = evt_num;
+  if(time != FAV3_EVB_NO_TIME)
+    f->time = time;
+
+  /* Queue full: send out the oldest events without the slots behind */
+  while(f->count >= faV3EvBuild.fifo_size)
+    faV3EvBuildEmit(1);
+
+  s = &f->ev[(f->first + f->count) & (faV3EvBuild.fifo_size - 1)];
+  s->evt_num = evt_num;
+  s->time = time;
+  s->data = data;
+  s->nwords = nwords;
+  f->seq[(f->first + f->count) & (faV3EvBuild.fifo_size - 1)] = seq;
+  f->count++;
+  faV3EvBuild.have |= bit;
+
+  /* A slot is into its second block: every slot has had a chance to show
+     up */
+  if(faV3EvBuild.learn && (f->count > faV3EvBuild.block_level))
+    faV3EvBuild.learn = 0;
+}
+
+static int32_t
+faV3EvBuildGrow(void **ptr, int32_t * max, int32_t n, size_t size)
+{
+  void *p;
+
+  if(n <= *max)
+    return OK;
+
+  p = realloc(*ptr, n * size);
+  if(p == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate %d items of %d bytes\n",
+	     __func__, n, (int) size);
+      return ERROR;
+    }
+
+  *ptr = p;
+  *max = n;
+
+  return OK;
+}
+
+/* Index a pushed buffer and queue its events */
+static void
+faV3EvBuildParse(uint32_t seq)
+{
+  faV3EvBuildEntry_t *e = &faV3EvBuild.entry[seq & (faV3EvBuild.nbuf - 1)];
+  faV3Index_t *idx = &faV3EvBuild.idx;
+  faV3IndexBlock_t *b;
+  uint32_t ievt, last, end;
+  int32_t iblk;
+
+  if((faV3EvBuildGrow((void **) &idx->blocks, &idx->maxblocks,
+		      (e->nwords >> 1) + 1, sizeof(faV3IndexBlock_t)) != OK) ||
+     (faV3EvBuildGrow((void **) &idx->events, &idx->maxevents,
+		      e->nwords + 1, sizeof(uint32_t)) != OK))
+    return;
+
+  faV3IndexBuild(idx, e->data, e->nwords,
+		 faV3EvBuild.flags & (FAV3_DEC_FLAG_SWAP |
+				      FAV3_DEC_FLAG_SCALAR));
+  faV3EvBuild.nindexerr += idx->nerrors;
+  faV3EvBuild.nbuffers++;
+
+  for(iblk = 0; iblk < idx->nblocks; iblk++)
+    {
+      b = &idx->blocks[iblk];
+      if(b->nevents == 0)
+	continue;
+
+      /* The last event of a block ends at its trailer */
+      if(b->trailer != FAV3_INDEX_NONE)
+	last = b->trailer;
+      else if(iblk + 1 < idx->nblocks)
+	last = idx->blocks[iblk + 1].header;
+      else
+	last = e->nwords;
+
+      for(ievt = b->first_event; ievt < b->first_event + b->nevents; ievt++)
+	{
+	  end = (ievt + 1 < b->first_event + b->nevents) ?
+	    idx->events[ievt + 1] : last;
+	  faV3EvBuildQueue(b->slot, &e->data[idx->events[ievt]],
+			   end - idx->events[ievt], seq);
+	}
+    }
+}
+
+/* Give back the buffers that no queued event points into */
+static void
+faV3EvBuildRelease()
+{
+  faV3EvBuildFifo_t *f;
+  faV3EvBuildEntry_t *e;
+  uint32_t upto = faV3EvBuild.parse, seq, tail = faV3EvBuild.tail;
+  int32_t slot;
+
+  for(slot = 0; slot < 32; slot++)
+    {
+      if(!(faV3EvBuild.have & (1u << slot)))
+	continue;
+      f = &faV3EvBuild.fifo[slot];
+      seq = f->seq[f->first & (faV3EvBuild.fifo_size - 1)];
+      if((int32_t) (seq - upto) < 0)
+	upto = seq;
+    }
+
+  while(tail != upto)
+    {
+      e = &faV3EvBuild.entry[tail & (faV3EvBuild.nbuf - 1)];
+      if(e->done)
+	(*e->done) (e->data, e->arg);
+      tail++;
+      __atomic_store_n(&faV3EvBuild.tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+/* Send out everything queued, complete or not */
+static void
+faV3EvBuildFlushAll()
+{
+  while(faV3EvBuild.have)
+    faV3EvBuildEmit(1);
+  faV3EvBuildRelease();
+}
+
+/* Copy the statistics for the Get and Status routines */
+static void
+faV3EvBuildPublish()
+{
+  faV3EvBuildStats_t *pub = &faV3EvBuild.pub;
+  int32_t slot;
+
+  EVBLOCK;
+  pub->slotmask = faV3EvBuild.slotmask;
+  pub->learn = faV3EvBuild.learn;
+  pub->nbuffers = faV3EvBuild.nbuffers;
+  pub->nevents = faV3EvBuild.nevents;
+  pub->nincomplete = faV3EvBuild.nincomplete;
+  pub->nmismatch = faV3EvBuild.nmismatch;
+  pub->nforced = faV3EvBuild.nforced;
+  pub->ndropped = faV3EvBuild.ndropped;
+  pub->nindexerr = faV3EvBuild.nindexerr;
+  for(slot = 0; slot < 32; slot++)
+    pub->slot[slot] = faV3EvBuild.fifo[slot].stats;
+  EVBUNLOCK;
+}
+
+/* Build from the buffers pushed since the last call.  Returns the number of
+   buffers taken. */
+static int32_t
+faV3EvBuildProcess()
+{
+  /* Buffers pushed before a flush request are built before the flush */
+  int32_t flush = __atomic_load_n(&faV3EvBuild.flushreq, __ATOMIC_SEQ_CST);
+  uint32_t head = __atomic_load_n(&faV3EvBuild.head, __ATOMIC_ACQUIRE);
+  int32_t n = 0;
+
+  while(faV3EvBuild.parse != head)
+    {
+      faV3EvBuildParse(faV3EvBuild.parse);
+      faV3EvBuild.parse++;
+      faV3EvBuildReady();
+      faV3EvBuildRelease();
+      n++;
+    }
+
+  /* Published before the flush is done, so faV3EvBuildFlush returns with
+     the statistics up to date */
+  if(flush)
+    {
+      faV3EvBuildFlushAll();
+      faV3EvBuildPublish();
+      __atomic_store_n(&faV3EvBuild.flushreq, 0, __ATOMIC_SEQ_CST);
+    }
+  else if(n > 0)
+    faV3EvBuildPublish();
+
+  return n;
+}
+
+static void *
+faV3EvBuildThread(void *arg)
+{
+  struct timespec ts;
+  int32_t idle = 0;
+
+  while(!faV3EvBuild.quit)
+    {
+      if(faV3EvBuildProcess() > 0)
+	{
+	  idle = 0;
+	  continue;
+	}
+
+      if(++idle < FAV3_EVB_SPIN)
+	{
+	  sched_yield();
+	  continue;
+	}
+
+      /* Push checks sleeping after it moves head, so one of the two sees
+         the other */
+      EVBLOCK;
+      __atomic_store_n(&faV3EvBuild.sleeping, 1, __ATOMIC_SEQ_CST);
+      if((__atomic_load_n(&faV3EvBuild.head, __ATOMIC_SEQ_CST) ==
+	  faV3EvBuild.parse) && !faV3EvBuild.quit &&
+	 !__atomic_load_n(&faV3EvBuild.flushreq, __ATOMIC_SEQ_CST))
+	{
+	  clock_gettime(CLOCK_REALTIME, &ts);
+	  ts.tv_nsec += FAV3_EVB_SLEEP_US * 1000;
+	  if(ts.tv_nsec >= 1000000000)
+	    {
+	      ts.tv_sec++;
+	      ts.tv_nsec -= 1000000000;
+	    }
+	  pthread_cond_timedwait(&faV3EvBuildCond, &faV3EvBuildMutex, &ts);
+	}
+      __atomic_store_n(&faV3EvBuild.sleeping, 0, __ATOMIC_SEQ_CST);
+      EVBUNLOCK;
+      idle = 0;
+    }
+
+  return NULL;
+}
+
+static void
+faV3EvBuildWake()
+{
+  if(__atomic_load_n(&faV3EvBuild.sleeping, __ATOMIC_SEQ_CST))
+    {
+      EVBLOCK;
+      pthread_cond_signal(&faV3EvBuildCond);
+      EVBUNLOCK;
+    }
+}
+
+static void
+faV3EvBuildFree()
+{
+  free(faV3EvBuild.entry);
+  free(faV3EvBuild.evmem);
+  free(faV3EvBuild.seqmem);
+  free(faV3EvBuild.idx.blocks);
+  free(faV3EvBuild.idx.events);
+  memset(&faV3EvBuild, 0, sizeof(faV3EvBuild));
+}
+
+/**
+ * @brief Create the event builder
+ *
+ *   cb is called for each event, in trigger number order, from the builder
+ *   thread (FAV3_EVB_FLAG_THREAD) or from faV3EvBuildPoll.  Event data
+ *   pointers are valid only during the call.
+ *
+ * @param slotmask Slots expected in every event.  If 0, the slots that
+ *                 send data before any slot is into its second block.
+ * @param block_level Largest block level of the boards
+ *                    (1 - FAV3_EVB_MAX_BLOCKLEVEL)
+ * @param nbuf Buffers that may be pushed and not yet given back
+ *             (1 - FAV3_EVB_MAX_BUFFERS)
+ * @param cb Routine called for each event
+ * @param arg Argument passed to cb
+ * @param flags FAV3_EVB_FLAG_THREAD, and FAV3_DEC_FLAG_SWAP for big-endian
+ *              data
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3EvBuildCreate(uint32_t slotmask, int32_t block_level, int32_t nbuf,
+		  faV3EvBuildCallback_t cb, void *arg, uint32_t flags)
+{
+  uint32_t n, slot;
+
+  if((block_level <= 0) || (block_level > FAV3_EVB_MAX_BLOCKLEVEL))
+    {
+      printf("%s: ERROR: Invalid block level (%d)\n", __func__, block_level);
+      return ERROR;
+    }
+
+  if((nbuf <= 0) || (nbuf > FAV3_EVB_MAX_BUFFERS))
+    {
+      printf("%s: ERROR: Invalid number of buffers (%d)\n", __func__, nbuf);
+      return ERROR;
+    }
+
+  if(cb == NULL)
+    {
+      printf("%s: ERROR: No event routine\n", __func__);
+      return ERROR;
+    }
+
+  EVBLOCK;
+  if(faV3EvBuild.created)
+    {
+      printf("%s: ERROR: Event builder already created\n", __func__);
+      EVBUNLOCK;
+      return ERROR;
+    }
+
+  memset(&faV3EvBuild, 0, sizeof(faV3EvBuild));
+
+  /* Both rings are indexed with a mask */
+  for(n = 1; n < (uint32_t) nbuf; n <<= 1);
+  faV3EvBuild.nbuf = n;
+  for(n = 1; n < (uint32_t) (2 * block_level); n <<= 1);
+  faV3EvBuild.fifo_size = n;
+
+  faV3EvBuild.entry = calloc(faV3EvBuild.nbuf, sizeof(faV3EvBuildEntry_t));
+  faV3EvBuild.evmem = calloc(32 * faV3EvBuild.fifo_size,
+			     sizeof(faV3EvBuildSlot_t));
+  faV3EvBuild.seqmem = calloc(32 * faV3EvBuild.fifo_size, sizeof(uint32_t));
+  if(!faV3EvBuild.entry || !faV3EvBuild.evmem || !faV3EvBuild.seqmem)
+    {
+      printf("%s: ERROR: Unable to allocate queues\n", __func__);
+      faV3EvBuildFree();
+      EVBUNLOCK;
+      return ERROR;
+    }
+
+  for(slot = 0; slot < 32; slot++)
+    {
+      faV3EvBuild.fifo[slot].ev = &faV3EvBuild.evmem[slot * faV3EvBuild.fifo_size];
+      faV3EvBuild.fifo[slot].seq = &faV3EvBuild.seqmem[slot * faV3EvBuild.fifo_size];
+      faV3EvBuild.fifo[slot].time = FAV3_EVB_NO_TIME;
+    }
+
+  faV3EvBuild.slotmask = slotmask;
+  faV3EvBuild.learn = (slotmask == 0);
+  faV3EvBuild.block_level = block_level;
+  faV3EvBuild.cb = cb;
+  faV3EvBuild.arg = arg;
+  faV3EvBuild.flags = flags;
+  faV3EvBuild.created = 1;
+
+  if(flags & FAV3_EVB_FLAG_THREAD)
+    {
+      if(pthread_create(&faV3EvBuild.thread, NULL, faV3EvBuildThread, NULL)
+	 != 0)
+	{
+	  perror("pthread_create");
+	  printf("%s: ERROR: Unable to start the builder thread\n", __func__);
+	  faV3EvBuildFree();
+	  EVBUNLOCK;
+	  return ERROR;
+	}
+    }
+  EVBUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Stop the event builder and free it
+ *
+ *   Buffers already pushed are built, the events still incomplete are sent
+ *   out, and every buffer is given back.
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3EvBuildDestroy()
+{
+  EVBLOCK;
+  if(!faV3EvBuild.created)
+    {
+      EVBUNLOCK;
+      return OK;
+    }
+
+  faV3EvBuild.quit = 1;
+  pthread_cond_signal(&faV3EvBuildCond);
+  EVBUNLOCK;
+
+  if(faV3EvBuild.flags & FAV3_EVB_FLAG_THREAD)
+    pthread_join(faV3EvBuild.thread, NULL);
+
+  /* Nothing else builds now */
+  faV3EvBuildProcess();
+  faV3EvBuildFlushAll();
+
+  EVBLOCK;
+  faV3EvBuildFree();
+  EVBUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Hand a buffer to the event builder
+ *
+ *   Does not lock or copy, and may be called from one thread only (the
+ *   readout thread).  The buffer must not be changed until done is
+ *   called, from the builder.
+ *
+ * @param data Data (e.g. from faV3ReadBlock or a faV3RingBuf_t)
+ * @param nwords Number of words in data
+ * @param done Routine called when the builder is done with data, or NULL
+ * @param arg Argument passed to done
+ * @return OK if successful, ERROR if the queue is full (the builder is
+ *         behind) or the builder is not created
+ */
+int32_t
+faV3EvBuildPush(const uint32_t * data, int32_t nwords, faV3EvBuildDone_t done,
+		void *arg)
+{
+  faV3EvBuildEntry_t *e;
+  uint32_t head, tail;
+
+  if(!faV3EvBuild.created)
+    {
+      printf("%s: ERROR: Event builder not created\n", __func__);
+      return ERROR;
+    }
+
+  if(((data == NULL) && (nwords > 0)) || (nwords < 0))
+    return ERROR;
+
+  head = faV3EvBuild.head;
+  tail = __atomic_load_n(&faV3EvBuild.tail, __ATOMIC_ACQUIRE);
+  if(head - tail >= faV3EvBuild.nbuf)
+    {
+      /* Only this thread writes it */
+      __atomic_store_n(&faV3EvBuild.nfull, faV3EvBuild.nfull + 1,
+		       __ATOMIC_RELAXED);
+      return ERROR;
+    }
+
+  e = &faV3EvBuild.entry[head & (faV3EvBuild.nbuf - 1)];
+  e->data = data;
+  e->nwords = nwords;
+  e->done = done;
+  e->arg = arg;
+  __atomic_store_n(&faV3EvBuild.head, head + 1, __ATOMIC_SEQ_CST);
+
+  if(faV3EvBuild.flags & FAV3_EVB_FLAG_THREAD)
+    faV3EvBuildWake();
+
+  return OK;
+}
+
+/**
+ * @brief Build from the buffers pushed so far, on the calling thread
+ *
+ *   Only without FAV3_EVB_FLAG_THREAD.
+ *
+ * @return Number of events sent out, otherwise ERROR
+ */
+int32_t
+faV3EvBuildPoll()
+{
+  uint32_t nevents = faV3EvBuild.nevents;
+
+  if(!faV3EvBuild.created || (faV3EvBuild.flags & FAV3_EVB_FLAG_THREAD))
+    {
+      printf("%s: ERROR: Event builder not created, or has its own thread\n",
+	     __func__);
+      return ERROR;
+    }
+
+  faV3EvBuildProcess();
+
+  return faV3EvBuild.nevents - nevents;
+}
+
+/**
+ * @brief Send out all queued events, complete or not
+ *
+ *   E.g. at the end of a run, for the events of the last block of slots
+ *   that did not send it.  With FAV3_EVB_FLAG_THREAD, waits for the
+ *   builder thread to do it.
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3EvBuildFlush()
+{
+  if(!faV3EvBuild.created)
+    {
+      printf("%s: ERROR: Event builder not created\n", __func__);
+      return ERROR;
+    }
+
+  __atomic_store_n(&faV3EvBuild.flushreq, 1, __ATOMIC_SEQ_CST);
+
+  if(faV3EvBuild.flags & FAV3_EVB_FLAG_THREAD)
+    {
+      faV3EvBuildWake();
+      while(__atomic_load_n(&faV3EvBuild.flushreq, __ATOMIC_SEQ_CST))
+	usleep(100);
+    }
+  else
+    faV3EvBuildProcess();
+
+  return OK;
+}
+
+/**
+ * @brief Return the first trigger number where a slot did not match
+ * @param slot Slot number
+ * @param evt_num Where to put the (extended) trigger number
+ * @return 1 if the slot had a mismatch, 0 if not, otherwise ERROR
+ */
+int32_t
+faV3EvBuildGetFirstTriggerMismatch(int32_t slot, uint32_t * evt_num)
+{
+  int32_t rval;
+
+  if((slot < 0) || (slot >= 32) || (evt_num == NULL))
+    return ERROR;
+
+  EVBLOCK;
+  rval = faV3EvBuild.pub.slot[slot].mismatched;
+  if(rval)
+    *evt_num = faV3EvBuild.pub.slot[slot].first_mismatch;
+  EVBUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief Return the number of triggers where a slot did not match
+ * @param slot Slot number
+ * @return mismatch count, if successful.  Otherwise ERROR
+ */
+uint32_t
+faV3EvBuildGetMismatchTriggerCount(int32_t slot)
+{
+  uint32_t rval;
+
+  if((slot < 0) || (slot >= 32))
+    return ERROR;
+
+  EVBLOCK;
+  rval = faV3EvBuild.pub.slot[slot].nmismatch;
+  EVBUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief Show the state of the event builder
+ * @param pflag Print to standard out if non-zero
+ * @return Number of events sent out
+ */
+int32_t
+faV3EvBuildStatus(int32_t pflag)
+{
+  const faV3EvBuildStats_t *pub = &faV3EvBuild.pub;
+  const faV3EvBuildSlotStats_t *st;
+  int32_t slot, rval;
+
+  EVBLOCK;
+  rval = pub->nevents;
+
+  if(pflag)
+    {
+      printf("faV3EvBuild: %s\n",
+	     faV3EvBuild.created ? "created" : "not created");
+      if(faV3EvBuild.created)
+	{
+	  printf("  Slots       0x%08x%s\n", pub->slotmask,
+		 pub->learn ? "  (still learning)" : "");
+	  printf("  Buffers     %10u pushed  %10u built  (%u queue full)\n",
+		 __atomic_load_n(&faV3EvBuild.head, __ATOMIC_ACQUIRE),
+		 pub->nbuffers,
+		 __atomic_load_n(&faV3EvBuild.nfull, __ATOMIC_RELAXED));
+	  printf("  Events      %10u  (incomplete %u, forced out %u)\n",
+		 pub->nevents, pub->nincomplete, pub->nforced);
+	  printf("  Mismatched  %10u\n", pub->nmismatch);
+	  printf("  Index errors %9u  dropped %u\n", pub->nindexerr,
+		 pub->ndropped);
+	  printf("  Slot      Events     Missing  Mismatched        Late"
+		 "  First Mismatch\n");
+	  for(slot = 0; slot < 32; slot++)
+	    {
+	      if(!(pub->slotmask & (1u << slot)))
+		continue;
+	      st = &pub->slot[slot];
+	      printf("  %4d  %10u  %10u  %10u  %10u", slot, st->nevents,
+		     st->nmissing, st->nmismatch, st->nlate);
+	      if(st->mismatched)
+		printf("  %10u", st->first_mismatch);
+	      printf("\n");
+	    }
+	}
+    }
+  EVBUNLOCK;
+
+  return rval;
+}
@@ -0,0 +1,60 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3EvBuild.h
+ *
+ * @brief     Header for the cross-slot event builder
+ *
+ */
+
+#include <stdint.h>
+
+#define FAV3_EVB_MAX_BUFFERS    1024
+#define FAV3_EVB_MAX_BLOCKLEVEL 255	/* block header event count is 8 bits */
+#define FAV3_EVB_NO_TIME        0xFFFFFFFFFFFFFFFFULL
+
+/* Create flags.  FAV3_DEC_FLAG_SWAP and FAV3_DEC_FLAG_SCALAR may be added
+   for the buffer index. */
+#define FAV3_EVB_FLAG_THREAD    (1 << 8)	/* build on a thread of its own,
+						   otherwise in faV3EvBuildPoll */
+
+/* One slot's part of an event */
+typedef struct faV3EvBuildSlot_struct
+{
+  uint32_t evt_num;		/* trigger number, extended past 12 bits */
+  uint64_t time;		/* 48 bit trigger time, or FAV3_EVB_NO_TIME */
+  const uint32_t *data;		/* event header in the pushed buffer */
+  int32_t nwords;		/* words up to the next event or the trailer */
+} faV3EvBuildSlot_t;
+
+/* One trigger, assembled across slots */
+typedef struct faV3EvBuildEvent_struct
+{
+  uint32_t evt_num;		/* trigger number, extended past 12 bits */
+  uint64_t time;		/* trigger time of the lowest slot */
+  uint32_t slotmask;		/* slots with data for this trigger */
+  uint32_t missing;		/* expected slots without data */
+  uint32_t mismatch;		/* slots with a different trigger time, or
+				   that skipped this trigger number */
+  faV3EvBuildSlot_t slot[32];	/* indexed by slot number */
+} faV3EvBuildEvent_t;
+
+typedef void (*faV3EvBuildCallback_t) (const faV3EvBuildEvent_t * evt,
+				       void *arg);
+/* Called when the builder no longer needs a pushed buffer */
+typedef void (*faV3EvBuildDone_t) (const uint32_t * data, void *arg);
+
+int32_t faV3EvBuildCreate(uint32_t slotmask, int32_t block_level,
+			  int32_t nbuf, faV3EvBuildCallback_t cb, void *arg,
+			  uint32_t flags);
+int32_t faV3EvBuildDestroy();
+int32_t faV3EvBuildPush(const uint32_t * data, int32_t nwords,
+			faV3EvBuildDone_t done, void *arg);
+int32_t faV3EvBuildPoll();
+int32_t faV3EvBuildFlush();
+int32_t faV3EvBuildGetFirstTriggerMismatch(int32_t slot, uint32_t * evt_num);
+uint32_t faV3EvBuildGetMismatchTriggerCount(int32_t slot);
+int32_t faV3EvBuildStatus(int32_t pflag);
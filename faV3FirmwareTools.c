@@ -15,13 +15,20 @@
 #include <string.h>
 #include <ctype.h>
 #include <byteswap.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAV3_FW_X86
+#endif
 #include "faV3Lib.h"
 #include "faV3FirmwareTools.h"
 
-extern pthread_mutex_t faV3Mutex;
+extern pthread_mutex_t faV3SlotMutex[FAV3_MAX_BOARDS + 2];
 
-#define FAV3LOCK      if(pthread_mutex_lock(&faV3Mutex)<0) perror("pthread_mutex_lock");
-#define FAV3UNLOCK    if(pthread_mutex_unlock(&faV3Mutex)<0) perror("pthread_mutex_unlock");
+#define FAV3SLOTLOCK(_id)   if(pthread_mutex_lock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_lock");
+#define FAV3SLOTUNLOCK(_id) if(pthread_mutex_unlock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_unlock");
 
 extern int32_t nfaV3;
 extern int32_t faV3ID[FAV3_MAX_BOARDS];
@@ -47,6 +54,7 @@ const uint8_t ConfigRom_RDSR1 = 0x05;  // Read status register 1
 const uint8_t ConfigRom_WRDI = 0x04;  // Disable write to ROM non-Volatile memory
 const uint8_t ConfigRom_WREN = 0x06;  // Enable write to ROM non-Volatilde memory
 const uint8_t ConfigRom_BE = 0x60;   // BULK Erase
+const uint8_t ConfigRom_SE = 0xDC;   // Sector Erase, 4 byte address
 const uint8_t ConfigRom_PP4 = 0x12;   // Write to ROM volatalile memory. Content store to ROM on rising edge of ROM CSN
 const uint8_t ConfigRom_AREAD = 0X13;   // Read FLASH Array Low memory then higher memory
 const uint32_t ConfigRom_SR1V_WEL   = 2; // Write Enable Latch 1= Can write to memory, registers
@@ -55,9 +63,21 @@ const uint32_t ConfigRomReadyForCommand = 0x2;
 const uint32_t ConfigRomRebootFPGA = (1 << 11);
 
 #define MAX_FW_SIZE 0x1800000
+#ifndef FAV3_FW_SIZE
 #define FAV3_FW_SIZE 0x1701DEC
+#endif
 #define FAV3_FIRMWARE_WAIT 200
 
+/* Program page, and erase sector (S25FL256S, uniform 256 kB sectors) */
+#define FAV3_FW_PAGE_SIZE 256
+#define FAV3_FW_PAGE_WORDS (FAV3_FW_PAGE_SIZE >> 2)
+#ifndef FAV3_FW_SECTOR_SIZE
+#define FAV3_FW_SECTOR_SIZE 0x40000
+#endif
+#define FAV3_FW_SECTOR_PAGES (FAV3_FW_SECTOR_SIZE / FAV3_FW_PAGE_SIZE)
+#define FAV3_FW_NSECTORS (MAX_FW_SIZE / FAV3_FW_SECTOR_SIZE)
+#define FAV3_FW_SECTOR(_romadr) ((_romadr) / FAV3_FW_SECTOR_SIZE)
+
 #define VME_CONFIG6_ADR &FAV3p[id]->config_rom_control0
 #define VME_CONFIG7_ADR &FAV3p[id]->config_rom_control1
 #define VME_CONFIG8_ADR &FAV3p[id]->config_rom_control2
@@ -68,11 +88,22 @@ typedef struct {
   int32_t loaded;
   uint32_t size;
   uint32_t data[MAX_FW_SIZE>>2];
+  uint32_t npages;		/* pages written, with the trailing word */
+  uint32_t pagesum[MAX_FW_SIZE / FAV3_FW_PAGE_SIZE];
+  uint64_t hash;		/* of the page checksums */
+  struct stat st;		/* of the file read, to find it unchanged */
 } faV3fw_t;
 
 faV3fw_t *file_firmware = NULL;
 faV3fw_t *rom_firmware = NULL;
 
+/* Sectors of each ROM already the same as the file, from
+   faV3FirmwareScanRom.  These are not erased, programmed or verified. */
+static uint8_t fwSectorSame[FAV3_MAX_BOARDS + 1][FAV3_FW_NSECTORS];
+
+/* Erase and program only the sectors that differ, unless this is 0 */
+static int32_t fwIncremental = 1;
+
 VOIDFUNCPTR faV3UpdateWatcherRoutine = NULL;
 faV3UpdateWatcherArgs_t faV3UpdateWatcherArgs;
 
@@ -91,9 +122,9 @@ faV3FirmwareWaitForReady(int32_t id, int32_t nwait, int32_t pflag)
 
   while( ((regval & ConfigRomReadyForCommand)==0) && (iwait++ < nwait) )
     {
-      FAV3LOCK;
+      FAV3SLOTLOCK(id);
       regval = vmeRead32(&FAV3p[id]->config_rom_status1);
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
     }
 
   if(regval & ConfigRomReadyForCommand)
@@ -189,7 +220,7 @@ faV3FirmwareRomID(int32_t id)
   WAITFORREADY;
   cmd = ConfigRomHostEndOfCmd | ConfigRom_RDID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   cmd = ConfigRomHostExec | cmd;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Execute Command
@@ -197,13 +228,13 @@ faV3FirmwareRomID(int32_t id)
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   WAITFORREADY;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(VME_STATUS5_ADR);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -224,7 +255,7 @@ faV3FirmwareRomStatus1(int32_t id)
   WAITFORREADY;
   cmd = ConfigRomHostEndOfCmd | ConfigRom_RDSR1;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
 
   cmd = ConfigRomHostExec | cmd;
@@ -232,13 +263,13 @@ faV3FirmwareRomStatus1(int32_t id)
 
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   WAITFORREADY;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(VME_STATUS5_ADR);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -265,7 +296,7 @@ faV3FirmwareSetMemoryWrite(int32_t id, int32_t enable)
   else
     cmd = ConfigRomHostEndOfCmd | ConfigRom_WRDI;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
 
   cmd = ConfigRomHostExec | cmd;
@@ -273,14 +304,14 @@ faV3FirmwareSetMemoryWrite(int32_t id, int32_t enable)
 
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   WAITFORREADY;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(!enable)
     rval = vmeRead32(VME_STATUS5_ADR);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(enable)
     rval = faV3FirmwareRomStatus1(id) & ConfigRom_SR1V_WEL;
@@ -313,7 +344,7 @@ faV3FirmwareRomErase(int32_t id, int32_t waitforWIP)
   WAITFORREADY;
   cmd = ConfigRomHostEndOfCmd | ConfigRom_BE;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
 
   cmd = ConfigRomHostExec | cmd;
@@ -321,7 +352,10 @@ faV3FirmwareRomErase(int32_t id, int32_t waitforWIP)
 
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
+
+  /* Every sector has to be programmed again */
+  memset(fwSectorSame[id], 0, sizeof(fwSectorSame[id]));
 
   if(waitforWIP)
     {
@@ -342,26 +376,69 @@ faV3FirmwareRomErase(int32_t id, int32_t waitforWIP)
 }
 
 /**
- * @brief Read the contents of the ROM at specified address
- * @param[in] id faV3 slot ID
- * @param[in] romadr ROM Address
- * @param[in] last Whether or not this is the end of the page
- * @return Data from ROM, if successful
+ * @brief Erase one sector of the ROM
+ * @param[in] id faV3 Slot ID
+ * @param[in] romadr ROM Address in the sector
+ * @param[in] waitforWIP Wait for the erase to finish, if non-zero
+ * @return OK if successful, otherwise ERROR
  */
 
 int32_t
-faV3FirmwareReadRomAdr(int32_t id, uint32_t romadr, int32_t last)
+faV3FirmwareRomSectorErase(int32_t id, uint32_t romadr, int32_t waitforWIP)
 {
-  uint32_t rval;
-  uint32_t cmd, romdata = 0;
+  int32_t rval;
+  uint32_t cmd;
   CHECKID;
 
+  rval = faV3FirmwareSetMemoryWrite(id, 1);
+  if(rval == 0)
+    {
+      printf("%s: ERROR: Write not enabled for romadr = 0x%x\n",
+	     __func__, romadr);
+      return ERROR;
+    }
+
+  WAITFORREADY;
+  cmd = ConfigRomHostEndOfCmd | ConfigRom_SE;
+
+  FAV3SLOTLOCK(id);
+  vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
+  vmeWrite32(VME_CONFIG7_ADR, romadr);	// Rom Address
+
+  cmd = ConfigRomHostExec | cmd;
+  vmeWrite32(VME_CONFIG6_ADR, cmd);	// Execute Command
+
+  cmd = cmd & ~ConfigRomHostExec;
+  vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
+  FAV3SLOTUNLOCK(id);
+
+  if(waitforWIP)
+    {
+      /* Sector erase is typically 0.5 s, 2.6 s max */
+      if(faV3FirmwareWaitForWIP(id, 5000, 0) < 0)
+	{
+	  printf("%s: Failed to erase Config ROM sector 0x%x.  romstatus1 = 0x%08x\n",
+		 __func__, romadr, faV3FirmwareRomStatus1(id));
+	  return ERROR;
+	}
+    }
+
+  return OK;
+}
+
+/* Start a ROM read.  The data is taken with faV3FirmwareReadRomResult,
+   so reads of other boards can go in between. */
+static int32_t
+faV3FirmwareReadRomIssue(int32_t id, uint32_t romadr, int32_t last)
+{
+  uint32_t cmd;
+
   WAITFORREADY;
   cmd = ConfigRom_AREAD;
   if(last)
     cmd |= ConfigRomHostEndOfCmd;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
   vmeWrite32(VME_CONFIG7_ADR, romadr);	// Rom Address
 
@@ -370,32 +447,53 @@ faV3FirmwareReadRomAdr(int32_t id, uint32_t romadr, int32_t last)
 
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
+
+  return OK;
+}
 
+static int32_t
+faV3FirmwareReadRomResult(int32_t id, uint32_t *romdata)
+{
   WAITFORREADY;
 
-  FAV3LOCK;
-  rval = vmeRead32(VME_STATUS5_ADR);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  *romdata = vmeRead32(VME_STATUS5_ADR);
+  FAV3SLOTUNLOCK(id);
 
-  return rval;
+  return OK;
 }
 
 /**
- * @brief Write data to the ROM at specified address
+ * @brief Read the contents of the ROM at specified address
  * @param[in] id faV3 slot ID
  * @param[in] romadr ROM Address
- * @param[in] romdata Data to write
  * @param[in] last Whether or not this is the end of the page
- * @return 0
+ * @return Data from ROM, if successful
  */
 
 int32_t
-faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t last)
+faV3FirmwareReadRomAdr(int32_t id, uint32_t romadr, int32_t last)
+{
+  uint32_t rval;
+  CHECKID;
+
+  if(faV3FirmwareReadRomIssue(id, romadr, last) != OK)
+    return ERROR;
+
+  if(faV3FirmwareReadRomResult(id, &rval) != OK)
+    return ERROR;
+
+  return rval;
+}
+
+/* Write a ROM word, without waiting for the end of page to be
+   programmed.  Returns -1 or ERROR if it failed. */
+static int32_t
+faV3FirmwareWriteRomWord(int32_t id, uint32_t romadr, uint32_t romdata, int32_t last)
 {
   int32_t rval = 0;
   uint32_t cmd;
-  CHECKID;
 
   WAITFORREADY;
 
@@ -414,7 +512,7 @@ faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t l
   if(last)
     cmd |= ConfigRomHostEndOfCmd;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Rom Command
   vmeWrite32(VME_CONFIG7_ADR, romadr);	// Rom Address
   vmeWrite32(VME_CONFIG8_ADR, romdata);	// Rom Data
@@ -425,7 +523,29 @@ faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t l
   cmd = cmd & ~ConfigRomHostExec;
   vmeWrite32(VME_CONFIG6_ADR, cmd);	// Ready for Next Command
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
+
+  return rval;
+}
+
+/**
+ * @brief Write data to the ROM at specified address
+ * @param[in] id faV3 slot ID
+ * @param[in] romadr ROM Address
+ * @param[in] romdata Data to write
+ * @param[in] last Whether or not this is the end of the page
+ * @return 0
+ */
+
+int32_t
+faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t last)
+{
+  int32_t rval = 0;
+  CHECKID;
+
+  rval = faV3FirmwareWriteRomWord(id, romadr, romdata, last);
+  if(rval < 0)
+    return rval;
 
   if(last)
     {
@@ -435,6 +555,97 @@ faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t l
   return rval;
 }
 
+/* Word of the image as programmed: the file, the 0xFFFFFFFF written
+   after it, then erased ROM */
+static inline uint32_t
+faV3FirmwareImageWord(const faV3fw_t *fw, uint32_t idata)
+{
+  return (idata < fw->size) ? fw->data[idata] : 0xFFFFFFFF;
+}
+
+/* Page checksum, FNV-1a over the 32 bit words */
+#define FAV3_FW_SUM_INIT 0x811C9DC5
+static inline uint32_t
+faV3FirmwareSumWord(uint32_t sum, uint32_t word)
+{
+  return (sum ^ word) * 0x01000193;
+}
+
+static void
+faV3FirmwareSumPages(faV3fw_t *fw)
+{
+  uint32_t ipage, iword, sum, s0, s1, s2, s3, nfull;
+  const uint32_t *p;
+
+  fw->npages = ((fw->size + 1) + FAV3_FW_PAGE_WORDS - 1) / FAV3_FW_PAGE_WORDS;
+
+  /* Four pages of the file at a time, so that their checksums (each a
+     chain of multiplies) are computed side by side */
+  nfull = (fw->size / FAV3_FW_PAGE_WORDS) & ~3;
+  for(ipage = 0; ipage < nfull; ipage += 4)
+    {
+      p = &fw->data[ipage * FAV3_FW_PAGE_WORDS];
+      s0 = s1 = s2 = s3 = FAV3_FW_SUM_INIT;
+      for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+	{
+	  s0 = faV3FirmwareSumWord(s0, p[iword]);
+	  s1 = faV3FirmwareSumWord(s1, p[iword + FAV3_FW_PAGE_WORDS]);
+	  s2 = faV3FirmwareSumWord(s2, p[iword + 2 * FAV3_FW_PAGE_WORDS]);
+	  s3 = faV3FirmwareSumWord(s3, p[iword + 3 * FAV3_FW_PAGE_WORDS]);
+	}
+      fw->pagesum[ipage] = s0;
+      fw->pagesum[ipage + 1] = s1;
+      fw->pagesum[ipage + 2] = s2;
+      fw->pagesum[ipage + 3] = s3;
+    }
+
+  for(ipage = nfull; ipage < fw->npages; ipage++)
+    {
+      sum = FAV3_FW_SUM_INIT;
+      for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+	sum = faV3FirmwareSumWord(sum,
+				  faV3FirmwareImageWord(fw, ipage * FAV3_FW_PAGE_WORDS + iword));
+      fw->pagesum[ipage] = sum;
+    }
+
+  /* 64 bit FNV-1a over the page checksums, to name the image */
+  fw->hash = 0xCBF29CE484222325ULL;
+  for(ipage = 0; ipage < fw->npages; ipage++)
+    fw->hash = (fw->hash ^ fw->pagesum[ipage]) * 0x100000001B3ULL;
+}
+
+/* Read back a page of the ROM, and return its checksum.  Progress is
+   shown for each word, as with faV3FirmwareDownloadRom. */
+static int32_t
+faV3FirmwareReadPageSum(int32_t id, uint32_t ipage, uint32_t *sum,
+			faV3UpdateWatcherArgs_t updateArgs)
+{
+  uint32_t idata, iword, romdata;
+
+  *sum = FAV3_FW_SUM_INIT;
+  for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+    {
+      idata = ipage * FAV3_FW_PAGE_WORDS + iword;
+      if(faV3FirmwareReadRomIssue(id, idata << 2,
+				  (idata & (256 >> 2)) == (256 >> 2)) != OK)
+	return ERROR;
+      if(faV3FirmwareReadRomResult(id, &romdata) != OK)
+	return ERROR;
+      *sum = faV3FirmwareSumWord(*sum, romdata);
+
+      faV3FirmwareUpdateWatcher(updateArgs);
+    }
+
+  return OK;
+}
+
+/* Whether the word is in a sector that is already the same as the file */
+static inline int32_t
+faV3FirmwareSectorSame(int32_t id, uint32_t idata)
+{
+  return fwSectorSame[id][FAV3_FW_SECTOR(idata << 2)];
+}
+
 /**
  * @brief Download the contents of the ROM to local memory
  * @param[in] id faV3 slot ID
@@ -511,7 +722,8 @@ faV3FirmwareProgramRom(int32_t id)
       else
 	last_of_page = 0;
 
-      faV3FirmwareWriteRomAdr(id, romadr, file_firmware->data[idata], last_of_page);
+      if(!faV3FirmwareSectorSame(id, idata))
+	faV3FirmwareWriteRomAdr(id, romadr, file_firmware->data[idata], last_of_page);
 
       idata++;
 
@@ -519,11 +731,149 @@ faV3FirmwareProgramRom(int32_t id)
 
     }
   romadr = idata << 2;
-  faV3FirmwareWriteRomAdr(id, romadr, 0xFFFFFFFF, 1);
+  if(!faV3FirmwareSectorSame(id, idata))
+    faV3FirmwareWriteRomAdr(id, romadr, 0xFFFFFFFF, 1);
+
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+
+  return OK;
+}
+
+/**
+ * @brief Find the sectors of the ROM that differ from the file
+ *
+ *   The ROM is read back a page at a time and compared with the page
+ *   checksums of the file.  The rest of a sector is skipped after its
+ *   first page that differs, so only the sectors that are the same are
+ *   read in full.  Those are then left alone by faV3FirmwareProgramRom
+ *   and faV3FirmwareVerifyRom, until the next faV3FirmwareRomErase.
+ *
+ * @param[in] id faV3 slot ID
+ * @return Number of sectors that differ, otherwise ERROR
+ */
+int32_t
+faV3FirmwareScanRom(int32_t id)
+{
+  uint32_t isector, nsectors, ipage, lastpage, sum;
+  int32_t same, ndiff = 0;
+  faV3UpdateWatcherArgs_t updateArgs;
+  CHECKID;
+
+  if((file_firmware == NULL) || (file_firmware->loaded != 1))
+    {
+      printf("%s: ERROR : Firmware was not loaded\n", __func__);
+      return ERROR;
+    }
+
+  memset(fwSectorSame[id], 0, sizeof(fwSectorSame[id]));
+
+  nsectors = (file_firmware->npages + FAV3_FW_SECTOR_PAGES - 1) /
+    FAV3_FW_SECTOR_PAGES;
+
+  updateArgs.step = FAV3_UPDATE_STEP_DOWNLOAD;
+  updateArgs.show = FAV3_ARGS_SHOW_PROGRESS;
+  for(isector = 0; isector < nsectors; isector++)
+    {
+      lastpage = (isector + 1) * FAV3_FW_SECTOR_PAGES;
+      if(lastpage > file_firmware->npages)
+	lastpage = file_firmware->npages;
+
+      same = 1;
+      for(ipage = isector * FAV3_FW_SECTOR_PAGES;
+	  same && (ipage < lastpage); ipage++)
+	{
+	  if(faV3FirmwareReadPageSum(id, ipage, &sum, updateArgs) != OK)
+	    return ERROR;
+
+	  if(sum != file_firmware->pagesum[ipage])
+	    same = 0;
+	}
+
+      fwSectorSame[id][isector] = same;
+      if(!same)
+	ndiff++;
+    }
+
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+
+  return ndiff;
+}
+
+/* Erase the sectors that differ, from faV3FirmwareScanRom */
+static int32_t
+faV3FirmwareEraseSectors(int32_t id)
+{
+  uint32_t isector, nsectors;
+
+  nsectors = (file_firmware->npages + FAV3_FW_SECTOR_PAGES - 1) /
+    FAV3_FW_SECTOR_PAGES;
+
+  for(isector = 0; isector < nsectors; isector++)
+    {
+      if(fwSectorSame[id][isector])
+	continue;
+
+      if(faV3FirmwareRomSectorErase(id, isector * FAV3_FW_SECTOR_SIZE, 1) != OK)
+	return ERROR;
+    }
+
+  return OK;
+}
+
+/**
+ * @brief Verify the programmed sectors of the ROM with the file
+ *
+ *   Each page is read back and its checksum compared with that of the
+ *   file, so no copy of the ROM is kept.
+ *
+ * @param[in] id faV3 slot ID
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3FirmwareVerifyRom(int32_t id)
+{
+  uint32_t ipage, sum;
+  int32_t errorCount = 0;
+  faV3UpdateWatcherArgs_t updateArgs;
+  CHECKID;
+
+  if((file_firmware == NULL) || (file_firmware->loaded != 1))
+    {
+      printf("%s: ERROR : File Firmware was not loaded\n", __func__);
+      return ERROR;
+    }
+
+  updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
+  updateArgs.show = FAV3_ARGS_SHOW_PROGRESS;
+  for(ipage = 0; ipage < file_firmware->npages; ipage++)
+    {
+      if(fwSectorSame[id][ipage / FAV3_FW_SECTOR_PAGES])
+	continue;
+
+      if(faV3FirmwareReadPageSum(id, ipage, &sum, updateArgs) != OK)
+	return ERROR;
+
+      if(sum != file_firmware->pagesum[ipage])
+	{
+	  errorCount++;
+	  if(errorCount < 16)
+	    printf("%s: ERROR: page 0x%x  File sum 0x%08x  ROM sum 0x%08x\n",
+		   __func__, ipage, file_firmware->pagesum[ipage], sum);
+	}
+    }
 
   updateArgs.show = FAV3_ARGS_SHOW_DONE;
   faV3FirmwareUpdateWatcher(updateArgs);
 
+  if(errorCount)
+    {
+      printf("%s: errorCount = 0x%x (%d) pages\n", __func__,
+	     errorCount, errorCount);
+      return ERROR;
+    }
+
   return OK;
 }
 
@@ -592,9 +942,9 @@ faV3FirmwareReboot(int32_t id)
   int32_t rval = OK;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(VME_CONFIG6_ADR, ConfigRomRebootFPGA);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return rval;
 }
 
@@ -618,9 +968,9 @@ faV3FirmwareWaitForReboot(int32_t id, int32_t nwait, int32_t pflag)
   res = vmeMemProbe((char *) &FAV3p[id]->version, 4, (char *) &rdata);
   while( (res < 0) && (iwait++ < nwait) )
     {
-      FAV3LOCK;
+      FAV3SLOTLOCK(id);
       res = vmeMemProbe((char *) &FAV3p[id]->version, 4, (char *) &rdata);
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       if(res >= 0)
 	if(rdata == -1) res = -1;
       faV3FirmwareUpdateWatcher(updateArgs);
@@ -675,111 +1025,507 @@ faV3FirmwarePassedMask()
   return retMask;
 }
 
-/*************************************************************
- * faV3FirmwareLoad
- *   - main routine to load up firmware for FADC with specific id
+/* faV3FirmwareGLoad programs and verifies all boards together, unless
+   this is 0 */
+static int32_t fwInterleave = 1;
+
+/**
+ * @brief Program and verify the boards together in faV3FirmwareGLoad
  *
- *  NOTE: Make call to
- *     faV3FirmwareSetFilename(...);
- *   if not using firmware from the default
+ *   Each ROM page is written to every board in turn, so while one board
+ *   programs its page the others are using the bus.  Each word is read
+ *   from every board before going on to the next.  With 0, the boards are
+ *   done one after another.
+ *
+ * @param[in] enable 1 (default) to interleave the boards, 0 for one at a time
+ * @return OK
  */
+int32_t
+faV3FirmwareSetInterleave(int32_t enable)
+{
+  fwInterleave = enable ? 1 : 0;
+
+  return OK;
+}
 
+/**
+ * @brief Erase and program only the sectors of the ROM that differ
+ *
+ *   The ROM is first read back and compared, page by page, with the
+ *   checksums of the file (faV3FirmwareScanRom).  Only the sectors that
+ *   differ are erased, programmed and verified.  With 0, the ROM is bulk
+ *   erased and all of it is programmed.
+ *
+ * @param[in] enable 1 (default) for incremental, 0 to program the whole ROM
+ * @return OK
+ */
 int32_t
-faV3FirmwareLoad(int32_t id, int32_t pFlag)
+faV3FirmwareSetIncremental(int32_t enable)
 {
-  faV3UpdateWatcherArgs_t updateArgs;
-  CHECKID;
+  fwIncremental = enable ? 1 : 0;
 
-  if(id==0) id = faV3Slot(id);
-  updateArgs.id = id;
-  updateArgs.step = FAV3_UPDATE_STEP_INIT;
+  return OK;
+}
 
-  /* Perform a hardware and software reset */
-  FAV3LOCK;
-  vmeWrite32(&FAV3p[id]->reset, 0xFFFF);
-  FAV3UNLOCK;
-  taskDelay(60);
+/* Mark a board as failed in fwStatus */
+static void
+faV3FirmwareFailed(int32_t id, int32_t step, const char *what)
+{
+  faV3UpdateWatcherArgs_t updateArgs;
 
+  updateArgs.id = id;
+  updateArgs.step = step;
   updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "Check if ready \n");
+  snprintf(updateArgs.title, sizeof(updateArgs.title),
+	   "ERROR: FAV3 %2d %s\n", id, what);
   faV3FirmwareUpdateWatcher(updateArgs);
 
-  updateArgs.show = FAV3_ARGS_SHOW_ID;
-  faV3FirmwareUpdateWatcher(updateArgs);
+  fwStatus[id].passed = 0;
+  fwStatus[id].stepfail = step;
+}
 
-  /* Check for ROM Ready after reset */
-  if(faV3FirmwareWaitForReady(id, 60, 0) < OK)
+/* Slots not skipped and not failed */
+static int32_t
+faV3FirmwareActiveSlots(int32_t *slots)
+{
+  int32_t ifadc, id, nslots = 0;
+
+  for(ifadc = 0; ifadc < nfaV3; ifadc++)
     {
-      updateArgs.show = FAV3_ARGS_SHOW_STRING;
-      sprintf(updateArgs.title,
-	      "ERROR: FAV3 %2d not ready after reset\n", id);
-      faV3FirmwareUpdateWatcher(updateArgs);
-      return ERROR;
+      id = faV3Slot(ifadc);
+      if(!fwStatus[id].skip && fwStatus[id].passed)
+	slots[nslots++] = id;
     }
 
-  updateArgs.show = FAV3_ARGS_SHOW_DONE;
-  faV3FirmwareUpdateWatcher(updateArgs);
+  return nslots;
+}
 
-  /* ERASE ROM */
-  updateArgs.step = FAV3_UPDATE_STEP_ERASE;
+static void
+faV3FirmwareShowSlots(int32_t step, const char *what, int32_t *slots,
+		      int32_t nslots)
+{
+  faV3UpdateWatcherArgs_t updateArgs;
+  int32_t islot, len;
 
+  updateArgs.id = 0;
+  updateArgs.step = step;
   updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "ERASE ROM \n");
+  len = snprintf(updateArgs.title, sizeof(updateArgs.title), "%s:", what);
+  for(islot = 0; (islot < nslots) && (len < sizeof(updateArgs.title)); islot++)
+    len += snprintf(updateArgs.title + len, sizeof(updateArgs.title) - len,
+		    " %d", slots[islot]);
+  if(len < sizeof(updateArgs.title) - 1)
+    strcat(updateArgs.title, "\n");
+  faV3FirmwareUpdateWatcher(updateArgs);
+}
+
+/* Program the ROMs of all active boards, one page to each board in turn.
+   A board programs its page while the pages of the others are written,
+   so its WIP is checked only before its next page. */
+static void
+faV3FirmwareGProgramRom()
+{
+  int32_t slots[FAV3_MAX_BOARDS + 1], nslots, islot, id, last, nfail;
+  int32_t wip[FAV3_MAX_BOARDS + 1];
+  uint32_t ipage, iword, idata, romdata;
+  faV3UpdateWatcherArgs_t updateArgs;
+
+  nslots = faV3FirmwareActiveSlots(slots);
+  if(nslots == 0)
+    return;
+
+  if((file_firmware == NULL) || (file_firmware->loaded != 1))
+    {
+      printf("%s: ERROR : Firmware was not loaded\n", __func__);
+      for(islot = 0; islot < nslots; islot++)
+	faV3FirmwareFailed(slots[islot], FAV3_UPDATE_STEP_PROGRAM,
+			   "FAILED ROM PROGRAM");
+      return;
+    }
+
+  faV3FirmwareShowSlots(FAV3_UPDATE_STEP_PROGRAM, "Program ROM", slots,
+			nslots);
+
+  memset(wip, 0, sizeof(wip));
+  updateArgs.step = FAV3_UPDATE_STEP_PROGRAM;
+  updateArgs.show = FAV3_ARGS_SHOW_PROGRESS;
+  for(ipage = 0; (ipage < file_firmware->npages) && (nslots > 0); ipage++)
+    {
+      nfail = 0;
+      for(islot = 0; islot < nslots; islot++)
+	{
+	  id = slots[islot];
+	  if(faV3FirmwareSectorSame(id, ipage * FAV3_FW_PAGE_WORDS))
+	    continue;
+
+	  if(wip[id] && (faV3FirmwareWaitForWIP(id, 20, 0) < 0))
+	    {
+	      faV3FirmwareFailed(id, FAV3_UPDATE_STEP_PROGRAM,
+				 "FAILED ROM PROGRAM");
+	      nfail++;
+	      continue;
+	    }
+
+	  /* The word after the image is 0xFFFFFFFF, and ends the last page */
+	  for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+	    {
+	      idata = ipage * FAV3_FW_PAGE_WORDS + iword;
+	      last = (iword == FAV3_FW_PAGE_WORDS - 1) ||
+		(idata == file_firmware->size);
+	      romdata = (idata < file_firmware->size) ?
+		file_firmware->data[idata] : 0xFFFFFFFF;
+
+	      if(faV3FirmwareWriteRomWord(id, idata << 2, romdata, last) < 0)
+		{
+		  faV3FirmwareFailed(id, FAV3_UPDATE_STEP_PROGRAM,
+				     "FAILED ROM PROGRAM");
+		  nfail++;
+		  break;
+		}
+	      if(last)
+		break;
+	    }
+	  wip[id] = 1;
+	}
+
+      for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+	faV3FirmwareUpdateWatcher(updateArgs);
+
+      if(nfail)
+	nslots = faV3FirmwareActiveSlots(slots);
+    }
+
+  /* The last page of each board */
+  for(islot = 0; islot < nslots; islot++)
+    {
+      id = slots[islot];
+      if(wip[id] && (faV3FirmwareWaitForWIP(id, 20, 0) < 0))
+	faV3FirmwareFailed(id, FAV3_UPDATE_STEP_PROGRAM, "FAILED ROM PROGRAM");
+    }
+
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+}
+
+/* Read back the ROMs of all active boards, one word from each board in
+   turn, and compare the page checksums with the file */
+static void
+faV3FirmwareGVerifyRom()
+{
+  int32_t slots[FAV3_MAX_BOARDS + 1], nslots, islot, id, last, nfail;
+  int32_t errorCount[FAV3_MAX_BOARDS + 1];
+  uint32_t sum[FAV3_MAX_BOARDS + 1];
+  uint32_t ipage, iword, idata, romdata;
+  faV3UpdateWatcherArgs_t updateArgs;
+
+  nslots = faV3FirmwareActiveSlots(slots);
+  if(nslots == 0)
+    return;
+
+  if((file_firmware == NULL) || (file_firmware->loaded != 1))
+    {
+      printf("%s: ERROR : File Firmware was not loaded\n", __func__);
+      for(islot = 0; islot < nslots; islot++)
+	faV3FirmwareFailed(slots[islot], FAV3_UPDATE_STEP_VERIFY,
+			   "FAILED ROM DATA VERIFICATION");
+      return;
+    }
+
+  faV3FirmwareShowSlots(FAV3_UPDATE_STEP_VERIFY, "Verify ROM data", slots,
+			nslots);
+
+  memset(errorCount, 0, sizeof(errorCount));
+  updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
+  updateArgs.show = FAV3_ARGS_SHOW_PROGRESS;
+  for(ipage = 0; (ipage < file_firmware->npages) && (nslots > 0); ipage++)
+    {
+      nfail = 0;
+      for(islot = 0; islot < nslots; islot++)
+	sum[slots[islot]] = FAV3_FW_SUM_INIT;
+
+      for(iword = 0; iword < FAV3_FW_PAGE_WORDS; iword++)
+	{
+	  idata = ipage * FAV3_FW_PAGE_WORDS + iword;
+	  last = ((idata & (256 >> 2)) == (256 >> 2));
+
+	  for(islot = 0; islot < nslots; islot++)
+	    {
+	      id = slots[islot];
+	      if(!fwStatus[id].passed || faV3FirmwareSectorSame(id, idata))
+		continue;
+
+	      if(faV3FirmwareReadRomIssue(id, idata << 2, last) != OK)
+		{
+		  faV3FirmwareFailed(id, FAV3_UPDATE_STEP_DOWNLOAD,
+				     "FAILED ROM DATA DOWNLOAD");
+		  nfail++;
+		}
+	    }
+
+	  for(islot = 0; islot < nslots; islot++)
+	    {
+	      id = slots[islot];
+	      if(!fwStatus[id].passed || faV3FirmwareSectorSame(id, idata))
+		continue;
+
+	      if(faV3FirmwareReadRomResult(id, &romdata) != OK)
+		{
+		  faV3FirmwareFailed(id, FAV3_UPDATE_STEP_DOWNLOAD,
+				     "FAILED ROM DATA DOWNLOAD");
+		  nfail++;
+		}
+	      else
+		sum[id] = faV3FirmwareSumWord(sum[id], romdata);
+	    }
+
+	  faV3FirmwareUpdateWatcher(updateArgs);
+	}
+
+      for(islot = 0; islot < nslots; islot++)
+	{
+	  id = slots[islot];
+	  if(!fwStatus[id].passed ||
+	     faV3FirmwareSectorSame(id, ipage * FAV3_FW_PAGE_WORDS))
+	    continue;
+
+	  if(sum[id] != file_firmware->pagesum[ipage])
+	    {
+	      if(++errorCount[id] < 16)
+		printf("%s: ERROR: slot %2d page 0x%x  File sum 0x%08x  ROM sum 0x%08x\n",
+		       __func__, id, ipage, file_firmware->pagesum[ipage], sum[id]);
+	    }
+	}
+
+      if(nfail)
+	nslots = faV3FirmwareActiveSlots(slots);
+    }
+
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+
+  for(islot = 0; islot < nslots; islot++)
+    {
+      id = slots[islot];
+      if(errorCount[id])
+	{
+	  printf("%s: slot %2d errorCount = 0x%x (%d) pages\n", __func__,
+		 id, errorCount[id], errorCount[id]);
+	  faV3FirmwareFailed(id, FAV3_UPDATE_STEP_VERIFY,
+			     "FAILED ROM DATA VERIFICATION");
+	}
+    }
+}
+
+/* Scan the ROMs of all active boards for the sectors that differ from
+   the file, then erase those sectors of all boards together. */
+static void
+faV3FirmwareGEraseSectors()
+{
+  int32_t slots[FAV3_MAX_BOARDS + 1], nslots, islot, id, ndiff, nbusy, iwait;
+  uint32_t isector[FAV3_MAX_BOARDS + 1], nsectors;
+  faV3UpdateWatcherArgs_t updateArgs;
+
+  nslots = faV3FirmwareActiveSlots(slots);
+  if(nslots == 0)
+    return;
+
+  if((file_firmware == NULL) || (file_firmware->loaded != 1))
+    {
+      printf("%s: ERROR : Firmware was not loaded\n", __func__);
+      for(islot = 0; islot < nslots; islot++)
+	faV3FirmwareFailed(slots[islot], FAV3_UPDATE_STEP_ERASE,
+			   "FAILED ROM ERASE");
+      return;
+    }
+
+  nsectors = (file_firmware->npages + FAV3_FW_SECTOR_PAGES - 1) /
+    FAV3_FW_SECTOR_PAGES;
+
+  updateArgs.step = FAV3_UPDATE_STEP_ERASE;
+  for(islot = 0; islot < nslots; islot++)
+    {
+      id = slots[islot];
+      updateArgs.id = id;
+      updateArgs.show = FAV3_ARGS_SHOW_ID;
+      faV3FirmwareUpdateWatcher(updateArgs);
+
+      ndiff = faV3FirmwareScanRom(id);
+      if(ndiff < 0)
+	{
+	  faV3FirmwareFailed(id, FAV3_UPDATE_STEP_DOWNLOAD,
+			     "FAILED ROM DATA DOWNLOAD");
+	  continue;
+	}
+
+      updateArgs.show = FAV3_ARGS_SHOW_STRING;
+      snprintf(updateArgs.title, sizeof(updateArgs.title),
+	       "    %d of %d sectors differ\n", ndiff, nsectors);
+      faV3FirmwareUpdateWatcher(updateArgs);
+
+      isector[id] = 0;
+    }
+
+  /* Start the next sector erase of each board as the last one finishes */
+  nslots = faV3FirmwareActiveSlots(slots);
+  updateArgs.step = FAV3_UPDATE_STEP_ERASE;
+  updateArgs.show = FAV3_ARGS_SHOW_PROGRESS;
+  for(iwait = 0; iwait < 200000; iwait++)
+    {
+      nbusy = 0;
+      for(islot = 0; islot < nslots; islot++)
+	{
+	  id = slots[islot];
+	  if(!fwStatus[id].passed)
+	    continue;
+
+	  if(isector[id] > 0 &&
+	     (faV3FirmwareRomStatus1(id) & ConfigRom_SR1V_WIP))
+	    {
+	      nbusy++;
+	      continue;
+	    }
+
+	  while((isector[id] < nsectors) && fwSectorSame[id][isector[id]])
+	    isector[id]++;
+
+	  if(isector[id] == nsectors)
+	    continue;
+
+	  if(faV3FirmwareRomSectorErase(id, isector[id] * FAV3_FW_SECTOR_SIZE,
+					0) != OK)
+	    {
+	      faV3FirmwareFailed(id, FAV3_UPDATE_STEP_ERASE,
+				 "FAILED TO EXEC ROM ERASE");
+	      continue;
+	    }
+	  isector[id]++;
+	  nbusy++;
+	}
+
+      if(nbusy == 0)
+	break;
+
+      faV3FirmwareUpdateWatcher(updateArgs);
+      usleep(1000);
+    }
+
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+
+  if(nbusy)
+    {
+      for(islot = 0; islot < nslots; islot++)
+	{
+	  id = slots[islot];
+	  if(fwStatus[id].passed &&
+	     ((isector[id] < nsectors) ||
+	      (faV3FirmwareRomStatus1(id) & ConfigRom_SR1V_WIP)))
+	    faV3FirmwareFailed(id, FAV3_UPDATE_STEP_ERASE, "FAILED ROM ERASE");
+	}
+    }
+}
+
+/*************************************************************
+ * faV3FirmwareLoad
+ *   - main routine to load up firmware for FADC with specific id
+ *
+ *  NOTE: Make call to
+ *     faV3FirmwareSetFilename(...);
+ *   if not using firmware from the default
+ */
+
+int32_t
+faV3FirmwareLoad(int32_t id, int32_t pFlag)
+{
+  int32_t rval, ndiff;
+  faV3UpdateWatcherArgs_t updateArgs;
+  CHECKID;
+
+  if(id==0) id = faV3Slot(id);
+  updateArgs.id = id;
+  updateArgs.step = FAV3_UPDATE_STEP_INIT;
+
+  /* Perform a hardware and software reset */
+  FAV3SLOTLOCK(id);
+  vmeWrite32(&FAV3p[id]->reset, 0xFFFF);
+  FAV3SLOTUNLOCK(id);
+  taskDelay(60);
+
+  updateArgs.show = FAV3_ARGS_SHOW_STRING;
+  sprintf(updateArgs.title, "Check if ready \n");
   faV3FirmwareUpdateWatcher(updateArgs);
 
   updateArgs.show = FAV3_ARGS_SHOW_ID;
   faV3FirmwareUpdateWatcher(updateArgs);
 
-  if(faV3FirmwareRomErase(id, 1) != OK)
+  /* Check for ROM Ready after reset */
+  if(faV3FirmwareWaitForReady(id, 60, 0) < OK)
     {
-      printf("%s: ERROR: faV3 %2d Failed to erase ROM\n",
-	     __func__, id);
       updateArgs.show = FAV3_ARGS_SHOW_STRING;
       sprintf(updateArgs.title,
-	      "ERROR: FAV3 %2d FAILED ROM ERASE\n", id);
+	      "ERROR: FAV3 %2d not ready after reset\n", id);
       faV3FirmwareUpdateWatcher(updateArgs);
       return ERROR;
     }
 
-  /* Program ROM */
-  updateArgs.step = FAV3_UPDATE_STEP_PROGRAM;
+  updateArgs.show = FAV3_ARGS_SHOW_DONE;
+  faV3FirmwareUpdateWatcher(updateArgs);
+
+  /* ERASE ROM */
+  updateArgs.step = FAV3_UPDATE_STEP_ERASE;
+
   updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "Program ROM\n");
+  sprintf(updateArgs.title, "ERASE ROM \n");
   faV3FirmwareUpdateWatcher(updateArgs);
 
   updateArgs.show = FAV3_ARGS_SHOW_ID;
   faV3FirmwareUpdateWatcher(updateArgs);
-  if(faV3FirmwareProgramRom(id) != OK)
+
+  if(fwIncremental)
     {
-      printf("%s: ERROR: faV3 %2d Failed to program ROM\n",
+      ndiff = faV3FirmwareScanRom(id);
+      if(ndiff >= 0)
+	{
+	  updateArgs.show = FAV3_ARGS_SHOW_STRING;
+	  sprintf(updateArgs.title, "    %d sectors differ\n", ndiff);
+	  faV3FirmwareUpdateWatcher(updateArgs);
+	}
+      rval = (ndiff < 0) ? ERROR : faV3FirmwareEraseSectors(id);
+    }
+  else
+    rval = faV3FirmwareRomErase(id, 1);
+
+  if(rval != OK)
+    {
+      printf("%s: ERROR: faV3 %2d Failed to erase ROM\n",
 	     __func__, id);
       updateArgs.show = FAV3_ARGS_SHOW_STRING;
       sprintf(updateArgs.title,
-	      "ERROR: FAV3 %2d FAILED ROM PROGRAM\n", id);
+	      "ERROR: FAV3 %2d FAILED ROM ERASE\n", id);
       faV3FirmwareUpdateWatcher(updateArgs);
       return ERROR;
     }
 
-  /* Download ROM data */
-  updateArgs.step = FAV3_UPDATE_STEP_DOWNLOAD;
+  /* Program ROM */
+  updateArgs.step = FAV3_UPDATE_STEP_PROGRAM;
   updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "Download ROM data\n");
+  sprintf(updateArgs.title, "Program ROM\n");
   faV3FirmwareUpdateWatcher(updateArgs);
+
   updateArgs.show = FAV3_ARGS_SHOW_ID;
   faV3FirmwareUpdateWatcher(updateArgs);
-
-  if(faV3FirmwareDownload(id, 1) != OK)
+  if(faV3FirmwareProgramRom(id) != OK)
     {
-      printf("%s: ERROR: faV3 %2d Failed to download ROM data\n",
+      printf("%s: ERROR: faV3 %2d Failed to program ROM\n",
 	     __func__, id);
       updateArgs.show = FAV3_ARGS_SHOW_STRING;
       sprintf(updateArgs.title,
-	      "ERROR: FAV3 %2d FAILED ROM DATA DOWNLOAD\n", id);
+	      "ERROR: FAV3 %2d FAILED ROM PROGRAM\n", id);
       faV3FirmwareUpdateWatcher(updateArgs);
       return ERROR;
     }
 
-  /* Verify ROM data with file */
+  /* Verify ROM data with file, by page checksums */
   updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
   updateArgs.show = FAV3_ARGS_SHOW_STRING;
   sprintf(updateArgs.title, "Verify ROM data\n");
@@ -788,7 +1534,7 @@ faV3FirmwareLoad(int32_t id, int32_t pFlag)
   updateArgs.show = FAV3_ARGS_SHOW_ID;
   faV3FirmwareUpdateWatcher(updateArgs);
 
-  if(faV3FirmwareVerify(id, 1) != OK)
+  if(faV3FirmwareVerifyRom(id) != OK)
     {
       printf("%s: ERROR: faV3 %2d ROM Data not verified\n",
 	     __func__, id);
@@ -884,9 +1630,11 @@ faV3FirmwareDone(int32_t pFlag)
 
   if(rom_firmware)
     free(rom_firmware);
+  rom_firmware = NULL;
 
   if(file_firmware)
     free(file_firmware);
+  file_firmware = NULL;
 
   return OK;
 }
@@ -930,7 +1678,9 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
 		    printf("Skip slot ");
 
 		  print_once = 0;
-		  fwStatus[id].skip = 1;
+		  if(!fwStatus[faV3Slot(ifadc)].skip)
+		    printf("%d ", faV3Slot(ifadc));
+		  fwStatus[faV3Slot(ifadc)].skip = 1;
 		}
 	      }
 	    }
@@ -942,7 +1692,6 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
 
   /* Perform a hardware and software reset */
   updateArgs.step = FAV3_UPDATE_STEP_INIT;
-  FAV3LOCK;
   for(ifadc = 0; ifadc < nfaV3; ifadc++)
     {
       id = faV3Slot(ifadc);
@@ -959,10 +1708,11 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
       else
 	{
 	  fwStatus[id].passed = 1;
+	  FAV3SLOTLOCK(id);
 	  vmeWrite32(&FAV3p[id]->reset, 0xFFFF);
+	  FAV3SLOTUNLOCK(id);
 	}
     }
-  FAV3UNLOCK;
   taskDelay(60);
 
   /* Check if FADC is Ready */
@@ -1004,116 +1754,117 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
   sprintf(updateArgs.title, "ERASE ROM \n");
   faV3FirmwareUpdateWatcher(updateArgs);
 
-  /* Execute erase command */
-  for(ifadc = 0; ifadc < nfaV3; ifadc++)
+  if(fwIncremental)
     {
-      id = faV3Slot(ifadc);
-      if(fwStatus[id].skip)
-	continue;
-
-      if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
+      /* Erase only the sectors that differ from the file */
+      faV3FirmwareGEraseSectors();
+    }
+  else
+    {
+      /* Execute erase command */
+      for(ifadc = 0; ifadc < nfaV3; ifadc++)
 	{
-	  if(faV3FirmwareRomErase(id, 0) != OK)
+	  id = faV3Slot(ifadc);
+	  if(fwStatus[id].skip)
+	    continue;
+
+	  if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
 	    {
-	      updateArgs.show = FAV3_ARGS_SHOW_STRING;
-	      sprintf(updateArgs.title,
-		      "ERROR: FAV3 %2d FAILED TO EXEC ROM ERASE\n", id);
-	      faV3FirmwareUpdateWatcher(updateArgs);
-	      fwStatus[id].passed = 0;
-	      fwStatus[id].stepfail = updateArgs.step;
+	      if(faV3FirmwareRomErase(id, 0) != OK)
+		{
+		  updateArgs.show = FAV3_ARGS_SHOW_STRING;
+		  sprintf(updateArgs.title,
+			  "ERROR: FAV3 %2d FAILED TO EXEC ROM ERASE\n", id);
+		  faV3FirmwareUpdateWatcher(updateArgs);
+		  fwStatus[id].passed = 0;
+		  fwStatus[id].stepfail = updateArgs.step;
+		}
 	    }
 	}
-    }
-  /* Wait for Erase to Complete */
-  for(ifadc = 0; ifadc < nfaV3; ifadc++)
-    {
-      id = faV3Slot(ifadc);
-      if(fwStatus[id].skip)
-	continue;
-
-      if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
+      /* Wait for Erase to Complete */
+      for(ifadc = 0; ifadc < nfaV3; ifadc++)
 	{
-	  updateArgs.id = id;
-	  updateArgs.show = FAV3_ARGS_SHOW_ID;
-	  faV3FirmwareUpdateWatcher(updateArgs);
+	  id = faV3Slot(ifadc);
+	  if(fwStatus[id].skip)
+	    continue;
 
-	  if(faV3FirmwareWaitForWIP(id, 200000, 0) < OK)
+	  if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
 	    {
-	      updateArgs.show = FAV3_ARGS_SHOW_STRING;
-	      sprintf(updateArgs.title,
-		      "ERROR: FAV3 %2d FAILED ROM ERASE\n", id);
+	      updateArgs.id = id;
+	      updateArgs.show = FAV3_ARGS_SHOW_ID;
 	      faV3FirmwareUpdateWatcher(updateArgs);
-	      fwStatus[id].passed = 0;
-	      fwStatus[id].stepfail = updateArgs.step;
+
+	      if(faV3FirmwareWaitForWIP(id, 200000, 0) < OK)
+		{
+		  updateArgs.show = FAV3_ARGS_SHOW_STRING;
+		  sprintf(updateArgs.title,
+			  "ERROR: FAV3 %2d FAILED ROM ERASE\n", id);
+		  faV3FirmwareUpdateWatcher(updateArgs);
+		  fwStatus[id].passed = 0;
+		  fwStatus[id].stepfail = updateArgs.step;
+		}
 	    }
 	}
     }
 
-  /* Program ROM */
-  updateArgs.step = FAV3_UPDATE_STEP_PROGRAM;
-
-  updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "Program ROM\n");
-  faV3FirmwareUpdateWatcher(updateArgs);
-
-  for(ifadc = 0; ifadc < nfaV3; ifadc++)
+  if(fwInterleave)
     {
-      id = faV3Slot(ifadc);
-      if(fwStatus[id].skip)
-	continue;
+      /* Program, then read back and verify, all boards together */
+      faV3FirmwareGProgramRom();
+      faV3FirmwareGVerifyRom();
+      updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
+    }
+  else
+    {
+      /* Program ROM */
+      updateArgs.step = FAV3_UPDATE_STEP_PROGRAM;
 
-      if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
+      updateArgs.show = FAV3_ARGS_SHOW_STRING;
+      sprintf(updateArgs.title, "Program ROM\n");
+      faV3FirmwareUpdateWatcher(updateArgs);
+
+      for(ifadc = 0; ifadc < nfaV3; ifadc++)
 	{
-	  updateArgs.id = id;
-	  updateArgs.show = FAV3_ARGS_SHOW_ID;
-	  faV3FirmwareUpdateWatcher(updateArgs);
-	  if(faV3FirmwareProgramRom(id) != OK)
+	  id = faV3Slot(ifadc);
+	  if(fwStatus[id].skip)
+	    continue;
+
+	  if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
 	    {
-	      updateArgs.show = FAV3_ARGS_SHOW_STRING;
-	      sprintf(updateArgs.title,
-		      "ERROR: FAV3 %2d FAILED ROM PROGRAM\n", id);
+	      updateArgs.id = id;
+	      updateArgs.show = FAV3_ARGS_SHOW_ID;
 	      faV3FirmwareUpdateWatcher(updateArgs);
-	      fwStatus[id].passed = 0;
-	      fwStatus[id].stepfail = updateArgs.step;
+	      if(faV3FirmwareProgramRom(id) != OK)
+		{
+		  updateArgs.show = FAV3_ARGS_SHOW_STRING;
+		  sprintf(updateArgs.title,
+			  "ERROR: FAV3 %2d FAILED ROM PROGRAM\n", id);
+		  faV3FirmwareUpdateWatcher(updateArgs);
+		  fwStatus[id].passed = 0;
+		  fwStatus[id].stepfail = updateArgs.step;
+		}
 	    }
 	}
-    }
 
-  /* Download and Verify ROM data */
-  updateArgs.step = FAV3_UPDATE_STEP_DOWNLOAD;
-  updateArgs.show = FAV3_ARGS_SHOW_STRING;
-  sprintf(updateArgs.title, "Download and Verify ROM data\n");
-  faV3FirmwareUpdateWatcher(updateArgs);
-
-  for(ifadc = 0; ifadc < nfaV3; ifadc++)
-    {
-      id = faV3Slot(ifadc);
-      if(fwStatus[id].skip)
-	continue;
+      /* Verify ROM data, by page checksums */
+      updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
+      updateArgs.show = FAV3_ARGS_SHOW_STRING;
+      sprintf(updateArgs.title, "Verify ROM data\n");
+      faV3FirmwareUpdateWatcher(updateArgs);
 
-      if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
+      for(ifadc = 0; ifadc < nfaV3; ifadc++)
 	{
-	  updateArgs.id = id;
-	  updateArgs.show = FAV3_ARGS_SHOW_ID;
-	  faV3FirmwareUpdateWatcher(updateArgs);
+	  id = faV3Slot(ifadc);
+	  if(fwStatus[id].skip)
+	    continue;
 
-	  if(faV3FirmwareDownload(id, 1) != OK)
-	    {
-	      updateArgs.show = FAV3_ARGS_SHOW_STRING;
-	      sprintf(updateArgs.title,
-		      "ERROR: FAV3 %2d FAILED ROM DATA DOWNLOAD\n", id);
-	      faV3FirmwareUpdateWatcher(updateArgs);
-	      fwStatus[id].passed = 0;
-	      fwStatus[id].stepfail = updateArgs.step;
-	    }
-	  else
+	  if(fwStatus[id].passed)		/* Skip the ones that have previously failed */
 	    {
-	      /* Verify ROM data */
-	      updateArgs.step = FAV3_UPDATE_STEP_VERIFY;
+	      updateArgs.id = id;
 	      updateArgs.show = FAV3_ARGS_SHOW_ID;
 	      faV3FirmwareUpdateWatcher(updateArgs);
 
-	      if(faV3FirmwareVerify(id, 1) != OK)
+	      if(faV3FirmwareVerifyRom(id) != OK)
 		{
 		  updateArgs.show = FAV3_ARGS_SHOW_STRING;
 		  sprintf(updateArgs.title,
@@ -1121,7 +1872,6 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
 		  faV3FirmwareUpdateWatcher(updateArgs);
 		  fwStatus[id].passed = 0;
 		  fwStatus[id].stepfail = updateArgs.step;
-
 		}
 	    }
 	}
@@ -1187,34 +1937,169 @@ faV3FirmwareGLoad(int32_t pFlag, int32_t force)
 
 }
 
+/* Byte swap the words of the file into the image */
+static void
+faV3FirmwareSwapScalar(uint32_t *dst, const uint32_t *src, uint32_t nwords)
+{
+  uint32_t idata;
+
+  for(idata = 0; idata < nwords; idata++)
+    dst[idata] = bswap_32(src[idata]);
+}
+
+#ifdef FAV3_FW_X86
+__attribute__ ((target("ssse3")))
+static void
+faV3FirmwareSwapSSSE3(uint32_t *dst, const uint32_t *src, uint32_t nwords)
+{
+  const __m128i ctrl =
+    _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  uint32_t idata;
+
+  for(idata = 0; idata + 4 <= nwords; idata += 4)
+    _mm_storeu_si128((__m128i *) & dst[idata],
+		     _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+						      &src[idata]), ctrl));
+
+  faV3FirmwareSwapScalar(&dst[idata], &src[idata], nwords - idata);
+}
+
+__attribute__ ((target("avx2")))
+static void
+faV3FirmwareSwapAVX2(uint32_t *dst, const uint32_t *src, uint32_t nwords)
+{
+  const __m256i ctrl =
+    _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		     3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  uint32_t idata;
+
+  for(idata = 0; idata + 8 <= nwords; idata += 8)
+    _mm256_storeu_si256((__m256i *) & dst[idata],
+			_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+							       &src[idata]),
+					    ctrl));
+
+  _mm256_zeroupper();
+
+  faV3FirmwareSwapScalar(&dst[idata], &src[idata], nwords - idata);
+}
+#endif /* FAV3_FW_X86 */
+
+static void
+faV3FirmwareSwap(uint32_t *dst, const uint32_t *src, uint32_t nwords)
+{
+#ifdef FAV3_FW_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    {
+      faV3FirmwareSwapAVX2(dst, src, nwords);
+      return;
+    }
+  if(__builtin_cpu_supports("ssse3"))
+    {
+      faV3FirmwareSwapSSSE3(dst, src, nwords);
+      return;
+    }
+#endif
+  faV3FirmwareSwapScalar(dst, src, nwords);
+}
+
+/**
+ * @brief Read the firmware image from a file
+ *
+ *   The file is mapped, and must be the length of the bitstream
+ *   (FAV3_FW_SIZE bytes).  Its words are byte swapped into the image,
+ *   and the page checksums and hash of the image are computed.  The image
+ *   is kept until faV3FirmwareDone, and used by faV3FirmwareLoad,
+ *   faV3FirmwareGLoad and the verify step.  Reading the same, unchanged,
+ *   file again does nothing.
+ *
+ * @param[in] filename Firmware file (.bin)
+ * @return OK if successful, otherwise ERROR
+ */
 int
 faV3FirmwareReadFile(char *filename)
 {
-  FILE *firmwareFD = fopen(filename, "r");
+  struct stat st;
+  const uint32_t *map;
+  uint32_t nwords;
+  int fd;
 
-  if(firmwareFD == NULL)
+  if(strlen(filename) >= sizeof(file_firmware->filename))
     {
-      perror("fopen");
+      printf("%s: ERROR: filename too long (%s)\n", __func__, filename);
+      return ERROR;
+    }
+
+  fd = open(filename, O_RDONLY);
+  if((fd < 0) || (fstat(fd, &st) != 0))
+    {
+      perror("open");
       printf("%s: ERROR opening file (%s) for reading\n", __func__, filename);
+      if(fd >= 0)
+	close(fd);
       return ERROR;
     }
 
-  file_firmware = (faV3fw_t *)malloc(sizeof(faV3fw_t));
+  if(st.st_size != FAV3_FW_SIZE)
+    {
+      printf("%s: ERROR: %s is 0x%llx bytes, firmware is 0x%x\n",
+	     __func__, filename, (unsigned long long) st.st_size, FAV3_FW_SIZE);
+      close(fd);
+      return ERROR;
+    }
 
-  strcpy(file_firmware->filename, filename);
+  if(file_firmware && (file_firmware->loaded == 1) &&
+     (strcmp(file_firmware->filename, filename) == 0) &&
+     (file_firmware->st.st_dev == st.st_dev) &&
+     (file_firmware->st.st_ino == st.st_ino) &&
+     (file_firmware->st.st_size == st.st_size) &&
+     (file_firmware->st.st_mtim.tv_sec == st.st_mtim.tv_sec) &&
+     (file_firmware->st.st_mtim.tv_nsec == st.st_mtim.tv_nsec))
+    {
+      close(fd);
+      printf("%s: Firmware from %s already read (hash 0x%016llx)\n",
+	     __func__, filename, (unsigned long long) file_firmware->hash);
+      return OK;
+    }
 
-  uint32_t idata = 0, data = 0;
-  while(!feof(firmwareFD))
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED)
     {
-      fread(&data, sizeof(uint32_t), 1, firmwareFD);
-      file_firmware->data[idata++] = bswap_32(data);
+      perror("mmap");
+      printf("%s: ERROR mapping file (%s)\n", __func__, filename);
+      return ERROR;
     }
-  fclose(firmwareFD);
 
-  file_firmware->size = idata-1;
+  /* The image buffer is kept, and reused by the next file */
+  if(file_firmware == NULL)
+    {
+      file_firmware = (faV3fw_t *)malloc(sizeof(faV3fw_t));
+      if(file_firmware == NULL)
+	{
+	  perror("malloc");
+	  munmap((void *) map, st.st_size);
+	  return ERROR;
+	}
+    }
+  file_firmware->loaded = 0;
+
+  nwords = st.st_size >> 2;
+  faV3FirmwareSwap(file_firmware->data, map, nwords);
+  munmap((void *) map, st.st_size);
+
+  strcpy(file_firmware->filename, filename);
+  file_firmware->st = st;
+  file_firmware->size = nwords;
+  faV3FirmwareSumPages(file_firmware);
   file_firmware->loaded = 1;
 
-  printf("%s: Read Firmware from %s\n", __func__, file_firmware->filename);
+  /* The sectors found the same were the same as the last image */
+  memset(fwSectorSame, 0, sizeof(fwSectorSame));
+
+  printf("%s: Read Firmware from %s (hash 0x%016llx)\n", __func__,
+	 file_firmware->filename, (unsigned long long) file_firmware->hash);
 
   return OK;
 }
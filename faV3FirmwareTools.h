@@ -9,10 +9,13 @@ uint32_t faV3FirmwareRomID(int32_t id);
 uint32_t faV3FirmwareRomStatus1(int32_t id);
 uint32_t faV3FirmwareSetMemoryWrite(int32_t id, int32_t enable);
 int32_t  faV3FirmwareRomErase(int32_t id, int32_t waitforWIP);
+int32_t  faV3FirmwareRomSectorErase(int32_t id, uint32_t romadr, int32_t waitforWIP);
 int32_t  faV3FirmwareReadRomAdr(int32_t id, uint32_t romadr, int32_t last);
 int32_t  faV3FirmwareWriteRomAdr(int32_t id, uint32_t romadr, uint32_t romdata, int32_t last);
 int32_t  faV3FirmwareDownloadRom(int32_t id, int32_t size);
 int32_t  faV3FirmwareProgramRom(int32_t id);
+int32_t  faV3FirmwareScanRom(int32_t id);
+int32_t  faV3FirmwareVerifyRom(int32_t id);
 int32_t  faV3FirmwareVerifyDownload();
 
 int32_t faV3FirmwareReboot(int32_t id);
@@ -24,6 +27,8 @@ int32_t faV3FirmwareDownload(int32_t id, int32_t pFlag);
 int32_t faV3FirmwareVerify(int32_t id, int32_t pFlag);
 int32_t faV3FirmwareDone(int32_t pFlag);
 int32_t faV3FirmwareGLoad(int32_t pFlag, int32_t force);
+int32_t faV3FirmwareSetInterleave(int32_t enable);
+int32_t faV3FirmwareSetIncremental(int32_t enable);
 int32_t faV3FirmwareReadFile(char *filename);
 int32_t faV3FirmwareWriteFile(char *filename);
 int32_t faV3FirmwareReadMcsFile(char *filename);
@@ -0,0 +1,736 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Hist.c
+ *
+ * @brief     Online per-slot, per-channel histograms of pulse parameters.
+ *
+ *            Filled from decoded PULSE PARAM records (modes 9 and 10):
+ *            pulse integral, time, peak and pedestal sum.
+ *
+ *            Every thread that fills gets its own set of counts, found
+ *            through a thread local pointer, so filling takes no lock and
+ *            no atomic operation.  The counts of a slot are allocated the
+ *            first time the thread sees that slot.  Reading a histogram
+ *            adds up the counts of all threads.
+ *
+ *            faV3HistReset only bumps a reset number.  Each thread clears
+ *            its own counts on its next fill, and until then its counts
+ *            are left out of reads.
+ *
+ *            A readout thread fills from its raw data with
+ *            faV3HistFillBuffer, which decodes one buffer in a prescale
+ *            and skips the others at the cost of a few loads.  The
+ *            default prescale grows with the number of slots the thread
+ *            reads, so a thread spends about the same on filling whether
+ *            it reads one board or a crate.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+#include "faV3Hist.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+typedef struct
+{
+  uint32_t min, shift, nbins;
+  uint32_t offset;		/* of this quantity in a channel's counts */
+} faV3HistAxis_t;
+
+/* Counts of one thread */
+typedef struct faV3HistAcc_struct
+{
+  uint32_t *slot[32];		/* 16 channels of counts, or NULL */
+  volatile uint32_t reset_gen;	/* reset number the counts belong to */
+  uint32_t nrec, npulse, nignored;
+  uint32_t nbuf[32];		/* buffers given, by slot of the first word */
+  uint32_t seen;		/* slots found in decoded buffers */
+  uint32_t nbuffers, ndecoded;
+  faV3Decoder_t dec;		/* for faV3HistFillBuffer */
+  struct faV3HistAcc_struct *next;
+} faV3HistAcc_t;
+
+typedef struct
+{
+  int32_t created;
+  uint32_t slotmask;
+  uint32_t prescale;		/* decode one buffer in prescale, 0: auto */
+  volatile uint32_t reset_gen;
+  faV3HistAxis_t axis[FAV3_HIST_NQ];
+  uint32_t chan_words;		/* counts per channel, all quantities */
+  faV3HistAcc_t *acc;		/* one per thread that filled */
+  int32_t nacc;
+} faV3Hist_t;
+
+static faV3Hist_t faV3Hist;
+
+/* Bumped by create and destroy, so threads know to find their counts
+   again */
+static volatile uint32_t faV3HistGen = 0;
+
+/* Counts of the calling thread.  The library is built with -fPIC, where a
+   thread local variable of the default model takes a call to
+   __tls_get_addr for each use: initial-exec makes it a load. */
+typedef struct
+{
+  faV3HistAcc_t *acc;
+  uint32_t gen;			/* faV3HistGen acc belongs to */
+} faV3HistLocal_t;
+
+static __thread faV3HistLocal_t faV3HistLocal
+__attribute__ ((tls_model("initial-exec"))) = { NULL, 0 };
+
+static const char *faV3HistNames[FAV3_HIST_NQ] =
+  { "Sum", "Time", "Peak", "Pedestal" };
+
+pthread_mutex_t faV3HistMutex = PTHREAD_MUTEX_INITIALIZER;
+#define HISTLOCK      if(pthread_mutex_lock(&faV3HistMutex)<0) perror("pthread_mutex_lock");
+#define HISTUNLOCK    if(pthread_mutex_unlock(&faV3HistMutex)<0) perror("pthread_mutex_unlock");
+
+static void
+faV3HistLayout()
+{
+  uint32_t q, off = 0;
+
+  for(q = 0; q < FAV3_HIST_NQ; q++)
+    {
+      faV3Hist.axis[q].offset = off;
+      off += faV3Hist.axis[q].nbins + 2;	/* + underflow and overflow */
+    }
+
+  faV3Hist.chan_words = off;
+}
+
+static void faV3HistDecRecord(const faV3DecRecord_t * rec, void *arg);
+
+/* Counts of the calling thread, added to the list on first use */
+static faV3HistAcc_t *
+faV3HistRegister()
+{
+  faV3HistAcc_t *acc = NULL;
+
+  HISTLOCK;
+  if(faV3Hist.created)
+    {
+      acc = (faV3HistAcc_t *) calloc(1, sizeof(faV3HistAcc_t));
+      if(acc)
+	{
+	  acc->reset_gen = faV3Hist.reset_gen;
+	  faV3DecoderInit(&acc->dec, 0);
+	  faV3DecoderSetCallback(&acc->dec, faV3HistDecRecord, acc);
+	  acc->next = faV3Hist.acc;
+	  faV3Hist.acc = acc;
+	  faV3Hist.nacc++;
+	  faV3HistLocal.acc = acc;
+	  faV3HistLocal.gen = faV3HistGen;
+	}
+      else
+	printf("%s: ERROR: Unable to allocate thread counts\n", __func__);
+    }
+  HISTUNLOCK;
+
+  return acc;
+}
+
+/* Clear the counts of the calling thread, after faV3HistReset */
+static void
+faV3HistClear(faV3HistAcc_t * acc, uint32_t reset_gen)
+{
+  int32_t slot;
+
+  for(slot = 0; slot < 32; slot++)
+    if(acc->slot[slot])
+      memset(acc->slot[slot], 0,
+	     FAV3_MAX_ADC_CHANNELS * faV3Hist.chan_words * sizeof(uint32_t));
+
+  acc->nrec = 0;
+  acc->npulse = 0;
+  acc->nignored = 0;
+  memset(acc->nbuf, 0, sizeof(acc->nbuf));
+  acc->seen = 0;
+  acc->nbuffers = 0;
+  acc->ndecoded = 0;
+  __atomic_store_n(&acc->reset_gen, reset_gen, __ATOMIC_RELEASE);
+}
+
+static inline void
+faV3HistAdd(uint32_t * h, const faV3HistAxis_t * ax, uint32_t v)
+{
+  uint32_t bin = 0;
+
+  if(v >= ax->min)
+    {
+      bin = ((v - ax->min) >> ax->shift) + 1;
+      if(bin > ax->nbins)
+	bin = ax->nbins + 1;
+    }
+
+  h[ax->offset + bin]++;
+}
+
+/**
+ * @brief Create the histograms, with the default binning
+ * @param slotmask Slots to histogram
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistCreate(uint32_t slotmask)
+{
+  HISTLOCK;
+  if(faV3Hist.created)
+    {
+      printf("%s: ERROR: Histograms already created\n", __func__);
+      HISTUNLOCK;
+      return ERROR;
+    }
+
+  memset(&faV3Hist, 0, sizeof(faV3Hist));
+
+  /* 1024 bins over the full range of each field */
+  faV3Hist.axis[FAV3_HIST_SUM].shift = 8;	/* 18 bits */
+  faV3Hist.axis[FAV3_HIST_TIME].shift = 5;	/* 9 + 6 bits */
+  faV3Hist.axis[FAV3_HIST_PEAK].shift = 2;	/* 12 bits */
+  faV3Hist.axis[FAV3_HIST_PED].shift = 4;	/* 14 bits */
+  faV3Hist.axis[FAV3_HIST_SUM].nbins = 1024;
+  faV3Hist.axis[FAV3_HIST_TIME].nbins = 1024;
+  faV3Hist.axis[FAV3_HIST_PEAK].nbins = 1024;
+  faV3Hist.axis[FAV3_HIST_PED].nbins = 1024;
+  faV3HistLayout();
+
+  faV3Hist.slotmask = slotmask;
+  faV3Hist.created = 1;
+  faV3HistGen++;
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Free the histograms.  No thread may be filling.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistDestroy()
+{
+  faV3HistAcc_t *acc, *next;
+  int32_t slot;
+
+  HISTLOCK;
+  for(acc = faV3Hist.acc; acc; acc = next)
+    {
+      next = acc->next;
+      for(slot = 0; slot < 32; slot++)
+	free(acc->slot[slot]);
+      free(acc);
+    }
+
+  memset(&faV3Hist, 0, sizeof(faV3Hist));
+  faV3HistGen++;
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Set the binning of a quantity, before the first fill
+ *
+ *   Bin i (1 - nbins) holds values min + (i - 1) * 2^shift up to the next
+ *   bin.  Bin 0 is the underflow, bin nbins + 1 the overflow.
+ *
+ * @param quantity FAV3_HIST_SUM, _TIME, _PEAK or _PED
+ * @param min Lowest value of bin 1
+ * @param shift Bin width is 2^shift
+ * @param nbins Number of bins (1 - FAV3_HIST_MAX_BINS)
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistSetBinning(int32_t quantity, uint32_t min, uint32_t shift,
+		   uint32_t nbins)
+{
+  if((quantity < 0) || (quantity >= FAV3_HIST_NQ) || (shift > 31) ||
+     (nbins == 0) || (nbins > FAV3_HIST_MAX_BINS))
+    {
+      printf("%s: ERROR: Invalid quantity (%d) or binning (%d, %d)\n",
+	     __func__, quantity, shift, nbins);
+      return ERROR;
+    }
+
+  HISTLOCK;
+  if(!faV3Hist.created || (faV3Hist.nacc > 0))
+    {
+      printf("%s: ERROR: Histograms not created, or already filled\n",
+	     __func__);
+      HISTUNLOCK;
+      return ERROR;
+    }
+
+  faV3Hist.axis[quantity].min = min;
+  faV3Hist.axis[quantity].shift = shift;
+  faV3Hist.axis[quantity].nbins = nbins;
+  faV3HistLayout();
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Get the binning of a quantity
+ * @param quantity FAV3_HIST_SUM, _TIME, _PEAK or _PED
+ * @param min Where to put the lowest value of bin 1
+ * @param shift Where to put the bin width (as a power of 2)
+ * @param nbins Where to put the number of bins
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistGetBinning(int32_t quantity, uint32_t * min, uint32_t * shift,
+		   uint32_t * nbins)
+{
+  if((quantity < 0) || (quantity >= FAV3_HIST_NQ))
+    return ERROR;
+
+  HISTLOCK;
+  if(min)
+    *min = faV3Hist.axis[quantity].min;
+  if(shift)
+    *shift = faV3Hist.axis[quantity].shift;
+  if(nbins)
+    *nbins = faV3Hist.axis[quantity].nbins;
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/* Counts of the calling thread, cleared if reset.  NULL if the
+   histograms are not created (no message, as this may be called for
+   every record) or the counts could not be allocated. */
+static inline faV3HistAcc_t *
+faV3HistThread()
+{
+  faV3HistAcc_t *acc = faV3HistLocal.acc;
+  uint32_t reset_gen;
+
+  if(!faV3Hist.created)
+    return NULL;
+
+  if(faV3HistLocal.gen != faV3HistGen)
+    acc = faV3HistRegister();
+  if(acc == NULL)
+    return NULL;
+
+  reset_gen = faV3Hist.reset_gen;
+  if(acc->reset_gen != reset_gen)
+    faV3HistClear(acc, reset_gen);
+
+  return acc;
+}
+
+/* Fill a PULSE PARAM record into the counts of the calling thread */
+static inline int32_t
+faV3HistAddRecord(faV3HistAcc_t * acc, const faV3DecRecord_t * rec)
+{
+  const faV3HistAxis_t *axis = faV3Hist.axis;
+  const faV3DecPulse_t *p;
+  uint32_t *h, ipulse;
+
+  if((rec->slot >= 32) || !(faV3Hist.slotmask & (1u << rec->slot)))
+    {
+      acc->nignored++;
+      return OK;
+    }
+
+  h = acc->slot[rec->slot];
+  if(h == NULL)
+    {
+      h = (uint32_t *) calloc(FAV3_MAX_ADC_CHANNELS * faV3Hist.chan_words,
+			      sizeof(uint32_t));
+      if(h == NULL)
+	{
+	  printf("%s: ERROR: Unable to allocate counts for slot %d\n",
+		 __func__, rec->slot);
+	  return ERROR;
+	}
+      __atomic_store_n(&acc->slot[rec->slot], h, __ATOMIC_RELEASE);
+    }
+  h += (rec->u.pp.chan & 0xF) * faV3Hist.chan_words;
+
+  faV3HistAdd(h, &axis[FAV3_HIST_PED], rec->u.pp.ped_sum);
+  for(ipulse = 0; ipulse < rec->u.pp.npulse; ipulse++)
+    {
+      p = &rec->u.pp.pulse[ipulse];
+      faV3HistAdd(h, &axis[FAV3_HIST_SUM], p->adc_sum);
+      faV3HistAdd(h, &axis[FAV3_HIST_TIME],
+		  ((uint32_t) p->time_coarse << 6) | p->time_fine);
+      faV3HistAdd(h, &axis[FAV3_HIST_PEAK], p->vpeak);
+    }
+
+  acc->nrec++;
+  acc->npulse += rec->u.pp.npulse;
+
+  return OK;
+}
+
+/**
+ * @brief Fill the histograms from a decoded record
+ *
+ *   Only PULSE PARAM records are used.  Takes no lock, except the first
+ *   time a thread fills.  Every record given is filled: a thread reading
+ *   more than one board at high rate should use faV3HistFillBuffer.
+ *
+ * @param rec Record from faV3Decoder
+ * @return OK if successful, ERROR if the histograms are not created or
+ *         counts could not be allocated
+ */
+int32_t
+faV3HistFill(const faV3DecRecord_t * rec)
+{
+  faV3HistAcc_t *acc;
+
+  if(rec->type != FAV3_DEC_PULSE_PARAM)
+    return OK;
+
+  acc = faV3HistThread();
+  if(acc == NULL)
+    return ERROR;
+
+  return faV3HistAddRecord(acc, rec);
+}
+
+/* Callback of the decoder of faV3HistFillBuffer */
+static void
+faV3HistDecRecord(const faV3DecRecord_t * rec, void *arg)
+{
+  faV3HistAcc_t *acc = (faV3HistAcc_t *) arg;
+
+  if(rec->type == FAV3_DEC_PULSE_PARAM)
+    faV3HistAddRecord(acc, rec);
+  else if((rec->type == FAV3_DEC_BLOCK_HEADER) && (rec->slot < 32) &&
+	  (faV3Hist.slotmask & (1u << rec->slot)))
+    acc->seen |= 1u << rec->slot;
+}
+
+/**
+ * @brief Set which buffers faV3HistFillBuffer decodes
+ *
+ *   Buffers are counted by the slot of their first block header, and one
+ *   in prescale of each count is decoded.  With 0 (automatic, the
+ *   default), prescale is twice the number of slots the thread has found
+ *   in the buffers it decoded: one buffer in 2 for a thread reading one
+ *   board, one in 32 for a crate of 16.  Decoding and filling all the
+ *   data of one board at 100 kHz takes 3-6% of a 1.15 GHz CPU
+ *   (test/faV3HistBench), so this keeps a thread at half that.
+ *
+ * @param prescale 1: decode every buffer, 0: automatic
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistSetPrescale(uint32_t prescale)
+{
+  HISTLOCK;
+  if(!faV3Hist.created)
+    {
+      printf("%s: ERROR: Histograms not created\n", __func__);
+      HISTUNLOCK;
+      return ERROR;
+    }
+  faV3Hist.prescale = prescale;
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Fill the histograms from a buffer of raw data
+ *
+ *   For readout threads: the buffer (one or more blocks, as read from
+ *   the boards) is decoded and filled, or left out if prescaled
+ *   (faV3HistSetPrescale).  A buffer left out costs a few loads, whatever
+ *   its size, which keeps the cost of a thread reading a full crate at
+ *   about that of one reading one board.  Takes no lock, except the
+ *   first time a thread fills.
+ *
+ * @param buf Raw data, starting with a block header
+ * @param nwords Number of words in buf
+ * @param flags FAV3_DEC_FLAG_* of the decoder (e.g. FAV3_DEC_FLAG_SWAP
+ *              for big-endian data)
+ * @return OK if successful, ERROR if the histograms are not created or
+ *         counts could not be allocated
+ */
+int32_t
+faV3HistFillBuffer(const uint32_t * buf, int32_t nwords, uint32_t flags)
+{
+  faV3HistAcc_t *acc;
+  uint32_t prescale, word, slot = 0;
+
+  acc = faV3HistThread();
+  if(acc == NULL)
+    return ERROR;
+
+  if((buf == NULL) || (nwords <= 0))
+    return OK;
+
+  word = (flags & FAV3_DEC_FLAG_SWAP) ? __builtin_bswap32(buf[0]) : buf[0];
+  if((word & (FAV3_DATA_TYPE_DEFINE | FAV3_DATA_TYPE_MASK)) ==
+     (FAV3_DATA_TYPE_DEFINE | FAV3_DATA_BLOCK_HEADER))
+    slot = (word & FAV3_DATA_SLOT_MASK) >> 22;
+
+  prescale = faV3Hist.prescale;
+  if(prescale == 0)
+    prescale = acc->seen ? 2 * __builtin_popcount(acc->seen) : 1;
+
+  acc->nbuffers++;
+  if((acc->nbuf[slot]++ % prescale) != 0)
+    return OK;
+  acc->ndecoded++;
+
+  if(acc->dec.flags != flags)
+    {
+      faV3DecoderInit(&acc->dec, flags);
+      faV3DecoderSetCallback(&acc->dec, faV3HistDecRecord, acc);
+    }
+  faV3DecoderReset(&acc->dec);
+  faV3DecoderFeed(&acc->dec, buf, nwords);
+  faV3DecoderFlush(&acc->dec);
+
+  return OK;
+}
+
+/**
+ * @brief faV3HistFill as a decoder callback (faV3DecoderSetCallback)
+ * @param rec Record from faV3Decoder
+ * @param arg Not used
+ */
+void
+faV3HistDecCallback(const faV3DecRecord_t * rec, void *arg)
+{
+  faV3HistFill(rec);
+}
+
+/**
+ * @brief Clear all histograms
+ *
+ *   Counts of each thread are cleared by that thread on its next fill.
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistReset()
+{
+  HISTLOCK;
+  if(!faV3Hist.created)
+    {
+      printf("%s: ERROR: Histograms not created\n", __func__);
+      HISTUNLOCK;
+      return ERROR;
+    }
+  faV3Hist.reset_gen++;
+  HISTUNLOCK;
+
+  return OK;
+}
+
+/* Add up the counts of all threads.  Call with HISTLOCK held. */
+static void
+faV3HistMerge(int32_t slot, int32_t chan, int32_t quantity, uint32_t * counts)
+{
+  const faV3HistAxis_t *ax = &faV3Hist.axis[quantity];
+  faV3HistAcc_t *acc;
+  const uint32_t *h;
+  uint32_t i;
+
+  memset(counts, 0, (ax->nbins + 2) * sizeof(uint32_t));
+
+  for(acc = faV3Hist.acc; acc; acc = acc->next)
+    {
+      if(__atomic_load_n(&acc->reset_gen, __ATOMIC_ACQUIRE) !=
+	 faV3Hist.reset_gen)
+	continue;
+      h = __atomic_load_n(&acc->slot[slot], __ATOMIC_ACQUIRE);
+      if(h == NULL)
+	continue;
+
+      h += chan * faV3Hist.chan_words + ax->offset;
+      for(i = 0; i < ax->nbins + 2; i++)
+	counts[i] += h[i];
+    }
+}
+
+/**
+ * @brief Get a histogram, added up over all threads
+ *
+ *   counts[0] is the underflow, counts[nbins + 1] the overflow.
+ *
+ * @param slot Slot number
+ * @param chan Channel (0 - 15)
+ * @param quantity FAV3_HIST_SUM, _TIME, _PEAK or _PED
+ * @param counts Where to put the counts
+ * @param maxbins Size of counts (at least nbins + 2)
+ * @return Number of entries put in counts, otherwise ERROR
+ */
+int32_t
+faV3HistGet(int32_t slot, int32_t chan, int32_t quantity, uint32_t * counts,
+	    int32_t maxbins)
+{
+  int32_t rval;
+
+  if((slot < 0) || (slot >= 32) || (chan < 0) ||
+     (chan >= FAV3_MAX_ADC_CHANNELS) || (quantity < 0) ||
+     (quantity >= FAV3_HIST_NQ) || (counts == NULL))
+    {
+      printf("%s: ERROR: Invalid slot (%d), channel (%d) or quantity (%d)\n",
+	     __func__, slot, chan, quantity);
+      return ERROR;
+    }
+
+  HISTLOCK;
+  rval = faV3Hist.axis[quantity].nbins + 2;
+  if(!faV3Hist.created || (maxbins < rval))
+    {
+      printf("%s: ERROR: Histograms not created, or maxbins < %d\n",
+	     __func__, rval);
+      HISTUNLOCK;
+      return ERROR;
+    }
+
+  faV3HistMerge(slot, chan, quantity, counts);
+  HISTUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief Write all histograms to a binary file
+ *
+ *   The layout is described with FAV3_HIST_MAGIC in faV3Hist.h.
+ *
+ * @param filename Name of the file
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3HistWrite(const char *filename)
+{
+  uint32_t hdr[4 + 3 * FAV3_HIST_NQ], *counts;
+  int32_t slot, chan, q, n, rval = OK;
+  FILE *f;
+
+  counts = (uint32_t *) malloc((FAV3_HIST_MAX_BINS + 2) * sizeof(uint32_t));
+  if(counts == NULL)
+    return ERROR;
+
+  f = fopen(filename, "wb");
+  if(f == NULL)
+    {
+      perror("fopen");
+      printf("%s: ERROR: Unable to open %s\n", __func__, filename);
+      free(counts);
+      return ERROR;
+    }
+
+  HISTLOCK;
+  if(!faV3Hist.created)
+    {
+      printf("%s: ERROR: Histograms not created\n", __func__);
+      rval = ERROR;
+    }
+  else
+    {
+      hdr[0] = FAV3_HIST_MAGIC;
+      hdr[1] = FAV3_HIST_VERSION;
+      hdr[2] = faV3Hist.slotmask;
+      hdr[3] = FAV3_HIST_NQ;
+      for(q = 0; q < FAV3_HIST_NQ; q++)
+	{
+	  hdr[4 + 3 * q] = faV3Hist.axis[q].min;
+	  hdr[5 + 3 * q] = faV3Hist.axis[q].shift;
+	  hdr[6 + 3 * q] = faV3Hist.axis[q].nbins;
+	}
+      if(fwrite(hdr, sizeof(hdr), 1, f) != 1)
+	rval = ERROR;
+
+      for(slot = 0; (slot < 32) && (rval == OK); slot++)
+	{
+	  if(!(faV3Hist.slotmask & (1u << slot)))
+	    continue;
+	  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+	    for(q = 0; q < FAV3_HIST_NQ; q++)
+	      {
+		faV3HistMerge(slot, chan, q, counts);
+		n = faV3Hist.axis[q].nbins + 2;
+		if(fwrite(counts, sizeof(uint32_t), n, f) != (size_t) n)
+		  rval = ERROR;
+	      }
+	}
+
+      if(rval != OK)
+	printf("%s: ERROR: Unable to write %s\n", __func__, filename);
+    }
+  HISTUNLOCK;
+
+  if(fclose(f) != 0)
+    rval = ERROR;
+  free(counts);
+
+  return rval;
+}
+
+/**
+ * @brief Show the state of the histograms
+ * @param pflag Print to standard out if non-zero
+ * @return Number of records filled, added up over all threads
+ */
+int32_t
+faV3HistStatus(int32_t pflag)
+{
+  faV3HistAcc_t *acc;
+  uint32_t nrec = 0, npulse = 0, nignored = 0, nbuffers = 0, ndecoded = 0;
+  int32_t q;
+
+  HISTLOCK;
+  for(acc = faV3Hist.acc; acc; acc = acc->next)
+    {
+      if(acc->reset_gen != faV3Hist.reset_gen)
+	continue;
+      nrec += acc->nrec;
+      npulse += acc->npulse;
+      nignored += acc->nignored;
+      nbuffers += acc->nbuffers;
+      ndecoded += acc->ndecoded;
+    }
+
+  if(pflag)
+    {
+      printf("faV3Hist: %s\n", faV3Hist.created ? "created" : "not created");
+      if(faV3Hist.created)
+	{
+	  printf("  Slots       0x%08x\n", faV3Hist.slotmask);
+	  printf("  Threads     %10d\n", faV3Hist.nacc);
+	  if(faV3Hist.prescale)
+	    printf("  Prescale    %10u\n", faV3Hist.prescale);
+	  else
+	    printf("  Prescale          auto\n");
+	  printf("  Buffers     %10u  (decoded %u)\n", nbuffers, ndecoded);
+	  printf("  Records     %10u  (other slots %u)\n", nrec, nignored);
+	  printf("  Pulses      %10u\n", npulse);
+	  printf("  Quantity         Min  Shift  Bins\n");
+	  for(q = 0; q < FAV3_HIST_NQ; q++)
+	    printf("  %-10s %9u  %5u  %4u\n", faV3HistNames[q],
+		   faV3Hist.axis[q].min, faV3Hist.axis[q].shift,
+		   faV3Hist.axis[q].nbins);
+	}
+    }
+  HISTUNLOCK;
+
+  return nrec;
+}
@@ -0,0 +1,64 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Hist.h
+ *
+ * @brief     Header for the online per-channel histograms of pulse
+ *            parameters
+ *
+ *            Cost, mode 9, 16 channels with one pulse, 100 kHz triggers,
+ *            1.15 GHz CPU (test/faV3HistBench):
+ *
+ *            faV3HistFillBuffer, automatic prescale: 2-3% of a readout
+ *            thread for a crate of 16 boards, under 2% for one board.
+ *            Buffers left out cost a few loads, whatever their size.
+ *
+ *            faV3HistFill on every record: 8-18 ns per record, 1-2% for
+ *            one board, 20-45% for a crate.  The records of a crate at
+ *            100 kHz leave about 2 ns each for 5% of a CPU, which no fill
+ *            of every record meets on this machine.
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Decoder.h"
+
+/* Histogrammed quantities */
+enum faV3HistQuantity_enum
+  {
+    FAV3_HIST_SUM,		/* pulse integral (adc_sum) */
+    FAV3_HIST_TIME,		/* time_coarse * 64 + time_fine */
+    FAV3_HIST_PEAK,		/* vpeak */
+    FAV3_HIST_PED,		/* pedestal sum (ped_sum) */
+    FAV3_HIST_NQ
+  };
+
+#define FAV3_HIST_MAX_BINS     16384
+
+/* Binary file written by faV3HistWrite.  All words are 32 bit, host order.
+     magic (FAV3_HIST_MAGIC), version, slotmask, FAV3_HIST_NQ
+     for each quantity: min, shift, nbins
+     for each slot in slotmask, channel 0-15, quantity:
+       underflow, nbins counts, overflow                                 */
+#define FAV3_HIST_MAGIC        0x66614869	/* "faHi" */
+#define FAV3_HIST_VERSION      1
+
+int32_t faV3HistCreate(uint32_t slotmask);
+int32_t faV3HistDestroy();
+int32_t faV3HistSetBinning(int32_t quantity, uint32_t min, uint32_t shift,
+			   uint32_t nbins);
+int32_t faV3HistGetBinning(int32_t quantity, uint32_t * min,
+			   uint32_t * shift, uint32_t * nbins);
+int32_t faV3HistFill(const faV3DecRecord_t * rec);
+int32_t faV3HistSetPrescale(uint32_t prescale);
+int32_t faV3HistFillBuffer(const uint32_t * buf, int32_t nwords,
+			   uint32_t flags);
+void faV3HistDecCallback(const faV3DecRecord_t * rec, void *arg);
+int32_t faV3HistReset();
+int32_t faV3HistGet(int32_t slot, int32_t chan, int32_t quantity,
+		    uint32_t * counts, int32_t maxbins);
+int32_t faV3HistWrite(const char *filename);
+int32_t faV3HistStatus(int32_t pflag);
@@ -0,0 +1,873 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ItrigEmu.c
+ *
+ * @brief     Software HITSUM internal trigger emulator.
+ *
+ *            Gives the internal trigger rate of a set of faItrigSetMode
+ *            parameters from recorded data, so they can be tuned offline.
+ *            faV3ItrigEmuScan runs many parameter sets on a pool of
+ *            threads.
+ *
+ *            Input is, for each 4 ns clock, the channels that are over
+ *            threshold: recorded hit patterns, or raw waveforms compared
+ *            with pedestal + threshold.  Only the clocks where a channel
+ *            goes over threshold (a new hit) are kept.
+ *
+ *            Hit bit: a new hit on channel c sets its hit bit hbDelay[c]
+ *              clocks later (plus the fixed FAV3_ITRIGEMU_LATENCY), for
+ *              hbWidth[c] + 1 clocks.  Another hit while it is set
+ *              extends it.  The pattern is the 16 hit bits.
+ *
+ *            Table: trigger when table[pattern] becomes 1.
+ *
+ *            Coincidence: trigger when all of the cMask hit bits become
+ *              set together.
+ *
+ *            Window: a hit bit of wMask that is newly set opens a window
+ *              of wWidth clocks.  The wMask hit bits set during the
+ *              window are latched, and at its end give a trigger if
+ *              table[latched] is 1.
+ *
+ *            Sum: trigger when the sum of the 16 channels (samples less
+ *              pedestal, 12 bits each) becomes >= sumThresh.  Needs raw
+ *              waveforms.
+ *
+ *            A trigger sets the output for trigWidth clocks, and no
+ *            trigger is made while it is set.  Trigger clocks are those of
+ *            the decision, without the latency, so the rates are exact
+ *            while the clocks of the triggers are relative to the data.
+ *
+ *            Time skips from one clock where the pattern can change (a
+ *            new hit, a hit bit that starts or ends, or a window end) to
+ *            the next, as nothing else changes the decision.  The
+ *            waveform thresholds, the channel sum and the sum threshold
+ *            scan use SSE2 when available.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAV3_ITRIGEMU_X86
+#endif
+#include "faV3ItrigEmu.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+#define FAV3_ITRIGEMU_DELAY_RING  16	/* > FAV3_ITRIG_MAX_HB_DELAY */
+#define FAV3_ITRIGEMU_SAMPLE_MAX  0x0FFF	/* 12 bits, overflow saturates */
+
+/**
+ * @brief Fill a configuration with the defaults of the internal trigger:
+ *        table mode with every pattern valid, the shortest hit bits and
+ *        trigger output, and no delays
+ */
+void
+faV3ItrigEmuDefaults(faV3ItrigEmuConfig_t * cfg)
+{
+  memset(cfg, 0, sizeof(faV3ItrigEmuConfig_t));
+
+  cfg->mode = FAV3_ITRIG_TABLE_MODE;
+  cfg->wWidth = 1;
+  cfg->wMask = 0xffff;
+  cfg->cMask = 0xffff;
+  cfg->trigWidth = FAV3_ITRIG_MIN_WIDTH;
+  cfg->table = NULL;
+}
+
+/* Allocate the new hit lists of data for nedge clocks */
+static int32_t
+faV3ItrigEmuAlloc(faV3ItrigEmuData_t * data, uint32_t nedge)
+{
+  data->nedge = nedge;
+  data->edge_clk = (uint32_t *) malloc((nedge + 1) * sizeof(uint32_t));
+  data->edge_mask = (uint16_t *) malloc((nedge + 1) * sizeof(uint16_t));
+  if((data->edge_clk == NULL) || (data->edge_mask == NULL))
+    {
+      printf("%s: ERROR: Unable to allocate %d new hits\n", __func__,
+	     nedge);
+      faV3ItrigEmuDataFree(data);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/**
+ * @brief Make emulator input from recorded hit patterns
+ * @param data Filled in.  Free with faV3ItrigEmuDataFree.
+ * @param hits For each clock, the channels over threshold (bit c for
+ *             channel c)
+ * @param nclk Number of clocks
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ItrigEmuDataFromHits(faV3ItrigEmuData_t * data, const uint16_t * hits,
+			 uint32_t nclk)
+{
+  uint32_t iclk, nedge = 0;
+  uint16_t prev = 0;
+
+  memset(data, 0, sizeof(faV3ItrigEmuData_t));
+  if((hits == NULL) || (nclk == 0))
+    {
+      printf("%s: ERROR: No hit patterns\n", __func__);
+      return ERROR;
+    }
+  data->nclk = nclk;
+
+  for(iclk = 0; iclk < nclk; iclk++)
+    {
+      if(hits[iclk] & ~prev)
+	nedge++;
+      prev = hits[iclk];
+    }
+
+  if(faV3ItrigEmuAlloc(data, nedge) != OK)
+    return ERROR;
+
+  nedge = 0;
+  prev = 0;
+  for(iclk = 0; iclk < nclk; iclk++)
+    {
+      if(hits[iclk] & ~prev)
+	{
+	  data->edge_clk[nedge] = iclk;
+	  data->edge_mask[nedge] = hits[iclk] & ~prev;
+	  nedge++;
+	}
+      prev = hits[iclk];
+    }
+
+  return OK;
+}
+
+/*
+ * Waveforms.  over: bit i of the mask is set if samples[i] > thr, with
+ * the mask from bit 0 of word 0.  Samples are at most 13 bits, so signed
+ * 16 bit compares are fine.  sum: add samples less the pedestal, 12 bits
+ * with the overflow bit saturating, to the channel sum.
+ */
+
+static void
+faV3ItrigEmuOverScalar(const uint16_t * samples, uint32_t n, uint16_t thr,
+		       uint32_t * mask)
+{
+  uint32_t i;
+
+  for(i = 0; i < n; i++)
+    if(samples[i] > thr)
+      mask[i >> 5] |= 1u << (i & 31);
+}
+
+static void
+faV3ItrigEmuSumScalar(const uint16_t * samples, uint32_t n, uint16_t ped,
+		      uint16_t * sum)
+{
+  uint32_t i;
+  uint16_t v;
+
+  for(i = 0; i < n; i++)
+    {
+      v = (samples[i] & 0x1000) ? FAV3_ITRIGEMU_SAMPLE_MAX :
+	(samples[i] & FAV3_ITRIGEMU_SAMPLE_MAX);
+      if(v > ped)
+	sum[i] += v - ped;
+    }
+}
+
+/* Sum mode triggers */
+typedef struct
+{
+  uint32_t ntrig;
+  uint32_t busy;		/* clock the trigger output ends */
+  uint32_t width;		/* of the trigger output */
+  uint32_t last;		/* sum >= thr the clock before */
+  uint32_t *trig_clk;
+  uint32_t maxtrig;
+} faV3ItrigEmuSumTrig_t;
+
+/* over: bit i set if the sum >= thr at clock iclk + i, for 16 clocks.
+   Trigger where it was below the clock before. */
+static inline void
+faV3ItrigEmuSumRise(faV3ItrigEmuSumTrig_t * st, uint32_t iclk, uint32_t over)
+{
+  uint32_t rise, clk;
+
+  rise = over & ~((over << 1) | st->last);
+  st->last = (over >> 15) & 1;
+
+  for(; rise; rise &= rise - 1)
+    {
+      clk = iclk + __builtin_ctz(rise);
+      if(clk >= st->busy)
+	{
+	  if(st->ntrig < st->maxtrig)
+	    st->trig_clk[st->ntrig] = clk;
+	  st->ntrig++;
+	  st->busy = clk + st->width;
+	}
+    }
+}
+
+/* Clocks from to n of the sum, 16 at a time from a multiple of 16 */
+static void
+faV3ItrigEmuSumScanScalar(const uint16_t * sum, uint32_t from, uint32_t n,
+			  uint16_t thr, faV3ItrigEmuSumTrig_t * st)
+{
+  uint32_t iclk, i, over;
+
+  for(iclk = from; iclk < n; iclk += 16)
+    {
+      over = 0;
+      for(i = 0; (i < 16) && (iclk + i < n); i++)
+	over |= (uint32_t) (sum[iclk + i] >= thr) << i;
+      faV3ItrigEmuSumRise(st, iclk, over);
+    }
+}
+
+#ifdef FAV3_ITRIGEMU_X86
+__attribute__ ((target("sse2")))
+static void
+faV3ItrigEmuOverSSE2(const uint16_t * samples, uint32_t n, uint16_t thr,
+		     uint32_t * mask)
+{
+  const __m128i t = _mm_set1_epi16((short) thr);
+  __m128i a, b;
+  uint32_t i;
+
+  /* 16 samples per pass */
+  for(i = 0; i + 16 <= n; i += 16)
+    {
+      a = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *) &samples[i]), t);
+      b = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *) &samples[i + 8]),
+			  t);
+      mask[i >> 5] |= ((uint32_t) _mm_movemask_epi8(_mm_packs_epi16(a, b)))
+	<< (i & 31);
+    }
+
+  /* The rest, with the mask still aligned: i is a multiple of 16 */
+  if(i < n)
+    {
+      uint32_t j, bits = 0;
+
+      for(j = i; j < n; j++)
+	if(samples[j] > thr)
+	  bits |= 1u << (j - i);
+      mask[i >> 5] |= bits << (i & 31);
+    }
+}
+
+__attribute__ ((target("sse2")))
+static void
+faV3ItrigEmuSumSSE2(const uint16_t * samples, uint32_t n, uint16_t ped,
+		    uint16_t * sum)
+{
+  const __m128i p = _mm_set1_epi16((short) ped);
+  const __m128i vmax = _mm_set1_epi16(FAV3_ITRIGEMU_SAMPLE_MAX);
+  __m128i s, ovf;
+  uint32_t i;
+
+  /* 8 samples per pass.  16 channels of 12 bits fit in 16 bits. */
+  for(i = 0; i + 8 <= n; i += 8)
+    {
+      s = _mm_loadu_si128((const __m128i *) &samples[i]);
+      ovf = _mm_srai_epi16(_mm_slli_epi16(s, 3), 15);	/* bit 12 */
+      s = _mm_and_si128(_mm_or_si128(s, ovf), vmax);
+      s = _mm_subs_epu16(s, p);
+      _mm_storeu_si128((__m128i *) & sum[i],
+		       _mm_add_epi16(_mm_loadu_si128((const __m128i *)
+						     &sum[i]), s));
+    }
+
+  faV3ItrigEmuSumScalar(&samples[i], n - i, ped, &sum[i]);
+}
+
+__attribute__ ((target("sse2")))
+static void
+faV3ItrigEmuSumScanSSE2(const uint16_t * sum, uint32_t n, uint16_t thr,
+			faV3ItrigEmuSumTrig_t * st)
+{
+  const __m128i t = _mm_set1_epi16((short) thr);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a, b;
+  uint32_t iclk, over;
+
+  /* sum >= thr where thr - sum saturates to 0.  16 clocks per pass. */
+  for(iclk = 0; iclk + 16 <= n; iclk += 16)
+    {
+      a = _mm_cmpeq_epi16(_mm_subs_epu16(t,
+					 _mm_loadu_si128((const __m128i *) &sum[iclk])),
+			  zero);
+      b = _mm_cmpeq_epi16(_mm_subs_epu16(t,
+					 _mm_loadu_si128((const __m128i *) &sum[iclk + 8])),
+			  zero);
+      over = (uint32_t) _mm_movemask_epi8(_mm_packs_epi16(a, b));
+      if(over | st->last)
+	faV3ItrigEmuSumRise(st, iclk, over);
+    }
+
+  faV3ItrigEmuSumScanScalar(sum, iclk, n, thr, st);
+}
+
+static int32_t
+faV3ItrigEmuSSE2()
+{
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("sse2"))
+    return 1;
+
+  return 0;
+}
+#endif /* FAV3_ITRIGEMU_X86 */
+
+/**
+ * @brief Make emulator input from raw waveforms
+ *
+ *   A channel is over threshold when its sample is > ped + thr, as with
+ *   the mode 9 TET.  The channel sum for sum mode is also made.
+ *
+ * @param data Filled in.  Free with faV3ItrigEmuDataFree.
+ * @param samples For each of the 16 channels, nclk raw samples (13 bits).
+ *                A NULL channel is never over threshold and adds nothing
+ *                to the sum.
+ * @param nclk Number of clocks (samples of each channel)
+ * @param ped Pedestal of each channel
+ * @param thr Threshold above pedestal of each channel.  0 leaves the
+ *            channel out of the hits, but not of the sum.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ItrigEmuDataFromSamples(faV3ItrigEmuData_t * data,
+			    const uint16_t * const *samples, uint32_t nclk,
+			    const uint16_t * ped, const uint16_t * thr)
+{
+  uint32_t *over[FAV3_MAX_ADC_CHANNELS];
+  uint32_t nwords, iword, prev[FAV3_MAX_ADC_CHANNELS], edge, pass;
+  uint32_t nedge = 0, bit;
+  uint16_t mask;
+  int32_t ichan, rval = ERROR;
+
+  memset(data, 0, sizeof(faV3ItrigEmuData_t));
+  memset(over, 0, sizeof(over));
+  if((samples == NULL) || (ped == NULL) || (thr == NULL) || (nclk == 0))
+    {
+      printf("%s: ERROR: No samples, pedestals or thresholds\n", __func__);
+      return ERROR;
+    }
+  data->nclk = nclk;
+  nwords = (nclk + 31) >> 5;
+
+  data->sum = (uint16_t *) calloc(nclk, sizeof(uint16_t));
+  if(data->sum == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate the channel sum\n", __func__);
+      return ERROR;
+    }
+
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    {
+      if(samples[ichan] == NULL)
+	continue;
+
+#ifdef FAV3_ITRIGEMU_X86
+      if(faV3ItrigEmuSSE2())
+	faV3ItrigEmuSumSSE2(samples[ichan], nclk, ped[ichan], data->sum);
+      else
+#endif
+	faV3ItrigEmuSumScalar(samples[ichan], nclk, ped[ichan], data->sum);
+
+      if(thr[ichan] == 0)
+	continue;
+
+      over[ichan] = (uint32_t *) calloc(nwords, sizeof(uint32_t));
+      if(over[ichan] == NULL)
+	{
+	  printf("%s: ERROR: Unable to allocate the channel %d hits\n",
+		 __func__, ichan);
+	  goto CLEANUP;
+	}
+
+#ifdef FAV3_ITRIGEMU_X86
+      if(faV3ItrigEmuSSE2())
+	faV3ItrigEmuOverSSE2(samples[ichan], nclk, ped[ichan] + thr[ichan],
+			     over[ichan]);
+      else
+#endif
+	faV3ItrigEmuOverScalar(samples[ichan], nclk, ped[ichan] + thr[ichan],
+			       over[ichan]);
+    }
+
+  /* New hits: over, and not over the clock before.  Counted, then
+     listed. */
+  for(pass = 0; pass < 2; pass++)
+    {
+      memset(prev, 0, sizeof(prev));
+      nedge = 0;
+      for(iword = 0; iword < nwords; iword++)
+	{
+	  uint32_t edges[FAV3_MAX_ADC_CHANNELS], all = 0;
+
+	  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	    {
+	      if(over[ichan] == NULL)
+		{
+		  edges[ichan] = 0;
+		  continue;
+		}
+	      edge = over[ichan][iword] & ~((over[ichan][iword] << 1) | prev[ichan]);
+	      prev[ichan] = over[ichan][iword] >> 31;
+	      edges[ichan] = edge;
+	      all |= edge;
+	    }
+
+	  while(all)
+	    {
+	      bit = __builtin_ctz(all);
+	      if(pass)
+		{
+		  mask = 0;
+		  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+		    mask |= ((edges[ichan] >> bit) & 1) << ichan;
+		  data->edge_clk[nedge] = (iword << 5) + bit;
+		  data->edge_mask[nedge] = mask;
+		}
+	      nedge++;
+	      all &= all - 1;
+	    }
+	}
+
+      if(!pass && (faV3ItrigEmuAlloc(data, nedge) != OK))
+	goto CLEANUP;
+    }
+
+  rval = OK;
+
+ CLEANUP:
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    if(over[ichan])
+      free(over[ichan]);
+
+  if(rval != OK)
+    faV3ItrigEmuDataFree(data);
+
+  return rval;
+}
+
+/**
+ * @brief Free the emulator input
+ */
+void
+faV3ItrigEmuDataFree(faV3ItrigEmuData_t * data)
+{
+  if(data->edge_clk)
+    free(data->edge_clk);
+  if(data->edge_mask)
+    free(data->edge_mask);
+  if(data->sum)
+    free(data->sum);
+
+  memset(data, 0, sizeof(faV3ItrigEmuData_t));
+}
+
+static int32_t
+faV3ItrigEmuCheck(const faV3ItrigEmuConfig_t * cfg,
+		  const faV3ItrigEmuData_t * data)
+{
+  int32_t ichan;
+
+  switch (cfg->mode)
+    {
+    case FAV3_ITRIG_TABLE_MODE:
+      break;
+
+    case FAV3_ITRIG_COIN_MODE:
+      if((cfg->cMask == 0) || (cfg->cMask > 0xffff))
+	{
+	  printf("%s: ERROR: Coincidence channel mask out of range (0<cc<=0xffff)\n",
+		 __func__);
+	  return ERROR;
+	}
+      break;
+
+    case FAV3_ITRIG_WINDOW_MODE:
+      if((cfg->wMask == 0) || (cfg->wMask > 0xffff))
+	{
+	  printf("%s: ERROR: Trigger Window channel mask out of range (0<wc<=0xffff)\n",
+		 __func__);
+	  return ERROR;
+	}
+      if((cfg->wWidth == 0) || (cfg->wWidth > FAV3_ITRIG_WINDOW_MAX_WIDTH))
+	{
+	  printf("%s: ERROR: Trigger Window width out of range (0<ww<=0x%x)\n",
+		 __func__, FAV3_ITRIG_WINDOW_MAX_WIDTH);
+	  return ERROR;
+	}
+      break;
+
+    case FAV3_ITRIG_SUM_MODE:
+      if((cfg->sumThresh == 0) || (cfg->sumThresh > 0xffff))
+	{
+	  printf("%s: ERROR: Sum Threshold out of range (0<st<=0xffff)\n",
+		 __func__);
+	  return ERROR;
+	}
+      if(data->sum == NULL)
+	{
+	  printf("%s: ERROR: Sum mode needs waveforms (faV3ItrigEmuDataFromSamples)\n",
+		 __func__);
+	  return ERROR;
+	}
+      break;
+
+    default:
+      printf("%s: ERROR: Trigger mode (%d) out of range (tmode = 0-2,4)\n",
+	     __func__, cfg->mode);
+      return ERROR;
+    }
+
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    {
+      if((cfg->hbWidth[ichan] > FAV3_ITRIG_MAX_HB_WIDTH) ||
+	 (cfg->hbDelay[ichan] > FAV3_ITRIG_MAX_HB_DELAY))
+	{
+	  printf("%s: ERROR: Channel %d hit bit width (%d) or delay (%d) out of range\n",
+		 __func__, ichan, cfg->hbWidth[ichan], cfg->hbDelay[ichan]);
+	  return ERROR;
+	}
+    }
+
+  if(cfg->trigWidth > FAV3_ITRIG_MAX_WIDTH)
+    {
+      printf("%s: ERROR: Trigger output width out of range (<=0x%x)\n",
+	     __func__, FAV3_ITRIG_MAX_WIDTH);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/* table[pattern], with NULL for every pattern but 0 */
+static inline int32_t
+faV3ItrigEmuTable(const uint32_t * table, uint32_t pattern)
+{
+  if(table == NULL)
+    return (pattern != 0);
+
+  return (pattern != 0) && table[pattern];
+}
+
+/* Sum mode */
+static uint32_t
+faV3ItrigEmuSum(const faV3ItrigEmuConfig_t * cfg,
+		const faV3ItrigEmuData_t * data, uint32_t * trig_clk,
+		uint32_t maxtrig)
+{
+  faV3ItrigEmuSumTrig_t st;
+
+  memset(&st, 0, sizeof(st));
+  st.width = (cfg->trigWidth > 0) ? cfg->trigWidth : 1;
+  st.trig_clk = trig_clk;
+  st.maxtrig = maxtrig;
+
+#ifdef FAV3_ITRIGEMU_X86
+  if(faV3ItrigEmuSSE2())
+    faV3ItrigEmuSumScanSSE2(data->sum, data->nclk, cfg->sumThresh, &st);
+  else
+#endif
+    faV3ItrigEmuSumScanScalar(data->sum, 0, data->nclk, cfg->sumThresh,
+			      &st);
+
+  return st.ntrig;
+}
+
+/* Table, coincidence and window modes */
+static uint32_t
+faV3ItrigEmuHits(const faV3ItrigEmuConfig_t * cfg,
+		 const faV3ItrigEmuData_t * data, uint32_t * trig_clk,
+		 uint32_t maxtrig)
+{
+  uint32_t end[FAV3_MAX_ADC_CHANNELS];	/* clock after the hit bit */
+  uint32_t width[FAV3_MAX_ADC_CHANNELS], delay[FAV3_MAX_ADC_CHANNELS];
+  uint16_t ring[FAV3_ITRIGEMU_DELAY_RING];	/* new hit bits, by clock */
+  uint32_t ringmask = 0;	/* ring entries that are set */
+  uint32_t iclk, iedge = 0, ntrig = 0, busy = 0, trigwidth, next, bits;
+  uint32_t pattern = 0, prev = 0, latch = 0, wend = 0, slot;
+  int32_t ichan, cond, prevcond = 0, wopen = 0, trig;
+
+  if(data->nedge == 0)
+    return 0;
+  iclk = data->edge_clk[0];
+
+  trigwidth = (cfg->trigWidth > 0) ? cfg->trigWidth : 1;
+
+  memset(end, 0, sizeof(end));
+  memset(ring, 0, sizeof(ring));
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    {
+      width[ichan] = cfg->hbWidth[ichan] + 1;
+      delay[ichan] = cfg->hbDelay[ichan];
+    }
+
+  /* Only the channels with a hit bit, or one on the way, are looked at */
+  while(1)
+    {
+      if((iedge < data->nedge) && (data->edge_clk[iedge] == iclk))
+	{
+	  for(bits = data->edge_mask[iedge]; bits; bits &= bits - 1)
+	    {
+	      ichan = __builtin_ctz(bits);
+	      slot = (iclk + delay[ichan]) % FAV3_ITRIGEMU_DELAY_RING;
+	      ring[slot] |= 1 << ichan;
+	      ringmask |= 1 << slot;
+	    }
+	  iedge++;
+	}
+
+      /* Hit bits that end, then those that start, this clock */
+      for(bits = pattern; bits; bits &= bits - 1)
+	{
+	  ichan = __builtin_ctz(bits);
+	  if(end[ichan] <= iclk)
+	    pattern &= ~(1 << ichan);
+	}
+
+      slot = iclk % FAV3_ITRIGEMU_DELAY_RING;
+      if(ringmask & (1 << slot))
+	{
+	  for(bits = ring[slot]; bits; bits &= bits - 1)
+	    {
+	      ichan = __builtin_ctz(bits);
+	      end[ichan] = iclk + width[ichan];
+	    }
+	  pattern |= ring[slot];
+	  ring[slot] = 0;
+	  ringmask &= ~(1 << slot);
+	}
+
+      trig = 0;
+      switch (cfg->mode)
+	{
+	case FAV3_ITRIG_TABLE_MODE:
+	  cond = faV3ItrigEmuTable(cfg->table, pattern);
+	  trig = cond && !prevcond;
+	  prevcond = cond;
+	  break;
+
+	case FAV3_ITRIG_COIN_MODE:
+	  cond = ((pattern & cfg->cMask) == cfg->cMask);
+	  trig = cond && !prevcond;
+	  prevcond = cond;
+	  break;
+
+	case FAV3_ITRIG_WINDOW_MODE:
+	  if(!wopen && (pattern & ~prev & cfg->wMask) && (iclk >= busy))
+	    {
+	      wopen = 1;
+	      wend = iclk + cfg->wWidth;
+	      latch = 0;
+	    }
+	  if(wopen)
+	    {
+	      latch |= pattern & cfg->wMask;
+	      if(iclk + 1 >= wend)
+		{
+		  wopen = 0;
+		  trig = faV3ItrigEmuTable(cfg->table, latch);
+		}
+	    }
+	  break;
+	}
+
+      if(trig && (iclk >= busy))
+	{
+	  if(ntrig < maxtrig)
+	    trig_clk[ntrig] = iclk;
+	  ntrig++;
+	  busy = iclk + trigwidth;
+	}
+
+      prev = pattern;
+
+      /* Next clock where the pattern or the window can change: a new
+         hit, a hit bit that starts or ends, or the end of the window.
+         Until then the decision is the same as this clock. */
+      next = (iedge < data->nedge) ? data->edge_clk[iedge] : data->nclk;
+      if(ringmask)
+	{
+	  /* The ring from the next clock on, in clock order */
+	  slot = (iclk + 1) % FAV3_ITRIGEMU_DELAY_RING;
+	  bits = (ringmask >> slot) |
+	    (ringmask << (FAV3_ITRIGEMU_DELAY_RING - slot));
+	  bits = iclk + 1 + __builtin_ctz(bits);
+	  if(bits < next)
+	    next = bits;
+	}
+      for(bits = pattern; bits; bits &= bits - 1)
+	{
+	  ichan = __builtin_ctz(bits);
+	  if(end[ichan] < next)
+	    next = end[ichan];
+	}
+      if(wopen && (wend - 1 < next))
+	next = wend - 1;
+
+      if(next >= data->nclk)
+	break;
+      iclk = next;
+    }
+
+  return ntrig;
+}
+
+/**
+ * @brief Emulate the internal trigger for one set of parameters
+ * @param cfg Internal trigger settings
+ * @param data Input, from faV3ItrigEmuDataFromHits/FromSamples
+ * @param res Number of triggers and rate
+ * @param trig_clk If not NULL, the clocks of the first maxtrig triggers
+ * @param maxtrig Size of trig_clk
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ItrigEmuRun(const faV3ItrigEmuConfig_t * cfg,
+		const faV3ItrigEmuData_t * data, faV3ItrigEmuResult_t * res,
+		uint32_t * trig_clk, uint32_t maxtrig)
+{
+  memset(res, 0, sizeof(faV3ItrigEmuResult_t));
+  res->status = ERROR;
+
+  if((cfg == NULL) || (data == NULL) || (data->nclk == 0))
+    {
+      printf("%s: ERROR: No configuration or data\n", __func__);
+      return ERROR;
+    }
+
+  if(faV3ItrigEmuCheck(cfg, data) != OK)
+    return ERROR;
+
+  if(trig_clk == NULL)
+    maxtrig = 0;
+
+  if(cfg->mode == FAV3_ITRIG_SUM_MODE)
+    res->ntrig = faV3ItrigEmuSum(cfg, data, trig_clk, maxtrig);
+  else
+    res->ntrig = faV3ItrigEmuHits(cfg, data, trig_clk, maxtrig);
+
+  res->rate = res->ntrig /
+    ((double) data->nclk * FAV3_ADC_NS_PER_CLK * 1e-9);
+  res->status = OK;
+
+  return OK;
+}
+
+typedef struct
+{
+  const faV3ItrigEmuConfig_t *cfg;
+  const faV3ItrigEmuData_t *data;
+  faV3ItrigEmuResult_t *res;
+  int32_t ncfg;
+  int32_t next;
+  pthread_mutex_t mutex;
+} faV3ItrigEmuScan_t;
+
+/* Each worker takes the next parameter set until there are none left */
+static void *
+faV3ItrigEmuWorker(void *arg)
+{
+  faV3ItrigEmuScan_t *scan = (faV3ItrigEmuScan_t *) arg;
+  int32_t icfg;
+
+  while(1)
+    {
+      pthread_mutex_lock(&scan->mutex);
+      icfg = scan->next++;
+      pthread_mutex_unlock(&scan->mutex);
+
+      if(icfg >= scan->ncfg)
+	break;
+
+      faV3ItrigEmuRun(&scan->cfg[icfg], scan->data, &scan->res[icfg],
+		      NULL, 0);
+    }
+
+  return NULL;
+}
+
+/**
+ * @brief Emulate the internal trigger for many sets of parameters
+ * @param cfg Array of ncfg internal trigger settings
+ * @param ncfg Number of settings
+ * @param data Input, from faV3ItrigEmuDataFromHits/FromSamples
+ * @param res Array of ncfg results.  A bad setting has status ERROR.
+ * @param nthreads Number of threads, including the calling one
+ * @return Number of settings that were bad, otherwise ERROR
+ */
+int32_t
+faV3ItrigEmuScan(const faV3ItrigEmuConfig_t * cfg, int32_t ncfg,
+		 const faV3ItrigEmuData_t * data, faV3ItrigEmuResult_t * res,
+		 int32_t nthreads)
+{
+  pthread_t thread[FAV3_ITRIGEMU_MAX_THREADS];
+  faV3ItrigEmuScan_t scan;
+  int32_t icfg, ithread, nstarted, nbad = 0;
+
+  if((cfg == NULL) || (data == NULL) || (res == NULL) || (ncfg <= 0))
+    {
+      printf("%s: ERROR: No configurations, data or results\n", __func__);
+      return ERROR;
+    }
+
+  if((nthreads <= 0) || (nthreads > FAV3_ITRIGEMU_MAX_THREADS))
+    {
+      printf("%s: ERROR: Invalid number of threads (%d)\n", __func__,
+	     nthreads);
+      return ERROR;
+    }
+
+  if(nthreads > ncfg)
+    nthreads = ncfg;
+
+  scan.cfg = cfg;
+  scan.data = data;
+  scan.res = res;
+  scan.ncfg = ncfg;
+  scan.next = 0;
+  pthread_mutex_init(&scan.mutex, NULL);
+
+  /* This thread runs settings too, so one fewer is started */
+  for(nstarted = 0; nstarted < nthreads - 1; nstarted++)
+    {
+      if(pthread_create(&thread[nstarted], NULL, faV3ItrigEmuWorker,
+			&scan) != 0)
+	{
+	  perror("pthread_create");
+	  break;
+	}
+    }
+
+  faV3ItrigEmuWorker(&scan);
+
+  for(ithread = 0; ithread < nstarted; ithread++)
+    pthread_join(thread[ithread], NULL);
+
+  pthread_mutex_destroy(&scan.mutex);
+
+  for(icfg = 0; icfg < ncfg; icfg++)
+    if(res[icfg].status != OK)
+      nbad++;
+
+  return nbad;
+}
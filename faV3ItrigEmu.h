@@ -0,0 +1,77 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ItrigEmu.h
+ *
+ * @brief     Header for the software HITSUM internal trigger emulator
+ *
+ *            Works on recorded hit patterns or raw waveforms, does no
+ *            I/O and has no global state, so it may be run on many threads.
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Lib.h"
+
+#define FAV3_ITRIGEMU_MAX_THREADS  64
+#define FAV3_ITRIGEMU_LATENCY      7	/* clocks of hit bit delay at a
+					   delay register value of 0 */
+
+/* The internal trigger settings, as programmed by faItrigSetMode,
+   faItrigInitTable, faItrigSetHBwidth, faItrigSetHBdelay and
+   faItrigSetOutWidth.  Times are in clocks (FAV3_ADC_NS_PER_CLK). */
+typedef struct faV3ItrigEmuConfig_struct
+{
+  int32_t mode;			/* FAV3_ITRIG_{TABLE,COIN,WINDOW,SUM}_MODE */
+  uint32_t wWidth;		/* window mode: width of the window */
+  uint32_t wMask;		/* window mode: channels that open the window */
+  uint32_t cMask;		/* coincidence mode: channels required */
+  uint32_t sumThresh;		/* sum mode: threshold of the channel sum */
+  uint16_t hbWidth[FAV3_MAX_ADC_CHANNELS];	/* hit bit width register
+						   value: hbWidth + 1 clocks */
+  uint16_t hbDelay[FAV3_MAX_ADC_CHANNELS];	/* hit bit delay register
+						   value */
+  uint32_t trigWidth;		/* trigger output width.  No trigger is made
+				   while the output is high. */
+  const uint32_t *table;	/* table and window modes: 65536 values (1 or
+				   0), NULL for every pattern but 0 */
+} faV3ItrigEmuConfig_t;
+
+/* Input to the emulator, from faV3ItrigEmuDataFromHits or
+   faV3ItrigEmuDataFromSamples.  The same data may be used by any number
+   of threads. */
+typedef struct faV3ItrigEmuData_struct
+{
+  uint32_t nclk;		/* clocks recorded */
+  uint32_t nedge;		/* clocks with a new hit */
+  uint32_t *edge_clk;		/* clock of each */
+  uint16_t *edge_mask;		/* channels with a new hit at that clock */
+  uint16_t *sum;		/* channel sum at each clock, for sum mode,
+				   or NULL */
+} faV3ItrigEmuData_t;
+
+typedef struct faV3ItrigEmuResult_struct
+{
+  int32_t status;		/* OK, or ERROR if the configuration is bad */
+  uint32_t ntrig;
+  double rate;			/* Hz */
+} faV3ItrigEmuResult_t;
+
+void faV3ItrigEmuDefaults(faV3ItrigEmuConfig_t * cfg);
+int32_t faV3ItrigEmuDataFromHits(faV3ItrigEmuData_t * data,
+				 const uint16_t * hits, uint32_t nclk);
+int32_t faV3ItrigEmuDataFromSamples(faV3ItrigEmuData_t * data,
+				    const uint16_t * const *samples,
+				    uint32_t nclk, const uint16_t * ped,
+				    const uint16_t * thr);
+void faV3ItrigEmuDataFree(faV3ItrigEmuData_t * data);
+int32_t faV3ItrigEmuRun(const faV3ItrigEmuConfig_t * cfg,
+			const faV3ItrigEmuData_t * data,
+			faV3ItrigEmuResult_t * res, uint32_t * trig_clk,
+			uint32_t maxtrig);
+int32_t faV3ItrigEmuScan(const faV3ItrigEmuConfig_t * cfg, int32_t ncfg,
+			 const faV3ItrigEmuData_t * data,
+			 faV3ItrigEmuResult_t * res, int32_t nthreads);
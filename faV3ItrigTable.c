@@ -0,0 +1,392 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ItrigTable.c
+ *
+ * @brief     HITSUM trigger tables, on the host.
+ *
+ *            Builds the 65536 entry table of faItrigInitTable from a
+ *            boolean expression or a list of channel combinations, and
+ *            finds the runs of entries that differ between two tables,
+ *            so that a board can be loaded with only those.  Does no I/O.
+ *
+ *            faV3Itrig.c, which loads the table into the board, is not
+ *            built: faV3_t has no hitsum register block.  It is left as
+ *            it came, with the single library lock and direct register
+ *            access, still writing all 65536 entries.  Once it has a
+ *            register map, it needs the per-slot locks and the register
+ *            shadow of faV3Lib.c, and its table load should keep a packed
+ *            copy of what each board holds and write only the runs from
+ *            faItrigTableNextRun (test/faV3ItrigTableBench counts those
+ *            writes).
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "faV3Lib.h"
+#include "faV3ItrigTable.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+/************************************************************
+ *
+ *  Pack a table of 65536 values (1 or 0) into bits, one per input
+ *  pattern.  Address 0 is never a valid trigger.
+ */
+void
+faItrigPackTable(const uint32_t * table, uint32_t * bits)
+{
+  int ii;
+
+  memset(bits, 0, FAV3_ITRIG_TABLE_WORDS * sizeof(uint32_t));
+  for(ii = 1; ii < FAV3_ITRIG_TABLE_SIZE; ii++)
+    if(table[ii])
+      bits[ii >> 5] |= 1u << (ii & 31);
+}
+
+/************************************************************
+ *
+ *  Next run of addresses where two packed tables differ
+ *    from, to = packed tables (faItrigPackTable)
+ *    addr     = address to start looking at.  Set to the start of
+ *               the run.
+ *  Returns the length of the run, or 0 if there is none.  Loading the
+ *  run takes a write of the auto-increment address and one write per
+ *  entry.
+ */
+int
+faItrigTableNextRun(const uint32_t * from, const uint32_t * to,
+		    uint32_t * addr)
+{
+  uint32_t iword, diff, start;
+
+  if(*addr >= FAV3_ITRIG_TABLE_SIZE)
+    return 0;
+
+  /* First entry that differs */
+  iword = *addr >> 5;
+  diff = (from[iword] ^ to[iword]) & (0xFFFFFFFF << (*addr & 31));
+  while(diff == 0)
+    {
+      if(++iword == FAV3_ITRIG_TABLE_WORDS)
+	return 0;
+      diff = from[iword] ^ to[iword];
+    }
+  start = (iword << 5) + __builtin_ctz(diff);
+
+  /* First entry after it that is the same */
+  diff = ~(from[iword] ^ to[iword]) & (0xFFFFFFFF << (start & 31));
+  while(diff == 0)
+    {
+      if(++iword == FAV3_ITRIG_TABLE_WORDS)
+	{
+	  *addr = start;
+	  return FAV3_ITRIG_TABLE_SIZE - start;
+	}
+      diff = ~(from[iword] ^ to[iword]);
+    }
+
+  *addr = start;
+  return (iword << 5) + __builtin_ctz(diff) - start;
+}
+
+/************************************************************
+ *
+ *  Trigger table builder
+ *
+ *   The expression is of channels 0-15 (a channel is 1 when its hit
+ *   bit is set), with
+ *     !  not         &  and
+ *     ^  xor         |  or
+ *   in order of precedence, and parentheses.  e.g.
+ *     "(0 & 1) | (2 & 3) | (14 & !15)"
+ *   It is compiled to postfix, then evaluated for 32 input patterns at
+ *   a time: bit k of the word for patterns 32*w to 32*w+31 is pattern
+ *   32*w+k.
+ */
+
+#define FAV3_ITRIG_EXPR_MAX_OPS   256
+#define FAV3_ITRIG_EXPR_MAX_DEPTH 32
+
+enum faItrigExprOp_enum
+  {
+    /* 0-15 push a channel */
+    FAV3_ITRIG_OP_NOT = FAV3_MAX_ADC_CHANNELS,
+    FAV3_ITRIG_OP_AND,
+    FAV3_ITRIG_OP_XOR,
+    FAV3_ITRIG_OP_OR
+  };
+
+typedef struct
+{
+  const char *expr;
+  const char *pos;
+  int error;
+  int nop;
+  int depth, maxdepth;		/* of the evaluation stack */
+  uint8_t op[FAV3_ITRIG_EXPR_MAX_OPS];
+} faItrigExpr_t;
+
+static void faItrigExprOr(faItrigExpr_t * e);
+
+static void
+faItrigExprError(faItrigExpr_t * e, const char *what)
+{
+  if(e->error)
+    return;
+
+  printf("faItrigBuildTable: ERROR: %s at column %d of \"%s\"\n",
+	 what, (int) (e->pos - e->expr) + 1, e->expr);
+  e->error = 1;
+}
+
+static char
+faItrigExprPeek(faItrigExpr_t * e)
+{
+  while(isspace((unsigned char) *e->pos))
+    e->pos++;
+
+  return *e->pos;
+}
+
+/* Emit an op.  Channels push, binary ops pop one. */
+static void
+faItrigExprEmit(faItrigExpr_t * e, int op)
+{
+  if(e->error)
+    return;
+
+  if(e->nop == FAV3_ITRIG_EXPR_MAX_OPS)
+    {
+      faItrigExprError(e, "Expression too long");
+      return;
+    }
+  e->op[e->nop++] = op;
+
+  if(op < FAV3_MAX_ADC_CHANNELS)
+    {
+      if(++e->depth > e->maxdepth)
+	e->maxdepth = e->depth;
+    }
+  else if(op != FAV3_ITRIG_OP_NOT)
+    e->depth--;
+}
+
+static void
+faItrigExprFactor(faItrigExpr_t * e)
+{
+  char c = faItrigExprPeek(e);
+  int chan = 0;
+
+  if(c == '!')
+    {
+      e->pos++;
+      faItrigExprFactor(e);
+      faItrigExprEmit(e, FAV3_ITRIG_OP_NOT);
+    }
+  else if(c == '(')
+    {
+      e->pos++;
+      faItrigExprOr(e);
+      if(faItrigExprPeek(e) != ')')
+	faItrigExprError(e, "Expected ')'");
+      else
+	e->pos++;
+    }
+  else if(isdigit((unsigned char) c))
+    {
+      while(isdigit((unsigned char) *e->pos) && (chan < FAV3_MAX_ADC_CHANNELS))
+	chan = 10 * chan + (*e->pos++ - '0');
+      if(chan >= FAV3_MAX_ADC_CHANNELS)
+	faItrigExprError(e, "Channel out of range (0-15)");
+      else
+	faItrigExprEmit(e, chan);
+    }
+  else
+    faItrigExprError(e, (c == 0) ? "Unexpected end" : "Expected a channel");
+}
+
+static void
+faItrigExprAnd(faItrigExpr_t * e)
+{
+  faItrigExprFactor(e);
+  while(!e->error && (faItrigExprPeek(e) == '&'))
+    {
+      e->pos++;
+      faItrigExprFactor(e);
+      faItrigExprEmit(e, FAV3_ITRIG_OP_AND);
+    }
+}
+
+static void
+faItrigExprXor(faItrigExpr_t * e)
+{
+  faItrigExprAnd(e);
+  while(!e->error && (faItrigExprPeek(e) == '^'))
+    {
+      e->pos++;
+      faItrigExprAnd(e);
+      faItrigExprEmit(e, FAV3_ITRIG_OP_XOR);
+    }
+}
+
+static void
+faItrigExprOr(faItrigExpr_t * e)
+{
+  faItrigExprXor(e);
+  while(!e->error && (faItrigExprPeek(e) == '|'))
+    {
+      e->pos++;
+      faItrigExprXor(e);
+      faItrigExprEmit(e, FAV3_ITRIG_OP_OR);
+    }
+}
+
+/* Hit bit of a channel for patterns 32*iword to 32*iword+31 */
+static inline uint32_t
+faItrigChanWord(int chan, uint32_t iword)
+{
+  static const uint32_t low[5] =
+    { 0xAAAAAAAA, 0xCCCCCCCC, 0xF0F0F0F0, 0xFF00FF00, 0xFFFF0000 };
+
+  if(chan < 5)
+    return low[chan];
+
+  return ((iword >> (chan - 5)) & 1) ? 0xFFFFFFFF : 0;
+}
+
+/* Expand packed bits to a table of 65536 values (1 or 0) */
+void
+faItrigUnpackTable(const uint32_t * bits, uint32_t * table)
+{
+  int ii;
+
+  for(ii = 0; ii < FAV3_ITRIG_TABLE_SIZE; ii++)
+    table[ii] = (bits[ii >> 5] >> (ii & 31)) & 1;
+}
+
+/************************************************************
+ *
+ *  Build a trigger table from a boolean expression of the channels
+ *    expr  = e.g. "(0 & 1) | (2 & 3)"
+ *    table = array of 65536 values (1 or 0), for faItrigInitTable
+ *  Address 0 (no channels hit) is never a valid trigger.
+ */
+int
+faItrigBuildTable(const char *expr, uint32_t * table)
+{
+  faItrigExpr_t e;
+  uint32_t bits[FAV3_ITRIG_TABLE_WORDS];
+  uint32_t stack[FAV3_ITRIG_EXPR_MAX_DEPTH];
+  uint32_t iword;
+  int iop, sp, op;
+
+  if((expr == NULL) || (table == NULL))
+    {
+      printf("faItrigBuildTable: ERROR: NULL expression or table\n");
+      return ERROR;
+    }
+
+  memset(&e, 0, sizeof(e));
+  e.expr = e.pos = expr;
+
+  faItrigExprOr(&e);
+  if(!e.error && (faItrigExprPeek(&e) != 0))
+    faItrigExprError(&e, "Unexpected character");
+  if(!e.error && (e.maxdepth > FAV3_ITRIG_EXPR_MAX_DEPTH))
+    faItrigExprError(&e, "Expression nested too deep");
+  if(e.error)
+    return ERROR;
+
+  for(iword = 0; iword < FAV3_ITRIG_TABLE_WORDS; iword++)
+    {
+      sp = 0;
+      for(iop = 0; iop < e.nop; iop++)
+	{
+	  op = e.op[iop];
+	  switch (op)
+	    {
+	    case FAV3_ITRIG_OP_NOT:
+	      stack[sp - 1] = ~stack[sp - 1];
+	      break;
+	    case FAV3_ITRIG_OP_AND:
+	      sp--;
+	      stack[sp - 1] &= stack[sp];
+	      break;
+	    case FAV3_ITRIG_OP_XOR:
+	      sp--;
+	      stack[sp - 1] ^= stack[sp];
+	      break;
+	    case FAV3_ITRIG_OP_OR:
+	      sp--;
+	      stack[sp - 1] |= stack[sp];
+	      break;
+	    default:
+	      stack[sp++] = faItrigChanWord(op, iword);
+	    }
+	}
+      bits[iword] = stack[0];
+    }
+  bits[0] &= ~1u;
+
+  faItrigUnpackTable(bits, table);
+
+  return OK;
+}
+
+/************************************************************
+ *
+ *  Build a trigger table from a list of channel combinations
+ *    combo  = array of channel masks.  A pattern triggers when all of
+ *             the channels of any of the masks are hit.
+ *    ncombo = number of masks
+ *    table  = array of 65536 values (1 or 0), for faItrigInitTable
+ */
+int
+faItrigBuildTableList(const uint16_t * combo, int ncombo, uint32_t * table)
+{
+  uint32_t bits[FAV3_ITRIG_TABLE_WORDS], word;
+  uint32_t iword;
+  int icombo, chan;
+
+  if((combo == NULL) || (table == NULL) || (ncombo <= 0))
+    {
+      printf("faItrigBuildTableList: ERROR: No combinations or table\n");
+      return ERROR;
+    }
+
+  for(icombo = 0; icombo < ncombo; icombo++)
+    if(combo[icombo] == 0)
+      {
+	printf("faItrigBuildTableList: ERROR: Combination %d has no channels\n",
+	       icombo);
+	return ERROR;
+      }
+
+  memset(bits, 0, sizeof(bits));
+  for(iword = 0; iword < FAV3_ITRIG_TABLE_WORDS; iword++)
+    {
+      for(icombo = 0; icombo < ncombo; icombo++)
+	{
+	  word = 0xFFFFFFFF;
+	  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+	    if(combo[icombo] & (1 << chan))
+	      word &= faItrigChanWord(chan, iword);
+	  bits[iword] |= word;
+	}
+    }
+  bits[0] &= ~1u;
+
+  faItrigUnpackTable(bits, table);
+
+  return OK;
+}
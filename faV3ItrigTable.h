@@ -0,0 +1,25 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ItrigTable.h
+ *
+ * @brief     Header for the HITSUM trigger table builder
+ *
+ */
+
+#include <stdint.h>
+
+#define FAV3_ITRIG_TABLE_SIZE 0x10000	/* trigger table entries, one per
+					   input pattern */
+#define FAV3_ITRIG_TABLE_WORDS (FAV3_ITRIG_TABLE_SIZE >> 5)	/* packed */
+
+int faItrigBuildTable(const char *expr, uint32_t * table);
+int faItrigBuildTableList(const uint16_t * combo, int ncombo,
+			  uint32_t * table);
+void faItrigPackTable(const uint32_t * table, uint32_t * bits);
+void faItrigUnpackTable(const uint32_t * bits, uint32_t * table);
+int faItrigTableNextRun(const uint32_t * from, const uint32_t * to,
+			uint32_t * addr);
@@ -40,6 +40,9 @@
 #include <vxLib.h>
 #else
 #include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/eventfd.h>
 #endif
 
 
@@ -49,11 +52,22 @@
 #ifdef VXWORKS
 #define FAV3LOCK
 #define FAV3UNLOCK
+#define FAV3SLOTLOCK(_id)
+#define FAV3SLOTUNLOCK(_id)
 #else
-/* Mutex to guard flexio read/writes */
+/* Mutex to guard crate-wide state: the multiblock window (FAV3pmb),
+   the token passing chain, the DMA engine and the SDC.
+   Lock order: faV3Mutex first, then at most one slot mutex. */
 pthread_mutex_t faV3Mutex = PTHREAD_MUTEX_INITIALIZER;
 #define FAV3LOCK      if(pthread_mutex_lock(&faV3Mutex)<0) perror("pthread_mutex_lock");
 #define FAV3UNLOCK    if(pthread_mutex_unlock(&faV3Mutex)<0) perror("pthread_mutex_unlock");
+
+/* Mutex per slot to guard register read/writes of a single module */
+pthread_mutex_t faV3SlotMutex[FAV3_MAX_BOARDS + 2] = {
+  [0 ... FAV3_MAX_BOARDS + 1] = PTHREAD_MUTEX_INITIALIZER
+};
+#define FAV3SLOTLOCK(_id)   if(pthread_mutex_lock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_lock");
+#define FAV3SLOTUNLOCK(_id) if(pthread_mutex_unlock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_unlock");
 #endif
 
 /* Define external Functions */
@@ -76,6 +90,11 @@ LOCAL VOIDFUNCPTR faV3IntRoutine = NULL;	/* user interrupt service routine */
 LOCAL int faV3IntArg = 0;	/* arg to user routine */
 LOCAL uint32_t faV3IntLevel = FAV3_VME_INT_LEVEL;	/* default VME interrupt level */
 LOCAL uint32_t faV3IntVec = FAV3_VME_INT_VEC;	/* default interrupt Vector */
+volatile uint32_t faV3IntCount = 0;	/* number of block-ready interrupts */
+#ifndef VXWORKS
+LOCAL int faV3IntFd = -1;	/* eventfd signalled from the interrupt handler */
+#endif
+LOCAL int faV3WaitSpinUs = FAV3_WAIT_SPIN_MAX_US / 4;	/* adaptive spin budget (us) */
 
 /* Define global variables */
 int nfaV3 = 0;			/* Number of FAV3s in Crate */
@@ -93,6 +112,10 @@ int faV3FwRev[(FAV3_MAX_BOARDS + 1)][FAV3_FW_FUNCTION_MAX];  /* control+proc ver
 
 
 uint16_t faV3ChanDisableMask[(FAV3_MAX_BOARDS + 1)];	/* Disabled Channel Mask for each Module */
+uint32_t faV3ScalerLatchCount[(FAV3_MAX_BOARDS + 1)];	/* Bumped on every scaler latch or clear */
+uint32_t faV3ScalerClearCount[(FAV3_MAX_BOARDS + 1)];	/* Bumped on every scaler clear */
+int faV3ScalerLatchPending[(FAV3_MAX_BOARDS + 1)];	/* faV3LatchScalers done, faV3ReadScalers not yet */
+int faV3ShadowEnabled[(FAV3_MAX_BOARDS + 1)];	/* >0 if setters use the shadow registers */
 int faV3Inited = 0;		/* >0 if Library has been Initialized before */
 int faV3MaxSlot = 0;		/* Highest Slot hold an FAV3 */
 int faV3MinSlot = 0;		/* Lowest Slot holding an FAV3 */
@@ -194,6 +217,10 @@ const char *faV3_mode_names[FAV3_MAX_PROC_MODE+1] =
  *      bit 18:  Skip firmware check.  Useful for firmware updating.
  *             0 Perform firmware check
  *             1 Skip firmware check
+ *
+ *      bit 22:  Shadow the read-modify-write registers (faV3ShadowEnable)
+ *             0 Setters read the registers from the board
+ *             1 Setters read the registers from the host copy
  * </pre>
  *
  *
@@ -219,6 +246,9 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
   int useSlotNumbers=0;
   uint16_t ctrl_version = 0, proc_version = 0;
 
+  /* The shadow registers are loaded again at the end, if requested */
+  memset(faV3ShadowEnabled, 0, sizeof(faV3ShadowEnabled));
+
   /* Check if we have already Initialized boards before */
   if((faV3Inited > 0) && (faV3ID[0] != 0))
     {
@@ -464,6 +494,7 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
   faV3IntVec = FAV3_VME_INT_VEC;
   faV3IntRoutine = NULL;
   faV3IntArg = 0;
+  faV3IntCount = 0;
 
   if(!noBoardInit)
     {
@@ -621,8 +652,8 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
       /* Enable Clock source - Internal Clk enabled by default */
       for(ii = 0; ii < nfaV3; ii++)
 	{
-	  vmeWrite32(&FAV3p[faV3ID[ii]]->ctrl1,
-		     (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
+	  faV3RegWrite32(faV3ID[ii], &FAV3p[faV3ID[ii]]->ctrl1,
+			 (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
 	}
       taskDelay(20);
 
@@ -682,10 +713,10 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
 	  vmeWrite32(&FAV3p[faV3ID[ii]]->blocklevel, 1);
 
 	  /* Setup Trigger and Sync Reset sources */
-	  vmeWrite32(&FAV3p[faV3ID[ii]]->ctrl1,
-		     (vmeRead32(&FAV3p[faV3ID[ii]]->ctrl1) &
+	  faV3RegWrite32(faV3ID[ii], &FAV3p[faV3ID[ii]]->ctrl1,
+			 (faV3RegRead32(faV3ID[ii], &FAV3p[faV3ID[ii]]->ctrl1) &
 		      ~(FAV3_REF_CLK_MASK | FAV3_TRIG_MASK | FAV3_SRESET_MASK)) |
-		     (clkSrc | srSrc | trigSrc) );
+			 (clkSrc | srSrc | trigSrc) );
 
 	  /* Initialize DAC */
 	  faV3DACInit(faV3ID[ii]);
@@ -735,10 +766,10 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
       faV3MinSlot = minSlot;
       if(!noBoardInit)
 	{
-	  vmeWrite32(&(FAV3p[minSlot]->ctrl1),
-		     vmeRead32(&(FAV3p[minSlot]->ctrl1)) | FAV3_FIRST_BOARD);
-	  vmeWrite32(&(FAV3p[maxSlot]->ctrl1),
-		     vmeRead32(&(FAV3p[maxSlot]->ctrl1)) | FAV3_LAST_BOARD);
+	  faV3RegWrite32(minSlot, &(FAV3p[minSlot]->ctrl1),
+			 faV3RegRead32(minSlot, &(FAV3p[minSlot]->ctrl1)) | FAV3_FIRST_BOARD);
+	  faV3RegWrite32(maxSlot, &(FAV3p[maxSlot]->ctrl1),
+			 faV3RegRead32(maxSlot, &(FAV3p[maxSlot]->ctrl1)) | FAV3_LAST_BOARD);
 	}
     }
 
@@ -751,6 +782,9 @@ faV3Init(uint32_t addr, uint32_t addr_inc, int nadc, int iFlag)
       return (ERROR);
     }
 
+  if(iFlag & FAV3_INIT_USE_SHADOW)
+    faV3GShadowEnable(1);
+
   printf("%s: %d FADC(s) successfully initialized\n",
 	 __func__, nfaV3);
 
@@ -915,12 +949,12 @@ faV3SetClockSource(int id, int clkSrc)
     }
 
   /* Enable Clock source - Internal Clk enabled by default */
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     (vmeRead32(&FAV3p[id]->ctrl1) & ~(FAV3_REF_CLK_MASK)) |
-	     (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 (faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~(FAV3_REF_CLK_MASK)) |
+		 (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
   taskDelay(20);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   switch (clkSrc)
     {
@@ -982,16 +1016,16 @@ faV3GSetClockSource(int clkSrc)
     }
 
   /* Enable Clock source - Internal Clk enabled by default */
-  FAV3LOCK;
   for(ifa = 0; ifa < nfaV3; ifa++)
     {
       id = faV3Slot(ifa);
-      vmeWrite32(&(FAV3p[id]->ctrl1),
-		 (vmeRead32(&FAV3p[id]->ctrl1) & ~(FAV3_REF_CLK_MASK)) |
-		 (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
+      FAV3SLOTLOCK(id);
+      faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		     (faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~(FAV3_REF_CLK_MASK)) |
+		     (clkSrc | FAV3_ENABLE_INTERNAL_CLK));
+      FAV3SLOTUNLOCK(id);
     }
   taskDelay(20);
-  FAV3UNLOCK;
 
   switch (clkSrc)
     {
@@ -1022,268 +1056,1100 @@ faV3GSetClockSource(int clkSrc)
   return OK;
 }
 
-/**
- *  @ingroup Status
- *  @brief Print Status of fADC250 to standard out
- *  @param id Slot Number
- *  @param sflag Reserved for future use
- *
- */
+/* Registers that the library reads back to change a few bits.  With the
+   shadow enabled, their last written values are kept on the host and the
+   read goes to the copy instead of the bus. */
+typedef struct
+{
+  uint32_t offset;
+  int32_t width;		/* 16 or 32 bit */
+  int32_t count;		/* registers in a row */
+  uint32_t mask;		/* bits compared by faV3ShadowVerify */
+  const char *name;
+} faV3ShadowReg_t;
+
+static const faV3ShadowReg_t faV3ShadowRegs[] = {
+  {offsetof(faV3_t, ctrl1), 32, 1, FAV3_CONTROL_MASK, "ctrl1"},
+  {offsetof(faV3_t, ctrl2), 32, 1, FAV3_CONTROL2_MASK, "ctrl2"},
+  {offsetof(faV3_t, trigger_control), 32, 1, 0xFFFFFFFF, "trigger_control"},
+  {offsetof(faV3_t, adc.config1), 16, 1, 0xFFFF, "adc.config1"},
+  {offsetof(faV3_t, adc.nsa), 16, 1, 0xFFFF, "adc.nsa"},
+  {offsetof(faV3_t, adc.thres), 16, FAV3_MAX_ADC_CHANNELS, 0xFFFF, "adc.thres"},
+  {offsetof(faV3_t, adc.trig_gain), 16, FAV3_MAX_ADC_CHANNELS, 0xFFFF, "adc.trig_gain"},
+  {offsetof(faV3_t, adc.hitbit_config), 16, 1, 0xFFFF, "adc.hitbit_config"},
+  {offsetof(faV3_t, adc.config3), 16, 1, 0xFFFF, "adc.config3"}
+};
+#define FAV3_SHADOW_NREGS (sizeof(faV3ShadowRegs) / sizeof(faV3ShadowRegs[0]))
+
+static faV3_t faV3Shadow[(FAV3_MAX_BOARDS + 1)];
+static uint32_t faV3ShadowHits[(FAV3_MAX_BOARDS + 1)];	/* reads not sent to the bus */
+static int faV3BatchOpen[(FAV3_MAX_BOARDS + 1)];	/* >0 while faV3ShadowBatch holds writes back */
+static uint32_t faV3BatchDirty[(FAV3_MAX_BOARDS + 1)];	/* bit ch: adc.thres, 16+ch: adc.trig_gain */
+
+#define FAV3_SHADOW32(_id, _off) \
+  (((volatile uint32_t *) &faV3Shadow[_id])[(_off) >> 2])
+#define FAV3_SHADOW16(_id, _off) \
+  (((volatile uint16_t *) &faV3Shadow[_id])[(_off) >> 1])
+
+/* Width (16 or 32) of the shadowed register at byte offset off, 0 if it
+   is not shadowed. */
+static int
+faV3ShadowWidth(uint32_t off)
+{
+  int ireg;
+
+  for(ireg = 0; ireg < FAV3_SHADOW_NREGS; ireg++)
+    {
+      if((off >= faV3ShadowRegs[ireg].offset) &&
+	 (off < faV3ShadowRegs[ireg].offset +
+	  faV3ShadowRegs[ireg].count * (faV3ShadowRegs[ireg].width >> 3)))
+	return faV3ShadowRegs[ireg].width;
+    }
 
-int
-faV3Status(int id, int sflag)
+  return 0;
+}
+
+/* Take the shadowed register at byte offset off back from the board */
+static void
+faV3ShadowReload(int id, uint32_t off)
 {
-  int ii;
-  uint32_t a32Base, ambMin, ambMax, vers;
-  uint32_t csr, ctrl1, ctrl2, count, bcount, blevel, intr, addr32, addrMB;
-  uint32_t adcStat[3], adcConf[3],
-    PTW, PL, NSB, NSA, NP, adcChanDisabled, playbackMode;
-  uint32_t adc_enabled, adc_version, adc_option;
-  uint32_t trigCnt, trig2Cnt, srCnt, itrigCnt, ramWords;
-  uint32_t mgtStatus, mgtCtrl;
-  uint32_t berr_count = 0;
-  uint32_t scaler_interval = 0;
-  uint32_t trigger_control = 0;
-  uint32_t lost_trig_scal = 0;
-  uint32_t tet_trg[16], tet_readout[16], delay[16];
-  float gain_trg[16], ped_trg[16];
-  uint32_t val, trig_mode[16], inverted[16], playback_ch[16];
-  char *trig_mode_string;
+  int width = faV3ShadowWidth(off);
 
-  CHECKID;
+  if(width == 32)
+    FAV3_SHADOW32(id, off & ~0x3) =
+      vmeRead32((volatile uint32_t *) ((u_long) FAV3p[id] + (off & ~0x3)));
+  else if(width == 16)
+    FAV3_SHADOW16(id, off & ~0x1) =
+      vmeRead16((volatile uint16_t *) ((u_long) FAV3p[id] + (off & ~0x1)));
+}
 
-  FAV3LOCK;
-  vers = vmeRead32(&FAV3p[id]->version);
+/* Keep a write of width bits at byte offset off in the shadow.  A write
+   of the other width (e.g. through the faV3-HallD.c map, which has 32 bit
+   registers where faV3_t has 16 bit ones) does not say which half went
+   where without the byte order of the bridge, so the shadowed registers
+   it covered are read back instead. */
+static void
+faV3ShadowPut(int id, uint32_t off, int width, uint32_t val)
+{
+  if(faV3ShadowWidth(off) == width)
+    {
+      if(width == 32)
+	FAV3_SHADOW32(id, off) = val;
+      else
+	FAV3_SHADOW16(id, off) = val;
+      return;
+    }
 
-  csr = (vmeRead32(&(FAV3p[id]->csr))) & FAV3_CSR_MASK;
-  ctrl1 = (vmeRead32(&(FAV3p[id]->ctrl1))) & FAV3_CONTROL_MASK;
-  ctrl2 = (vmeRead32(&(FAV3p[id]->ctrl2))) & FAV3_CONTROL2_MASK;
-  count = (vmeRead32(&(FAV3p[id]->ev_count))) & FAV3_EVENT_COUNT_MASK;
-  bcount = (vmeRead32(&(FAV3p[id]->blk_count))) & FAV3_BLOCK_COUNT_MASK;
-  blevel = (vmeRead32(&(FAV3p[id]->blocklevel))) & FAV3_BLOCK_LEVEL_MASK;
-  ramWords = (vmeRead32(&(FAV3p[id]->ram_word_count))) & FAV3_RAM_DATA_MASK;
-  trigCnt = vmeRead32(&(FAV3p[id]->trig_scal));
-  trig2Cnt = vmeRead32(&FAV3p[id]->trig2_scal);
-  srCnt = vmeRead32(&FAV3p[id]->syncreset_scal);
-  itrigCnt = vmeRead32(&(FAV3p[id]->trig_live_count));
-  intr = vmeRead32(&(FAV3p[id]->intr));
-  addr32 = vmeRead32(&(FAV3p[id]->adr32));
-  a32Base = (addr32 & FAV3_A32_ADDR_MASK) << 16;
-  addrMB = vmeRead32(&(FAV3p[id]->adr_mb));
-  ambMin = (addrMB & FAV3_AMB_MIN_MASK) << 16;
-  ambMax = (addrMB & FAV3_AMB_MAX_MASK);
-  berr_count = vmeRead32(&(FAV3p[id]->aux.berr_driven_count));
-
-  adcStat[0] = (vmeRead16(&(FAV3p[id]->adc.status0)) & 0xFFFF);
-  adcStat[1] = (vmeRead16(&(FAV3p[id]->adc.status1)) & 0xFFFF);
-  adcStat[2] = (vmeRead16(&(FAV3p[id]->adc.status2)) & 0xFFFF);
-  adcConf[0] = (vmeRead16(&(FAV3p[id]->adc.config1)) & 0xFFFF);
-  adcConf[1] = (vmeRead16(&(FAV3p[id]->adc.config2)) & 0xFFFF);
-  adcConf[2] = (vmeRead16(&(FAV3p[id]->adc.config4)) & 0xFFFF);
-
-  PTW = (vmeRead16(&(FAV3p[id]->adc.ptw)) & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
-  PL = (vmeRead16(&(FAV3p[id]->adc.pl)) & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
-  NSB = (vmeRead16(&(FAV3p[id]->adc.nsb)) & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
-  NSA = (vmeRead16(&(FAV3p[id]->adc.nsa)) & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
-  adc_version = adcStat[0] & FAV3_ADC_VERSION_MASK;
-  adc_option = (adcConf[0] & FAV3_ADC_PROC_MASK) + 1;
-  NP = (adcConf[0] & FAV3_ADC_PEAK_MASK) >> 4;
-  adc_enabled = (adcConf[0] & FAV3_ADC_PROC_ENABLE);
-  playbackMode = (adcConf[0] & FAV3_ADC_PLAYBACK_MODE) >> 7;
-  adcChanDisabled = (adcConf[1] & FAV3_ADC_CHAN_MASK);
+  faV3ShadowReload(id, off);
+  if(width == 32)
+    faV3ShadowReload(id, off + 2);
+}
 
-  mgtStatus = vmeRead32(&(FAV3p[id]->status_mgt));
+/* Read of width bits at byte offset off from the shadow.  Returns 0 if
+   the shadow does not keep a register of that width there. */
+static int
+faV3ShadowGet(int id, uint32_t off, int width, uint32_t * val)
+{
+  if(faV3ShadowWidth(off) != width)
+    return 0;
 
-  scaler_interval =
-    vmeRead32(&FAV3p[id]->scaler_insert) & FAV3_SCALER_INSERT_MASK;
+  if(width == 32)
+    *val = FAV3_SHADOW32(id, off);
+  else
+    *val = FAV3_SHADOW16(id, off);
 
-  FAV3UNLOCK;
+  return 1;
+}
 
-#ifdef VXWORKS
-  printf("\nSTATUS for FADC in slot %d at base address 0x%x \n",
-	 id, (uint32_t) FAV3p[id]);
-#else
-  printf("\nSTATUS for FADC in slot %d at VME (Local) base address 0x%x (0x%lx)\n",
-	 id, (uint32_t) (u_long) (FAV3p[id] - faV3A24Offset), (u_long) FAV3p[id]);
-#endif
-  printf("---------------------------------------------------------------------- \n");
+#define FAV3_SHADOW_OFFSET(_id, _reg) \
+  ((uint32_t) ((u_long) (_reg) - (u_long) FAV3p[_id]))
 
-  printf(" Board Firmware Rev/ID = 0x%04x : ADC Processing Rev = 0x%04x\n",
-	 (vers) & 0xffff, adc_version);
-  if(addrMB & FAV3_AMB_ENABLE)
-    {
-      printf(" Alternate VME Addressing: Multiblock Enabled\n");
-      if(addr32 & FAV3_A32_ENABLE)
-	printf("   A32 Enabled at VME (Local) base 0x%08x (0x%lx)\n", a32Base,
-	       (u_long) FAV3pd[id]);
-      else
-	printf("   A32 Disabled\n");
+/* Fill the shadow from the hardware.  Slot lock must be held. */
+static void
+faV3ShadowLoad(int id)
+{
+  const faV3ShadowReg_t *r;
+  uint32_t off;
+  int ireg, ii;
 
-      printf("   Multiblock VME Address Range 0x%08x - 0x%08x\n", ambMin,
-	     ambMax);
-    }
-  else
+  for(ireg = 0; ireg < FAV3_SHADOW_NREGS; ireg++)
     {
-      printf(" Alternate VME Addressing: Multiblock Disabled\n");
-      if(addr32 & FAV3_A32_ENABLE)
-	printf("   A32 Enabled at VME (Local) base 0x%08x (0x%lx)\n", a32Base,
-	       (u_long) FAV3pd[id]);
-      else
-	printf("   A32 Disabled\n");
+      r = &faV3ShadowRegs[ireg];
+      for(ii = 0; ii < r->count; ii++)
+	{
+	  off = r->offset + ii * (r->width >> 3);
+	  if(r->width == 32)
+	    FAV3_SHADOW32(id, off) =
+	      vmeRead32((volatile uint32_t *) ((u_long) FAV3p[id] + off));
+	  else
+	    FAV3_SHADOW16(id, off) =
+	      vmeRead16((volatile uint16_t *) ((u_long) FAV3p[id] + off));
+	}
     }
 
-  if(ctrl1 & FAV3_INT_ENABLE_MASK)
-    {
-      printf("\n  Interrupts ENABLED: ");
-      if(ctrl1 & FAV3_ENABLE_BLKLVL_INT)
-	printf(" on Block Level(%d)", blevel);
+  /* The board has these values now: writes held back are dropped */
+  faV3BatchDirty[id] = 0;
+}
 
-      printf("\n");
-      printf("  Interrupt Reg: 0x%08x\n", intr);
-      printf("  VME INT Vector = 0x%x  Level = %d\n",
-	     (intr & FAV3_INT_VEC_MASK), ((intr & FAV3_INT_LEVEL_MASK) >> 8));
-    }
+/* Bit in faV3BatchDirty of the register at byte offset off, 0 if writes
+   to it are not held back in a batch.  Only the per channel registers
+   are: each is written several times in a download, and the board does
+   nothing with them but keep them. */
+static uint32_t
+faV3BatchBit(uint32_t off)
+{
+  uint32_t thres = offsetof(faV3_t, adc.thres);
+  uint32_t gain = offsetof(faV3_t, adc.trig_gain);
 
-  printf("\n Signal Sources: \n");
+  if((off >= thres) && (off < thres + 2 * FAV3_MAX_ADC_CHANNELS))
+    return 1u << ((off - thres) >> 1);
+  if((off >= gain) && (off < gain + 2 * FAV3_MAX_ADC_CHANNELS))
+    return 1u << (16 + ((off - gain) >> 1));
 
-  if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_INTERNAL)
-    {
-      printf("   Ref Clock : Internal\n");
-    }
-  else if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_P0)
-    {
-      printf("   Ref Clock : VXS\n");
-    }
-  else if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_FP)
-    {
-      printf("   Ref Clock : Front Panel\n");
-    }
-  else
-    {
-      printf("   Ref Clock : %d (Undefined)\n", (ctrl1 & FAV3_REF_CLK_MASK));
-    }
+  return 0;
+}
 
-  switch (ctrl1 & FAV3_TRIG_MASK)
-    {
-    case FAV3_TRIG_INTERNAL:
-      printf("   Trig Src  : Internal\n");
-      break;
-    case FAV3_TRIG_VME:
-      printf("   Trig Src  : VME (Software)\n");
-      break;
-    case FAV3_TRIG_P0_ISYNC:
-      printf("   Trig Src  : VXS (Async)\n");
-      break;
-    case FAV3_TRIG_P0:
-      printf("   Trig Src  : VXS (Sync)\n");
-      break;
-    case FAV3_TRIG_FP_ISYNC:
-      printf("   Trig Src  : Front Panel (Async)\n");
-      break;
-    case FAV3_TRIG_FP:
-      printf("   Trig Src  : Front Panel (Sync)\n");
-    }
+/* Write the registers held back in the batch, each once, from the
+   shadow.  Slot lock must be held. */
+static void
+faV3BatchFlush(int id)
+{
+  uint32_t dirty = faV3BatchDirty[id];
+  int ichan;
 
-  switch (ctrl1 & FAV3_SRESET_MASK)
+  faV3BatchDirty[id] = 0;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
     {
-    case FAV3_SRESET_VME:
-      printf("   Sync Reset: VME (Software)\n");
-      break;
-    case FAV3_SRESET_P0_ISYNC:
-      printf("   Sync Reset: VXS (Async)\n");
-      break;
-    case FAV3_SRESET_P0:
-      printf("   Sync Reset: VXS (Sync)\n");
-      break;
-    case FAV3_SRESET_FP_ISYNC:
-      printf("   Sync Reset: Front Panel (Async)\n");
-      break;
-    case FAV3_SRESET_FP:
-      printf("   Sync Reset: Front Panel (Sync)\n");
+      if(dirty & (1u << ichan))
+	vmeWrite16(&FAV3p[id]->adc.thres[ichan],
+		   faV3Shadow[id].adc.thres[ichan]);
+      if(dirty & (1u << (16 + ichan)))
+	vmeWrite16(&FAV3p[id]->adc.trig_gain[ichan],
+		   faV3Shadow[id].adc.trig_gain[ichan]);
     }
+}
 
-  if(faV3UseSDC)
-    {
-      printf("   SDC       : In Use\n");
-    }
+/**
+ *  @ingroup Config
+ *  @brief Read a register, from the shadow if it is enabled and keeps it.
+ *         To be called with the slot lock held.
+ *  @param id Slot number
+ *  @param reg Register in the board map
+ *  @return Register value
+ */
 
+uint32_t
+faV3RegRead32(int id, volatile uint32_t * reg)
+{
+  uint32_t val;
 
-  printf("\n Configuration: \n");
+  if(faV3BatchDirty[id] &&
+     (faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg)) |
+      faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg) + 2)))
+    faV3BatchFlush(id);
 
-  if(ctrl1 & FAV3_ENABLE_INTERNAL_CLK)
-    printf("   Internal Clock ON\n");
-  else
-    printf("   Internal Clock OFF\n");
+  if(faV3ShadowEnabled[id] &&
+     faV3ShadowGet(id, FAV3_SHADOW_OFFSET(id, reg), 32, &val))
+    {
+      faV3ShadowHits[id]++;
+      return val;
+    }
 
-  if(ctrl1 & FAV3_ENABLE_BERR)
-    printf("   Bus Error ENABLED\n");
-  else
-    printf("   Bus Error DISABLED\n");
+  return vmeRead32(reg);
+}
 
+uint16_t
+faV3RegRead16(int id, volatile uint16_t * reg)
+{
+  uint32_t val;
 
-  if(ctrl1 & FAV3_ENABLE_MULTIBLOCK)
-    {
-      int tP0, tP2;
-      tP0 = ctrl1 & FAV3_MB_TOKEN_VIA_P0;
-      tP2 = ctrl1 & FAV3_MB_TOKEN_VIA_P2;
+  /* Held back by faV3ShadowBatch: the board has the old value */
+  if(faV3BatchDirty[id] &&
+     (faV3BatchDirty[id] & faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg))))
+    return FAV3_SHADOW16(id, FAV3_SHADOW_OFFSET(id, reg));
 
-      if(tP0)
-	{
-	  if(ctrl1 & FAV3_FIRST_BOARD)
-	    printf("   MultiBlock transfer ENABLED (First Board - token via VXS)\n");
-	  else if(ctrl1 & FAV3_LAST_BOARD)
-	    printf("   MultiBlock transfer ENABLED (Last Board  - token via VXS)\n");
-	  else
-	    printf("   MultiBlock transfer ENABLED (Token via VXS)\n");
-	  /* #ifdef VERSION1 */
-	}
-      else if(tP2)
-	{
-	  if(ctrl1 & FAV3_FIRST_BOARD)
-	    printf("   MultiBlock transfer ENABLED (First Board - token via P2)\n");
-	  else if(ctrl1 & FAV3_LAST_BOARD)
-	    printf("   MultiBlock transfer ENABLED (Last Board  - token via P2)\n");
-	  else
-	    printf("   MultiBlock transfer ENABLED (Token via P2)\n");
-	  /* #endif */
-	}
-      else
-	{
-	  printf("   MultiBlock transfer ENABLED (**NO Tokens enabled**)\n");
-	}
-    }
-  else
+  if(faV3ShadowEnabled[id] &&
+     faV3ShadowGet(id, FAV3_SHADOW_OFFSET(id, reg), 16, &val))
     {
-      printf("   MultiBlock transfer DISABLED\n");
+      faV3ShadowHits[id]++;
+      return val;
     }
 
-  if(ctrl1 & FAV3_ENABLE_SOFT_TRIG)
-    printf("   Software Triggers   ENABLED\n");
-  if(ctrl1 & FAV3_ENABLE_SOFT_SRESET)
-    printf("   Software Sync Reset ENABLED\n");
+  return vmeRead16(reg);
+}
 
+/**
+ *  @ingroup Config
+ *  @brief Write a register, and the shadow if it is enabled and keeps it.
+ *         To be called with the slot lock held.
+ *
+ *   Every write to a shadowed register must go through here (or
+ *   faV3RegWrite16), also from other register maps of the same board,
+ *   or the shadow goes stale.
+ *
+ *  @param id Slot number
+ *  @param reg Register in the board map
+ *  @param val Value to write
+ */
 
-  printf("\n ADC Processing Configuration: \n");
-  printf("   Channel Disable Mask = 0x%04x\n", adcChanDisabled);
-  if(adc_enabled)
-    printf("   Mode = %d  (ENABLED)\n", adc_option);
-  else
-    printf("   Mode = %d  (Disabled)\n", adc_option);
+void
+faV3RegWrite32(int id, volatile uint32_t * reg, uint32_t val)
+{
+  if(faV3BatchDirty[id] &&
+     (faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg)) |
+      faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg) + 2)))
+    faV3BatchFlush(id);
 
-  printf("   Lookback (PL)    = %d ns   Time Window (PTW) = %d ns\n", PL,
-	 PTW);
-  printf("   Time Before Peak = %d ns   Time After Peak   = %d ns\n", NSB,
-	 NSA);
-  printf("   Max Peak Count   = %d \n", NP);
-  printf("   Playback Mode    = %d \n", playbackMode);
+  vmeWrite32(reg, val);
+  if(faV3ShadowEnabled[id])
+    faV3ShadowPut(id, FAV3_SHADOW_OFFSET(id, reg), 32, val);
+}
 
+void
+faV3RegWrite16(int id, volatile uint16_t * reg, uint16_t val)
+{
+  uint32_t bit;
 
+  if(faV3BatchOpen[id] &&
+     (bit = faV3BatchBit(FAV3_SHADOW_OFFSET(id, reg))))
+    {
+      FAV3_SHADOW16(id, FAV3_SHADOW_OFFSET(id, reg)) = val;
+      faV3BatchDirty[id] |= bit;
+      return;
+    }
 
-  printf("\n");
-  printf(" Unacknowleged Trigger Stop: %s (%d)\n",
-	 (trigger_control & FAV3_TRIGCTL_TRIGSTOP_EN) ? " ENABLED" : "DISABLED",
-	 (trigger_control & FAV3_TRIGCTL_MAX2_MASK) >> 16);
-  printf(" Unacknowleged Trigger Busy: %s (%d)\n",
+  vmeWrite16(reg, val);
+  if(faV3ShadowEnabled[id])
+    faV3ShadowPut(id, FAV3_SHADOW_OFFSET(id, reg), 16, val);
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Enable or disable the shadow of the read-modify-write registers
+ *
+ *   When enabled, the shadow is loaded from the hardware and the setters
+ *   that change a few bits of ctrl1, ctrl2, trigger_control, adc.config1,
+ *   adc.nsa, adc.thres, adc.trig_gain, adc.hitbit_config or adc.config3
+ *   skip the read of the register.
+ *   Registers changed behind the library (another process, a reset not
+ *   done with faV3Reset) make the shadow stale; see faV3ShadowVerify.
+ *
+ *  @param id Slot number
+ *  @param enable 1 to enable, 0 to disable
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3ShadowEnable(int id, int enable)
+{
+  CHECKID;
+
+  FAV3SLOTLOCK(id);
+  faV3BatchFlush(id);
+  if(enable)
+    faV3ShadowLoad(id);
+  faV3ShadowEnabled[id] = enable ? 1 : 0;
+  faV3ShadowHits[id] = 0;
+  FAV3SLOTUNLOCK(id);
+
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Hold back the writes of the per channel registers
+ *
+ *   Between faV3ShadowBatch(id, 1) and faV3ShadowBatch(id, 0), writes
+ *   to adc.thres and adc.trig_gain through faV3RegWrite16 only change
+ *   the shadow.  At the end each register that was written goes out
+ *   once, with its last value.  A setter that sets one field of all 16
+ *   thresholds in turn then costs no bus cycles until the end.
+ *   The shadow does not have to be enabled: the held values are kept in
+ *   it either way, and faV3RegRead16 returns them.
+ *
+ *   faV3GetThreshold, faV3GetChannelGain (and the other getters that
+ *   read the board) return the old values until the batch ends.
+ *   Registers with an order to keep (adc.config1 around the window
+ *   settings, the DACs) are always written at once.
+ *
+ *  @param id Slot number
+ *  @param enable 1 to start the batch, 0 to write it out and end it
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3ShadowBatch(int id, int enable)
+{
+  CHECKID;
+
+  FAV3SLOTLOCK(id);
+  if(!enable)
+    faV3BatchFlush(id);
+  faV3BatchOpen[id] = enable ? 1 : 0;
+  FAV3SLOTUNLOCK(id);
+
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Enable or disable the shadow registers of all initialized fADC250s
+ *  @param enable 1 to enable, 0 to disable
+ */
+
+void
+faV3GShadowEnable(int enable)
+{
+  int ifa;
+
+  for(ifa = 0; ifa < nfaV3; ifa++)
+    faV3ShadowEnable(faV3Slot(ifa), enable);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Compare the shadow registers with the hardware
+ *
+ *  @param id Slot number
+ *  @param rflag What to do with a difference
+ *    - FAV3_SHADOW_VERIFY:  only print it
+ *    - FAV3_SHADOW_LOAD:    take the hardware value into the shadow
+ *    - FAV3_SHADOW_RESTORE: write the shadow value to the hardware
+ *  @return Number of registers that differ, otherwise ERROR.
+ */
+
+int
+faV3ShadowVerify(int id, int rflag)
+{
+  const faV3ShadowReg_t *r;
+  volatile uint32_t *reg32;
+  volatile uint16_t *reg16;
+  uint32_t off, hw, sh;
+  int ireg, ii, ndiff = 0;
+
+  CHECKID;
+
+  if((rflag < FAV3_SHADOW_VERIFY) || (rflag > FAV3_SHADOW_RESTORE))
+    {
+      printf("%s: ERROR: Invalid rflag (%d)\n", __func__, rflag);
+      return ERROR;
+    }
+
+  FAV3SLOTLOCK(id);
+  if(!faV3ShadowEnabled[id])
+    {
+      printf("%s: ERROR: Shadow registers not enabled for slot %d\n",
+	     __func__, id);
+      FAV3SLOTUNLOCK(id);
+      return ERROR;
+    }
+
+  for(ireg = 0; ireg < FAV3_SHADOW_NREGS; ireg++)
+    {
+      r = &faV3ShadowRegs[ireg];
+      for(ii = 0; ii < r->count; ii++)
+	{
+	  off = r->offset + ii * (r->width >> 3);
+	  reg32 = (volatile uint32_t *) ((u_long) FAV3p[id] + off);
+	  reg16 = (volatile uint16_t *) reg32;
+
+	  if(r->width == 32)
+	    {
+	      hw = vmeRead32(reg32);
+	      sh = FAV3_SHADOW32(id, off);
+	    }
+	  else
+	    {
+	      hw = vmeRead16(reg16);
+	      sh = FAV3_SHADOW16(id, off);
+	    }
+
+	  if(((hw ^ sh) & r->mask) == 0)
+	    continue;
+
+	  ndiff++;
+	  if(r->count > 1)
+	    printf("%s: Slot %2d %s[%d]: shadow 0x%08x  hardware 0x%08x\n",
+		   __func__, id, r->name, ii, sh, hw);
+	  else
+	    printf("%s: Slot %2d %s: shadow 0x%08x  hardware 0x%08x\n",
+		   __func__, id, r->name, sh, hw);
+
+	  if(rflag == FAV3_SHADOW_LOAD)
+	    {
+	      if(r->width == 32)
+		FAV3_SHADOW32(id, off) = hw;
+	      else
+		FAV3_SHADOW16(id, off) = hw;
+	    }
+	  else if(rflag == FAV3_SHADOW_RESTORE)
+	    {
+	      if(r->width == 32)
+		vmeWrite32(reg32, sh);
+	      else
+		vmeWrite16(reg16, sh);
+	    }
+	}
+    }
+  FAV3SLOTUNLOCK(id);
+
+  return ndiff;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Compare the shadow registers with the hardware for all
+ *         initialized fADC250s
+ *  @param rflag See faV3ShadowVerify
+ *  @return Number of registers that differ, otherwise ERROR.
+ */
+
+int
+faV3GShadowVerify(int rflag)
+{
+  int ifa, rval, ndiff = 0;
+
+  for(ifa = 0; ifa < nfaV3; ifa++)
+    {
+      rval = faV3ShadowVerify(faV3Slot(ifa), rflag);
+      if(rval == ERROR)
+	return ERROR;
+      ndiff += rval;
+    }
+
+  return ndiff;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Number of register reads taken from the shadow since it was
+ *         enabled
+ *  @param id Slot number
+ *  @param pflag Print if not zero
+ *  @return Number of reads, otherwise ERROR.
+ */
+
+int
+faV3ShadowStatus(int id, int pflag)
+{
+  uint32_t hits;
+  int enabled;
+
+  CHECKID;
+
+  FAV3SLOTLOCK(id);
+  enabled = faV3ShadowEnabled[id];
+  hits = faV3ShadowHits[id];
+  FAV3SLOTUNLOCK(id);
+
+  if(pflag)
+    printf("%s: Slot %2d shadow registers %s, %u reads saved\n",
+	   __func__, id, enabled ? "enabled" : "disabled", hits);
+
+  return hits;
+}
+
+/* Bookkeeping for the DMA transfer started by faV3ReadBlockStart.
+   Guarded by faV3Mutex.  There is one DMA engine: a thread that wants
+   to start a transfer while another thread's transfer is in flight
+   waits on faV3XferCond until it is completed.  faV3Snapshot block
+   transfers hold faV3Mutex while they use the engine. */
+#define FAV3_XFER_IDLE     0
+#define FAV3_XFER_ACTIVE   1	/* started, not yet claimed by ...Done */
+#define FAV3_XFER_DONE     2	/* faV3ReadBlockDone is waiting for it */
+typedef struct
+{
+  int active;			/* FAV3_XFER_* */
+  int id;			/* Slot number used to start the transfer */
+  int rmode;			/* 1: single board, 2: multiblock */
+  int nwrds;			/* Max number of words requested */
+  int dummy;			/* 1 if a dummy word was inserted for alignment */
+#ifndef VXWORKS
+  pthread_t owner;		/* Thread that started the transfer */
+#endif
+} faV3DmaXfer_t;
+
+static faV3DmaXfer_t faV3Xfer = { FAV3_XFER_IDLE, 0, 0, 0, 0 };
+#ifndef VXWORKS
+static pthread_cond_t faV3XferCond = PTHREAD_COND_INITIALIZER;
+#endif
+
+/* Registers copied by faV3Snapshot: all status, counters and
+   configuration.  Blank addresses, and registers with side effects when
+   read (memory data, event generator, sum data, logic analyzer), are not
+   in the table. */
+typedef struct
+{
+  uint32_t offset;
+  int32_t width;		/* 16 or 32 bit */
+  int32_t count;		/* registers in a row */
+  uint32_t region;		/* FAV3_SNAP_* */
+} faV3SnapReg_t;
+
+static const faV3SnapReg_t faV3SnapRegs[] = {
+  {offsetof(faV3_t, version), 32, 9, FAV3_SNAP_CTRL},	/* - sec_adr */
+  {offsetof(faV3_t, trig_cfg), 32, 17, FAV3_SNAP_CTRL},	/* - config_rom_status1 */
+  {offsetof(faV3_t, status1), 32, 3, FAV3_SNAP_CTRL},	/* status1-3 */
+  {offsetof(faV3_t, trigger_control), 32, 3, FAV3_SNAP_CTRL},	/* - mem_adr */
+  {offsetof(faV3_t, prom_reg1), 32, 11, FAV3_SNAP_CTRL},	/* - busy_level */
+  {offsetof(faV3_t, status_mgt), 32, 10, FAV3_SNAP_CTRL},	/* - sum_threshold */
+  {offsetof(faV3_t, sys_mon), 32, 1, FAV3_SNAP_CTRL},
+  {offsetof(faV3_t, adc.status0), 16, 120, FAV3_SNAP_ADC},	/* - scaler_latch */
+  {offsetof(faV3_t, scalers), 32, FAV3_MAX_ADC_CHANNELS + 1, FAV3_SNAP_SCALERS},
+  {offsetof(faV3_t, aux.state_level), 32, 3, FAV3_SNAP_AUX},	/* - state_value */
+  {offsetof(faV3_t, aux.berr_driven_count), 32, 2, FAV3_SNAP_AUX},
+  {offsetof(faV3_t, aux.vxs_output_status), 32, 6, FAV3_SNAP_AUX},	/* - triggers_processed */
+  {offsetof(faV3_t, aux.idelay_control_1), 32, 4, FAV3_SNAP_AUX}	/* - idelay_status_2 */
+};
+#define FAV3_SNAP_NREGS (sizeof(faV3SnapRegs) / sizeof(faV3SnapRegs[0]))
+
+/* Block transfers of faV3Snapshot (faV3SnapshotBlockConfig): the address
+   ranges that hold the registers above.  They pass over blank addresses,
+   never over a register with side effects.  A single register is read
+   with a single cycle. */
+static const faV3SnapReg_t faV3SnapBlocks[] = {
+  {0x000, 32, 36, FAV3_SNAP_CTRL},	/* version - mem_adr */
+  {0x098, 32, 11, FAV3_SNAP_CTRL},	/* prom_reg1 - busy_level */
+  {0x0D0, 32, 10, FAV3_SNAP_CTRL},	/* status_mgt - sum_threshold */
+  {0x0FC, 32, 1, FAV3_SNAP_CTRL},	/* sys_mon */
+  {0x100, 16, 120, FAV3_SNAP_ADC},	/* status0 - scaler_latch */
+  {0x300, 32, 17, FAV3_SNAP_SCALERS},
+  {0x500, 32, 20, FAV3_SNAP_AUX}
+};
+#define FAV3_SNAP_NBLOCKS (sizeof(faV3SnapBlocks) / sizeof(faV3SnapBlocks[0]))
+
+/* DMA buffer and mode for the block transfers */
+static int faV3SnapBlockEnabled = 0;
+#ifndef VXWORKS
+static DMA_MEM_ID faV3SnapPool = 0;
+static DMANODE *faV3SnapNode = NULL;
+static uint32_t faV3SnapDmaMode[3];	/* readout addrType, dataType, sstMode */
+#endif
+
+/**
+ *  @ingroup Status
+ *  @brief Read the snapshot registers with A24 block transfers
+ *
+ *   faV3Snapshot then programs the DMA engine for A24 BLT, reads each
+ *   range of registers in one transfer, and sets the engine back to the
+ *   mode given here, the one of the readout (see vmeDmaConfig).  It takes
+ *   the engine only when no readout transfer (faV3ReadBlockStart) is in
+ *   flight.  Not available on vxWorks.
+ *
+ *  @param enable 1 to use block transfers, 0 for single cycles
+ *  @param addrType DMA address type of the readout (vmeDmaConfig)
+ *  @param dataType DMA data type of the readout (vmeDmaConfig)
+ *  @param sstMode  DMA 2eSST mode of the readout (vmeDmaConfig)
+ *  @return OK if successful, otherwise ERROR
+ */
+
+int
+faV3SnapshotBlockConfig(int enable, uint32_t addrType, uint32_t dataType,
+			uint32_t sstMode)
+{
+#ifdef VXWORKS
+  printf("%s: ERROR: Not supported on vxWorks\n", __func__);
+  return ERROR;
+#else
+  FAV3LOCK;
+  if(enable && (faV3SnapNode == NULL))
+    {
+      faV3SnapPool = dmaPCreate("faV3Snap", sizeof(faV3_t), 1, 0);
+      if(faV3SnapPool)
+	faV3SnapNode = dmaPGetItem(faV3SnapPool);
+      if(faV3SnapNode == NULL)
+	{
+	  printf("%s: ERROR: No DMA buffer\n", __func__);
+	  if(faV3SnapPool)
+	    dmaPFree(faV3SnapPool);
+	  faV3SnapPool = 0;
+	  FAV3UNLOCK;
+	  return ERROR;
+	}
+    }
+  else if(!enable && (faV3SnapNode != NULL))
+    {
+      dmaPFreeItem(faV3SnapNode);
+      dmaPFree(faV3SnapPool);
+      faV3SnapNode = NULL;
+      faV3SnapPool = 0;
+    }
+
+  faV3SnapDmaMode[0] = addrType;
+  faV3SnapDmaMode[1] = dataType;
+  faV3SnapDmaMode[2] = sstMode;
+  faV3SnapBlockEnabled = enable ? 1 : 0;
+  FAV3UNLOCK;
+
+  return OK;
+#endif
+}
+
+#ifndef VXWORKS
+/* Block transfers of the regions into the DMA buffer, laid out like the
+   board map.  Crate and slot locks must be held, DMA engine idle. */
+static int
+faV3SnapshotBlockRead(int id, uint32_t regions)
+{
+  volatile uint32_t *buf = faV3SnapNode->data;
+  const faV3SnapReg_t *b;
+  uint32_t vmeAdr = (uint32_t) ((u_long) FAV3p[id] - faV3A24Offset);
+  int iblk, nbytes, rval = OK;
+
+  vmeDmaConfig(1, 2, 0);	/* A24, BLT */
+  for(iblk = 0; iblk < FAV3_SNAP_NBLOCKS; iblk++)
+    {
+      b = &faV3SnapBlocks[iblk];
+      if(!(b->region & regions))
+	continue;
+
+      if(b->count == 1)
+	{
+	  buf[b->offset >> 2] =
+	    LSWAP(vmeRead32((volatile uint32_t *) ((u_long) FAV3p[id] + b->offset)));
+	  continue;
+	}
+
+      nbytes = b->count * (b->width >> 3);
+      if((vmeDmaSend((u_long) & buf[b->offset >> 2], vmeAdr + b->offset,
+		     nbytes) != 0) || (vmeDmaDone() != nbytes))
+	{
+	  printf("%s: ERROR: Slot %d block transfer of 0x%03x - 0x%03x failed\n",
+		 __func__, id, b->offset, b->offset + nbytes - 1);
+	  rval = ERROR;
+	  break;
+	}
+    }
+  vmeDmaConfig(faV3SnapDmaMode[0], faV3SnapDmaMode[1], faV3SnapDmaMode[2]);
+
+  return rval;
+}
+#endif
+
+/**
+ *  @ingroup Status
+ *  @brief Copy the status, counter and configuration registers of a
+ *         fADC250 in one pass
+ *
+ *   The registers in the faV3SnapRegs table are read in address order
+ *   with the slot lock held once: with single cycles, or with one A24
+ *   block transfer per range of registers if enabled with
+ *   faV3SnapshotBlockConfig.  The rest of the copy is 0.
+ *
+ *  @param id Slot Number
+ *  @param regions FAV3_SNAP_* regions to read
+ *  @param snap Where to put the registers
+ *  @return OK if successful, otherwise ERROR
+ */
+
+int
+faV3Snapshot(int id, uint32_t regions, faV3Snapshot_t * snap)
+{
+  volatile uint32_t *src32, *dst32;
+  volatile uint16_t *src16, *dst16;
+  const faV3SnapReg_t *r;
+  uint32_t off;
+  int ireg, i, block = 0;
+
+  CHECKID;
+
+  if(snap == NULL)
+    {
+      printf("%s: ERROR: NULL snapshot\n", __func__);
+      return ERROR;
+    }
+
+  memset(snap, 0, sizeof(faV3Snapshot_t));
+  snap->id = id;
+  snap->a24addr = (uint32_t) ((u_long) FAV3p[id] - faV3A24Offset);
+  snap->regions = regions & FAV3_SNAP_ALL;
+
+  src32 = (volatile uint32_t *) FAV3p[id];
+  src16 = (volatile uint16_t *) FAV3p[id];
+  dst32 = (volatile uint32_t *) &snap->regs;
+  dst16 = (volatile uint16_t *) &snap->regs;
+
+#ifndef VXWORKS
+  /* Block transfers: wait for a readout transfer to be completed, and
+     keep the DMA engine until the copy is in the buffer.  Single cycles
+     take only the slot lock, so look at the flag before locking. */
+  if(faV3SnapBlockEnabled)
+    {
+      FAV3LOCK;
+      block = faV3SnapBlockEnabled;
+      if(!block)
+	{
+	  FAV3UNLOCK;
+	}
+    }
+  if(block)
+    {
+      while(faV3Xfer.active != FAV3_XFER_IDLE)
+	{
+	  if(pthread_equal(faV3Xfer.owner, pthread_self()))
+	    {
+	      printf("%s: ERROR: Complete the readout transfer first\n",
+		     __func__);
+	      FAV3UNLOCK;
+	      return ERROR;
+	    }
+	  pthread_cond_wait(&faV3XferCond, &faV3Mutex);
+	}
+
+      FAV3SLOTLOCK(id);
+      if(faV3SnapshotBlockRead(id, regions) != OK)
+	{
+	  FAV3SLOTUNLOCK(id);
+	  FAV3UNLOCK;
+	  return ERROR;
+	}
+      FAV3SLOTUNLOCK(id);
+
+      src32 = faV3SnapNode->data;
+      src16 = (volatile uint16_t *) faV3SnapNode->data;
+    }
+#endif
+
+  if(!block)
+    {
+      FAV3SLOTLOCK(id);
+    }
+  for(ireg = 0; ireg < FAV3_SNAP_NREGS; ireg++)
+    {
+      r = &faV3SnapRegs[ireg];
+      if(!(r->region & regions))
+	continue;
+
+      for(i = 0, off = r->offset; i < r->count; i++, off += (r->width >> 3))
+	{
+	  if(block)
+	    {
+	      /* The buffer holds the bytes in VME (big endian) order */
+	      if(r->width == 32)
+		dst32[off >> 2] = LSWAP(src32[off >> 2]);
+	      else
+		dst16[off >> 1] = (uint16_t) ((src16[off >> 1] >> 8) |
+					      (src16[off >> 1] << 8));
+	    }
+	  else if(r->width == 32)
+	    dst32[off >> 2] = vmeRead32(&src32[off >> 2]);
+	  else
+	    dst16[off >> 1] = vmeRead16(&src16[off >> 1]);
+	}
+    }
+  if(block)
+    {
+      FAV3UNLOCK;
+    }
+  else
+    {
+      FAV3SLOTUNLOCK(id);
+    }
+
+  return OK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Copy the registers of all initialized fADC250s
+ *  @param regions FAV3_SNAP_* regions to read
+ *  @param snap Where to put the registers, one per board in faV3Slot order
+ *              (FAV3_MAX_BOARDS entries is enough)
+ *  @return Number of boards, otherwise ERROR
+ */
+
+int
+faV3GSnapshot(uint32_t regions, faV3Snapshot_t * snap)
+{
+  int ifa;
+
+  if(snap == NULL)
+    {
+      printf("%s: ERROR: NULL snapshot\n", __func__);
+      return ERROR;
+    }
+
+  for(ifa = 0; ifa < nfaV3; ifa++)
+    if(faV3Snapshot(faV3Slot(ifa), regions, &snap[ifa]) != OK)
+      return ERROR;
+
+  return nfaV3;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print Status of fADC250 to standard out
+ *  @param id Slot Number
+ *  @param sflag Reserved for future use
+ *
+ */
+
+int
+faV3Status(int id, int sflag)
+{
+  faV3Snapshot_t snap;
+
+  if(faV3Snapshot(id, FAV3_SNAP_CTRL | FAV3_SNAP_ADC | FAV3_SNAP_AUX,
+		  &snap) != OK)
+    return ERROR;
+
+  return faV3PrintStatus(&snap, sflag);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the status of a fADC250 from a snapshot
+ *  @param snap Snapshot from faV3Snapshot (FAV3_SNAP_CTRL, FAV3_SNAP_ADC
+ *              and FAV3_SNAP_AUX)
+ *  @param sflag Reserved for future use
+ *
+ */
+
+int
+faV3PrintStatus(const faV3Snapshot_t * snap, int sflag)
+{
+  const faV3_t *st = &snap->regs;
+  int id = snap->id;
+  uint32_t a32Base, ambMin, ambMax, vers;
+  uint32_t csr, ctrl1, ctrl2, count, bcount, blevel, intr, addr32, addrMB;
+  uint32_t adcStat[3], adcConf[3],
+    PTW, PL, NSB, NSA, NP, adcChanDisabled, playbackMode;
+  uint32_t adc_enabled, adc_version, adc_option;
+  uint32_t trigCnt, trig2Cnt, srCnt, itrigCnt, ramWords;
+  uint32_t mgtStatus;
+  uint32_t berr_count = 0;
+  uint32_t scaler_interval = 0;
+  uint32_t trigger_control = 0;
+  uint32_t lost_trig_scal = 0;
+
+  vers = st->version;
+
+  csr = st->csr & FAV3_CSR_MASK;
+  ctrl1 = st->ctrl1 & FAV3_CONTROL_MASK;
+  ctrl2 = st->ctrl2 & FAV3_CONTROL2_MASK;
+  count = st->ev_count & FAV3_EVENT_COUNT_MASK;
+  bcount = st->blk_count & FAV3_BLOCK_COUNT_MASK;
+  blevel = st->blocklevel & FAV3_BLOCK_LEVEL_MASK;
+  ramWords = st->ram_word_count & FAV3_RAM_DATA_MASK;
+  trigCnt = st->trig_scal;
+  trig2Cnt = st->trig2_scal;
+  srCnt = st->syncreset_scal;
+  itrigCnt = st->trig_live_count;
+  intr = st->intr;
+  addr32 = st->adr32;
+  a32Base = (addr32 & FAV3_A32_ADDR_MASK) << 16;
+  addrMB = st->adr_mb;
+  ambMin = (addrMB & FAV3_AMB_MIN_MASK) << 16;
+  ambMax = (addrMB & FAV3_AMB_MAX_MASK);
+  berr_count = st->aux.berr_driven_count;
+
+  adcStat[0] = st->adc.status0 & 0xFFFF;
+  adcStat[1] = st->adc.status1 & 0xFFFF;
+  adcStat[2] = st->adc.status2 & 0xFFFF;
+  adcConf[0] = st->adc.config1 & 0xFFFF;
+  adcConf[1] = st->adc.config2 & 0xFFFF;
+  adcConf[2] = st->adc.config4 & 0xFFFF;
+
+  PTW = (st->adc.ptw & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
+  PL = (st->adc.pl & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
+  NSB = (st->adc.nsb & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
+  NSA = (st->adc.nsa & 0xFFFF) * FAV3_ADC_NS_PER_CLK;
+  adc_version = adcStat[0] & FAV3_ADC_VERSION_MASK;
+  adc_option = (adcConf[0] & FAV3_ADC_PROC_MASK) + 1;
+  NP = (adcConf[0] & FAV3_ADC_PEAK_MASK) >> 4;
+  adc_enabled = (adcConf[0] & FAV3_ADC_PROC_ENABLE);
+  playbackMode = (adcConf[0] & FAV3_ADC_PLAYBACK_MODE) >> 7;
+  adcChanDisabled = (adcConf[1] & FAV3_ADC_CHAN_MASK);
+
+  mgtStatus = st->status_mgt;
+
+  scaler_interval = st->scaler_insert & FAV3_SCALER_INSERT_MASK;
+
+#ifdef VXWORKS
+  printf("\nSTATUS for FADC in slot %d at base address 0x%x \n",
+	 id, (uint32_t) FAV3p[id]);
+#else
+  printf("\nSTATUS for FADC in slot %d at VME (Local) base address 0x%x (0x%lx)\n",
+	 id, (uint32_t) (u_long) (FAV3p[id] - faV3A24Offset), (u_long) FAV3p[id]);
+#endif
+  printf("---------------------------------------------------------------------- \n");
+
+  printf(" Board Firmware Rev/ID = 0x%04x : ADC Processing Rev = 0x%04x\n",
+	 (vers) & 0xffff, adc_version);
+  if(addrMB & FAV3_AMB_ENABLE)
+    {
+      printf(" Alternate VME Addressing: Multiblock Enabled\n");
+      if(addr32 & FAV3_A32_ENABLE)
+	printf("   A32 Enabled at VME (Local) base 0x%08x (0x%lx)\n", a32Base,
+	       (u_long) FAV3pd[id]);
+      else
+	printf("   A32 Disabled\n");
+
+      printf("   Multiblock VME Address Range 0x%08x - 0x%08x\n", ambMin,
+	     ambMax);
+    }
+  else
+    {
+      printf(" Alternate VME Addressing: Multiblock Disabled\n");
+      if(addr32 & FAV3_A32_ENABLE)
+	printf("   A32 Enabled at VME (Local) base 0x%08x (0x%lx)\n", a32Base,
+	       (u_long) FAV3pd[id]);
+      else
+	printf("   A32 Disabled\n");
+    }
+
+  if(ctrl1 & FAV3_INT_ENABLE_MASK)
+    {
+      printf("\n  Interrupts ENABLED: ");
+      if(ctrl1 & FAV3_ENABLE_BLKLVL_INT)
+	printf(" on Block Level(%d)", blevel);
+
+      printf("\n");
+      printf("  Interrupt Reg: 0x%08x\n", intr);
+      printf("  VME INT Vector = 0x%x  Level = %d\n",
+	     (intr & FAV3_INT_VEC_MASK), ((intr & FAV3_INT_LEVEL_MASK) >> 8));
+    }
+
+  printf("\n Signal Sources: \n");
+
+  if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_INTERNAL)
+    {
+      printf("   Ref Clock : Internal\n");
+    }
+  else if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_P0)
+    {
+      printf("   Ref Clock : VXS\n");
+    }
+  else if((ctrl1 & FAV3_REF_CLK_MASK) == FAV3_REF_CLK_FP)
+    {
+      printf("   Ref Clock : Front Panel\n");
+    }
+  else
+    {
+      printf("   Ref Clock : %d (Undefined)\n", (ctrl1 & FAV3_REF_CLK_MASK));
+    }
+
+  switch (ctrl1 & FAV3_TRIG_MASK)
+    {
+    case FAV3_TRIG_INTERNAL:
+      printf("   Trig Src  : Internal\n");
+      break;
+    case FAV3_TRIG_VME:
+      printf("   Trig Src  : VME (Software)\n");
+      break;
+    case FAV3_TRIG_P0_ISYNC:
+      printf("   Trig Src  : VXS (Async)\n");
+      break;
+    case FAV3_TRIG_P0:
+      printf("   Trig Src  : VXS (Sync)\n");
+      break;
+    case FAV3_TRIG_FP_ISYNC:
+      printf("   Trig Src  : Front Panel (Async)\n");
+      break;
+    case FAV3_TRIG_FP:
+      printf("   Trig Src  : Front Panel (Sync)\n");
+    }
+
+  switch (ctrl1 & FAV3_SRESET_MASK)
+    {
+    case FAV3_SRESET_VME:
+      printf("   Sync Reset: VME (Software)\n");
+      break;
+    case FAV3_SRESET_P0_ISYNC:
+      printf("   Sync Reset: VXS (Async)\n");
+      break;
+    case FAV3_SRESET_P0:
+      printf("   Sync Reset: VXS (Sync)\n");
+      break;
+    case FAV3_SRESET_FP_ISYNC:
+      printf("   Sync Reset: Front Panel (Async)\n");
+      break;
+    case FAV3_SRESET_FP:
+      printf("   Sync Reset: Front Panel (Sync)\n");
+    }
+
+  if(faV3UseSDC)
+    {
+      printf("   SDC       : In Use\n");
+    }
+
+
+  printf("\n Configuration: \n");
+
+  if(ctrl1 & FAV3_ENABLE_INTERNAL_CLK)
+    printf("   Internal Clock ON\n");
+  else
+    printf("   Internal Clock OFF\n");
+
+  if(ctrl1 & FAV3_ENABLE_BERR)
+    printf("   Bus Error ENABLED\n");
+  else
+    printf("   Bus Error DISABLED\n");
+
+
+  if(ctrl1 & FAV3_ENABLE_MULTIBLOCK)
+    {
+      int tP0, tP2;
+      tP0 = ctrl1 & FAV3_MB_TOKEN_VIA_P0;
+      tP2 = ctrl1 & FAV3_MB_TOKEN_VIA_P2;
+
+      if(tP0)
+	{
+	  if(ctrl1 & FAV3_FIRST_BOARD)
+	    printf("   MultiBlock transfer ENABLED (First Board - token via VXS)\n");
+	  else if(ctrl1 & FAV3_LAST_BOARD)
+	    printf("   MultiBlock transfer ENABLED (Last Board  - token via VXS)\n");
+	  else
+	    printf("   MultiBlock transfer ENABLED (Token via VXS)\n");
+	  /* #ifdef VERSION1 */
+	}
+      else if(tP2)
+	{
+	  if(ctrl1 & FAV3_FIRST_BOARD)
+	    printf("   MultiBlock transfer ENABLED (First Board - token via P2)\n");
+	  else if(ctrl1 & FAV3_LAST_BOARD)
+	    printf("   MultiBlock transfer ENABLED (Last Board  - token via P2)\n");
+	  else
+	    printf("   MultiBlock transfer ENABLED (Token via P2)\n");
+	  /* #endif */
+	}
+      else
+	{
+	  printf("   MultiBlock transfer ENABLED (**NO Tokens enabled**)\n");
+	}
+    }
+  else
+    {
+      printf("   MultiBlock transfer DISABLED\n");
+    }
+
+  if(ctrl1 & FAV3_ENABLE_SOFT_TRIG)
+    printf("   Software Triggers   ENABLED\n");
+  if(ctrl1 & FAV3_ENABLE_SOFT_SRESET)
+    printf("   Software Sync Reset ENABLED\n");
+
+
+  printf("\n ADC Processing Configuration: \n");
+  printf("   Channel Disable Mask = 0x%04x\n", adcChanDisabled);
+  if(adc_enabled)
+    printf("   Mode = %d  (ENABLED)\n", adc_option);
+  else
+    printf("   Mode = %d  (Disabled)\n", adc_option);
+
+  printf("   Lookback (PL)    = %d ns   Time Window (PTW) = %d ns\n", PL,
+	 PTW);
+  printf("   Time Before Peak = %d ns   Time After Peak   = %d ns\n", NSB,
+	 NSA);
+  printf("   Max Peak Count   = %d \n", NP);
+  printf("   Playback Mode    = %d \n", playbackMode);
+
+
+
+  printf("\n");
+  printf(" Unacknowleged Trigger Stop: %s (%d)\n",
+	 (trigger_control & FAV3_TRIGCTL_TRIGSTOP_EN) ? " ENABLED" : "DISABLED",
+	 (trigger_control & FAV3_TRIGCTL_MAX2_MASK) >> 16);
+  printf(" Unacknowleged Trigger Busy: %s (%d)\n",
 	 (trigger_control & FAV3_TRIGCTL_BUSY_EN) ? " ENABLED" : "DISABLED",
 	 trigger_control & FAV3_TRIGCTL_MAX1_MASK);
 
@@ -1384,73 +2250,31 @@ faV3Status(int id, int sflag)
 void
 faV3GStatus(int sflag)
 {
-  int ifa, id, ii;
-  faV3_t st[FAV3_MAX_BOARDS + 1];
-  uint32_t a24addr[FAV3_MAX_BOARDS + 1];
-  int nsb;
+  faV3Snapshot_t snap[FAV3_MAX_BOARDS];
+  int nsnap;
 
-  FAV3LOCK;
-  for(ifa = 0; ifa < nfaV3; ifa++)
-    {
-      id = faV3Slot(ifa);
-      a24addr[id] = (uint32_t) ((u_long) FAV3p[id] - faV3A24Offset);
-      st[id].version = vmeRead32(&FAV3p[id]->version);
-      st[id].adr32 = vmeRead32(&FAV3p[id]->adr32);
-      st[id].adr_mb = vmeRead32(&FAV3p[id]->adr_mb);
-
-      st[id].ctrl1 = vmeRead32(&FAV3p[id]->ctrl1);
-      st[id].ctrl2 = vmeRead32(&FAV3p[id]->ctrl2);
-
-      st[id].csr = vmeRead32(&FAV3p[id]->csr);
-
-      st[id].sys_mon = vmeRead32(&FAV3p[id]->sys_mon);
-
-      st[id].adc.status0 =
-	vmeRead16(&FAV3p[id]->adc.status0) & 0xFFFF;
-      st[id].adc.status1 =
-	vmeRead16(&FAV3p[id]->adc.status0) & 0xFFFF;
-      st[id].adc.status2 =
-	vmeRead16(&FAV3p[id]->adc.status0) & 0xFFFF;
-
-      st[id].adc.config1 =
-	vmeRead16(&FAV3p[id]->adc.config1) & 0xFFFF;
-      st[id].adc.config2 =
-	vmeRead16(&FAV3p[id]->adc.config2) & 0xFFFF;
-      st[id].adc.config4 =
-	vmeRead16(&FAV3p[id]->adc.config4) & 0xFFFF;
-
-      st[id].adc.ptw = vmeRead16(&FAV3p[id]->adc.ptw);
-      st[id].adc.pl = vmeRead16(&FAV3p[id]->adc.pl);
-      st[id].adc.nsb = vmeRead16(&FAV3p[id]->adc.nsb);
-      st[id].adc.nsa = vmeRead16(&FAV3p[id]->adc.nsa);
-
-      st[id].adc.live_trig_mask = vmeRead16(&FAV3p[id]->adc.live_trig_mask);
-      st[id].adc.live_trig_width = vmeRead16(&FAV3p[id]->adc.live_trig_width);
-      st[id].adc.hitbit_config = vmeRead16(&FAV3p[id]->adc.hitbit_config);
-      st[id].adc.live_trig_width = vmeRead16(&FAV3p[id]->adc.live_trig_width);
-
-      st[id].blk_count = vmeRead32(&FAV3p[id]->blk_count);
-      st[id].blocklevel = vmeRead32(&FAV3p[id]->blocklevel);
-      st[id].ram_word_count =
-	vmeRead32(&FAV3p[id]->ram_word_count) & FAV3_RAM_DATA_MASK;
-
-      st[id].trig_scal = vmeRead32(&(FAV3p[id]->trig_scal));
-      st[id].trig2_scal = vmeRead32(&FAV3p[id]->trig2_scal);
-      st[id].syncreset_scal = vmeRead32(&FAV3p[id]->syncreset_scal);
-      st[id].aux.berr_driven_count = vmeRead32(&FAV3p[id]->aux.berr_driven_count);
-
-      st[id].aux.sparsify_control = vmeRead32(&FAV3p[id]->aux.sparsify_control);
-
-      for(ii = 0; ii < FAV3_MAX_ADC_CHANNELS; ii++)
-	{
-	  st[id].adc.pedestal[ii] = vmeRead16(&FAV3p[id]->adc.pedestal[ii]);
-	  st[id].adc.thres[ii] = vmeRead16(&FAV3p[id]->adc.thres[ii]);
-	  st[id].adc.trig_gain[ii] = vmeRead16(&FAV3p[id]->adc.trig_gain[ii]);
-	  st[id].adc.trig_delay[ii] = vmeRead16(&FAV3p[id]->adc.trig_delay[ii]);
-	}
+  nsnap = faV3GSnapshot(FAV3_SNAP_CTRL | FAV3_SNAP_ADC | FAV3_SNAP_AUX, snap);
+  if(nsnap < 0)
+    return;
 
-    }
-  FAV3UNLOCK;
+  faV3PrintGStatus(snap, nsnap, sflag);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print a summary of fADC250s from their snapshots
+ *  @param snap Snapshots from faV3GSnapshot (FAV3_SNAP_CTRL, FAV3_SNAP_ADC
+ *              and FAV3_SNAP_AUX)
+ *  @param nsnap Number of snapshots
+ *  @param sflag reserved for future use
+ */
+
+void
+faV3PrintGStatus(const faV3Snapshot_t * snap, int nsnap, int sflag)
+{
+  const faV3_t *st;
+  int ifa, id;
+  int nsb;
 
   printf("\n");
 
@@ -1459,30 +2283,31 @@ faV3GStatus(int sflag)
   printf("Slot  Ctrl   Proc      A24        A32     A32 Multiblock Range   VXS Readout\n");
   printf("--------------------------------------------------------------------------------\n");
 
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d  ", id);
 
-      printf("0x%04x 0x%04x  ", st[id].version & 0xFFFF,
-	     st[id].adc.status0 & FAV3_ADC_VERSION_MASK);
+      printf("0x%04x 0x%04x  ", st->version & 0xFFFF,
+	     st->adc.status0 & FAV3_ADC_VERSION_MASK);
 
-      printf("0x%06x  ", a24addr[id]);
+      printf("0x%06x  ", snap[ifa].a24addr);
 
-      if(st[id].adr32 & FAV3_A32_ENABLE)
+      if(st->adr32 & FAV3_A32_ENABLE)
 	{
-	  printf("0x%08x  ", (st[id].adr32 & FAV3_A32_ADDR_MASK) << 16);
+	  printf("0x%08x  ", (st->adr32 & FAV3_A32_ADDR_MASK) << 16);
 	}
       else
 	{
 	  printf("  Disabled  ");
 	}
 
-      if(st[id].adr_mb & FAV3_AMB_ENABLE)
+      if(st->adr_mb & FAV3_AMB_ENABLE)
 	{
 	  printf("0x%08x-0x%08x  ",
-		 (st[id].adr_mb & FAV3_AMB_MIN_MASK) << 16,
-		 (st[id].adr_mb & FAV3_AMB_MAX_MASK));
+		 (st->adr_mb & FAV3_AMB_MIN_MASK) << 16,
+		 (st->adr_mb & FAV3_AMB_MAX_MASK));
 	}
       else
 	{
@@ -1490,8 +2315,7 @@ faV3GStatus(int sflag)
 	}
 
       printf("%s",
-	     (st[id].
-	      ctrl2 & FAV3_CTRL_VXS_RO_ENABLE) ? " Enabled" : "Disabled");
+	     (st->ctrl2 & FAV3_CTRL_VXS_RO_ENABLE) ? " Enabled" : "Disabled");
 
       printf("\n");
     }
@@ -1502,50 +2326,50 @@ faV3GStatus(int sflag)
   printf("      .Signal Sources..                        ..Channel...  ..Channel.\n");
   printf("Slot  Clk   Trig   Sync     MBlk  Token  BERR  Enabled Mask  Rogue Mask\n");
   printf("--------------------------------------------------------------------------------\n");
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d  ", id);
 
       printf("%s  ",
-	     (st[id].ctrl1 & FAV3_REF_CLK_MASK) ==
-	     FAV3_REF_CLK_INTERNAL ? " INT " : (st[id].
-						ctrl1 & FAV3_REF_CLK_MASK) ==
-	     FAV3_REF_CLK_P0 ? " VXS " : (st[id].ctrl1 & FAV3_REF_CLK_MASK) ==
+	     (st->ctrl1 & FAV3_REF_CLK_MASK) ==
+	     FAV3_REF_CLK_INTERNAL ? " INT " : (st->ctrl1 & FAV3_REF_CLK_MASK) ==
+	     FAV3_REF_CLK_P0 ? " VXS " : (st->ctrl1 & FAV3_REF_CLK_MASK) ==
 	     FAV3_REF_CLK_FP ? "  FP " : " ??? ");
 
       printf("%s  ",
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_INTERNAL ? " INT " :
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_VME ? " VME " :
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_P0_ISYNC ? " VXS " :
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_FP_ISYNC ? "  FP " :
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_P0 ? " VXS " :
-	     (st[id].ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_FP ? "  FP " : " ??? ");
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_INTERNAL ? " INT " :
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_VME ? " VME " :
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_P0_ISYNC ? " VXS " :
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_FP_ISYNC ? "  FP " :
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_P0 ? " VXS " :
+	     (st->ctrl1 & FAV3_TRIG_MASK) == FAV3_TRIG_FP ? "  FP " : " ??? ");
 
       printf("%s    ",
-	     (st[id].ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_VME ? " VME " :
-	     (st[id].ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_P0_ISYNC ? " VXS " :
-	     (st[id].ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_FP_ISYNC ? "  FP " :
-	     (st[id].ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_P0 ? " VXS " :
-	     (st[id].ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_FP ? "  FP " :
+	     (st->ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_VME ? " VME " :
+	     (st->ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_P0_ISYNC ? " VXS " :
+	     (st->ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_FP_ISYNC ? "  FP " :
+	     (st->ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_P0 ? " VXS " :
+	     (st->ctrl1 & FAV3_SRESET_MASK) == FAV3_SRESET_FP ? "  FP " :
 	     " ??? ");
 
-      printf("%s   ", (st[id].ctrl1 & FAV3_ENABLE_MULTIBLOCK) ? "YES" : " NO");
+      printf("%s   ", (st->ctrl1 & FAV3_ENABLE_MULTIBLOCK) ? "YES" : " NO");
 
       printf("%s",
-	     st[id].ctrl1 & (FAV3_MB_TOKEN_VIA_P0) ? " P0" :
-	     st[id].ctrl1 & (FAV3_MB_TOKEN_VIA_P2) ? " P0" : " NO");
+	     st->ctrl1 & (FAV3_MB_TOKEN_VIA_P0) ? " P0" :
+	     st->ctrl1 & (FAV3_MB_TOKEN_VIA_P2) ? " P0" : " NO");
       printf("%s  ",
-	     st[id].ctrl1 & (FAV3_FIRST_BOARD) ? "-F" :
-	     st[id].ctrl1 & (FAV3_LAST_BOARD) ? "-L" : "  ");
+	     st->ctrl1 & (FAV3_FIRST_BOARD) ? "-F" :
+	     st->ctrl1 & (FAV3_LAST_BOARD) ? "-L" : "  ");
 
-      printf("%s     ", st[id].ctrl1 & FAV3_ENABLE_BERR ? "YES" : " NO");
+      printf("%s     ", st->ctrl1 & FAV3_ENABLE_BERR ? "YES" : " NO");
 
       printf("0x%04X        ",
-	     ~(st[id].adc.config2 & FAV3_ADC_CHAN_MASK) & 0xFFFF);
+	     ~(st->adc.config2 & FAV3_ADC_CHAN_MASK) & 0xFFFF);
 
       printf("0x%04X",
-	     st[id].adc.rogue_ptw_fall_back & FAV3_ADC_CHAN_MASK);
+	     st->adc.rogue_ptw_fall_back & FAV3_ADC_CHAN_MASK);
 
       printf("\n");
     }
@@ -1557,39 +2381,40 @@ faV3GStatus(int sflag)
   printf("Slot  Level  Mode    PL   PTW   NSB  NSA  NP   NPED  MAXPED  NSAT   Playback   \n");
   printf("--------------------------------------------------------------------------------\n");
 
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d    ", id);
 
-      printf("%3d    ", st[id].blocklevel & FAV3_BLOCK_LEVEL_MASK);
-      int proc_bits = (st[id].adc.config1 & FAV3_ADC_PROC_MASK) >> 8;
+      printf("%3d    ", st->blocklevel & FAV3_BLOCK_LEVEL_MASK);
+      int proc_bits = (st->adc.config1 & FAV3_ADC_PROC_MASK) >> 8;
       printf("%2d   ", proc_bits == 3 ? 1 : (proc_bits + 9));
 
-      printf("%4d  ", (st[id].adc.pl & 0xFFFF) * FAV3_ADC_NS_PER_CLK);
+      printf("%4d  ", (st->adc.pl & 0xFFFF) * FAV3_ADC_NS_PER_CLK);
 
-      printf("%4d   ", ((st[id].adc.ptw & 0xFFFF) + 1) * FAV3_ADC_NS_PER_CLK);
+      printf("%4d   ", ((st->adc.ptw & 0xFFFF) + 1) * FAV3_ADC_NS_PER_CLK);
 
-      nsb = st[id].adc.nsb & FAV3_ADC_NSB_READBACK_MASK;
+      nsb = st->adc.nsb & FAV3_ADC_NSB_READBACK_MASK;
       nsb =
 	(nsb & 0x7) * ((nsb & FAV3_ADC_NSB_NEGATIVE) ? -1 : 1) *
 	FAV3_ADC_NS_PER_CLK;
       printf("%3d  ", nsb);
 
       printf("%3d   ",
-	     (st[id].adc.nsa & FAV3_ADC_NSA_READBACK_MASK) * FAV3_ADC_NS_PER_CLK);
+	     (st->adc.nsa & FAV3_ADC_NSA_READBACK_MASK) * FAV3_ADC_NS_PER_CLK);
 
       printf("%1d      ",
-	     ((st[id].adc.config1 & FAV3_ADC_PEAK_MASK) >> 4) + 1);
+	     ((st->adc.config1 & FAV3_ADC_PEAK_MASK) >> 4) + 1);
 
-      printf("%2d    ", (((st[id].adc.config7 & FAV3_ADC_CONFIG7_NPED_MASK)>>10) + 1)*FAV3_ADC_NS_PER_CLK);
+      printf("%2d    ", (((st->adc.config7 & FAV3_ADC_CONFIG7_NPED_MASK)>>10) + 1)*FAV3_ADC_NS_PER_CLK);
 
-      printf("%4d     ", st[id].adc.config7 & FAV3_ADC_CONFIG7_MAXPED_MASK);
+      printf("%4d     ", st->adc.config7 & FAV3_ADC_CONFIG7_MAXPED_MASK);
 
-      printf("%d   ", ((st[id].adc.config1 & FAV3_ADC_CONFIG1_NSAT_MASK)>>10) + 1);
+      printf("%d   ", ((st->adc.config1 & FAV3_ADC_CONFIG1_NSAT_MASK)>>10) + 1);
 
       printf("%s   ",
-	     (st[id].adc.config1 &FAV3_ADC_PLAYBACK_MODE)>>7 ?" Enabled":"Disabled");
+	     (st->adc.config1 &FAV3_ADC_PLAYBACK_MODE)>>7 ?" Enabled":"Disabled");
 
       printf("\n");
     }
@@ -1599,33 +2424,34 @@ faV3GStatus(int sflag)
   printf("           ............faV3 Signal Scalers..........     ..System Monitor..\n");
   printf("Slot       Trig1       Trig2   SyncReset        BERR     TempC   1.0V   2.5V\n");
   printf("--------------------------------------------------------------------------------\n");
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d   ", id);
 
-      printf("%10d  ", st[id].trig_scal);
+      printf("%10d  ", st->trig_scal);
 
-      printf("%10d  ", st[id].trig2_scal);
+      printf("%10d  ", st->trig2_scal);
 
-      printf("%10d  ", st[id].syncreset_scal);
+      printf("%10d  ", st->syncreset_scal);
 
-      printf("%10d     ", st[id].aux.berr_driven_count);
+      printf("%10d     ", st->aux.berr_driven_count);
 
       double fpga_temperature =
-	(((double) (st[id].sys_mon & FAV3_SYSMON_CTRL_TEMP_MASK)) *
+	(((double) (st->sys_mon & FAV3_SYSMON_CTRL_TEMP_MASK)) *
 	 (503.975 / 1024.0)) - 273.15;
       printf("%3.1f    ", fpga_temperature);
 
       double fpga_1V =
 	(((double)
-	  ((st[id].sys_mon & FAV3_SYSMON_FPGA_CORE_V_MASK) >> 11)) *
+	  ((st->sys_mon & FAV3_SYSMON_FPGA_CORE_V_MASK) >> 11)) *
 	 (3.0 / 1024.0));
       printf("%3.1f    ", fpga_1V);
 
       double fpga_25V =
 	(((double)
-	  ((st[id].sys_mon & FAV3_SYSMON_FPGA_AUX_V_MASK) >> 22)) *
+	  ((st->sys_mon & FAV3_SYSMON_FPGA_AUX_V_MASK) >> 22)) *
 	 (3.0 / 1024.0));
       printf("%3.1f    ", fpga_25V);
 
@@ -1638,24 +2464,25 @@ faV3GStatus(int sflag)
   printf("      Trigger   Block                              Error Status\n");
   printf("Slot  Source    Ready  Blocks In Fifo  RAM Level   CSR     MGT\n");
   printf("--------------------------------------------------------------------------------\n");
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d  ", id);
 
       printf("%s    ",
-	     st[id].ctrl2 & FAV3_CTRL_ENABLE_MASK ? " Enabled" : "Disabled");
+	     st->ctrl2 & FAV3_CTRL_ENABLE_MASK ? " Enabled" : "Disabled");
 
-      printf("%s       ", st[id].csr & FAV3_CSR_BLOCK_READY ? "YES" : " NO");
+      printf("%s       ", st->csr & FAV3_CSR_BLOCK_READY ? "YES" : " NO");
 
-      printf("%10d ", st[id].blk_count & FAV3_BLOCK_COUNT_MASK);
+      printf("%10d ", st->blk_count & FAV3_BLOCK_COUNT_MASK);
 
-      printf("%10d  ", (st[id].ram_word_count & FAV3_RAM_DATA_MASK) * 8);
+      printf("%10d  ", (st->ram_word_count & FAV3_RAM_DATA_MASK) * 8);
 
-      printf("%s     ", st[id].csr & FAV3_CSR_ERROR_MASK ? "ERROR" : "  OK ");
+      printf("%s     ", st->csr & FAV3_CSR_ERROR_MASK ? "ERROR" : "  OK ");
 
       printf("%s  ",
-	     st[id].status_mgt &
+	     st->status_mgt &
 	     (FAV3_MGT_GTX1_HARD_ERROR | FAV3_MGT_GTX1_SOFT_ERROR |
 	      FAV3_MGT_GTX2_HARD_ERROR | FAV3_MGT_GTX2_SOFT_ERROR) ? "ERROR" : "  OK " );
 
@@ -1669,24 +2496,25 @@ faV3GStatus(int sflag)
   printf("Slot   Mask    Width   TOT     Mult    HallB  HallD Suppress  Params    Sparse\n");
   printf("--------------------------------------------------------------------------------\n");
   //       13    0xFFFF  0xFFFF  0xFF    0xFF    None   None  Disabled  Disabled  Disabled
-  for(ifa = 0; ifa < nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
       printf(" %2d    ", id);
 
-      printf("0x%04x  ", st[id].adc.live_trig_mask);
-      printf("0x%04x  ", st[id].adc.live_trig_width);
-      printf("0x%02x    ", st[id].adc.hitbit_config & 0xff);
-      printf("0x%02x    ", (st[id].adc.hitbit_config >> 8) & 0x1F);
+      printf("0x%04x  ", st->adc.live_trig_mask);
+      printf("0x%04x  ", st->adc.live_trig_width);
+      printf("0x%02x    ", st->adc.hitbit_config & 0xff);
+      printf("0x%02x    ", (st->adc.hitbit_config >> 8) & 0x1F);
 
       printf("%s",
-	     (st[id].ctrl2 & FAV3_CTRL_COMPRESS_MASK) == FAV3_CTRL_COMPRESS_DISABLE ? "None   " :
-	     (st[id].ctrl2 & FAV3_CONTROL2_MASK) == FAV3_CTRL_COMPRESS_ENABLE  ? "Enable " :
-	     (st[id].ctrl2 & FAV3_CONTROL2_MASK) == FAV3_CTRL_COMPRESS_VERIFY  ? "Verify " : "?????? ");
+	     (st->ctrl2 & FAV3_CTRL_COMPRESS_MASK) == FAV3_CTRL_COMPRESS_DISABLE ? "None   " :
+	     (st->ctrl2 & FAV3_CONTROL2_MASK) == FAV3_CTRL_COMPRESS_ENABLE  ? "Enable " :
+	     (st->ctrl2 & FAV3_CONTROL2_MASK) == FAV3_CTRL_COMPRESS_VERIFY  ? "Verify " : "?????? ");
       printf("%s",
-	     ((st[id].ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 0 ? "None  " :
-	     ((st[id].ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 1 ? "Inter " :
-	     ((st[id].ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 2 ? "Full  " : "????  ");
+	     ((st->ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 0 ? "None  " :
+	     ((st->ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 1 ? "Inter " :
+	     ((st->ctrl1 & FAV3_CTRL1_DATAFORMAT_MASK) >> 26) == 2 ? "Full  " : "????  ");
       printf("%s", "Disabled  ");
       printf("%s", "Disabled  ");
       printf("%s", "Disabled  ");
@@ -1697,13 +2525,14 @@ faV3GStatus(int sflag)
 
   printf("\n");
   printf("                      fAV3 Trigger Path Processing\n\n");
-  for(ifa=0; ifa<nfaV3; ifa++)
+  for(ifa = 0; ifa < nsnap; ifa++)
     {
       printf("           .......TET.......                                           \n");
       printf("Slot  Ch   Readout   Trigger      Gain      Ped   Delay  TrigMode  Invert  Accum\n");
       printf("--------------------------------------------------------------------------------\n");
 
-      id = faV3Slot(ifa);
+      id = snap[ifa].id;
+      st = &snap[ifa].regs;
 
       int ichan;
       for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
@@ -1716,17 +2545,17 @@ faV3GStatus(int sflag)
 	  printf("   ");
 	  printf("%2d      ",ichan);
 
-	  int NSB = (st[id].adc.nsb & FAV3_ADC_NSB_MASK) * FAV3_ADC_NS_PER_CLK;
-	  int NSA = (st[id].adc.nsa & FAV3_ADC_NSA_MASK) * FAV3_ADC_NS_PER_CLK;
-	  float gain_trg = (st[id].adc.trig_gain[ichan] & 0x4000) ?
-                           ((st[id].adc.trig_gain[ichan] & 0x3FFF) / 16384.0f) : ((st[id].adc.trig_gain[ichan] & 0x3FFF) / 256.0f);
-	  float ped_trg = 4.0 * ((float)(st[id].adc.pedestal[ichan] & FAV3_ADC_PEDESTAL_MASK)) /
+	  int NSB = (st->adc.nsb & FAV3_ADC_NSB_MASK) * FAV3_ADC_NS_PER_CLK;
+	  int NSA = (st->adc.nsa & FAV3_ADC_NSA_MASK) * FAV3_ADC_NS_PER_CLK;
+	  float gain_trg = (st->adc.trig_gain[ichan] & 0x4000) ?
+                           ((st->adc.trig_gain[ichan] & 0x3FFF) / 16384.0f) : ((st->adc.trig_gain[ichan] & 0x3FFF) / 256.0f);
+	  float ped_trg = 4.0 * ((float)(st->adc.pedestal[ichan] & FAV3_ADC_PEDESTAL_MASK)) /
 	    ((float)(NSA+NSB));
 
-	  int tet_trg = (st[id].adc.thres[ichan] & FAV3_THR_VALUE_MASK) - (int)ped_trg;
+	  int tet_trg = (st->adc.thres[ichan] & FAV3_THR_VALUE_MASK) - (int)ped_trg;
 
-	  int tet_readout = (st[id].adc.thres[ichan] & FAV3_THR_IGNORE_MASK) ? 0
-	    : ((st[id].adc.thres[ichan] & FAV3_THR_VALUE_MASK) - (int)ped_trg);
+	  int tet_readout = (st->adc.thres[ichan] & FAV3_THR_IGNORE_MASK) ? 0
+	    : ((st->adc.thres[ichan] & FAV3_THR_VALUE_MASK) - (int)ped_trg);
 
 	  printf("%4d      ", tet_readout);
 
@@ -1736,13 +2565,13 @@ faV3GStatus(int sflag)
 
 	  printf("%8.3f     ", ped_trg);
 
-	  printf("%3d     ", st[id].adc.trig_delay[ichan]);
+	  printf("%3d     ", st->adc.trig_delay[ichan]);
 
-	  printf("%s       ", (st[id].adc.trig_gain[ichan] & 0x8000) ? " DISC" : "PULSE");
+	  printf("%s       ", (st->adc.trig_gain[ichan] & 0x8000) ? " DISC" : "PULSE");
 
-	  printf("%d      ", (st[id].adc.thres[ichan] & FAV3_THR_INVERT_MASK) ? 1 : 0);
+	  printf("%d      ", (st->adc.thres[ichan] & FAV3_THR_INVERT_MASK) ? 1 : 0);
 
-	  printf("%d", (st[id].adc.thres[ichan] & FAV3_THR_ACCUMULATOR_SCALER_MODE_MASK) ? 1 : 0);
+	  printf("%d", (st->adc.thres[ichan] & FAV3_THR_ACCUMULATOR_SCALER_MODE_MASK) ? 1 : 0);
 
 	  printf("\n");
 	}
@@ -1769,7 +2598,7 @@ faV3ChannelStatus(int id, int sflag)
   int ichan;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   st.adc.nsb = vmeRead16(&FAV3p[id]->adc.nsb);
   st.adc.nsa = vmeRead16(&FAV3p[id]->adc.nsa);
 
@@ -1782,7 +2611,7 @@ faV3ChannelStatus(int id, int sflag)
     {
       st.adc.thres[ichan] = vmeRead16(&FAV3p[id]->adc.thres[ichan]);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   printf("           .......TET....... \n");
   printf("Slot  Ch   Readout   Trigger      Ped    gain    delay   mode\n");
@@ -1849,13 +2678,13 @@ faV3GetFirmwareVersions(int id, int pflag)
   uint32_t cntl = 0, proc = 0, rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Control FPGA firmware version */
   cntl = vmeRead32(&FAV3p[id]->version) & 0xFFFF;
 
   /* Processing FPGA firmware version */
   proc = vmeRead16(&(FAV3p[id]->adc.status0)) & FAV3_ADC_VERSION_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   rval = (cntl) | (proc << 16);
 
@@ -1957,7 +2786,7 @@ faV3SetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
 
   rval = faV3SetupADC(id, 0);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Disable ADC processing while writing window info */
   if(pmode == FAV3_PROC_MODE_PULSE_PARAM)
     mode_bits = 0;
@@ -1974,8 +2803,8 @@ faV3SetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
 
   /* Configure the mode (mode_bit), # of pulses (NP), # samples above TET (NSAT)
      keep TNSAT, if it's already been configured */
-  uint16_t temp = vmeRead16(&FAV3p[id]->adc.config1) & (FAV3_ADC_CONFIG1_NSAT_MASK | FAV3_ADC_CONFIG1_TNSAT_MASK);
-  vmeWrite16(&FAV3p[id]->adc.config1, (mode_bits << 8) | ((NP-1) << 4) | temp);
+  uint16_t temp = faV3RegRead16(id, &FAV3p[id]->adc.config1) & (FAV3_ADC_CONFIG1_NSAT_MASK | FAV3_ADC_CONFIG1_TNSAT_MASK);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, (mode_bits << 8) | ((NP-1) << 4) | temp);
 
   /* Disable user-requested channels */
   vmeWrite16(&FAV3p[id]->adc.config2, faV3ChanDisableMask[id]);
@@ -1989,17 +2818,17 @@ faV3SetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
     NSB = ((-1) * NSB) | FAV3_ADC_NSB_NEGATIVE;
 
   vmeWrite16(&FAV3p[id]->adc.nsb, NSB);
-  vmeWrite16(&FAV3p[id]->adc.nsa,
-	     (vmeRead16(&FAV3p[id]->adc.nsa) & FAV3_ADC_TNSA_MASK) |
-	     NSA );
+  faV3RegWrite16(id, &FAV3p[id]->adc.nsa,
+		 (faV3RegRead16(id, &FAV3p[id]->adc.nsa) & FAV3_ADC_TNSA_MASK) |
+		 NSA );
 
   /* Enable ADC processing */
-  vmeWrite16(&FAV3p[id]->adc.config1,
-	     vmeRead16(&FAV3p[id]->adc.config1) | FAV3_ADC_PROC_ENABLE );
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1,
+		 faV3RegRead16(id, &FAV3p[id]->adc.config1) | FAV3_ADC_PROC_ENABLE );
 
   /* Set default value of trigger path threshold (TPT) */
-  vmeWrite16(&FAV3p[id]->adc.config3, FAV3_ADC_DEFAULT_TPT);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.config3, FAV3_ADC_DEFAULT_TPT);
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -2026,8 +2855,8 @@ faV3GetProcMode(int id, int *pmode, uint32_t * PL, uint32_t * PTW,
 
   CHECKID;
 
-  FAV3LOCK;
-  *PTW = (vmeRead16(&(FAV3p[id]->adc.ptw) + 1) & FAV3_ADC_PTW_MASK);
+  FAV3SLOTLOCK(id);
+  *PTW = (vmeRead16(&(FAV3p[id]->adc.ptw)) & FAV3_ADC_PTW_MASK) + 1;
   *PL = (vmeRead16(&(FAV3p[id]->adc.pl)) & FAV3_ADC_PL_MASK);
   *NSB = (vmeRead16(&(FAV3p[id]->adc.nsb)) & FAV3_ADC_NSB_MASK);
   *NSA = (vmeRead16(&(FAV3p[id]->adc.nsa)) & FAV3_ADC_NSA_MASK);
@@ -2044,7 +2873,7 @@ faV3GetProcMode(int id, int *pmode, uint32_t * PL, uint32_t * PTW,
 
   *NP = ((config1 & FAV3_ADC_PEAK_MASK) >> 4) + 1;
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (0);
 }
@@ -2066,15 +2895,15 @@ faV3SetPulseParameterConfig(int32_t id, uint32_t NPED, uint32_t MAXPED, uint32_t
   CHECKID;
   int32_t rval = OK;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  vmeWrite16(&FAV3p[id]->adc.config1,
-	     (vmeRead16(&FAV3p[id]->adc.config1) & ~FAV3_ADC_CONFIG1_NSAT_MASK) |
-	     ((NSAT-1) << 10) );
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1,
+		 (faV3RegRead16(id, &FAV3p[id]->adc.config1) & ~FAV3_ADC_CONFIG1_NSAT_MASK) |
+		 ((NSAT-1) << 10) );
 
   vmeWrite16(&FAV3p[id]->adc.config7, (NPED-1)<<10 | (MAXPED));
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -2086,7 +2915,7 @@ faV3GetPulseParameterConfig(int32_t id, uint32_t *NPED, uint32_t *MAXPED, uint32
   uint16_t config1 = 0, config7 = 0;
   int32_t rval = OK;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   config1 = vmeRead16(&FAV3p[id]->adc.config1);
   *NSAT = ((config1 & FAV3_ADC_CONFIG1_NSAT_MASK) >> 10) + 1;
@@ -2095,7 +2924,7 @@ faV3GetPulseParameterConfig(int32_t id, uint32_t *NPED, uint32_t *MAXPED, uint32
   *NPED = ((config7 & FAV3_ADC_CONFIG7_NPED_MASK) >> 10) + 1;
   *MAXPED = (config7 & FAV3_ADC_CONFIG7_MAXPED_MASK);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -2121,21 +2950,21 @@ faV3SetTriggerStopCondition(int id, int trigger_max)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(trigger_max > 0)
     {
-      vmeWrite32(&FAV3p[id]->trigger_control,
-		 (vmeRead32(&FAV3p[id]->trigger_control) &
+      faV3RegWrite32(id, &FAV3p[id]->trigger_control,
+		     (faV3RegRead32(id, &FAV3p[id]->trigger_control) &
 		  ~(FAV3_TRIGCTL_TRIGSTOP_EN | FAV3_TRIGCTL_MAX2_MASK)) |
-		 (FAV3_TRIGCTL_TRIGSTOP_EN | (trigger_max << 16)));
+		     (FAV3_TRIGCTL_TRIGSTOP_EN | (trigger_max << 16)));
     }
   else
     {
-      vmeWrite32(&FAV3p[id]->trigger_control,
-		 (vmeRead32(&FAV3p[id]->trigger_control) &
+      faV3RegWrite32(id, &FAV3p[id]->trigger_control,
+		     (faV3RegRead32(id, &FAV3p[id]->trigger_control) &
 		  ~(FAV3_TRIGCTL_TRIGSTOP_EN | FAV3_TRIGCTL_MAX2_MASK)));
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2145,9 +2974,9 @@ faV3GetTriggerStopCondition(int id, int *trigger_max)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   *trigger_max = (vmeRead32(&FAV3p[id]->trigger_control) & FAV3_TRIGCTL_MAX2_MASK ) >> 16;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2173,21 +3002,21 @@ faV3SetTriggerBusyCondition(int id, int trigger_max)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(trigger_max > 0)
     {
-      vmeWrite32(&FAV3p[id]->trigger_control,
-		 (vmeRead32(&FAV3p[id]->trigger_control) &
+      faV3RegWrite32(id, &FAV3p[id]->trigger_control,
+		     (faV3RegRead32(id, &FAV3p[id]->trigger_control) &
 		  ~(FAV3_TRIGCTL_BUSY_EN | FAV3_TRIGCTL_MAX1_MASK)) |
-		 (FAV3_TRIGCTL_BUSY_EN | (trigger_max)));
+		     (FAV3_TRIGCTL_BUSY_EN | (trigger_max)));
     }
   else
     {
-      vmeWrite32(&FAV3p[id]->trigger_control,
-		 (vmeRead32(&FAV3p[id]->trigger_control) &
+      faV3RegWrite32(id, &FAV3p[id]->trigger_control,
+		     (faV3RegRead32(id, &FAV3p[id]->trigger_control) &
 		  ~(FAV3_TRIGCTL_BUSY_EN | FAV3_TRIGCTL_MAX1_MASK)));
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2197,9 +3026,9 @@ faV3GetTriggerBusyCondition(int id, int *trigger_max)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   *trigger_max = vmeRead32(&FAV3p[id]->trigger_control) & FAV3_TRIGCTL_MAX1_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2234,15 +3063,15 @@ faV3SetTriggerPathSamples(int id, uint32_t TNSA, uint32_t TNSAT)
       TNSAT = FAV3_ADC_DEFAULT_TNSAT;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  readback_nsa = vmeRead16(&FAV3p[id]->adc.nsa) & FAV3_ADC_NSA_READBACK_MASK;
-  readback_config1 = vmeRead16(&FAV3p[id]->adc.config1) & ~FAV3_ADC_CONFIG1_TNSAT_MASK;
+  readback_nsa = faV3RegRead16(id, &FAV3p[id]->adc.nsa) & FAV3_ADC_NSA_READBACK_MASK;
+  readback_config1 = faV3RegRead16(id, &FAV3p[id]->adc.config1) & ~FAV3_ADC_CONFIG1_TNSAT_MASK;
 
-  vmeWrite16(&FAV3p[id]->adc.nsa, (TNSA << 9) | readback_nsa);
-  vmeWrite16(&FAV3p[id]->adc.config1, ((TNSAT - 1) << 12) | readback_config1);
+  faV3RegWrite16(id, &FAV3p[id]->adc.nsa, (TNSA << 9) | readback_nsa);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, ((TNSAT - 1) << 12) | readback_config1);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2276,12 +3105,12 @@ faV3GetTriggerPathSamples(int id, uint32_t *TNSA, uint32_t *TNSAT)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   *TNSA = (vmeRead16(&FAV3p[id]->adc.nsa) & FAV3_ADC_TNSA_MASK) >> 9;
   *TNSAT = ((vmeRead16(&FAV3p[id]->adc.config1) & FAV3_ADC_CONFIG1_TNSAT_MASK) >> 12) + 1;
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2306,10 +3135,10 @@ faV3SetTriggerPathThreshold(int id, uint32_t TPT)
       TPT = FAV3_ADC_MAX_TPT;
     }
 
-  FAV3LOCK;
-  vmeWrite16(&FAV3p[id]->adc.config3,
-	     (vmeRead16(&FAV3p[id]->adc.config3) & ~FAV3_ADC_CONFIG3_TPT_MASK) | TPT);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config3,
+		 (faV3RegRead16(id, &FAV3p[id]->adc.config3) & ~FAV3_ADC_CONFIG3_TPT_MASK) | TPT);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2340,9 +3169,9 @@ faV3GetTriggerPathThreshold(int id, uint32_t *TPT)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   *TPT = vmeRead16(&FAV3p[id]->adc.config3) & FAV3_ADC_CONFIG3_TPT_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2441,7 +3270,7 @@ faV3SetupADC(int id, int32_t mode)
     printf("%s(%d): ---- Initializing ADC chips ----\n",
 	   __func__, id);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.config4, 0x0);			/* reset adc chip */
   taskDelay(1);
 
@@ -2472,7 +3301,7 @@ faV3SetupADC(int id, int32_t mode)
   if(debug)
     printf("%s(%d):   ---- ADC chips in normal running mode ----\n",
 	   __func__, id);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -2508,7 +3337,7 @@ faV3SetPPG(int id, uint16_t *sdata, int nsamples)
   if((nsamples <= 0) || (nsamples > FAV3_PPG_MAX_SAMPLES))
     nsamples = FAV3_PPG_MAX_SAMPLES;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii = 0; ii < (nsamples - 2); ii++)
     {
       vmeWrite16(&FAV3p[id]->adc.test_wave, (sdata[ii] | FAV3_PPG_WRITE_VALUE));
@@ -2535,7 +3364,7 @@ faV3SetPPG(int id, uint16_t *sdata, int nsamples)
   /*   vmeWrite16(&FAV3p[id]->adc.test_wave, (sdata[(nsamples-2)]&FAV3_PPG_SAMPLE_MASK)); */
   /*   vmeWrite16(&FAV3p[id]->adc.test_wave, (sdata[(nsamples-1)]&FAV3_PPG_SAMPLE_MASK)); */
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -2554,11 +3383,11 @@ faV3PPGEnable(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  val1 = (vmeRead16(&FAV3p[id]->adc.config1) & 0xFFFF);
+  FAV3SLOTLOCK(id);
+  val1 = (faV3RegRead16(id, &FAV3p[id]->adc.config1) & 0xFFFF);
   val1 |= (FAV3_PPG_ENABLE | 0xff00);
-  vmeWrite16(&FAV3p[id]->adc.config1, val1);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, val1);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2577,12 +3406,12 @@ faV3PPGDisable(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  val1 = (vmeRead16(&FAV3p[id]->adc.config1) & 0xFFFF);
+  FAV3SLOTLOCK(id);
+  val1 = (faV3RegRead16(id, &FAV3p[id]->adc.config1) & 0xFFFF);
   val1 &= ~FAV3_PPG_ENABLE;
   val1 &= ~(0xff00);
-  vmeWrite16(&FAV3p[id]->adc.config1, val1);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, val1);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2603,326 +3432,505 @@ faV3ItrigControl(int id, uint16_t itrig_width, uint16_t itrig_dt)
 
   CHECKID;
 
-  /* If both parameters = 0 then just return the current value */
-  FAV3LOCK;
-  if((itrig_width == 0) && (itrig_dt == 0))
-    {
-      retval = vmeRead32(&(FAV3p[id]->trig_cfg));
-    }
-  else
-    {
-      if((itrig_width == 0) || (itrig_width > 255))
-	itrig_width = 0xc;	/* default 48ns */
-      if((itrig_dt == 0) || (itrig_dt > 255))
-	itrig_dt = 0xa;		/* default 40ns */
+  /* If both parameters = 0 then just return the current value */
+  FAV3SLOTLOCK(id);
+  if((itrig_width == 0) && (itrig_dt == 0))
+    {
+      retval = vmeRead32(&(FAV3p[id]->trig_cfg));
+    }
+  else
+    {
+      if((itrig_width == 0) || (itrig_width > 255))
+	itrig_width = 0xc;	/* default 48ns */
+      if((itrig_dt == 0) || (itrig_dt > 255))
+	itrig_dt = 0xa;		/* default 40ns */
+
+      vmeWrite32(&(FAV3p[id]->trig_cfg), (itrig_width << 16) | itrig_dt);
+      retval = vmeRead32(&(FAV3p[id]->trig_cfg));
+    }
+  FAV3SLOTUNLOCK(id);
+
+  return (retval);
+}
+
+
+
+/**
+ *  @ingroup Readout
+ *  @brief General Data readout routine
+ *
+ *  @param  id     Slot number of module to read
+ *  @param  data   local memory address to place data
+ *  @param  nwrds  Max number of words to transfer
+ *  @param  rflag  Readout Flag
+ * <pre>
+ *              0 - programmed I/O from the specified board
+ *              1 - DMA transfer using Universe/Tempe DMA Engine
+ *                    (DMA VME transfer Mode must be setup prior)
+ *              2 - Multiblock DMA transfer (Multiblock must be enabled
+ *                     and daisychain in place or SD being used)
+ * </pre>
+ *
+ *    A DMA transfer waits for one started by another thread with
+ *    faV3ReadBlockStart to be completed.
+ *
+ *  @sa faV3ReadBlockStart faV3ReadBlockDone
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ */
+
+int
+faV3ReadBlock(int id, volatile uint32_t *data, int nwrds, int rflag)
+{
+  int ii;
+  int retVal, rmode;
+  int dCnt, berr = 0;
+  uint32_t bhead, ehead, val;
+
+  CHECKID;
+
+  if(data == NULL)
+    {
+      logMsg("faV3ReadBlock: ERROR: Invalid Destination address\n", 0, 0, 0, 0,
+	     0, 0);
+      return (ERROR);
+    }
+
+  if(nwrds <= 0)
+    nwrds = (FAV3_MAX_ADC_CHANNELS * FAV3_MAX_DATA_PER_CHANNEL) + 8;
+  rmode = rflag & 0x0f;
+
+  if(rmode >= 1)
+    {				/* Block Transfers */
+      /* faV3BlockError is set under the crate lock by Start and Done */
+      retVal = faV3ReadBlockStart(id, data, nwrds, rflag);
+      if(retVal != OK)
+	return (retVal);
+
+      return faV3ReadBlockDone();
+    }
+  else
+    {				/*Programmed IO */
+      faV3BlockError = FAV3_BLOCKERROR_NO_ERROR;
+      if(faV3A32Offset == 0)
+	{
+	  logMsg("faV3ReadBlock(%d): ERROR: Invalid Readout mode (%d) for A32 address (0x%08x)", rmode, (unsigned int)(unsigned long)FAV3pd[id]);
+	  return ERROR;
+	}
+
+      /* Check if Bus Errors are enabled. If so then disable for Prog I/O reading */
+      FAV3SLOTLOCK(id);
+      berr = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_ENABLE_BERR;
+      if(berr)
+	faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		       faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
+
+      dCnt = 0;
+      /* Read Block Header - should be first word */
+      bhead = (uint32_t) * FAV3pd[id];
+#ifndef VXWORKS
+      bhead = LSWAP(bhead);
+#endif
+      if((bhead & FAV3_DATA_TYPE_DEFINE)
+	 && ((bhead & FAV3_DATA_TYPE_MASK) == FAV3_DATA_BLOCK_HEADER))
+	{
+	  ehead = (uint32_t) * FAV3pd[id];
+#ifndef VXWORKS
+	  ehead = LSWAP(ehead);
+#endif
+
+#ifdef VXWORKS
+	  data[dCnt] = bhead;
+#else
+	  data[dCnt] = LSWAP(bhead);	/* Swap back to little-endian */
+#endif
+	  dCnt++;
+#ifdef VXWORKS
+	  data[dCnt] = ehead;
+#else
+	  data[dCnt] = LSWAP(ehead);	/* Swap back to little-endian */
+#endif
+	  dCnt++;
+	}
+      else
+	{
+	  /* We got bad data - Check if there is any data at all */
+	  if((vmeRead32(&(FAV3p[id]->ev_count)) & FAV3_EVENT_COUNT_MASK) == 0)
+	    {
+	      logMsg("faV3ReadBlock: FIFO Empty (0x%08x)\n", bhead, 0, 0, 0, 0,
+		     0);
+	      FAV3SLOTUNLOCK(id);
+	      return (0);
+	    }
+	  else
+	    {
+	      logMsg("faV3ReadBlock: ERROR: Invalid Header Word 0x%08x\n",
+		     bhead, 0, 0, 0, 0, 0);
+	      FAV3SLOTUNLOCK(id);
+	      return (ERROR);
+	    }
+	}
+
+      ii = 0;
+      while(ii < nwrds)
+	{
+	  val = (uint32_t) * FAV3pd[id];
+	  data[ii + 2] = val;
+#ifndef VXWORKS
+	  val = LSWAP(val);
+#endif
+	  if((val & FAV3_DATA_TYPE_DEFINE)
+	     && ((val & FAV3_DATA_TYPE_MASK) == FAV3_DATA_BLOCK_TRAILER))
+	    break;
+	  ii++;
+	}
+      ii++;
+      dCnt += ii;
+
+      if(berr)
+	faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		       faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
 
-      vmeWrite32(&(FAV3p[id]->trig_cfg), (itrig_width << 16) | itrig_dt);
-      retval = vmeRead32(&(FAV3p[id]->trig_cfg));
+      FAV3SLOTUNLOCK(id);
+      return (dCnt);
     }
-  FAV3UNLOCK;
-
-  return (retval);
-}
 
+  return (OK);
 
+}				//End faReadBlock
 
 /**
  *  @ingroup Readout
- *  @brief General Data readout routine
+ *  @brief Start a DMA transfer of the current block and return without
+ *         waiting for it to complete.
+ *
+ *    The transfer is completed with faV3ReadBlockDone.  Only one transfer
+ *    may be in flight at a time (there is a single DMA engine): while
+ *    another thread has one in flight, this waits for it to be completed.
+ *    A thread must complete its own transfer before starting the next.
+ *    The destination buffer must not be touched until faV3ReadBlockDone
+ *    returns.
  *
  *  @param  id     Slot number of module to read
  *  @param  data   local memory address to place data
  *  @param  nwrds  Max number of words to transfer
  *  @param  rflag  Readout Flag
  * <pre>
- *              0 - programmed I/O from the specified board
  *              1 - DMA transfer using Universe/Tempe DMA Engine
  *                    (DMA VME transfer Mode must be setup prior)
  *              2 - Multiblock DMA transfer (Multiblock must be enabled
  *                     and daisychain in place or SD being used)
  * </pre>
- *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ *  @sa faV3ReadBlockDone faV3ReadBlockPending
+ *  @return OK if the transfer was started, otherwise ERROR.
  */
 
 int
-faV3ReadBlock(int id, volatile uint32_t *data, int nwrds, int rflag)
+faV3ReadBlockStart(int id, volatile uint32_t *data, int nwrds, int rflag)
 {
-  int ii;
-  int stat, retVal, xferCount, rmode, async;
-  int dCnt, berr = 0;
+  int retVal, rmode;
   int dummy = 0;
   volatile uint32_t *laddr;
-  uint32_t bhead, ehead, val;
-  uint32_t vmeAdr, csr;
+  uint32_t vmeAdr;
 
   CHECKID;
 
   if(data == NULL)
     {
-      logMsg("faV3ReadBlock: ERROR: Invalid Destination address\n", 0, 0, 0, 0,
+      logMsg("faV3ReadBlockStart: ERROR: Invalid Destination address\n", 0, 0, 0, 0,
 	     0, 0);
       return (ERROR);
     }
 
-  faV3BlockError = FAV3_BLOCKERROR_NO_ERROR;
-  if(nwrds <= 0)
-    nwrds = (FAV3_MAX_ADC_CHANNELS * FAV3_MAX_DATA_PER_CHANNEL) + 8;
   rmode = rflag & 0x0f;
+  if(rmode < 1)
+    {
+      logMsg("faV3ReadBlockStart: ERROR: Invalid DMA readout mode (%d)\n",
+	     rmode, 0, 0, 0, 0, 0);
+      return (ERROR);
+    }
 
-  if(rmode >= 1)
-    {				/* Block Transfers */
+  if(nwrds <= 0)
+    nwrds = (FAV3_MAX_ADC_CHANNELS * FAV3_MAX_DATA_PER_CHANNEL) + 8;
 
-      /*Assume that the DMA programming is already setup. */
-      /* Don't Bother checking if there is valid data - that should be done prior
-         to calling the read routine */
+  /*Assume that the DMA programming is already setup. */
+  /* Don't Bother checking if there is valid data - that should be done prior
+     to calling the read routine */
 
-      /* Check for 8 byte boundary for address - insert dummy word (Slot 0 FADC Dummy DATA) */
-      if((u_long) (data) & 0x7)
-	{
+  /* Check for 8 byte boundary for address - insert dummy word (Slot 0 FADC Dummy DATA)
+     Buffers from faV3Ring are always aligned, this is for raw pointers */
+  if((u_long) (data) & 0x7)
+    {
 #ifdef VXWORKS
-	  *data = FAV3_DUMMY_DATA;
+      *data = FAV3_DUMMY_DATA;
 #else
-	  *data = LSWAP(FAV3_DUMMY_DATA);
+      *data = LSWAP(FAV3_DUMMY_DATA);
 #endif
-	  dummy = 1;
-	  laddr = (data + 1);
-	}
-      else
-	{
-	  dummy = 0;
-	  laddr = data;
-	}
+      dummy = 1;
+      laddr = (data + 1);
+    }
+  else
+    {
+      dummy = 0;
+      laddr = data;
+    }
 
-      if(rmode == 1)
+  if(rmode == 1)
+    {
+      /* Check for valid A32 data pointer */
+      if(FAV3pd[id] == NULL)
 	{
-	  /* Check for valid A32 data pointer */
-	  if(FAV3pd[id] == NULL)
-	    {
-	      logMsg("faV3ReadBlock(id = %d): ERROR: A32 Data Pointer not initialized\n",
-		     id, 0, 0, 0, 0, 0);
-	      return ERROR;
-	    }
-	}
-
-      FAV3LOCK;
-      if(rmode == 2)
-	{			/* Multiblock Mode */
-	  if((vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_FIRST_BOARD) == 0)
-	    {
-	      logMsg("faV3ReadBlock: ERROR: FADC in slot %d is not First Board\n",
+	  logMsg("faV3ReadBlockStart(id = %d): ERROR: A32 Data Pointer not initialized\n",
 		 id, 0, 0, 0, 0, 0);
-	      FAV3UNLOCK;
-	      return (ERROR);
-	    }
-	  vmeAdr = (uint32_t) ((u_long) (FAV3pmb) - faV3A32Offset);
+	  return ERROR;
 	}
-      else
+    }
+
+  /* The crate lock covers the DMA engine, FAV3pmb and faV3Xfer.  Wait
+     here for a transfer started by another thread to be completed. */
+  FAV3LOCK;
+#ifndef VXWORKS
+  while((faV3Xfer.active != FAV3_XFER_IDLE)
+	&& !pthread_equal(faV3Xfer.owner, pthread_self()))
+    pthread_cond_wait(&faV3XferCond, &faV3Mutex);
+#endif
+  if(faV3Xfer.active != FAV3_XFER_IDLE)
+    {
+      logMsg("faV3ReadBlockStart: ERROR: Previous transfer (slot %d) not completed\n",
+	     faV3Xfer.id, 0, 0, 0, 0, 0);
+      FAV3UNLOCK;
+      return (ERROR);
+    }
+  faV3BlockError = FAV3_BLOCKERROR_NO_ERROR;
+
+  FAV3SLOTLOCK(id);
+  if(rmode == 2)
+    {			/* Multiblock Mode */
+      if((vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_FIRST_BOARD) == 0)
 	{
-	  vmeAdr = (uint32_t) ((u_long) (FAV3pd[id]) - faV3A32Offset);
+	  logMsg("faV3ReadBlockStart: ERROR: FADC in slot %d is not First Board\n",
+		 id, 0, 0, 0, 0, 0);
+	  FAV3SLOTUNLOCK(id);
+	  FAV3UNLOCK;
+	  return (ERROR);
 	}
+      vmeAdr = (uint32_t) ((u_long) (FAV3pmb) - faV3A32Offset);
+    }
+  else
+    {
+      vmeAdr = (uint32_t) ((u_long) (FAV3pd[id]) - faV3A32Offset);
+    }
 
 #ifdef VXWORKS
-      retVal = sysVmeDmaSend((uint32_t) laddr, vmeAdr, (nwrds << 2), 0);
+  retVal = sysVmeDmaSend((uint32_t) laddr, vmeAdr, (nwrds << 2), 0);
 #else
-      retVal = vmeDmaSend((u_long) laddr, vmeAdr, (nwrds << 2));
+  retVal = vmeDmaSend((u_long) laddr, vmeAdr, (nwrds << 2));
 #endif
-      if(retVal != 0)
-	{
-	  logMsg("faV3ReadBlock: ERROR in DMA transfer Initialization 0x%x\n",
-		 retVal, 0, 0, 0, 0, 0);
-	  FAV3UNLOCK;
-	  return (retVal);
-	}
+  if(retVal != 0)
+    {
+      logMsg("faV3ReadBlockStart: ERROR in DMA transfer Initialization 0x%x\n",
+	     retVal, 0, 0, 0, 0, 0);
+      FAV3SLOTUNLOCK(id);
+      FAV3UNLOCK;
+      return (retVal);
+    }
+
+  faV3Xfer.id = id;
+  faV3Xfer.rmode = rmode;
+  faV3Xfer.nwrds = nwrds;
+  faV3Xfer.dummy = dummy;
+#ifndef VXWORKS
+  faV3Xfer.owner = pthread_self();
+#endif
+  faV3Xfer.active = FAV3_XFER_ACTIVE;
+  FAV3SLOTUNLOCK(id);
+  FAV3UNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Wait for the DMA transfer started with faV3ReadBlockStart to
+ *         complete.
+ *
+ *    faV3BlockError is set with the same meaning as for faV3ReadBlock.
+ *
+ *  @sa faV3ReadBlockStart faV3ReadBlockDoneStatus faV3GetBlockError
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ */
+
+int
+faV3ReadBlockDone()
+{
+  return faV3ReadBlockDoneStatus(NULL);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Wait for the DMA transfer started with faV3ReadBlockStart to
+ *         complete, and return its block error.
+ *
+ *    faV3GetBlockError reports the last transfer in the crate, which may
+ *    already be another thread's by the time it is called.  The block
+ *    error returned here is the one of this transfer.
+ *
+ *  @param blockError Where to put the FAV3_BLOCKERROR_* of the transfer
+ *                    (may be NULL)
+ *  @sa faV3ReadBlockStart faV3ReadBlockDone
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ */
+
+int
+faV3ReadBlockDoneStatus(int *blockError)
+{
+  int id, rmode, nwrds, dummy;
+  int stat, retVal, xferCount;
+  int berr = FAV3_BLOCKERROR_NO_ERROR;
+  uint32_t csr;
+
+  /* Claim the transfer, so that it is completed only once */
+  FAV3LOCK;
+  if(faV3Xfer.active != FAV3_XFER_ACTIVE)
+    {
+      FAV3UNLOCK;
+      logMsg("faV3ReadBlockDone: ERROR: No transfer in progress\n",
+	     0, 0, 0, 0, 0, 0);
+      return (ERROR);
+    }
+  faV3Xfer.active = FAV3_XFER_DONE;
+  id = faV3Xfer.id;
+  rmode = faV3Xfer.rmode;
+  nwrds = faV3Xfer.nwrds;
+  dummy = faV3Xfer.dummy;
+  FAV3UNLOCK;
 
-      /* Wait until Done or Error */
+  /* Wait until Done or Error.  The lock is not held, so register access
+     to other boards may go on meanwhile.  The DMA engine stays claimed
+     (FAV3_XFER_DONE) until the bookkeeping below is finished. */
 #ifdef VXWORKS
-      retVal = sysVmeDmaDone(10000, 1);
+  retVal = sysVmeDmaDone(10000, 1);
 #else
-      retVal = vmeDmaDone();
+  retVal = vmeDmaDone();
 #endif
 
-      if(retVal > 0)
+  if(retVal > 0)
+    {
+      /* Check to see that Bus error was generated by FADC */
+      if(rmode == 2)
 	{
-	  /* Check to see that Bus error was generated by FADC */
-	  if(rmode == 2)
-	    {
-	      csr = vmeRead32(&(FAV3p[faV3MaxSlot]->csr));	/* from Last FADC */
-	    }
-	  else
-	    {
-	      csr = vmeRead32(&(FAV3p[id]->csr));	/* from Last FADC */
-	    }
-	  stat = (csr) & FAV3_CSR_BERR_STATUS;
+	  FAV3SLOTLOCK(faV3MaxSlot);
+	  csr = vmeRead32(&(FAV3p[faV3MaxSlot]->csr));	/* from Last FADC */
+	  FAV3SLOTUNLOCK(faV3MaxSlot);
+	}
+      else
+	{
+	  FAV3SLOTLOCK(id);
+	  csr = vmeRead32(&(FAV3p[id]->csr));	/* from Last FADC */
+	  FAV3SLOTUNLOCK(id);
+	}
+      stat = (csr) & FAV3_CSR_BERR_STATUS;
 
-	  if((retVal > 0) && (stat))
-	    {
 #ifdef VXWORKS
-	      xferCount = (nwrds - (retVal >> 2) + dummy);	/* Number of Longwords transfered */
+      xferCount = (nwrds - (retVal >> 2) + dummy);	/* Number of Longwords transfered */
 #else
-	      xferCount = ((retVal >> 2) + dummy);	/* Number of Longwords transfered */
+      xferCount = ((retVal >> 2) + dummy);	/* Number of Longwords transfered */
 #endif
-	      FAV3UNLOCK;
-	      return (xferCount);	/* Return number of data words transfered */
+
+      if(!stat)
+	{
+#ifdef VXWORKS
+	  logMsg
+	    ("faReadBlock: DMA transfer terminated by unknown BUS Error (csr=0x%x xferCount=%d id=%d)\n",
+	     csr, xferCount, id, 0, 0, 0);
+	  berr = FAV3_BLOCKERROR_UNKNOWN_BUS_ERROR;
+#else
+	  if((retVal >> 2) == nwrds)
+	    {
+	      logMsg
+		("faReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",
+		 nwrds, 0, 0, 0, 0, 0);
+	      berr = FAV3_BLOCKERROR_TERM_ON_WORDCOUNT;
 	    }
 	  else
 	    {
-#ifdef VXWORKS
-	      xferCount = (nwrds - (retVal >> 2) + dummy);	/* Number of Longwords transfered */
 	      logMsg
 		("faReadBlock: DMA transfer terminated by unknown BUS Error (csr=0x%x xferCount=%d id=%d)\n",
 		 csr, xferCount, id, 0, 0, 0);
-	      faV3BlockError = FAV3_BLOCKERROR_UNKNOWN_BUS_ERROR;
-#else
-	      xferCount = ((retVal >> 2) + dummy);	/* Number of Longwords transfered */
-	      if((retVal >> 2) == nwrds)
-		{
-		  logMsg
-		    ("faReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",
-		     nwrds, 0, 0, 0, 0, 0);
-		  faV3BlockError = FAV3_BLOCKERROR_TERM_ON_WORDCOUNT;
-		}
-	      else
-		{
-		  logMsg
-		    ("faReadBlock: DMA transfer terminated by unknown BUS Error (csr=0x%x xferCount=%d id=%d)\n",
-		     csr, xferCount, id, 0, 0, 0);
-		  faV3BlockError = FAV3_BLOCKERROR_UNKNOWN_BUS_ERROR;
-		}
-#endif
-	      FAV3UNLOCK;
-	      if(rmode == 2)
-		faV3GetTokenStatus(1);
-
-	      return (xferCount);
+	      berr = FAV3_BLOCKERROR_UNKNOWN_BUS_ERROR;
 	    }
-	}
-      else if(retVal == 0)
-	{			/* Block Error finished without Bus Error */
-#ifdef VXWORKS
-	  logMsg
-	    ("faReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",
-	     nwrds, 0, 0, 0, 0, 0);
-#else
-	  logMsg
-	    ("faReadBlock: WARN: DMA transfer returned zero word count 0x%x\n",
-	     nwrds, 0, 0, 0, 0, 0);
 #endif
-	  faV3BlockError = FAV3_BLOCKERROR_ZERO_WORD_COUNT;
-	  FAV3UNLOCK;
-
 	  if(rmode == 2)
 	    faV3GetTokenStatus(1);
-
-	  return (nwrds);
 	}
-      else
-	{			/* Error in DMA */
+    }
+  else if(retVal == 0)
+    {			/* Block Error finished without Bus Error */
 #ifdef VXWORKS
-	  logMsg("faV3ReadBlock: ERROR: sysVmeDmaDone returned an Error\n", 0,
-		 0, 0, 0, 0, 0);
+      logMsg
+	("faReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",
+	 nwrds, 0, 0, 0, 0, 0);
 #else
-	  logMsg("faV3ReadBlock: ERROR: vmeDmaDone returned an Error\n", 0, 0,
-		 0, 0, 0, 0);
+      logMsg
+	("faReadBlock: WARN: DMA transfer returned zero word count 0x%x\n",
+	 nwrds, 0, 0, 0, 0, 0);
 #endif
-	  faV3BlockError = FAV3_BLOCKERROR_DMADONE_ERROR;
-	  FAV3UNLOCK;
+      berr = FAV3_BLOCKERROR_ZERO_WORD_COUNT;
 
-	  if(rmode == 2)
-	    faV3GetTokenStatus(1);
-
-	  return (retVal >> 2);
-	}
+      if(rmode == 2)
+	faV3GetTokenStatus(1);
 
+      xferCount = nwrds;
     }
   else
-    {				/*Programmed IO */
-      if(faV3A32Offset == 0)
-	{
-	  logMsg("faV3ReadBlock(%d): ERROR: Invalid Readout mode (%d) for A32 address (0x%08x)", rmode, (unsigned int)(unsigned long)FAV3pd[id]);
-	  return ERROR;
-	}
-
-      /* Check if Bus Errors are enabled. If so then disable for Prog I/O reading */
-      FAV3LOCK;
-      berr = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_ENABLE_BERR;
-      if(berr)
-	vmeWrite32(&(FAV3p[id]->ctrl1),
-		   vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
-
-      dCnt = 0;
-      /* Read Block Header - should be first word */
-      bhead = (uint32_t) * FAV3pd[id];
-#ifndef VXWORKS
-      bhead = LSWAP(bhead);
-#endif
-      if((bhead & FAV3_DATA_TYPE_DEFINE)
-	 && ((bhead & FAV3_DATA_TYPE_MASK) == FAV3_DATA_BLOCK_HEADER))
-	{
-	  ehead = (uint32_t) * FAV3pd[id];
-#ifndef VXWORKS
-	  ehead = LSWAP(ehead);
-#endif
-
-#ifdef VXWORKS
-	  data[dCnt] = bhead;
-#else
-	  data[dCnt] = LSWAP(bhead);	/* Swap back to little-endian */
-#endif
-	  dCnt++;
+    {			/* Error in DMA */
 #ifdef VXWORKS
-	  data[dCnt] = ehead;
+      logMsg("faV3ReadBlockDone: ERROR: sysVmeDmaDone returned an Error\n", 0,
+	     0, 0, 0, 0, 0);
 #else
-	  data[dCnt] = LSWAP(ehead);	/* Swap back to little-endian */
-#endif
-	  dCnt++;
-	}
-      else
-	{
-	  /* We got bad data - Check if there is any data at all */
-	  if((vmeRead32(&(FAV3p[id]->ev_count)) & FAV3_EVENT_COUNT_MASK) == 0)
-	    {
-	      logMsg("faV3ReadBlock: FIFO Empty (0x%08x)\n", bhead, 0, 0, 0, 0,
-		     0);
-	      FAV3UNLOCK;
-	      return (0);
-	    }
-	  else
-	    {
-	      logMsg("faV3ReadBlock: ERROR: Invalid Header Word 0x%08x\n",
-		     bhead, 0, 0, 0, 0, 0);
-	      FAV3UNLOCK;
-	      return (ERROR);
-	    }
-	}
-
-      ii = 0;
-      while(ii < nwrds)
-	{
-	  val = (uint32_t) * FAV3pd[id];
-	  data[ii + 2] = val;
-#ifndef VXWORKS
-	  val = LSWAP(val);
+      logMsg("faV3ReadBlockDone: ERROR: vmeDmaDone returned an Error\n", 0, 0,
+	     0, 0, 0, 0);
 #endif
-	  if((val & FAV3_DATA_TYPE_DEFINE)
-	     && ((val & FAV3_DATA_TYPE_MASK) == FAV3_DATA_BLOCK_TRAILER))
-	    break;
-	  ii++;
-	}
-      ii++;
-      dCnt += ii;
+      berr = FAV3_BLOCKERROR_DMADONE_ERROR;
 
-      if(berr)
-	vmeWrite32(&(FAV3p[id]->ctrl1),
-		   vmeRead32(&(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
+      if(rmode == 2)
+	faV3GetTokenStatus(1);
 
-      FAV3UNLOCK;
-      return (dCnt);
+      xferCount = (retVal >> 2);
     }
 
+  /* Bookkeeping done: publish the block error and free the DMA engine */
+  FAV3LOCK;
+  faV3BlockError = berr;
+  faV3Xfer.active = FAV3_XFER_IDLE;
+#ifndef VXWORKS
+  pthread_cond_broadcast(&faV3XferCond);
+#endif
   FAV3UNLOCK;
-  return (OK);
 
-}				//End faReadBlock
+  if(blockError != NULL)
+    *blockError = berr;
+
+  return (xferCount);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Check if a transfer started with faV3ReadBlockStart has not yet
+ *         been completed with faV3ReadBlockDone.
+ *  @return 1 if a transfer is in flight, otherwise 0.
+ */
+
+int
+faV3ReadBlockPending()
+{
+  int rval;
+
+  FAV3LOCK;
+  rval = (faV3Xfer.active != FAV3_XFER_IDLE);
+  FAV3UNLOCK;
+
+  return rval;
+}
 
 /**
  *  @ingroup Status
@@ -2983,19 +3991,19 @@ faV3PrintBlock(int id)
     }
 
   /* Check if data available */
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if((vmeRead32(&(FAV3p[id]->ev_count)) & FAV3_EVENT_COUNT_MASK) == 0)
     {
       printf("faV3PrintBlock: ERROR: FIFO Empty\n");
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       return (0);
     }
 
   /* Check if Bus Errors are enabled. If so then disable for reading */
   berr = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_ENABLE_BERR;
   if(berr)
-    vmeWrite32(&(FAV3p[id]->ctrl1),
-	       vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
+    faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		   faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
 
   dCnt = 0;
   /* Read Block Header - should be first word */
@@ -3023,14 +4031,14 @@ faV3PrintBlock(int id)
       if((vmeRead32(&(FAV3p[id]->ev_count)) & FAV3_EVENT_COUNT_MASK) == 0)
 	{
 	  logMsg("faV3PrintBlock: FIFO Empty (0x%08x)\n", bhead, 0, 0, 0, 0, 0);
-	  FAV3UNLOCK;
+	  FAV3SLOTUNLOCK(id);
 	  return (0);
 	}
       else
 	{
 	  logMsg("faV3PrintBlock: ERROR: Invalid Header Word 0x%08x\n", bhead,
 		 0, 0, 0, 0, 0);
-	  FAV3UNLOCK;
+	  FAV3SLOTUNLOCK(id);
 	  return (ERROR);
 	}
     }
@@ -3058,10 +4066,10 @@ faV3PrintBlock(int id)
   dCnt += ii;
 
   if(berr)
-    vmeWrite32(&(FAV3p[id]->ctrl1),
-	       vmeRead32(&(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
+    faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		   faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return (dCnt);
 
 }
@@ -3081,9 +4089,9 @@ faV3ReadCSR(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&(FAV3p[id]->csr));
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -3099,9 +4107,9 @@ faV3Clear(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_SOFT_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3135,9 +4143,9 @@ faV3ClearError(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_ERROR_CLEAR);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3176,7 +4184,7 @@ faV3Reset(int id, int iFlag)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(iFlag == 0)
     {
       a32addr = vmeRead32(&(FAV3p[id]->adr32));
@@ -3191,7 +4199,11 @@ faV3Reset(int id, int iFlag)
       vmeWrite32(&(FAV3p[id]->adr32), a32addr);
       vmeWrite32(&(FAV3p[id]->adr_mb), addrMB);
     }
-  FAV3UNLOCK;
+
+  /* Registers are back to their defaults */
+  if(faV3ShadowEnabled[id])
+    faV3ShadowLoad(id);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3215,15 +4227,19 @@ faV3GReset(int iFlag)
       for(ifa = 0; ifa < nfaV3; ifa++)
 	{
 	  id = faV3Slot(ifa);
+	  FAV3SLOTLOCK(id);
 	  a32addr[id] = vmeRead32(&(FAV3p[id]->adr32));
 	  addrMB[id] = vmeRead32(&(FAV3p[id]->adr_mb));
+	  FAV3SLOTUNLOCK(id);
 	}
     }
 
   for(ifa = 0; ifa < nfaV3; ifa++)
     {
       id = faV3Slot(ifa);
+      FAV3SLOTLOCK(id);
       vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_HARD_RESET);
+      FAV3SLOTUNLOCK(id);
     }
 
   taskDelay(10);
@@ -3233,11 +4249,23 @@ faV3GReset(int iFlag)
       for(ifa = 0; ifa < nfaV3; ifa++)
 	{
 	  id = faV3Slot(ifa);
+	  FAV3SLOTLOCK(id);
 	  vmeWrite32(&(FAV3p[id]->adr32), a32addr[id]);
 	  vmeWrite32(&(FAV3p[id]->adr_mb), addrMB[id]);
+	  FAV3SLOTUNLOCK(id);
 	}
     }
 
+  /* Registers are back to their defaults */
+  for(ifa = 0; ifa < nfaV3; ifa++)
+    {
+      id = faV3Slot(ifa);
+      FAV3SLOTLOCK(id);
+      if(faV3ShadowEnabled[id])
+	faV3ShadowLoad(id);
+      FAV3SLOTUNLOCK(id);
+    }
+
   FAV3UNLOCK;
 
 }
@@ -3256,12 +4284,12 @@ faV3SoftReset(int id, int cflag)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(cflag)			/* perform soft clear */
     vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_SOFT_CLEAR);
   else				/* normal soft reset */
     vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_SOFT_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3282,9 +4310,9 @@ faV3ResetToken(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->reset), FAV3_RESET_TOKEN);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3304,9 +4332,9 @@ faV3TokenStatus(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->csr) & FAV3_CSR_TOKEN_STATUS) >> 4;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -3380,10 +4408,10 @@ faV3SetChanDisableMask(int id, uint16_t cmask)
 
   faV3ChanDisableMask[id] = cmask;	/* Set Global Variable */
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Write New Disable Mask */
   vmeWrite16(&(FAV3p[id]->adc.config2), cmask);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3403,11 +4431,11 @@ faV3GetChanDisableMask(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   tmp = vmeRead16(&(FAV3p[id]->adc.config2)) & 0xFFFF;
   cmask = (tmp & FAV3_ADC_CHAN_MASK);
   faV3ChanDisableMask[id] = cmask;	/* Set Global Variable */
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
 
   return (cmask);
@@ -3422,9 +4450,9 @@ faV3SetCompression(int id, int opt)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  ctrl2 = (vmeRead32(&(FAV3p[id]->ctrl2))) & FAV3_CONTROL2_MASK;
+  ctrl2 = (faV3RegRead32(id, &(FAV3p[id]->ctrl2))) & FAV3_CONTROL2_MASK;
 #ifdef DEBUG_COMPRESSION
   printf("faV3SetCompression: read ctrl2=0x%08x\n", ctrl2);
 #endif /* DEBUG_COMPRESSION */
@@ -3454,9 +4482,9 @@ faV3SetCompression(int id, int opt)
 #ifdef DEBUG_COMPRESSION
   printf("faV3SetCompression: writing ctrl2=0x%08x\n", ctrl2);
 #endif /* DEBUG_COMPRESSION */
-  vmeWrite32(&(FAV3p[id]->ctrl2), ctrl2);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl2), ctrl2);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3470,7 +4498,7 @@ faV3GetCompression(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   ctrl2 = (vmeRead32(&(FAV3p[id]->ctrl2))) & FAV3_CONTROL2_MASK;
 #ifdef DEBUG_COMPRESSION
@@ -3491,7 +4519,7 @@ faV3GetCompression(int id)
   else
     opt = -2;
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (opt);
 }
@@ -3504,9 +4532,9 @@ faV3SetVXSReadout(int id, int opt)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  ctrl2 = vmeRead32(&FAV3p[id]->ctrl2);
+  ctrl2 = faV3RegRead32(id, &FAV3p[id]->ctrl2);
 
   if(opt == 0)
     {
@@ -3517,9 +4545,9 @@ faV3SetVXSReadout(int id, int opt)
       ctrl2 = ctrl2 | FAV3_CTRL_VXS_RO_ENABLE;
     }
 
-  vmeWrite32(&(FAV3p[id]->ctrl2), ctrl2);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl2), ctrl2);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return OK;
 }
 
@@ -3544,7 +4572,7 @@ faV3GetVXSReadout(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   ctrl2 = vmeRead32(&FAV3p[id]->ctrl2) & FAV3_CTRL_VXS_RO_ENABLE;
 
@@ -3553,7 +4581,7 @@ faV3GetVXSReadout(int id)
   else
     opt = 0;
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (opt);
 }
@@ -3571,10 +4599,10 @@ faV3EnableSyncSrc(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  ctrl2 = vmeRead32(&FAV3p[id]->ctrl2) | FAV3_CTRL_ENABLE_SRESET;
-  vmeWrite32(&FAV3p[id]->ctrl2, ctrl2);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  ctrl2 = faV3RegRead32(id, &FAV3p[id]->ctrl2) | FAV3_CTRL_ENABLE_SRESET;
+  faV3RegWrite32(id, &FAV3p[id]->ctrl2, ctrl2);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3608,11 +4636,11 @@ faV3Enable(int id, int eflag)
 
   CHECKID;
 
-  /* call it BEFORE 'FAV3LOCK' !!! */
+  /* call it BEFORE 'FAV3SLOTLOCK(id)' !!! */
   compress_opt = faV3GetCompression(id);
   vxsro_opt = faV3GetVXSReadout(id);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   ctrl2 = FAV3_CTRL_GO | FAV3_CTRL_ENABLE_TRIG | FAV3_CTRL_ENABLE_SRESET;
 
@@ -3635,9 +4663,9 @@ faV3Enable(int id, int eflag)
       ctrl2 = ctrl2 | FAV3_CTRL_VXS_RO_ENABLE;
     }
 
-  vmeWrite32(&(FAV3p[id]->ctrl2), ctrl2);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl2), ctrl2);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3677,12 +4705,12 @@ faV3Disable(int id, int eflag)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(eflag)
-    vmeWrite32(&(FAV3p[id]->ctrl2), 0);	/* Turn FIFO Transfer off as well */
+    faV3RegWrite32(id, &(FAV3p[id]->ctrl2), 0);	/* Turn FIFO Transfer off as well */
   else
-    vmeWrite32(&(FAV3p[id]->ctrl2), (FAV3_CTRL_GO | FAV3_CTRL_ENABLE_SRESET));	/* Keep SYNC RESET detection enabled */
-  FAV3UNLOCK;
+    faV3RegWrite32(id, &(FAV3p[id]->ctrl2), (FAV3_CTRL_GO | FAV3_CTRL_ENABLE_SRESET));	/* Keep SYNC RESET detection enabled */
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3719,14 +4747,14 @@ faV3Trig(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   if(vmeRead32(&(FAV3p[id]->ctrl1)) & (FAV3_ENABLE_SOFT_TRIG))
     vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_TRIGGER);
   else
     logMsg("faV3Trig: ERROR: Software Triggers not enabled", 0, 0, 0, 0, 0, 0);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3756,12 +4784,12 @@ faV3Trig2(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(vmeRead32(&(FAV3p[id]->ctrl1)) & (FAV3_ENABLE_SOFT_TRIG))
     vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_SOFT_PULSE_TRIG2);
   else
     logMsg("faV3Trig2: ERROR: Software Triggers not enabled", 0, 0, 0, 0, 0, 0);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3800,9 +4828,9 @@ faV3SetTrig21Delay(int id, int delay)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->trig21_del, delay);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3820,9 +4848,9 @@ faV3GetTrig21Delay(int id)
   int rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->trig21_del) & FAV3_TRIG21_DELAY_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -3840,11 +4868,11 @@ faV3EnableInternalPlaybackTrigger(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&FAV3p[id]->ctrl1,
-	     (vmeRead32(&FAV3p[id]->ctrl1) & ~FAV3_TRIG_MASK) |
-	     FAV3_TRIG_VME_PLAYBACK);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &FAV3p[id]->ctrl1,
+		 (faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~FAV3_TRIG_MASK) |
+		 FAV3_TRIG_VME_PLAYBACK);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3861,13 +4889,13 @@ faV3Sync(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(vmeRead32(&(FAV3p[id]->ctrl1)) & (FAV3_ENABLE_SOFT_SRESET))
     vmeWrite32(&(FAV3p[id]->csr), FAV3_CSR_SYNC);
   else
     logMsg("faV3Sync: ERROR: Software Sync Resets not enabled\n", 0, 0, 0, 0, 0,
 	   0);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3890,12 +4918,12 @@ faV3Dready(int id, int dflag)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(dflag)
     dcnt = vmeRead32(&(FAV3p[id]->blk_count)) & FAV3_BLOCK_COUNT_MASK;
   else
     dcnt = vmeRead32(&(FAV3p[id]->ev_count)) & FAV3_EVENT_COUNT_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
 
   return (dcnt);
@@ -3915,9 +4943,9 @@ faV3Bready(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   stat = (vmeRead32(&(FAV3p[id]->csr))) & FAV3_CSR_BLOCK_READY;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(stat)
     return (1);
@@ -3937,17 +4965,17 @@ faV3GBready()
   int ii, id, stat = 0;
   uint32_t dmask = 0;
 
-  FAV3LOCK;
   for(ii = 0; ii < nfaV3; ii++)
     {
       id = faV3ID[ii];
 
+      FAV3SLOTLOCK(id);
       stat = vmeRead32(&(FAV3p[id]->csr)) & FAV3_CSR_BLOCK_READY;
+      FAV3SLOTUNLOCK(id);
 
       if(stat)
 	dmask |= (1 << id);
     }
-  FAV3UNLOCK;
 
   return (dmask);
 }
@@ -3966,7 +4994,6 @@ faV3GBlockReady(uint32_t slotmask, int nloop)
   int iloop, islot, stat = 0;
   uint32_t dmask = 0;
 
-  FAV3LOCK;
   for(iloop = 0; iloop < nloop; iloop++)
     {
 
@@ -3979,26 +5006,324 @@ faV3GBlockReady(uint32_t slotmask, int nloop)
 	      if(!(dmask & (1 << islot)))
 		{		/* No block ready yet. */
 
+		  FAV3SLOTLOCK(islot);
 		  stat = vmeRead32(&FAV3p[islot]->csr) & FAV3_CSR_BLOCK_READY;
+		  FAV3SLOTUNLOCK(islot);
 
 		  if(stat)
 		    dmask |= (1 << islot);
 
 		  if(dmask == slotmask)
 		    {		/* Blockready mask matches user slotmask */
-		      FAV3UNLOCK;
 		      return (dmask);
 		    }
 		}
 	    }
 	}
     }
-  FAV3UNLOCK;
 
   return (dmask);
 
 }
 
+/* Handler connected to the VME interrupt.  Counts the interrupt, calls the
+   user routine and wakes anybody sleeping in faV3BlockReadyWait */
+LOCAL void
+faV3Int(int arg)
+{
+  faV3IntCount++;
+
+  if(faV3IntRoutine != NULL)
+    (*faV3IntRoutine) (faV3IntArg);
+
+#ifndef VXWORKS
+  if(faV3IntFd >= 0)
+    {
+      uint64_t one = 1;
+      if(write(faV3IntFd, &one, sizeof(one)) < 0)
+	perror("faV3Int: write");
+    }
+#endif
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Connect a routine to the block-ready interrupt
+ *
+ *    The library handler is connected to the VME interrupt.  It calls the
+ *    user routine (if any) and signals the descriptor returned by
+ *    faV3BlockReadyFd.  Interrupts are generated once faV3IntEnable is
+ *    called for the module.
+ *
+ *  @param vector VME Interrupt Vector (0 for default)
+ *  @param level VME Interrupt Level (0 for default)
+ *  @param routine User routine to call from the handler (may be NULL)
+ *  @param arg Argument to pass to the user routine
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3IntConnect(uint32_t vector, uint32_t level, FAV3INTFUNCPTR routine, int arg)
+{
+  int rval = 0;
+
+  if(faV3IntRunning)
+    {
+      printf("%s: ERROR: Interrupts are enabled. Disable before connecting\n",
+	     __func__);
+      return ERROR;
+    }
+
+  if(vector)
+    faV3IntVec = vector & FAV3_INT_VEC_MASK;
+  if(level)
+    faV3IntLevel = level & 0x7;
+
+  faV3IntRoutine = routine;
+  faV3IntArg = arg;
+  faV3IntCount = 0;
+
+#ifdef VXWORKS
+  intDisconnect(faV3IntVec);
+  rval = intConnect(INUM_TO_IVEC(faV3IntVec), faV3Int, arg);
+  if(rval == OK)
+    rval = sysIntEnable(faV3IntLevel);
+#else
+  if(faV3IntFd < 0)
+    {
+      faV3IntFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if(faV3IntFd < 0)
+	{
+	  perror("faV3IntConnect: eventfd");
+	  return ERROR;
+	}
+    }
+
+  rval = vmeIntConnect(faV3IntVec, faV3IntLevel, faV3Int, arg);
+#endif
+
+  if(rval != OK)
+    {
+      printf("%s: ERROR: Failed to connect vector 0x%x level %d\n",
+	     __func__, faV3IntVec, faV3IntLevel);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Disconnect the block-ready interrupt handler
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3IntDisconnect()
+{
+  int rval = OK;
+
+  if(faV3IntRunning && (faV3IntID > 0))
+    faV3IntDisable(faV3IntID);
+
+#ifdef VXWORKS
+  sysIntDisable(faV3IntLevel);
+  rval = intDisconnect(faV3IntVec);
+#else
+  rval = vmeIntDisconnect(faV3IntLevel);
+
+  if(faV3IntFd >= 0)
+    {
+      close(faV3IntFd);
+      faV3IntFd = -1;
+    }
+#endif
+
+  faV3IntRoutine = NULL;
+  faV3IntArg = 0;
+
+  return rval;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Enable the block-ready interrupt for the module
+ *
+ *    In multiblock readout, this is normally the last board in the chain.
+ *
+ *  @param id Slot number
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3IntEnable(int id)
+{
+  CHECKID;
+
+  FAV3SLOTLOCK(id);
+  vmeWrite32(&(FAV3p[id]->intr),
+	     ((faV3IntLevel << 8) & FAV3_INT_LEVEL_MASK) |
+	     (faV3IntVec & FAV3_INT_VEC_MASK));
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BLKLVL_INT);
+  FAV3SLOTUNLOCK(id);
+
+  faV3IntID = id;
+  faV3IntRunning = TRUE;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Disable the block-ready interrupt for the module
+ *  @param id Slot number
+ *  @return OK if successful, otherwise ERROR.
+ */
+
+int
+faV3IntDisable(int id)
+{
+  CHECKID;
+
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BLKLVL_INT);
+  FAV3SLOTUNLOCK(id);
+
+  if(id == faV3IntID)
+    faV3IntRunning = FALSE;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Return the file descriptor signalled on each block-ready interrupt
+ *
+ *    The descriptor is an eventfd that becomes readable after an interrupt.
+ *    It may be added to a caller's own poll/epoll set.
+ *
+ *  @return File descriptor, or -1 if interrupts are not connected.
+ */
+
+int
+faV3BlockReadyFd()
+{
+#ifdef VXWORKS
+  return -1;
+#else
+  return faV3IntFd;
+#endif
+}
+
+LOCAL int64_t
+faV3ElapsedUs(struct timespec *t0)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((int64_t) (now.tv_sec - t0->tv_sec) * 1000000 +
+	  (now.tv_nsec - t0->tv_nsec) / 1000);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Wait for block ready from the fADCs indicated in supplied slotmask
+ *
+ *    The csr of each module is polled for a short, adaptive, spin period.
+ *    After that the caller sleeps: on the interrupt descriptor if
+ *    interrupts are connected and enabled, otherwise with an exponential
+ *    backoff of up to FAV3_WAIT_SLEEP_MAX_US.  The spin period follows the
+ *    observed wait times, so high-rate runs stay in the spin phase and
+ *    low-rate runs go to sleep straight away.  No lock is held while
+ *    sleeping.
+ *
+ *  @param slotmask Slotmask of fADCs to wait for
+ *  @param timeout_us Timeout in microseconds.  0 checks once, <0 waits forever.
+ *  @return block ready mask.  Equal to slotmask unless the timeout expired.
+ */
+
+uint32_t
+faV3BlockReadyWait(uint32_t slotmask, int timeout_us)
+{
+  struct timespec t0;
+  int64_t elapsed = 0, remaining = 0, spin_us = 0, sleep_us = 1;
+  uint32_t dmask = 0;
+  int target = 0;
+#ifndef VXWORKS
+  struct pollfd pfd;
+  uint64_t count;
+  int poll_ms;
+#endif
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  spin_us = faV3WaitSpinUs;
+
+  while(1)
+    {
+      dmask = faV3GBlockReady(slotmask, 1);
+      if(dmask == slotmask)
+	break;
+
+      elapsed = faV3ElapsedUs(&t0);
+      if((timeout_us >= 0) && (elapsed >= timeout_us))
+	break;
+
+      /* Spin phase */
+      if(elapsed < spin_us)
+	continue;
+
+      /* Sleep phase */
+      remaining = (timeout_us < 0) ? FAV3_WAIT_POLL_MAX_US
+	: (timeout_us - elapsed);
+      if(remaining > FAV3_WAIT_POLL_MAX_US)
+	remaining = FAV3_WAIT_POLL_MAX_US;
+
+#ifndef VXWORKS
+      if((faV3IntFd >= 0) && faV3IntRunning)
+	{
+	  /* Re-check the csr at least every FAV3_WAIT_POLL_MAX_US, in case
+	     the interrupt was raised before we got here */
+	  pfd.fd = faV3IntFd;
+	  pfd.events = POLLIN;
+	  pfd.revents = 0;
+	  poll_ms = (int) ((remaining + 999) / 1000);
+
+	  if(poll(&pfd, 1, poll_ms) > 0)
+	    {
+	      if(read(faV3IntFd, &count, sizeof(count)) < 0)
+		perror("faV3BlockReadyWait: read");
+	    }
+	  continue;
+	}
+
+      if(sleep_us > remaining)
+	sleep_us = remaining;
+      usleep((useconds_t) sleep_us);
+#else
+      taskDelay(1);
+#endif
+
+      sleep_us <<= 1;
+      if(sleep_us > FAV3_WAIT_SLEEP_MAX_US)
+	sleep_us = FAV3_WAIT_SLEEP_MAX_US;
+    }
+
+  /* Adapt the spin budget: spin a bit past the typical short wait, and
+     not at all when waits are long */
+  if(dmask == slotmask)
+    {
+      target = (elapsed <= FAV3_WAIT_SPIN_MAX_US) ? (int) (2 * elapsed) : 0;
+      if(target > FAV3_WAIT_SPIN_MAX_US)
+	target = FAV3_WAIT_SPIN_MAX_US;
+      faV3WaitSpinUs = (3 * faV3WaitSpinUs + target) / 4;
+    }
+
+  return (dmask);
+}
+
 /**
  *  @ingroup Status
  *  @brief Return the vme slot mask of all initialized fADC250s
@@ -4043,7 +5368,7 @@ faV3BusyLevel(int id, uint32_t val, int bflag)
     return (ERROR);
 
   /* if Val > 0 then set the Level else leave it alone */
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(val)
     {
       if(bflag)
@@ -4057,7 +5382,7 @@ faV3BusyLevel(int id, uint32_t val, int bflag)
       if(bflag)
 	vmeWrite32(&(FAV3p[id]->busy_level), (blreg | FAV3_FORCE_BUSY));
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return ((blreg & FAV3_BUSY_LEVEL_MASK));
 }
@@ -4077,10 +5402,10 @@ faV3Busy(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   blreg = vmeRead32(&(FAV3p[id]->busy_level)) & FAV3_BUSY_LEVEL_MASK;
   dreg = vmeRead32(&(FAV3p[id]->ram_word_count)) & FAV3_RAM_DATA_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(dreg >= blreg)
     return (1);
@@ -4100,13 +5425,13 @@ faV3EnableSoftTrig(int id)
   CHECKID;
 
   /* Clear the source */
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_TRIG_MASK);
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_TRIG_MASK);
   /* Set Source and Enable */
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) | (FAV3_TRIG_VME |
-					       FAV3_ENABLE_SOFT_TRIG));
-  FAV3UNLOCK;
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | (FAV3_TRIG_VME |
+							   FAV3_ENABLE_SOFT_TRIG));
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4141,10 +5466,10 @@ faV3DisableSoftTrig(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_SOFT_TRIG);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_SOFT_TRIG);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4162,14 +5487,14 @@ faV3EnableSoftSync(int id)
   CHECKID;
 
   /* Clear the source */
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_SRESET_MASK);
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_SRESET_MASK);
   /* Set Source and Enable */
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) | (FAV3_SRESET_VME |
-					       FAV3_ENABLE_SOFT_SRESET));
-  FAV3UNLOCK;
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | (FAV3_SRESET_VME |
+							   FAV3_ENABLE_SOFT_SRESET));
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4185,10 +5510,10 @@ faV3DisableSoftSync(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_SOFT_SRESET);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_SOFT_SRESET);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4205,11 +5530,11 @@ faV3EnableClk(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) | (FAV3_REF_CLK_INTERNAL |
-					       FAV3_ENABLE_INTERNAL_CLK));
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | (FAV3_REF_CLK_INTERNAL |
+							   FAV3_ENABLE_INTERNAL_CLK));
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4225,10 +5550,10 @@ faV3DisableClk(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_INTERNAL_CLK);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_INTERNAL_CLK);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4271,9 +5596,9 @@ faV3EnableTriggerOut(int id, int output)
       break;
     }
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) | bitset);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | bitset);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4290,10 +5615,10 @@ faV3EnableBusError(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_ENABLE_BERR);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4308,13 +5633,13 @@ faV3GEnableBusError()
 {
   int ii;
 
-  FAV3LOCK;
   for(ii = 0; ii < nfaV3; ii++)
     {
-      vmeWrite32(&(FAV3p[faV3ID[ii]]->ctrl1),
-		 vmeRead32(&(FAV3p[faV3ID[ii]]->ctrl1)) | FAV3_ENABLE_BERR);
+      FAV3SLOTLOCK(faV3ID[ii]);
+      faV3RegWrite32(faV3ID[ii], &(FAV3p[faV3ID[ii]]->ctrl1),
+		     faV3RegRead32(faV3ID[ii], &(FAV3p[faV3ID[ii]]->ctrl1)) | FAV3_ENABLE_BERR);
+      FAV3SLOTUNLOCK(faV3ID[ii]);
     }
-  FAV3UNLOCK;
 
 }
 
@@ -4330,10 +5655,10 @@ faV3DisableBusError(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_ENABLE_BERR);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4365,29 +5690,31 @@ faV3EnableMultiBlock(int tflag)
   else
     mode = (FAV3_ENABLE_MULTIBLOCK | FAV3_MB_TOKEN_VIA_P2);
 
+  FAV3LOCK;
   for(ii = 0; ii < nfaV3; ii++)
     {
       id = faV3ID[ii];
-      FAV3LOCK;
-      vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) | mode);
-      FAV3UNLOCK;
+      FAV3SLOTLOCK(id);
+      faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | mode);
+      FAV3SLOTUNLOCK(id);
       faV3DisableBusError(id);
       if(id == faV3MinSlot)
 	{
-	  FAV3LOCK;
-	  vmeWrite32(&(FAV3p[id]->ctrl1),
-		     vmeRead32(&(FAV3p[id]->ctrl1)) | FAV3_FIRST_BOARD);
-	  FAV3UNLOCK;
+	  FAV3SLOTLOCK(id);
+	  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+			 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_FIRST_BOARD);
+	  FAV3SLOTUNLOCK(id);
 	}
       if(id == faV3MaxSlot)
 	{
-	  FAV3LOCK;
-	  vmeWrite32(&(FAV3p[id]->ctrl1),
-		     vmeRead32(&(FAV3p[id]->ctrl1)) | FAV3_LAST_BOARD);
-	  FAV3UNLOCK;
+	  FAV3SLOTLOCK(id);
+	  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+			 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | FAV3_LAST_BOARD);
+	  FAV3SLOTUNLOCK(id);
 	  faV3EnableBusError(id);	/* Enable Bus Error only on Last Board */
 	}
     }
+  FAV3UNLOCK;
 
   return OK;
 }
@@ -4411,8 +5738,12 @@ faV3DisableMultiBlock()
 
   FAV3LOCK;
   for(ii = 0; ii < nfaV3; ii++)
-    vmeWrite32(&(FAV3p[faV3ID[ii]]->ctrl1),
-	       vmeRead32(&(FAV3p[faV3ID[ii]]->ctrl1)) & ~FAV3_ENABLE_MULTIBLOCK);
+    {
+      FAV3SLOTLOCK(faV3ID[ii]);
+      faV3RegWrite32(faV3ID[ii], &(FAV3p[faV3ID[ii]]->ctrl1),
+		     faV3RegRead32(faV3ID[ii], &(FAV3p[faV3ID[ii]]->ctrl1)) & ~FAV3_ENABLE_MULTIBLOCK);
+      FAV3SLOTUNLOCK(faV3ID[ii]);
+    }
   FAV3UNLOCK;
 
   return OK;
@@ -4439,10 +5770,10 @@ faV3SetBlockLevel(int id, int level)
   logMsg("faV3SetBlockLevel: INFO: Set ADC slot %d block level to %d \n", id,
 	 level, 0, 0, 0, 0);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->blocklevel), level);
   rval = vmeRead32(&(FAV3p[id]->blocklevel)) & FAV3_BLOCK_LEVEL_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -4460,10 +5791,12 @@ faV3GSetBlockLevel(int level)
 
   if(level <= 0)
     level = 1;
-  FAV3LOCK;
   for(ii = 0; ii < nfaV3; ii++)
-    vmeWrite32(&(FAV3p[faV3ID[ii]]->blocklevel), level);
-  FAV3UNLOCK;
+    {
+      FAV3SLOTLOCK(faV3ID[ii]);
+      vmeWrite32(&(FAV3p[faV3ID[ii]]->blocklevel), level);
+      FAV3SLOTUNLOCK(faV3ID[ii]);
+    }
 
 }
 
@@ -4485,14 +5818,14 @@ faV3SetClkSource(int id, int source)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_REF_CLK_SEL_MASK);
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_REF_CLK_SEL_MASK);
   if((source < 0) || (source > 7))
     source = FAV3_REF_CLK_INTERNAL;
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) | source);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | source);
   rval = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_REF_CLK_SEL_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
 
   return (rval);
@@ -4520,14 +5853,14 @@ faV3SetTrigSource(int id, int source)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_TRIG_SEL_MASK);
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_TRIG_SEL_MASK);
   if((source < 0) || (source > 7))
     source = FAV3_TRIG_FP_ISYNC;
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) | source);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | source);
   rval = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_TRIG_SEL_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 
@@ -4556,14 +5889,14 @@ faV3SetSyncSource(int id, int source)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_SRESET_SEL_MASK);
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_SRESET_SEL_MASK);
   if((source < 0) || (source > 7))
     source = FAV3_SRESET_FP_ISYNC;
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&(FAV3p[id]->ctrl1)) | source);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | source);
   rval = vmeRead32(&(FAV3p[id]->ctrl1)) & FAV3_SRESET_SEL_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 
@@ -4583,15 +5916,15 @@ faV3EnableFP(int id)
 
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) &
-	     ~(FAV3_TRIG_SEL_MASK | FAV3_SRESET_SEL_MASK | FAV3_ENABLE_SOFT_SRESET |
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) &
+		 ~(FAV3_TRIG_SEL_MASK | FAV3_SRESET_SEL_MASK | FAV3_ENABLE_SOFT_SRESET |
 	       FAV3_ENABLE_SOFT_TRIG));
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     vmeRead32(&(FAV3p[id]->ctrl1)) | (FAV3_TRIG_FP_ISYNC |
-					       FAV3_SRESET_FP_ISYNC));
-  FAV3UNLOCK;
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 faV3RegRead32(id, &(FAV3p[id]->ctrl1)) | (FAV3_TRIG_FP_ISYNC |
+							   FAV3_SRESET_FP_ISYNC));
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4620,11 +5953,11 @@ faV3SetTrigOut(int id, int trigout)
       return ERROR;
     }
 
-  FAV3LOCK;
-  vmeWrite32(&(FAV3p[id]->ctrl1),
-	     (vmeRead32(&(FAV3p[id]->ctrl1)) & ~FAV3_TRIGOUT_MASK) |
-	     trigout << 12);
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1),
+		 (faV3RegRead32(id, &(FAV3p[id]->ctrl1)) & ~FAV3_TRIGOUT_MASK) |
+		 trigout << 12);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -4661,31 +5994,38 @@ faV3ResetTriggerCount(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->trig_scal, FAV3_TRIG_SCAL_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
 
 /**
  *  @ingroup Config
- *  @brief Set the readout threshold value for specified channel mask
+ *  @brief Set the readout threshold value for specified channel
+ *
+ *    Only the threshold value bits are changed.  The ignore, invert and
+ *    accumulator scaler mode bits of the register are kept.
+ *
  *  @param id Slot number
+ *  @param chan Channel number
  *  @param tvalue Threshold value
- *  @param chmask Mask of channels to set
  *  @return OK if successful, otherwise ERROR.
  */
 
 int
 faV3SetThreshold(int id, int chan, uint16_t tvalue)
 {
+  uint16_t thres;
   CHECKID;
 
-  FAV3LOCK;
-  vmeWrite16(&FAV3p[id]->adc.thres[chan], tvalue);
+  FAV3SLOTLOCK(id);
+  thres = faV3RegRead16(id, &FAV3p[id]->adc.thres[chan]) & ~FAV3_THR_VALUE_MASK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.thres[chan],
+		 thres | (tvalue & FAV3_THR_VALUE_MASK));
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -4697,9 +6037,9 @@ faV3GetThreshold(int id, int chan)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead16(&FAV3p[id]->adc.thres[chan]);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -4720,12 +6060,12 @@ faV3PrintThreshold(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii = 0; ii < FAV3_MAX_ADC_CHANNELS; ii++)
     {
       tval[ii] = vmeRead16(&FAV3p[id]->adc.thres[ii]);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   printf(" Threshold Settings for FAV3 in slot %d:", id);
   for(ii = 0; ii < FAV3_MAX_ADC_CHANNELS; ii++)
@@ -4750,12 +6090,12 @@ faV3DACInit(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->dac_csr, FAV3_DAC_INIT);
   taskDelay(1);		// wait
   csr_value = vmeRead32(&FAV3p[id]->dac_csr);	// read back value
   init_done = (csr_value & FAV3_DAC_INIT_DONE) >> 30;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(!init_done)
     {
@@ -4776,14 +6116,14 @@ faV3DACClear(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->dac_csr, FAV3_DAC_CLEAR);
   csr_value = vmeRead32(&FAV3p[id]->dac_csr);	// read back value
   ready = (csr_value & FAV3_DAC_READY) >> 16;
   success = (csr_value & FAV3_DAC_SUCCESS) >> 17;
   not_ready_since_clear = (csr_value & FAV3_DAC_NOT_READY) >> 18;
   timeout_since_clear = (csr_value & FAV3_DAC_TIMEOUT) >> 19;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(!ready || not_ready_since_clear || timeout_since_clear)
     {
@@ -4806,13 +6146,13 @@ faV3DACStatus(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   csr_value = vmeRead32(&FAV3p[id]->dac_csr);	// read back value
   ready = (csr_value & FAV3_DAC_READY >> 16);
   success = (csr_value & FAV3_DAC_SUCCESS) >> 17;
   not_ready_since_clear = (csr_value & FAV3_DAC_NOT_READY) >> 18;
   timeout_since_clear = (csr_value & FAV3_DAC_TIMEOUT) >> 19;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   printf("%s(id = %d): DAC_CSR: 0x%08x\n",
 	 __func__, id, csr_value);
@@ -4846,7 +6186,7 @@ faV3DACSet(int id, int chan, uint32_t dac_value)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->dac_csr, chan);
 
   vmeWrite32(&FAV3p[id]->dac_data, dac_value);
@@ -4854,7 +6194,7 @@ faV3DACSet(int id, int chan, uint32_t dac_value)
   ready = (csr_value & FAV3_DAC_READY) >> 16;
   success = (csr_value & FAV3_DAC_SUCCESS) >> 17;
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(!ready)
     {
@@ -4884,7 +6224,7 @@ faV3DACGet(int id, int chan, uint32_t *dac_value)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->dac_csr, chan);
 
   data_value = vmeRead32(&FAV3p[id]->dac_data);
@@ -4894,7 +6234,7 @@ faV3DACGet(int id, int chan, uint32_t *dac_value)
   csr_value = vmeRead32(&FAV3p[id]->dac_csr);	// read back value
   ready = (csr_value & FAV3_DAC_READY) >> 16;
   success = (csr_value & FAV3_DAC_SUCCESS) >> 17;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(!ready || !success)
     {
@@ -4975,9 +6315,9 @@ faV3SetPedestal(int id, int chan, uint32_t ped)
       return (ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.pedestal[chan], ped);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -5004,9 +6344,9 @@ faV3GetPedestal(int id, int chan)
       return (ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead16(&FAV3p[id]->adc.pedestal[chan]) & FAV3_ADC_PEDESTAL_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -5019,12 +6359,12 @@ faV3PrintPedestal(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii = 0; ii < FAV3_MAX_ADC_CHANNELS; ii++)
     {
       tval[ii] = vmeRead16(&(FAV3p[id]->adc.pedestal[ii]));
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
 
   printf(" Pedestal Settings for FADC in slot %d:", id);
@@ -5061,9 +6401,9 @@ faV3SetChannelDelay(int id, int chan, uint16_t delay)
       return(ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.trig_delay[chan], delay);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -5082,9 +6422,9 @@ faV3GetChannelDelay(int id, int chan)
       return(ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead16(&FAV3p[id]->adc.trig_delay[chan]) & FAV3_ADC_DELAY_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(rval);
 }
@@ -5098,18 +6438,18 @@ faV3SetInvertMask(int id, uint16_t chmask)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
-      thres = vmeRead16(&FAV3p[id]->adc.thres[ii]);
+      thres = faV3RegRead16(id, &FAV3p[id]->adc.thres[ii]);
       if((1 << ii) & chmask)
 	thres |= FAV3_THR_INVERT_MASK;
       else
 	thres &=~FAV3_THR_INVERT_MASK;
 
-      vmeWrite16(&FAV3p[id]->adc.thres[ii], thres);
+      faV3RegWrite16(id, &FAV3p[id]->adc.thres[ii], thres);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -5122,14 +6462,14 @@ faV3GetInvertMask(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
       tmp = vmeRead16(&FAV3p[id]->adc.thres[ii]);
       if(tmp & FAV3_THR_INVERT_MASK)
 	cmask |= (1<<ii);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(cmask);
 }
@@ -5148,16 +6488,16 @@ faV3SetTriggerProcessingMode(int id, int chan, int mode)
       return(ERROR);
     }
 
-  FAV3LOCK;
-  rval = vmeRead16(&FAV3p[id]->adc.trig_gain[chan]);
+  FAV3SLOTLOCK(id);
+  rval = faV3RegRead16(id, &FAV3p[id]->adc.trig_gain[chan]);
 
   if(mode)
     rval |= 0x8000;
   else
     rval &= 0x7FFF;
 
-  vmeWrite16(&FAV3p[id]->adc.trig_gain[chan], rval);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.trig_gain[chan], rval);
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -5176,13 +6516,13 @@ faV3GetTriggerProcessingMode(int id, int chan)
       return(ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead16(&FAV3p[id]->adc.trig_gain[chan]);
   if(rval & 0x8000)
     rval = 1;
   else
     rval = 0;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(rval);
 }
@@ -5211,11 +6551,11 @@ faV3SetChannelGain(int id, int chan, float gain)
 
   igain = (int)(gain*256.0);
 
-  FAV3LOCK;
-  rval = vmeRead16(&FAV3p[id]->adc.trig_gain[chan]) & 0x8000;
+  FAV3SLOTLOCK(id);
+  rval = faV3RegRead16(id, &FAV3p[id]->adc.trig_gain[chan]) & 0x8000;
   rval |= igain & 0x7FFF;
-  vmeWrite16(&FAV3p[id]->adc.trig_gain[chan], igain);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.trig_gain[chan], rval);
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -5234,9 +6574,9 @@ faV3GetChannelGain(int id, int chan)
       return(ERROR);
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead16(&FAV3p[id]->adc.trig_gain[chan]) & 0x7FFF;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return( ((float)rval)/256.0 );
 }
@@ -5276,7 +6616,7 @@ faV3ReadScalers(int id, volatile uint32_t * data, uint32_t chmask, int rflag)
   doLatch = rflag & (1 << 0);
   doClear = rflag & (1 << 1);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(doLatch)
     vmeWrite32(&FAV3p[id]->scaler_ctrl,
 	       FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_LATCH);
@@ -5294,9 +6634,15 @@ faV3ReadScalers(int id, volatile uint32_t * data, uint32_t chmask, int rflag)
   dCnt++;
 
   if(doClear)
-    vmeWrite32(&FAV3p[id]->scaler_ctrl,
-	       FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_RESET);
-  FAV3UNLOCK;
+    {
+      vmeWrite32(&FAV3p[id]->scaler_ctrl,
+		 FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_RESET);
+      faV3ScalerClearCount[id]++;
+    }
+  if(doLatch || doClear)
+    faV3ScalerLatchCount[id]++;
+  faV3ScalerLatchPending[id] = 0;
+  FAV3SLOTUNLOCK(id);
 
   return dCnt;
 
@@ -5333,7 +6679,7 @@ faV3PrintScalers(int id, int rflag)
   doLatch = rflag & (1 << 0);
   doClear = rflag & (1 << 1);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(doLatch)
     vmeWrite32(&FAV3p[id]->scaler_ctrl,
 	       FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_LATCH);
@@ -5346,9 +6692,14 @@ faV3PrintScalers(int id, int rflag)
   time_count = vmeRead32(&FAV3p[id]->scalers.time_count);
 
   if(doClear)
-    vmeWrite32(&FAV3p[id]->scaler_ctrl,
-	       FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_RESET);
-  FAV3UNLOCK;
+    {
+      vmeWrite32(&FAV3p[id]->scaler_ctrl,
+		 FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_RESET);
+      faV3ScalerClearCount[id]++;
+    }
+  if(doLatch || doClear)
+    faV3ScalerLatchCount[id]++;
+  FAV3SLOTUNLOCK(id);
 
   printf("%s: Scaler Counts\n", __func__);
   for(ichan = 0; ichan < 16; ichan++)
@@ -5376,10 +6727,13 @@ faV3ClearScalers(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->scaler_ctrl,
 	     FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_RESET);
-  FAV3UNLOCK;
+  faV3ScalerLatchCount[id]++;
+  faV3ScalerClearCount[id]++;
+  faV3ScalerLatchPending[id] = 0;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -5387,6 +6741,11 @@ faV3ClearScalers(int id)
 /**
  *  @ingroup Config
  *  @brief Latch the current scaler count
+ *
+ *   Until the latched counts are read with faV3ReadScalers, the scaler
+ *   monitor (faV3ScalerMon) reads them as they are instead of latching
+ *   again.
+ *
  *  @param id Slot number
  *  @return OK if successful, otherwise ERROR.
  */
@@ -5396,10 +6755,12 @@ faV3LatchScalers(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->scaler_ctrl,
 	     FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_LATCH);
-  FAV3UNLOCK;
+  faV3ScalerLatchCount[id]++;
+  faV3ScalerLatchPending[id] = 1;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -5415,9 +6776,9 @@ faV3EnableScalers(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->scaler_ctrl, FAV3_SCALER_CTRL_ENABLE);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -5434,9 +6795,9 @@ faV3DisableScalers(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->scaler_ctrl, ~FAV3_SCALER_CTRL_ENABLE);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -5509,7 +6870,7 @@ faV3GetMinA32MB(int id)
   uint32_t rval = 0, a32addr, addrMB;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   a32addr = vmeRead32(&(FAV3p[id]->adr32));
   addrMB = vmeRead32(&(FAV3p[id]->adr_mb));
@@ -5531,7 +6892,7 @@ faV3GetMinA32MB(int id)
   printf("faV3GetMinA32MB: rval=0x%08x\n", rval);
 #endif
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
 
   return rval;
@@ -5551,7 +6912,7 @@ faV3GetMaxA32MB(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   a32addr = vmeRead32(&(FAV3p[id]->adr32));
   addrMB = vmeRead32(&(FAV3p[id]->adr_mb));
@@ -5567,7 +6928,7 @@ faV3GetMaxA32MB(int id)
   printf("faV3GetMaxA32MB: rval=0x%08x\n", rval);
 #endif
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -5587,12 +6948,12 @@ faV3PrintFifoStatus(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   dflow = vmeRead32(&(FAV3p[id]->flow_status));
   ibuf = vmeRead32(&(FAV3p[id]->status1)) & 0xdfffdfff;
   bbuf = vmeRead32(&(FAV3p[id]->status2)) & 0x1fff1fff;
   obuf = vmeRead32(&(FAV3p[id]->status3)) & 0x3fff3fff;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   printf("%s: Fifo Buffers Status (DataFlow Status = 0x%08x\n",
 	 __func__, dflow);
@@ -5667,13 +7028,13 @@ faV3Live(int id, int sflag)
   CHECKID;
 
   /* Read Current Scaler values */
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (int)vmeRead32(&(FAV3p[id]->trig_live_count));
 
   /* Reset if requested */
   if(sflag)
     vmeWrite32(&(FAV3p[id]->trig_live_count), 0x80000000);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -5682,6 +7043,7 @@ faV3Live(int id, int sflag)
 /**
  *  @ingroup Status
  *  @brief Decode a data word from an fADC250 and print to standard out.
+ *         Not reentrant.  See faV3DecoderFeed for use in a readout thread.
  *  @param data 32bit fADC250 data word
  */
 
@@ -5992,12 +7354,12 @@ faV3TestSetSystemTestMode(int id, int mode)
   else
     reg = 0;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  vmeWrite32(&(FAV3p[id]->ctrl1), vmeRead32(&FAV3p[id]->ctrl1) | reg);
+  faV3RegWrite32(id, &(FAV3p[id]->ctrl1), faV3RegRead32(id, &FAV3p[id]->ctrl1) | reg);
 
   /*   printf(" ctrl1 = 0x%08x\n",vmeRead32(&FAV3p[id]->ctrl1)); */
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6026,9 +7388,9 @@ faV3TestSetTrigOut(int id, int mode)
   else
     reg = 0;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->system_test.testbit), reg);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6057,9 +7419,9 @@ faV3TestSetBusyOut(int id, int mode)
   else
     reg = 0;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->system_test.testbit), reg);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6088,9 +7450,9 @@ faV3TestSetSdLink(int id, int mode)
   else
     reg = 0;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->system_test.testbit), reg);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6119,9 +7481,9 @@ faV3TestSetTokenOut(int id, int mode)
   else
     reg = 0;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&(FAV3p[id]->system_test.testbit), reg);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6143,9 +7505,9 @@ faV3TestGetStatBitB(int id)
   int reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = (vmeRead32(&FAV3p[id]->system_test.testbit) & FAV3_TESTBIT_STATBITB) >> 8;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6168,9 +7530,9 @@ faV3TestGetTokenIn(int id)
   int reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = (vmeRead32(&FAV3p[id]->system_test.testbit) & FAV3_TESTBIT_TOKENIN) >> 9;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6193,9 +7555,9 @@ faV3TestGetClock250CounterStatus(int id)
   int reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = (vmeRead32(&FAV3p[id]->system_test.testbit) & FAV3_TESTBIT_CLOCK250_STATUS) >> 15;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6218,9 +7580,9 @@ faV3TestGetClock250Counter(int id)
   uint32_t reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = vmeRead32(&FAV3p[id]->system_test.count_250);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6243,9 +7605,9 @@ faV3TestGetSyncCounter(int id)
   uint32_t reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = vmeRead32(&FAV3p[id]->system_test.count_sync);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6268,9 +7630,9 @@ faV3TestGetTrig1Counter(int id)
   uint32_t reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = vmeRead32(&FAV3p[id]->system_test.count_trig1);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6293,9 +7655,9 @@ faV3TestGetTrig2Counter(int id)
   uint32_t reg = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   reg = vmeRead32(&FAV3p[id]->system_test.count_trig2);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return reg;
 
@@ -6316,10 +7678,10 @@ faV3TestResetClock250Counter(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->system_test.count_250, FAV3_CLOCK250COUNT_RESET);
   vmeWrite32(&FAV3p[id]->system_test.count_250, FAV3_CLOCK250COUNT_START);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6339,9 +7701,9 @@ faV3TestResetSyncCounter(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->system_test.count_sync, FAV3_SYNCP0COUNT_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6361,9 +7723,9 @@ faV3TestResetTrig1Counter(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->system_test.count_trig1, FAV3_TRIG1P0COUNT_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6383,9 +7745,9 @@ faV3TestResetTrig2Counter(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->system_test.count_trig2, FAV3_TRIG2P0COUNT_RESET);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6407,9 +7769,9 @@ faV3TestGetTestBitReg(int id)
   uint32_t rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->system_test.testbit);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -6500,10 +7862,10 @@ faV3GetSerialNumber(int id, char **rval)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(i = 0; i < 2; i++)
     sn[i] = vmeRead32(&FAV3p[id]->serial_reg[i]);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   strcpy(sn_str, "");
   for(ibyte = 3; ibyte >= 0; ibyte--)
@@ -6561,9 +7923,9 @@ faV3SetScalerBlockInterval(int id, uint32_t nblock)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->scaler_insert, nblock);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6582,9 +7944,9 @@ faV3GetScalerBlockInterval(int id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->scaler_insert) & FAV3_SCALER_INSERT_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -6612,10 +7974,10 @@ faV3ForceEndOfBlock(int id, int scalers)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Disable triggers to Processing FPGA (if enabled) */
-  proc_config = vmeRead16(&FAV3p[id]->adc.config1);
-  vmeWrite16(&FAV3p[id]->adc.config1, proc_config & ~(FAV3_ADC_PROC_ENABLE));
+  proc_config = faV3RegRead16(id, &FAV3p[id]->adc.config1);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, proc_config & ~(FAV3_ADC_PROC_ENABLE));
 
   csr = FAV3_CSR_FORCE_EOB_INSERT;
   if(scalers > 0)
@@ -6651,9 +8013,9 @@ faV3ForceEndOfBlock(int id, int scalers)
     }
 
   /* Restore the original state of the Processing FPGA */
-  vmeWrite16(&FAV3p[id]->adc.config1, proc_config);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, proc_config);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -6706,9 +8068,9 @@ faV3SetHistoryBufferThreshold(int id, int thres)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->sum_threshold,thres);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6742,9 +8104,9 @@ faV3GetHistoryBufferThreshold(int id)
   int rval=0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->sum_threshold) & FAV3_SUM_THRESHOLD_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -6760,9 +8122,9 @@ faV3ArmHistoryBuffer(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->sum_data, FAV3_SUM_DATA_ARM_HISTORY_BUFFER);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return OK;
 }
 
@@ -6793,9 +8155,9 @@ faV3HistoryBufferDReady(int id)
   int rval=0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->sum_threshold) & FAV3_SUM_THRESHOLD_DREADY)>>31;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -6814,7 +8176,7 @@ faV3ReadHistoryBuffer(int id, volatile unsigned int *data, int nwrds)
   int idata=0, dCnt=0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   while(idata<nwrds)
     {
       data[idata] = vmeRead32(&FAV3p[id]->sum_data) & FAV3_SUM_DATA_SAMPLE_MASK;
@@ -6828,7 +8190,7 @@ faV3ReadHistoryBuffer(int id, volatile unsigned int *data, int nwrds)
   /* Use this to clear the data ready bit (dont set back to zero) */
   vmeWrite32(&FAV3p[id]->sum_data,FAV3_SUM_DATA_ARM_HISTORY_BUFFER);
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   dCnt += idata;
 
   return dCnt;
@@ -6849,12 +8211,12 @@ faV3StateArmBuffer(int id, int enable)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(enable)
     vmeWrite32(&FAV3p[id]->aux.state_csr, FAV3_STATE_CSR_ARM_BUFFER);
   else
     vmeWrite32(&FAV3p[id]->aux.state_csr, 0);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -6873,7 +8235,7 @@ faV3StateReadBuffer(int id, volatile unsigned int *data, int nwords)
   int rval=0, idata=0, ndata=0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   /* Read in how many words are available */
   ndata = vmeRead32(&FAV3p[id]->aux.state_csr) & FAV3_STATE_CSR_BUFFER_WORDS_MASK;
 
@@ -6898,7 +8260,7 @@ faV3StateReadBuffer(int id, volatile unsigned int *data, int nwords)
       rval = ndata;
     }
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7177,9 +8539,9 @@ faV3SetSparsificationMode(int id, int mode)
   /* logic in register is reversed */
   mode = mode ? 0 : 1;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->aux.sparsify_control, mode);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -7202,12 +8564,12 @@ faV3GSetSparsificationMode(int mode)
   /* logic in register is reversed */
   mode = mode ? 0 : 1;
 
-  FAV3LOCK;
-
   for(id = 0; id < nfaV3; id++)
-    vmeWrite32(&FAV3p[id]->aux.sparsify_control, mode);
-
-  FAV3UNLOCK;
+    {
+      FAV3SLOTLOCK(id);
+      vmeWrite32(&FAV3p[id]->aux.sparsify_control, mode);
+      FAV3SLOTUNLOCK(id);
+    }
 }
 
 /**
@@ -7223,13 +8585,13 @@ faV3GetSparsificationMode(int id)
   int mode = 0, rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   mode =
     (int) (vmeRead32(&FAV3p[id]->aux.sparsify_control) & FAV3_SPARSE_CONTROL_BYPASS);
 
   /* logic in register is reversed */
   rval = mode ? 0 : 1;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -7240,9 +8602,9 @@ faV3GetSparsificationStatus(int id)
   int rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (int) (vmeRead32(&FAV3p[id]->aux.sparsify_status) & FAV3_SPARSE_STATUS_MASK);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7252,9 +8614,9 @@ faV3ClearSparsificationStatus(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite32(&FAV3p[id]->aux.sparsify_control, FAV3_SPARSE_STATUS_CLEAR);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -7264,11 +8626,12 @@ faV3GClearSparsificationStatus()
 {
   int id = 0;
 
-  FAV3LOCK;
   for(id = 0; id < nfaV3; id++)
-    vmeWrite32(&FAV3p[id]->aux.sparsify_control, FAV3_SPARSE_STATUS_CLEAR);
-
-  FAV3UNLOCK;
+    {
+      FAV3SLOTLOCK(id);
+      vmeWrite32(&FAV3p[id]->aux.sparsify_control, FAV3_SPARSE_STATUS_CLEAR);
+      FAV3SLOTUNLOCK(id);
+    }
 }
 
 
@@ -7290,7 +8653,7 @@ faV3PrintAuxScal(int id)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   printf("Auxillary Scalers:\n");
   printf("       Word Count:         %d\n",
 	 vmeRead32(&FAV3p[id]->proc_words_scal));
@@ -7299,7 +8662,7 @@ faV3PrintAuxScal(int id)
 	 vmeRead32(&FAV3p[id]->trailer_scal));
   printf("  Lost Triggers  :         %d\n",
 	 vmeRead32(&FAV3p[id]->lost_trig_scal));
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -7318,9 +8681,9 @@ faV3GetFirstTriggerMismatch(int id)
   uint32_t rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->aux.first_trigger_mismatch);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7339,9 +8702,9 @@ faV3GetMismatchTriggerCount(int id)
   uint32_t rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->aux.trigger_mismatch_counter);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7360,9 +8723,9 @@ faV3GetTriggersProcessedCount(int id)
   uint32_t rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = vmeRead32(&FAV3p[id]->aux.triggers_processed);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7416,13 +8779,13 @@ faV3LoadIdelay(int32_t id, int32_t pflag)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   DoneLdIdelay = (vmeRead32(&FAV3p[id]->aux.idelay_status_1) & DoneLdIdelayMask) ? 1 : 0;
   IdelayCtrlRdy = (vmeRead32(&FAV3p[id]->aux.idelay_status_2) & IdelayCtrlRdyMask) ? 1 : 0;
   if(DoneLdIdelay && IdelayCtrlRdy)
     {
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       if(pflag)
 	{
 	  printf("%s(%d): Idelay Already loaded\n", __func__, id);
@@ -7477,7 +8840,7 @@ faV3LoadIdelay(int32_t id, int32_t pflag)
 
   if(invalid_diff)
     {
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       printf("%s(%d): Invalid calculated IDelay values\n", __func__, id);
       int jj;
       // print arrays
@@ -7536,7 +8899,7 @@ faV3LoadIdelay(int32_t id, int32_t pflag)
 	break;
     }
   vmeWrite32(&FAV3p[id]->aux.idelay_control_1, 0);	// Enable VTC
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   if(DoneLdIdelayCntVal && IdelayCtrlRdy)
     rval = OK;
@@ -7626,7 +8989,7 @@ faV3IDelayPrint(int32_t id)
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
   DoneLdIdelay = (vmeRead32(&FAV3p[id]->aux.idelay_status_1) & DoneLdIdelayMask) ? 1 : 0;
   IdelayCtrlRdy = (vmeRead32(&FAV3p[id]->aux.idelay_status_2) & IdelayCtrlRdyMask) ? 1 : 0;
@@ -7669,7 +9032,7 @@ faV3IDelayPrint(int32_t id)
 
     }
 
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   int jj;
   // print arrays
@@ -7721,10 +9084,10 @@ faV3SampleConfig(int id, int nsamples, int maxvalue)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.config6,
 	     (nsamples - 1)<<10 | maxvalue);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -7770,14 +9133,14 @@ faV3ReadAllChannelSamples(int id, uint16_t data[16])
 
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
 
-  config1 = vmeRead16(&FAV3p[id]->adc.config1);
+  config1 = faV3RegRead16(id, &FAV3p[id]->adc.config1);
   // Set request bit
-  vmeWrite16(&FAV3p[id]->adc.config1, (config1 |  FAV3_ADC_CONFIG1_CHAN_READ_ENABLE) );
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, (config1 |  FAV3_ADC_CONFIG1_CHAN_READ_ENABLE) );
 
   // reset request bit
-  vmeWrite16(&FAV3p[id]->adc.config1, config1);
+  faV3RegWrite16(id, &FAV3p[id]->adc.config1, config1);
 
 
   status2 = vmeRead16(&FAV3p[id]->adc.status2);
@@ -7788,7 +9151,7 @@ faV3ReadAllChannelSamples(int id, uint16_t data[16])
     {
       printf("%s(id = %d): Timeout waiting for Channel Samples\n",
 	     __func__, id);
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
       return ERROR;
     }
 
@@ -7798,7 +9161,7 @@ faV3ReadAllChannelSamples(int id, uint16_t data[16])
       status2 = vmeRead16(&FAV3p[id]->adc.status2);
       data[ichan] = status2 & 0x7FFF;
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (FAV3_MAX_ADC_CHANNELS);
 }
@@ -7820,9 +9183,9 @@ faV3SetRoguePTWFallBack(int id, uint16_t enablemask)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.rogue_ptw_fall_back, enablemask);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (OK);
 }
@@ -7844,9 +9207,9 @@ faV3GetRoguePTWFallBack(int id, uint16_t *enablemask)
   int rval = OK;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   *enablemask = vmeRead16(&FAV3p[id]->adc.rogue_ptw_fall_back) & FAV3_ROGUE_PTW_FALL_BACK_MASK;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (rval);
 }
@@ -7867,12 +9230,12 @@ faV3DataInsertAdcParameters(int id, int enable)
 {
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(enable)
-    vmeWrite32(&FAV3p[id]->ctrl1, vmeRead32(&FAV3p[id]->ctrl1) | FAV3_ENABLE_ADC_PARAMETERS_DATA);
+    faV3RegWrite32(id, &FAV3p[id]->ctrl1, faV3RegRead32(id, &FAV3p[id]->ctrl1) | FAV3_ENABLE_ADC_PARAMETERS_DATA);
   else
-    vmeWrite32(&FAV3p[id]->ctrl1, vmeRead32(&FAV3p[id]->ctrl1) & ~FAV3_ENABLE_ADC_PARAMETERS_DATA);
-  FAV3UNLOCK;
+    faV3RegWrite32(id, &FAV3p[id]->ctrl1, faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~FAV3_ENABLE_ADC_PARAMETERS_DATA);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -7908,9 +9271,9 @@ faV3DataGetInsertAdcParameters(int id)
   int rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->ctrl1) & FAV3_ENABLE_ADC_PARAMETERS_DATA) ? 1 : 0;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -7951,12 +9314,12 @@ faV3DataSuppressTriggerTime(int id, int suppress)
       return ERROR;
     }
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   if(suppress)
-    vmeWrite32(&FAV3p[id]->ctrl1, vmeRead32(&FAV3p[id]->ctrl1) | suppress_bits);
+    faV3RegWrite32(id, &FAV3p[id]->ctrl1, faV3RegRead32(id, &FAV3p[id]->ctrl1) | suppress_bits);
   else
-    vmeWrite32(&FAV3p[id]->ctrl1, vmeRead32(&FAV3p[id]->ctrl1) & ~suppress_bits);
-  FAV3UNLOCK;
+    faV3RegWrite32(id, &FAV3p[id]->ctrl1, faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~suppress_bits);
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -7986,9 +9349,9 @@ faV3DataGetSuppressTriggerTime(int id)
   int rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->ctrl1) & FAV3_SUPPRESS_TRIGGER_TIME_MASK) >> 16;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -8015,10 +9378,10 @@ faV3SetDataFormat(int id, int format)
       return ERROR;
     }
 
-  FAV3LOCK;
-  vmeWrite32(&FAV3p[id]->ctrl1,
-	     (vmeRead32(&FAV3p[id]->ctrl1) & ~FAV3_CTRL1_DATAFORMAT_MASK) | (format << 26));
-  FAV3UNLOCK;
+  FAV3SLOTLOCK(id);
+  faV3RegWrite32(id, &FAV3p[id]->ctrl1,
+		 (faV3RegRead32(id, &FAV3p[id]->ctrl1) & ~FAV3_CTRL1_DATAFORMAT_MASK) | (format << 26));
+  FAV3SLOTUNLOCK(id);
 
   return OK;
 }
@@ -8046,9 +9409,9 @@ faV3GetDataFormat(int id)
   int32_t rval = 0;
   CHECKID;
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rval = (vmeRead32(&FAV3p[id]->ctrl1) & FAV3_CTRL1_DATAFORMAT_MASK) >> 26;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return rval;
 }
@@ -8059,9 +9422,9 @@ faV3SetHitbitTrigMask(int id, uint16_t chmask)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.live_trig_mask, chmask);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -8073,9 +9436,9 @@ faV3GetHitbitTrigMask(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rvalue = vmeRead16(&FAV3p[id]->adc.live_trig_mask) & 0xFFFF;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(rvalue);
 }
@@ -8087,11 +9450,11 @@ faV3SetHitbitMinTOT(int id, uint16_t width)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
-  val = vmeRead16(&FAV3p[id]->adc.hitbit_config);
+  FAV3SLOTLOCK(id);
+  val = faV3RegRead16(id, &FAV3p[id]->adc.hitbit_config);
   val = (val & 0xFFFFFF00) | (width & 0xFF);
-  vmeWrite16(&FAV3p[id]->adc.hitbit_config, val);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.hitbit_config, val);
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -8103,9 +9466,9 @@ faV3GetHitbitMinTOT(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   val = vmeRead16(&FAV3p[id]->adc.hitbit_config);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return (val & 0xFF);
 }
@@ -8129,11 +9492,11 @@ faV3SetHitbitMinMultiplicity(int id, uint16_t mult)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
-  val = vmeRead16(&FAV3p[id]->adc.hitbit_config);
+  FAV3SLOTLOCK(id);
+  val = faV3RegRead16(id, &FAV3p[id]->adc.hitbit_config);
   val = (val & 0xFFFFE0FF) | ((mult & 0x1F)<<8);
-  vmeWrite16(&FAV3p[id]->adc.hitbit_config, val);
-  FAV3UNLOCK;
+  faV3RegWrite16(id, &FAV3p[id]->adc.hitbit_config, val);
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -8145,9 +9508,9 @@ faV3GetHitbitMinMultiplicity(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   val = vmeRead16(&FAV3p[id]->adc.hitbit_config);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return((val >> 8) & 0x1F);
 }
@@ -8170,9 +9533,9 @@ faV3SetHitbitTrigWidth(int id, uint16_t width)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   vmeWrite16(&FAV3p[id]->adc.live_trig_width, width);
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -8184,9 +9547,9 @@ faV3GetHitbitTrigWidth(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   rvalue = vmeRead16(&FAV3p[id]->adc.live_trig_width) & 0xFFFF;
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(rvalue);
 }
@@ -8199,19 +9562,19 @@ faV3ThresholdIgnore(int id, uint16_t chmask)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
-      thres = vmeRead16(&FAV3p[id]->adc.thres[ii]);
+      thres = faV3RegRead16(id, &FAV3p[id]->adc.thres[ii]);
 
       if((1<<ii)&chmask)
 	thres |= FAV3_THR_IGNORE_MASK;
       else
 	thres &= ~FAV3_THR_IGNORE_MASK;
 
-      vmeWrite16(&FAV3p[id]->adc.thres[ii], thres);
+      faV3RegWrite16(id, &FAV3p[id]->adc.thres[ii], thres);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return(OK);
 }
 
@@ -8223,14 +9586,14 @@ faV3GetThresholdIgnoreMask(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
       tmp = vmeRead16(&FAV3p[id]->adc.thres[ii]);
       if(tmp & FAV3_THR_IGNORE_MASK)
 	cmask |= (1<<ii);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(cmask);
 }
@@ -8243,19 +9606,19 @@ faV3PlaybackDisable(int id, uint16_t chmask)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
-      thres = vmeRead16(&FAV3p[id]->adc.thres[ii]);
+      thres = faV3RegRead16(id, &FAV3p[id]->adc.thres[ii]);
 
       if((1<<ii)&chmask)
 	thres |= FAV3_PLAYBACK_DIS_MASK;
       else
 	thres &= ~FAV3_PLAYBACK_DIS_MASK;
 
-      vmeWrite16(&FAV3p[id]->adc.thres[ii], thres);
+      faV3RegWrite16(id, &FAV3p[id]->adc.thres[ii], thres);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
   return(OK);
 }
 
@@ -8267,14 +9630,14 @@ faV3GetPlaybackDisableMask(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
       tmp = vmeRead16(&FAV3p[id]->adc.thres[ii]);
       if(tmp & FAV3_PLAYBACK_DIS_MASK)
 	cmask |= (1<<ii);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(cmask);
 }
@@ -8297,19 +9660,19 @@ faV3SetAccumulatorScalerMode(int id, uint16_t chmask)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
-      thres = vmeRead16(&FAV3p[id]->adc.thres[ii]);
+      thres = faV3RegRead16(id, &FAV3p[id]->adc.thres[ii]);
 
       if((1<<ii)&chmask)
 	thres |= FAV3_THR_ACCUMULATOR_SCALER_MODE_MASK;
       else
 	thres &= ~FAV3_THR_ACCUMULATOR_SCALER_MODE_MASK;
 
-      vmeWrite16(&FAV3p[id]->adc.thres[ii], thres);
+      faV3RegWrite16(id, &FAV3p[id]->adc.thres[ii], thres);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -8322,14 +9685,14 @@ faV3GetAccumulatorScalerMode(int id)
   CHECKID;
   CHECK_PROC_SUPPORTED(FAV3_PROC_PRAD_FIRMWARE);
 
-  FAV3LOCK;
+  FAV3SLOTLOCK(id);
   for(ii=0;ii<FAV3_MAX_ADC_CHANNELS;ii++)
     {
       tmp = vmeRead16(&FAV3p[id]->adc.thres[ii]);
       if(tmp & FAV3_THR_ACCUMULATOR_SCALER_MODE_MASK)
 	cmask |= (1<<ii);
     }
-  FAV3UNLOCK;
+  FAV3SLOTUNLOCK(id);
 
   return(cmask);
 }
@@ -8360,7 +9723,7 @@ faV3MeasureChannelPedestal(int id, unsigned int chan, faV3Ped *ped)
 
   for(n = 0; n < FAV3_MEASURE_PED_NTIMES; n++)
     {
-      FAV3LOCK;
+      FAV3SLOTLOCK(id);
       vmeWrite16(&FAV3p[id]->adc.la_ctrl_reg, 0);       /* disable logic analyzer */
       for(i=0;i<16;i++)
 	{
@@ -8368,14 +9731,14 @@ faV3MeasureChannelPedestal(int id, unsigned int chan, faV3Ped *ped)
 	  vmeWrite16(&FAV3p[id]->adc.cmp_thr[i], 0);	/* setup a don't care trigger */
 	}
       vmeWrite16(&FAV3p[id]->adc.la_ctrl_reg, 1); /* enable logic analyzer */
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
 
       taskDelay(1);
 
-      FAV3LOCK;
+      FAV3SLOTLOCK(id);
       status = vmeRead16(&FAV3p[id]->adc.la_rdyStatus);
       vmeWrite16(&FAV3p[id]->adc.la_ctrl_reg, 0);       /* disable logic analyzer */
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
 
       if(!status)
 	{
@@ -8383,7 +9746,7 @@ faV3MeasureChannelPedestal(int id, unsigned int chan, faV3Ped *ped)
 	  return(ERROR);
 	}
 
-      FAV3LOCK;
+      FAV3SLOTLOCK(id);
       for(i = 0; i < 512; i++)
 	{
 	  unsigned int idx   = (chan*16)/16;
@@ -8403,7 +9766,7 @@ faV3MeasureChannelPedestal(int id, unsigned int chan, faV3Ped *ped)
 	  if(adc_val > p.max)
 	    p.max = adc_val;
 	}
-      FAV3UNLOCK;
+      FAV3SLOTUNLOCK(id);
     }
 
   nsamples = 512.0 * (double)FAV3_MEASURE_PED_NTIMES;
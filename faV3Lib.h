@@ -31,6 +31,14 @@
 #define FAV3_VME_INT_LEVEL           3
 #define FAV3_VME_INT_VEC          0xFA
 
+/* faV3BlockReadyWait tuning (microseconds) */
+#define FAV3_WAIT_SPIN_MAX_US       200
+#define FAV3_WAIT_SLEEP_MAX_US     1000
+#define FAV3_WAIT_POLL_MAX_US     10000
+
+/* User routine called from the block-ready interrupt handler */
+typedef void (*FAV3INTFUNCPTR) (int arg);
+
 #define FAV3_CTRL_PRAD_FIRMWARE 0x20F
 #define FAV3_PROC_PRAD_FIRMWARE 0xF04
 
@@ -282,6 +290,31 @@ typedef struct faV3_sdc_struct
   volatile uint16_t busy_status;
 } faV3sdc_t;
 
+/* Register regions read by faV3Snapshot and faV3GSnapshot: every status,
+   counter and configuration register, but not the blank addresses and not
+   those with side effects when read (memory data, event generator, sum
+   data, logic analyzer). */
+#define FAV3_SNAP_CTRL      (1 << 0)	/* 0x000 - 0x0FC: 54 registers */
+#define FAV3_SNAP_ADC       (1 << 1)	/* 0x100 - 0x1EE: 120 (16 bit) */
+#define FAV3_SNAP_SCALERS   (1 << 2)	/* 0x300 - 0x340: 17 */
+#define FAV3_SNAP_AUX       (1 << 3)	/* 0x500 - 0x54C: 15 */
+#define FAV3_SNAP_ALL       0xF
+
+/* Copy of the registers of one board, at their offsets in the board map.
+   Registers not read are 0. */
+typedef struct faV3Snapshot_struct
+{
+  int32_t id;			/* slot */
+  uint32_t a24addr;		/* VME A24 base address */
+  uint32_t regions;		/* FAV3_SNAP_* read */
+  faV3_t regs;
+} faV3Snapshot_t;
+
+/* faV3ShadowVerify rflag */
+#define FAV3_SHADOW_VERIFY  0	/* only print the differences */
+#define FAV3_SHADOW_LOAD    1	/* take the hardware values */
+#define FAV3_SHADOW_RESTORE 2	/* write the shadow values to the board */
+
 
 /* FADC Special Board IDs */
 
@@ -749,6 +782,7 @@ extern const char *faV3_mode_names[FAV3_MAX_PROC_MODE + 1];
 #define FAV3_INIT_MULTIBLOCK_ONLY     (1<<19)
 #define FAV3_INIT_VXS_READOUT_ONLY    (1<<20)
 #define FAV3_INIT_A32_SLOTNUMBER      (1<<21)
+#define FAV3_INIT_USE_SHADOW          (1<<22)
 
 /* Define Init Flag bits for Clock Source */
 #define FAV3_SOURCE_INT         FAV3_INIT_INT_CLKSRC
@@ -806,6 +840,22 @@ int faV3GSetClockSource(int clkSrc);
 
 int faV3Status(int id, int sflag);
 void faV3GStatus(int sflag);
+int faV3Snapshot(int id, uint32_t regions, faV3Snapshot_t * snap);
+int faV3GSnapshot(uint32_t regions, faV3Snapshot_t * snap);
+int faV3SnapshotBlockConfig(int enable, uint32_t addrType, uint32_t dataType,
+			    uint32_t sstMode);
+int faV3PrintStatus(const faV3Snapshot_t * snap, int sflag);
+void faV3PrintGStatus(const faV3Snapshot_t * snap, int nsnap, int sflag);
+uint32_t faV3RegRead32(int id, volatile uint32_t * reg);
+uint16_t faV3RegRead16(int id, volatile uint16_t * reg);
+void faV3RegWrite32(int id, volatile uint32_t * reg, uint32_t val);
+void faV3RegWrite16(int id, volatile uint16_t * reg, uint16_t val);
+int faV3ShadowEnable(int id, int enable);
+int faV3ShadowBatch(int id, int enable);
+void faV3GShadowEnable(int enable);
+int faV3ShadowVerify(int id, int rflag);
+int faV3GShadowVerify(int rflag);
+int faV3ShadowStatus(int id, int pflag);
 uint32_t faV3GetFirmwareVersions(int id, int pflag);
 
 int faV3SetProcMode(int id, int pmode, uint32_t PL, uint32_t PTW,
@@ -838,6 +888,10 @@ int faV3PPGDisable(int id);
 uint32_t faV3ItrigControl(int id, uint16_t itrig_width, uint16_t itrig_dt);
 
 int faV3ReadBlock(int id, volatile uint32_t * data, int nwrds, int rflag);
+int faV3ReadBlockStart(int id, volatile uint32_t * data, int nwrds, int rflag);
+int faV3ReadBlockDone();
+int faV3ReadBlockDoneStatus(int *blockError);
+int faV3ReadBlockPending();
 int faV3GetBlockError(int pflag);
 int faV3PrintBlock(int id);
 
@@ -884,6 +938,12 @@ int faV3Dready(int id, int dflag);
 int faV3Bready(int id);
 uint32_t faV3GBready();
 uint32_t faV3GBlockReady(uint32_t slotmask, int nloop);
+int faV3IntConnect(uint32_t vector, uint32_t level, FAV3INTFUNCPTR routine, int arg);
+int faV3IntDisconnect();
+int faV3IntEnable(int id);
+int faV3IntDisable(int id);
+int faV3BlockReadyFd();
+uint32_t faV3BlockReadyWait(uint32_t slotmask, int timeout_us);
 uint32_t faV3ScanMask();
 int faV3BusyLevel(int id, uint32_t val, int bflag);
 int faV3Busy(int id);
@@ -0,0 +1,438 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3PulseEmu.c
+ *
+ * @brief     Software pulse parameter (mode 9) algorithm.
+ *
+ *            Computes, from the raw samples of a window, a pulse
+ *            parameter record in the mode 9 format, following the
+ *            algorithm below.  With mode 10 data it can be compared with
+ *            the record from the board (faV3PulseEmuCompare), and raw runs
+ *            can be reprocessed with other parameters.
+ *
+ *            For a window of n samples and channel threshold TET:
+ *
+ *            Pedestal: the first NPED samples.  Samples above MAXPED (or
+ *              with the overflow bit) are left out of the sum and set the
+ *              pedestal quality bit.  VMIN is the mean of the samples
+ *              summed.
+ *
+ *            Pulse: a sample above VMIN + TET whose previous sample is not,
+ *              followed by NSAT - 1 more samples above VMIN + TET, at or
+ *              after sample NPED.  Up to NP pulses, each searched for
+ *              after the integration window of the last.
+ *
+ *            Sum: samples TC - NSB to TC + NSA - 1 (TC + |NSB| onwards if
+ *              NSB < 0), clipped to the window.  If the last sample is
+ *              still above threshold the sum is extended until a sample
+ *              is not (NSA extension bit).  over/under are set if a summed
+ *              sample overflowed or is 0.  #OT counts the summed samples
+ *              above threshold.
+ *
+ *            Peak: the first local maximum from TC.  No-peak quality bit
+ *              if the samples are still rising at the end of the window.
+ *
+ *            Time: where the rising edge crosses VMID = (VMIN + VPEAK) / 2,
+ *              coarse = sample below VMID, fine = 64 * (VMID - Vbelow) /
+ *              (Vabove - Vbelow).  Time quality bit if there is no sample
+ *              below VMID before the peak.
+ *
+ *            The threshold comparison is done for the whole window at
+ *            once, with SSE2/AVX2 when available.
+ *
+ *            The trigger path threshold (TPT) is not used: it sets the
+ *            trigger sums only.
+ *
+ *            What is checked (test/faV3PulseEmuCheck): windows whose
+ *            records were worked out by hand from the description above,
+ *            and the SIMD and scalar paths against each other.  It has
+ *            not been compared with records from a board, so agreement
+ *            with the firmware is not claimed; faV3PulseEmuCheck -f runs
+ *            that comparison on a mode 10 file when one is available.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAV3_EMU_X86
+#endif
+#include "faV3PulseEmu.h"
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+/* Words in the threshold bitmask: a zero word in front (sample -1), and
+   room for NSAT look-ahead past the end */
+#define FAV3_EMU_MASK_WORDS  ((FAV3_DEC_MAX_SAMPLES >> 5) + 3)
+
+#define FAV3_EMU_PULSE_PARAM 0x48000000	/* type 9 */
+
+/**
+ * @brief Fill a configuration with the library defaults
+ *        (FAV3_ADC_DEFAULT_*)
+ */
+void
+faV3PulseEmuDefaults(faV3PulseEmuConfig_t * cfg)
+{
+  int32_t ichan;
+
+  memset(cfg, 0, sizeof(faV3PulseEmuConfig_t));
+
+  cfg->NSB = FAV3_ADC_DEFAULT_NSB;
+  cfg->NSA = FAV3_ADC_DEFAULT_NSA;
+  cfg->NP = FAV3_ADC_DEFAULT_NP;
+  cfg->NPED = FAV3_ADC_DEFAULT_NPED;
+  cfg->MAXPED = FAV3_ADC_DEFAULT_MAXPED;
+  cfg->NSAT = FAV3_ADC_DEFAULT_NSAT;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    cfg->thres[ichan] = FAV3_ADC_DEFAULT_TET;
+}
+
+/*
+ * Threshold bitmask: bit i of mask (after the leading zero word) is set if
+ * samples[i] > thr.  Samples are at most 13 bits, so signed 16 bit compares
+ * are fine.
+ */
+
+static void
+faV3EmuAboveScalar(const uint16_t * samples, uint32_t n, uint16_t thr,
+		   uint32_t * mask)
+{
+  uint32_t i;
+
+  for(i = 0; i < n; i++)
+    if(samples[i] > thr)
+      mask[i >> 5] |= 1u << (i & 31);
+}
+
+#ifdef FAV3_EMU_X86
+__attribute__ ((target("sse2")))
+static void
+faV3EmuAboveSSE2(const uint16_t * samples, uint32_t n, uint16_t thr,
+		 uint32_t * mask)
+{
+  const __m128i t = _mm_set1_epi16((short) thr);
+  __m128i a, b;
+  uint32_t i;
+
+  /* 16 samples per pass */
+  for(i = 0; i + 16 <= n; i += 16)
+    {
+      a = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *) &samples[i]), t);
+      b = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *) &samples[i + 8]),
+			  t);
+      mask[i >> 5] |= ((uint32_t) _mm_movemask_epi8(_mm_packs_epi16(a, b)))
+	<< (i & 31);
+    }
+
+  /* The rest, with the mask still aligned: i is a multiple of 16 */
+  if(i < n)
+    {
+      uint32_t j, bits = 0;
+
+      for(j = i; j < n; j++)
+	if(samples[j] > thr)
+	  bits |= 1u << (j - i);
+      mask[i >> 5] |= bits << (i & 31);
+    }
+}
+
+__attribute__ ((target("avx2")))
+static void
+faV3EmuAboveAVX2(const uint16_t * samples, uint32_t n, uint16_t thr,
+		 uint32_t * mask)
+{
+  const __m256i t = _mm256_set1_epi16((short) thr);
+  __m256i a, b;
+  uint32_t i;
+
+  /* 32 samples per pass */
+  for(i = 0; i + 32 <= n; i += 32)
+    {
+      a = _mm256_cmpgt_epi16(_mm256_loadu_si256((const __m256i *)
+						&samples[i]), t);
+      b = _mm256_cmpgt_epi16(_mm256_loadu_si256((const __m256i *)
+						&samples[i + 16]), t);
+      /* packs works per 128 bit lane, put the quadwords back in order */
+      mask[i >> 5] =
+	(uint32_t) _mm256_movemask_epi8(_mm256_permute4x64_epi64
+					(_mm256_packs_epi16(a, b), 0xD8));
+    }
+
+  _mm256_zeroupper();
+
+  faV3EmuAboveSSE2(&samples[i], n - i, thr, &mask[i >> 5]);
+}
+#endif /* FAV3_EMU_X86 */
+
+typedef void (*faV3EmuAboveFunc_t) (const uint16_t *, uint32_t, uint16_t,
+				    uint32_t *);
+
+static inline faV3EmuAboveFunc_t
+faV3EmuAboveSelect()
+{
+#ifdef FAV3_EMU_X86
+  if(__builtin_cpu_supports("avx2"))
+    return faV3EmuAboveAVX2;
+  if(__builtin_cpu_supports("sse2"))
+    return faV3EmuAboveSSE2;
+#endif
+  return faV3EmuAboveScalar;
+}
+
+/* 32 bits of the threshold mask starting at sample pos (pos >= -1) */
+static inline uint32_t
+faV3EmuBits(const uint32_t * m, int32_t pos)
+{
+  uint32_t idx = (uint32_t) (pos + 32), s = idx & 31;
+
+  if(s == 0)
+    return m[idx >> 5];
+
+  return (m[idx >> 5] >> s) | (m[(idx >> 5) + 1] << (32 - s));
+}
+
+/* Next pulse at or after sample from, or -1 */
+static int32_t
+faV3EmuFindPulse(const uint32_t * m, uint32_t n, uint32_t from,
+		 uint32_t nsat)
+{
+  uint32_t pos, cand, j;
+
+  for(pos = from; pos < n; pos += 32)
+    {
+      /* Above threshold, previous sample not */
+      cand = faV3EmuBits(m, pos) & ~faV3EmuBits(m, (int32_t) pos - 1);
+      for(j = 1; (j < nsat) && cand; j++)
+	cand &= faV3EmuBits(m, pos + j);
+
+      if(cand)
+	{
+	  pos += __builtin_ctz(cand);
+	  return (pos < n) ? (int32_t) pos : -1;
+	}
+    }
+
+  return -1;
+}
+
+/**
+ * @brief Compute the pulse parameters of one raw window
+ * @param cfg Parameters
+ * @param chan Channel (selects the threshold)
+ * @param samples 13 bit raw samples
+ * @param nsamples Number of samples (up to FAV3_DEC_MAX_SAMPLES)
+ * @param out Pulse parameter record (slot, event and evt_of_blk are not set)
+ * @return Number of pulses found, otherwise ERROR
+ */
+int32_t
+faV3PulseEmuWindow(const faV3PulseEmuConfig_t * cfg, uint32_t chan,
+		   const uint16_t * samples, uint32_t nsamples,
+		   faV3DecRecord_t * out)
+{
+  uint32_t mask_buf[FAV3_EMU_MASK_WORDS];
+  uint32_t *mask = &mask_buf[1];
+  uint32_t i, n = nsamples, nped, ninc = 0, vmin = 0, thr, tet;
+  uint32_t np, sum, nover, over, under, ipk, vpeak, vmid, vb, va;
+  uint32_t ped_sum = 0, ped_bad = 0;
+  int32_t tc, start, end, k, from;
+  faV3DecPulse_t *p;
+
+  if((cfg == NULL) || (out == NULL) || (chan >= FAV3_MAX_ADC_CHANNELS) ||
+     ((samples == NULL) && (nsamples > 0)) ||
+     (nsamples > FAV3_DEC_MAX_SAMPLES))
+    return ERROR;
+
+  memset(out, 0, sizeof(faV3DecRecord_t));
+  out->type = FAV3_DEC_PULSE_PARAM;
+  out->u.pp.chan = chan;
+
+  /* Pedestal */
+  nped = (cfg->NPED < n) ? cfg->NPED : n;
+  for(i = 0; i < nped; i++)
+    {
+      if((samples[i] & FAV3_EMU_SAMPLE_OVERFLOW) || (samples[i] > cfg->MAXPED))
+	{
+	  ped_bad = 1;
+	  continue;
+	}
+      ped_sum += samples[i];
+      ninc++;
+    }
+  if(ninc)
+    vmin = ped_sum / ninc;
+
+  out->u.pp.quality = ped_bad;
+  out->u.pp.ped_sum = (ped_sum > 0x3FFF) ? 0x3FFF : ped_sum;
+  out->word = FAV3_DATA_TYPE_DEFINE | FAV3_EMU_PULSE_PARAM | (chan << 15) |
+    (ped_bad << 14) | out->u.pp.ped_sum;
+
+  if(cfg->thres[chan] & FAV3_THR_IGNORE_MASK)
+    return 0;
+
+  tet = cfg->thres[chan] & FAV3_THR_VALUE_MASK;
+  thr = vmin + tet;
+
+  /* Threshold mask for the whole window */
+  memset(mask_buf, 0, ((n >> 5) + 3) * sizeof(uint32_t));
+  if(cfg->flags & FAV3_DEC_FLAG_SCALAR)
+    faV3EmuAboveScalar(samples, n, (uint16_t) thr, mask);
+  else
+    (*faV3EmuAboveSelect()) (samples, n, (uint16_t) thr, mask);
+
+  np = cfg->NP;
+  if(np > FAV3_DEC_MAX_PULSES)
+    np = FAV3_DEC_MAX_PULSES;
+
+  from = nped;
+  while((out->u.pp.npulse < np) &&
+	((tc = faV3EmuFindPulse(mask_buf, n, from, cfg->NSAT ? cfg->NSAT : 1))
+	 >= 0))
+    {
+      p = &out->u.pp.pulse[out->u.pp.npulse++];
+      p->word1_type = 1;
+
+      /* Sum */
+      start = (cfg->NSB >= 0) ? tc - cfg->NSB : tc + (-cfg->NSB);
+      if(start < 0)
+	start = 0;
+      end = tc + (int32_t) cfg->NSA;
+      if(end > (int32_t) n)
+	end = n;
+      if((end < (int32_t) n) && (end > 0) && (samples[end - 1] > thr))
+	{
+	  p->nsa_ext = 1;
+	  while((end < (int32_t) n) && (samples[end] > thr))
+	    end++;
+	}
+
+      sum = nover = over = under = 0;
+      for(k = start; k < end; k++)
+	{
+	  sum += samples[k];
+	  nover += (samples[k] > thr);
+	  over |= (samples[k] & FAV3_EMU_SAMPLE_OVERFLOW) ? 1 : 0;
+	  under |= (samples[k] == 0);
+	}
+
+      p->adc_sum = (sum > 0x3FFFF) ? 0x3FFFF : sum;
+      p->over = over;
+      p->under = under;
+      p->samp_ov_thres = (nover > 0x1FF) ? 0x1FF : nover;
+
+      /* Peak */
+      ipk = tc;
+      while((ipk + 1 < n) && (samples[ipk + 1] > samples[ipk]))
+	ipk++;
+      vpeak = samples[ipk];
+      if(ipk + 1 >= n)
+	p->quality = 1;
+      p->vpeak = vpeak & 0xFFF;
+
+      /* Time at half height */
+      vmid = (vmin + vpeak) >> 1;
+      k = ipk;
+      while((k > 0) && (samples[k - 1] > vmid))
+	k--;
+      if(k == 0)
+	p->quality2 = 1;
+      else
+	{
+	  vb = samples[k - 1];
+	  va = samples[k];
+	  p->time_coarse = (k - 1) & 0x1FF;
+	  p->time_fine = (va > vb) ? (((vmid - vb) << 6) / (va - vb)) & 0x3F : 0;
+	}
+
+      from = (end > tc) ? end : tc + 1;
+    }
+
+  return out->u.pp.npulse;
+}
+
+/**
+ * @brief Compute the pulse parameters of a decoded raw window record
+ * @param cfg Parameters
+ * @param win FAV3_DEC_WINDOW_RAW record
+ * @param out Pulse parameter record, with the slot and event of win
+ * @return Number of pulses found, otherwise ERROR
+ */
+int32_t
+faV3PulseEmuRecord(const faV3PulseEmuConfig_t * cfg,
+		   const faV3DecRecord_t * win, faV3DecRecord_t * out)
+{
+  int32_t rval;
+
+  if((win == NULL) || (win->type != FAV3_DEC_WINDOW_RAW))
+    return ERROR;
+
+  rval = faV3PulseEmuWindow(cfg, win->u.win.chan, win->u.win.samples,
+			    win->u.win.nsamples, out);
+  if(rval < 0)
+    return rval;
+
+  out->slot = win->slot;
+  out->evt_num = win->evt_num;
+  out->evt_idx = win->evt_idx;
+  out->u.pp.evt_of_blk = win->evt_idx + 1;
+  out->word |= (out->u.pp.evt_of_blk & 0xFF) << 19;
+
+  return rval;
+}
+
+/**
+ * @brief Compare a pulse parameter record from the data with a computed one
+ * @param data Record from the data
+ * @param emu Record from faV3PulseEmuWindow or faV3PulseEmuRecord
+ * @return 0 if they agree, otherwise FAV3_EMU_DIFF_* bits
+ */
+uint32_t
+faV3PulseEmuCompare(const faV3DecRecord_t * data, const faV3DecRecord_t * emu)
+{
+  const faV3DecPulse_t *a, *b;
+  uint32_t diff = 0, ip, np;
+
+  if((data == NULL) || (emu == NULL))
+    return 0xFFFFFFFF;
+
+  if(data->u.pp.chan != emu->u.pp.chan)
+    diff |= FAV3_EMU_DIFF_CHAN;
+
+  if((data->u.pp.ped_sum != emu->u.pp.ped_sum) ||
+     (data->u.pp.quality != emu->u.pp.quality))
+    diff |= FAV3_EMU_DIFF_PEDESTAL;
+
+  if(data->u.pp.npulse != emu->u.pp.npulse)
+    diff |= FAV3_EMU_DIFF_NPULSE;
+
+  np = (data->u.pp.npulse < emu->u.pp.npulse) ?
+    data->u.pp.npulse : emu->u.pp.npulse;
+
+  for(ip = 0; ip < np; ip++)
+    {
+      a = &data->u.pp.pulse[ip];
+      b = &emu->u.pp.pulse[ip];
+
+      if(a->adc_sum != b->adc_sum)
+	diff |= FAV3_EMU_DIFF_SUM;
+      if((a->nsa_ext != b->nsa_ext) || (a->over != b->over) ||
+	 (a->under != b->under) || (a->samp_ov_thres != b->samp_ov_thres))
+	diff |= FAV3_EMU_DIFF_FLAGS;
+      if((a->time_coarse != b->time_coarse) ||
+	 (a->time_fine != b->time_fine) || (a->quality2 != b->quality2))
+	diff |= FAV3_EMU_DIFF_TIME;
+      if((a->vpeak != b->vpeak) || (a->quality != b->quality))
+	diff |= FAV3_EMU_DIFF_PEAK;
+    }
+
+  return diff;
+}
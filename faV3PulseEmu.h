@@ -0,0 +1,58 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3PulseEmu.h
+ *
+ * @brief     Header for the software pulse parameter (mode 9) algorithm
+ *
+ *            Works on decoded raw windows (faV3Decoder.h records), does no
+ *            I/O and has no global state, so it may be run on many threads.
+ *            It implements the algorithm as written out in faV3PulseEmu.c,
+ *            and is checked against that description only: it has not
+ *            been compared with records from a board, and agreement with
+ *            the firmware is not claimed.
+ *
+ */
+
+#include <stdint.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+
+/* Fields that differ, from faV3PulseEmuCompare */
+#define FAV3_EMU_DIFF_PEDESTAL    (1 << 0)	/* ped_sum or pedestal quality */
+#define FAV3_EMU_DIFF_NPULSE      (1 << 1)
+#define FAV3_EMU_DIFF_SUM         (1 << 2)
+#define FAV3_EMU_DIFF_FLAGS       (1 << 3)	/* nsa_ext, over, under, #over thres */
+#define FAV3_EMU_DIFF_TIME        (1 << 4)	/* coarse or fine time */
+#define FAV3_EMU_DIFF_PEAK        (1 << 5)	/* vpeak or its quality bits */
+#define FAV3_EMU_DIFF_CHAN        (1 << 6)
+
+/* A 13 bit raw sample with bit 12 set is an ADC overflow */
+#define FAV3_EMU_SAMPLE_OVERFLOW  0x1000
+
+/* The mode 9 parameters, as programmed by faV3SetProcMode/
+   faV3HallDSetProcMode (NSB, NSA, NP), faV3SetPulseParameterConfig (NPED,
+   MAXPED, NSAT) and faV3SetThreshold (TET).  The trigger path threshold
+   (faV3SetTriggerPathThreshold, TPT) feeds the trigger sums, not the
+   readout records, so it has no field here. */
+typedef struct faV3PulseEmuConfig_struct
+{
+  int32_t NSB;			/* < 0: samples after threshold excluded */
+  uint32_t NSA, NP;
+  uint32_t NPED, MAXPED, NSAT;
+  uint16_t thres[FAV3_MAX_ADC_CHANNELS];	/* thres register value: TET
+						   and FAV3_THR_IGNORE_MASK */
+  uint32_t flags;		/* FAV3_DEC_FLAG_SCALAR */
+} faV3PulseEmuConfig_t;
+
+void faV3PulseEmuDefaults(faV3PulseEmuConfig_t * cfg);
+int32_t faV3PulseEmuWindow(const faV3PulseEmuConfig_t * cfg, uint32_t chan,
+			   const uint16_t * samples, uint32_t nsamples,
+			   faV3DecRecord_t * out);
+int32_t faV3PulseEmuRecord(const faV3PulseEmuConfig_t * cfg,
+			   const faV3DecRecord_t * win, faV3DecRecord_t * out);
+uint32_t faV3PulseEmuCompare(const faV3DecRecord_t * data,
+			     const faV3DecRecord_t * emu);
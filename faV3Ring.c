@@ -0,0 +1,415 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Ring.c
+ *
+ * @brief     Pooled readout ring of DMA destination buffers.
+ *
+ *            A readout thread fills buffers with faV3ReadBlock
+ *            (faV3RingFill).  Consumer threads borrow filled buffers
+ *            without copying (faV3RingBorrow), may share them with
+ *            faV3RingRetain, and hand them back with faV3RingRelease.  A
+ *            buffer returns to the free list when its last reference is
+ *            released.
+ *
+ *            Buffers are allocated once from jvme DMA memory and aligned to
+ *            8 bytes, so the dummy word that faV3ReadBlock inserts for
+ *            unaligned destinations is never needed here.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Ring.h"
+
+typedef struct
+{
+  int32_t created;
+  int32_t nbuf;
+  int32_t maxwords;
+  DMA_MEM_ID pool;
+  faV3RingBuf_t buf[FAV3_RING_MAX_BUFFERS];
+
+  /* Queues of buffer indices */
+  int32_t freeq[FAV3_RING_MAX_BUFFERS];
+  int32_t freehead, nfree;
+  int32_t fullq[FAV3_RING_MAX_BUFFERS];
+  int32_t fullhead, nfull;
+
+  /* Statistics */
+  uint32_t seq;
+  uint32_t nfill, nborrow, nrelease, nfillwait, nfillerror;
+} faV3Ring_t;
+
+static faV3Ring_t faV3Ring;
+
+pthread_mutex_t faV3RingMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t faV3RingFreeCond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t faV3RingFullCond = PTHREAD_COND_INITIALIZER;
+#define RINGLOCK      if(pthread_mutex_lock(&faV3RingMutex)<0) perror("pthread_mutex_lock");
+#define RINGUNLOCK    if(pthread_mutex_unlock(&faV3RingMutex)<0) perror("pthread_mutex_unlock");
+
+static void
+faV3RingPush(int32_t * q, int32_t head, int32_t * count, int32_t index)
+{
+  q[(head + *count) % faV3Ring.nbuf] = index;
+  (*count)++;
+}
+
+static int32_t
+faV3RingPop(int32_t * q, int32_t * head, int32_t * count)
+{
+  int32_t index = q[*head];
+
+  *head = (*head + 1) % faV3Ring.nbuf;
+  (*count)--;
+
+  return index;
+}
+
+/* Wait on cond until *count is non-zero.  Called with faV3RingMutex held.
+   timeout_us: 0 = don't wait, < 0 = wait forever */
+static int32_t
+faV3RingWait(pthread_cond_t * cond, int32_t * count, int32_t timeout_us)
+{
+  struct timeval now;
+  struct timespec abstime;
+  int rval = 0;
+
+  if(timeout_us > 0)
+    {
+      gettimeofday(&now, NULL);
+      abstime.tv_sec = now.tv_sec + timeout_us / 1000000;
+      abstime.tv_nsec = (now.tv_usec + (timeout_us % 1000000)) * 1000;
+      if(abstime.tv_nsec >= 1000000000)
+	{
+	  abstime.tv_sec++;
+	  abstime.tv_nsec -= 1000000000;
+	}
+    }
+
+  while((*count == 0) && faV3Ring.created)
+    {
+      if(timeout_us == 0)
+	return ERROR;
+
+      if(timeout_us < 0)
+	rval = pthread_cond_wait(cond, &faV3RingMutex);
+      else
+	rval = pthread_cond_timedwait(cond, &faV3RingMutex, &abstime);
+
+      if(rval == ETIMEDOUT)
+	break;
+    }
+
+  return (*count > 0) ? OK : ERROR;
+}
+
+/**
+ * @brief Allocate the readout ring
+ * @param nbuf Number of buffers (up to FAV3_RING_MAX_BUFFERS)
+ * @param maxwords Capacity of each buffer, in 32bit words
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3RingCreate(int32_t nbuf, int32_t maxwords)
+{
+  int32_t ibuf;
+  DMANODE *node;
+
+  if((nbuf <= 0) || (nbuf > FAV3_RING_MAX_BUFFERS))
+    {
+      printf("%s: ERROR: Invalid number of buffers (%d)\n", __func__, nbuf);
+      return ERROR;
+    }
+
+  if(maxwords <= 0)
+    {
+      printf("%s: ERROR: Invalid buffer size (%d words)\n", __func__,
+	     maxwords);
+      return ERROR;
+    }
+
+  RINGLOCK;
+  if(faV3Ring.created)
+    {
+      printf("%s: ERROR: Ring already created\n", __func__);
+      RINGUNLOCK;
+      return ERROR;
+    }
+
+  memset(&faV3Ring, 0, sizeof(faV3Ring));
+
+  /* Extra 8 bytes per item to align the start of the data */
+  faV3Ring.pool = dmaPCreate("faV3Ring", (maxwords << 2) + 8, nbuf, 0);
+  if(faV3Ring.pool == NULL)
+    {
+      printf("%s: ERROR: Unable to allocate %d DMA buffers of %d words\n",
+	     __func__, nbuf, maxwords);
+      RINGUNLOCK;
+      return ERROR;
+    }
+
+  faV3Ring.nbuf = nbuf;
+  faV3Ring.maxwords = maxwords;
+
+  for(ibuf = 0; ibuf < nbuf; ibuf++)
+    {
+      node = dmaPGetItem(faV3Ring.pool);
+      if(node == NULL)
+	{
+	  printf("%s: ERROR: Unable to get DMA buffer %d\n", __func__, ibuf);
+	  while(--ibuf >= 0)
+	    dmaPFreeItem((DMANODE *) faV3Ring.buf[ibuf].node);
+	  dmaPFree(faV3Ring.pool);
+	  faV3Ring.pool = NULL;
+	  RINGUNLOCK;
+	  return ERROR;
+	}
+
+      faV3Ring.buf[ibuf].node = node;
+      faV3Ring.buf[ibuf].data = (volatile uint32_t *)
+	(((unsigned long) node->data + 7) & ~((unsigned long) 7));
+      faV3Ring.buf[ibuf].maxwords = maxwords;
+      faV3Ring.buf[ibuf].index = ibuf;
+      faV3RingPush(faV3Ring.freeq, faV3Ring.freehead, &faV3Ring.nfree, ibuf);
+    }
+
+  faV3Ring.created = 1;
+  RINGUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Free the readout ring.
+ *        Filled buffers that were not borrowed are discarded.
+ * @return OK if successful, ERROR if buffers are still borrowed.
+ */
+int32_t
+faV3RingDestroy()
+{
+  int32_t ibuf;
+
+  RINGLOCK;
+  if(!faV3Ring.created)
+    {
+      RINGUNLOCK;
+      return OK;
+    }
+
+  if((faV3Ring.nfree + faV3Ring.nfull) != faV3Ring.nbuf)
+    {
+      printf("%s: ERROR: %d buffer(s) still borrowed\n", __func__,
+	     faV3Ring.nbuf - faV3Ring.nfree - faV3Ring.nfull);
+      RINGUNLOCK;
+      return ERROR;
+    }
+
+  for(ibuf = 0; ibuf < faV3Ring.nbuf; ibuf++)
+    dmaPFreeItem((DMANODE *) faV3Ring.buf[ibuf].node);
+  dmaPFree(faV3Ring.pool);
+
+  faV3Ring.pool = NULL;
+  faV3Ring.created = 0;
+
+  /* Wake up anybody still waiting */
+  pthread_cond_broadcast(&faV3RingFreeCond);
+  pthread_cond_broadcast(&faV3RingFullCond);
+  RINGUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Read a block into the next free buffer and queue it for consumers
+ *
+ *   The transfer is done outside of the ring lock, with faV3ReadBlock for
+ *   programmed I/O and faV3ReadBlockStart/faV3ReadBlockDoneStatus for DMA,
+ *   so that the block error kept is the one of this transfer.
+ *
+ * @param id Slot number (see faV3ReadBlock)
+ * @param rflag Readout flag (see faV3ReadBlock)
+ * @param timeout_us Time to wait for a free buffer. 0 = no wait, <0 = forever
+ * @return Number of words read, 0 if there was no data, otherwise ERROR
+ */
+int32_t
+faV3RingFill(int32_t id, int32_t rflag, int32_t timeout_us)
+{
+  faV3RingBuf_t *buf;
+  int32_t index, nwords, berr = FAV3_BLOCKERROR_NO_ERROR;
+
+  RINGLOCK;
+  if(!faV3Ring.created)
+    {
+      printf("%s: ERROR: Ring not created\n", __func__);
+      RINGUNLOCK;
+      return ERROR;
+    }
+
+  if(faV3Ring.nfree == 0)
+    faV3Ring.nfillwait++;
+
+  if(faV3RingWait(&faV3RingFreeCond, &faV3Ring.nfree, timeout_us) != OK)
+    {
+      RINGUNLOCK;
+      return ERROR;
+    }
+
+  index = faV3RingPop(faV3Ring.freeq, &faV3Ring.freehead, &faV3Ring.nfree);
+  RINGUNLOCK;
+
+  buf = &faV3Ring.buf[index];
+  if((rflag & 0x0f) >= 1)
+    {
+      nwords = faV3ReadBlockStart(id, buf->data, buf->maxwords, rflag);
+      if(nwords == OK)
+	nwords = faV3ReadBlockDoneStatus(&berr);
+    }
+  else
+    nwords = faV3ReadBlock(id, buf->data, buf->maxwords, rflag);
+
+  RINGLOCK;
+  if(nwords <= 0)
+    {
+      faV3Ring.nfillerror++;
+      faV3RingPush(faV3Ring.freeq, faV3Ring.freehead, &faV3Ring.nfree, index);
+      pthread_cond_signal(&faV3RingFreeCond);
+      RINGUNLOCK;
+      return nwords;
+    }
+
+  buf->nwords = nwords;
+  buf->blockError = berr;
+  buf->seq = faV3Ring.seq++;
+  buf->refcnt = 0;
+
+  faV3RingPush(faV3Ring.fullq, faV3Ring.fullhead, &faV3Ring.nfull, index);
+  faV3Ring.nfill++;
+  pthread_cond_signal(&faV3RingFullCond);
+  RINGUNLOCK;
+
+  return nwords;
+}
+
+/**
+ * @brief Take the oldest filled buffer.
+ *        The caller holds one reference and must call faV3RingRelease.
+ * @param timeout_us Time to wait for a filled buffer. 0 = no wait, <0 = forever
+ * @return Pointer to the buffer, or NULL if none was available.
+ */
+faV3RingBuf_t *
+faV3RingBorrow(int32_t timeout_us)
+{
+  faV3RingBuf_t *buf;
+  int32_t index;
+
+  RINGLOCK;
+  if(faV3RingWait(&faV3RingFullCond, &faV3Ring.nfull, timeout_us) != OK)
+    {
+      RINGUNLOCK;
+      return NULL;
+    }
+
+  index = faV3RingPop(faV3Ring.fullq, &faV3Ring.fullhead, &faV3Ring.nfull);
+  faV3Ring.nborrow++;
+  RINGUNLOCK;
+
+  buf = &faV3Ring.buf[index];
+  __sync_add_and_fetch(&buf->refcnt, 1);
+
+  return buf;
+}
+
+/**
+ * @brief Add a reference to a borrowed buffer, to share it with another thread.
+ * @return buf
+ */
+faV3RingBuf_t *
+faV3RingRetain(faV3RingBuf_t * buf)
+{
+  if(buf == NULL)
+    return NULL;
+
+  __sync_add_and_fetch(&buf->refcnt, 1);
+
+  return buf;
+}
+
+/**
+ * @brief Drop a reference to a borrowed buffer.
+ *        The buffer is reused once the last reference is dropped.
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3RingRelease(faV3RingBuf_t * buf)
+{
+  int32_t refcnt;
+
+  if(buf == NULL)
+    return ERROR;
+
+  refcnt = __sync_sub_and_fetch(&buf->refcnt, 1);
+  if(refcnt < 0)
+    {
+      printf("%s: ERROR: Buffer %d released too many times\n", __func__,
+	     buf->index);
+      __sync_add_and_fetch(&buf->refcnt, 1);
+      return ERROR;
+    }
+
+  if(refcnt == 0)
+    {
+      RINGLOCK;
+      faV3RingPush(faV3Ring.freeq, faV3Ring.freehead, &faV3Ring.nfree,
+		   buf->index);
+      faV3Ring.nrelease++;
+      pthread_cond_signal(&faV3RingFreeCond);
+      RINGUNLOCK;
+    }
+
+  return OK;
+}
+
+/**
+ * @brief Show the state of the readout ring
+ * @param pflag Print to standard out if non-zero
+ * @return Number of filled buffers waiting for a consumer
+ */
+int32_t
+faV3RingStatus(int32_t pflag)
+{
+  int32_t rval;
+
+  RINGLOCK;
+  rval = faV3Ring.nfull;
+
+  if(pflag)
+    {
+      printf("faV3Ring: %s\n", faV3Ring.created ? "created" : "not created");
+      if(faV3Ring.created)
+	{
+	  printf("  Buffers   %4d x %d words\n", faV3Ring.nbuf,
+		 faV3Ring.maxwords);
+	  printf("  Free      %4d\n", faV3Ring.nfree);
+	  printf("  Filled    %4d\n", faV3Ring.nfull);
+	  printf("  Borrowed  %4d\n",
+		 faV3Ring.nbuf - faV3Ring.nfree - faV3Ring.nfull);
+	  printf("  Fills       %10u  (waited %u, no data/error %u)\n",
+		 faV3Ring.nfill, faV3Ring.nfillwait, faV3Ring.nfillerror);
+	  printf("  Borrows     %10u\n", faV3Ring.nborrow);
+	  printf("  Releases    %10u\n", faV3Ring.nrelease);
+	}
+    }
+  RINGUNLOCK;
+
+  return rval;
+}
@@ -0,0 +1,37 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3Ring.h
+ *
+ * @brief     Header for the pooled readout ring of DMA destination buffers
+ *
+ */
+
+#include <stdint.h>
+
+#define FAV3_RING_MAX_BUFFERS   256
+
+/* A single readout buffer.  data is 8-byte aligned, so faV3ReadBlock never
+   has to insert a dummy word at the start of it. */
+typedef struct faV3RingBuf_struct
+{
+  volatile uint32_t *data;	/* Start of block data (8-byte aligned) */
+  int32_t maxwords;		/* Capacity of data in 32bit words */
+  int32_t nwords;		/* Words written by faV3ReadBlock */
+  int32_t blockError;		/* FAV3_BLOCKERROR_* of this transfer */
+  uint32_t seq;			/* Fill sequence number */
+  volatile int32_t refcnt;	/* References held by consumers */
+  int32_t index;		/* Position in the ring */
+  void *node;			/* DMANODE backing this buffer */
+} faV3RingBuf_t;
+
+int32_t faV3RingCreate(int32_t nbuf, int32_t maxwords);
+int32_t faV3RingDestroy();
+int32_t faV3RingFill(int32_t id, int32_t rflag, int32_t timeout_us);
+faV3RingBuf_t *faV3RingBorrow(int32_t timeout_us);
+faV3RingBuf_t *faV3RingRetain(faV3RingBuf_t * buf);
+int32_t faV3RingRelease(faV3RingBuf_t * buf);
+int32_t faV3RingStatus(int32_t pflag);
@@ -0,0 +1,645 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ScalerMon.c
+ *
+ * @brief     Background scaler rate monitor.
+ *
+ *            A thread latches the scalers of every initialized board once
+ *            a period, reads back the 16 channels and time_count, turns
+ *            the change since the last sample into rates, and keeps the
+ *            samples in a fixed size ring for each board.
+ *
+ *            The slot lock that the readout takes is only held for the
+ *            latch write, and then for FAV3_SCALMON_WORDS_PER_LOCK reads
+ *            at a time, so readout never waits on the monitor for more
+ *            than a few VME cycles.  Every latch or clear in the library
+ *            bumps faV3ScalerLatchCount under the slot lock, so if the
+ *            readout latches in between, the reads start over and the
+ *            sample still comes from a single latch.  If that keeps
+ *            happening for FAV3_SCALMON_RETRIES tries, the sample is
+ *            dropped and counted.
+ *
+ *            Between the readout's faV3LatchScalers and its
+ *            faV3ReadScalers, a latch by the monitor would replace the
+ *            counts the readout is about to read.  The monitor then does
+ *            not latch, and reads the readout's latch instead.
+ *
+ *            time_count is 32 bits, and its change is taken modulo 2^32,
+ *            so a wrap is not a reset.  A reset is a scaler clear by the
+ *            library (faV3ScalerClearCount), or a change larger than
+ *            twice the host time since the previous sample plus a second
+ *            (a clear the library did not see, such as a board reset).
+ *
+ *            Each ring entry is guarded by a sequence count, odd while it
+ *            is written.  Readers copy the entry and retry if the count
+ *            moved, so faV3ScalerMonGetLatest and faV3ScalerMonGetHistory
+ *            take no lock and never touch the bus.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3ScalerMon.h"
+
+extern pthread_mutex_t faV3SlotMutex[FAV3_MAX_BOARDS + 2];
+
+#define FAV3SLOTLOCK(_id)   if(pthread_mutex_lock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_lock");
+#define FAV3SLOTUNLOCK(_id) if(pthread_mutex_unlock(&faV3SlotMutex[_id])<0) perror("pthread_mutex_unlock");
+
+extern int nfaV3;
+extern int faV3ID[FAV3_MAX_BOARDS];
+extern volatile faV3_t *FAV3p[(FAV3_MAX_BOARDS + 1)];	/* pointers to FAV3 memory map */
+extern uint32_t faV3ScalerLatchCount[(FAV3_MAX_BOARDS + 1)];
+extern uint32_t faV3ScalerClearCount[(FAV3_MAX_BOARDS + 1)];
+extern int faV3ScalerLatchPending[(FAV3_MAX_BOARDS + 1)];
+
+#define FAV3_SCALMON_NWORDS  (FAV3_MAX_ADC_CHANNELS + 1)	/* + time_count */
+#define FAV3_SCALMON_RETRIES 3
+
+typedef struct
+{
+  volatile uint32_t lock;	/* odd while the sample is written */
+  faV3ScalerSample_t s;
+} faV3ScalerMonEntry_t;
+
+typedef struct
+{
+  int32_t id;
+  faV3ScalerMonEntry_t *ring;
+  volatile uint32_t head;	/* samples written */
+  uint32_t prev_counts[16];
+  uint32_t prev_time;
+  uint64_t prev_us;		/* host time of the previous sample */
+  uint32_t prev_clears;		/* faV3ScalerClearCount at the previous sample */
+  uint32_t max_hold_ns;		/* longest slot lock hold */
+  uint32_t nreset;
+  uint32_t nrelatch;		/* reads started over after another latch */
+  uint32_t nshared;		/* samples read from the readout's latch */
+  uint32_t ndropped;		/* samples dropped, latched over every try */
+} faV3ScalerMonBoard_t;
+
+typedef struct
+{
+  int32_t created;
+  int32_t quit;
+  uint32_t period_ms;
+  uint32_t tick_ns;
+  uint32_t depth;		/* power of 2 */
+  int32_t nboard;
+  faV3ScalerMonBoard_t board[FAV3_MAX_BOARDS];
+  int32_t slot2board[FAV3_MAX_BOARDS + 2];	/* -1 if not monitored */
+  uint32_t nlate;		/* periods that started late */
+  pthread_t thread;
+} faV3ScalerMon_t;
+
+static faV3ScalerMon_t faV3ScalerMon;
+
+pthread_mutex_t faV3ScalerMonMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t faV3ScalerMonCond = PTHREAD_COND_INITIALIZER;
+#define SMONLOCK      if(pthread_mutex_lock(&faV3ScalerMonMutex)<0) perror("pthread_mutex_lock");
+#define SMONUNLOCK    if(pthread_mutex_unlock(&faV3ScalerMonMutex)<0) perror("pthread_mutex_unlock");
+
+static uint64_t
+faV3ScalerMonNs(clockid_t clk)
+{
+  struct timespec ts;
+
+  clock_gettime(clk, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Latch and read one board.  The longest slot lock hold goes in hold
+   (ns), and the clear count of the latch read in clears.  ERROR if the
+   counts were latched over on every try. */
+static int32_t
+faV3ScalerMonRead(faV3ScalerMonBoard_t * b, uint32_t * words,
+		  uint64_t * time_us, uint32_t * clears, uint32_t * hold)
+{
+  int32_t id = b->id;
+  volatile uint32_t *src = (volatile uint32_t *) &FAV3p[id]->scalers;
+  uint64_t t0, t;
+  uint32_t latch;
+  int32_t iw, jw, itry;
+
+  t0 = faV3ScalerMonNs(CLOCK_MONOTONIC);
+  FAV3SLOTLOCK(id);
+  if(faV3ScalerLatchPending[id])
+    {
+      /* The readout has latched and not read yet: use its latch */
+      latch = faV3ScalerLatchCount[id];
+      b->nshared++;
+    }
+  else
+    {
+      vmeWrite32(&FAV3p[id]->scaler_ctrl,
+		 FAV3_SCALER_CTRL_ENABLE | FAV3_SCALER_CTRL_LATCH);
+      latch = ++faV3ScalerLatchCount[id];
+    }
+  *clears = faV3ScalerClearCount[id];
+  FAV3SLOTUNLOCK(id);
+  *hold = faV3ScalerMonNs(CLOCK_MONOTONIC) - t0;
+  *time_us = faV3ScalerMonNs(CLOCK_REALTIME) / 1000;
+
+  for(itry = 0; itry < FAV3_SCALMON_RETRIES; itry++)
+    {
+      for(iw = 0; iw < FAV3_SCALMON_NWORDS;
+	  iw += FAV3_SCALMON_WORDS_PER_LOCK)
+	{
+	  t0 = faV3ScalerMonNs(CLOCK_MONOTONIC);
+	  FAV3SLOTLOCK(id);
+	  if(faV3ScalerLatchCount[id] != latch)
+	    {
+	      /* Someone else latched, read their latch from the start */
+	      latch = faV3ScalerLatchCount[id];
+	      *clears = faV3ScalerClearCount[id];
+	      FAV3SLOTUNLOCK(id);
+	      break;
+	    }
+	  for(jw = iw; (jw < iw + FAV3_SCALMON_WORDS_PER_LOCK) &&
+		(jw < FAV3_SCALMON_NWORDS); jw++)
+	    words[jw] = vmeRead32(&src[jw]);
+	  FAV3SLOTUNLOCK(id);
+	  t = faV3ScalerMonNs(CLOCK_MONOTONIC) - t0;
+	  if(t > *hold)
+	    *hold = t;
+	}
+      if(iw >= FAV3_SCALMON_NWORDS)
+	return OK;
+      b->nrelatch++;
+    }
+
+  /* The words are from more than one latch */
+  return ERROR;
+}
+
+static void
+faV3ScalerMonSample(faV3ScalerMonBoard_t * b, uint32_t tick_ns)
+{
+  uint32_t words[FAV3_SCALMON_NWORDS];
+  faV3ScalerSample_t s;
+  faV3ScalerMonEntry_t *e;
+  uint32_t head, hold = 0, clears, dt, dc, lock;
+  uint64_t elapsed;
+  double secs;
+  int32_t ichan, rval;
+
+  memset(&s, 0, sizeof(s));
+
+  rval = faV3ScalerMonRead(b, words, &s.time_us, &clears, &hold);
+  if(hold > b->max_hold_ns)
+    b->max_hold_ns = hold;
+  if(rval != OK)
+    {
+      b->ndropped++;
+      return;
+    }
+
+  head = b->head;
+  s.seq = head;
+  memcpy(s.counts, words, sizeof(s.counts));
+  s.time_count = words[FAV3_MAX_ADC_CHANNELS];
+
+  if(head > 0)
+    {
+      /* Ticks since the previous sample, modulo 2^32 across a wrap.  More
+         than twice the host time (plus a second, for scheduling) means
+         the timer went back. */
+      dt = s.time_count - b->prev_time;
+      elapsed = ((s.time_us - b->prev_us) * 2 + 1000000) * 1000 / tick_ns;
+      if((clears != b->prev_clears) || ((uint64_t) dt > elapsed))
+	{
+	  s.flags |= FAV3_SCALMON_TIMER_RESET;
+	  memset(b->prev_counts, 0, sizeof(b->prev_counts));
+	  b->prev_time = 0;
+	  b->nreset++;
+	}
+
+      dt = s.time_count - b->prev_time;
+      if(dt > 0)
+	{
+	  secs = (double) dt * tick_ns * 1e-9;
+	  for(ichan = 0; ichan < 16; ichan++)
+	    {
+	      dc = s.counts[ichan] - b->prev_counts[ichan];
+	      s.rate[ichan] = (float) (dc / secs);
+	    }
+	  s.flags |= FAV3_SCALMON_RATE_VALID;
+	}
+    }
+
+  memcpy(b->prev_counts, s.counts, sizeof(b->prev_counts));
+  b->prev_time = s.time_count;
+  b->prev_us = s.time_us;
+  b->prev_clears = clears;
+
+  /* Only this thread writes, readers check the entry lock */
+  e = &b->ring[head & (faV3ScalerMon.depth - 1)];
+  lock = e->lock;
+  __atomic_store_n(&e->lock, lock + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy((void *) &e->s, &s, sizeof(s));
+  __atomic_store_n(&e->lock, lock + 2, __ATOMIC_RELEASE);
+
+  __atomic_store_n(&b->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void *
+faV3ScalerMonThread(void *arg)
+{
+  struct timespec ts;
+  uint64_t start, next;
+  uint32_t tick_ns;
+  int32_t ib;
+
+  SMONLOCK;
+  while(!faV3ScalerMon.quit)
+    {
+      tick_ns = faV3ScalerMon.tick_ns;
+      SMONUNLOCK;
+
+      start = faV3ScalerMonNs(CLOCK_REALTIME);
+      for(ib = 0; ib < faV3ScalerMon.nboard; ib++)
+	faV3ScalerMonSample(&faV3ScalerMon.board[ib], tick_ns);
+
+      SMONLOCK;
+      if(faV3ScalerMonNs(CLOCK_REALTIME) >=
+	 start + (uint64_t) faV3ScalerMon.period_ms * 1000000ULL)
+	faV3ScalerMon.nlate++;
+
+      /* The period is looked at again after a faV3ScalerMonSetPeriod */
+      while(!faV3ScalerMon.quit)
+	{
+	  next = start + (uint64_t) faV3ScalerMon.period_ms * 1000000ULL;
+	  if(faV3ScalerMonNs(CLOCK_REALTIME) >= next)
+	    break;
+	  ts.tv_sec = next / 1000000000ULL;
+	  ts.tv_nsec = next % 1000000000ULL;
+	  pthread_cond_timedwait(&faV3ScalerMonCond, &faV3ScalerMonMutex, &ts);
+	}
+    }
+  SMONUNLOCK;
+
+  return NULL;
+}
+
+static void
+faV3ScalerMonFree()
+{
+  int32_t ib;
+
+  for(ib = 0; ib < faV3ScalerMon.nboard; ib++)
+    if(faV3ScalerMon.board[ib].ring)
+      free(faV3ScalerMon.board[ib].ring);
+
+  memset(&faV3ScalerMon, 0, sizeof(faV3ScalerMon));
+}
+
+/**
+ * @brief Start the scaler monitor on every initialized board
+ *
+ * @param period_ms Time between samples, at least FAV3_SCALMON_MIN_PERIOD_MS
+ * @param depth     Samples kept for each board, rounded up to a power of 2
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ScalerMonCreate(uint32_t period_ms, int32_t depth)
+{
+  faV3ScalerMonBoard_t *b;
+  uint32_t n;
+  int32_t ifa, id;
+
+  if(period_ms < FAV3_SCALMON_MIN_PERIOD_MS)
+    {
+      printf("%s: ERROR: Invalid period (%u ms)\n", __func__, period_ms);
+      return ERROR;
+    }
+
+  if((depth <= 0) || (depth > FAV3_SCALMON_MAX_DEPTH))
+    {
+      printf("%s: ERROR: Invalid depth (%d)\n", __func__, depth);
+      return ERROR;
+    }
+
+  if(nfaV3 <= 0)
+    {
+      printf("%s: ERROR: No initialized boards\n", __func__);
+      return ERROR;
+    }
+
+  SMONLOCK;
+  if(faV3ScalerMon.created)
+    {
+      printf("%s: ERROR: Scaler monitor already created\n", __func__);
+      SMONUNLOCK;
+      return ERROR;
+    }
+
+  memset(&faV3ScalerMon, 0, sizeof(faV3ScalerMon));
+  for(n = 1; n < (uint32_t) depth; n <<= 1);
+  faV3ScalerMon.depth = n;
+  faV3ScalerMon.period_ms = period_ms;
+  faV3ScalerMon.tick_ns = FAV3_SCALMON_TIMER_NS;
+
+  for(id = 0; id < FAV3_MAX_BOARDS + 2; id++)
+    faV3ScalerMon.slot2board[id] = -1;
+
+  for(ifa = 0; ifa < nfaV3; ifa++)
+    {
+      id = faV3ID[ifa];
+      if((id <= 0) || (id > 21) || (FAV3p[id] == NULL))
+	continue;
+
+      b = &faV3ScalerMon.board[faV3ScalerMon.nboard];
+      b->id = id;
+      b->ring = calloc(faV3ScalerMon.depth, sizeof(faV3ScalerMonEntry_t));
+      if(b->ring == NULL)
+	{
+	  printf("%s: ERROR: Unable to allocate history for slot %d\n",
+		 __func__, id);
+	  faV3ScalerMonFree();
+	  SMONUNLOCK;
+	  return ERROR;
+	}
+      faV3ScalerMon.slot2board[id] = faV3ScalerMon.nboard++;
+    }
+
+  faV3ScalerMon.created = 1;
+
+  if(pthread_create(&faV3ScalerMon.thread, NULL, faV3ScalerMonThread, NULL)
+     != 0)
+    {
+      perror("pthread_create");
+      printf("%s: ERROR: Unable to start the monitor thread\n", __func__);
+      faV3ScalerMonFree();
+      SMONUNLOCK;
+      return ERROR;
+    }
+  SMONUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Stop the scaler monitor and free the history
+ *
+ *   No faV3ScalerMonGet call may be in progress.
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ScalerMonDestroy()
+{
+  SMONLOCK;
+  if(!faV3ScalerMon.created)
+    {
+      SMONUNLOCK;
+      return OK;
+    }
+
+  faV3ScalerMon.quit = 1;
+  pthread_cond_signal(&faV3ScalerMonCond);
+  SMONUNLOCK;
+
+  pthread_join(faV3ScalerMon.thread, NULL);
+
+  SMONLOCK;
+  faV3ScalerMonFree();
+  SMONUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Change the time between samples
+ *
+ * @param period_ms Time between samples, at least FAV3_SCALMON_MIN_PERIOD_MS
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ScalerMonSetPeriod(uint32_t period_ms)
+{
+  if(period_ms < FAV3_SCALMON_MIN_PERIOD_MS)
+    {
+      printf("%s: ERROR: Invalid period (%u ms)\n", __func__, period_ms);
+      return ERROR;
+    }
+
+  SMONLOCK;
+  if(!faV3ScalerMon.created)
+    {
+      printf("%s: ERROR: Scaler monitor not created\n", __func__);
+      SMONUNLOCK;
+      return ERROR;
+    }
+
+  faV3ScalerMon.period_ms = period_ms;
+  pthread_cond_signal(&faV3ScalerMonCond);
+  SMONUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Set the period of a time_count tick, used for the rates
+ *
+ * @param tick_ns Tick in ns, 0 for FAV3_SCALMON_TIMER_NS
+ *
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3ScalerMonSetTimerTick(uint32_t tick_ns)
+{
+  SMONLOCK;
+  if(!faV3ScalerMon.created)
+    {
+      printf("%s: ERROR: Scaler monitor not created\n", __func__);
+      SMONUNLOCK;
+      return ERROR;
+    }
+
+  faV3ScalerMon.tick_ns = tick_ns ? tick_ns : FAV3_SCALMON_TIMER_NS;
+  SMONUNLOCK;
+
+  return OK;
+}
+
+static faV3ScalerMonBoard_t *
+faV3ScalerMonBoard(int32_t id)
+{
+  int32_t ib;
+
+  if(!faV3ScalerMon.created)
+    {
+      printf("%s: ERROR: Scaler monitor not created\n", __func__);
+      return NULL;
+    }
+
+  if(id == 0)
+    id = faV3ID[0];
+
+  if((id <= 0) || (id > 21) || ((ib = faV3ScalerMon.slot2board[id]) < 0))
+    {
+      printf("%s: ERROR: Slot %d is not monitored\n", __func__, id);
+      return NULL;
+    }
+
+  return &faV3ScalerMon.board[ib];
+}
+
+/* Copy out sample number seq.  ERROR if it has been overwritten. */
+static int32_t
+faV3ScalerMonCopy(faV3ScalerMonBoard_t * b, uint32_t seq,
+		  faV3ScalerSample_t * out)
+{
+  faV3ScalerMonEntry_t *e = &b->ring[seq & (faV3ScalerMon.depth - 1)];
+  uint32_t l1, l2;
+
+  for(;;)
+    {
+      l1 = __atomic_load_n(&e->lock, __ATOMIC_ACQUIRE);
+      if(l1 & 1)
+	{
+	  sched_yield();
+	  continue;
+	}
+      memcpy(out, (const void *) &e->s, sizeof(*out));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      l2 = __atomic_load_n(&e->lock, __ATOMIC_RELAXED);
+      if(l1 == l2)
+	break;
+    }
+
+  return (out->seq == seq) ? OK : ERROR;
+}
+
+/**
+ * @brief Get the newest sample of a board
+ *
+ *   Takes no lock and does not touch the bus.
+ *
+ * @param id     Slot number
+ * @param sample Where to copy the sample
+ *
+ * @return OK if successful, ERROR if there is no sample yet
+ */
+int32_t
+faV3ScalerMonGetLatest(int32_t id, faV3ScalerSample_t * sample)
+{
+  faV3ScalerMonBoard_t *b;
+  uint32_t head;
+
+  if(sample == NULL)
+    return ERROR;
+
+  if((b = faV3ScalerMonBoard(id)) == NULL)
+    return ERROR;
+
+  head = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+  if(head == 0)
+    return ERROR;
+
+  return faV3ScalerMonCopy(b, head - 1, sample);
+}
+
+/**
+ * @brief Get the history of a board, newest sample first
+ *
+ *   Takes no lock and does not touch the bus.
+ *
+ * @param id      Slot number
+ * @param samples Where to copy the samples
+ * @param max     Room in samples
+ *
+ * @return Number of samples copied, or ERROR
+ */
+int32_t
+faV3ScalerMonGetHistory(int32_t id, faV3ScalerSample_t * samples, int32_t max)
+{
+  faV3ScalerMonBoard_t *b;
+  uint32_t head, n, i;
+
+  if((samples == NULL) || (max < 0))
+    return ERROR;
+
+  if((b = faV3ScalerMonBoard(id)) == NULL)
+    return ERROR;
+
+  head = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+  n = head;
+  if(n > faV3ScalerMon.depth)
+    n = faV3ScalerMon.depth;
+  if(n > (uint32_t) max)
+    n = max;
+
+  /* The oldest may be overwritten while copying */
+  for(i = 0; i < n; i++)
+    if(faV3ScalerMonCopy(b, head - 1 - i, &samples[i]) != OK)
+      break;
+
+  return i;
+}
+
+/**
+ * @brief Print the state of the scaler monitor and the newest rates
+ *
+ * @param pflag Print if not zero
+ *
+ * @return Number of monitored boards
+ */
+int32_t
+faV3ScalerMonStatus(int32_t pflag)
+{
+  faV3ScalerMonBoard_t *b;
+  faV3ScalerSample_t s;
+  int32_t ib, ichan, rval;
+
+  SMONLOCK;
+  rval = faV3ScalerMon.nboard;
+
+  if(pflag)
+    {
+      printf("faV3ScalerMon: %s\n",
+	     faV3ScalerMon.created ? "created" : "not created");
+      if(faV3ScalerMon.created)
+	{
+	  printf("  Period      %10u ms  (%u late)\n",
+		 faV3ScalerMon.period_ms, faV3ScalerMon.nlate);
+	  printf("  Timer tick  %10u ns\n", faV3ScalerMon.tick_ns);
+	  printf("  History     %10u samples per board\n",
+		 faV3ScalerMon.depth);
+	  for(ib = 0; ib < faV3ScalerMon.nboard; ib++)
+	    {
+	      b = &faV3ScalerMon.board[ib];
+	      printf("  Slot %2d  %10u samples  %u timer resets  %u reread"
+		     "  %u dropped  %u from readout latch"
+		     "  longest lock %u ns\n", b->id, b->head, b->nreset,
+		     b->nrelatch, b->ndropped, b->nshared, b->max_hold_ns);
+	      if((b->head == 0) || (faV3ScalerMonCopy(b, b->head - 1, &s) != OK)
+		 || !(s.flags & FAV3_SCALMON_RATE_VALID))
+		continue;
+	      for(ichan = 0; ichan < 16; ichan++)
+		{
+		  if((ichan % 4) == 0)
+		    printf("   ");
+		  printf("  %2d: %10.1f Hz", ichan, s.rate[ichan]);
+		  if((ichan % 4) == 3)
+		    printf("\n");
+		}
+	    }
+	}
+    }
+  SMONUNLOCK;
+
+  return rval;
+}
@@ -0,0 +1,43 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3ScalerMon.h
+ *
+ * @brief     Header for the background scaler rate monitor
+ *
+ */
+
+#include <stdint.h>
+
+#define FAV3_SCALMON_MIN_PERIOD_MS  10
+#define FAV3_SCALMON_MAX_DEPTH      65536
+#define FAV3_SCALMON_TIMER_NS       2048	/* default time_count tick */
+#define FAV3_SCALMON_WORDS_PER_LOCK 4	/* scaler reads per slot lock hold */
+
+/* Sample flags */
+#define FAV3_SCALMON_RATE_VALID     (1 << 0)	/* rates are from the previous
+						   sample */
+#define FAV3_SCALMON_TIMER_RESET    (1 << 1)	/* scalers cleared, rates are
+						   since the clear */
+
+typedef struct faV3ScalerSample_struct
+{
+  uint32_t seq;			/* sample number of this board, from 0 */
+  uint32_t flags;
+  uint64_t time_us;		/* host time of the latch, CLOCK_REALTIME */
+  uint32_t counts[16];		/* latched scalers */
+  uint32_t time_count;		/* latched timer */
+  float rate[16];		/* Hz */
+} faV3ScalerSample_t;
+
+int32_t faV3ScalerMonCreate(uint32_t period_ms, int32_t depth);
+int32_t faV3ScalerMonDestroy();
+int32_t faV3ScalerMonSetPeriod(uint32_t period_ms);
+int32_t faV3ScalerMonSetTimerTick(uint32_t tick_ns);
+int32_t faV3ScalerMonGetLatest(int32_t id, faV3ScalerSample_t * sample);
+int32_t faV3ScalerMonGetHistory(int32_t id, faV3ScalerSample_t * samples,
+				int32_t max);
+int32_t faV3ScalerMonStatus(int32_t pflag);
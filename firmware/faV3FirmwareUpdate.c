@@ -207,10 +207,7 @@ main(int argc, char *argv[])
       if(faV3FirmwareReadFile(fw_filename) != OK)
 	goto CLOSE;
 
-      if(faV3FirmwareDownload(0, 1) != OK)
-	goto CLOSE;
-
-      if(faV3FirmwareVerify(0, 1) != OK)
+      if(faV3FirmwareVerifyRom(0) != OK)
 	goto CLOSE;
     }
   else if(save)
@@ -0,0 +1,195 @@
+/*
+ * File:
+ *    faV3BlockReadyBench.c
+ *
+ * Description:
+ *    Block-ready wait benchmark, on the emulated VME bus.
+ *
+ *    A source thread sets the block-ready bit in the csr of the board in
+ *    slot 3 at a fixed rate, and raises the interrupt.  The readout thread
+ *    waits for it, clears it, and records the wakeup latency (from the bit
+ *    being set to the wait returning) and its own CPU time.
+ *
+ *    Waits:
+ *      spin     faV3GBlockReady in a loop, as readout lists did
+ *      backoff  faV3BlockReadyWait, interrupts not connected
+ *      irq      faV3BlockReadyWait, woken by the interrupt
+ *
+ *    Usage:
+ *      faV3BlockReadyBench [-c <cycle ns>] [-t <seconds per point>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3BusEmu.h"
+
+#define SLOT      3
+#define MAXEVENTS (1 << 20)
+
+#define WAIT_SPIN     0
+#define WAIT_BACKOFF  1
+#define WAIT_IRQ      2
+
+static volatile int32_t running = 0;
+static volatile double tReady = 0;
+static int32_t sourcePeriodUs = 0, sourceIrq = 0;
+static double latency[MAXEVENTS];
+
+static volatile uint32_t *csr;
+
+static double
+threadCpu()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/* Block ready every sourcePeriodUs, unless the last one was not taken */
+static void *
+sourceThread(void *arg)
+{
+  struct timespec next;
+  int64_t ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while(running)
+    {
+      ns = next.tv_nsec + 1000 * (int64_t) sourcePeriodUs;
+      next.tv_sec += ns / 1000000000;
+      next.tv_nsec = ns % 1000000000;
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+      if(*csr & FAV3_CSR_BLOCK_READY)
+	continue;
+
+      tReady = faV3BusEmuTime();
+      __sync_fetch_and_or(csr, FAV3_CSR_BLOCK_READY);
+      if(sourceIrq)
+	faV3BusEmuInterrupt();
+    }
+
+  return NULL;
+}
+
+static int
+cmpDouble(const void *a, const void *b)
+{
+  double da = *(const double *) a, db = *(const double *) b;
+
+  return (da > db) - (da < db);
+}
+
+static void
+runPoint(int32_t wait, int32_t period_us, double seconds)
+{
+  const char *name[3] = { "spin", "backoff", "irq" };
+  pthread_t th;
+  double end, cpu0, cpu;
+  int32_t nevt = 0, nmiss = 0;
+  uint32_t mask;
+
+  *csr &= ~FAV3_CSR_BLOCK_READY;
+  sourcePeriodUs = period_us;
+  sourceIrq = (wait == WAIT_IRQ);
+  if(wait == WAIT_IRQ)
+    {
+      faV3IntConnect(0, 0, NULL, 0);
+      faV3IntEnable(SLOT);
+    }
+
+  running = 1;
+  pthread_create(&th, NULL, sourceThread, NULL);
+
+  cpu0 = threadCpu();
+  end = faV3BusEmuTime() + seconds;
+  while((faV3BusEmuTime() < end) && (nevt < MAXEVENTS))
+    {
+      if(wait == WAIT_SPIN)
+	{
+	  mask = 0;
+	  while((mask != (1 << SLOT)) && (faV3BusEmuTime() < end))
+	    mask = faV3GBlockReady(1 << SLOT, 100);
+	}
+      else
+	mask = faV3BlockReadyWait(1 << SLOT, 100000);
+
+      if(mask != (1 << SLOT))
+	{
+	  nmiss++;
+	  continue;
+	}
+
+      latency[nevt++] = faV3BusEmuTime() - tReady;
+      __sync_fetch_and_and(csr, ~FAV3_CSR_BLOCK_READY);
+    }
+  cpu = threadCpu() - cpu0;
+
+  running = 0;
+  pthread_join(th, NULL);
+
+  if(wait == WAIT_IRQ)
+    faV3IntDisconnect();
+
+  if(nevt == 0)
+    {
+      printf("%-8s  %7d  no events\n", name[wait], 1000000 / period_us);
+      return;
+    }
+
+  qsort(latency, nevt, sizeof(double), cmpDouble);
+  printf("%-8s  %7d  %7d  %8.1f  %8.1f  %8.1f  %6.1f%%  %d\n", name[wait],
+	 1000000 / period_us, nevt, 1e6 * latency[nevt / 2],
+	 1e6 * latency[(nevt * 99) / 100], 1e6 * latency[nevt - 1],
+	 100 * cpu / seconds, nmiss);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t periods[4] = { 10000, 1000, 100, 20 };
+  int32_t cycle = 500, iper, wait, opt;
+  double seconds = 1.0;
+
+  while((opt = getopt(argc, argv, "c:t:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 't':
+	  seconds = atof(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-t <seconds per point>]\n",
+		 argv[0]);
+	  exit(1);
+	}
+    }
+
+  faV3BusEmuInit(1 << SLOT);
+  if(faV3Init(SLOT << 19, 1 << 19, 1, FAV3_INIT_SKIP) != 1)
+    exit(1);
+  faV3BusEmuSetCycle(cycle);
+  csr = faV3BusEmuReg(SLOT, offsetof(faV3_t, csr));
+
+  printf("\n%d ns single cycles.  Latency in us, CPU of the readout thread."
+	 "\n\n", cycle);
+  printf("wait         rate   events    median       p99       max     CPU"
+	 "  timeouts\n");
+  for(iper = 0; iper < 4; iper++)
+    for(wait = WAIT_SPIN; wait <= WAIT_IRQ; wait++)
+      runPoint(wait, periods[iper], seconds);
+
+  exit(0);
+}
@@ -0,0 +1,552 @@
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3BusEmu.c
+ *
+ * @brief     Emulated VME bus for the offline test and benchmark programs
+ *
+ *            A24: a register map in host memory for each board of the
+ *              slotmask, at slot << 19.  Registers read back what was
+ *              written, except where a faV3BusEmuRegFunc changes them.
+ *              The board ID, slot and firmware versions are set, so that
+ *              faV3Init finds the boards.
+ *
+ *            A32: reserved but not mapped.  Only DMA is emulated: the
+ *              faV3BusEmuDmaFunc fills the buffer when the transfer is
+ *              started, and vmeDmaDone returns once the time the transfer
+ *              would take has passed.  The CPU is free meanwhile, as with
+ *              the DMA engine of the VME bridge.
+ *
+ *            A24 DMA (vmeDmaConfig address type 1): copies the register
+ *              map in VME byte order (16 bit registers at 0x100 - 0x29F),
+ *              with the same timing, and passes each word read to the
+ *              faV3BusEmuRegFunc.
+ *
+ *            Single cycles are serialized on the bus, and each takes
+ *            faV3BusEmuSetCycle nanoseconds.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3BusEmu.h"
+
+extern volatile uint32_t *FAV3pd[(FAV3_MAX_BOARDS + 1)];
+extern volatile uint32_t *FAV3pmb;
+extern u_long faV3A32Offset;
+extern int faV3MaxSlot;
+
+static pthread_mutex_t emuBus = PTHREAD_MUTEX_INITIALIZER;
+static char *emuA24 = NULL, *emuA32 = NULL;
+static uint32_t emuSlotMask = 0;
+static int32_t emuCycleNs = 0;
+static faV3BusEmuRegFunc emuRegFunc = NULL;
+static faV3BusEmuCount_t emuCount;
+
+/* DMA engine */
+static faV3BusEmuDmaFunc emuDmaFunc = NULL;
+static int32_t emuDmaRate = 200;	/* MB/s */
+static int32_t emuDmaActive = 0, emuDmaBytes = 0;
+static uint32_t emuDmaAddrType = 2;	/* vmeDmaConfig: 1 A24, 2 A32 */
+static double emuDmaEnd = 0;
+
+#define FAV3_EMU_DMA_SETUP  2e-6	/* s, to program the DMA engine */
+
+/* Interrupt handler connected with vmeIntConnect */
+static VOIDFUNCPTR emuIntRoutine = NULL;
+static unsigned int emuIntArg = 0;
+
+typedef struct
+{
+  int32_t size, nitem, nfree;
+  DMANODE **node;
+} faV3BusEmuPool_t;
+
+double
+faV3BusEmuTime()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+double
+faV3BusEmuCpuTime()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+void
+faV3BusEmuSpin(double seconds)
+{
+  double end = faV3BusEmuTime() + seconds;
+
+  while(faV3BusEmuTime() < end);
+}
+
+/**
+ * @brief Set up the register maps
+ * @param slotmask Slots with a board
+ * @return OK if successful, otherwise ERROR
+ */
+int32_t
+faV3BusEmuInit(uint32_t slotmask)
+{
+  volatile faV3_t *fa;
+  int32_t slot;
+
+  if(emuA24 == NULL)
+    {
+      emuA24 = mmap(NULL, FAV3_EMU_A24_SIZE, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      emuA32 = mmap(NULL, FAV3_EMU_A32_SIZE, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if((emuA24 == MAP_FAILED) || (emuA32 == MAP_FAILED))
+	{
+	  perror("faV3BusEmuInit: mmap");
+	  emuA24 = emuA32 = NULL;
+	  return ERROR;
+	}
+    }
+
+  memset(emuA24, 0, FAV3_EMU_A24_SIZE);
+  emuSlotMask = slotmask & 0x3FFFFC;	/* slots 2-21 */
+
+  for(slot = 2; slot <= 21; slot++)
+    {
+      if(!(emuSlotMask & (1 << slot)))
+	continue;
+      fa = (volatile faV3_t *) (emuA24 + slot * FAV3_EMU_SLOT_SIZE);
+      fa->version = FAV3_BOARD_ID | FAV3_EMU_CTRL_VERSION;
+      fa->intr = slot << 16;
+      fa->adc.status0 = FAV3_EMU_PROC_VERSION;
+    }
+
+  faV3BusEmuClearCount();
+
+  return OK;
+}
+
+void
+faV3BusEmuSetCycle(int32_t cycle_ns)
+{
+  emuCycleNs = cycle_ns;
+}
+
+void
+faV3BusEmuSetRegFunc(faV3BusEmuRegFunc func)
+{
+  emuRegFunc = func;
+}
+
+void
+faV3BusEmuSetDmaFunc(faV3BusEmuDmaFunc func, int32_t mbytes_per_s)
+{
+  emuDmaFunc = func;
+  if(mbytes_per_s > 0)
+    emuDmaRate = mbytes_per_s;
+}
+
+/**
+ * @brief Direct access to a register, without a bus cycle
+ * @param slot Slot number
+ * @param offset Offset from the board base
+ */
+volatile uint32_t *
+faV3BusEmuReg(int32_t slot, uint32_t offset)
+{
+  return (volatile uint32_t *) (emuA24 + slot * FAV3_EMU_SLOT_SIZE + offset);
+}
+
+/**
+ * @brief Raise the interrupt connected with vmeIntConnect
+ */
+void
+faV3BusEmuInterrupt()
+{
+  if(emuIntRoutine != NULL)
+    (*emuIntRoutine) (emuIntArg);
+}
+
+void
+faV3BusEmuGetCount(faV3BusEmuCount_t * count)
+{
+  pthread_mutex_lock(&emuBus);
+  *count = emuCount;
+  pthread_mutex_unlock(&emuBus);
+}
+
+void
+faV3BusEmuClearCount()
+{
+  pthread_mutex_lock(&emuBus);
+  memset(&emuCount, 0, sizeof(emuCount));
+  pthread_mutex_unlock(&emuBus);
+}
+
+/* Slot and offset of an A24 address.  Returns 0 if there is no board. */
+static int32_t
+faV3BusEmuDecode(volatile void *addr, uint32_t * offset)
+{
+  u_long off = (u_long) addr - (u_long) emuA24;
+  int32_t slot;
+
+  if((emuA24 == NULL) || ((u_long) addr < (u_long) emuA24)
+     || (off >= FAV3_EMU_A24_SIZE))
+    {
+      fprintf(stderr, "faV3BusEmu: ERROR: %p is not in the emulated A24 space\n",
+	      addr);
+      abort();
+    }
+
+  slot = off / FAV3_EMU_SLOT_SIZE;
+  *offset = off % FAV3_EMU_SLOT_SIZE;
+
+  return (emuSlotMask & (1 << slot)) ? slot : 0;
+}
+
+static void
+faV3BusEmuCycle()
+{
+  if(emuCycleNs > 0)
+    faV3BusEmuSpin(1e-9 * emuCycleNs);
+}
+
+/* jvme routines used by the library */
+
+unsigned int
+vmeRead32(volatile unsigned int *addr)
+{
+  uint32_t offset, value = 0xFFFFFFFF;
+  int32_t slot = faV3BusEmuDecode(addr, &offset);
+
+  pthread_mutex_lock(&emuBus);
+  if(slot)
+    {
+      value = *addr;
+      if(emuRegFunc)
+	(*emuRegFunc) (slot, offset, 0, &value);
+    }
+  emuCount.nread++;
+  faV3BusEmuCycle();
+  pthread_mutex_unlock(&emuBus);
+
+  return value;
+}
+
+unsigned short
+vmeRead16(volatile unsigned short *addr)
+{
+  uint32_t offset, value = 0xFFFF;
+  int32_t slot = faV3BusEmuDecode(addr, &offset);
+
+  pthread_mutex_lock(&emuBus);
+  if(slot)
+    {
+      value = *addr;
+      if(emuRegFunc)
+	(*emuRegFunc) (slot, offset, 0, &value);
+    }
+  emuCount.nread++;
+  faV3BusEmuCycle();
+  pthread_mutex_unlock(&emuBus);
+
+  return (unsigned short) value;
+}
+
+void
+vmeWrite32(volatile unsigned int *addr, unsigned int val)
+{
+  uint32_t offset, value = val;
+  int32_t slot = faV3BusEmuDecode(addr, &offset);
+
+  pthread_mutex_lock(&emuBus);
+  if(slot)
+    {
+      *addr = val;
+      if(emuRegFunc)
+	(*emuRegFunc) (slot, offset, 1, &value);
+    }
+  emuCount.nwrite++;
+  faV3BusEmuCycle();
+  pthread_mutex_unlock(&emuBus);
+}
+
+void
+vmeWrite16(volatile unsigned short *addr, unsigned short val)
+{
+  uint32_t offset, value = val;
+  int32_t slot = faV3BusEmuDecode(addr, &offset);
+
+  pthread_mutex_lock(&emuBus);
+  if(slot)
+    {
+      *addr = val;
+      if(emuRegFunc)
+	(*emuRegFunc) (slot, offset, 1, &value);
+    }
+  emuCount.nwrite++;
+  faV3BusEmuCycle();
+  pthread_mutex_unlock(&emuBus);
+}
+
+int
+vmeMemProbe(char *addr, int size, char *rval)
+{
+  uint32_t offset;
+
+  if((emuA24 == NULL) || (addr < emuA24) || (addr >= emuA24 + FAV3_EMU_A24_SIZE))
+    return ERROR;
+  if(faV3BusEmuDecode(addr, &offset) == 0)
+    return ERROR;
+
+  pthread_mutex_lock(&emuBus);
+  memcpy(rval, addr, size);
+  emuCount.nread++;
+  faV3BusEmuCycle();
+  pthread_mutex_unlock(&emuBus);
+
+  return OK;
+}
+
+int
+vmeBusToLocalAdrs(int vmeAdrsSpace, char *vmeBusAdrs, char **pLocalAdrs)
+{
+  u_long vmeaddr = (u_long) vmeBusAdrs;
+
+  if((vmeAdrsSpace & 0xF0) == 0x30)
+    {				/* A24 */
+      if((emuA24 == NULL) || (vmeaddr >= FAV3_EMU_A24_SIZE))
+	return ERROR;
+      *pLocalAdrs = emuA24 + vmeaddr;
+      return OK;
+    }
+
+  if((vmeAdrsSpace & 0xF0) == 0x00)
+    {				/* A32 */
+      if((emuA32 == NULL) || (vmeaddr >= FAV3_EMU_A32_SIZE))
+	return ERROR;
+      *pLocalAdrs = emuA32 + vmeaddr;
+      return OK;
+    }
+
+  return ERROR;			/* No A16 (SDC) */
+}
+
+int
+vmeDmaConfig(unsigned int addrType, unsigned int dataType, unsigned int sstMode)
+{
+  emuDmaAddrType = addrType;
+
+  return OK;
+}
+
+/* A24 block read of registers, into locAdrs as the bridge would put it */
+static int32_t
+faV3BusEmuDmaA24(uint32_t * dst, uint32_t vmeAdrs, int32_t nwords)
+{
+  uint32_t offset, value;
+  int32_t slot, iword;
+
+  if(vmeAdrs + (nwords << 2) > FAV3_EMU_A24_SIZE)
+    return -1;
+
+  slot = vmeAdrs / FAV3_EMU_SLOT_SIZE;
+  offset = vmeAdrs % FAV3_EMU_SLOT_SIZE;
+  if(!(emuSlotMask & (1 << slot)))
+    return -1;
+
+  pthread_mutex_lock(&emuBus);
+  for(iword = 0; iword < nwords; iword++, offset += 4)
+    {
+      value = *faV3BusEmuReg(slot, offset);
+      if(emuRegFunc)
+	(*emuRegFunc) (slot, offset, 0, &value);
+      if((offset >= 0x100) && (offset < 0x2A0))	/* two 16 bit registers */
+	dst[iword] = ((value & 0xFF00FF00) >> 8) | ((value & 0x00FF00FF) << 8);
+      else
+	dst[iword] = LSWAP(value);
+    }
+  pthread_mutex_unlock(&emuBus);
+
+  return nwords;
+}
+
+int
+vmeDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size)
+{
+  int32_t slot = -1, id, nwords = size >> 2, nread = 0;
+
+  if(emuDmaActive)
+    return ERROR;
+
+  if(emuDmaAddrType == 1)
+    {
+      nread = faV3BusEmuDmaA24((uint32_t *) locAdrs, vmeAdrs, nwords);
+      if(nread < 0)
+	return ERROR;
+      goto started;
+    }
+
+  for(id = 1; id <= FAV3_MAX_BOARDS; id++)
+    if((FAV3pd[id] != NULL)
+       && ((u_long) FAV3pd[id] - faV3A32Offset == vmeAdrs))
+      slot = id;
+  if((FAV3pmb != NULL) && ((u_long) FAV3pmb - faV3A32Offset == vmeAdrs))
+    slot = 0;
+  if(slot < 0)
+    return ERROR;
+
+  if(emuDmaFunc)
+    nread = (*emuDmaFunc) (slot, (uint32_t *) locAdrs, nwords);
+  if(nread < nwords)
+    {
+      /* Ended by the bus error from the last board */
+      id = slot ? slot : faV3MaxSlot;
+      *faV3BusEmuReg(id, offsetof(faV3_t, csr)) |= FAV3_CSR_BERR_STATUS;
+    }
+
+started:
+  pthread_mutex_lock(&emuBus);
+  emuCount.ndma++;
+  emuCount.dma_bytes += nread << 2;
+  pthread_mutex_unlock(&emuBus);
+
+  emuDmaBytes = nread << 2;
+  emuDmaEnd = faV3BusEmuTime() + FAV3_EMU_DMA_SETUP
+    + emuDmaBytes / (emuDmaRate * 1e6);
+  emuDmaActive = 1;
+
+  return OK;
+}
+
+int
+vmeDmaDone()
+{
+  double remaining;
+
+  if(!emuDmaActive)
+    return ERROR;
+
+  /* Sleep through most of it, as the bridge driver does */
+  remaining = emuDmaEnd - faV3BusEmuTime();
+  if(remaining > 100e-6)
+    {
+      struct timespec t;
+      remaining -= 50e-6;
+      t.tv_sec = (time_t) remaining;
+      t.tv_nsec = (long) ((remaining - t.tv_sec) * 1e9);
+      nanosleep(&t, NULL);
+    }
+  while(faV3BusEmuTime() < emuDmaEnd);
+
+  emuDmaActive = 0;
+
+  return emuDmaBytes;
+}
+
+int
+vmeIntConnect(unsigned int vector, unsigned int level, VOIDFUNCPTR routine,
+	      unsigned int arg)
+{
+  emuIntRoutine = routine;
+  emuIntArg = arg;
+  return OK;
+}
+
+int
+vmeIntDisconnect(unsigned int level)
+{
+  emuIntRoutine = NULL;
+  return OK;
+}
+
+/* The emulated boards need no time to settle */
+int
+taskDelay(int ticks)
+{
+  return OK;
+}
+
+int
+logMsg(const char *format, ...)
+{
+  va_list args;
+  int rval;
+
+  va_start(args, format);
+  rval = vprintf(format, args);
+  va_end(args);
+
+  return rval;
+}
+
+/* DMA buffer pools (faV3Ring) */
+
+DMA_MEM_ID
+dmaPCreate(char *name, int size, int numItems, int incr)
+{
+  faV3BusEmuPool_t *pool;
+  void *data;
+  int32_t ii;
+
+  pool = calloc(1, sizeof(*pool));
+  pool->node = calloc(numItems, sizeof(DMANODE *));
+  pool->size = size;
+  for(ii = 0; ii < numItems; ii++)
+    {
+      pool->node[ii] = calloc(1, sizeof(DMANODE));
+      if(posix_memalign(&data, 64, size) != 0)
+	return NULL;
+      pool->node[ii]->data = data;
+    }
+  pool->nitem = pool->nfree = numItems;
+
+  return (DMA_MEM_ID) pool;
+}
+
+DMANODE *
+dmaPGetItem(DMA_MEM_ID pPart)
+{
+  faV3BusEmuPool_t *pool = (faV3BusEmuPool_t *) pPart;
+
+  if(pool->nfree == 0)
+    return NULL;
+
+  return pool->node[--pool->nfree];
+}
+
+void
+dmaPFreeItem(DMANODE * pItem)
+{
+  /* Nodes go back when the pool is freed */
+}
+
+void
+dmaPFree(DMA_MEM_ID pPart)
+{
+  faV3BusEmuPool_t *pool = (faV3BusEmuPool_t *) pPart;
+  int32_t ii;
+
+  for(ii = 0; ii < pool->nitem; ii++)
+    {
+      free((void *) pool->node[ii]->data);
+      free(pool->node[ii]);
+    }
+  free(pool->node);
+  free(pool);
+}
@@ -0,0 +1,58 @@
+#pragma once
+/**
+ * @copyright Copyright 2024, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      faV3BusEmu.h
+ *
+ * @brief     Emulated VME bus for the offline test and benchmark programs
+ *
+ *            Provides the jvme routines used by libfaV3 on register maps
+ *            in host memory, so that the library runs unchanged without a
+ *            crate.  Linked in place of -ljvme.
+ *
+ */
+
+#include <stdint.h>
+
+#define FAV3_EMU_A24_SIZE     0x01000000
+#define FAV3_EMU_A32_SIZE     0x10000000
+#define FAV3_EMU_SLOT_SIZE    0x80000	/* A24 address = slot << 19 */
+#define FAV3_EMU_CTRL_VERSION 0x20F	/* as FAV3_SUPPORTED_CTRL_FIRMWARE */
+#define FAV3_EMU_PROC_VERSION 0xE06	/* as FAV3_SUPPORTED_PROC_FIRMWARE */
+
+/* Bus cycles since faV3BusEmuClearCount */
+typedef struct faV3BusEmuCount_struct
+{
+  uint64_t nread;		/* single cycle reads, including probes */
+  uint64_t nwrite;		/* single cycle writes */
+  uint64_t ndma;		/* DMA transfers */
+  uint64_t dma_bytes;
+} faV3BusEmuCount_t;
+
+/* Called for each single cycle of a board, with the bus held: after a
+   write is stored in the register map, and before a read is returned
+   from it.  offset is from the board base, value may be changed. */
+typedef void (*faV3BusEmuRegFunc) (int32_t slot, uint32_t offset,
+				   int32_t write, uint32_t * value);
+
+/* Fills a DMA transfer from a board (slot), or from the multiblock window
+   (slot 0).  Returns the number of words put in data, at most nwords.
+   Fewer words than nwords ends the transfer with a bus error. */
+typedef int32_t (*faV3BusEmuDmaFunc) (int32_t slot, uint32_t * data,
+				      int32_t nwords);
+
+int32_t faV3BusEmuInit(uint32_t slotmask);
+void faV3BusEmuSetCycle(int32_t cycle_ns);
+void faV3BusEmuSetRegFunc(faV3BusEmuRegFunc func);
+void faV3BusEmuSetDmaFunc(faV3BusEmuDmaFunc func, int32_t mbytes_per_s);
+volatile uint32_t *faV3BusEmuReg(int32_t slot, uint32_t offset);
+void faV3BusEmuInterrupt();
+void faV3BusEmuGetCount(faV3BusEmuCount_t * count);
+void faV3BusEmuClearCount();
+
+/* Helpers for the benchmarks */
+double faV3BusEmuTime();
+double faV3BusEmuCpuTime();
+void faV3BusEmuSpin(double seconds);
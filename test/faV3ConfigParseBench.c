@@ -0,0 +1,362 @@
+/*
+ * File:
+ *    faV3ConfigParseBench.c
+ *
+ * Description:
+ *    Time of faV3ReadConfigFile on a generated multi-crate file, one
+ *    FAV3_CRATE section per ROC, and checks of the result, with 16
+ *    boards (slots 3-10, 13-20) on the emulated VME bus.
+ *
+ *    Each section sets every keyword type for every slot, with values
+ *    from a random seed per crate.  The section for this host is put
+ *    first, in the middle or last of -n crates.  The first read goes
+ *    through the file; the next ones of the same file use the crate
+ *    index.  Each time, the faV3ConfigToBinary image must be the same as
+ *    from a file with only that section.  The files are dated 10 s back,
+ *    as a file not just written, else the index is not kept.
+ *
+ *    Channel 16 must be taken with a warning on its line and not change
+ *    the settings, as if the line was not there.  Channel 17 must fail,
+ *    with that line in the error.
+ *
+ *    Usage:
+ *      faV3ConfigParseBench [-n <crates>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Config.h"
+#include "faV3BusEmu.h"
+
+#define SLOTMASK  0x1FE7F8	/* slots 3-10, 13-20 */
+#define NBOARDS   16
+#define NREPEAT   5
+#define BINSIZE   (1 << 16)
+
+static char host[256];
+static int32_t nlines;
+static int32_t stdoutFd = -1;
+
+/* Send the library printout to a file, or back */
+static void
+redirect(const char *path)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(path)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+#define LINE(...) { fprintf(out, __VA_ARGS__); nlines++; }
+
+static void
+writeMask(FILE * out, const char *keyword, uint32_t * seed)
+{
+  int32_t ichan;
+
+  fprintf(out, "%s", keyword);
+  for(ichan = 0; ichan < 16; ichan++)
+    fprintf(out, " %d", rand_r(seed) & 1);
+  LINE("\n");
+}
+
+static void
+writeCrate(FILE * out, const char *name, uint32_t seed)
+{
+  int32_t slot, ichan;
+
+  LINE("# crate %s\n", name);
+  LINE("FAV3_CRATE %s\n", name);
+  LINE("\n");
+  LINE("FAV3_SLOT all\n");
+  LINE("FAV3_MODE 10\n");
+  LINE("FAV3_NSA %d\n", 20 + 4 * (rand_r(&seed) % 5));
+  LINE("FAV3_NSB %d\n", 8 + 4 * (rand_r(&seed) % 3));
+  LINE("FAV3_PED %.2f\n", 100. + (rand_r(&seed) % 1000) / 10.);
+  LINE("FAV3_TET %d\n", rand_r(&seed) % 200);
+  LINE("FAV3_DAC %d\n", 3000 + rand_r(&seed) % 500);
+  LINE("FAV3_GAIN %.3f\n", (rand_r(&seed) % 2000) / 1000.);
+  LINE("FAV3_DELAY %d\n", 4 * (rand_r(&seed) % 16));
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      LINE("\n");
+      LINE("FAV3_SLOT %d\n", slot);
+      LINE("  # board %d\n", slot);
+      LINE("FAV3_W_OFFSET %d\n", 4 * (rand_r(&seed) % 1000));
+      LINE("FAV3_W_WIDTH %d\n", 4 * (rand_r(&seed) % 128));
+      LINE("FAV3_NPEAK %d\n", 1 + rand_r(&seed) % 4);
+      LINE("FAV3_NSAT %d\n", 4 * (1 + rand_r(&seed) % 4));
+      LINE("FAV3_NPED %d\n", 1 + rand_r(&seed) % 15);
+      LINE("FAV3_MAXPED %d\n", rand_r(&seed) % 1024);
+      LINE("FAV3_TRIG_THR %d\n", rand_r(&seed) % 4096);
+      LINE("FAV3_TRIG_NSA %d\n", 4 * (rand_r(&seed) % 64));
+      LINE("FAV3_TRIG_NSAT %d\n", 4 * (1 + rand_r(&seed) % 4));
+      LINE("FAV3_TRG_WIDTH %d\n", 4 * (rand_r(&seed) % 255));
+      LINE("FAV3_TRG_MINTOT %d\n", rand_r(&seed) % 256);
+      LINE("FAV3_TRG_MINMULT %d\n", rand_r(&seed) % 16);
+      LINE("FAV3_SPARSIFICATION %d\n", rand_r(&seed) % 2);
+      LINE("FAV3_DATA_FORMAT %d\n", rand_r(&seed) % 3);
+      LINE("FAV3_COMPRESSION %d\n", rand_r(&seed) % 2);
+      LINE("FAV3_VXSREADOUT %d\n", rand_r(&seed) % 2);
+      writeMask(out, "FAV3_ADC_MASK", &seed);
+      writeMask(out, "FAV3_TRG_MASK", &seed);
+      writeMask(out, "FAV3_TET_IGNORE_MASK", &seed);
+      writeMask(out, "FAV3_INVERT_MASK", &seed);
+      writeMask(out, "FAV3_PTW_FALLBACK_MASK", &seed);
+
+      fprintf(out, "FAV3_ALLCH_PED");
+      for(ichan = 0; ichan < 16; ichan++)
+	fprintf(out, " %.3f", 50. + (rand_r(&seed) % 100000) / 1000.);
+      LINE("\n");
+      fprintf(out, "FAV3_ALLCH_TET");
+      for(ichan = 0; ichan < 16; ichan++)
+	fprintf(out, " %d", rand_r(&seed) % 500);
+      LINE("\n");
+
+      for(ichan = 0; ichan < 16; ichan++)
+	{
+	  LINE("FAV3_CH_DAC %d %d\n", ichan, 2500 + rand_r(&seed) % 1500);
+	  LINE("FAV3_CH_GAIN %d %.4f\n", ichan, (rand_r(&seed) % 20000) / 10000.);
+	  if(rand_r(&seed) & 1)
+	    LINE("FAV3_CH_TET %d %d\n", ichan, rand_r(&seed) % 500);
+	}
+    }
+
+  LINE("\n");
+  LINE("FAV3_CRATE end\n");
+  LINE("\n");
+}
+
+/* A file of ncrates sections, ours at position iours (or none if < 0) */
+static void
+writeFile(const char *path, int32_t ncrates, int32_t iours)
+{
+  char name[32];
+  struct timeval tv[2];
+  int32_t icrate;
+  FILE *out = fopen(path, "w");
+
+  if(out == NULL)
+    {
+      perror(path);
+      exit(1);
+    }
+
+  nlines = 0;
+  for(icrate = 0; icrate < ncrates; icrate++)
+    {
+      if(icrate == iours)
+	writeCrate(out, host, 12345);
+      else
+	{
+	  sprintf(name, "rocfadc%03d", icrate);
+	  writeCrate(out, name, icrate);
+	}
+    }
+  fclose(out);
+
+  gettimeofday(&tv[0], NULL);
+  tv[0].tv_sec -= 10;
+  tv[1] = tv[0];
+  utimes(path, tv);
+}
+
+/* Two other crates, then ours with line in slot 4 (or none if NULL).
+   Returns the line number of line. */
+static int32_t
+writeChanFile(const char *path, const char *line)
+{
+  struct timeval tv[2];
+  FILE *out;
+
+  writeFile(path, 2, -1);
+  out = fopen(path, "a");
+  fprintf(out, "FAV3_CRATE %s\nFAV3_SLOT 4\n", host);
+  if(line)
+    fprintf(out, "%s\n", line);
+  fprintf(out, "FAV3_CH_TET 3 100\nFAV3_CRATE end\n");
+  fclose(out);
+
+  gettimeofday(&tv[0], NULL);
+  tv[0].tv_sec -= 10;
+  tv[1] = tv[0];
+  utimes(path, tv);
+
+  return nlines + 3;
+}
+
+/* Read path with the printout to errout.  Returns what
+   faV3ReadConfigFile did, and if text was printed on line badline. */
+static int32_t
+parseChan(const char *path, const char *errout, int32_t badline,
+	  const char *text, uint32_t * bin, int32_t *reported)
+{
+  char out[4096], want[64];
+  int32_t rval;
+  FILE *in;
+
+  faV3InitGlobals();
+  redirect(errout);
+  rval = faV3ReadConfigFile((char *) path);
+  redirect(NULL);
+
+  memset(bin, 0, BINSIZE);
+  faV3ConfigToBinary(bin, BINSIZE);
+
+  in = fopen(errout, "r");
+  memset(out, 0, sizeof(out));
+  fread(out, 1, sizeof(out) - 1, in);
+  fclose(in);
+
+  sprintf(want, "%s line %d:", path, badline);
+  *reported = (strstr(out, want) != NULL) && (strstr(out, text) != NULL);
+
+  return rval;
+}
+
+static int32_t
+parse(const char *path, uint32_t * bin, double *ms)
+{
+  double t0;
+  int32_t rval;
+
+  faV3InitGlobals();
+  redirect("/dev/null");
+  t0 = faV3BusEmuTime();
+  rval = faV3ReadConfigFile((char *) path);
+  t0 = faV3BusEmuTime() - t0;
+  redirect(NULL);
+  if(ms)
+    *ms = 1e3 * t0;
+
+  memset(bin, 0, BINSIZE);
+  faV3ConfigToBinary(bin, BINSIZE);
+
+  return rval;
+}
+
+int
+main(int argc, char *argv[])
+{
+  static uint32_t ref[BINSIZE / 4], bin[BINSIZE / 4];
+  char small[] = "/tmp/faV3ConfigParseBench.XXXXXX";
+  char big[] = "/tmp/faV3ConfigParseBench.XXXXXX";
+  char errout[] = "/tmp/faV3ConfigParseBench.XXXXXX";
+  const char *where[] = { "first", "middle", "last" };
+  int32_t ncrates = 120, iwhere, iours, irep, nerr = 0, badline, opt;
+  int32_t reported, same;
+  double ms, first, best;
+
+  while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  ncrates = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <crates>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+  if(ncrates < 1)
+    ncrates = 1;
+
+  gethostname(host, sizeof(host));
+  host[strcspn(host, ".")] = '\0';
+
+  close(mkstemp(small));
+  close(mkstemp(big));
+  close(mkstemp(errout));
+
+  faV3BusEmuInit(SLOTMASK);
+  redirect("/dev/null");
+  if(faV3Init(3 << 19, 1 << 19, 18, FAV3_INIT_SKIP) != NBOARDS)
+    exit(1);
+  redirect(NULL);
+
+  writeFile(small, 1, 0);
+  if(parse(small, ref, NULL) != 0)
+    {
+      printf("ERROR: %s did not parse\n", small);
+      exit(1);
+    }
+
+  printf("\n%d crates, %d boards each\n\n", ncrates, NBOARDS);
+  printf("our crate      lines  first ms  again ms  ns/line  same FAV3_CONF\n");
+  for(iwhere = 0; iwhere < 3; iwhere++)
+    {
+      iours = (iwhere == 0) ? 0 : (iwhere == 1) ? ncrates / 2 : ncrates - 1;
+      writeFile(big, ncrates, iours);
+
+      /* the first read builds the index */
+      if(parse(big, bin, &first) != 0)
+	nerr++;
+      same = (memcmp(ref, bin, BINSIZE) == 0);
+
+      best = 1e9;
+      for(irep = 0; irep < NREPEAT; irep++)
+	{
+	  if(parse(big, bin, &ms) != 0)
+	    nerr++;
+	  if(ms < best)
+	    best = ms;
+	  same &= (memcmp(ref, bin, BINSIZE) == 0);
+	}
+
+      if(!same)
+	nerr++;
+
+      printf("%-9s  %9d  %8.2f  %8.3f  %7.0f  %s\n", where[iwhere], nlines,
+	     first, best, 1e6 * first / nlines, same ? "yes" : "NO");
+    }
+
+  /* Channel 16: taken, not stored */
+  writeChanFile(big, NULL);
+  parseChan(big, errout, 0, "", ref, &reported);
+  badline = writeChanFile(big, "FAV3_CH_TET 16 100");
+  opt = parseChan(big, errout, badline, "WARNING", bin, &reported);
+  same = (memcmp(ref, bin, BINSIZE) == 0);
+  printf("\nChannel 16 on line %d: faV3ReadConfigFile returned %d, %s, %s\n",
+	 badline, opt, reported ? "warning on the line" : "NO warning",
+	 same ? "settings unchanged" : "settings CHANGED");
+  if((opt != 0) || !reported || !same)
+    nerr++;
+
+  /* Channel 17: an error */
+  badline = writeChanFile(big, "FAV3_CH_GAIN 17 0.5");
+  opt = parseChan(big, errout, badline, "ERROR", bin, &reported);
+  printf("Channel 17 on line %d: faV3ReadConfigFile returned %d, %s\n",
+	 badline, opt, reported ? "line reported" : "line NOT reported");
+  if((opt >= 0) || !reported)
+    nerr++;
+
+  unlink(small);
+  unlink(big);
+  unlink(errout);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,226 @@
+/*
+ * File:
+ *    faV3ConfigStringBench.c
+ *
+ * Description:
+ *    Time of faV3ConfigToString and faV3ConfigToBinary for 1 to 20 boards
+ *    (from slot 2) on the emulated VME bus, with the time per board to
+ *    show that it scales linearly.
+ *
+ *    For each number of boards, checks that the length query gives the
+ *    length of the text, that the text read back with faV3ReadConfigFile
+ *    writes the same text again, and that faV3ConfigFromBinary of the
+ *    binary form gives the same binary form.  Then, with 20 boards, that
+ *    a short buffer gets whole lines only, and that faV3UploadAll returns
+ *    -1 for it.
+ *
+ *    Usage:
+ *      faV3ConfigStringBench [-f <config file>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Config.h"
+#include "faV3BusEmu.h"
+
+#define NREPEAT   20
+#define TEXTSIZE  (1 << 20)
+#define BINSIZE   (1 << 16)
+
+static int32_t stdoutFd = -1;
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+/* Best of NREPEAT, in us */
+static double
+timeText(char *text)
+{
+  double t0, best = 1e9;
+  int32_t irep;
+
+  for(irep = 0; irep < NREPEAT; irep++)
+    {
+      t0 = faV3BusEmuTime();
+      faV3ConfigToString(text, TEXTSIZE);
+      t0 = faV3BusEmuTime() - t0;
+      if(t0 < best)
+	best = t0;
+    }
+
+  return 1e6 * best;
+}
+
+static double
+timeBinary(uint32_t * bin)
+{
+  double t0, best = 1e9;
+  int32_t irep;
+
+  for(irep = 0; irep < NREPEAT; irep++)
+    {
+      t0 = faV3BusEmuTime();
+      faV3ConfigToBinary(bin, BINSIZE);
+      t0 = faV3BusEmuTime() - t0;
+      if(t0 < best)
+	best = t0;
+    }
+
+  return 1e6 * best;
+}
+
+/* Text and binary round trips of the current configuration */
+static int32_t
+roundTrip(const char *text, const uint32_t * bin, int32_t nbytes)
+{
+  static char again[TEXTSIZE];
+  static uint32_t bagain[BINSIZE / 4];
+  char path[] = "/tmp/faV3ConfigStringBench.XXXXXX";
+  int32_t fd, nerr = 0;
+
+  fd = mkstemp(path);
+  write(fd, text, strlen(text));
+  close(fd);
+
+  faV3InitGlobals();
+  quiet(1);
+  if(faV3ReadConfigFile(path) < 0)
+    nerr++;
+  quiet(0);
+  unlink(path);
+
+  faV3ConfigToString(again, TEXTSIZE);
+  if(strcmp(text, again) != 0)
+    {
+      printf("  ERROR: text read back writes different text\n");
+      nerr++;
+    }
+
+  faV3InitGlobals();
+  if(faV3ConfigFromBinary(bin, nbytes) != faV3GetN())
+    nerr++;
+  memset(bagain, 0, sizeof(bagain));
+  if((faV3ConfigToBinary(bagain, BINSIZE) != nbytes) ||
+     (memcmp(bin, bagain, nbytes) != 0))
+    {
+      printf("  ERROR: binary form read back is different\n");
+      nerr++;
+    }
+
+  return nerr;
+}
+
+int
+main(int argc, char *argv[])
+{
+  static char text[TEXTSIZE], small[TEXTSIZE];
+  static uint32_t bin[BINSIZE / 4];
+  const int32_t nboards[] = { 1, 2, 4, 8, 12, 16, 20 };
+  char *fname = "faV3.cfg";
+  int32_t ib, n, len, query, nbytes, size, nerr = 0, opt;
+  double ttext, tbin;
+
+  while((opt = getopt(argc, argv, "f:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'f':
+	  fname = optarg;
+	  break;
+	default:
+	  printf("Usage: %s [-f <config file>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  printf("\n%s, best of %d\n\n", fname, NREPEAT);
+  printf("boards   bytes  text us  us/board   binary us  us/board  round trip\n");
+  for(ib = 0; ib < sizeof(nboards) / sizeof(nboards[0]); ib++)
+    {
+      n = nboards[ib];
+
+      faV3BusEmuInit(((1 << n) - 1) << 2);
+      quiet(1);
+      if(faV3Init(2 << 19, 1 << 19, n, FAV3_INIT_SKIP) != n)
+	{
+	  quiet(0);
+	  printf("ERROR: %d boards not found\n", n);
+	  exit(1);
+	}
+      faV3InitGlobals();
+      if(faV3ReadConfigFile(fname) < 0)
+	exit(1);
+      quiet(0);
+
+      query = faV3ConfigToString(NULL, 0);
+      ttext = timeText(text);
+      len = strlen(text);
+      if((query != len) || (faV3ConfigToString(text, TEXTSIZE) != len))
+	{
+	  printf("  ERROR: length query %d, text %d\n", query, len);
+	  nerr++;
+	}
+
+      nbytes = faV3ConfigToBinary(NULL, 0);
+      tbin = timeBinary(bin);
+
+      opt = roundTrip(text, bin, nbytes);
+      nerr += opt;
+
+      printf("%6d  %6d  %7.1f  %8.2f  %10.2f  %8.3f  %s\n", n, len, ttext,
+	     ttext / n, tbin, tbin / n, opt ? "WRONG" : "same");
+    }
+
+  /* Half the text fits: whole lines, and the length of the whole text */
+  len = strlen(text);
+  size = len / 2;
+  memset(small, 'x', sizeof(small));
+  quiet(1);
+  query = faV3ConfigToString(small, size);
+  quiet(0);
+  n = strlen(small);
+  printf("\nBuffer of %d for %d bytes: returned %d, wrote %d, %s\n", size,
+	 len, query, n, ((n < size) && (small[n - 1] == '\n') &&
+			 (strncmp(small, text, n) == 0)) ?
+	 "whole lines" : "NOT whole lines");
+  if((query != len) || (n >= size) || (small[n - 1] != '\n') ||
+     (strncmp(small, text, n) != 0) || (text[n - 1] != '\n'))
+    nerr++;
+
+  quiet(1);
+  opt = faV3UploadAll(small, size);
+  n = faV3UploadAll(small, len + 1);
+  quiet(0);
+  printf("faV3UploadAll: %d with %d bytes, %d with %d\n", opt, size, n,
+	 len + 1);
+  if((opt != -1) || (n != 0))
+    nerr++;
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
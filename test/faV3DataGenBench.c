@@ -0,0 +1,204 @@
+/*
+ * File:
+ *    faV3DataGenBench.c
+ *
+ * Description:
+ *    Checks and throughput of the data generator (faV3DataGen).  No
+ *    hardware or bus is used.
+ *
+ *    Round trip: for every combination of proc mode (1, 9, 10), data
+ *    format (0, 1, 2), trigger time suppression (0, 1, 2), ADC parameter
+ *    insertion, scaler interval (0, 3) and byte order, 20 multiblock
+ *    readouts of 16 boards are generated and decoded with faV3Decoder.
+ *    The decoder must find every block, event header (one per block in
+ *    format 2), window and pulse record, with no orphans, overflows or
+ *    trailer mismatches.
+ *
+ *    Throughput: GB/s of generated words for modes 1, 9 and 10.
+ *
+ *    Build the library with optimization (make DEBUG=) for the rates.
+ *
+ *    Usage:
+ *      faV3DataGenBench [-n <passes>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3BusEmu.h"
+
+#define NBOARDS   16
+#define NREADOUT  20
+#define NCHAN     15		/* chan_mask 0xFFF7 */
+#define MAXWORDS  (1 << 22)
+
+static uint32_t data[MAXWORDS];
+
+static void
+initCrate(faV3Gen_t * gen, faV3GenConfig_t * cfg)
+{
+  faV3GenChannel_t ch;
+  int32_t igen, ichan, slot = 3;
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 10;
+  ch.pulse[0].amplitude = 500;
+  ch.pulse[0].rise = 3;
+  ch.pulse[0].fall = 8;
+
+  for(igen = 0; igen < NBOARDS; igen++, slot++)
+    {
+      if(slot == 11)
+	slot = 13;		/* switch slots */
+      cfg->slot = slot;
+      faV3GenInit(&gen[igen], cfg);
+      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	faV3GenSetChannel(&gen[igen], ichan, &ch);
+    }
+}
+
+static int32_t
+roundTrip(faV3GenConfig_t * cfg)
+{
+  static faV3Decoder_t dec;
+  faV3Gen_t gen[NBOARDS];
+  const faV3DecStats_t *st = &dec.stats;
+  uint64_t nblk = NBOARDS * NREADOUT, nevt = nblk * cfg->block_level;
+  int32_t igen, iread, nwords = 0, bad;
+
+  initCrate(gen, cfg);
+  for(iread = 0; iread < NREADOUT; iread++)
+    nwords += faV3GenCrate(gen, NBOARDS, data + nwords, MAXWORDS - nwords);
+  for(igen = 0; igen < NBOARDS; igen++)
+    faV3GenFree(&gen[igen]);
+
+  faV3DecoderInit(&dec,
+		  (cfg->flags & FAV3_GEN_FLAG_SWAP) ? FAV3_DEC_FLAG_SWAP : 0);
+  faV3DecoderFeed(&dec, data, nwords);
+  faV3DecoderFlush(&dec);
+
+  bad = (st->nrec[FAV3_DEC_BLOCK_HEADER] != nblk)
+    || (st->nrec[FAV3_DEC_BLOCK_TRAILER] != nblk)
+    || (st->nrec[FAV3_DEC_EVENT_HEADER] !=
+	((cfg->format == 2) ? nblk : nevt))
+    || (st->nrec[FAV3_DEC_WINDOW_RAW] !=
+	((cfg->mode == 9) ? 0 : nevt * NCHAN))
+    || (st->nrec[FAV3_DEC_PULSE_PARAM] !=
+	((cfg->mode == 1) ? 0 : nevt * NCHAN))
+    || ((cfg->scaler_interval > 0) != (st->nrec[FAV3_DEC_SCALER] > 0))
+    || st->orphan || st->overflow || st->trailer_mismatch
+    || st->trailer_slot;
+
+  if(bad)
+    printf("  ERROR: mode %d format %d suppress %d params %d scalers %d"
+	   " swap %d: bh %llu bt %llu eh %llu win %llu pp %llu sc %llu"
+	   " orphan %u overflow %u mismatch %u slot %u\n",
+	   cfg->mode, cfg->format, cfg->suppress_tt, cfg->insert_params,
+	   cfg->scaler_interval, cfg->flags & FAV3_GEN_FLAG_SWAP,
+	   (unsigned long long) st->nrec[FAV3_DEC_BLOCK_HEADER],
+	   (unsigned long long) st->nrec[FAV3_DEC_BLOCK_TRAILER],
+	   (unsigned long long) st->nrec[FAV3_DEC_EVENT_HEADER],
+	   (unsigned long long) st->nrec[FAV3_DEC_WINDOW_RAW],
+	   (unsigned long long) st->nrec[FAV3_DEC_PULSE_PARAM],
+	   (unsigned long long) st->nrec[FAV3_DEC_SCALER],
+	   st->orphan, st->overflow, st->trailer_mismatch, st->trailer_slot);
+
+  return bad;
+}
+
+/* GB/s of generated words */
+static double
+runGen(int32_t mode, int32_t npass, int32_t * blockwords)
+{
+  faV3Gen_t gen[NBOARDS];
+  faV3GenConfig_t cfg;
+  uint64_t total = 0;
+  int32_t igen, ipass, nwords, cratewords = 0;
+  double t0;
+
+  faV3GenDefaults(&cfg);
+  cfg.mode = mode;
+  cfg.PTW = 100;
+  cfg.block_level = 10;
+  initCrate(gen, &cfg);
+  *blockwords = faV3GenBlockWords(&gen[0]);
+  for(igen = 0; igen < NBOARDS; igen++)
+    cratewords += faV3GenBlockWords(&gen[igen]);
+
+  t0 = faV3BusEmuTime();
+  for(ipass = 0; ipass < npass; ipass++)
+    {
+      for(nwords = 0; nwords + cratewords <= MAXWORDS;)
+	nwords += faV3GenCrate(gen, NBOARDS, data + nwords, MAXWORDS - nwords);
+      total += nwords;
+    }
+  t0 = faV3BusEmuTime() - t0;
+
+  for(igen = 0; igen < NBOARDS; igen++)
+    faV3GenFree(&gen[igen]);
+
+  return 4.0 * total / t0 / 1e9;
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3GenConfig_t cfg;
+  int32_t modes[3] = { 1, 9, 10 };
+  int32_t imode, format, suppress, params, scalers, swap;
+  int32_t npass = 20, ncase = 0, nerr = 0, blockwords, opt;
+  double rate;
+
+  while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  npass = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <passes>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  for(imode = 0; imode < 3; imode++)
+    for(format = 0; format <= 2; format++)
+      for(suppress = 0; suppress <= 2; suppress++)
+	for(params = 0; params <= 1; params++)
+	  for(scalers = 0; scalers <= 3; scalers += 3)
+	    for(swap = 0; swap <= 1; swap++)
+	      {
+		faV3GenDefaults(&cfg);
+		cfg.mode = modes[imode];
+		cfg.PTW = 51;
+		cfg.format = format;
+		cfg.suppress_tt = suppress;
+		cfg.insert_params = params;
+		cfg.scaler_interval = scalers;
+		cfg.block_level = 4;
+		cfg.chan_mask = 0xFFF7;
+		cfg.flags = swap ? FAV3_GEN_FLAG_SWAP : 0;
+		nerr += roundTrip(&cfg);
+		ncase++;
+	      }
+  printf("\nRound trip: %d configurations, %d errors\n", ncase, nerr);
+
+  printf("\nGeneration rate, PTW 100, block level 10, 16 boards\n\n");
+  printf("mode  block words  GB/s\n");
+  for(imode = 0; imode < 3; imode++)
+    {
+      rate = runGen(modes[imode], npass, &blockwords);
+      printf("%4d  %11d  %4.2f\n", modes[imode], blockwords, rate);
+    }
+
+  exit(nerr ? 1 : 0);
+}
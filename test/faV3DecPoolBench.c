@@ -0,0 +1,272 @@
+/*
+ * File:
+ *    faV3DecPoolBench.c
+ *
+ * Description:
+ *    Scaling of the multi-threaded decoder (faV3DecPool) with 1-16
+ *    threads, on synthetic crate data from faV3DataGen.  No hardware or
+ *    bus is used.
+ *
+ *    16 boards (slots 3-10, 13-20) in mode 10, block level 10.  The board
+ *    in slot 5 has a 400 sample window and the others 30, so one block
+ *    takes much longer to decode than the rest.  The buffer holds 20
+ *    multiblock readouts back to back.  Every event must have all 16
+ *    slots and come in trigger number order.
+ *
+ *    Rates are from the best of the passes.  The fixed cost of the pool
+ *    per block is its time with 1 thread, less the index and the decode
+ *    of the same blocks by one decoder into output arrays, over the
+ *    number of blocks.  The three are timed back to back in each pass,
+ *    and the median of the passes is shown.
+ *
+ *    Build the library with optimization (make DEBUG=) for the rates.
+ *
+ *    Usage:
+ *      faV3DecPoolBench [-n <passes>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3DecPool.h"
+#include "faV3BusEmu.h"
+
+#define NBOARDS   16
+#define NREADOUT  20
+#define MAXWORDS  (1 << 22)
+
+static uint32_t data[MAXWORDS];
+static int32_t dataWords = 0;
+
+static uint64_t nevents, nbad;
+static uint32_t lastEvt;
+static int32_t firstEvt;
+
+static void
+checkEvent(const faV3DecEvent_t * evt, void *arg)
+{
+  if(!firstEvt && (evt->evt_num != ((lastEvt + 1) & 0xFFF)))
+    nbad++;
+  if(evt->nslots != NBOARDS)
+    nbad++;
+  lastEvt = evt->evt_num;
+  firstEvt = 0;
+  nevents++;
+}
+
+static void
+countRecord(const faV3DecRecord_t * rec, void *arg)
+{
+}
+
+/* Decode the indexed blocks one by one into output arrays, as the pool
+   does, on this thread */
+static void
+decodeBlocks(faV3Decoder_t * dec, const faV3Index_t * idx, faV3DecOutput_t * out)
+{
+  int32_t iblk, end;
+
+  for(iblk = 0; iblk < idx->nblocks; iblk++)
+    {
+      end = (iblk + 1 < idx->nblocks) ?
+	(int32_t) idx->blocks[iblk + 1].header : dataWords;
+      out->nrec = out->nsamples = out->nwords = 0;
+      faV3DecoderReset(dec);
+      faV3DecoderFeed(dec, &data[idx->blocks[iblk].header],
+		      end - idx->blocks[iblk].header);
+      faV3DecoderFlush(dec);
+    }
+}
+
+static int
+compareTimes(const void *a, const void *b)
+{
+  double ta = *(const double *) a, tb = *(const double *) b;
+
+  return (ta < tb) ? -1 : (ta > tb);
+}
+
+static double
+median(double *t, int32_t n)
+{
+  qsort(t, n, sizeof(double), compareTimes);
+
+  return t[n / 2];
+}
+
+static void
+makeCrate()
+{
+  faV3Gen_t gen[NBOARDS];
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t igen, ichan, iread, slot = 3;
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+
+  for(igen = 0; igen < NBOARDS; igen++, slot++)
+    {
+      if(slot == 11)
+	slot = 13;		/* switch slots */
+      faV3GenDefaults(&cfg);
+      cfg.slot = slot;
+      cfg.mode = 10;
+      cfg.PTW = (slot == 5) ? 400 : 30;
+      cfg.block_level = 10;
+      faV3GenInit(&gen[igen], &cfg);
+      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	faV3GenSetChannel(&gen[igen], ichan, &ch);
+    }
+
+  for(iread = 0; iread < NREADOUT; iread++)
+    dataWords += faV3GenCrate(gen, NBOARDS, data + dataWords,
+			      MAXWORDS - dataWords);
+
+  for(igen = 0; igen < NBOARDS; igen++)
+    faV3GenFree(&gen[igen]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  static faV3Decoder_t dec;
+  static faV3IndexBlock_t blocks[MAXWORDS / 64];
+  static uint32_t events[MAXWORDS / 16];
+  static faV3DecRecord_t rec[MAXWORDS / 8];
+  static uint16_t samples[2 * MAXWORDS / 8];
+  static uint32_t words[MAXWORDS / 8];
+  faV3Index_t idx;
+  faV3DecOutput_t out;
+  int32_t nthreads, ipass, npass = 20, opt;
+  double t0, tdec, best, rate1;
+  double *tidx, *tarr, *tpool, *tfixed;
+
+  while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  npass = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <passes>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  if(npass < 1)
+    npass = 1;
+  tidx = (double *) malloc(4 * npass * sizeof(double));
+  tarr = tidx + npass;
+  tpool = tarr + npass;
+  tfixed = tpool + npass;
+
+  makeCrate();
+
+  memset(&idx, 0, sizeof(idx));
+  idx.blocks = blocks;
+  idx.maxblocks = MAXWORDS / 64;
+  idx.events = events;
+  idx.maxevents = MAXWORDS / 16;
+  faV3IndexBuild(&idx, data, dataWords, 0);
+
+  printf("\n%d readouts of %d boards, %d words, %d blocks, %ld CPUs.\n\n",
+	 NREADOUT, NBOARDS, dataWords, idx.nblocks,
+	 sysconf(_SC_NPROCESSORS_ONLN));
+
+  /* One decoder, one thread, no merge */
+  faV3DecoderInit(&dec, 0);
+  faV3DecoderSetCallback(&dec, countRecord, NULL);
+  tdec = 1e9;
+  for(ipass = 0; ipass < npass; ipass++)
+    {
+      t0 = faV3BusEmuTime();
+      faV3DecoderFeed(&dec, data, dataWords);
+      t0 = faV3BusEmuTime() - t0;
+      if(t0 < tdec)
+	tdec = t0;
+    }
+  rate1 = 4.0 * dataWords / tdec / 1e9;
+
+  printf("threads   GB/s  speedup  events  bad\n");
+  printf("decoder  %5.2f     1.00\n", rate1);
+
+  for(nthreads = 1; nthreads <= 16; nthreads <<= 1)
+    {
+      if(faV3DecPoolCreate(nthreads, 0) != OK)
+	exit(1);
+      nevents = nbad = 0;
+
+      best = 1e9;
+      for(ipass = 0; ipass < npass; ipass++)
+	{
+	  firstEvt = 1;
+	  t0 = faV3BusEmuTime();
+	  faV3DecPoolDecode(data, dataWords, checkEvent, NULL);
+	  t0 = faV3BusEmuTime() - t0;
+	  if(t0 < best)
+	    best = t0;
+	}
+
+      printf("%7d  %5.2f  %7.2f  %6llu  %llu\n", nthreads,
+	     4.0 * dataWords / best / 1e9, tdec / best,
+	     (unsigned long long) nevents / npass,
+	     (unsigned long long) nbad);
+      faV3DecPoolDestroy();
+    }
+
+  /* The pool with 1 thread, and its single thread parts: index, and block
+     by block decode into arrays */
+  out.rec = rec;
+  out.maxrec = MAXWORDS / 8;
+  out.samples = samples;
+  out.maxsamples = 2 * MAXWORDS / 8;
+  out.words = words;
+  out.maxwords = MAXWORDS / 8;
+  faV3DecoderInit(&dec, 0);
+  faV3DecoderSetOutput(&dec, &out);
+  if(faV3DecPoolCreate(1, 0) != OK)
+    exit(1);
+  for(ipass = 0; ipass < npass; ipass++)
+    {
+      t0 = faV3BusEmuTime();
+      faV3IndexBuild(&idx, data, dataWords, 0);
+      tidx[ipass] = faV3BusEmuTime() - t0;
+
+      t0 = faV3BusEmuTime();
+      decodeBlocks(&dec, &idx, &out);
+      tarr[ipass] = faV3BusEmuTime() - t0;
+
+      firstEvt = 1;
+      t0 = faV3BusEmuTime();
+      faV3DecPoolDecode(data, dataWords, checkEvent, NULL);
+      tpool[ipass] = faV3BusEmuTime() - t0;
+
+      tfixed[ipass] = tpool[ipass] - tidx[ipass] - tarr[ipass];
+    }
+  faV3DecPoolDestroy();
+
+  printf("\nOne buffer, 1 thread, median us\n");
+  printf("  decoder, callback          %8.1f  (best)\n", 1e6 * tdec);
+  printf("  index                      %8.1f\n", 1e6 * median(tidx, npass));
+  printf("  decoder, arrays per block  %8.1f\n", 1e6 * median(tarr, npass));
+  printf("  pool                       %8.1f\n", 1e6 * median(tpool, npass));
+  printf("  pool fixed cost per block  %8.2f\n",
+	 1e6 * median(tfixed, npass) / idx.nblocks);
+
+  free(tidx);
+
+  exit(0);
+}
@@ -0,0 +1,732 @@
+/*
+ * File:
+ *    faV3Decode.c
+ *
+ * Description:
+ *    Decode a raw fADC250 V3 data dump with the library decoder
+ *    (faV3DecoderFeed).  Binary dumps are memory mapped and decoded in
+ *    place.  Hex text dumps (one or more words per line, as read by
+ *    faV3DataDecode.C) are parsed first.  The byte order is detected from
+ *    the block header / trailer pairs: host order, byte swapped (LSWAP),
+ *    or 16 bit halves swapped.
+ *
+ *    Usage:
+ *      faV3Decode [options] <file>
+ *        -s          Summary: records per type, per slot and per channel
+ *                    (default)
+ *        -p          Print every record
+ *        -c <file>   Export records as CSV
+ *        -b <file>   Export records as packed binary
+ *        -o <order>  Byte order: auto (default), host, lswap, hswap
+ *        -x          Input is hex text (default: detect)
+ *        -n <N>      Benchmark: decode N times and report the throughput
+ *
+ *    CSV and binary exports have the same fields per record:
+ *      type, slot, evt_num, then by type
+ *        BLOCK HEADER   modID blk_num n_evts has_param PL NSB NSA
+ *        BLOCK TRAILER  n_words counted
+ *        EVENT HEADER   evt_num time_low_10
+ *        TRIGGER TIME   time (bits 0-31) time (bits 32-47)
+ *        WINDOW RAW     chan width ninvalid sample...
+ *        PULSE PARAM    chan evt_of_blk ped_sum quality npulse, then per
+ *                       pulse: adc_sum nsa_ext over under samp_ov_thres
+ *                       time_coarse time_fine vpeak quality quality2
+ *        SCALER         nwords count...
+ *        FILLER, OTHER  word
+ *    A binary record is a 32 bit word (type << 24) | (slot << 16) | nfields,
+ *    the 32 bit evt_num, and nfields 32 bit fields, all in host order.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+
+#define FEED_WORDS     (1 << 20)	/* words per faV3DecoderFeed */
+#define DETECT_WORDS   (1 << 20)	/* words examined to detect the order */
+#define OUTBUF_SIZE    (1 << 20)
+#define MAX_FIELDS     (FAV3_DEC_MAX_SAMPLES + 16)
+
+enum
+  {
+    ORDER_HOST,
+    ORDER_LSWAP,		/* bytes of each word swapped */
+    ORDER_HSWAP,		/* 16 bit halves of each word swapped */
+    ORDER_N
+  };
+
+static const char *orderNames[ORDER_N] = { "host", "lswap", "hswap" };
+
+typedef struct
+{
+  uint64_t slot[32][FAV3_DEC_NTYPES];	/* records per slot and type */
+  uint64_t chan[32][FAV3_MAX_ADC_CHANNELS];	/* windows + pulse records */
+  uint64_t pulses[32][FAV3_MAX_ADC_CHANNELS];
+  uint64_t samples;
+} summary_t;
+
+static summary_t sum;
+static int printRecords = 0;
+static FILE *csvFile = NULL, *binFile = NULL;
+static char outbuf[OUTBUF_SIZE + 64];
+static int outlen = 0;
+
+static inline uint32_t
+loadWord(uint32_t w, int order)
+{
+  if(order == ORDER_LSWAP)
+    return __builtin_bswap32(w);
+  if(order == ORDER_HSWAP)
+    return (w << 16) | (w >> 16);
+  return w;
+}
+
+/* Number of blocks whose trailer has the slot and word count of the header */
+static int64_t
+orderScore(const uint32_t * data, int64_t nwords, int order)
+{
+  int64_t i, hdr = -1, score = 0;
+  uint32_t w, slot = 0;
+
+  for(i = 0; i < nwords; i++)
+    {
+      w = loadWord(data[i], order);
+      if((w & 0xF8000000) == (FAV3_DATA_TYPE_DEFINE | FAV3_DATA_BLOCK_HEADER))
+	{
+	  hdr = i;
+	  slot = w & FAV3_DATA_SLOT_MASK;
+	}
+      else if((w & 0xF8000000) ==
+	      (FAV3_DATA_TYPE_DEFINE | FAV3_DATA_BLOCK_TRAILER))
+	{
+	  if((hdr >= 0) && ((w & FAV3_DATA_SLOT_MASK) == slot) &&
+	     ((w & FAV3_DATA_WRDCNT_MASK) == (uint32_t) (i - hdr + 1)))
+	    score++;
+	  hdr = -1;
+	}
+    }
+
+  return score;
+}
+
+static int
+detectOrder(const uint32_t * data, int64_t nwords)
+{
+  int64_t score, best_score = 0;
+  int order, best = ORDER_HOST;
+
+  if(nwords > DETECT_WORDS)
+    nwords = DETECT_WORDS;
+
+  for(order = 0; order < ORDER_N; order++)
+    {
+      score = orderScore(data, nwords, order);
+      if(score > best_score)
+	{
+	  best_score = score;
+	  best = order;
+	}
+    }
+
+  if(best_score == 0)
+    fprintf(stderr, "WARN: No complete block found, assuming host order\n");
+
+  return best;
+}
+
+/* Hex text if the start of the file has nothing but hex digits, 0x and
+   white space */
+static int
+isHexText(const char *p, size_t len)
+{
+  size_t i;
+
+  if(len > 4096)
+    len = 4096;
+
+  for(i = 0; i < len; i++)
+    {
+      if(((p[i] >= '0') && (p[i] <= '9')) || ((p[i] >= 'a') && (p[i] <= 'f'))
+	 || ((p[i] >= 'A') && (p[i] <= 'F')) || (p[i] == 'x') || (p[i] == 'X')
+	 || (p[i] == ' ') || (p[i] == '\t') || (p[i] == '\n') || (p[i] == '\r'))
+	continue;
+      return 0;
+    }
+
+  return 1;
+}
+
+static inline int
+hexValue(char c)
+{
+  if((c >= '0') && (c <= '9'))
+    return c - '0';
+  if((c >= 'a') && (c <= 'f'))
+    return c - 'a' + 10;
+  if((c >= 'A') && (c <= 'F'))
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* Parse hex words.  Returns the number of words, or -1 on error. */
+static int64_t
+parseHex(const char *p, size_t len, uint32_t ** words)
+{
+  int64_t n = 0, max = (len / 9) + 1024;
+  uint32_t *w = malloc(max * sizeof(uint32_t)), v;
+  size_t i = 0;
+  int d;
+
+  while((i < len) && w)
+    {
+      while((i < len) && (hexValue(p[i]) < 0))
+	i++;
+      if(i >= len)
+	break;
+
+      if((p[i] == '0') && (i + 1 < len) && ((p[i + 1] == 'x') || (p[i + 1] == 'X')))
+	i += 2;
+
+      v = 0;
+      while((i < len) && ((d = hexValue(p[i])) >= 0))
+	{
+	  v = (v << 4) | d;
+	  i++;
+	}
+
+      if(n == max)
+	{
+	  max *= 2;
+	  w = realloc(w, max * sizeof(uint32_t));
+	  if(w == NULL)
+	    break;
+	}
+      w[n++] = v;
+    }
+
+  if(w == NULL)
+    {
+      perror("malloc");
+      return -1;
+    }
+
+  *words = w;
+  return n;
+}
+
+/* CSV output buffer.  The binary export writes through stdio directly. */
+static void
+outFlush(FILE * f)
+{
+  if(outlen && (fwrite(outbuf, 1, outlen, f) != (size_t) outlen))
+    perror("fwrite");
+  outlen = 0;
+}
+
+static inline void
+outU32(uint32_t v)
+{
+  char tmp[12];
+  int n = 0;
+
+  do
+    {
+      tmp[n++] = '0' + (v % 10);
+      v /= 10;
+    }
+  while(v);
+
+  while(n)
+    outbuf[outlen++] = tmp[--n];
+}
+
+/* Fields of a record, as listed at the top of this file */
+static int
+recordFields(const faV3DecRecord_t * rec, uint32_t * f)
+{
+  const faV3DecPulse_t *p;
+  uint32_t i;
+  int n = 0;
+
+  switch (rec->type)
+    {
+    case FAV3_DEC_BLOCK_HEADER:
+      f[n++] = rec->u.bh.modID;
+      f[n++] = rec->u.bh.blk_num;
+      f[n++] = rec->u.bh.n_evts;
+      f[n++] = rec->u.bh.has_param;
+      f[n++] = rec->u.bh.PL;
+      f[n++] = rec->u.bh.NSB;
+      f[n++] = rec->u.bh.NSA;
+      break;
+
+    case FAV3_DEC_BLOCK_TRAILER:
+      f[n++] = rec->u.bt.n_words;
+      f[n++] = rec->u.bt.counted;
+      break;
+
+    case FAV3_DEC_EVENT_HEADER:
+      f[n++] = rec->u.eh.evt_num;
+      f[n++] = rec->u.eh.time_low_10;
+      break;
+
+    case FAV3_DEC_TRIGGER_TIME:
+      f[n++] = (uint32_t) rec->u.tt.time;
+      f[n++] = (uint32_t) (rec->u.tt.time >> 32);
+      break;
+
+    case FAV3_DEC_WINDOW_RAW:
+      f[n++] = rec->u.win.chan;
+      f[n++] = rec->u.win.width;
+      f[n++] = rec->u.win.ninvalid;
+      for(i = 0; i < rec->u.win.nsamples; i++)
+	f[n++] = rec->u.win.samples[i];
+      break;
+
+    case FAV3_DEC_PULSE_PARAM:
+      f[n++] = rec->u.pp.chan;
+      f[n++] = rec->u.pp.evt_of_blk;
+      f[n++] = rec->u.pp.ped_sum;
+      f[n++] = rec->u.pp.quality;
+      f[n++] = rec->u.pp.npulse;
+      for(i = 0; i < rec->u.pp.npulse; i++)
+	{
+	  p = &rec->u.pp.pulse[i];
+	  f[n++] = p->adc_sum;
+	  f[n++] = p->nsa_ext;
+	  f[n++] = p->over;
+	  f[n++] = p->under;
+	  f[n++] = p->samp_ov_thres;
+	  f[n++] = p->time_coarse;
+	  f[n++] = p->time_fine;
+	  f[n++] = p->vpeak;
+	  f[n++] = p->quality;
+	  f[n++] = p->quality2;
+	}
+      break;
+
+    case FAV3_DEC_SCALER:
+      f[n++] = rec->u.sc.nwords;
+      for(i = 0; i < rec->u.sc.nwords; i++)
+	f[n++] = rec->u.sc.counts[i];
+      break;
+
+    default:
+      f[n++] = rec->word;
+      break;
+    }
+
+  return n;
+}
+
+static void
+exportCSV(const faV3DecRecord_t * rec, const uint32_t * f, int nf)
+{
+  const char *name = faV3DecoderTypeName(rec->type);
+  int i;
+
+  while(*name)
+    outbuf[outlen++] = *name++;
+  outbuf[outlen++] = ',';
+  outU32(rec->slot);
+  outbuf[outlen++] = ',';
+  outU32(rec->evt_num);
+
+  for(i = 0; i < nf; i++)
+    {
+      outbuf[outlen++] = ',';
+      outU32(f[i]);
+      if(outlen > OUTBUF_SIZE)
+	outFlush(csvFile);
+    }
+  outbuf[outlen++] = '\n';
+
+  if(outlen > OUTBUF_SIZE - 64)
+    outFlush(csvFile);
+}
+
+static void
+exportBinary(const faV3DecRecord_t * rec, const uint32_t * f, int nf)
+{
+  uint32_t hdr[2];
+
+  hdr[0] = (rec->type << 24) | ((rec->slot & 0xFF) << 16) | (nf & 0xFFFF);
+  hdr[1] = rec->evt_num;
+
+  fwrite(hdr, sizeof(uint32_t), 2, binFile);
+  fwrite(f, sizeof(uint32_t), nf, binFile);
+}
+
+static void
+printRecord(const faV3DecRecord_t * rec)
+{
+  const faV3DecPulse_t *p;
+  uint32_t i;
+
+  printf("%08X %-14s slot %2d evt %5d ", rec->word,
+	 faV3DecoderTypeName(rec->type), rec->slot, rec->evt_num);
+
+  switch (rec->type)
+    {
+    case FAV3_DEC_BLOCK_HEADER:
+      printf("modID %d  blk %d  n_evts %d", rec->u.bh.modID,
+	     rec->u.bh.blk_num, rec->u.bh.n_evts);
+      if(rec->u.bh.has_param)
+	printf("  PL %d  NSB %d  NSA %d", rec->u.bh.PL, rec->u.bh.NSB,
+	       rec->u.bh.NSA);
+      break;
+
+    case FAV3_DEC_BLOCK_TRAILER:
+      printf("n_words %d%s", rec->u.bt.n_words,
+	     (rec->u.bt.n_words != rec->u.bt.counted) ? "  (MISMATCH)" : "");
+      break;
+
+    case FAV3_DEC_EVENT_HEADER:
+      printf("trig time %d", rec->u.eh.time_low_10);
+      break;
+
+    case FAV3_DEC_TRIGGER_TIME:
+      printf("time 0x%012llx", (unsigned long long) rec->u.tt.time);
+      break;
+
+    case FAV3_DEC_WINDOW_RAW:
+      printf("chan %2d  width %d  invalid %d\n   ", rec->u.win.chan,
+	     rec->u.win.width, rec->u.win.ninvalid);
+      for(i = 0; i < rec->u.win.nsamples; i++)
+	printf("%s%5d", ((i % 16) == 0 && i) ? "\n   " : "",
+	       rec->u.win.samples[i]);
+      break;
+
+    case FAV3_DEC_PULSE_PARAM:
+      printf("chan %2d  pedsum %d  quality %d", rec->u.pp.chan,
+	     rec->u.pp.ped_sum, rec->u.pp.quality);
+      for(i = 0; i < rec->u.pp.npulse; i++)
+	{
+	  p = &rec->u.pp.pulse[i];
+	  printf("\n    P# %d  Sum %d  NSA+ %d  Ov/Un %d/%d  #OT %d"
+		 "  CTime %d  FTime %d  Peak %d  NoVp %d  Q %d",
+		 i + 1, p->adc_sum, p->nsa_ext, p->over, p->under,
+		 p->samp_ov_thres, p->time_coarse, p->time_fine, p->vpeak,
+		 p->quality, p->quality2);
+	}
+      break;
+
+    case FAV3_DEC_SCALER:
+      for(i = 0; i < rec->u.sc.nwords; i++)
+	printf("%s%10u", ((i % 8) == 0) ? "\n   " : " ", rec->u.sc.counts[i]);
+      break;
+
+    default:
+      break;
+    }
+
+  printf("\n");
+}
+
+static void
+recordCallback(const faV3DecRecord_t * rec, void *arg)
+{
+  static uint32_t f[MAX_FIELDS];
+  uint32_t slot = rec->slot & 31;
+  int nf;
+
+  sum.slot[slot][rec->type]++;
+  if(rec->type == FAV3_DEC_WINDOW_RAW)
+    {
+      sum.chan[slot][rec->u.win.chan]++;
+      sum.samples += rec->u.win.nsamples;
+    }
+  else if(rec->type == FAV3_DEC_PULSE_PARAM)
+    {
+      sum.chan[slot][rec->u.pp.chan]++;
+      sum.pulses[slot][rec->u.pp.chan] += rec->u.pp.npulse;
+    }
+
+  if(printRecords)
+    printRecord(rec);
+
+  if(csvFile || binFile)
+    {
+      nf = recordFields(rec, f);
+      if(csvFile)
+	exportCSV(rec, f, nf);
+      if(binFile)
+	exportBinary(rec, f, nf);
+    }
+}
+
+/* Decode the whole buffer.  Returns the time taken, in seconds. */
+static double
+decodeAll(faV3Decoder_t * dec, const uint32_t * data, int64_t nwords,
+	  int order)
+{
+  static uint32_t tmp[FEED_WORDS];
+  struct timespec t0, t1;
+  int64_t off, n, i;
+
+  faV3DecoderReset(dec);
+  memset(&sum, 0, sizeof(sum));
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for(off = 0; off < nwords; off += n)
+    {
+      n = nwords - off;
+      if(n > FEED_WORDS)
+	n = FEED_WORDS;
+
+      if(order == ORDER_HSWAP)
+	{
+	  for(i = 0; i < n; i++)
+	    tmp[i] = loadWord(data[off + i], ORDER_HSWAP);
+	  faV3DecoderFeed(dec, tmp, n);
+	}
+      else
+	faV3DecoderFeed(dec, &data[off], n);
+    }
+  faV3DecoderFlush(dec);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  return (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+}
+
+static void
+printSummary(const faV3Decoder_t * dec)
+{
+  uint64_t total[FAV3_DEC_NTYPES];
+  int slot, type, chan;
+
+  memset(total, 0, sizeof(total));
+  for(slot = 0; slot < 32; slot++)
+    for(type = 0; type < FAV3_DEC_NTYPES; type++)
+      total[type] += sum.slot[slot][type];
+
+  printf("Records:\n");
+  for(type = 0; type < FAV3_DEC_NTYPES; type++)
+    printf("  %-14s %12llu\n", faV3DecoderTypeName(type),
+	   (unsigned long long) total[type]);
+  printf("  Raw samples    %12llu\n", (unsigned long long) sum.samples);
+
+  printf("Errors:\n");
+  printf("  Orphan words          %10u\n", dec->stats.orphan);
+  printf("  Extra words           %10u\n", dec->stats.overflow);
+  printf("  Trailer word count    %10u\n", dec->stats.trailer_mismatch);
+  printf("  Trailer slot          %10u\n", dec->stats.trailer_slot);
+
+  printf("Per slot:\n");
+  printf("  Slot      Blocks      Events     Windows  PulseParam     Scalers\n");
+  for(slot = 0; slot < 32; slot++)
+    {
+      if(sum.slot[slot][FAV3_DEC_BLOCK_HEADER] == 0)
+	continue;
+      printf("  %4d  %10llu  %10llu  %10llu  %10llu  %10llu\n", slot,
+	     (unsigned long long) sum.slot[slot][FAV3_DEC_BLOCK_HEADER],
+	     (unsigned long long) sum.slot[slot][FAV3_DEC_EVENT_HEADER],
+	     (unsigned long long) sum.slot[slot][FAV3_DEC_WINDOW_RAW],
+	     (unsigned long long) sum.slot[slot][FAV3_DEC_PULSE_PARAM],
+	     (unsigned long long) sum.slot[slot][FAV3_DEC_SCALER]);
+    }
+
+  printf("Per channel (window + pulse parameter records / pulses):\n");
+  for(slot = 0; slot < 32; slot++)
+    {
+      if(sum.slot[slot][FAV3_DEC_BLOCK_HEADER] == 0)
+	continue;
+      printf("  Slot %2d:\n", slot);
+      for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+	printf("    %2d: %10llu / %10llu%s", chan,
+	       (unsigned long long) sum.chan[slot][chan],
+	       (unsigned long long) sum.pulses[slot][chan],
+	       (chan & 1) ? "\n" : "   ");
+    }
+}
+
+static void
+usage(const char *prog)
+{
+  printf("Usage: %s [options] <file>\n", prog);
+  printf("  -s          Summary: records per type, slot and channel (default)\n");
+  printf("  -p          Print every record\n");
+  printf("  -c <file>   Export records as CSV\n");
+  printf("  -b <file>   Export records as packed binary\n");
+  printf("  -o <order>  Byte order: auto (default), host, lswap, hswap\n");
+  printf("  -x          Input is hex text (default: detect)\n");
+  printf("  -n <N>      Benchmark: decode N times and report the throughput\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3Decoder_t *dec;
+  const uint32_t *data;
+  uint32_t *hexwords = NULL;
+  struct stat st;
+  const char *filename;
+  char *map;
+  int64_t nwords;
+  double t, tmin = 0, ttot = 0;
+  int opt, fd, order = -1, hex = -1, summary = 0, nbench = 0, irun;
+
+  while((opt = getopt(argc, argv, "spc:b:o:xn:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 's':
+	  summary = 1;
+	  break;
+	case 'p':
+	  printRecords = 1;
+	  break;
+	case 'c':
+	  csvFile = fopen(optarg, "w");
+	  if(csvFile == NULL)
+	    {
+	      perror(optarg);
+	      return 1;
+	    }
+	  break;
+	case 'b':
+	  binFile = fopen(optarg, "wb");
+	  if(binFile == NULL)
+	    {
+	      perror(optarg);
+	      return 1;
+	    }
+	  setvbuf(binFile, NULL, _IOFBF, OUTBUF_SIZE);
+	  break;
+	case 'o':
+	  for(order = 0; order < ORDER_N; order++)
+	    if(strcmp(optarg, orderNames[order]) == 0)
+	      break;
+	  if(strcmp(optarg, "auto") == 0)
+	    order = -1;
+	  else if(order == ORDER_N)
+	    {
+	      usage(argv[0]);
+	      return 1;
+	    }
+	  break;
+	case 'x':
+	  hex = 1;
+	  break;
+	case 'n':
+	  nbench = atoi(optarg);
+	  break;
+	default:
+	  usage(argv[0]);
+	  return 1;
+	}
+    }
+
+  if(optind != argc - 1)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  filename = argv[optind];
+
+  if(!printRecords && !csvFile && !binFile && !nbench)
+    summary = 1;
+
+  fd = open(filename, O_RDONLY);
+  if((fd < 0) || (fstat(fd, &st) < 0))
+    {
+      perror(filename);
+      return 1;
+    }
+
+  if(st.st_size == 0)
+    {
+      printf("%s: empty file\n", filename);
+      return 0;
+    }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(map == MAP_FAILED)
+    {
+      perror("mmap");
+      return 1;
+    }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  if(hex < 0)
+    hex = isHexText(map, st.st_size);
+
+  if(hex)
+    {
+      nwords = parseHex(map, st.st_size, &hexwords);
+      if(nwords < 0)
+	return 1;
+      data = hexwords;
+    }
+  else
+    {
+      data = (const uint32_t *) map;
+      nwords = st.st_size / sizeof(uint32_t);
+    }
+
+  if(order < 0)
+    order = detectOrder(data, nwords);
+
+  printf("%s: %lld words (%s), byte order %s\n", filename,
+	 (long long) nwords, hex ? "hex text" : "binary", orderNames[order]);
+
+  dec = malloc(sizeof(faV3Decoder_t));
+  if(dec == NULL)
+    {
+      perror("malloc");
+      return 1;
+    }
+  faV3DecoderInit(dec, (order == ORDER_LSWAP) ? FAV3_DEC_FLAG_SWAP : 0);
+  faV3DecoderSetCallback(dec, recordCallback, NULL);
+
+  t = decodeAll(dec, data, nwords, order);
+  if(csvFile)
+    {
+      outFlush(csvFile);
+      fclose(csvFile);
+      csvFile = NULL;
+    }
+  if(binFile)
+    {
+      fclose(binFile);
+      binFile = NULL;
+    }
+  printRecords = 0;
+
+  printf("Decoded in %.3f s (%.1f MB/s)\n", t,
+	 (nwords * 4.0) / (t * 1e6));
+
+  if(summary)
+    printSummary(dec);
+
+  if(nbench > 0)
+    {
+      for(irun = 0; irun < nbench; irun++)
+	{
+	  t = decodeAll(dec, data, nwords, order);
+	  ttot += t;
+	  if((irun == 0) || (t < tmin))
+	    tmin = t;
+	}
+      printf("Benchmark: %d passes of %.1f MB\n", nbench, nwords * 4.0 / 1e6);
+      printf("  mean %.4f s  (%.1f MB/s)\n", ttot / nbench,
+	     (nwords * 4.0 * nbench) / (ttot * 1e6));
+      printf("  best %.4f s  (%.1f MB/s)\n", tmin,
+	     (nwords * 4.0) / (tmin * 1e6));
+    }
+
+  free(dec);
+  free(hexwords);
+  munmap(map, st.st_size);
+  close(fd);
+
+  return 0;
+}
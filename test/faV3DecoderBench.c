@@ -0,0 +1,383 @@
+/*
+ * File:
+ *    faV3DecoderBench.c
+ *
+ * Description:
+ *    Decoder benchmark on synthetic data from faV3DataGen.  No hardware
+ *    or bus is used.
+ *
+ *    For modes 1, 9 and 10 (PTW 100, block level 10, 16 channels with a
+ *    pulse each) a buffer of blocks is generated and decoded with
+ *    faV3DecoderFeed, into a callback and into output arrays.  The decoder
+ *    statistics are checked against the generated blocks.  The callback
+ *    run is repeated with FAV3_DEC_FLAG_SCALAR, without the SIMD sample
+ *    unpacker.  Rates are from the CPU time of the best pass, as the
+ *    wall time of a shared machine varies from pass to pass.
+ *
+ *    faV3DecodeSamples is then timed on its own, on windows of 100 and
+ *    400 samples, in host and big-endian order, with and without SIMD.
+ *    The SIMD output is compared with the scalar output.
+ *
+ *    Last, faV3IndexBuild indexes a multiblock buffer of 16 slots, with
+ *    and without SIMD, and is compared with a full decode of the buffer.
+ *    The index must hold every block and event, with no errors.
+ *
+ *    Build the library with optimization (make DEBUG=) for the rates.
+ *
+ *    Usage:
+ *      faV3DecoderBench [-m <MB of data>] [-n <passes>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3BusEmu.h"
+
+#define MAXREC     4096
+
+static uint32_t *data;
+static int32_t dataWords, dataBlocks;
+static uint64_t ncallback;
+
+static void
+countRecord(const faV3DecRecord_t * rec, void *arg)
+{
+  ncallback++;
+}
+
+static void
+initGen(faV3Gen_t * gen, int32_t slot, int32_t mode)
+{
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t ichan;
+
+  faV3GenDefaults(&cfg);
+  cfg.slot = slot;
+  cfg.mode = mode;
+  cfg.PTW = 100;
+  cfg.block_level = 10;
+  faV3GenInit(gen, &cfg);
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    faV3GenSetChannel(gen, ichan, &ch);
+}
+
+/* Fill data with blocks of one configuration, in host order */
+static void
+makeData(int32_t mode, int32_t maxwords)
+{
+  faV3Gen_t gen;
+  int32_t nw;
+
+  initGen(&gen, 3, mode);
+
+  dataWords = 0;
+  dataBlocks = 0;
+  nw = faV3GenBlockWords(&gen);
+  while(dataWords + nw <= maxwords)
+    {
+      dataWords += faV3GenBlock(&gen, data + dataWords, maxwords - dataWords);
+      dataBlocks++;
+    }
+  faV3GenFree(&gen);
+}
+
+static int32_t
+checkStats(const faV3Decoder_t * dec, int32_t npass)
+{
+  const faV3DecStats_t *st = &dec->stats;
+
+  if((st->nrec[FAV3_DEC_BLOCK_TRAILER] != (uint64_t) npass * dataBlocks)
+     || st->orphan || st->overflow || st->trailer_mismatch
+     || st->trailer_slot)
+    {
+      printf("  ERROR: %llu trailers for %d blocks, orphan %u overflow %u"
+	     " mismatch %u slot %u\n",
+	     (unsigned long long) st->nrec[FAV3_DEC_BLOCK_TRAILER],
+	     npass * dataBlocks, st->orphan, st->overflow,
+	     st->trailer_mismatch, st->trailer_slot);
+      return 1;
+    }
+
+  return 0;
+}
+
+/* GB/s of input words, in CPU time of the best pass */
+static double
+runCallback(uint32_t flags, int32_t npass, int32_t * nerr)
+{
+  static faV3Decoder_t dec;
+  double t0, best = 1e9;
+  int32_t ipass;
+
+  faV3DecoderInit(&dec, flags);
+  faV3DecoderSetCallback(&dec, countRecord, NULL);
+  ncallback = 0;
+
+  for(ipass = 0; ipass < npass; ipass++)
+    {
+      t0 = faV3BusEmuCpuTime();
+      faV3DecoderFeed(&dec, data, dataWords);
+      t0 = faV3BusEmuCpuTime() - t0;
+      if(t0 < best)
+	best = t0;
+    }
+  faV3DecoderFlush(&dec);
+
+  *nerr += checkStats(&dec, npass);
+
+  return 4.0 * dataWords / best / 1e9;
+}
+
+static double
+runArrays(uint32_t flags, int32_t npass, int32_t * nerr)
+{
+  static faV3Decoder_t dec;
+  static faV3DecRecord_t rec[MAXREC];
+  static uint16_t samples[MAXREC * 128];
+  static uint32_t words[MAXREC * 8];
+  faV3DecOutput_t out;
+  double t0, best = 1e9;
+  int32_t ipass, off, nw;
+
+  out.rec = rec;
+  out.maxrec = MAXREC;
+  out.samples = samples;
+  out.maxsamples = MAXREC * 128;
+  out.words = words;
+  out.maxwords = MAXREC * 8;
+  faV3DecoderInit(&dec, flags);
+  faV3DecoderSetOutput(&dec, &out);
+
+  for(ipass = 0; ipass < npass; ipass++)
+    {
+      t0 = faV3BusEmuCpuTime();
+      for(off = 0; off < dataWords; off += nw)
+	{
+	  out.nrec = out.nsamples = out.nwords = 0;
+	  nw = faV3DecoderFeed(&dec, data + off, dataWords - off);
+	  if(nw <= 0)
+	    {
+	      printf("  ERROR: feed returned %d\n", nw);
+	      (*nerr)++;
+	      break;
+	    }
+	}
+      t0 = faV3BusEmuCpuTime() - t0;
+      if(t0 < best)
+	best = t0;
+    }
+  faV3DecoderFlush(&dec);
+
+  *nerr += checkStats(&dec, npass);
+
+  return 4.0 * dataWords / best / 1e9;
+}
+
+/* Unpack rate in Gsamples/s of windows of width samples */
+static double
+runSamples(int32_t width, uint32_t flags, int32_t nwin, uint16_t * samples,
+	   uint32_t * invalid)
+{
+  int32_t nw = width / 2, iwin, off;
+  double t0;
+
+  t0 = faV3BusEmuTime();
+  for(iwin = 0, off = 0; iwin < nwin; iwin++)
+    {
+      memset(invalid, 0, FAV3_DEC_INVALID_WORDS(width) << 2);
+      faV3DecodeSamples(data + off, nw, flags, samples, invalid, 0);
+      off += nw;
+      if(off + nw > dataWords)
+	off = 0;
+    }
+  t0 = faV3BusEmuTime() - t0;
+
+  return (double) width * nwin / t0 / 1e9;
+}
+
+static void
+benchSamples(int32_t * nerr)
+{
+  static uint16_t s0[FAV3_DEC_MAX_SAMPLES], s1[FAV3_DEC_MAX_SAMPLES];
+  static uint32_t i0[FAV3_DEC_INVALID_WORDS(FAV3_DEC_MAX_SAMPLES)];
+  static uint32_t i1[FAV3_DEC_INVALID_WORDS(FAV3_DEC_MAX_SAMPLES)];
+  int32_t widths[2] = { 100, 400 };
+  uint32_t orders[2] = { 0, FAV3_DEC_FLAG_SWAP };
+  int32_t iw, io, ii, nwin;
+
+  /* Sample words with an invalid flag now and then */
+  dataWords = 1 << 20;
+  srand(1);
+  for(ii = 0; ii < dataWords; ii++)
+    {
+      data[ii] = ((rand() & 0xFFF) << 16) | (rand() & 0xFFF);
+      if((rand() & 0xFF) == 0)
+	data[ii] |= 0x20000000;
+      if((rand() & 0xFF) == 0)
+	data[ii] |= 0x2000;
+    }
+
+  printf("\nfaV3DecodeSamples in Gsamples/s\n\n");
+  printf("width  order        SIMD  scalar\n");
+  for(iw = 0; iw < 2; iw++)
+    for(io = 0; io < 2; io++)
+      {
+	if(io)
+	  for(ii = 0; ii < dataWords; ii++)
+	    data[ii] = __builtin_bswap32(data[ii]);
+
+	/* Same output with and without SIMD */
+	for(ii = 0; ii + widths[iw] / 2 <= dataWords; ii += 4099)
+	  {
+	    memset(i0, 0, sizeof(i0));
+	    memset(i1, 0, sizeof(i1));
+	    faV3DecodeSamples(data + ii, widths[iw] / 2, orders[io], s0, i0, 0);
+	    faV3DecodeSamples(data + ii, widths[iw] / 2,
+			      orders[io] | FAV3_DEC_FLAG_SCALAR, s1, i1, 0);
+	    if(memcmp(s0, s1, widths[iw] << 1)
+	       || memcmp(i0, i1, FAV3_DEC_INVALID_WORDS(widths[iw]) << 2))
+	      {
+		printf("  ERROR: SIMD and scalar differ at word %d\n", ii);
+		(*nerr)++;
+		break;
+	      }
+	  }
+
+	nwin = 200000000 / widths[iw];
+	printf("%5d  %-10s  %6.2f  %6.2f\n", widths[iw],
+	       io ? "big-endian" : "host",
+	       runSamples(widths[iw], orders[io], nwin, s0, i0),
+	       runSamples(widths[iw], orders[io] | FAV3_DEC_FLAG_SCALAR, nwin,
+			  s0, i0));
+
+	if(io)
+	  for(ii = 0; ii < dataWords; ii++)
+	    data[ii] = __builtin_bswap32(data[ii]);
+      }
+}
+
+/* Buffers indexed per second */
+static double
+runIndex(faV3Index_t * idx, uint32_t flags, int32_t npass, int32_t * nerr)
+{
+  double t0;
+  int32_t ipass;
+
+  t0 = faV3BusEmuTime();
+  for(ipass = 0; ipass < npass; ipass++)
+    faV3IndexBuild(idx, data, dataWords, flags);
+  t0 = faV3BusEmuTime() - t0;
+
+  if((idx->nblocks != 16) || (idx->nevents != 160) || idx->nerrors
+     || idx->orphan || idx->truncated || (idx->slotmask != 0x7FFF8))
+    {
+      printf("  ERROR: %d blocks, %d events, %u errors, mask 0x%x\n",
+	     idx->nblocks, idx->nevents, idx->nerrors, idx->slotmask);
+      (*nerr)++;
+    }
+
+  return npass / t0;
+}
+
+static void
+benchIndex(int32_t * nerr)
+{
+  static faV3Gen_t gen[16];
+  static faV3IndexBlock_t blocks[64];
+  static uint32_t events[1024];
+  static faV3Decoder_t dec;
+  faV3Index_t idx;
+  int32_t modes[3] = { 1, 9, 10 };
+  int32_t imode, igen, ipass, npass;
+  double t0, tdec;
+
+  memset(&idx, 0, sizeof(idx));
+  idx.blocks = blocks;
+  idx.maxblocks = 64;
+  idx.events = events;
+  idx.maxevents = 1024;
+
+  printf("\nfaV3IndexBuild, 16 slots x 10 events, in buffers/s\n\n");
+  printf("mode   words      SIMD    scalar    decode\n");
+  for(imode = 0; imode < 3; imode++)
+    {
+      for(igen = 0; igen < 16; igen++)
+	initGen(&gen[igen], 3 + igen, modes[imode]);
+      dataWords = faV3GenCrate(gen, 16, data, 1 << 22);
+      for(igen = 0; igen < 16; igen++)
+	faV3GenFree(&gen[igen]);
+
+      npass = 200000000 / dataWords;
+
+      faV3DecoderInit(&dec, 0);
+      faV3DecoderSetCallback(&dec, countRecord, NULL);
+      t0 = faV3BusEmuTime();
+      for(ipass = 0; ipass < npass / 4; ipass++)
+	faV3DecoderFeed(&dec, data, dataWords);
+      tdec = (npass / 4) / (faV3BusEmuTime() - t0);
+
+      printf("%4d  %6d  %8.0f  %8.0f  %8.0f\n", modes[imode], dataWords,
+	     runIndex(&idx, 0, npass, nerr),
+	     runIndex(&idx, FAV3_DEC_FLAG_SCALAR, npass, nerr), tdec);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t modes[3] = { 1, 9, 10 };
+  int32_t imode, maxwords, npass = 5, megabytes = 64, nerr = 0, opt;
+
+  while((opt = getopt(argc, argv, "m:n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'm':
+	  megabytes = atoi(optarg);
+	  break;
+	case 'n':
+	  npass = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-m <MB of data>] [-n <passes>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  maxwords = megabytes << 18;
+  data = malloc(maxwords << 2);
+  if(data == NULL)
+    exit(1);
+
+  printf("\nDecode rate in GB/s of 32-bit words, CPU time of the best of"
+	 " %d passes over %d MB.\n\n",
+	 npass, megabytes);
+  printf("mode  block words  callback   arrays   scalar\n");
+  for(imode = 0; imode < 3; imode++)
+    {
+      makeData(modes[imode], maxwords);
+      printf("%4d  %11d  %8.2f %8.2f %8.2f\n", modes[imode],
+	     dataWords / dataBlocks, runCallback(0, npass, &nerr),
+	     runArrays(0, npass, &nerr),
+	     runCallback(FAV3_DEC_FLAG_SCALAR, npass, &nerr));
+    }
+
+  benchSamples(&nerr);
+  benchIndex(&nerr);
+  printf("\n%d errors\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,244 @@
+/*
+ * File:
+ *    faV3DmaBench.c
+ *
+ * Description:
+ *    Benchmark of the split-phase DMA readout (faV3ReadBlockStart /
+ *    faV3ReadBlockDone) against faV3ReadBlock, on the emulated VME bus.
+ *
+ *    For modes 1, 9 and 10 and block levels 1-40, a block from the data
+ *    generator is read and decoded over and over:
+ *      blocking: faV3ReadBlock, then decode
+ *      split:    complete block N, start block N+1, decode block N
+ *    The emulated DMA engine takes the setup time plus bytes / rate, and
+ *    leaves the CPU free meanwhile.
+ *
+ *    Then two threads read the same board, one with faV3ReadBlock and
+ *    one with the split-phase calls, to check that they take turns.
+ *
+ *    Usage:
+ *      faV3DmaBench [-r <MB/s>] [-t <seconds per point>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3BusEmu.h"
+
+#define SLOT      3
+#define MAXWORDS  (1 << 20)
+
+static uint32_t *block;
+static int32_t blockWords = 0;
+static faV3Decoder_t dec;
+
+/* The board has one block ready every time */
+static int32_t
+dmaFill(int32_t slot, uint32_t * data, int32_t nwords)
+{
+  int32_t n = (blockWords < nwords) ? blockWords : nwords;
+
+  memcpy(data, block, n << 2);
+  return n;
+}
+
+static void
+decode(const uint32_t * buf, int32_t nwords)
+{
+  faV3DecoderFeed(&dec, buf, nwords);
+}
+
+static int32_t
+makeBlock(int32_t mode, int32_t blocklevel)
+{
+  faV3Gen_t gen;
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t ichan;
+
+  faV3GenDefaults(&cfg);
+  cfg.slot = SLOT;
+  cfg.mode = mode;
+  cfg.block_level = blocklevel;
+  cfg.flags = FAV3_GEN_FLAG_SWAP;	/* as read from the board */
+  faV3GenInit(&gen, &cfg);
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    faV3GenSetChannel(&gen, ichan, &ch);
+
+  blockWords = faV3GenBlock(&gen, block, MAXWORDS);
+  faV3GenFree(&gen);
+
+  return blockWords;
+}
+
+/* Seconds per block */
+static double
+runBlocking(uint32_t * buf, int32_t nblock, int32_t * nerr)
+{
+  double t0 = faV3BusEmuTime();
+  int32_t iblock, nw;
+
+  for(iblock = 0; iblock < nblock; iblock++)
+    {
+      nw = faV3ReadBlock(SLOT, buf, MAXWORDS, 1);
+      if(nw != blockWords)
+	(*nerr)++;
+      decode(buf, nw);
+    }
+
+  return (faV3BusEmuTime() - t0) / nblock;
+}
+
+static double
+runSplit(uint32_t * buf[2], int32_t nblock, int32_t * nerr)
+{
+  double t0 = faV3BusEmuTime();
+  int32_t iblock, nw;
+
+  if(faV3ReadBlockStart(SLOT, buf[0], MAXWORDS, 1) != OK)
+    (*nerr)++;
+  for(iblock = 0; iblock < nblock; iblock++)
+    {
+      nw = faV3ReadBlockDone();
+      if(nw != blockWords)
+	(*nerr)++;
+      if(iblock + 1 < nblock)
+	if(faV3ReadBlockStart(SLOT, buf[(iblock + 1) & 1], MAXWORDS, 1) != OK)
+	  (*nerr)++;
+      decode(buf[iblock & 1], nw);
+    }
+
+  return (faV3BusEmuTime() - t0) / nblock;
+}
+
+static double
+timeDecode(const uint32_t * buf, int32_t nblock)
+{
+  double t0 = faV3BusEmuTime();
+  int32_t iblock;
+
+  for(iblock = 0; iblock < nblock; iblock++)
+    decode(buf, blockWords);
+
+  return (faV3BusEmuTime() - t0) / nblock;
+}
+
+/* Two threads on the DMA engine */
+static volatile int32_t sharedErr = 0;
+
+static void *
+blockingThread(void *arg)
+{
+  uint32_t *buf = arg;
+  int32_t iblock;
+
+  for(iblock = 0; iblock < 2000; iblock++)
+    if(faV3ReadBlock(SLOT, buf, MAXWORDS, 1) != blockWords)
+      __sync_fetch_and_add(&sharedErr, 1);
+
+  return NULL;
+}
+
+static void *
+splitThread(void *arg)
+{
+  uint32_t *buf = arg;
+  int32_t iblock, berr;
+
+  for(iblock = 0; iblock < 2000; iblock++)
+    {
+      if(faV3ReadBlockStart(SLOT, buf, MAXWORDS, 1) != OK)
+	{
+	  __sync_fetch_and_add(&sharedErr, 1);
+	  continue;
+	}
+      berr = -1;
+      if((faV3ReadBlockDoneStatus(&berr) != blockWords) ||
+	 (berr != FAV3_BLOCKERROR_NO_ERROR))
+	__sync_fetch_and_add(&sharedErr, 1);
+    }
+
+  return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t modes[3] = { 1, 9, 10 };
+  int32_t levels[5] = { 1, 5, 10, 20, 40 };
+  int32_t imode, ilevel, nblock, nerr = 0, rate = 200, opt;
+  double seconds = 0.2, tdma, tdec, tblk, tsplit;
+  uint32_t *buf[2];
+  pthread_t th[2];
+
+  while((opt = getopt(argc, argv, "r:t:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'r':
+	  rate = atoi(optarg);
+	  break;
+	case 't':
+	  seconds = atof(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-r <MB/s>] [-t <seconds per point>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  block = malloc(MAXWORDS << 2);
+  buf[0] = malloc(MAXWORDS << 2);
+  buf[1] = malloc(MAXWORDS << 2);
+
+  faV3BusEmuInit(1 << SLOT);
+  faV3BusEmuSetDmaFunc(dmaFill, rate);
+  if(faV3Init(SLOT << 19, 1 << 19, 1, FAV3_INIT_SKIP) != 1)
+    exit(1);
+
+  faV3DecoderInit(&dec, FAV3_DEC_FLAG_SWAP);
+
+  printf("\nDMA at %d MB/s.  Times are per block, in us.\n\n", rate);
+  printf("mode  level   words      DMA   decode  blocking    split  gain\n");
+  for(imode = 0; imode < 3; imode++)
+    for(ilevel = 0; ilevel < 5; ilevel++)
+      {
+	makeBlock(modes[imode], levels[ilevel]);
+	tdma = 2e-6 + (blockWords << 2) / (rate * 1e6);
+
+	nblock = (int32_t) (seconds / (2 * tdma)) + 10;
+	tdec = timeDecode(block, nblock);
+	tblk = runBlocking(buf[0], nblock, &nerr);
+	tsplit = runSplit(buf, nblock, &nerr);
+
+	printf("%4d  %5d  %6d  %7.1f  %7.1f  %8.1f  %7.1f  %4.2f\n",
+	       modes[imode], levels[ilevel], blockWords, tdma * 1e6,
+	       tdec * 1e6, tblk * 1e6, tsplit * 1e6, tblk / tsplit);
+      }
+  printf("\nBlocks with the wrong word count: %d\n", nerr);
+
+  /* faV3ReadBlock waits for the split-phase transfer of another thread */
+  makeBlock(1, 1);
+  pthread_create(&th[0], NULL, blockingThread, buf[0]);
+  pthread_create(&th[1], NULL, splitThread, buf[1]);
+  pthread_join(th[0], NULL);
+  pthread_join(th[1], NULL);
+  printf("Two threads, 2 x 2000 blocks: %d errors\n", sharedErr);
+
+  exit((nerr || sharedErr) ? 1 : 0);
+}
@@ -0,0 +1,219 @@
+/*
+ * File:
+ *    faV3DownloadBench.c
+ *
+ * Description:
+ *    Time of a prestart configuration (faV3DownloadAll of a configuration
+ *    file) of 16 boards (slots 3-10, 13-20) for 1 to 8 download threads,
+ *    on the emulated VME bus at -c ns per single cycle, with and without
+ *    the shadow registers, and the single cycle writes per board.
+ *
+ *    The thresholds and trigger gains are batched (faV3ShadowBatch): each
+ *    must be written exactly once per board and download, and with the
+ *    shadow enabled it must agree with the boards after the download.
+ *
+ *    Then checks the summary: with the DAC of slot 8 never ready,
+ *    faV3DownloadAll must return -1, faV3DownloadStatus must count the
+ *    16 failed faV3DACSet calls of slot 8 and none for the other boards,
+ *    and -1 for a slot that was not downloaded.
+ *
+ *    Usage:
+ *      faV3DownloadBench [-c <cycle ns>] [-f <config file>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Config.h"
+#include "faV3BusEmu.h"
+
+#define SLOTMASK  0x1FE7F8	/* slots 3-10, 13-20 */
+#define NBOARDS   16
+#define BADSLOT   8
+#define NREPEAT   5
+
+static volatile int32_t dacFail = 0;
+static volatile int32_t nchanWrite = 0;	/* to the per channel registers */
+static int32_t stdoutFd = -1;
+static double writesPerBoard;
+
+/* The DAC is ready and the write succeeds, except for BADSLOT with
+   dacFail set */
+static void
+dacReady(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  if(write && (slot == 3) &&
+     (((offset >= offsetof(faV3_t, adc.thres)) &&
+       (offset < offsetof(faV3_t, adc.thres[FAV3_MAX_ADC_CHANNELS]))) ||
+      ((offset >= offsetof(faV3_t, adc.trig_gain)) &&
+       (offset < offsetof(faV3_t, adc.trig_gain[FAV3_MAX_ADC_CHANNELS])))))
+    nchanWrite++;
+
+  if(!write && (offset == offsetof(faV3_t, dac_csr)))
+    {
+      if(dacFail && (slot == BADSLOT))
+	*value &= ~(FAV3_DAC_READY | FAV3_DAC_SUCCESS);
+      else
+	*value |= FAV3_DAC_READY | FAV3_DAC_SUCCESS;
+    }
+}
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+/* Best of NREPEAT downloads, in ms */
+static double
+download(int32_t nthreads)
+{
+  faV3BusEmuCount_t count;
+  double t0, best = 1e9;
+  int32_t irep, rval;
+
+  faV3SetDownloadThreads(nthreads);
+  for(irep = 0; irep < NREPEAT; irep++)
+    {
+      quiet(1);
+      nchanWrite = 0;
+      faV3BusEmuClearCount();
+      t0 = faV3BusEmuTime();
+      rval = faV3DownloadAll();
+      t0 = faV3BusEmuTime() - t0;
+      quiet(0);
+      if(rval != 0)
+	{
+	  printf("ERROR: faV3DownloadAll returned %d\n", rval);
+	  exit(1);
+	}
+      faV3BusEmuGetCount(&count);
+      writesPerBoard = (double) count.nwrite / NBOARDS;
+      if(nchanWrite != 2 * FAV3_MAX_ADC_CHANNELS)
+	{
+	  printf("ERROR: %d writes to the per channel registers of slot 3\n",
+		 nchanWrite);
+	  exit(1);
+	}
+      if(t0 < best)
+	best = t0;
+    }
+
+  return 1e3 * best;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const int32_t threads[] = { 1, 2, 4, 8 };
+  char *fname = "faV3.cfg";
+  int32_t cycle = 1000, slot, ithr, nerr = 0, rval, opt;
+  double ms;
+
+  while((opt = getopt(argc, argv, "c:f:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'f':
+	  fname = optarg;
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-f <config file>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  faV3BusEmuInit(SLOTMASK);
+  /* firmware with the per channel gain, delay and invert registers */
+  for(slot = 3; slot <= 20; slot++)
+    if(SLOTMASK & (1 << slot))
+      *faV3BusEmuReg(slot, offsetof(faV3_t, adc.status0)) =
+	FAV3_PROC_PRAD_FIRMWARE;
+
+  if(faV3Init(3 << 19, 1 << 19, 18,
+	      FAV3_INIT_SKIP | FAV3_INIT_SKIP_FIRMWARE_CHECK) != NBOARDS)
+    exit(1);
+
+  faV3InitGlobals();
+  if(faV3ReadConfigFile(fname) < 0)
+    exit(1);
+
+  faV3BusEmuSetRegFunc(dacReady);
+  faV3BusEmuSetCycle(cycle);
+
+  printf("\n%d boards, %d ns per cycle, %s, best of %d\n\n",
+	 NBOARDS, cycle, fname, NREPEAT);
+  printf("threads   crate ms  writes/board   with shadow  writes/board\n");
+  for(ithr = 0; ithr < 4; ithr++)
+    {
+      ms = download(threads[ithr]);
+      printf("%7d  %9.3f  %12.1f", threads[ithr], ms, writesPerBoard);
+      faV3GShadowEnable(1);
+      ms = download(threads[ithr]);
+      printf("  %12.3f  %12.1f\n", ms, writesPerBoard);
+      if(faV3GShadowVerify(FAV3_SHADOW_VERIFY) != 0)
+	{
+	  printf("ERROR: shadow and boards differ after the download\n");
+	  nerr++;
+	}
+      faV3GShadowEnable(0);
+    }
+
+  /* Summary of a download with a failing board */
+  faV3SetDownloadThreads(FAV3_DOWNLOAD_THREADS);
+  dacFail = 1;
+  quiet(1);
+  rval = faV3DownloadAll();
+  quiet(0);
+  dacFail = 0;
+
+  printf("\nDAC of slot %d not ready:\n", BADSLOT);
+  printf("  faV3DownloadAll returned %d\n", rval);
+  if(rval != -1)
+    nerr++;
+  for(slot = 3; slot <= 20; slot++)
+    {
+      rval = faV3DownloadStatus(slot);
+      if(!(SLOTMASK & (1 << slot)))
+	{
+	  if(rval != -1)
+	    nerr++;
+	  continue;
+	}
+      if(rval != ((slot == BADSLOT) ? FAV3_MAX_ADC_CHANNELS : 0))
+	{
+	  printf("  ERROR: slot %d: %d failed calls\n", slot, rval);
+	  nerr++;
+	}
+    }
+  printf("  faV3DownloadStatus(%d) = %d, other slots %s\n", BADSLOT,
+	 faV3DownloadStatus(BADSLOT), nerr ? "WRONG" : "0");
+
+  faV3BusEmuSetRegFunc(NULL);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,295 @@
+/*
+ * File:
+ *    faV3DownloadChangedBench.c
+ *
+ * Description:
+ *    Bus cycles of a download after a small configuration edit, on the
+ *    emulated VME bus with 16 boards (slots 3-10, 13-20).
+ *
+ *    Configuration A is the -f file with some channels ignored and
+ *    inverted.  Configuration B is A with three thresholds changed.
+ *    From the boards configured with A, B is downloaded:
+ *      full       faV3DownloadAll
+ *      changed    faV3DownloadChanged, against the last download
+ *      readback   faV3DownloadChanged(FAV3_DOWNLOAD_READBACK)
+ *    Each must leave the same register contents, and the dry run must
+ *    list the changes without a write.  Reports the reads and writes of
+ *    the crate and the time at -c ns per single cycle.
+ *
+ *    Usage:
+ *      faV3DownloadChangedBench [-c <cycle ns>] [-f <config file>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Config.h"
+#include "faV3BusEmu.h"
+
+#define SLOTMASK  0x1FE7F8	/* slots 3-10, 13-20 */
+#define NBOARDS   16
+
+static const char *editA =
+  "\nFAV3_CRATE all\n"
+  "FAV3_SLOT all\n"
+  "FAV3_TET_IGNORE_MASK 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 1\n"
+  "FAV3_INVERT_MASK     0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 0\n"
+  "FAV3_CRATE end\n";
+
+static const char *editB =
+  "\nFAV3_CRATE all\n"
+  "FAV3_SLOT 5\n"
+  "FAV3_CH_TET 3 120\n"
+  "FAV3_SLOT 14\n"
+  "FAV3_CH_TET 0 90\n"
+  "FAV3_CH_TET 7 150\n"
+  "FAV3_CRATE end\n";
+
+static faV3_t mapA[FAV3_MAX_BOARDS + 1];
+static faV3_t mapFull[FAV3_MAX_BOARDS + 1];
+static uint32_t dacChan[FAV3_MAX_BOARDS + 1];
+static uint32_t dacValue[FAV3_MAX_BOARDS + 1][FAV3_MAX_ADC_CHANNELS];
+static int32_t stdoutFd = -1;
+
+/* Serial DAC: ready at once, a value kept for each channel */
+static void
+dacReg(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  if(offset == offsetof(faV3_t, dac_csr))
+    {
+      if(write)
+	dacChan[slot] = *value & 0xF;
+      else
+	*value |= FAV3_DAC_READY | FAV3_DAC_SUCCESS;
+    }
+  else if(offset == offsetof(faV3_t, dac_data))
+    {
+      if(write)
+	dacValue[slot][dacChan[slot]] = *value & FAV3_DAC_DATA_MASK;
+      else
+	*value = (dacChan[slot] << 14) | dacValue[slot][dacChan[slot]];
+    }
+}
+
+/* Configuration file: the -f file followed by the edits */
+static char *
+writeConfig(const char *fname, const char *edit1, const char *edit2)
+{
+  static char name[2][64];
+  static int32_t iname = 0;
+  char line[1024];
+  FILE *in, *out;
+  char *path = name[iname++ & 1];
+
+  strcpy(path, "/tmp/faV3DownloadChangedBench.XXXXXX");
+  out = fdopen(mkstemp(path), "w");
+  in = fopen(fname, "r");
+  if((in == NULL) || (out == NULL))
+    {
+      perror(fname);
+      exit(1);
+    }
+  while(fgets(line, sizeof(line), in) != NULL)
+    fputs(line, out);
+  fclose(in);
+  fputs(edit1, out);
+  if(edit2)
+    fputs(edit2, out);
+  fclose(out);
+
+  return path;
+}
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+static void
+copyMaps(faV3_t * map, int32_t save)
+{
+  int32_t slot;
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      if(save)
+	memcpy(&map[slot], (void *) faV3BusEmuReg(slot, 0), sizeof(faV3_t));
+      else
+	memcpy((void *) faV3BusEmuReg(slot, 0), &map[slot], sizeof(faV3_t));
+    }
+}
+
+static int32_t
+compareMaps(const char *name, const faV3_t * map)
+{
+  const uint32_t *ref, *reg;
+  int32_t slot, ii, nerr = 0;
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      ref = (const uint32_t *) &map[slot];
+      reg = (const uint32_t *) faV3BusEmuReg(slot, 0);
+      for(ii = 0; ii < sizeof(faV3_t) / 4; ii++)
+	{
+	  if(ref[ii] == reg[ii])
+	    continue;
+	  if(nerr++ < 10)
+	    printf("  ERROR: %s: slot %d 0x%03x: 0x%08x, full download "
+		   "0x%08x\n", name, slot, ii << 2, reg[ii], ref[ii]);
+	}
+    }
+
+  return nerr;
+}
+
+static int32_t
+download(const char *name, int32_t flags, const faV3_t * ref)
+{
+  faV3BusEmuCount_t count;
+  double t0;
+  int32_t rval, nerr = 0;
+
+  copyMaps(mapA, 0);
+  faV3BusEmuClearCount();
+  quiet(1);
+  t0 = faV3BusEmuTime();
+  if(flags < 0)
+    rval = faV3DownloadAll();
+  else
+    rval = faV3DownloadChanged(flags);
+  t0 = faV3BusEmuTime() - t0;
+  quiet(0);
+  faV3BusEmuGetCount(&count);
+
+  if(rval != 0)
+    {
+      printf("  ERROR: %s returned %d\n", name, rval);
+      nerr++;
+    }
+  if(ref)
+    nerr += compareMaps(name, ref);
+
+  printf("%-10s  %8llu  %8llu  %8.3f\n", name,
+	 (unsigned long long) count.nread,
+	 (unsigned long long) count.nwrite, 1e3 * t0);
+
+  return nerr;
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3BusEmuCount_t count;
+  char *fname = "faV3.cfg", *cfgA, *cfgB;
+  int32_t cycle = 1000, slot, nerr = 0, opt;
+
+  while((opt = getopt(argc, argv, "c:f:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'f':
+	  fname = optarg;
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-f <config file>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  cfgA = writeConfig(fname, editA, NULL);
+  cfgB = writeConfig(fname, editA, editB);
+
+  faV3BusEmuInit(SLOTMASK);
+  /* firmware with the per channel gain, delay and invert registers */
+  for(slot = 3; slot <= 20; slot++)
+    if(SLOTMASK & (1 << slot))
+      *faV3BusEmuReg(slot, offsetof(faV3_t, adc.status0)) =
+	FAV3_PROC_PRAD_FIRMWARE;
+
+  quiet(1);
+  if(faV3Init(3 << 19, 1 << 19, 18,
+	      FAV3_INIT_SKIP | FAV3_INIT_SKIP_FIRMWARE_CHECK) != NBOARDS)
+    exit(1);
+  faV3BusEmuSetRegFunc(dacReg);
+
+  /* Boards configured with A */
+  faV3InitGlobals();
+  if((faV3ReadConfigFile(cfgA) < 0) || (faV3DownloadAll() != 0))
+    exit(1);
+  quiet(0);
+  copyMaps(mapA, 1);
+
+  faV3InitGlobals();
+  quiet(1);
+  if(faV3ReadConfigFile(cfgB) < 0)
+    exit(1);
+  quiet(0);
+
+  printf("\nDry run of %s after %s:\n", "B", "A");
+  faV3BusEmuClearCount();
+  faV3DownloadChanged(FAV3_DOWNLOAD_DRYRUN);
+  faV3BusEmuGetCount(&count);
+  if(count.nwrite)
+    {
+      printf("  ERROR: %llu writes in the dry run\n",
+	     (unsigned long long) count.nwrite);
+      nerr++;
+    }
+
+  faV3BusEmuSetCycle(cycle);
+  printf("\n%d boards, %d ns per cycle, %s\n\n", NBOARDS, cycle, fname);
+  printf("download       reads    writes  crate ms\n");
+
+  nerr += download("full", -1, NULL);
+  copyMaps(mapFull, 1);
+
+  /* The last download is A again */
+  quiet(1);
+  faV3InitGlobals();
+  faV3ReadConfigFile(cfgA);
+  copyMaps(mapA, 0);
+  faV3DownloadAll();
+  faV3InitGlobals();
+  faV3ReadConfigFile(cfgB);
+  quiet(0);
+
+  nerr += download("changed", 0, mapFull);
+  nerr += download("readback", FAV3_DOWNLOAD_READBACK, mapFull);
+
+  faV3BusEmuSetRegFunc(NULL);
+  unlink(cfgA);
+  unlink(cfgB);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
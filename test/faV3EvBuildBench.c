@@ -0,0 +1,317 @@
+/*
+ * File:
+ *    faV3EvBuildBench.c
+ *
+ * Description:
+ *    Checks and rate of the cross-slot event builder (faV3EvBuild), on
+ *    synthetic crate data from faV3DataGen.  No hardware or bus is used.
+ *
+ *    16 boards (slots 3-10, 13-20) in mode 9, 4 channels, block level 10,
+ *    20000 triggers, so the 12 bit trigger number rolls over 4 times.  Each
+ *    readout (one block from every board, back to back) is pushed as one
+ *    buffer.  Slot 7 leaves out the block of triggers 5001-5010 (a skipped
+ *    block), and slot 20 the 4 blocks of triggers 12001-12040 (a stalled
+ *    slot: the queues of the other slots fill and events are forced out).
+ *
+ *    For each event: trigger numbers come in order, one by one, past the
+ *    rollover; exactly the slots above are missing, and a slot is flagged
+ *    mismatched only where it is missing; the 48 bit trigger time is right,
+ *    with and without TRIGGER TIME word 2 (faV3DataSuppressTriggerTime 2);
+ *    each slot points to its own event header.  Some events of the stall
+ *    must be forced out (missing, not mismatched), every buffer must be
+ *    given back once and in order, and the builder statistics must agree.
+ *
+ *    All of this is run building in faV3EvBuildPoll, after each push, and
+ *    on the builder thread.  Rates are triggers per second from the first
+ *    push to the end of faV3EvBuildFlush, best of the passes.
+ *
+ *    Build the library with optimization (make DEBUG=) for the rates.
+ *
+ *    Usage:
+ *      faV3EvBuildBench [-n <passes>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sched.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3EvBuild.h"
+#include "faV3BusEmu.h"
+
+#define NBOARDS     16
+#define BLOCKLEVEL  10
+#define NTRIG       20000
+#define NREADOUT    (NTRIG / BLOCKLEVEL)
+#define PERIOD      5000	/* ticks between triggers: 2^24 every 3355 */
+#define NBUF        64
+#define MAXWORDS    (1 << 23)
+
+#define SKIP_SLOT   7
+#define SKIP_READ   500		/* triggers 5001 - 5010 */
+#define STALL_SLOT  20
+#define STALL_READ  1200	/* triggers 12001 - 12040 */
+#define STALL_LEN   4
+
+static uint32_t data[MAXWORDS];
+static int32_t readStart[NREADOUT + 1];
+static uint32_t allSlots;
+
+static uint32_t nextEvt, nbad, nforced, nextDone, ndone;
+
+static int32_t
+slotOf(int32_t igen)
+{
+  return (igen < 8) ? 3 + igen : 5 + igen;	/* switch slots 11, 12 */
+}
+
+/* Slots expected to be missing for a trigger */
+static uint32_t
+expectMissing(uint32_t evt_num)
+{
+  uint32_t missing = 0;
+
+  if((evt_num > SKIP_READ * BLOCKLEVEL) &&
+     (evt_num <= (SKIP_READ + 1) * BLOCKLEVEL))
+    missing |= 1u << SKIP_SLOT;
+  if((evt_num > STALL_READ * BLOCKLEVEL) &&
+     (evt_num <= (STALL_READ + STALL_LEN) * BLOCKLEVEL))
+    missing |= 1u << STALL_SLOT;
+
+  return missing;
+}
+
+/* The crate data, with the blocks of the skipped and stalled slots left
+   out.  suppress_tt 2: no TRIGGER TIME word 2. */
+static void
+makeCrate(uint32_t suppress_tt)
+{
+  faV3Gen_t gen[NBOARDS];
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t igen, ichan, iread, n, nwords = 0, slot;
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+
+  allSlots = 0;
+  for(igen = 0; igen < NBOARDS; igen++)
+    {
+      faV3GenDefaults(&cfg);
+      cfg.slot = slotOf(igen);
+      cfg.mode = 9;
+      cfg.chan_mask = 0x000F;
+      cfg.block_level = BLOCKLEVEL;
+      cfg.trig_period = PERIOD;
+      cfg.suppress_tt = suppress_tt;
+      faV3GenInit(&gen[igen], &cfg);
+      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	faV3GenSetChannel(&gen[igen], ichan, &ch);
+      allSlots |= 1u << cfg.slot;
+    }
+
+  for(iread = 0; iread < NREADOUT; iread++)
+    {
+      readStart[iread] = nwords;
+      for(igen = 0; igen < NBOARDS; igen++)
+	{
+	  slot = slotOf(igen);
+	  n = faV3GenBlock(&gen[igen], &data[nwords], MAXWORDS - nwords);
+	  if(n < 0)
+	    {
+	      printf("ERROR: data does not fit\n");
+	      exit(1);
+	    }
+	  if(((slot == SKIP_SLOT) && (iread == SKIP_READ)) ||
+	     ((slot == STALL_SLOT) && (iread >= STALL_READ) &&
+	      (iread < STALL_READ + STALL_LEN)))
+	    continue;		/* generated, then left out */
+	  nwords += n;
+	}
+    }
+  readStart[NREADOUT] = nwords;
+
+  for(igen = 0; igen < NBOARDS; igen++)
+    faV3GenFree(&gen[igen]);
+}
+
+static void
+checkEvent(const faV3EvBuildEvent_t * evt, void *arg)
+{
+  uint32_t missing = expectMissing(nextEvt), slot;
+  int32_t bad = 0;
+
+  bad |= (evt->evt_num != nextEvt);
+  bad |= (evt->missing != missing);
+  bad |= (evt->slotmask != (allSlots & ~missing));
+  bad |= ((evt->mismatch & ~missing) != 0);
+  bad |= (evt->time != (uint64_t) PERIOD * evt->evt_num);
+
+  for(slot = 0; slot < 32; slot++)
+    if(evt->slotmask & (1u << slot))
+      bad |= ((evt->slot[slot].data[0] & 0xFFF) != (evt->evt_num & 0xFFF)) ||
+	(evt->slot[slot].evt_num != evt->evt_num);
+
+  if((evt->missing & (1u << STALL_SLOT)) &&
+     !(evt->mismatch & (1u << STALL_SLOT)))
+    nforced++;
+
+  if(bad && (nbad++ < 5))
+    printf("  ERROR: trigger %u (expected %u): missing 0x%08x mismatch"
+	   " 0x%08x time %llu\n", evt->evt_num, nextEvt, evt->missing,
+	   evt->mismatch, (unsigned long long) evt->time);
+
+  nextEvt = evt->evt_num + 1;
+}
+
+static void
+bufferDone(const uint32_t * buf, void *arg)
+{
+  if((buf != &data[readStart[nextDone]]) && (nbad++ < 5))
+    printf("  ERROR: buffer %d given back out of order\n", nextDone);
+  nextDone++;
+  ndone++;
+}
+
+/* Build the crate data once.  Returns triggers per second, or 0 if
+   anything was wrong. */
+static double
+runBuild(uint32_t flags, int32_t *nerr)
+{
+  int32_t iread, first;
+  uint32_t evt_num, nmis;
+  double t0;
+
+  nextEvt = 1;
+  nbad = nforced = nextDone = ndone = 0;
+
+  if(faV3EvBuildCreate(allSlots, BLOCKLEVEL, NBUF, checkEvent, NULL,
+		       flags) != OK)
+    {
+      (*nerr)++;
+      return 0;
+    }
+
+  t0 = faV3BusEmuTime();
+  for(iread = 0; iread < NREADOUT; iread++)
+    {
+      while(faV3EvBuildPush(&data[readStart[iread]],
+			    readStart[iread + 1] - readStart[iread],
+			    bufferDone, NULL) != OK)
+	{
+	  if(flags & FAV3_EVB_FLAG_THREAD)
+	    sched_yield();
+	  else
+	    faV3EvBuildPoll();
+	}
+      if(!(flags & FAV3_EVB_FLAG_THREAD))
+	faV3EvBuildPoll();
+    }
+  faV3EvBuildFlush();
+  t0 = faV3BusEmuTime() - t0;
+
+  /* Statistics, as published after the flush */
+  if(faV3EvBuildStatus(0) != NTRIG)
+    {
+      printf("  ERROR: builder counted %d events\n", faV3EvBuildStatus(0));
+      nbad++;
+    }
+  first = faV3EvBuildGetFirstTriggerMismatch(SKIP_SLOT, &evt_num);
+  nmis = faV3EvBuildGetMismatchTriggerCount(SKIP_SLOT);
+  if((first != 1) || (evt_num != SKIP_READ * BLOCKLEVEL + 1) ||
+     (nmis != BLOCKLEVEL))
+    {
+      printf("  ERROR: slot %d mismatches: %u from %u\n", SKIP_SLOT, nmis,
+	     evt_num);
+      nbad++;
+    }
+  first = faV3EvBuildGetFirstTriggerMismatch(3, &evt_num);
+  if((first != 0) || (faV3EvBuildGetMismatchTriggerCount(3) != 0))
+    {
+      printf("  ERROR: slot 3 has mismatches\n");
+      nbad++;
+    }
+  faV3EvBuildDestroy();
+
+  if(nextEvt != NTRIG + 1)
+    {
+      printf("  ERROR: %u events sent out\n", nextEvt - 1);
+      nbad++;
+    }
+  if(nforced == 0)
+    {
+      printf("  ERROR: no event forced out during the stall\n");
+      nbad++;
+    }
+  if(ndone != NREADOUT)
+    {
+      printf("  ERROR: %u buffers given back of %d\n", ndone, NREADOUT);
+      nbad++;
+    }
+
+  *nerr += nbad;
+
+  return nbad ? 0 : NTRIG / t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char *modeName[2] = { "poll", "thread" };
+  const uint32_t modeFlags[2] = { 0, FAV3_EVB_FLAG_THREAD };
+  const char *ttName[2] = { "words 1 and 2", "word 1 only" };
+  const uint32_t ttSuppress[2] = { 0, 2 };
+  int32_t imode, itt, ipass, npass = 5, nerr = 0, opt;
+  double rate, best;
+
+  while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  npass = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <passes>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  if(npass < 1)
+    npass = 1;
+
+  printf("\n%d boards, block level %d, %d triggers, %ld CPUs\n\n",
+	 NBOARDS, BLOCKLEVEL, NTRIG, sysconf(_SC_NPROCESSORS_ONLN));
+  printf("trigger time   build    M triggers/s  forced out  errors\n");
+
+  for(itt = 0; itt < 2; itt++)
+    {
+      makeCrate(ttSuppress[itt]);
+      for(imode = 0; imode < 2; imode++)
+	{
+	  best = 0;
+	  for(ipass = 0; ipass < npass; ipass++)
+	    {
+	      rate = runBuild(modeFlags[imode], &nerr);
+	      if(rate > best)
+		best = rate;
+	    }
+	  printf("%-13s  %-6s  %12.3f  %10u  %6d\n", ttName[itt],
+		 modeName[imode], 1e-6 * best, nforced, nerr);
+	}
+    }
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
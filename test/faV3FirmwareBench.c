@@ -0,0 +1,396 @@
+/*
+ * File:
+ *    faV3FirmwareBench.c
+ *
+ * Description:
+ *    Time of faV3FirmwareGLoad, with the boards one after another and
+ *    interleaved (faV3FirmwareSetInterleave), for -n boards (from slot 3)
+ *    on the emulated VME bus at -c ns per single cycle.
+ *
+ *    Each board has an emulated configuration ROM: page program and
+ *    sector erase take the time of the flash part, scaled to the size of
+ *    the image (FAV3_FW_SIZE, FAV3_FW_SECTOR_SIZE from the Makefile), and
+ *    commands sent while it is busy are lost.  The ROMs start with other
+ *    firmware.
+ *
+ *    Then, interleaved, the update of ROMs with other firmware by a bulk
+ *    erase (faV3FirmwareSetIncremental(0)) and of ROMs that differ from
+ *    the file in a few sectors or not at all, with the sectors erased and
+ *    pages programmed per board.  Only the sectors that differ may be.
+ *
+ *    After each load, every ROM must hold the file and every board must
+ *    have passed.  Then, with a bit of one ROM stuck, that board only must
+ *    fail.
+ *
+ *    Usage:
+ *      faV3FirmwareBench [-c <cycle ns>] [-n <boards>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <byteswap.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3FirmwareTools.h"
+#include "faV3BusEmu.h"
+
+#ifndef FAV3_FW_SIZE
+#error "FAV3_FW_SIZE must be set as for faV3FirmwareTools.c"
+#endif
+
+#define ROM_SECTOR   FAV3_FW_SECTOR_SIZE
+#define ROM_WORDS    ((((FAV3_FW_SIZE + 4) + ROM_SECTOR - 1) / ROM_SECTOR) * \
+		      ROM_SECTOR / 4)
+#define ROM_ID       0x0102194D
+#define PAGE_TIME    200e-6	/* s, to program a page */
+#define SECTOR_TIME  30e-3	/* s, to erase a sector */
+#define BULK_TIME    (SECTOR_TIME * ROM_WORDS * 4 / ROM_SECTOR)
+#define BADSLOT      4
+#define BADWORD      0x1234
+
+/* Emulated configuration ROM of each slot */
+typedef struct
+{
+  uint32_t data[ROM_WORDS];
+  uint32_t lastCmd;
+  int32_t wel;
+  double busyEnd;
+  uint32_t stuck;		/* bits of BADWORD that stay 1 */
+  int32_t nlost;		/* commands sent while busy */
+  int32_t nerase;		/* sectors erased */
+  int32_t npage;		/* pages programmed */
+} romEmu_t;
+
+static romEmu_t rom[FAV3_MAX_BOARDS + 2];
+static uint32_t image[FAV3_FW_SIZE / 4];
+static double stepTime[FAV3_UPDATE_STEP_LAST], watchLast;
+static int32_t stdoutFd = -1;
+
+static void
+romExec(int32_t slot, uint32_t cmd)
+{
+  romEmu_t *r = &rom[slot];
+  uint32_t adr = *faV3BusEmuReg(slot, offsetof(faV3_t, config_rom_control1));
+  uint32_t data = *faV3BusEmuReg(slot, offsetof(faV3_t, config_rom_control2));
+  volatile uint32_t *status = faV3BusEmuReg(slot,
+					    offsetof(faV3_t,
+						     config_rom_status0));
+  double now = faV3BusEmuTime();
+  int32_t busy = (now < r->busyEnd), iword;
+
+  if((cmd & 0xFF) == 0x05)	/* RDSR1 */
+    {
+      *status = (busy ? 1 : 0) | (r->wel ? 2 : 0);
+      return;
+    }
+
+  if(busy)
+    {
+      r->nlost++;
+      return;
+    }
+
+  switch (cmd & 0xFF)
+    {
+    case 0x9F:			/* RDID */
+      *status = ROM_ID;
+      break;
+
+    case 0x06:			/* WREN */
+      r->wel = 1;
+      break;
+
+    case 0x04:			/* WRDI */
+      r->wel = 0;
+      *status = 0;
+      break;
+
+    case 0x60:			/* BE */
+      if(r->wel)
+	{
+	  memset(r->data, 0xFF, sizeof(r->data));
+	  r->nerase += ROM_WORDS * 4 / ROM_SECTOR;
+	  r->busyEnd = now + BULK_TIME;
+	  r->wel = 0;
+	}
+      break;
+
+    case 0xDC:			/* SE */
+      if(r->wel && (adr < ROM_WORDS * 4))
+	{
+	  iword = (adr & ~(ROM_SECTOR - 1)) >> 2;
+	  memset(&r->data[iword], 0xFF, ROM_SECTOR);
+	  r->nerase++;
+	  r->busyEnd = now + SECTOR_TIME;
+	  r->wel = 0;
+	}
+      break;
+
+    case 0x12:			/* PP4, programmed at the end of the page */
+      if(r->wel && (adr < ROM_WORDS * 4))
+	{
+	  r->data[adr >> 2] &= data | ((adr >> 2 == BADWORD) ? r->stuck : 0);
+	  if(cmd & 0x100)
+	    {
+	      r->npage++;
+	      r->busyEnd = now + PAGE_TIME;
+	      r->wel = 0;
+	    }
+	}
+      break;
+
+    case 0x13:			/* AREAD */
+      *status = (adr < ROM_WORDS * 4) ? r->data[adr >> 2] : 0xFFFFFFFF;
+      break;
+    }
+}
+
+static void
+romReg(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  if(offset == offsetof(faV3_t, config_rom_status1))
+    {
+      if(!write)
+	*value |= 0x2;		/* ready for a command */
+    }
+  else if(write && (offset == offsetof(faV3_t, config_rom_control0)))
+    {
+      if((*value & 0x200) && !(rom[slot].lastCmd & 0x200))
+	romExec(slot, *value);
+      rom[slot].lastCmd = *value;
+    }
+}
+
+/* Time from the last call, for the step of this one */
+static void
+watcher(faV3UpdateWatcherArgs_t arg)
+{
+  double now = faV3BusEmuTime();
+
+  if((arg.step >= 0) && (arg.step < FAV3_UPDATE_STEP_LAST))
+    stepTime[arg.step] += now - watchLast;
+  watchLast = now;
+}
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+/* The ROMs hold other firmware (nsectors < 0), or the file with a word
+   changed in each of nsectors sectors */
+static void
+romFirmware(uint32_t slotmask, int32_t nsectors)
+{
+  int32_t slot, iword, isector;
+
+  for(slot = 3; slot <= 21; slot++)
+    {
+      if(!(slotmask & (1 << slot)))
+	continue;
+      memset(&rom[slot], 0, sizeof(rom[slot]));
+      for(iword = 0; iword < ROM_WORDS; iword++)
+	rom[slot].data[iword] = (iword >= FAV3_FW_SIZE / 4) ? 0xFFFFFFFF :
+	  (nsectors < 0) ? ~image[iword] : image[iword];
+      for(isector = 0; isector < nsectors; isector++)
+	rom[slot].data[(2 * isector + 1) * ROM_SECTOR / 4 + slot] ^= 0x100;
+    }
+}
+
+/* Boards of the slotmask whose ROM is not the file, or that failed */
+static uint32_t
+checkRoms(uint32_t slotmask)
+{
+  uint32_t bad = 0;
+  int32_t slot;
+
+  for(slot = 3; slot <= 21; slot++)
+    {
+      if(!(slotmask & (1 << slot)))
+	continue;
+      if((memcmp(rom[slot].data, image, sizeof(image)) != 0) ||
+	 (rom[slot].data[FAV3_FW_SIZE / 4] != 0xFFFFFFFF) ||
+	 !(faV3FirmwarePassedMask() & (1 << slot)))
+	bad |= 1 << slot;
+      if(rom[slot].nlost)
+	printf("  ERROR: slot %d: %d ROM commands lost while busy\n", slot,
+	       rom[slot].nlost);
+    }
+
+  return bad;
+}
+
+static double
+load(int32_t interleave)
+{
+  faV3UpdateWatcherArgs_t args;
+  double t0;
+
+  memset(&args, 0, sizeof(args));
+  memset(stepTime, 0, sizeof(stepTime));
+  faV3FirmwareAttachUpdateWatcher((VOIDFUNCPTR) watcher, args);
+  faV3FirmwareSetInterleave(interleave);
+
+  quiet(1);
+  watchLast = t0 = faV3BusEmuTime();
+  faV3FirmwareGLoad(0, 1);
+  t0 = faV3BusEmuTime() - t0;
+  quiet(0);
+
+  faV3FirmwareAttachUpdateWatcher(NULL, args);
+
+  return t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char path[] = "/tmp/faV3FirmwareBench.XXXXXX";
+  const struct
+  {
+    const char *name;
+    int32_t incremental, nsectors;
+  } update[] =
+    {
+      { "other, bulk", 0, -1 },
+      { "other", 1, -1 },
+      { "2 sectors", 1, 2 },
+      { "same", 1, 0 }
+    };
+  uint32_t slotmask, bad, seed = 1;
+  int32_t cycle = 1000, nboards = 4, interleave, iupd, slot, iword, fd;
+  int32_t nerr = 0, opt;
+  double t;
+
+  while((opt = getopt(argc, argv, "c:n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'n':
+	  nboards = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-n <boards>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+  if((nboards < 2) || (nboards > 19))
+    nboards = 4;
+  slotmask = ((1 << nboards) - 1) << 3;
+
+  /* A firmware file: its words are byte swapped into the image */
+  for(iword = 0; iword < FAV3_FW_SIZE / 4; iword++)
+    image[iword] = rand_r(&seed) ^ (rand_r(&seed) << 16);
+  fd = mkstemp(path);
+  for(iword = 0; iword < FAV3_FW_SIZE / 4; iword++)
+    {
+      uint32_t word = bswap_32(image[iword]);
+      write(fd, &word, sizeof(word));
+    }
+  close(fd);
+
+  faV3BusEmuInit(slotmask);
+  quiet(1);
+  if((faV3Init(3 << 19, 1 << 19, nboards,
+	       FAV3_INIT_SKIP | FAV3_INIT_SKIP_FIRMWARE_CHECK) != nboards) ||
+     (faV3FirmwareReadFile(path) != OK))
+    exit(1);
+  quiet(0);
+  unlink(path);
+
+  faV3BusEmuSetRegFunc(romReg);
+  faV3BusEmuSetCycle(cycle);
+
+  printf("\n%d boards, %d ns per cycle, %d kB image, %d kB sectors\n\n",
+	 nboards, cycle, FAV3_FW_SIZE >> 10, ROM_SECTOR >> 10);
+  printf("boards        erase s  program s  verify s   total s  ROMs\n");
+  for(interleave = 0; interleave <= 1; interleave++)
+    {
+      romFirmware(slotmask, -1);
+      t = load(interleave);
+      bad = checkRoms(slotmask);
+      if(bad)
+	nerr++;
+
+      printf("%-11s  %8.2f  %9.2f  %8.2f  %8.2f  %s\n",
+	     interleave ? "interleaved" : "one by one",
+	     stepTime[FAV3_UPDATE_STEP_ERASE] +
+	     stepTime[FAV3_UPDATE_STEP_DOWNLOAD],
+	     stepTime[FAV3_UPDATE_STEP_PROGRAM],
+	     stepTime[FAV3_UPDATE_STEP_VERIFY], t,
+	     bad ? "WRONG" : "same as file");
+    }
+
+  /* Updates, interleaved */
+  printf("\nROM before    erase s  program s  verify s   total s  sectors"
+	 "  pages  ROMs\n");
+  for(iupd = 0; iupd < sizeof(update) / sizeof(update[0]); iupd++)
+    {
+      faV3FirmwareSetIncremental(update[iupd].incremental);
+      romFirmware(slotmask, update[iupd].nsectors);
+      t = load(1);
+      bad = checkRoms(slotmask);
+
+      /* Sectors erased and pages programmed, the same for every board */
+      for(slot = 4; slot < 3 + nboards; slot++)
+	if((rom[slot].nerase != rom[3].nerase) ||
+	   (rom[slot].npage != rom[3].npage))
+	  bad |= 1 << slot;
+      if((update[iupd].nsectors >= 0) &&
+	 ((rom[3].nerase != update[iupd].nsectors) ||
+	  (rom[3].npage != update[iupd].nsectors * ROM_SECTOR / 256)))
+	bad |= 1 << 3;
+      if(bad)
+	nerr++;
+
+      printf("%-11s  %8.2f  %9.2f  %8.2f  %8.2f  %7d  %5d  %s\n",
+	     update[iupd].name,
+	     stepTime[FAV3_UPDATE_STEP_ERASE] +
+	     stepTime[FAV3_UPDATE_STEP_DOWNLOAD],
+	     stepTime[FAV3_UPDATE_STEP_PROGRAM],
+	     stepTime[FAV3_UPDATE_STEP_VERIFY], t, rom[3].nerase,
+	     rom[3].npage, bad ? "WRONG" : "same as file");
+    }
+  faV3FirmwareSetIncremental(1);
+
+  /* A bit of one ROM that cannot be programmed */
+  romFirmware(slotmask, -1);
+  rom[BADSLOT].stuck = ~image[BADWORD] & -~image[BADWORD];
+  load(1);
+  bad = checkRoms(slotmask);
+  printf("\nStuck bit in slot %d: passed mask 0x%06x, boards wrong 0x%06x\n",
+	 BADSLOT, faV3FirmwarePassedMask(), bad);
+  if((bad != (1 << BADSLOT)) ||
+     (faV3FirmwarePassedMask() != (slotmask & ~(1 << BADSLOT))))
+    nerr++;
+
+  faV3BusEmuSetRegFunc(NULL);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,215 @@
+/*
+ * File:
+ *    faV3FirmwareReadBench.c
+ *
+ * Description:
+ *    Time of faV3FirmwareReadFile for a firmware file of the bitstream
+ *    length, against a read of one word at a time with fread, and of
+ *    reading the same, unchanged, file again.
+ *
+ *    The hash in the printout must be that of the byte swapped file,
+ *    computed here word by word.  A file that is read again after it was
+ *    changed must give the new hash, and a file of the wrong length must
+ *    fail.
+ *
+ *    Usage:
+ *      faV3FirmwareReadBench
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <byteswap.h>
+#include <sys/stat.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3FirmwareTools.h"
+#include "faV3BusEmu.h"
+
+#define FW_SIZE     0x1701DEC	/* bytes, FAV3_FW_SIZE */
+#define PAGE_WORDS  64
+#define NREPEAT     5
+
+static uint32_t image[FW_SIZE / 4 + PAGE_WORDS];
+static char outPath[] = "/tmp/faV3FirmwareReadBench.out.XXXXXX";
+static int32_t stdoutFd = -1;
+
+/* Send the library printout to outPath, or back */
+static void
+capture(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open(outPath, O_WRONLY | O_TRUNC);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+/* Read the file with the library, return the hash it printed */
+static uint64_t
+readFile(char *path, int32_t * rval, double *ms, int32_t * cached)
+{
+  char text[1024], *hash;
+  double t0;
+  FILE *in;
+
+  capture(1);
+  t0 = faV3BusEmuTime();
+  *rval = faV3FirmwareReadFile(path);
+  t0 = faV3BusEmuTime() - t0;
+  capture(0);
+  if(ms)
+    *ms = 1e3 * t0;
+
+  memset(text, 0, sizeof(text));
+  in = fopen(outPath, "r");
+  fread(text, 1, sizeof(text) - 1, in);
+  fclose(in);
+
+  if(cached)
+    *cached = (strstr(text, "already read") != NULL);
+  hash = strstr(text, "hash 0x");
+
+  return hash ? strtoull(hash + 5, NULL, 16) : 0;
+}
+
+/* Page checksums and hash of the image, as faV3FirmwareSumPages */
+static uint64_t
+imageHash(uint32_t nwords)
+{
+  uint32_t npages, ipage, iword, idata, sum, word;
+  uint64_t hash = 0xCBF29CE484222325ULL;
+
+  npages = (nwords + 1 + PAGE_WORDS - 1) / PAGE_WORDS;
+  for(ipage = 0; ipage < npages; ipage++)
+    {
+      sum = 0x811C9DC5;
+      for(iword = 0; iword < PAGE_WORDS; iword++)
+	{
+	  idata = ipage * PAGE_WORDS + iword;
+	  word = (idata < nwords) ? image[idata] : 0xFFFFFFFF;
+	  sum = (sum ^ word) * 0x01000193;
+	}
+      hash = (hash ^ sum) * 0x100000001B3ULL;
+    }
+
+  return hash;
+}
+
+/* A file of nbytes, and its byte swapped image */
+static void
+writeFile(const char *path, uint32_t nbytes, uint32_t seed)
+{
+  uint32_t iword, word;
+  FILE *out = fopen(path, "w");
+
+  for(iword = 0; iword < nbytes / 4; iword++)
+    {
+      word = rand_r(&seed) ^ (rand_r(&seed) << 16);
+      fwrite(&word, sizeof(word), 1, out);
+      image[iword] = bswap_32(word);
+    }
+  fclose(out);
+}
+
+/* One word at a time, as faV3FirmwareReadFile did before */
+static double
+freadWords(const char *path)
+{
+  static uint32_t data[FW_SIZE / 4 + 1];
+  uint32_t word, idata = 0;
+  double t0 = faV3BusEmuTime();
+  FILE *in = fopen(path, "r");
+
+  while(!feof(in))
+    {
+      if(fread(&word, sizeof(word), 1, in) == 1)
+	data[idata++] = bswap_32(word);
+    }
+  fclose(in);
+
+  return 1e3 * (faV3BusEmuTime() - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char path[] = "/tmp/faV3FirmwareReadBench.XXXXXX";
+  struct timespec times[2];
+  uint64_t hash, want;
+  int32_t irep, rval, cached, nerr = 0;
+  double ms, best, bestFread;
+
+  close(mkstemp(path));
+  close(mkstemp(outPath));
+
+  writeFile(path, FW_SIZE, 1);
+  want = imageHash(FW_SIZE / 4);
+
+  best = bestFread = 1e9;
+  for(irep = 0; irep < NREPEAT; irep++)
+    {
+      /* A new mtime, so that the file is read again */
+      times[0].tv_sec = times[1].tv_sec = 1000000 + irep;
+      times[0].tv_nsec = times[1].tv_nsec = 0;
+      utimensat(AT_FDCWD, path, times, 0);
+
+      hash = readFile(path, &rval, &ms, &cached);
+      if((rval != OK) || cached || (hash != want))
+	nerr++;
+      if(ms < best)
+	best = ms;
+
+      ms = freadWords(path);
+      if(ms < bestFread)
+	bestFread = ms;
+    }
+
+  printf("\n%d byte file, best of %d\n\n", FW_SIZE, NREPEAT);
+  printf("read                      ms\n");
+  printf("fread, word by word  %7.2f\n", bestFread);
+  printf("faV3FirmwareReadFile %7.2f  hash 0x%016llx %s\n", best,
+	 (unsigned long long) hash, (hash == want) ? "ok" : "WRONG");
+
+  hash = readFile(path, &rval, &ms, &cached);
+  printf("same file again      %7.3f  %s\n", ms,
+	 cached ? "not read" : "READ AGAIN");
+  if((rval != OK) || !cached || (hash != want))
+    nerr++;
+
+  /* Changed, with a new mtime */
+  writeFile(path, FW_SIZE, 2);
+  want = imageHash(FW_SIZE / 4);
+  hash = readFile(path, &rval, &ms, &cached);
+  printf("changed file         %7.2f  hash 0x%016llx %s\n", ms,
+	 (unsigned long long) hash, (hash == want) ? "ok" : "WRONG");
+  if((rval != OK) || cached || (hash != want))
+    nerr++;
+
+  writeFile(path, FW_SIZE - 4, 3);
+  readFile(path, &rval, NULL, NULL);
+  printf("\nFile 4 bytes short: faV3FirmwareReadFile returned %d\n", rval);
+  if(rval != ERROR)
+    nerr++;
+
+  faV3FirmwareDone(0);
+  unlink(path);
+  unlink(outPath);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,342 @@
+/*
+ * File:
+ *    faV3HistBench.c
+ *
+ * Description:
+ *    Checks and cost of the online histograms (faV3Hist).  No hardware or
+ *    bus is used.
+ *
+ *    Checks: faV3HistFill before faV3HistCreate and after faV3HistDestroy
+ *    returns ERROR (and does not crash); filled records land in the
+ *    expected bins; faV3HistReset clears them; faV3HistFillBuffer fills
+ *    a block, in host and in big-endian order.
+ *
+ *    Cost: mode 9 data from faV3DataGen (block level 10, 16 channels, one
+ *    pulse each), for a readout thread reading 1 board and one reading a
+ *    crate of 16, one buffer per board and readout.  Time is the CPU time
+ *    of the thread, best of NREP runs, interleaved.
+ *
+ *      records:  decoded with faV3HistDecCallback, less decoded with an
+ *                empty callback: every record filled.
+ *      buffers:  each buffer given to faV3HistFillBuffer, with the
+ *                automatic prescale and with every buffer decoded.
+ *
+ *    The time per trigger, times 100 kHz, is the CPU fraction filling adds
+ *    to a readout thread at 100 kHz triggers.  faV3HistFillBuffer with the
+ *    automatic prescale must keep it under 5% for the crate; this is
+ *    reported, not counted as an error, as it depends on the machine.
+ *    The records filled by faV3HistFillBuffer must match the prescale.
+ *
+ *    Build the library with optimization (make DEBUG=) for the rates.
+ *
+ *    Usage:
+ *      faV3HistBench [-n <passes>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3Hist.h"
+#include "faV3BusEmu.h"
+
+#define NREADOUT  100
+#define NREP      21
+#define MAXWORDS  (1 << 22)
+
+static uint32_t data[MAXWORDS];
+static int32_t bufStart[16 * NREADOUT + 1];
+
+/* CPU time of this thread: less noisy than wall time on a shared
+   machine */
+static double
+cpuTime()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/* One block of slot 5, 16 channels with the pulse of checkFill, filled
+   from raw data in host order and big-endian */
+static int32_t
+checkBuffer()
+{
+  faV3Gen_t gen;
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  uint32_t counts[1024 + 2], swapped[4096];
+  int32_t ichan, i, n, nerr = 0;
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+
+  faV3GenDefaults(&cfg);
+  cfg.slot = 5;
+  cfg.mode = 9;
+  cfg.block_level = 10;
+  faV3GenInit(&gen, &cfg);
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    faV3GenSetChannel(&gen, ichan, &ch);
+  n = faV3GenBlock(&gen, data, 4096);
+  faV3GenFree(&gen);
+  for(i = 0; i < n; i++)
+    swapped[i] = __builtin_bswap32(data[i]);
+
+  faV3HistReset();
+  faV3HistSetPrescale(1);
+  faV3HistFillBuffer(data, n, 0);
+  faV3HistFillBuffer(swapped, n, FAV3_DEC_FLAG_SWAP);
+  faV3HistSetPrescale(0);
+
+  /* 10 triggers, twice, in every channel */
+  nerr += (faV3HistStatus(0) != 2 * 10 * FAV3_MAX_ADC_CHANNELS);
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    {
+      faV3HistGet(5, ichan, FAV3_HIST_PED, counts, 1026);
+      for(i = 0, n = 0; i < 1026; i++)
+	n += counts[i];
+      nerr += (n != 20);
+    }
+
+  if(nerr)
+    printf("  ERROR: faV3HistFillBuffer\n");
+  return nerr;
+}
+
+static int32_t
+checkFill()
+{
+  faV3DecRecord_t rec;
+  uint32_t counts[1024 + 2];
+  int32_t nerr = 0;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.type = FAV3_DEC_PULSE_PARAM;
+  rec.slot = 5;
+  rec.u.pp.chan = 3;
+  rec.u.pp.ped_sum = 400;	/* bin 400 >> 4 = 25, + 1 */
+  rec.u.pp.npulse = 1;
+  rec.u.pp.pulse[0].adc_sum = 5000;	/* bin 5000 >> 8 = 19, + 1 */
+  rec.u.pp.pulse[0].time_coarse = 6;
+  rec.u.pp.pulse[0].time_fine = 16;	/* 400 >> 5 = 12, + 1 */
+  rec.u.pp.pulse[0].vpeak = 400;	/* 400 >> 2 = 100, + 1 */
+
+  if(faV3HistFill(&rec) != ERROR)
+    {
+      printf("  ERROR: fill before create did not return ERROR\n");
+      nerr++;
+    }
+
+  if(faV3HistCreate(1u << 5) != OK)
+    return nerr + 1;
+
+  faV3HistFill(&rec);
+  faV3HistFill(&rec);
+  rec.slot = 6;			/* not in slotmask */
+  faV3HistFill(&rec);
+  rec.slot = 5;
+
+  faV3HistGet(5, 3, FAV3_HIST_PED, counts, 1026);
+  nerr += (counts[26] != 2);
+  faV3HistGet(5, 3, FAV3_HIST_SUM, counts, 1026);
+  nerr += (counts[20] != 2);
+  faV3HistGet(5, 3, FAV3_HIST_TIME, counts, 1026);
+  nerr += (counts[13] != 2);
+  faV3HistGet(5, 3, FAV3_HIST_PEAK, counts, 1026);
+  nerr += (counts[101] != 2);
+  nerr += (faV3HistStatus(0) != 2);
+
+  faV3HistReset();
+  faV3HistFill(&rec);
+  faV3HistGet(5, 3, FAV3_HIST_PEAK, counts, 1026);
+  nerr += (counts[101] != 1);
+
+  nerr += checkBuffer();
+
+  faV3HistDestroy();
+  if(faV3HistFill(&rec) != ERROR)
+    {
+      printf("  ERROR: fill after destroy did not return ERROR\n");
+      nerr++;
+    }
+
+  printf("Fill checks: %d errors\n", nerr);
+  return nerr;
+}
+
+static void
+countRecord(const faV3DecRecord_t * rec, void *arg)
+{
+}
+
+/* Decode the data npass times, with the given callback.  Seconds. */
+static double
+runDecode(int32_t nwords, int32_t npass, faV3DecCallback_t cb)
+{
+  static faV3Decoder_t dec;
+  int32_t ipass;
+  double t0;
+
+  faV3DecoderInit(&dec, 0);
+  faV3DecoderSetCallback(&dec, cb, NULL);
+  t0 = cpuTime();
+  for(ipass = 0; ipass < npass; ipass++)
+    faV3DecoderFeed(&dec, data, nwords);
+  return cpuTime() - t0;
+}
+
+/* Give every buffer to faV3HistFillBuffer, npass times.  Seconds. */
+static double
+runBuffers(int32_t nbuf, int32_t npass)
+{
+  int32_t ipass, ibuf;
+  double t0;
+
+  t0 = cpuTime();
+  for(ipass = 0; ipass < npass; ipass++)
+    for(ibuf = 0; ibuf < nbuf; ibuf++)
+      faV3HistFillBuffer(&data[bufStart[ibuf]],
+			 bufStart[ibuf + 1] - bufStart[ibuf], 0);
+  return cpuTime() - t0;
+}
+
+static void
+printCost(int32_t nboards, const char *how, double t, double ntrig)
+{
+  double nrec = ntrig * nboards * FAV3_MAX_ADC_CHANNELS;
+
+  printf("%6d  %-14s  %12.0f  %14.2f  %13.1f\n", nboards, how,
+	 1e9 * t / ntrig, 1e9 * t / nrec, 100.0 * 1e5 * t / ntrig);
+}
+
+static void
+benchFill(int32_t nboards, int32_t npass, int32_t *nerr)
+{
+  faV3Gen_t gen[16];
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t igen, ichan, iread, irep, nbuf, nwords = 0, slot = 3;
+  uint32_t prescale, nfilled, nexpect;
+  double t, tdec, tfill, tbuf[2], ntrig;
+
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+
+  for(igen = 0; igen < nboards; igen++, slot++)
+    {
+      if(slot == 11)
+	slot = 13;		/* switch slots */
+      faV3GenDefaults(&cfg);
+      cfg.slot = slot;
+      cfg.mode = 9;
+      cfg.block_level = 10;
+      faV3GenInit(&gen[igen], &cfg);
+      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	faV3GenSetChannel(&gen[igen], ichan, &ch);
+    }
+  /* One buffer per board and readout */
+  for(iread = 0, nbuf = 0; iread < NREADOUT; iread++)
+    for(igen = 0; igen < nboards; igen++, nbuf++)
+      {
+	bufStart[nbuf] = nwords;
+	nwords += faV3GenBlock(&gen[igen], data + nwords, MAXWORDS - nwords);
+      }
+  bufStart[nbuf] = nwords;
+  for(igen = 0; igen < nboards; igen++)
+    faV3GenFree(&gen[igen]);
+
+  faV3HistCreate(0x1FFFF8);
+  runDecode(nwords, 1, faV3HistDecCallback);	/* allocate the counts */
+
+  /* Best of NREP, interleaved, as the differences are small next to
+     noise */
+  tdec = tfill = tbuf[0] = tbuf[1] = 1e9;
+  for(irep = 0; irep < NREP; irep++)
+    {
+      t = runDecode(nwords, npass, countRecord);
+      if(t < tdec)
+	tdec = t;
+      t = runDecode(nwords, npass, faV3HistDecCallback);
+      if(t < tfill)
+	tfill = t;
+      for(prescale = 0; prescale < 2; prescale++)
+	{
+	  faV3HistSetPrescale(prescale);
+	  t = runBuffers(nbuf, npass);
+	  if(t < tbuf[prescale])
+	    tbuf[prescale] = t;
+	}
+    }
+
+  /* Automatic prescale: every buffer of the first readout, then one in
+     2 * nboards of each board */
+  faV3HistReset();
+  faV3HistSetPrescale(0);
+  runBuffers(nbuf, npass);
+  nfilled = faV3HistStatus(0);
+  nexpect = nboards * FAV3_MAX_ADC_CHANNELS * cfg.block_level *
+    (1 + (NREADOUT * npass - 1) / (2 * nboards));
+  if(nfilled != nexpect)
+    {
+      printf("  ERROR: %u records filled, expected %u\n", nfilled, nexpect);
+      (*nerr)++;
+    }
+  faV3HistDestroy();
+
+  ntrig = (double) NREADOUT * cfg.block_level * npass;
+  printCost(nboards, "records", tfill - tdec, ntrig);
+  printCost(nboards, "buffers, 1", tbuf[1], ntrig);
+  printCost(nboards, "buffers, auto", tbuf[0], ntrig);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t npass = 32, nerr, opt;
+
+  while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  npass = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <passes>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  if(npass < 16)
+    npass = 16;
+
+  nerr = checkFill();
+
+  printf("\nMode 9, 16 channels with one pulse, block level 10\n\n");
+  printf("boards  fill, prescale  ns / trigger  ns / record    "
+	 "CPU %% 100 kHz\n");
+  benchFill(1, npass, &nerr);
+  benchFill(16, npass / 16, &nerr);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
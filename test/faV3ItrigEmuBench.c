@@ -0,0 +1,408 @@
+/*
+ * File:
+ *    faV3ItrigEmuBench.c
+ *
+ * Description:
+ *    Time of faV3ItrigEmuRun for random internal trigger settings of each
+ *    mode, on generated waveforms of 16 channels, against a reference
+ *    model that steps every clock, and of faV3ItrigEmuScan on -t threads.
+ *
+ *    The waveforms are made at the -r pulse rate and at 20 times it, with
+ *    one channel without samples, one with a threshold of 0 and some
+ *    pulses in overflow.  The new hits of faV3ItrigEmuDataFromSamples
+ *    must be those of faV3ItrigEmuDataFromHits of the hit patterns made
+ *    here, and the channel sum that made here.  For each setting, the
+ *    triggers and their clocks must be those of the reference model, and
+ *    the scan must give the same, with the bad settings flagged.
+ *
+ *    Usage:
+ *      faV3ItrigEmuBench [-n <clocks>] [-r <pulses per channel per 10000
+ *                        clocks>] [-s <settings>] [-t <threads>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3ItrigEmu.h"
+#include "faV3ItrigTable.h"
+#include "faV3BusEmu.h"
+
+#define NCHAN       FAV3_MAX_ADC_CHANNELS
+#define NOSAMPLES   13		/* channel without samples */
+#define NOTHR       15		/* channel with a threshold of 0 */
+#define MAXTRIG     4096
+#define NSCAN       256
+#define NMODE       4
+
+static uint16_t *samples[NCHAN], *hits, *sum;
+static uint16_t ped[NCHAN], thr[NCHAN];
+static uint32_t nclk;
+static uint32_t table[FAV3_ITRIG_TABLE_SIZE];
+static int32_t stdoutFd = -1;
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+/* Pedestal and noise, and pulses of 2 clocks rise and 6 fall at rate
+   per 10000 clocks.  Returns the fraction of channel clocks over
+   threshold. */
+static double
+makeWaveforms(int32_t rate, uint32_t seed)
+{
+  const int32_t shape[] = { 50, 100, 80, 60, 40, 25, 12, 5 };
+  uint32_t iclk, isamp, nover = 0;
+  int32_t ichan, amp, v;
+
+  memset(hits, 0, nclk * sizeof(uint16_t));
+  memset(sum, 0, nclk * sizeof(uint16_t));
+
+  for(ichan = 0; ichan < NCHAN; ichan++)
+    {
+      if(ichan == NOSAMPLES)
+	continue;
+
+      for(iclk = 0; iclk < nclk; iclk++)
+	samples[ichan][iclk] = ped[ichan] + rand_r(&seed) % 5 - 2;
+
+      for(iclk = 0; iclk < nclk; iclk++)
+	{
+	  if((rand_r(&seed) % 10000) >= rate)
+	    continue;
+
+	  amp = (rand_r(&seed) % 50) ? 10 + rand_r(&seed) % 1500 : 6000;
+	  for(isamp = 0; (isamp < 8) && (iclk + isamp < nclk); isamp++)
+	    {
+	      v = (samples[ichan][iclk + isamp] & 0xFFF) + amp * shape[isamp] / 100;
+	      samples[ichan][iclk + isamp] = (v > 0xFFF) ? 0x1FFF : v;
+	    }
+	}
+
+      /* Hits and the channel sum, as the firmware */
+      for(iclk = 0; iclk < nclk; iclk++)
+	{
+	  v = (samples[ichan][iclk] & 0x1000) ? 0xFFF :
+	    (samples[ichan][iclk] & 0xFFF);
+	  if(v > ped[ichan])
+	    sum[iclk] += v - ped[ichan];
+	  if(thr[ichan] && (samples[ichan][iclk] > ped[ichan] + thr[ichan]))
+	    {
+	      hits[iclk] |= 1 << ichan;
+	      nover++;
+	    }
+	}
+    }
+
+  return (double) nover / ((double) nclk * NCHAN);
+}
+
+static inline int32_t
+tableCond(const faV3ItrigEmuConfig_t * cfg, uint32_t pattern)
+{
+  return (pattern != 0) && ((cfg->table == NULL) || cfg->table[pattern]);
+}
+
+/* Every clock, from the hit patterns: the emulator without skipping */
+static uint32_t
+refRun(const faV3ItrigEmuConfig_t * cfg, uint32_t * trig_clk)
+{
+  uint32_t end[NCHAN], iclk, busy = 0, wend = 0, ntrig = 0, width, from;
+  uint16_t pattern = 0, prev = 0, newhit, latch = 0;
+  int32_t ichan, cond, prevcond = 0, wopen = 0, trig;
+
+  width = (cfg->trigWidth > 0) ? cfg->trigWidth : 1;
+  memset(end, 0, sizeof(end));
+
+  for(iclk = 0; iclk < nclk; iclk++)
+    {
+      trig = 0;
+      if(cfg->mode == FAV3_ITRIG_SUM_MODE)
+	{
+	  cond = (sum[iclk] >= cfg->sumThresh);
+	  trig = cond && !prevcond;
+	  prevcond = cond;
+	}
+      else
+	{
+	  pattern = 0;
+	  for(ichan = 0; ichan < NCHAN; ichan++)
+	    {
+	      if(iclk >= cfg->hbDelay[ichan])
+		{
+		  from = iclk - cfg->hbDelay[ichan];
+		  newhit = hits[from] & ~(from ? hits[from - 1] : 0);
+		  if(newhit & (1 << ichan))
+		    end[ichan] = iclk + cfg->hbWidth[ichan] + 1;
+		}
+	      if(end[ichan] > iclk)
+		pattern |= 1 << ichan;
+	    }
+
+	  switch (cfg->mode)
+	    {
+	    case FAV3_ITRIG_TABLE_MODE:
+	      cond = tableCond(cfg, pattern);
+	      trig = cond && !prevcond;
+	      prevcond = cond;
+	      break;
+
+	    case FAV3_ITRIG_COIN_MODE:
+	      cond = ((pattern & cfg->cMask) == cfg->cMask);
+	      trig = cond && !prevcond;
+	      prevcond = cond;
+	      break;
+
+	    case FAV3_ITRIG_WINDOW_MODE:
+	      if(!wopen && (pattern & ~prev & cfg->wMask) && (iclk >= busy))
+		{
+		  wopen = 1;
+		  wend = iclk + cfg->wWidth;
+		  latch = 0;
+		}
+	      if(wopen)
+		{
+		  latch |= pattern & cfg->wMask;
+		  if(iclk + 1 >= wend)
+		    {
+		      wopen = 0;
+		      trig = tableCond(cfg, latch);
+		    }
+		}
+	      break;
+	    }
+	  prev = pattern;
+	}
+
+      if(trig && (iclk >= busy))
+	{
+	  if(ntrig < MAXTRIG)
+	    trig_clk[ntrig] = iclk;
+	  ntrig++;
+	  busy = iclk + width;
+	}
+    }
+
+  return ntrig;
+}
+
+static void
+randomConfig(faV3ItrigEmuConfig_t * cfg, int32_t mode, uint32_t * seed)
+{
+  int32_t ichan;
+
+  faV3ItrigEmuDefaults(cfg);
+  cfg->mode = mode;
+
+  for(ichan = 0; ichan < NCHAN; ichan++)
+    {
+      cfg->hbWidth[ichan] = (rand_r(seed) & 1) ? rand_r(seed) % 8 :
+	rand_r(seed) % (FAV3_ITRIG_MAX_HB_WIDTH + 1);
+      cfg->hbDelay[ichan] = rand_r(seed) % (FAV3_ITRIG_MAX_HB_DELAY + 1);
+    }
+  cfg->trigWidth = rand_r(seed) % (FAV3_ITRIG_MAX_WIDTH + 1);
+  cfg->table = (rand_r(seed) & 1) ? table : NULL;
+
+  cfg->cMask = (1 << (rand_r(seed) % NCHAN)) | (1 << (rand_r(seed) % NCHAN));
+  cfg->wMask = (rand_r(seed) & 0xFFFF) | 1;
+  cfg->wWidth = 1 + rand_r(seed) % ((rand_r(seed) & 1) ? 16 :
+				    FAV3_ITRIG_WINDOW_MAX_WIDTH);
+  cfg->sumThresh = 50 + rand_r(seed) % 4000;
+}
+
+/* New hits and channel sum of two inputs are the same */
+static int32_t
+sameData(const faV3ItrigEmuData_t * a, const faV3ItrigEmuData_t * b)
+{
+  return (a->nclk == b->nclk) && (a->nedge == b->nedge) &&
+    !memcmp(a->edge_clk, b->edge_clk, a->nedge * sizeof(uint32_t)) &&
+    !memcmp(a->edge_mask, b->edge_mask, a->nedge * sizeof(uint16_t)) &&
+    (b->sum == NULL) && !memcmp(a->sum, sum, a->nclk * sizeof(uint16_t));
+}
+
+int
+main(int argc, char *argv[])
+{
+  const int32_t modes[NMODE] = { FAV3_ITRIG_TABLE_MODE, FAV3_ITRIG_COIN_MODE,
+    FAV3_ITRIG_WINDOW_MODE, FAV3_ITRIG_SUM_MODE
+  };
+  const char *modeName[NMODE] = { "table", "coin", "window", "sum" };
+  static faV3ItrigEmuConfig_t scan[NSCAN];
+  static faV3ItrigEmuResult_t sres[NSCAN], sres1[NSCAN];
+  static uint32_t emuClk[MAXTRIG], refClk[MAXTRIG];
+  faV3ItrigEmuConfig_t cfg;
+  faV3ItrigEmuData_t data, hdata;
+  faV3ItrigEmuResult_t res;
+  uint32_t seed = 1, refn, nsame;
+  int32_t nsets = 40, rate = 12, nthreads, irate, imode, iset, ichan;
+  int32_t nbad, nerr = 0, opt;
+  double occ, t0, emuMs[NMODE], refMs[NMODE], ms1, msN;
+
+  nclk = (1 << 21) + 13;
+  nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  while((opt = getopt(argc, argv, "n:r:s:t:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  nclk = atoi(optarg);
+	  break;
+	case 'r':
+	  rate = atoi(optarg);
+	  break;
+	case 's':
+	  nsets = atoi(optarg);
+	  break;
+	case 't':
+	  nthreads = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-n <clocks>] [-r <pulses per channel per 10000 clocks>]\n"
+		 "          [-s <settings>] [-t <threads>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+  if(nclk < 16)
+    nclk = 16;
+  if(nsets < NMODE)
+    nsets = NMODE;
+  if((nthreads < 1) || (nthreads > FAV3_ITRIGEMU_MAX_THREADS))
+    nthreads = 1;
+
+  for(ichan = 0; ichan < NCHAN; ichan++)
+    {
+      ped[ichan] = 100 + 5 * ichan;
+      thr[ichan] = (ichan == NOTHR) ? 0 : 20 + ichan;
+      samples[ichan] = (ichan == NOSAMPLES) ? NULL :
+	(uint16_t *) malloc(nclk * sizeof(uint16_t));
+    }
+  hits = (uint16_t *) malloc(nclk * sizeof(uint16_t));
+  sum = (uint16_t *) malloc(nclk * sizeof(uint16_t));
+
+  if(faItrigBuildTable("(0 & 1) | (2 & 3) | (4 & !5) | (6 ^ 7) | (8 & 9 & 10)",
+		       table) != OK)
+    exit(1);
+
+  printf("\n%d clocks, %d settings per data set\n\n", nclk, nsets);
+  printf("over thr  new hits  mode     sets  emu ms  ref ms  same\n");
+
+  for(irate = 0; irate < 2; irate++)
+    {
+      occ = makeWaveforms(irate ? 20 * rate : rate, 1 + irate);
+
+      quiet(1);
+      opt = faV3ItrigEmuDataFromSamples(&data,
+					(const uint16_t * const *) samples,
+					nclk, ped, thr);
+      opt |= faV3ItrigEmuDataFromHits(&hdata, hits, nclk);
+      quiet(0);
+      if(opt != OK)
+	{
+	  printf("ERROR: no emulator input\n");
+	  exit(1);
+	}
+      if(!sameData(&data, &hdata))
+	{
+	  printf("  ERROR: waveforms and hit patterns give different input\n");
+	  nerr++;
+	}
+
+      for(imode = 0; imode < NMODE; imode++)
+	{
+	  emuMs[imode] = refMs[imode] = 0;
+	  nsame = 0;
+	  for(iset = imode; iset < nsets; iset += NMODE)
+	    {
+	      randomConfig(&cfg, modes[imode], &seed);
+
+	      t0 = faV3BusEmuTime();
+	      faV3ItrigEmuRun(&cfg, &data, &res, emuClk, MAXTRIG);
+	      emuMs[imode] += 1e3 * (faV3BusEmuTime() - t0);
+
+	      t0 = faV3BusEmuTime();
+	      refn = refRun(&cfg, refClk);
+	      refMs[imode] += 1e3 * (faV3BusEmuTime() - t0);
+
+	      if((res.status == OK) && (res.ntrig == refn) &&
+		 !memcmp(emuClk, refClk,
+			 ((refn < MAXTRIG) ? refn : MAXTRIG) * sizeof(uint32_t)))
+		nsame++;
+	      else
+		{
+		  printf("  ERROR: %s setting %d: %d triggers, reference %d\n",
+			 modeName[imode], iset, res.ntrig, refn);
+		  nerr++;
+		}
+	    }
+
+	  opt = (nsets - imode + NMODE - 1) / NMODE;
+	  printf("%6.2f%%  %9d  %-7s  %4d  %6.2f  %6.1f  %s\n", 100. * occ,
+		 data.nedge, modeName[imode], opt, emuMs[imode] / opt,
+		 refMs[imode] / opt, (nsame == opt) ? "yes" : "NO");
+	}
+
+      faV3ItrigEmuDataFree(&data);
+      faV3ItrigEmuDataFree(&hdata);
+    }
+
+  /* Scan of the settings of every mode, on the sparse data, with two bad
+     ones */
+  makeWaveforms(rate, 1);
+  faV3ItrigEmuDataFromSamples(&data, (const uint16_t * const *) samples,
+			      nclk, ped, thr);
+  for(iset = 0; iset < NSCAN; iset++)
+    randomConfig(&scan[iset], modes[iset % NMODE], &seed);
+  scan[7].mode = 3;
+  scan[100].hbDelay[4] = FAV3_ITRIG_MAX_HB_DELAY + 1;
+
+  quiet(1);
+  t0 = faV3BusEmuTime();
+  nbad = faV3ItrigEmuScan(scan, NSCAN, &data, sres1, 1);
+  ms1 = 1e3 * (faV3BusEmuTime() - t0);
+  t0 = faV3BusEmuTime();
+  opt = faV3ItrigEmuScan(scan, NSCAN, &data, sres, nthreads);
+  msN = 1e3 * (faV3BusEmuTime() - t0);
+  quiet(0);
+
+  for(iset = 0; iset < NSCAN; iset++)
+    if((sres[iset].status != sres1[iset].status) ||
+       (sres[iset].ntrig != sres1[iset].ntrig))
+      break;
+
+  printf("\nfaV3ItrigEmuScan of %d settings: %.0f ms on 1 thread, %.0f ms on %d, %s\n",
+	 NSCAN, ms1, msN, nthreads, (iset == NSCAN) ? "same" : "DIFFERENT");
+  printf("Bad settings: %d and %d, %s\n", nbad, opt,
+	 ((sres[7].status == ERROR) && (sres[100].status == ERROR)) ?
+	 "flagged" : "NOT flagged");
+  if((iset != NSCAN) || (nbad != 2) || (opt != 2) ||
+     (sres[7].status != ERROR) || (sres[100].status != ERROR))
+    nerr++;
+
+  faV3ItrigEmuDataFree(&data);
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
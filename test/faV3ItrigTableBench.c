@@ -0,0 +1,236 @@
+/*
+ * File:
+ *    faV3ItrigTableBench.c
+ *
+ * Description:
+ *    VME writes to load the HITSUM trigger table of a board for a series
+ *    of typical edits, when only the runs of entries that changed are
+ *    written (faItrigTableNextRun: see faV3ItrigTable.c), and the
+ *    time they take at -c ns per single cycle.
+ *
+ *    For each edit, the runs applied to the table loaded before must give
+ *    the new table, and the writes must be those counted entry by entry.
+ *    Tables from faItrigBuildTable must be the same as from
+ *    faItrigBuildTableList and as the expression evaluated pattern by
+ *    pattern, and bad expressions must fail.
+ *
+ *    Usage:
+ *      faV3ItrigTableBench [-c <cycle ns>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3ItrigTable.h"
+#include "faV3BusEmu.h"
+
+#define NREPEAT 20
+
+static uint32_t table[FAV3_ITRIG_TABLE_SIZE];
+static int32_t stdoutFd = -1;
+
+/* Send the library printout to /dev/null, or back */
+static void
+quiet(int32_t on)
+{
+  int32_t fd;
+
+  fflush(stdout);
+  if(on)
+    {
+      stdoutFd = dup(STDOUT_FILENO);
+      fd = open("/dev/null", O_WRONLY);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+  else
+    {
+      dup2(stdoutFd, STDOUT_FILENO);
+      close(stdoutFd);
+    }
+}
+
+static inline int32_t
+entry(const uint32_t * bits, uint32_t addr)
+{
+  return (bits[addr >> 5] >> (addr & 31)) & 1;
+}
+
+/* Load "to" over "board", one run at a time.  Returns the writes. */
+static int32_t
+load(uint32_t * board, const uint32_t * to, int32_t * nrun)
+{
+  uint32_t addr = 0, ptr = 0, end;
+  int32_t len, nwrite = 0;
+
+  *nrun = 0;
+  while((len = faItrigTableNextRun(board, to, &addr)) > 0)
+    {
+      ptr = addr;		/* auto-increment address */
+      nwrite++;
+      for(end = addr + len; addr < end; addr++, ptr++)
+	{
+	  board[ptr >> 5] ^= (entry(board, ptr) ^ entry(to, addr)) << (ptr & 31);
+	  nwrite++;
+	}
+      (*nrun)++;
+    }
+
+  return nwrite;
+}
+
+/* Writes counted entry by entry: one per entry that differs, and one
+   more at the start of each run of them */
+static int32_t
+countWrites(const uint32_t * from, const uint32_t * to)
+{
+  uint32_t addr;
+  int32_t diff, last = 0, nwrite = 0;
+
+  for(addr = 0; addr < FAV3_ITRIG_TABLE_SIZE; addr++)
+    {
+      diff = entry(from, addr) != entry(to, addr);
+      if(diff)
+	nwrite += last ? 1 : 2;
+      last = diff;
+    }
+
+  return nwrite;
+}
+
+static int32_t
+build(const char *expr, uint32_t * bits)
+{
+  if(faItrigBuildTable(expr, table) != OK)
+    return ERROR;
+  faItrigPackTable(table, bits);
+
+  return OK;
+}
+
+/* (0 ^ 5) & !(14 | 15) | (3 & 7 & 11), pattern by pattern */
+static int32_t
+exprByPattern(uint32_t p)
+{
+  int32_t c[16], ii;
+
+  for(ii = 0; ii < 16; ii++)
+    c[ii] = (p >> ii) & 1;
+
+  return (p != 0) &&
+    (((c[0] ^ c[5]) && !(c[14] || c[15])) || (c[3] && c[7] && c[11]));
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char *edits[] = {
+    "(0 & 1) | (2 & 3)",
+    "(0 & 1) | (2 & 3) | (4 & 5)",
+    "(0 & 1) | (2 & 3) | (4 & 5) | (14 & !15)",
+    "(0 & 1) | (2 & 3) | (4 & 5) | (14 & !15) | (6&7&8&9&10&11&12&13)",
+    "(0 & 1) | (2 & 3) | (4 & 5) | (14 & !15) | (6&7&8&9&10&11&12&13)",
+    "(0 & 1) | (2 & 3) | (14 & !15)"
+  };
+  const char *bad[] = { "(0 & 1", "0 & 16", "0 + 1", "" };
+  const uint16_t combo[] = { 0x0003, 0x000C, 0x0030 };
+  static uint32_t board[FAV3_ITRIG_TABLE_WORDS], want[FAV3_ITRIG_TABLE_WORDS];
+  static uint32_t prev[FAV3_ITRIG_TABLE_WORDS], list[FAV3_ITRIG_TABLE_WORDS];
+  uint32_t addr;
+  int32_t cycle = 1000, iedit, irep, nwrite, nrun, nerr = 0, opt;
+  double t0, best;
+
+  while((opt = getopt(argc, argv, "c:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  /* The first load writes the whole table: here, the default table of
+     every pattern but 0 */
+  memset(want, 0xFF, sizeof(want));
+  want[0] &= ~1u;
+  nwrite = FAV3_ITRIG_TABLE_SIZE + 1;
+  memcpy(board, want, sizeof(board));
+
+  printf("\n%d ns per cycle\n\n", cycle);
+  printf("%-66s  writes  runs     ms\n", "table loaded");
+  printf("%-66s  %6d  %4d  %5.2f\n", "default (first load)", nwrite, 1,
+	 1e-6 * cycle * nwrite);
+
+  for(iedit = 0; iedit < sizeof(edits) / sizeof(edits[0]); iedit++)
+    {
+      memcpy(prev, board, sizeof(prev));
+      if(build(edits[iedit], want) != OK)
+	{
+	  printf("ERROR: %s did not build\n", edits[iedit]);
+	  exit(1);
+	}
+
+      nwrite = load(board, want, &nrun);
+      if((memcmp(board, want, sizeof(board)) != 0) ||
+	 (nwrite != countWrites(prev, want)))
+	{
+	  printf("  ERROR: %s loaded wrong\n", edits[iedit]);
+	  nerr++;
+	}
+
+      printf("%-66s  %6d  %4d  %5.2f\n", edits[iedit], nwrite, nrun,
+	     1e-6 * cycle * nwrite);
+    }
+
+  /* Builders */
+  best = 1e9;
+  for(irep = 0; irep < NREPEAT; irep++)
+    {
+      t0 = faV3BusEmuTime();
+      build(edits[3], want);
+      t0 = faV3BusEmuTime() - t0;
+      if(t0 < best)
+	best = t0;
+    }
+  printf("\nfaItrigBuildTable of the longest: %.1f us\n", 1e6 * best);
+
+  build("(0 & 1) | (2 & 3) | (4 & 5)", want);
+  faItrigBuildTableList(combo, 3, table);
+  faItrigPackTable(table, list);
+  printf("faItrigBuildTableList the same as the expression: %s\n",
+	 memcmp(want, list, sizeof(want)) ? "NO" : "yes");
+  if(memcmp(want, list, sizeof(want)) != 0)
+    nerr++;
+
+  build("(0 ^ 5) & !(14 | 15) | (3 & 7 & 11)", want);
+  for(addr = 0; addr < FAV3_ITRIG_TABLE_SIZE; addr++)
+    if(entry(want, addr) != exprByPattern(addr))
+      break;
+  printf("faItrigBuildTable the same as pattern by pattern: %s\n",
+	 (addr == FAV3_ITRIG_TABLE_SIZE) ? "yes" : "NO");
+  if(addr != FAV3_ITRIG_TABLE_SIZE)
+    nerr++;
+
+  for(iedit = 0; iedit < sizeof(bad) / sizeof(bad[0]); iedit++)
+    {
+      quiet(1);
+      opt = faItrigBuildTable(bad[iedit], table);
+      quiet(0);
+      printf("\"%s\": %s\n", bad[iedit], (opt == ERROR) ? "error" : "BUILT");
+      if(opt != ERROR)
+	nerr++;
+    }
+
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,207 @@
+/*
+ * File:
+ *    faV3LockBench.c
+ *
+ * Description:
+ *    Lock contention benchmark, on the emulated VME bus.
+ *
+ *    A readout thread reads a block from the board in slot 3 with
+ *    faV3ReadBlock (DMA) every -p microseconds, and records the time each
+ *    call takes.  Next to
+ *    it a status thread reads the registers of other boards with
+ *    faV3Snapshot, as a monitoring thread does.  Each single cycle takes
+ *    the -c time on the bus.  The status thread runs at idle priority,
+ *    below the readout thread, so that on a host with few CPUs it is the
+ *    locks that are measured and not the scheduler.
+ *
+ *    Cases:
+ *      alone        readout thread only
+ *      other slot   status thread on slots 4-6
+ *      same slot    status thread on slot 3
+ *      crate lock   status thread on slots 4-6, holding faV3Mutex for
+ *                   each board as every register access did when there
+ *                   was a single lock
+ *
+ *    Usage:
+ *      faV3LockBench [-c <cycle ns>] [-p <period us>] [-t <seconds per case>]
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3DataGen.h"
+#include "faV3BusEmu.h"
+
+#define READOUT_SLOT  3
+#define MAXWORDS      (1 << 16)
+#define MAXCALLS      (1 << 20)
+
+extern pthread_mutex_t faV3Mutex;
+
+static uint32_t block[MAXWORDS];
+static int32_t blockWords = 0;
+
+static volatile int32_t running = 0;
+static int32_t statusFirst, statusLast, statusCrateLock;
+static double latency[MAXCALLS];
+static int32_t ncalls;
+static int32_t nsnap;
+
+static int32_t
+dmaFill(int32_t slot, uint32_t * data, int32_t nwords)
+{
+  int32_t n = (blockWords < nwords) ? blockWords : nwords;
+
+  memcpy(data, block, n << 2);
+  return n;
+}
+
+static void *
+statusThread(void *arg)
+{
+  static faV3Snapshot_t snap;
+  struct sched_param param = { 0 };
+  int32_t id;
+
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+  nsnap = 0;
+  while(running)
+    {
+      for(id = statusFirst; id <= statusLast; id++)
+	{
+	  if(statusCrateLock)
+	    pthread_mutex_lock(&faV3Mutex);
+	  faV3Snapshot(id, FAV3_SNAP_ALL, &snap);
+	  if(statusCrateLock)
+	    pthread_mutex_unlock(&faV3Mutex);
+	  nsnap++;
+	}
+    }
+
+  return NULL;
+}
+
+static int
+cmpDouble(const void *a, const void *b)
+{
+  double da = *(const double *) a, db = *(const double *) b;
+
+  return (da > db) - (da < db);
+}
+
+static void
+runCase(const char *name, int32_t first, int32_t last, int32_t cratelock,
+	double seconds, int32_t period)
+{
+  static uint32_t buf[MAXWORDS];
+  struct timespec pause = { 0, period * 1000 };
+  pthread_t th;
+  double t0, t1, end;
+  int32_t nerr = 0;
+
+  statusFirst = first;
+  statusLast = last;
+  statusCrateLock = cratelock;
+  nsnap = 0;
+  ncalls = 0;
+
+  running = 1;
+  if(first > 0)
+    pthread_create(&th, NULL, statusThread, NULL);
+
+  end = faV3BusEmuTime() + seconds;
+  while((faV3BusEmuTime() < end) && (ncalls < MAXCALLS))
+    {
+      t0 = faV3BusEmuTime();
+      if(faV3ReadBlock(READOUT_SLOT, buf, MAXWORDS, 1) != blockWords)
+	nerr++;
+      t1 = faV3BusEmuTime();
+      latency[ncalls++] = t1 - t0;
+      nanosleep(&pause, NULL);
+    }
+
+  running = 0;
+  if(first > 0)
+    pthread_join(th, NULL);
+
+  qsort(latency, ncalls, sizeof(double), cmpDouble);
+  printf("%-12s  %8d  %8.1f  %8.1f  %8.1f  %9.1f  %8d  %d\n", name, ncalls,
+	 1e6 * latency[ncalls / 2], 1e6 * latency[(ncalls * 99) / 100],
+	 1e6 * latency[(ncalls * 999) / 1000], 1e6 * latency[ncalls - 1],
+	 nsnap, nerr);
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3Gen_t gen;
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t cycle = 500, period = 200, ichan, opt;
+  double seconds = 1.0;
+
+  while((opt = getopt(argc, argv, "c:p:t:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'p':
+	  period = atoi(optarg);
+	  break;
+	case 't':
+	  seconds = atof(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-p <period us>]"
+		 " [-t <seconds per case>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  /* Mode 9 block of 10 events, about 500 words */
+  faV3GenDefaults(&cfg);
+  cfg.slot = READOUT_SLOT;
+  cfg.mode = 9;
+  cfg.block_level = 10;
+  cfg.flags = FAV3_GEN_FLAG_SWAP;
+  faV3GenInit(&gen, &cfg);
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    faV3GenSetChannel(&gen, ichan, &ch);
+  blockWords = faV3GenBlock(&gen, block, MAXWORDS);
+  faV3GenFree(&gen);
+
+  faV3BusEmuInit((1 << 3) | (1 << 4) | (1 << 5) | (1 << 6));
+  faV3BusEmuSetDmaFunc(dmaFill, 200);
+  if(faV3Init(3 << 19, 1 << 19, 4, FAV3_INIT_SKIP) != 4)
+    exit(1);
+  faV3BusEmuSetCycle(cycle);
+
+  printf("\nfaV3ReadBlock of %d words every %d us, %d ns single cycles."
+	 "  Times in us.\n\n", blockWords, period, cycle);
+  printf("case             calls    median       p99     p99.9        max"
+	 "  snapshots  errors\n");
+  runCase("alone", 0, 0, 0, seconds, period);
+  runCase("other slot", 4, 6, 0, seconds, period);
+  runCase("same slot", 3, 3, 0, seconds, period);
+  runCase("crate lock", 4, 6, 1, seconds, period);
+
+  exit(0);
+}
@@ -0,0 +1,520 @@
+/*
+ * File:
+ *    faV3PulseEmuCheck.c
+ *
+ * Description:
+ *    Checks of the software pulse parameter algorithm (faV3PulseEmu).
+ *    No hardware is used.
+ *
+ *    Without -f:
+ *      - known answers: windows whose pulse parameters were worked out by
+ *        hand from the algorithm as described in faV3PulseEmu.c.  They
+ *        check the implementation against that description, not against
+ *        the firmware.
+ *      - the SIMD and scalar threshold paths give the same records on
+ *        random windows.
+ *      - the -f file path on faV3PulseEmuFixture.txt, next to the
+ *        program.  That file is NOT a capture from a board: it holds the
+ *        known answer windows as mode 10 data, so it checks the file
+ *        format, decoding and comparison code, and adds nothing to the
+ *        known answers about the algorithm.
+ *      - windows per second, for 100 sample windows.
+ *
+ *    With -f, a mode 10 data file (32 bit words as read from the board) is
+ *    decoded, and the pulse parameters sent by the firmware for each
+ *    channel are compared with those computed from its raw window.  The
+ *    parameters the board was run with must be given, or, in a .txt file
+ *    (hex words in host order, as the fixture), on its "params" lines.
+ *    This is the only check against the firmware, and none has been run
+ *    on data from a board yet.  The trigger path threshold (TPT) is not a
+ *    parameter of the readout records; a "params" line with TPT, or with
+ *    anything else after TET, is an error.
+ *
+ *    Usage:
+ *      faV3PulseEmuCheck [-f <mode 10 file> [-s] [-b NSB] [-a NSA] [-p NP]
+ *                        [-e NPED] [-m MAXPED] [-t NSAT] [-T TET]]
+ *
+ *      -s   file words are in host order (default: big-endian, as read)
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "faV3Lib.h"
+#include "faV3Decoder.h"
+#include "faV3PulseEmu.h"
+
+/* Mode 10 data for the file path check (not from a board: see the file) */
+#define FAV3_EMU_FIXTURE "faV3PulseEmuFixture.txt"
+
+typedef struct
+{
+  uint32_t adc_sum, nsa_ext, over, under, samp_ov_thres;
+  uint32_t time_coarse, time_fine, vpeak, quality, quality2;
+} knownPulse_t;
+
+/* A window and the pulse parameters worked out for it */
+typedef struct
+{
+  const char *name;
+  int32_t NSB;
+  uint32_t NSA, NP, NPED, MAXPED, NSAT, TET;
+  uint32_t n;
+  uint16_t samples[16];
+  uint32_t ped_sum, ped_quality, npulse;
+  knownPulse_t pulse[2];
+} knownAnswer_t;
+
+static const knownAnswer_t known[] = {
+  {"single pulse", 2, 6, 4, 4, 1000, 2, 50, 16,
+   {100, 102, 98, 100, 101, 120, 200, 400, 300, 180, 110, 100, 100, 100,
+    100, 100},
+   400, 0, 1,
+   {{1511, 0, 0, 0, 4, 6, 16, 400, 0, 0}}},
+  {"NSA extension", 2, 3, 4, 4, 1000, 2, 50, 16,
+   {100, 100, 100, 100, 100, 100, 300, 400, 500, 450, 300, 200, 100, 100,
+    100, 100},
+   400, 0, 1,
+   {{2350, 1, 0, 0, 6, 6, 0, 500, 0, 0}}},
+  {"two pulses, flags", 1, 3, 2, 4, 500, 2, 50, 16,
+   {100, 600, 100, 100, 100, 0, 4200, 4100, 100, 100, 300, 310, 100, 100,
+    100, 100},
+   300, 1, 2,
+   {{8400, 0, 1, 1, 2, 5, 32, 104, 0, 0},
+    {810, 0, 0, 0, 2, 9, 33, 310, 0, 0}}},
+  {"rising at end", 2, 6, 4, 2, 1000, 2, 50, 8,
+   {100, 100, 100, 100, 200, 300, 400, 500},
+   200, 0, 1,
+   {{1600, 0, 0, 0, 4, 5, 0, 500, 1, 0}}},
+  {"channel ignored", 2, 6, 4, 4, 1000, 2, FAV3_THR_IGNORE_MASK, 16,
+   {100, 100, 100, 100, 100, 100, 300, 400, 500, 450, 300, 200, 100, 100,
+    100, 100},
+   400, 0, 0},
+};
+
+#define NKNOWN (int32_t)(sizeof(known) / sizeof(known[0]))
+
+static int32_t
+checkKnown()
+{
+  faV3PulseEmuConfig_t cfg;
+  faV3DecRecord_t fw, emu;
+  const knownAnswer_t *k;
+  const knownPulse_t *kp;
+  faV3DecPulse_t *p;
+  uint32_t diff, scalar, ip;
+  int32_t ik, nerr = 0;
+
+  for(ik = 0; ik < NKNOWN; ik++)
+    for(scalar = 0; scalar <= FAV3_DEC_FLAG_SCALAR;
+	scalar += FAV3_DEC_FLAG_SCALAR)
+      {
+	k = &known[ik];
+	faV3PulseEmuDefaults(&cfg);
+	cfg.NSB = k->NSB;
+	cfg.NSA = k->NSA;
+	cfg.NP = k->NP;
+	cfg.NPED = k->NPED;
+	cfg.MAXPED = k->MAXPED;
+	cfg.NSAT = k->NSAT;
+	cfg.thres[0] = k->TET;
+	cfg.flags = scalar;
+
+	memset(&fw, 0, sizeof(fw));
+	fw.u.pp.chan = 0;
+	fw.u.pp.ped_sum = k->ped_sum;
+	fw.u.pp.quality = k->ped_quality;
+	fw.u.pp.npulse = k->npulse;
+	for(ip = 0; ip < k->npulse; ip++)
+	  {
+	    kp = &k->pulse[ip];
+	    p = &fw.u.pp.pulse[ip];
+	    p->adc_sum = kp->adc_sum;
+	    p->nsa_ext = kp->nsa_ext;
+	    p->over = kp->over;
+	    p->under = kp->under;
+	    p->samp_ov_thres = kp->samp_ov_thres;
+	    p->time_coarse = kp->time_coarse;
+	    p->time_fine = kp->time_fine;
+	    p->vpeak = kp->vpeak;
+	    p->quality = kp->quality;
+	    p->quality2 = kp->quality2;
+	  }
+
+	faV3PulseEmuWindow(&cfg, 0, k->samples, k->n, &emu);
+	diff = faV3PulseEmuCompare(&fw, &emu);
+	if(diff)
+	  {
+	    printf("  ERROR: %s%s: differs (0x%x)\n", k->name,
+		   scalar ? " (scalar)" : "", diff);
+	    nerr++;
+	  }
+      }
+
+  printf("Known answers: %d windows, %d errors\n", NKNOWN, nerr);
+  return nerr;
+}
+
+/* Random windows: pedestal noise with 0-3 pulses */
+static void
+randomWindow(uint16_t * s, uint32_t n)
+{
+  uint32_t i, ip, t, a, k;
+
+  for(i = 0; i < n; i++)
+    s[i] = 100 + (rand() & 7);
+
+  for(ip = rand() & 3; ip > 0; ip--)
+    {
+      t = rand() % n;
+      a = 50 + (rand() % 4200);
+      for(k = 0; (k < 12) && (t + k < n); k++)
+	s[t + k] += (k < 3) ? a * (k + 1) / 3 : a * (12 - k) / 9;
+      if((rand() & 31) == 0)
+	s[t] = 0;
+    }
+}
+
+static int32_t
+checkSimd(int32_t nwin)
+{
+  static uint16_t s[FAV3_DEC_MAX_SAMPLES];
+  faV3PulseEmuConfig_t cfg;
+  faV3DecRecord_t a, b;
+  int32_t iwin, nerr = 0;
+  uint32_t n;
+
+  faV3PulseEmuDefaults(&cfg);
+  cfg.NP = 4;
+  cfg.thres[0] = 40;
+
+  srand(1);
+  for(iwin = 0; iwin < nwin; iwin++)
+    {
+      n = 1 + (rand() % 500);
+      randomWindow(s, n);
+      cfg.flags = 0;
+      faV3PulseEmuWindow(&cfg, 0, s, n, &a);
+      cfg.flags = FAV3_DEC_FLAG_SCALAR;
+      faV3PulseEmuWindow(&cfg, 0, s, n, &b);
+      if(faV3PulseEmuCompare(&a, &b) || (a.word != b.word))
+	nerr++;
+    }
+
+  printf("SIMD vs scalar: %d random windows, %d differ\n", nwin, nerr);
+  return nerr;
+}
+
+static void
+benchWindows(int32_t nwin)
+{
+  static uint16_t s[64][100];
+  faV3PulseEmuConfig_t cfg;
+  faV3DecRecord_t r;
+  struct timespec t0, t1;
+  uint32_t scalar;
+  int32_t iwin;
+  double sec;
+
+  srand(2);
+  for(iwin = 0; iwin < 64; iwin++)
+    randomWindow(s[iwin], 100);
+
+  faV3PulseEmuDefaults(&cfg);
+  cfg.NP = 4;
+  cfg.thres[0] = 40;
+
+  for(scalar = 0; scalar <= FAV3_DEC_FLAG_SCALAR;
+      scalar += FAV3_DEC_FLAG_SCALAR)
+    {
+      cfg.flags = scalar;
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      for(iwin = 0; iwin < nwin; iwin++)
+	faV3PulseEmuWindow(&cfg, 0, s[iwin & 63], 100, &r);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      sec = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+      printf("100 sample windows, %s: %.1f M/s\n",
+	     scalar ? "scalar" : "SIMD  ", nwin / sec / 1e6);
+    }
+}
+
+/* Comparison with a mode 10 file */
+
+static faV3PulseEmuConfig_t fileCfg;
+static uint16_t winSamples[FAV3_MAX_ADC_CHANNELS][FAV3_DEC_MAX_SAMPLES];
+static faV3DecRecord_t winRec[FAV3_MAX_ADC_CHANNELS];
+static faV3DecRecord_t ppRec[FAV3_MAX_ADC_CHANNELS];
+static uint32_t haveWin, havePP;
+static uint64_t ncompared, ndiffer, nmissing, fieldDiff[7];
+
+/* Compare the channels of the event that have both records */
+static void
+compareEvent()
+{
+  faV3DecRecord_t emu;
+  uint32_t chan, diff, ibit;
+
+  for(chan = 0; chan < FAV3_MAX_ADC_CHANNELS; chan++)
+    {
+      if(((haveWin | havePP) & (1u << chan)) == 0)
+	continue;
+      if(((haveWin & havePP) & (1u << chan)) == 0)
+	{
+	  nmissing++;
+	  continue;
+	}
+
+      faV3PulseEmuRecord(&fileCfg, &winRec[chan], &emu);
+      diff = faV3PulseEmuCompare(&ppRec[chan], &emu);
+      ncompared++;
+      if(diff)
+	{
+	  ndiffer++;
+	  for(ibit = 0; ibit < 7; ibit++)
+	    if(diff & (1u << ibit))
+	      fieldDiff[ibit]++;
+	  if(ndiffer <= 10)
+	    printf("  slot %2d event %6d chan %2d: differs (0x%x)\n",
+		   winRec[chan].slot, winRec[chan].evt_num, chan, diff);
+	}
+    }
+
+  haveWin = havePP = 0;
+}
+
+static void
+fileRecord(const faV3DecRecord_t * rec, void *arg)
+{
+  uint32_t chan;
+
+  switch (rec->type)
+    {
+    case FAV3_DEC_EVENT_HEADER:
+    case FAV3_DEC_BLOCK_TRAILER:
+      compareEvent();
+      break;
+
+    case FAV3_DEC_WINDOW_RAW:
+      chan = rec->u.win.chan & 0xF;
+      winRec[chan] = *rec;
+      memcpy(winSamples[chan], rec->u.win.samples,
+	     rec->u.win.nsamples * sizeof(uint16_t));
+      winRec[chan].u.win.samples = winSamples[chan];
+      haveWin |= (1u << chan);
+      break;
+
+    case FAV3_DEC_PULSE_PARAM:
+      chan = rec->u.pp.chan & 0xF;
+      ppRec[chan] = *rec;
+      havePP |= (1u << chan);
+      break;
+    }
+}
+
+/* Feed the words of a text file: hex words, "#" comments, and "params"
+   lines that set the parameters for the blocks after them.  Returns 1 on
+   a bad "params" line, otherwise 0. */
+static int32_t
+feedText(FILE * f, faV3Decoder_t * dec, uint32_t * buf, int32_t max)
+{
+  char line[256], *p, *end;
+  uint32_t w;
+  int32_t nw = 0, nsb, tet, ichan, len, iline = 0;
+  faV3PulseEmuConfig_t cfg;
+
+  while(fgets(line, sizeof(line), f))
+    {
+      iline++;
+      if((p = strchr(line, '#')) != NULL)
+	*p = 0;
+
+      len = 0;
+      sscanf(line, " params%n", &len);
+      if(len > 0)
+	{
+	  cfg = fileCfg;
+	  len = 0;
+	  if((sscanf(line, " params NSB %d NSA %u NP %u NPED %u MAXPED %u"
+		     " NSAT %u TET %d %n", &nsb, &cfg.NSA, &cfg.NP, &cfg.NPED,
+		     &cfg.MAXPED, &cfg.NSAT, &tet, &len) != 7) ||
+	     (line[len] != 0))
+	    {
+	      printf("  ERROR: line %d: %s", iline,
+		     strstr(line, "TPT") ?
+		     "TPT is not a readout parameter\n" :
+		     "expected params NSB NSA NP NPED MAXPED NSAT TET\n");
+	      return 1;
+	    }
+
+	  /* The blocks before are compared with the parameters before */
+	  faV3DecoderFeed(dec, buf, nw);
+	  faV3DecoderFlush(dec);
+	  compareEvent();
+	  nw = 0;
+
+	  cfg.NSB = nsb;
+	  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	    cfg.thres[ichan] = tet;
+	  fileCfg = cfg;
+	  printf("  NSB %d NSA %d NP %d NPED %d MAXPED %d NSAT %d TET %d\n",
+		 fileCfg.NSB, fileCfg.NSA, fileCfg.NP, fileCfg.NPED,
+		 fileCfg.MAXPED, fileCfg.NSAT, fileCfg.thres[0]);
+	  continue;
+	}
+
+      for(p = line;; p = end)
+	{
+	  w = strtoul(p, &end, 16);
+	  if(end == p)
+	    break;
+	  buf[nw++] = w;
+	  if(nw == max)
+	    {
+	      faV3DecoderFeed(dec, buf, nw);
+	      nw = 0;
+	    }
+	}
+    }
+
+  faV3DecoderFeed(dec, buf, nw);
+
+  return 0;
+}
+
+static int32_t
+checkFile(const char *filename, uint32_t flags)
+{
+  const char *field[7] = { "pedestal", "npulse", "sum", "flags", "time",
+    "peak", "chan"
+  };
+  static uint32_t buf[1 << 16];
+  static faV3Decoder_t dec;
+  FILE *f;
+  size_t nw, len = strlen(filename);
+  int32_t ibit, text, bad = 0;
+
+  /* A .txt file is hex words in host order, with its parameters */
+  text = (len > 4) && (strcmp(&filename[len - 4], ".txt") == 0);
+
+  f = fopen(filename, text ? "r" : "rb");
+  if(f == NULL)
+    {
+      perror(filename);
+      return 1;
+    }
+
+  ncompared = ndiffer = nmissing = 0;
+  memset(fieldDiff, 0, sizeof(fieldDiff));
+
+  if(text)
+    {
+      printf("%s:\n", filename);
+      faV3DecoderInit(&dec, 0);
+      faV3DecoderSetCallback(&dec, fileRecord, NULL);
+      bad = feedText(f, &dec, buf, 1 << 16);
+    }
+  else
+    {
+      printf("%s: NSB %d NSA %d NP %d NPED %d MAXPED %d NSAT %d TET %d\n",
+	     filename, fileCfg.NSB, fileCfg.NSA, fileCfg.NP, fileCfg.NPED,
+	     fileCfg.MAXPED, fileCfg.NSAT, fileCfg.thres[0]);
+      faV3DecoderInit(&dec, flags);
+      faV3DecoderSetCallback(&dec, fileRecord, NULL);
+      while((nw = fread(buf, sizeof(uint32_t), 1 << 16, f)) > 0)
+	faV3DecoderFeed(&dec, buf, nw);
+    }
+  faV3DecoderFlush(&dec);
+  compareEvent();
+  fclose(f);
+
+  printf("%llu channels compared, %llu differ, %llu without both records\n",
+	 (unsigned long long) ncompared, (unsigned long long) ndiffer,
+	 (unsigned long long) nmissing);
+  for(ibit = 0; ibit < 7; ibit++)
+    if(fieldDiff[ibit])
+      printf("  %-8s %llu\n", field[ibit],
+	     (unsigned long long) fieldDiff[ibit]);
+
+  return (bad || ndiffer || (ncompared == 0)) ? 1 : 0;
+}
+
+static void
+usage(const char *name)
+{
+  printf("Usage: %s [-f <mode 10 file> [-s] [-b NSB] [-a NSA] [-p NP]\n"
+	 "          [-e NPED] [-m MAXPED] [-t NSAT] [-T TET]]\n", name);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char *filename = NULL;
+  char fixture[512], *p;
+  uint32_t flags = FAV3_DEC_FLAG_SWAP;
+  int32_t ichan, tet = -1, nerr = 0, opt;
+
+  faV3PulseEmuDefaults(&fileCfg);
+
+  while((opt = getopt(argc, argv, "f:sb:a:p:e:m:t:T:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'f':
+	  filename = optarg;
+	  break;
+	case 's':
+	  flags = 0;
+	  break;
+	case 'b':
+	  fileCfg.NSB = atoi(optarg);
+	  break;
+	case 'a':
+	  fileCfg.NSA = atoi(optarg);
+	  break;
+	case 'p':
+	  fileCfg.NP = atoi(optarg);
+	  break;
+	case 'e':
+	  fileCfg.NPED = atoi(optarg);
+	  break;
+	case 'm':
+	  fileCfg.MAXPED = atoi(optarg);
+	  break;
+	case 't':
+	  fileCfg.NSAT = atoi(optarg);
+	  break;
+	case 'T':
+	  tet = atoi(optarg);
+	  break;
+	default:
+	  usage(argv[0]);
+	}
+    }
+
+  if(filename)
+    {
+      if(tet >= 0)
+	for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	  fileCfg.thres[ichan] = tet;
+      exit(checkFile(filename, flags));
+    }
+
+  nerr += checkKnown();
+  nerr += checkSimd(200000);
+
+  /* The file path, on the fixture next to the program */
+  snprintf(fixture, sizeof(fixture), "%s", argv[0]);
+  p = strrchr(fixture, '/');
+  snprintf(p ? p + 1 : fixture, sizeof(fixture) - (p ? p + 1 - fixture : 0),
+	   "%s", FAV3_EMU_FIXTURE);
+  nerr += checkFile(fixture, 0);
+
+  benchWindows(2000000);
+  printf("\nErrors: %d\n", nerr);
+
+  exit(nerr ? 1 : 0);
+}
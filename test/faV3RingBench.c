@@ -0,0 +1,190 @@
+/*
+ * File:
+ *    faV3RingBench.c
+ *
+ * Description:
+ *    Throughput of the readout ring (faV3Ring), on the emulated VME bus.
+ *
+ *    copy:  one thread reads each block into a DMA buffer, copies it into
+ *           a list node and decodes it, as test/faV3ReadoutTest.c does.
+ *    ring:  one producer thread fills ring buffers with faV3RingFill, and
+ *           1-8 consumer threads borrow, decode and release them without
+ *           a copy.
+ *
+ *    Usage:
+ *      faV3RingBench [-r <DMA MB/s>] [-t <seconds per point>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Ring.h"
+#include "faV3DataGen.h"
+#include "faV3Decoder.h"
+#include "faV3BusEmu.h"
+
+#define SLOT      3
+#define MAXWORDS  (1 << 16)
+#define NBUF      32
+#define MAXCONS   8
+
+static uint32_t block[MAXWORDS];
+static int32_t blockWords = 0;
+
+static volatile int32_t running = 0;
+static volatile uint64_t nconsumed = 0;
+
+static int32_t
+dmaFill(int32_t slot, uint32_t * data, int32_t nwords)
+{
+  int32_t n = (blockWords < nwords) ? blockWords : nwords;
+
+  memcpy(data, block, n << 2);
+  return n;
+}
+
+static void *
+producerThread(void *arg)
+{
+  while(running)
+    faV3RingFill(SLOT, 1, 100000);
+
+  return NULL;
+}
+
+static void *
+consumerThread(void *arg)
+{
+  faV3Decoder_t dec;
+  faV3RingBuf_t *buf;
+
+  faV3DecoderInit(&dec, FAV3_DEC_FLAG_SWAP);
+  while(running)
+    {
+      buf = faV3RingBorrow(100000);
+      if(buf == NULL)
+	continue;
+      faV3DecoderFeed(&dec, (const uint32_t *) buf->data, buf->nwords);
+      faV3RingRelease(buf);
+      __sync_fetch_and_add(&nconsumed, 1);
+    }
+
+  return NULL;
+}
+
+static void
+runCopy(double seconds)
+{
+  static uint32_t dmabuf[MAXWORDS], node[MAXWORDS];
+  faV3Decoder_t dec;
+  double t0 = faV3BusEmuTime(), t;
+  uint64_t nblock = 0;
+  int32_t nw;
+
+  faV3DecoderInit(&dec, FAV3_DEC_FLAG_SWAP);
+  do
+    {
+      nw = faV3ReadBlock(SLOT, dmabuf, MAXWORDS, 1);
+      memcpy(node, dmabuf, nw << 2);
+      faV3DecoderFeed(&dec, node, nw);
+      nblock++;
+      t = faV3BusEmuTime() - t0;
+    }
+  while(t < seconds);
+
+  printf("copy        -  %9.0f  %8.1f\n", nblock / t,
+	 nblock * (blockWords << 2) / t / 1e6);
+}
+
+static void
+runRing(int32_t ncons, double seconds)
+{
+  pthread_t prod, cons[MAXCONS];
+  double t0;
+  int32_t icons;
+
+  faV3RingCreate(NBUF, MAXWORDS);
+  nconsumed = 0;
+  running = 1;
+  t0 = faV3BusEmuTime();
+  pthread_create(&prod, NULL, producerThread, NULL);
+  for(icons = 0; icons < ncons; icons++)
+    pthread_create(&cons[icons], NULL, consumerThread, NULL);
+
+  usleep((useconds_t) (seconds * 1e6));
+  running = 0;
+  seconds = faV3BusEmuTime() - t0;
+
+  pthread_join(prod, NULL);
+  for(icons = 0; icons < ncons; icons++)
+    pthread_join(cons[icons], NULL);
+
+  printf("ring     %4d  %9.0f  %8.1f\n", ncons, nconsumed / seconds,
+	 nconsumed * (blockWords << 2) / seconds / 1e6);
+  faV3RingDestroy();
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3Gen_t gen;
+  faV3GenConfig_t cfg;
+  faV3GenChannel_t ch;
+  int32_t rate = 200, ncons, ichan, opt;
+  double seconds = 1.0;
+
+  while((opt = getopt(argc, argv, "r:t:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'r':
+	  rate = atoi(optarg);
+	  break;
+	case 't':
+	  seconds = atof(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-r <DMA MB/s>] [-t <seconds per point>]\n",
+		 argv[0]);
+	  exit(1);
+	}
+    }
+
+  /* Mode 10 block of 10 events */
+  faV3GenDefaults(&cfg);
+  cfg.slot = SLOT;
+  cfg.mode = 10;
+  cfg.block_level = 10;
+  cfg.flags = FAV3_GEN_FLAG_SWAP;
+  faV3GenInit(&gen, &cfg);
+  memset(&ch, 0, sizeof(ch));
+  ch.pedestal = 100;
+  ch.npulse = 1;
+  ch.pulse[0].time = 20;
+  ch.pulse[0].amplitude = 800;
+  ch.pulse[0].rise = 4;
+  ch.pulse[0].fall = 12;
+  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+    faV3GenSetChannel(&gen, ichan, &ch);
+  blockWords = faV3GenBlock(&gen, block, MAXWORDS);
+  faV3GenFree(&gen);
+
+  faV3BusEmuInit(1 << SLOT);
+  faV3BusEmuSetDmaFunc(dmaFill, rate);
+  if(faV3Init(SLOT << 19, 1 << 19, 1, FAV3_INIT_SKIP) != 1)
+    exit(1);
+
+  printf("\nBlocks of %d words, DMA at %d MB/s, %ld CPUs.\n\n",
+	 blockWords, rate, sysconf(_SC_NPROCESSORS_ONLN));
+  printf("path  consumers   blocks/s      MB/s\n");
+  runCopy(seconds);
+  for(ncons = 1; ncons <= MAXCONS; ncons <<= 1)
+    runRing(ncons, seconds);
+
+  exit(0);
+}
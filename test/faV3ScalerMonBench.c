@@ -0,0 +1,198 @@
+/*
+ * File:
+ *    faV3ScalerMonBench.c
+ *
+ * Description:
+ *    Checks of the scaler rate monitor (faV3ScalerMon), on the emulated
+ *    VME bus with one board in slot 3.  The scalers count at
+ *    100000 * (channel + 1) Hz, and time_count ticks every 2048 ns, from
+ *    host time.  A latch copies them to the scaler registers.
+ *
+ *    The monitor samples every 10 ms while this program, as the readout:
+ *      wrap     lets time_count wrap past 2^32.  No sample may be flagged
+ *               as a reset, and every rate must be within 1%.
+ *      clear    calls faV3ClearScalers.  Exactly one sample is flagged.
+ *      latch    runs faV3LatchScalers, waits 2 ms, faV3ReadScalers(...,0)
+ *               in a loop.  Every read must return the counts of its own
+ *               latch, and the monitor must not latch in between.
+ *      drop     makes every scaler read look latched over.  No sample may
+ *               be stored.
+ *
+ *    Usage:
+ *      faV3ScalerMonBench
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <stddef.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3ScalerMon.h"
+#include "faV3BusEmu.h"
+
+#define SLOT       3
+#define PERIOD_MS  10
+#define TICK_NS    2048
+
+extern uint32_t faV3ScalerLatchCount[(FAV3_MAX_BOARDS + 1)];
+extern int faV3ScalerLatchPending[(FAV3_MAX_BOARDS + 1)];
+
+static double liveStart;	/* host time of the last clear */
+static uint32_t timeBase;	/* time_count at liveStart */
+static volatile int32_t dropMode = 0;
+static int32_t nlatchPending = 0;	/* latches while the readout's is pending */
+
+/* Latch or clear the emulated scalers.  Called with the bus held. */
+static void
+scalerReg(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  volatile uint32_t *reg;
+  double dt;
+  int32_t ichan;
+
+  if(write && (offset == offsetof(faV3_t, scaler_ctrl)))
+    {
+      if(*value & FAV3_SCALER_CTRL_LATCH)
+	{
+	  if(faV3ScalerLatchPending[slot])
+	    nlatchPending++;
+	  dt = faV3BusEmuTime() - liveStart;
+	  reg = faV3BusEmuReg(slot, offsetof(faV3_t, scalers));
+	  for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	    reg[ichan] = (uint32_t) (1e5 * (ichan + 1) * dt);
+	  reg[FAV3_MAX_ADC_CHANNELS] =
+	    timeBase + (uint32_t) (dt / (TICK_NS * 1e-9));
+	}
+      if(*value & FAV3_SCALER_CTRL_RESET)
+	{
+	  liveStart = faV3BusEmuTime();
+	  timeBase = 0;
+	}
+    }
+
+  if(!write && dropMode && (offset >= offsetof(faV3_t, scalers)) &&
+     (offset <= offsetof(faV3_t, scalers.time_count)))
+    faV3ScalerLatchCount[slot]++;	/* as if latched by someone else */
+}
+
+static void
+sleepMs(int32_t ms)
+{
+  struct timespec ts = { ms / 1000, (ms % 1000) * 1000000 };
+
+  nanosleep(&ts, NULL);
+}
+
+/* Samples since seq, newest first, and the number flagged as a reset */
+static int32_t
+getSamples(uint32_t seq, faV3ScalerSample_t * s, int32_t max, int32_t * nreset)
+{
+  int32_t n, i;
+
+  n = faV3ScalerMonGetHistory(SLOT, s, max);
+  for(i = 0; i < n; i++)
+    if(s[i].seq < seq)
+      break;
+  n = i;
+
+  *nreset = 0;
+  for(i = 0; i < n; i++)
+    if(s[i].flags & FAV3_SCALMON_TIMER_RESET)
+      (*nreset)++;
+
+  return n;
+}
+
+int
+main(int argc, char *argv[])
+{
+  static faV3ScalerSample_t s[1024];
+  faV3ScalerSample_t latest;
+  uint32_t data[FAV3_MAX_ADC_CHANNELS + 1], expect[FAV3_MAX_ADC_CHANNELS + 1];
+  volatile uint32_t *reg;
+  uint32_t seq, nbadrate = 0, nmismatch = 0, nloop = 0;
+  int32_t n, nreset, i, ichan, nerr = 0;
+  double err;
+
+  faV3BusEmuInit(1 << SLOT);
+  if(faV3Init(SLOT << 19, 1 << 19, 1, FAV3_INIT_SKIP) != 1)
+    exit(1);
+
+  /* time_count wraps 200 ms after the start */
+  liveStart = faV3BusEmuTime();
+  timeBase = 0xFFFFFFFF - (uint32_t) (0.2 / (TICK_NS * 1e-9));
+  faV3BusEmuSetRegFunc(scalerReg);
+
+  if(faV3ScalerMonCreate(PERIOD_MS, 1024) != OK)
+    exit(1);
+  faV3ScalerMonSetTimerTick(TICK_NS);
+
+  /* wrap */
+  sleepMs(500);
+  n = getSamples(0, s, 1024, &nreset);
+  for(i = 0; i < n; i++)
+    {
+      if(!(s[i].flags & FAV3_SCALMON_RATE_VALID))
+	continue;
+      for(ichan = 0; ichan < FAV3_MAX_ADC_CHANNELS; ichan++)
+	{
+	  err = s[i].rate[ichan] / (1e5 * (ichan + 1)) - 1.0;
+	  if((err > 0.01) || (err < -0.01))
+	    nbadrate++;
+	}
+    }
+  printf("wrap:   %3d samples, %d flagged as reset, %u rates off by > 1%%\n",
+	 n, nreset, nbadrate);
+  nerr += (n < 10) || nreset || nbadrate;
+
+  /* clear */
+  faV3ScalerMonGetLatest(SLOT, &latest);
+  seq = latest.seq + 1;
+  faV3ClearScalers(SLOT);
+  sleepMs(200);
+  n = getSamples(seq, s, 1024, &nreset);
+  printf("clear:  %3d samples, %d flagged as reset\n", n, nreset);
+  nerr += (nreset != 1);
+
+  /* latch */
+  reg = faV3BusEmuReg(SLOT, offsetof(faV3_t, scalers));
+  faV3ScalerMonGetLatest(SLOT, &latest);
+  seq = latest.seq + 1;
+  for(nloop = 0; nloop < 250; nloop++)
+    {
+      faV3LatchScalers(SLOT);
+      for(i = 0; i <= FAV3_MAX_ADC_CHANNELS; i++)
+	expect[i] = reg[i];
+      sleepMs(2);
+      faV3ReadScalers(SLOT, data, 0xFFFF, 0);
+      if(memcmp(data, expect, sizeof(data)) != 0)
+	nmismatch++;
+    }
+  n = getSamples(seq, s, 1024, &nreset);
+  printf("latch:  %3d samples, %u of %u readout reads changed, %d monitor"
+	 " latches while pending, %d flagged as reset\n",
+	 n, nmismatch, nloop, nlatchPending, nreset);
+  nerr += nmismatch || nlatchPending || nreset || (n == 0);
+
+  /* drop */
+  faV3ScalerMonGetLatest(SLOT, &latest);
+  seq = latest.seq + 1;
+  dropMode = 1;
+  sleepMs(200);
+  dropMode = 0;
+  n = getSamples(seq, s, 1024, &nreset);
+  printf("drop:   %3d samples stored while every read was latched over\n", n);
+  nerr += (n != 0);
+
+  sleepMs(50);
+  faV3ScalerMonStatus(1);
+  faV3ScalerMonDestroy();
+  faV3BusEmuSetRegFunc(NULL);
+
+  printf("\n%s\n", nerr ? "FAILED" : "OK");
+  exit(nerr ? 1 : 0);
+}
@@ -0,0 +1,228 @@
+/*
+ * File:
+ *    faV3ShadowBench.c
+ *
+ * Description:
+ *    Bus cycles of a prestart reconfiguration (faV3DownloadAll of a
+ *    configuration file) with and without the shadow registers, on the
+ *    emulated VME bus with 16 boards (slots 3-10, 13-20).
+ *
+ *    Both downloads start from the same register maps.  Checks that they
+ *    leave the boards with the same register contents, and that the
+ *    shadow matches the boards afterwards (faV3GShadowVerify).  Then
+ *    reports the reads and writes per board and the time of the crate
+ *    download, at -c ns per single cycle.
+ *
+ *    Then mixes writes through the other register map of the board with
+ *    shadowed setters: faV3HallDSetProcMode writes the Hall D nsa register,
+ *    which is where faV3_t has adc.thres[9] and [10], and faV3SetThreshold
+ *    then changes those two thresholds.  With and without the shadow the
+ *    boards must end up the same, and the shadow must match them.
+ *
+ *    Usage:
+ *      faV3ShadowBench [-c <cycle ns>] [-f <config file>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stddef.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3Config.h"
+#include "faV3-HallD.h"
+#include "faV3BusEmu.h"
+
+#define SLOTMASK  0x1FE7F8	/* slots 3-10, 13-20 */
+#define NBOARDS   16
+
+static faV3_t initMap[FAV3_MAX_BOARDS + 1];
+static faV3_t plainMap[FAV3_MAX_BOARDS + 1];
+
+/* The DAC is always ready, and the write succeeds */
+static void
+dacReady(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  if(!write && (offset == offsetof(faV3_t, dac_csr)))
+    *value |= FAV3_DAC_READY | FAV3_DAC_SUCCESS;
+}
+
+static void
+copyMaps(faV3_t * map, int32_t save)
+{
+  int32_t slot;
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      if(save)
+	memcpy(&map[slot], (void *) faV3BusEmuReg(slot, 0), sizeof(faV3_t));
+      else
+	memcpy((void *) faV3BusEmuReg(slot, 0), &map[slot], sizeof(faV3_t));
+    }
+}
+
+static int32_t
+compareMaps(const faV3_t * map)
+{
+  const uint32_t *ref, *reg;
+  int32_t slot, ii, nerr = 0;
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      ref = (const uint32_t *) &map[slot];
+      reg = (const uint32_t *) faV3BusEmuReg(slot, 0);
+      for(ii = 0; ii < sizeof(faV3_t) / 4; ii++)
+	{
+	  if(ref[ii] == reg[ii])
+	    continue;
+	  if(nerr++ < 10)
+	    printf("  ERROR: slot %d 0x%03x: 0x%08x without shadow, "
+		   "0x%08x with\n", slot, ii << 2, ref[ii], reg[ii]);
+	}
+    }
+
+  return nerr;
+}
+
+extern int faV3FwRev[(FAV3_MAX_BOARDS + 1)][FAV3_FW_FUNCTION_MAX];
+
+/* Hall D map writes and shadowed setters on the same registers.  Returns
+   the number of shadow differences afterwards. */
+static int32_t
+mixed(int32_t shadow)
+{
+  int32_t slot, ndiff = 0;
+
+  copyMaps(initMap, 0);
+  faV3GShadowEnable(shadow);
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      if(faV3HallDSetProcMode(slot, 9, 250, 100, 3, 20, 1, 4, 400, 2) != OK)
+	exit(1);
+      faV3SetThreshold(slot, 9, 0x123);
+      faV3SetThreshold(slot, 10, 0x234);
+    }
+
+  if(shadow)
+    ndiff = faV3GShadowVerify(FAV3_SHADOW_VERIFY);
+  faV3GShadowEnable(0);
+
+  return ndiff;
+}
+
+static double
+download(faV3BusEmuCount_t * count)
+{
+  double t0;
+
+  faV3BusEmuClearCount();
+  t0 = faV3BusEmuTime();
+  if(faV3DownloadAll() != 0)
+    exit(1);
+  t0 = faV3BusEmuTime() - t0;
+  faV3BusEmuGetCount(count);
+
+  return t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  faV3BusEmuCount_t plain, shadow, load;
+  char *fname = "faV3.cfg";
+  int32_t cycle = 1000, slot, nerr, ndiff, nmixed, opt;
+  double tplain, tshadow;
+
+  while((opt = getopt(argc, argv, "c:f:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'f':
+	  fname = optarg;
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-f <config file>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  faV3BusEmuInit(SLOTMASK);
+  /* firmware with the per channel gain, delay and invert registers */
+  for(slot = 3; slot <= 20; slot++)
+    if(SLOTMASK & (1 << slot))
+      *faV3BusEmuReg(slot, offsetof(faV3_t, adc.status0)) =
+	FAV3_PROC_PRAD_FIRMWARE;
+
+  if(faV3Init(3 << 19, 1 << 19, 18,
+	      FAV3_INIT_SKIP | FAV3_INIT_SKIP_FIRMWARE_CHECK) != NBOARDS)
+    exit(1);
+
+  faV3InitGlobals();
+  if(faV3ReadConfigFile(fname) < 0)
+    exit(1);
+
+  faV3BusEmuSetRegFunc(dacReady);
+  faV3BusEmuSetCycle(cycle);
+  copyMaps(initMap, 1);
+
+  tplain = download(&plain);
+  copyMaps(plainMap, 1);
+
+  copyMaps(initMap, 0);
+  faV3BusEmuClearCount();
+  faV3GShadowEnable(1);
+  faV3BusEmuGetCount(&load);
+  tshadow = download(&shadow);
+
+  nerr = compareMaps(plainMap);
+  ndiff = faV3GShadowVerify(FAV3_SHADOW_VERIFY);
+  faV3GShadowEnable(0);
+  faV3BusEmuSetRegFunc(NULL);
+
+  /* Hall D map: upper bits set in the thresholds the nsa write covers */
+  if(faV3HallDInit(3 << 19, 1 << 19, 18,
+		   FAV3_INIT_SKIP | FAV3_INIT_SKIP_FIRMWARE_CHECK) != OK)
+    exit(1);
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      faV3FwRev[slot][FAV3_FW_PROC] = FAV3_HALLD_SUPPORTED_PROC_FIRMWARE;
+      initMap[slot].adc.thres[9] |= 0xF000;
+      initMap[slot].adc.thres[10] |= 0xF000;
+    }
+  faV3BusEmuSetRegFunc(dacReady);
+  mixed(0);
+  copyMaps(plainMap, 1);
+  nmixed = mixed(1);
+  nmixed += compareMaps(plainMap);
+  faV3BusEmuSetRegFunc(NULL);
+
+  printf("\n%d boards, %d ns per cycle, %s\n\n", NBOARDS, cycle, fname);
+  printf("faV3DownloadAll   reads/board  writes/board  crate ms\n");
+  printf("without shadow    %11llu  %12llu  %8.3f\n",
+	 (unsigned long long) plain.nread / NBOARDS,
+	 (unsigned long long) plain.nwrite / NBOARDS, 1e3 * tplain);
+  printf("with shadow       %11llu  %12llu  %8.3f\n",
+	 (unsigned long long) shadow.nread / NBOARDS,
+	 (unsigned long long) shadow.nwrite / NBOARDS, 1e3 * tshadow);
+  printf("\nShadow load (once, at faV3Init): %llu reads/board\n",
+	 (unsigned long long) load.nread / NBOARDS);
+  printf("Register differences: %d, shadow differences: %d\n", nerr, ndiff);
+  printf("Hall D map writes mixed with shadowed setters: %d differences\n",
+	 nmixed);
+
+  exit((nerr || ndiff || nmixed) ? 1 : 0);
+}
@@ -0,0 +1,202 @@
+/*
+ * File:
+ *    faV3SnapshotBench.c
+ *
+ * Description:
+ *    Bus reads and time of faV3Snapshot / faV3GSnapshot, on the emulated
+ *    VME bus with 16 boards (slots 3-10, 13-20), with single cycles and
+ *    with A24 block transfers (faV3SnapshotBlockConfig).
+ *
+ *    Checks that no read goes to a register with side effects when read,
+ *    that single cycles do not read blank addresses, and that every
+ *    register read is copied to the snapshot at its own offset.  Block
+ *    transfers must give the same snapshot as single cycles.  Then
+ *    reports the single cycles and block transfers per board and the
+ *    time of a crate snapshot for each region, at -c ns per single cycle
+ *    and -r MB/s for block transfers.
+ *
+ *    Usage:
+ *      faV3SnapshotBench [-c <cycle ns>] [-r <MB/s>]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "jvme.h"
+#include "faV3Lib.h"
+#include "faV3BusEmu.h"
+
+#define SLOTMASK  0x1FE7F8	/* slots 3-10, 13-20 */
+
+/* Never read: registers with side effects when read (memory data, event
+   generator, sum data, logic analyzer), and what is outside the regions */
+static const uint32_t noRead[][2] = {
+  {0x090, 0x094}, {0x0C4, 0x0CC}, {0x0F8, 0x0F8},
+  {0x1F0, 0x20E}, {0x210, 0x2FE}, {0x344, 0x3FC}, {0x400, 0x4FC}
+};
+
+/* Blank addresses: only block transfers may pass over them */
+static const uint32_t blank[][2] = {
+  {0x024, 0x024}, {0x06C, 0x06C}, {0x07C, 0x080},
+  {0x50C, 0x50C}, {0x518, 0x518}, {0x534, 0x53C}
+};
+
+#define NNOREAD (int32_t)(sizeof(noRead) / sizeof(noRead[0]))
+#define NBLANK  (int32_t)(sizeof(blank) / sizeof(blank[0]))
+
+static int32_t nbad, blockMode;
+
+static void
+checkRead(int32_t slot, uint32_t offset, int32_t write, uint32_t * value)
+{
+  int32_t i;
+
+  if(write)
+    return;
+
+  for(i = 0; i < NNOREAD; i++)
+    if((offset >= noRead[i][0]) && (offset <= noRead[i][1]))
+      {
+	if(nbad++ < 10)
+	  printf("  ERROR: slot %d read of 0x%03x\n", slot, offset);
+      }
+
+  if(!blockMode)
+    for(i = 0; i < NBLANK; i++)
+      if((offset >= blank[i][0]) && (offset <= blank[i][1]))
+	{
+	  if(nbad++ < 10)
+	    printf("  ERROR: slot %d single cycle read of blank 0x%03x\n",
+		   slot, offset);
+	}
+}
+
+/* Fill the register maps with values that give each address away */
+static void
+fillRegs()
+{
+  volatile uint32_t *reg;
+  uint32_t slot, off;
+
+  for(slot = 3; slot <= 20; slot++)
+    {
+      if(!(SLOTMASK & (1 << slot)))
+	continue;
+      for(off = 0x008; off < 0x550; off += 4)
+	{
+	  reg = faV3BusEmuReg(slot, off);
+	  *reg = (slot << 24) | (off << 12) | off;
+	}
+    }
+}
+
+static int32_t
+checkCopy(const faV3Snapshot_t * snap, int32_t nsnap)
+{
+  const uint32_t *copy;
+  volatile uint32_t *reg;
+  uint32_t off, nerr = 0;
+  int32_t isnap;
+
+  for(isnap = 0; isnap < nsnap; isnap++)
+    {
+      copy = (const uint32_t *) &snap[isnap].regs;
+      for(off = 0x008; off < 0x550; off += 4)
+	{
+	  if(copy[off >> 2] == 0)
+	    continue;
+	  reg = faV3BusEmuReg(snap[isnap].id, off);
+	  /* a 16 bit register copies half of the 32 bit word */
+	  if(((copy[off >> 2] & 0xFFFF) && ((copy[off >> 2] & 0xFFFF) !=
+					    (*reg & 0xFFFF))) ||
+	     ((copy[off >> 2] >> 16) && ((copy[off >> 2] >> 16) !=
+					 (*reg >> 16))))
+	    nerr++;
+	}
+    }
+
+  return nerr;
+}
+
+int
+main(int argc, char *argv[])
+{
+  static faV3Snapshot_t snap[FAV3_MAX_BOARDS], bsnap[FAV3_MAX_BOARDS];
+  const char *names[] = { "CTRL", "ADC", "SCALERS", "AUX",
+    "CTRL|ADC|AUX (status)", "ALL"
+  };
+  uint32_t regions[] = { FAV3_SNAP_CTRL, FAV3_SNAP_ADC, FAV3_SNAP_SCALERS,
+    FAV3_SNAP_AUX, FAV3_SNAP_CTRL | FAV3_SNAP_ADC | FAV3_SNAP_AUX,
+    FAV3_SNAP_ALL
+  };
+  faV3BusEmuCount_t count, bcount;
+  int32_t cycle = 1000, rate = 40, nsnap = 0, ireg, nerr = 0, ndiff = 0, opt;
+  double t0, tb;
+
+  while((opt = getopt(argc, argv, "c:r:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'c':
+	  cycle = atoi(optarg);
+	  break;
+	case 'r':
+	  rate = atoi(optarg);
+	  break;
+	default:
+	  printf("Usage: %s [-c <cycle ns>] [-r <MB/s>]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  faV3BusEmuInit(SLOTMASK);
+  if(faV3Init(3 << 19, 1 << 19, 18, FAV3_INIT_SKIP) != 16)
+    exit(1);
+
+  fillRegs();
+  faV3BusEmuSetRegFunc(checkRead);
+  faV3BusEmuSetDmaFunc(NULL, rate);
+  faV3BusEmuSetCycle(cycle);
+
+  printf("\n16 boards, %d ns per cycle, block transfers at %d MB/s\n\n",
+	 cycle, rate);
+  printf("                          single cycles         block transfers\n");
+  printf("regions                 reads/board  crate ms  DMAs+reads/board  crate ms\n");
+  for(ireg = 0; ireg < 6; ireg++)
+    {
+      blockMode = 0;
+      faV3BusEmuClearCount();
+      t0 = faV3BusEmuTime();
+      nsnap = faV3GSnapshot(regions[ireg], snap);
+      t0 = faV3BusEmuTime() - t0;
+      faV3BusEmuGetCount(&count);
+      nerr += checkCopy(snap, nsnap);
+
+      blockMode = 1;
+      if(faV3SnapshotBlockConfig(1, 2, 5, 1) != OK)
+	exit(1);
+      faV3BusEmuClearCount();
+      tb = faV3BusEmuTime();
+      if(faV3GSnapshot(regions[ireg], bsnap) != nsnap)
+	exit(1);
+      tb = faV3BusEmuTime() - tb;
+      faV3BusEmuGetCount(&bcount);
+      faV3SnapshotBlockConfig(0, 2, 5, 1);
+      nerr += checkCopy(bsnap, nsnap);
+      if(memcmp(snap, bsnap, nsnap * sizeof(faV3Snapshot_t)) != 0)
+	ndiff++;
+
+      printf("%-22s  %11llu  %8.3f  %8llu+%-7llu  %8.3f\n", names[ireg],
+	     (unsigned long long) count.nread / nsnap, 1e3 * t0,
+	     (unsigned long long) bcount.ndma / nsnap,
+	     (unsigned long long) bcount.nread / nsnap, 1e3 * tb);
+    }
+  faV3BusEmuSetRegFunc(NULL);
+
+  printf("\nSide effect or blank reads: %d, copy errors: %d, block/single"
+	 " differences: %d\n", nbad, nerr, ndiff);
+
+  exit((nbad || nerr || ndiff) ? 1 : 0);
+}